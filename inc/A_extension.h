@@ -148,7 +148,7 @@ namespace riscv_tlm {
 
             TLB_reserve(mem_addr);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. A.LR.W: x{:d}(0x{:x}) -> x{:d}(0x{:x}) ",
+            this->logger->debug("{} ps. PC: 0x{:x}. A.LR.W: x{:d}(0x{:x}) -> x{:d}(0x{:x}) ",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, mem_addr, rd, data);
@@ -176,7 +176,7 @@ namespace riscv_tlm {
                 this->regs->setValue(rd, 1);  // SC writes nonzero on failure
             }
 
-            this->logger->debug("{} ns. PC: 0x{:x}. A.SC.W: (0x{:x}) <- x{:d}(0x{:x}) ",
+            this->logger->debug("{} ps. PC: 0x{:x}. A.SC.W: (0x{:x}) <- x{:d}(0x{:x}) ",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 mem_addr, rs2, data);
@@ -466,11 +466,28 @@ namespace riscv_tlm {
             }
         }
 
+        /**
+         * @brief Addresses reserved by LR, saved and restored with the hart
+         */
+        const std::unordered_set<std::uint32_t> &reservations() const {
+            return TLB_A_Entries;
+        }
+
+        void setReservations(const std::unordered_set<std::uint32_t> &entries) {
+            TLB_A_Entries = entries;
+        }
+
         bool exec_instruction(Instruction &inst, op_A_Codes code) {
             bool PC_not_affected = true;
 
             this->setInstr(inst.getInstr());
 
+            /* SC and AMOs fault as stores, and before rd is written */
+            MMU *mmu = this->mem_intf->getMMU();
+            if (code != OP_A_LR && mmu != nullptr && mmu->translates(AccessType::Store)) {
+                mmu->translate(this->regs->getValue(this->get_rs1()), AccessType::Store);
+            }
+
             switch (code) {
                 case OP_A_LR:
                     Exec_A_LR();
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file AotAPI.h
+ * @brief C interface between the simulator and ahead-of-time translated code
+ *
+ * rv_aot translates the basic blocks of an RV32 program into C and builds a
+ * shared library named after the image hash (ImageHash.h). The library
+ * exports:
+ *   - `const int rvvp_aot_version` set to RVVP_AOT_VERSION
+ *   - `const uint64_t rvvp_aot_image_hash`
+ *   - `const uint32_t rvvp_aot_block_count`
+ *   - `const rvvp_aot_block_t rvvp_aot_blocks[]`, one entry per block
+ *
+ * A block runs with the hart's integer registers and RAM, and returns with
+ * state->pc set to where the interpreter continues. It leaves before any
+ * instruction it cannot run natively: CSR, system, atomic and floating-point
+ * instructions, and loads and stores outside the RAM regions it was given
+ * (peripherals). Each block first checks that memory still holds the code it
+ * was translated from, and leaves at once if not (self-modifying code). A
+ * block that ends in a direct jump or branch to another block calls it
+ * directly until state->retired reaches state->budget.
+ */
+#ifndef RVVP_AOT_API_H
+#define RVVP_AOT_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Bumped on any incompatible change of this header or of the generated code */
+#define RVVP_AOT_VERSION 1
+
+#if defined(_WIN32)
+#define RVVP_AOT_EXPORT __declspec(dllexport)
+#else
+#define RVVP_AOT_EXPORT __attribute__((visibility("default")))
+#endif
+
+/** RAM regions a block may load from and store to directly */
+#define RVVP_AOT_REGIONS 2
+
+typedef struct rvvp_aot_state {
+    uint32_t *x;                        /**< x0..x31; x[0] is never written */
+    const uint8_t *code;                /**< host address of guest address 0, for the code checks */
+    uint32_t code_size;
+    uint8_t *mem[RVVP_AOT_REGIONS];     /**< host address of lo[i] */
+    uint32_t lo[RVVP_AOT_REGIONS];
+    uint32_t span[RVVP_AOT_REGIONS];    /**< bytes from lo[i]; 0 if the region is unused */
+    uint32_t pc;                        /**< out: next instruction for the interpreter */
+    uint32_t retired;                   /**< in/out: instructions retired so far */
+    uint32_t budget;                    /**< no more direct calls once retired reaches it */
+    uint32_t loads;                     /**< out: data accesses made, for the counters */
+    uint32_t stores;
+} rvvp_aot_state_t;
+
+typedef void (*rvvp_aot_block_fn)(rvvp_aot_state_t *state);
+
+typedef struct {
+    uint32_t pc;
+    rvvp_aot_block_fn fn;
+} rvvp_aot_block_t;
+
+/**
+ * @brief Host address of @p len bytes of RAM at guest address @p addr, or NULL
+ */
+static inline uint8_t *rvvp_aot_host(rvvp_aot_state_t *state, uint32_t addr, uint32_t len) {
+    for (unsigned int i = 0; i < RVVP_AOT_REGIONS; i++) {
+        uint32_t offset = addr - state->lo[i];
+        if ((uint64_t) offset + len <= state->span[i]) {
+            return state->mem[i] + offset;
+        }
+    }
+    return NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RVVP_AOT_API_H */
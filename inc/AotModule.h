@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file AotModule.h
+ * @brief Loader for ahead-of-time translated programs (see AotAPI.h)
+ *
+ * rv_aot writes the translation of a program to <dir>/<hash>.so, where
+ * hash is the ImageHash of the program in 16 hex digits. The simulator
+ * hashes the image it loaded and looks for that file in the directory given
+ * with --aot, so a rebuilt program never runs stale native code.
+ */
+#pragma once
+#ifndef INC_AOTMODULE_H_
+#define INC_AOTMODULE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "AotAPI.h"
+
+namespace riscv_tlm {
+
+    class AotModule {
+    public:
+        /**
+         * @brief Load the translation of image @p hash from @p dir
+         * @return nullptr with @p error set if there is none or it does not match
+         */
+        static std::unique_ptr<AotModule> load(const std::string &dir, std::uint64_t hash, std::string &error);
+
+        /**
+         * @brief "<hash>.so", as rv_aot names it
+         */
+        static std::string fileName(std::uint64_t hash) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "%016llx.so", static_cast<unsigned long long>(hash));
+            return name;
+        }
+
+        ~AotModule();
+
+        AotModule(const AotModule &) = delete;
+        AotModule &operator=(const AotModule &) = delete;
+
+        /**
+         * @brief Block starting at @p pc, or nullptr
+         */
+        rvvp_aot_block_fn find(std::uint32_t pc) const {
+            auto it = m_blocks.find(pc);
+            return it != m_blocks.end() ? it->second : nullptr;
+        }
+
+        std::size_t blocks() const {
+            return m_blocks.size();
+        }
+
+        const std::string &path() const {
+            return m_path;
+        }
+
+    private:
+        AotModule() = default;
+
+        void *m_handle{nullptr};
+        std::string m_path;
+        std::unordered_map<std::uint32_t, rvvp_aot_block_fn> m_blocks;
+    };
+}
+
+#endif /* INC_AOTMODULE_H_ */
@@ -292,7 +292,7 @@ namespace riscv_tlm {
             imm = static_cast<std::int32_t>(get_imm_U() << 12);
             this->regs->setValue(rd, imm);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. LUI: x{:d} <- 0x{:x}", sc_core::sc_time_stamp().value(),
+            this->logger->debug("{} ps. PC: 0x{:x}. LUI: x{:d} <- 0x{:x}", sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rd, imm);
 
@@ -310,7 +310,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, new_pc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. AUIPC: x{:d} <- 0x{:x} + PC (0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. AUIPC: x{:d} <- 0x{:x} + PC (0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rd, imm, new_pc);
@@ -333,7 +333,7 @@ namespace riscv_tlm {
             old_pc = old_pc + 4;
             this->regs->setValue(rd, old_pc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. JAL: x{:d} <- 0x{:x}. PC + 0x{:x} -> PC (0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. JAL: x{:d} <- 0x{:x}. PC + 0x{:x} -> PC (0x{:x})",
                                 sc_core::sc_time_stamp().value(), old_pc - 4,
                                 rd, old_pc, mem_addr, new_pc);
 
@@ -353,7 +353,7 @@ namespace riscv_tlm {
             new_pc = static_cast<unsigned_T>((this->regs->getValue(rs1) + offset) & ~1);
             this->regs->setValue(rd, old_pc + 4);
             this->regs->setPC(new_pc);
-            this->logger->debug("{} ns. PC: 0x{:x}. JALR: x{:d} <- 0x{:x}. PC <- 0x{:x}",
+            this->logger->debug("{} ps. PC: 0x{:x}. JALR: x{:d} <- 0x{:x}. PC <- 0x{:x}",
                                     sc_core::sc_time_stamp().value(),
                                     old_pc, rd, old_pc + 4, new_pc);
 
@@ -378,7 +378,7 @@ namespace riscv_tlm {
                 this->regs->incPC();
             }
 
-            this->logger->debug("{} ns. PC: 0x{:x}. BEQ: x{:d}(0x{:x}) == x{:d}(0x{:x})? -> PC (0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. BEQ: x{:d}(0x{:x}) == x{:d}(0x{:x})? -> PC (0x{:x})",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 rs1, this->regs->getValue(rs1), rs2, this->regs->getValue(rs2), this->regs->getPC());
 
@@ -405,7 +405,7 @@ namespace riscv_tlm {
                 this->regs->incPC();
             }
 
-            this->logger->debug("{} ns. PC: 0x{:x}. BNE: x{:d}(0x{:x}) != x{:d}(0x{:x})? -> PC (0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. BNE: x{:d}(0x{:x}) != x{:d}(0x{:x})? -> PC (0x{:x})",
                                 sc_core::sc_time_stamp().value(), old_pc,
                                 rs1, val1, rs2, val2, this->regs->getPC());
 
@@ -432,7 +432,7 @@ namespace riscv_tlm {
                 this->regs->incPC();
             }
 
-            this->logger->debug("{} ns. PC: 0x{:x}. BLT: x{:d}(0x{:x}) < x{:d}(0x{:x})? -> PC (0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. BLT: x{:d}(0x{:x}) < x{:d}(0x{:x})? -> PC (0x{:x})",
                                 sc_core::sc_time_stamp().value(), old_pc,
                                 rs1, this->regs->getValue(rs1), rs2, this->regs->getValue(rs2), this->regs->getPC());
 
@@ -459,7 +459,7 @@ namespace riscv_tlm {
                 this->regs->incPC();
             }
 
-            this->logger->debug("{} ns. PC: 0x{:x}. BGE: x{:d}(0x{:x}) > x{:d}(0x{:x})? -> PC (0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. BGE: x{:d}(0x{:x}) > x{:d}(0x{:x})? -> PC (0x{:x})",
                                 sc_core::sc_time_stamp().value(), old_pc,
                                 rs1, this->regs->getValue(rs1), rs2, this->regs->getValue(rs2), this->regs->getPC());
 
@@ -486,7 +486,7 @@ namespace riscv_tlm {
                 this->regs->incPC();
             }
 
-            this->logger->debug("{} ns. PC: 0x{:x}. BLTU: x{:d}(0x{:x}) < x{:d}(0x{:x})? -> PC (0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. BLTU: x{:d}(0x{:x}) < x{:d}(0x{:x})? -> PC (0x{:x})",
                                 sc_core::sc_time_stamp().value(), old_pc,
                                 rs1, this->regs->getValue(rs1), rs2, this->regs->getValue(rs2), this->regs->getPC());
 
@@ -513,7 +513,7 @@ namespace riscv_tlm {
                 this->regs->incPC();
             }
 
-            this->logger->debug("{} ns. PC: 0x{:x}. BGEU: x{:d}(0x{:x}) > x{:d}(0x{:x}) -> PC (0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. BGEU: x{:d}(0x{:x}) > x{:d}(0x{:x}) -> PC (0x{:x})",
                                 sc_core::sc_time_stamp().value(), old_pc,
                                 rs1, this->regs->getValue(rs1), rs2, this->regs->getValue(rs2), this->regs->getPC());
 
@@ -535,7 +535,7 @@ namespace riscv_tlm {
             this->perf->dataMemoryRead();
             this->regs->setValue(rd, data);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. LB: x{:d} + x{:d}(0x{:x}) -> x{:d}",
+            this->logger->debug("{} ps. PC: 0x{:x}. LB: x{:d} + x{:d}(0x{:x}) -> x{:d}",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, imm, mem_addr, rd);
@@ -558,7 +558,7 @@ namespace riscv_tlm {
             this->perf->dataMemoryRead();
             this->regs->setValue(rd, data);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. LH: x{:d} + x{:d}(0x{:x}) -> x{:d}",
+            this->logger->debug("{} ps. PC: 0x{:x}. LH: x{:d} + x{:d}(0x{:x}) -> x{:d}",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, imm, mem_addr, rd);
@@ -582,7 +582,7 @@ namespace riscv_tlm {
             this->perf->dataMemoryRead();
             this->regs->setValue(rd, data);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. LW: x{:d} + x{:d}(0x{:x}) -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. LW: x{:d} + x{:d}(0x{:x}) -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, imm, mem_addr, rd, data);
@@ -606,7 +606,7 @@ namespace riscv_tlm {
             this->perf->dataMemoryRead();
             this->regs->setValue(rd, data);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. LBU: x{:d} + x{:d}(0x{:x}) -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. LBU: x{:d} + x{:d}(0x{:x}) -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, imm, mem_addr, rd, data);
@@ -630,7 +630,7 @@ namespace riscv_tlm {
             this->perf->dataMemoryRead();
             this->regs->setValue(rd, data);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. LHU: x{:d} + x{:d}(0x{:x}) -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. LHU: x{:d} + x{:d}(0x{:x}) -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, imm, mem_addr, rd, data);
@@ -654,7 +654,7 @@ namespace riscv_tlm {
             this->perf->dataMemoryRead();
             this->regs->setValue(rd, data);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. LWU: x{:d} + x{:d}(0x{:x}) -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. LWU: x{:d} + x{:d}(0x{:x}) -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, imm, mem_addr, rd, data);
@@ -684,7 +684,7 @@ namespace riscv_tlm {
             this->perf->dataMemoryRead();
             this->regs->setValue(rd, data);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. LD: 0x{:x}({:d}) + {:d}(0x{:x}) -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. LD: 0x{:x}({:d}) + {:d}(0x{:x}) -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, offset, imm, mem_addr, rd, data);
@@ -705,7 +705,7 @@ namespace riscv_tlm {
             mem_addr = imm + this->regs->getValue(rs1);
             data = this->regs->getValue(rs2);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SD: 0x{:x} -> x{:d} + 0x{:x}(@0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. SD: 0x{:x} -> x{:d} + 0x{:x}(@0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs2, rs1, imm, mem_addr);
@@ -734,7 +734,7 @@ namespace riscv_tlm {
             this->mem_intf->writeDataMem(mem_addr, data, 1);
             this->perf->dataMemoryWrite();
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SB: x{:d} -> x{:d} + 0x{:x}(@0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. SB: x{:d} -> x{:d} + 0x{:x}(@0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs2, rs1, imm, mem_addr);
@@ -759,7 +759,7 @@ namespace riscv_tlm {
             this->mem_intf->writeDataMem(mem_addr, data, 2);
             this->perf->dataMemoryWrite();
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SH: x{:d} -> x{:d} + 0x{:x}(@0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. SH: x{:d} -> x{:d} + 0x{:x}(@0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs2, rs1, imm, mem_addr);
@@ -784,7 +784,7 @@ namespace riscv_tlm {
             this->mem_intf->writeDataMem(mem_addr, data, 4);
             this->perf->dataMemoryWrite();
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SW: x{:d}(0x{:x}) -> x{:d} + 0x{:x}(@0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. SW: x{:d}(0x{:x}) -> x{:d} + 0x{:x}(@0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs2, data, rs1, imm, mem_addr);
@@ -805,7 +805,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. ADDI: x{:d}(0x{:x}) + {:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. ADDI: x{:d}(0x{:x}) + {:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, this->regs->getValue(rs1), imm, rd, calc);
@@ -828,7 +828,7 @@ namespace riscv_tlm {
             calc = static_cast<std::int32_t>(aux);
 
             this->regs->setValue(rd, calc);
-            this->logger->debug("{} ns. PC: 0x{:x}. ADDIW: x{:d} + {:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. ADDIW: x{:d} + {:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, imm, rd, calc);
@@ -849,13 +849,13 @@ namespace riscv_tlm {
 
             if (val1 < imm) {
                 this->regs->setValue(rd, 1);
-                this->logger->debug("{} ns. PC: 0x{:x}. SLTI: x{:d} < x{:d} => 1 -> x{:d}",
+                this->logger->debug("{} ps. PC: 0x{:x}. SLTI: x{:d} < x{:d} => 1 -> x{:d}",
                                     sc_core::sc_time_stamp().value(),
                                     this->regs->getPC(),
                                     rs1, imm, rd);
             } else {
                 this->regs->setValue(rd, 0);
-                this->logger->debug("{} ns. PC: 0x{:x}. SLTI: x{:d} < x{:d} => 0 -> x{:d}",
+                this->logger->debug("{} ps. PC: 0x{:x}. SLTI: x{:d} < x{:d} => 0 -> x{:d}",
                                     sc_core::sc_time_stamp().value(),
                                     this->regs->getPC(),
                                     rs1, imm, rd);
@@ -876,13 +876,13 @@ namespace riscv_tlm {
 
             if (val1 < imm) {
                 this->regs->setValue(rd, 1);
-                this->logger->debug("{} ns. PC: 0x{:x}. SLTIU: x{:d} < x{:d} => 1 -> x{:d}",
+                this->logger->debug("{} ps. PC: 0x{:x}. SLTIU: x{:d} < x{:d} => 1 -> x{:d}",
                                     sc_core::sc_time_stamp().value(),
                                     this->regs->getPC(),
                                     rs1, imm, rd);
             } else {
                 this->regs->setValue(rd, 0);
-                this->logger->debug("{} ns. PC: 0x{:x}. SLTIU: x{:d} < x{:d} => 0 -> x{:d}",
+                this->logger->debug("{} ps. PC: 0x{:x}. SLTIU: x{:d} < x{:d} => 0 -> x{:d}",
                                     sc_core::sc_time_stamp().value(),
                                     this->regs->getPC(),
                                     rs1, imm, rd);
@@ -903,7 +903,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) ^ imm;
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. XORI: x{:d} XOR x{:d} -> x{:d}", sc_core::sc_time_stamp().value(),
+            this->logger->debug("{} ps. PC: 0x{:x}. XORI: x{:d} XOR x{:d} -> x{:d}", sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, imm, rd);
 
@@ -922,7 +922,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) | imm;
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. ORI: x{:d} OR x{:d} -> x{:d}", sc_core::sc_time_stamp().value(),
+            this->logger->debug("{} ps. PC: 0x{:x}. ORI: x{:d} OR x{:d} -> x{:d}", sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, imm, rd);
 
@@ -941,7 +941,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) & imm;
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. ANDI: x{:d} AND 0x{:x} -> x{:d}",
+            this->logger->debug("{} ps. PC: 0x{:x}. ANDI: x{:d} AND 0x{:x} -> x{:d}",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, imm, rd);
@@ -981,7 +981,7 @@ namespace riscv_tlm {
             calc = static_cast<std::int32_t>(static_cast<std::uint32_t>(this->regs->getValue(rs1)) << shift);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SLLIW: x{:d} << {:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. SLLIW: x{:d} << {:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, shift, rd, calc);
@@ -1012,7 +1012,7 @@ namespace riscv_tlm {
             calc = static_cast<std::int32_t>(static_cast<std::uint32_t>(this->regs->getValue(rs1) & 0xFFFFFFFF) >> shift);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SRLIW: x{:d} << {:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. SRLIW: x{:d} << {:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, shift, rd, calc);
@@ -1035,7 +1035,7 @@ namespace riscv_tlm {
             calc = static_cast<std::int32_t>(static_cast<std::int32_t>(this->regs->getValue(rs1)) >> shift);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SRAIW: x{:d} >> {:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. SRAIW: x{:d} >> {:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, shift, rd, calc);
@@ -1054,7 +1054,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. ADDW: x{:d} + x{:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. ADDW: x{:d} + x{:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, calc);
@@ -1073,7 +1073,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SUBW: x{:d} + x{:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. SUBW: x{:d} + x{:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, calc);
@@ -1096,7 +1096,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SLLW: x{:d} << x{:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. SLLW: x{:d} << x{:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, shift, rd, calc);
@@ -1119,7 +1119,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SRLW: x{:d} >> {:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. SRLW: x{:d} >> {:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, shift, rd, calc);
@@ -1142,7 +1142,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SRAW: x{:d} >> {:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. SRAW: x{:d} >> {:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, shift, rd, calc);
@@ -1161,7 +1161,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. ADD: x{:d} + x{:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. ADD: x{:d} + x{:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, calc);
@@ -1179,7 +1179,7 @@ namespace riscv_tlm {
             calc = static_cast<signed_T>(this->regs->getValue(rs1)) - static_cast<signed_T>(this->regs->getValue(rs2));
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SUB: x{:d} - x{:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. SUB: x{:d} - x{:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, calc);
@@ -1203,13 +1203,13 @@ namespace riscv_tlm {
 
             if (val1 < val2) {
                 this->regs->setValue(rd, 1);
-                this->logger->debug("{} ns. PC: 0x{:x}. SLT: x{:d} < x{:d} => 1 -> x{:d}",
+                this->logger->debug("{} ps. PC: 0x{:x}. SLT: x{:d} < x{:d} => 1 -> x{:d}",
                                     sc_core::sc_time_stamp().value(),
                                     this->regs->getPC(),
                                     rs1, rs2, rd);
             } else {
                 this->regs->setValue(rd, 0);
-                this->logger->debug("{} ns. PC: 0x{:x}. SLT: x{:d} < x{:d} => 0 -> x{:d}",
+                this->logger->debug("{} ps. PC: 0x{:x}. SLT: x{:d} < x{:d} => 0 -> x{:d}",
                                     sc_core::sc_time_stamp().value(),
                                     this->regs->getPC(),
                                     rs1, rs2, rd);
@@ -1231,13 +1231,13 @@ namespace riscv_tlm {
 
             if (val1 < val2) {
                 this->regs->setValue(rd, 1);
-                this->logger->debug("{} ns. PC: 0x{:x}. SLTU: x{:d} < x{:d} => 1 -> x{:d}",
+                this->logger->debug("{} ps. PC: 0x{:x}. SLTU: x{:d} < x{:d} => 1 -> x{:d}",
                                     sc_core::sc_time_stamp().value(),
                                     this->regs->getPC(),
                                     rs1, rs2, rd);
             } else {
                 this->regs->setValue(rd, 0);
-                this->logger->debug("{} ns. PC: 0x{:x}. SLTU: x{:d} < x{:d} => 0 -> x{:d}",
+                this->logger->debug("{} ps. PC: 0x{:x}. SLTU: x{:d} < x{:d} => 0 -> x{:d}",
                                     sc_core::sc_time_stamp().value(),
                                     this->regs->getPC(),
                                     rs1, rs2, rd);
@@ -1257,7 +1257,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) ^ this->regs->getValue(rs2);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. XOR: x{:d} XOR x{:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. XOR: x{:d} XOR x{:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, calc);
@@ -1282,7 +1282,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) | this->regs->getValue(rs2);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. OR: x{:d} OR x{:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. OR: x{:d} OR x{:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, calc);
@@ -1301,7 +1301,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) & this->regs->getValue(rs2);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. AND: x{:d} AND x{:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. AND: x{:d} AND x{:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, calc);
@@ -1310,7 +1310,7 @@ namespace riscv_tlm {
         }
 
         bool Exec_FENCE() const {
-            this->logger->debug("{} ns. PC: 0x{:x}. FENCE", sc_core::sc_time_stamp().value(), this->regs->getPC());
+            this->logger->debug("{} ps. PC: 0x{:x}. FENCE", sc_core::sc_time_stamp().value(), this->regs->getPC());
 
             // Check if next instruction is a FENCE, if so, stop simulation
             uint32_t ant_pc = this->regs->getPC();
@@ -1326,7 +1326,7 @@ namespace riscv_tlm {
 
         bool Exec_ECALL() {
 
-            this->logger->debug("{} ns. PC: 0x{:x}. ECALL", sc_core::sc_time_stamp().value(), this->regs->getPC());
+            this->logger->debug("{} ps. PC: 0x{:x}. ECALL", sc_core::sc_time_stamp().value(), this->regs->getPC());
 
             std::cout << std::endl << "ECALL Instruction called, stopping simulation"
                       << std::endl;
@@ -1341,7 +1341,7 @@ namespace riscv_tlm {
 
         bool Exec_EBREAK() {
 
-            this->logger->debug("{} ns. PC: 0x{:x}. EBREAK", sc_core::sc_time_stamp().value(), this->regs->getPC());
+            this->logger->debug("{} ps. PC: 0x{:x}. EBREAK", sc_core::sc_time_stamp().value(), this->regs->getPC());
             std::cout << std::endl << "EBRAK  Instruction called, dumping information"
                       << std::endl;
             this->regs->dump();
@@ -1371,7 +1371,7 @@ namespace riscv_tlm {
 
             this->regs->setCSR(csr, aux2);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. CSRRW: CSR #{:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. CSRRW: CSR #{:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 csr, rd, aux);
@@ -1388,8 +1388,12 @@ namespace riscv_tlm {
             rs1 = this->get_rs1();
             csr = get_csr();
 
+            if (csr == CSR_MNXTI) [[unlikely]] {
+                return Exec_MNXTI(rd, this->regs->getValue(rs1), false, rs1 != 0);
+            }
+
             if (rd == 0) {
-                this->logger->debug("{} ns. PC: 0x{:x}. CSRRS with rd1 == 0, doing nothing.",
+                this->logger->debug("{} ps. PC: 0x{:x}. CSRRS with rd1 == 0, doing nothing.",
                                     sc_core::sc_time_stamp().value(), this->regs->getPC());
                 return false;
             }
@@ -1403,7 +1407,7 @@ namespace riscv_tlm {
             aux2 = aux | bitmask;
             this->regs->setCSR(csr, aux2);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. CSRRS: CSR #{:d}(0x{:x}) -> x{:d}(0x{:x}) & CSR #{:d} <- 0x{:x}",
+            this->logger->debug("{} ps. PC: 0x{:x}. CSRRS: CSR #{:d}(0x{:x}) -> x{:d}(0x{:x}) & CSR #{:d} <- 0x{:x}",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 csr, aux, rd, rs1, csr, aux2);
 
@@ -1419,8 +1423,12 @@ namespace riscv_tlm {
             rs1 = this->get_rs1();
             csr = get_csr();
 
+            if (csr == CSR_MNXTI) [[unlikely]] {
+                return Exec_MNXTI(rd, this->regs->getValue(rs1), true, rs1 != 0);
+            }
+
             if (rd == 0) {
-                this->logger->debug("{} ns. PC: 0x{:x}. CSRRC with rd1 == 0, doing nothing.",
+                this->logger->debug("{} ps. PC: 0x{:x}. CSRRC with rd1 == 0, doing nothing.",
                                     sc_core::sc_time_stamp().value(), this->regs->getPC());
                 return true;
             }
@@ -1434,7 +1442,7 @@ namespace riscv_tlm {
             aux2 = aux & ~bitmask;
             this->regs->setCSR(csr, aux2);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. CSRRC: CSR #{:d}(0x{:x}) -> x{:d}(0x{:x}) & CSR #{:d} <- 0x{:x}",
+            this->logger->debug("{} ps. PC: 0x{:x}. CSRRC: CSR #{:d}(0x{:x}) -> x{:d}(0x{:x}) & CSR #{:d} <- 0x{:x}",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 csr, aux, rd, rs1, csr, aux2);
 
@@ -1458,7 +1466,7 @@ namespace riscv_tlm {
             aux = rs1;
             this->regs->setCSR(csr, aux);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. CSRRWI: CSR #{:d} -> x{:d}. x{:d} -> CSR #{:d}",
+            this->logger->debug("{} ps. PC: 0x{:x}. CSRRWI: CSR #{:d} -> x{:d}. x{:d} -> CSR #{:d}",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 csr, rd, rs1, csr);
 
@@ -1474,6 +1482,10 @@ namespace riscv_tlm {
             rs1 = this->get_rs1();
             csr = get_csr();
 
+            if (csr == CSR_MNXTI) [[unlikely]] {
+                return Exec_MNXTI(rd, rs1, false, rs1 != 0);
+            }
+
             if (rs1 == 0) {
                 return true;
             }
@@ -1486,7 +1498,7 @@ namespace riscv_tlm {
             aux = aux | bitmask;
             this->regs->setCSR(csr, aux);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. CSRRSI: CSR #{:d} -> x{:d}. x{:d} & CSR #{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. CSRRSI: CSR #{:d} -> x{:d}. x{:d} & CSR #{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 csr, rd, rs1, csr, aux);
 
@@ -1502,6 +1514,10 @@ namespace riscv_tlm {
             rs1 = this->get_rs1();
             csr = get_csr();
 
+            if (csr == CSR_MNXTI) [[unlikely]] {
+                return Exec_MNXTI(rd, rs1, true, rs1 != 0);
+            }
+
             if (rs1 == 0) {
                 return true;
             }
@@ -1514,13 +1530,29 @@ namespace riscv_tlm {
             aux = aux & ~bitmask;
             this->regs->setCSR(csr, aux);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. CSRRCI: CSR #{:d} -> x{:d}. x{:d} & CSR #{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. CSRRCI: CSR #{:d} -> x{:d}. x{:d} & CSR #{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 csr, rd, rs1, csr, aux);
 
             return true;
         }
 
+        /**
+         * @brief csrrs/csrrc(i) on mnxti: set or clear @p mask in mstatus and
+         *        read the mtvt entry of the next interrupt to service (0 if none)
+         */
+        bool Exec_MNXTI(unsigned int rd, unsigned_T mask, bool clear, bool write) const {
+            unsigned_T entry = this->regs->nextInterrupt(mask, clear, write);
+
+            this->regs->setValue(rd, entry);
+
+            this->logger->debug("{} ps. PC: 0x{:x}. MNXTI: mstatus {} 0x{:x} -> x{:d}(0x{:x})",
+                                sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                clear ? "&~" : "|", mask, rd, entry);
+
+            return true;
+        }
+
 /*********************** Privileged Instructions ******************************/
 
         bool Exec_MRET() const {
@@ -1528,19 +1560,11 @@ namespace riscv_tlm {
 
             new_pc = this->regs->getCSR(CSR_MEPC);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. MRET: PC <- 0x{:x}", sc_core::sc_time_stamp().value(),
+            this->logger->debug("{} ps. PC: 0x{:x}. MRET: PC <- 0x{:x}", sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(), new_pc);
 
             this->regs->setPC(new_pc);
-
-            // update mstatus
-            unsigned_T csr_temp;
-            csr_temp = this->regs->getCSR(CSR_MSTATUS);
-            if (csr_temp & MSTATUS_MPIE) {
-                csr_temp |= MSTATUS_MIE;
-            }
-            csr_temp |= MSTATUS_MPIE;
-            this->regs->setCSR(CSR_MSTATUS, csr_temp);
+            this->regs->returnFromTrap(Machine);
 
             return true;
         }
@@ -1550,10 +1574,11 @@ namespace riscv_tlm {
 
             new_pc = this->regs->getCSR(CSR_SEPC);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. SRET: PC <- 0x{:x}", sc_core::sc_time_stamp().value(),
+            this->logger->debug("{} ps. PC: 0x{:x}. SRET: PC <- 0x{:x}", sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(), new_pc);
 
             this->regs->setPC(new_pc);
+            this->regs->returnFromTrap(Supervisor);
 
             return true;
         }
@@ -1564,7 +1589,17 @@ namespace riscv_tlm {
         }
 
         bool Exec_SFENCE() const {
-            this->logger->debug("{} ns. PC: 0x{:x}. SFENCE");
+            unsigned int rs1 = this->get_rs1();
+            unsigned int rs2 = this->get_rs2();
+
+            /* rs1 = x0: all addresses, rs2 = x0: all address spaces */
+            MMU *mmu = this->mem_intf->getMMU();
+            if (mmu != nullptr) {
+                mmu->sfence(this->regs->getValue(rs1), rs1 == 0, this->regs->getValue(rs2), rs2 == 0);
+            }
+
+            this->logger->debug("{} ps. PC: 0x{:x}. SFENCE.VMA x{:d}, x{:d}", sc_core::sc_time_stamp().value(),
+                                this->regs->getPC(), rs1, rs2);
             return true;
         }
 
@@ -1865,7 +1900,8 @@ namespace riscv_tlm {
                         case ANDI_F:
                             return OP_ANDI;
                         case SLLI_F:
-                            return OP_SLLI;
+                            /* other imm[11:6] values are Zbb/Zbs */
+                            return (this->m_instr.to_uint() >> 26) == 0 ? OP_SLLI : OP_ERROR;
                         case SRLI_F:
                             // TODO: Why funct7b is not working?
                             //switch (this->get_funct7b()) {
@@ -1882,6 +1918,11 @@ namespace riscv_tlm {
                     if ( (this->get_funct7() != 0) && (this->get_funct7() != 0b0100000) ) {
                         return OP_ERROR;
                     }
+                    /* funct7 0100000 with AND/OR/XOR is andn/orn/xnor (Zbb) */
+                    if ( (this->get_funct7() != 0) && (this->get_funct3() != ADD_F)
+                         && (this->get_funct3() != SRL_F) ) {
+                        return OP_ERROR;
+                    }
                     switch (this->get_funct3()) {
                         case ADD_F:
                             switch (this->get_funct7()) {
@@ -1970,6 +2011,10 @@ namespace riscv_tlm {
                             return OP_ADDIW;
                             break;
                         case SLLIW_F:
+                            /* slli.uw, clzw, ctzw and cpopw share this funct3 */
+                            if (this->get_funct7() != 0) {
+                                return OP_ERROR;
+                            }
                             return OP_SLLIW;
                             break;
                         case SRLIW_F:
@@ -0,0 +1,541 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file B_extension.h
+ * @brief Implement Zba, Zbb, Zbc, Zbs, Zbkb and Zbkx extensions part of the RISC-V
+ *
+ * Address generation (Zba), basic bit manipulation (Zbb), carry-less
+ * multiplication (Zbc, which covers Zbkc), single-bit instructions (Zbs) and
+ * the pack/permute instructions of the scalar crypto extensions (Zbkb, Zbkx)
+ * for RV32 and RV64.
+ * The instructions share the OP, OP-IMM, OP-32 and OP-IMM-32 major opcodes
+ * with the base ISA and M; BASE_ISA and M_extension reject these encodings
+ * so they reach this decoder. Bit counts, rotates, byte reversal and
+ * carry-less products run on the host primitives of BitManip.h.
+ */
+#pragma once
+#ifndef B_EXTENSION__H
+#define B_EXTENSION__H
+
+#include "systemc"
+#include <cstdint>
+
+#include "extension_base.h"
+#include "BitManip.h"
+#include "Instruction.h"
+#include "Registers.h"
+
+namespace riscv_tlm {
+
+    typedef enum {
+        /* Zba */
+        OP_B_SH1ADD,
+        OP_B_SH2ADD,
+        OP_B_SH3ADD,
+        OP_B_ADD_UW,
+        OP_B_SH1ADD_UW,
+        OP_B_SH2ADD_UW,
+        OP_B_SH3ADD_UW,
+        OP_B_SLLI_UW,
+        /* Zbb */
+        OP_B_ANDN,
+        OP_B_ORN,
+        OP_B_XNOR,
+        OP_B_CLZ,
+        OP_B_CTZ,
+        OP_B_CPOP,
+        OP_B_CLZW,
+        OP_B_CTZW,
+        OP_B_CPOPW,
+        OP_B_MAX,
+        OP_B_MAXU,
+        OP_B_MIN,
+        OP_B_MINU,
+        OP_B_SEXT_B,
+        OP_B_SEXT_H,
+        OP_B_ZEXT_H,
+        OP_B_ROL,
+        OP_B_ROR,
+        OP_B_RORI,
+        OP_B_ROLW,
+        OP_B_RORW,
+        OP_B_RORIW,
+        OP_B_ORC_B,
+        OP_B_REV8,
+        /* Zbc */
+        OP_B_CLMUL,
+        OP_B_CLMULH,
+        OP_B_CLMULR,
+        /* Zbs */
+        OP_B_BCLR,
+        OP_B_BCLRI,
+        OP_B_BEXT,
+        OP_B_BEXTI,
+        OP_B_BINV,
+        OP_B_BINVI,
+        OP_B_BSET,
+        OP_B_BSETI,
+        /* Zbkb, Zbkx */
+        OP_B_PACK,
+        OP_B_PACKH,
+        OP_B_PACKW,
+        OP_B_BREV8,
+        OP_B_ZIP,
+        OP_B_UNZIP,
+        OP_B_XPERM4,
+        OP_B_XPERM8,
+        OP_B_ERROR
+    } op_B_Codes;
+
+    typedef enum {
+        B_OP = 0b0110011,
+        B_OP_IMM = 0b0010011,
+        B_OP_32 = 0b0111011,
+        B_OP_IMM_32 = 0b0011011,
+    } B_Codes;
+
+    /** funct7 of the register forms */
+    typedef enum {
+        B7_SHADD = 0b0010000,
+        B7_LOGIC_N = 0b0100000,
+        B7_MINMAX_CLMUL = 0b0000101,
+        B7_PACK_ADD_UW = 0b0000100,
+        B7_ROTATE = 0b0110000,
+        B7_BCLR_BEXT = 0b0100100,
+        B7_BINV = 0b0110100,
+        B7_BSET_XPERM = 0b0010100,
+    } B_Funct7;
+
+    /** imm[11:6] of the shift-immediate forms */
+    typedef enum {
+        B6_SLLI_UW = 0b000010,
+        B6_BSETI = 0b001010,
+        B6_BCLRI_BEXTI = 0b010010,
+        B6_RORI = 0b011000,
+        B6_BINVI = 0b011010,
+    } B_Funct6;
+
+    /** imm[11:0] of the unary forms */
+    typedef enum {
+        B12_CLZ = 0x600,
+        B12_CTZ = 0x601,
+        B12_CPOP = 0x602,
+        B12_SEXT_B = 0x604,
+        B12_SEXT_H = 0x605,
+        B12_ORC_B = 0x287,
+        B12_REV8_32 = 0x698,
+        B12_REV8_64 = 0x6B8,
+        B12_BREV8 = 0x687,
+        B12_ZIP = 0x08F,
+    } B_Imm12;
+
+/**
+ * @brief Instruction decoding and fields access
+ */
+    template<typename T>
+    class B_extension : public extension_base<T> {
+    public:
+
+        /**
+         * @brief Constructor, same as base class
+         */
+        using extension_base<T>::extension_base;
+
+        using signed_T = typename std::make_signed<T>::type;
+        using unsigned_T = typename std::make_unsigned<T>::type;
+
+        /**
+         * @brief Access to opcode field
+         * @return return opcode field
+         */
+        inline unsigned_T opcode() const override {
+            return static_cast<unsigned_T>(this->m_instr.range(6, 0));
+        }
+
+        inline unsigned int get_imm12() const {
+            return this->m_instr.range(31, 20);
+        }
+
+        inline unsigned int get_funct6() const {
+            return this->m_instr.range(31, 26);
+        }
+
+        inline unsigned int get_funct7() const {
+            return this->m_instr.range(31, 25);
+        }
+
+        /**
+         * @brief Decodes opcode of instruction
+         * @return opcode of instruction
+         */
+        op_B_Codes decode() const {
+            constexpr bool rv64 = sizeof(T) == 8;
+            unsigned int funct3 = this->get_funct3();
+            unsigned int funct7 = this->get_funct7();
+
+            switch (opcode()) {
+                case B_OP:
+                    return decodeOp(funct7, funct3, rv64);
+                case B_OP_IMM: {
+                    unsigned int imm12 = get_imm12();
+                    /* RV32 has 5 bit shift amounts */
+                    bool shamt_ok = rv64 || this->m_instr[25] == 0;
+
+                    if (funct3 == 0b001) {
+                        switch (imm12) {
+                            case B12_CLZ:
+                                return OP_B_CLZ;
+                            case B12_CTZ:
+                                return OP_B_CTZ;
+                            case B12_CPOP:
+                                return OP_B_CPOP;
+                            case B12_SEXT_B:
+                                return OP_B_SEXT_B;
+                            case B12_SEXT_H:
+                                return OP_B_SEXT_H;
+                            case B12_ZIP:
+                                return rv64 ? OP_B_ERROR : OP_B_ZIP;
+                            default:
+                                break;
+                        }
+                        if (!shamt_ok) {
+                            return OP_B_ERROR;
+                        }
+                        switch (get_funct6()) {
+                            case B6_BCLRI_BEXTI:
+                                return OP_B_BCLRI;
+                            case B6_BINVI:
+                                return OP_B_BINVI;
+                            case B6_BSETI:
+                                return OP_B_BSETI;
+                            default:
+                                return OP_B_ERROR;
+                        }
+                    } else if (funct3 == 0b101) {
+                        if (imm12 == B12_ORC_B) {
+                            return OP_B_ORC_B;
+                        } else if (imm12 == (rv64 ? B12_REV8_64 : B12_REV8_32)) {
+                            return OP_B_REV8;
+                        } else if (imm12 == B12_BREV8) {
+                            return OP_B_BREV8;
+                        } else if (!rv64 && imm12 == B12_ZIP) {
+                            return OP_B_UNZIP;
+                        }
+                        if (!shamt_ok) {
+                            return OP_B_ERROR;
+                        }
+                        switch (get_funct6()) {
+                            case B6_RORI:
+                                return OP_B_RORI;
+                            case B6_BCLRI_BEXTI:
+                                return OP_B_BEXTI;
+                            default:
+                                return OP_B_ERROR;
+                        }
+                    }
+                    return OP_B_ERROR;
+                }
+                case B_OP_32:
+                    if (!rv64) {
+                        return OP_B_ERROR;
+                    }
+                    switch (funct7) {
+                        case B7_PACK_ADD_UW:
+                            if (funct3 == 0b000) {
+                                return OP_B_ADD_UW;
+                            } else if (funct3 == 0b100) {
+                                /* zext.h is packw with rs2 = x0 */
+                                return this->get_rs2() == 0 ? OP_B_ZEXT_H : OP_B_PACKW;
+                            }
+                            return OP_B_ERROR;
+                        case B7_SHADD:
+                            return funct3 == 0b010 ? OP_B_SH1ADD_UW
+                                 : funct3 == 0b100 ? OP_B_SH2ADD_UW
+                                 : funct3 == 0b110 ? OP_B_SH3ADD_UW : OP_B_ERROR;
+                        case B7_ROTATE:
+                            return funct3 == 0b001 ? OP_B_ROLW
+                                 : funct3 == 0b101 ? OP_B_RORW : OP_B_ERROR;
+                        default:
+                            return OP_B_ERROR;
+                    }
+                case B_OP_IMM_32:
+                    if (!rv64) {
+                        return OP_B_ERROR;
+                    }
+                    if (funct3 == 0b001) {
+                        switch (get_imm12()) {
+                            case B12_CLZ:
+                                return OP_B_CLZW;
+                            case B12_CTZ:
+                                return OP_B_CTZW;
+                            case B12_CPOP:
+                                return OP_B_CPOPW;
+                            default:
+                                return get_funct6() == B6_SLLI_UW ? OP_B_SLLI_UW : OP_B_ERROR;
+                        }
+                    }
+                    return (funct3 == 0b101 && funct7 == B7_ROTATE) ? OP_B_RORIW : OP_B_ERROR;
+                default:
+                    return OP_B_ERROR;
+            }
+        }
+
+        /**
+         * @brief Result of @p code for the current instruction on operands @p a (rs1) and @p b (rs2)
+         * @return false if @p code is not an instruction of this extension
+         */
+        bool compute(op_B_Codes code, unsigned_T a, unsigned_T b, unsigned_T &result) const {
+            constexpr unsigned int XLEN = sizeof(T) * 8;
+            unsigned int shamt = this->get_shamt_slli() & (XLEN - 1);
+
+            switch (code) {
+                /* Zba */
+                case OP_B_SH1ADD:
+                case OP_B_SH2ADD:
+                case OP_B_SH3ADD:
+                    result = b + (a << (code - OP_B_SH1ADD + 1));
+                    break;
+                case OP_B_ADD_UW:
+                case OP_B_SH1ADD_UW:
+                case OP_B_SH2ADD_UW:
+                case OP_B_SH3ADD_UW:
+                    result = b + (static_cast<unsigned_T>(static_cast<std::uint32_t>(a))
+                                  << (code - OP_B_ADD_UW));
+                    break;
+                case OP_B_SLLI_UW:
+                    result = static_cast<unsigned_T>(static_cast<std::uint32_t>(a)) << shamt;
+                    break;
+
+                /* Zbb */
+                case OP_B_ANDN:
+                    result = a & ~b;
+                    break;
+                case OP_B_ORN:
+                    result = a | ~b;
+                    break;
+                case OP_B_XNOR:
+                    result = ~(a ^ b);
+                    break;
+                case OP_B_CLZ:
+                    result = bitmanip::clz(a);
+                    break;
+                case OP_B_CTZ:
+                    result = bitmanip::ctz(a);
+                    break;
+                case OP_B_CPOP:
+                    result = bitmanip::popcount(a);
+                    break;
+                case OP_B_CLZW:
+                    result = bitmanip::clz(static_cast<std::uint32_t>(a));
+                    break;
+                case OP_B_CTZW:
+                    result = bitmanip::ctz(static_cast<std::uint32_t>(a));
+                    break;
+                case OP_B_CPOPW:
+                    result = bitmanip::popcount(static_cast<std::uint32_t>(a));
+                    break;
+                case OP_B_MAX:
+                    result = static_cast<signed_T>(a) < static_cast<signed_T>(b) ? b : a;
+                    break;
+                case OP_B_MAXU:
+                    result = a < b ? b : a;
+                    break;
+                case OP_B_MIN:
+                    result = static_cast<signed_T>(a) < static_cast<signed_T>(b) ? a : b;
+                    break;
+                case OP_B_MINU:
+                    result = a < b ? a : b;
+                    break;
+                case OP_B_SEXT_B:
+                    result = static_cast<unsigned_T>(static_cast<signed_T>(static_cast<std::int8_t>(a)));
+                    break;
+                case OP_B_SEXT_H:
+                    result = static_cast<unsigned_T>(static_cast<signed_T>(static_cast<std::int16_t>(a)));
+                    break;
+                case OP_B_ZEXT_H:
+                    result = static_cast<std::uint16_t>(a);
+                    break;
+                case OP_B_ROL:
+                    result = bitmanip::rotl(a, static_cast<unsigned int>(b));
+                    break;
+                case OP_B_ROR:
+                    result = bitmanip::rotr(a, static_cast<unsigned int>(b));
+                    break;
+                case OP_B_RORI:
+                    result = bitmanip::rotr(a, shamt);
+                    break;
+                case OP_B_ROLW:
+                    result = signExtendWord(bitmanip::rotl(static_cast<std::uint32_t>(a),
+                                                           static_cast<unsigned int>(b)));
+                    break;
+                case OP_B_RORW:
+                    result = signExtendWord(bitmanip::rotr(static_cast<std::uint32_t>(a),
+                                                           static_cast<unsigned int>(b)));
+                    break;
+                case OP_B_RORIW:
+                    result = signExtendWord(bitmanip::rotr(static_cast<std::uint32_t>(a), shamt));
+                    break;
+                case OP_B_ORC_B:
+                    result = bitmanip::orcb(a);
+                    break;
+                case OP_B_REV8:
+                    result = bitmanip::bswap(a);
+                    break;
+
+                /* Zbc */
+                case OP_B_CLMUL:
+                case OP_B_CLMULH:
+                case OP_B_CLMULR: {
+                    bitmanip::ClmulResult p = bitmanip::clmul(a, b);
+                    if constexpr (sizeof(T) == 4) {
+                        /* 32 x 32 bit product is in p.lo */
+                        result = code == OP_B_CLMUL ? static_cast<unsigned_T>(p.lo)
+                               : code == OP_B_CLMULH ? static_cast<unsigned_T>(p.lo >> 32)
+                               : static_cast<unsigned_T>(p.lo >> 31);
+                    } else {
+                        result = code == OP_B_CLMUL ? p.lo
+                               : code == OP_B_CLMULH ? p.hi
+                               : (p.hi << 1) | (p.lo >> 63);
+                    }
+                    break;
+                }
+
+                /* Zbs */
+                case OP_B_BCLR:
+                    result = a & ~(unsigned_T(1) << (b & (XLEN - 1)));
+                    break;
+                case OP_B_BCLRI:
+                    result = a & ~(unsigned_T(1) << shamt);
+                    break;
+                case OP_B_BEXT:
+                    result = (a >> (b & (XLEN - 1))) & 1;
+                    break;
+                case OP_B_BEXTI:
+                    result = (a >> shamt) & 1;
+                    break;
+                case OP_B_BINV:
+                    result = a ^ (unsigned_T(1) << (b & (XLEN - 1)));
+                    break;
+                case OP_B_BINVI:
+                    result = a ^ (unsigned_T(1) << shamt);
+                    break;
+                case OP_B_BSET:
+                    result = a | (unsigned_T(1) << (b & (XLEN - 1)));
+                    break;
+                case OP_B_BSETI:
+                    result = a | (unsigned_T(1) << shamt);
+                    break;
+
+                /* Zbkb, Zbkx */
+                case OP_B_PACK:
+                    result = (b << (XLEN / 2)) | ((a << (XLEN / 2)) >> (XLEN / 2));
+                    break;
+                case OP_B_PACKH:
+                    result = ((b & 0xFF) << 8) | (a & 0xFF);
+                    break;
+                case OP_B_PACKW:
+                    result = signExtendWord((static_cast<std::uint32_t>(b & 0xFFFF) << 16) | (a & 0xFFFF));
+                    break;
+                case OP_B_BREV8:
+                    result = bitmanip::brev8(a);
+                    break;
+                case OP_B_ZIP:
+                    result = bitmanip::zip(static_cast<std::uint32_t>(a));
+                    break;
+                case OP_B_UNZIP:
+                    result = bitmanip::unzip(static_cast<std::uint32_t>(a));
+                    break;
+                case OP_B_XPERM4:
+                    result = bitmanip::xperm<4>(a, b);
+                    break;
+                case OP_B_XPERM8:
+                    result = bitmanip::xperm<8>(a, b);
+                    break;
+
+                default:
+                    return false;
+            }
+            return true;
+        }
+
+        bool exec_instruction(Instruction &inst, op_B_Codes code) {
+            this->setInstr(inst.getInstr());
+
+            unsigned int rd = this->get_rd();
+            auto a = static_cast<unsigned_T>(this->regs->getValue(this->get_rs1()));
+            auto b = static_cast<unsigned_T>(this->regs->getValue(this->get_rs2()));
+            unsigned_T result;
+
+            if (!compute(code, a, b, result)) {
+                this->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, this->m_instr);
+                return false;
+            }
+
+            this->regs->setValue(rd, static_cast<T>(result));
+
+            this->logger->debug("{} ps. PC: 0x{:x}. B: 0x{:x} -> x{:d}(0x{:x})",
+                                sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                static_cast<std::uint32_t>(this->m_instr), rd, result);
+            return true;
+        }
+
+    private:
+
+        op_B_Codes decodeOp(unsigned int funct7, unsigned int funct3, bool rv64) const {
+            switch (funct7) {
+                case B7_SHADD:
+                    return funct3 == 0b010 ? OP_B_SH1ADD
+                         : funct3 == 0b100 ? OP_B_SH2ADD
+                         : funct3 == 0b110 ? OP_B_SH3ADD : OP_B_ERROR;
+                case B7_LOGIC_N:
+                    return funct3 == 0b111 ? OP_B_ANDN
+                         : funct3 == 0b110 ? OP_B_ORN
+                         : funct3 == 0b100 ? OP_B_XNOR : OP_B_ERROR;
+                case B7_MINMAX_CLMUL:
+                    switch (funct3) {
+                        case 0b001:
+                            return OP_B_CLMUL;
+                        case 0b010:
+                            return OP_B_CLMULR;
+                        case 0b011:
+                            return OP_B_CLMULH;
+                        case 0b100:
+                            return OP_B_MIN;
+                        case 0b101:
+                            return OP_B_MINU;
+                        case 0b110:
+                            return OP_B_MAX;
+                        case 0b111:
+                            return OP_B_MAXU;
+                        default:
+                            return OP_B_ERROR;
+                    }
+                case B7_PACK_ADD_UW:
+                    /* zext.h is pack with rs2 = x0 in RV32 (packw in RV64) */
+                    if (funct3 == 0b100) {
+                        return (!rv64 && this->get_rs2() == 0) ? OP_B_ZEXT_H : OP_B_PACK;
+                    }
+                    return funct3 == 0b111 ? OP_B_PACKH : OP_B_ERROR;
+                case B7_ROTATE:
+                    return funct3 == 0b001 ? OP_B_ROL
+                         : funct3 == 0b101 ? OP_B_ROR : OP_B_ERROR;
+                case B7_BCLR_BEXT:
+                    return funct3 == 0b001 ? OP_B_BCLR
+                         : funct3 == 0b101 ? OP_B_BEXT : OP_B_ERROR;
+                case B7_BINV:
+                    return funct3 == 0b001 ? OP_B_BINV : OP_B_ERROR;
+                case B7_BSET_XPERM:
+                    return funct3 == 0b001 ? OP_B_BSET
+                         : funct3 == 0b010 ? OP_B_XPERM4
+                         : funct3 == 0b100 ? OP_B_XPERM8 : OP_B_ERROR;
+                default:
+                    return OP_B_ERROR;
+            }
+        }
+
+        static unsigned_T signExtendWord(std::uint32_t value) {
+            return static_cast<unsigned_T>(static_cast<signed_T>(static_cast<std::int32_t>(value)));
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,199 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file BitManip.h
+ * @brief Host primitives behind the Zba/Zbb/Zbc/Zbs and Zbkb/Zbkx extensions
+ *
+ * Bit counts, byte swaps and rotates map onto compiler intrinsics, which
+ * become single popcnt/lzcnt/tzcnt/bswap/rol instructions on hosts that
+ * have them (see the ENABLE_HOST_BMI CMake option). Carry-less multiply
+ * uses PCLMULQDQ when the host supports it, picked once at start-up, with
+ * a portable shift-and-xor fallback.
+ *
+ * All functions work on 32 or 64 bit unsigned values.
+ */
+#pragma once
+#ifndef BIT_MANIP_H
+#define BIT_MANIP_H
+
+#include <cstdint>
+#include <type_traits>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <stdlib.h>
+#endif
+
+namespace riscv_tlm {
+
+namespace bitmanip {
+
+template<typename U>
+inline unsigned int popcount(U x) {
+    static_assert(std::is_unsigned<U>::value, "unsigned operand expected");
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned int n = 0;
+    for (; x != 0; x &= x - 1) {
+        n++;
+    }
+    return n;
+#else
+    return sizeof(U) == 8 ? __builtin_popcountll(x) : __builtin_popcount(static_cast<std::uint32_t>(x));
+#endif
+}
+
+/**
+ * @brief Count leading zeros, width of U for zero
+ */
+template<typename U>
+inline unsigned int clz(U x) {
+    if (x == 0) {
+        return sizeof(U) * 8;
+    }
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long idx;
+    if constexpr (sizeof(U) == 8) {
+        _BitScanReverse64(&idx, x);
+    } else {
+        _BitScanReverse(&idx, x);
+    }
+    return sizeof(U) * 8 - 1 - idx;
+#else
+    return sizeof(U) == 8 ? __builtin_clzll(x) : __builtin_clz(static_cast<std::uint32_t>(x));
+#endif
+}
+
+/**
+ * @brief Count trailing zeros, width of U for zero
+ */
+template<typename U>
+inline unsigned int ctz(U x) {
+    if (x == 0) {
+        return sizeof(U) * 8;
+    }
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long idx;
+    if constexpr (sizeof(U) == 8) {
+        _BitScanForward64(&idx, x);
+    } else {
+        _BitScanForward(&idx, x);
+    }
+    return idx;
+#else
+    return sizeof(U) == 8 ? __builtin_ctzll(x) : __builtin_ctz(static_cast<std::uint32_t>(x));
+#endif
+}
+
+template<typename U>
+inline U bswap(U x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    if constexpr (sizeof(U) == 8) {
+        return _byteswap_uint64(x);
+    } else {
+        return _byteswap_ulong(x);
+    }
+#else
+    if constexpr (sizeof(U) == 8) {
+        return __builtin_bswap64(x);
+    } else {
+        return __builtin_bswap32(x);
+    }
+#endif
+}
+
+/* the masked forms are recognised as rol/ror by GCC, Clang and MSVC */
+template<typename U>
+inline U rotl(U x, unsigned int n) {
+    constexpr unsigned int mask = sizeof(U) * 8 - 1;
+    n &= mask;
+    return static_cast<U>((x << n) | (x >> ((0u - n) & mask)));
+}
+
+template<typename U>
+inline U rotr(U x, unsigned int n) {
+    constexpr unsigned int mask = sizeof(U) * 8 - 1;
+    n &= mask;
+    return static_cast<U>((x >> n) | (x << ((0u - n) & mask)));
+}
+
+/**
+ * @brief orc.b: every non-zero byte becomes 0xFF
+ */
+template<typename U>
+inline U orcb(U x) {
+    constexpr U msb = static_cast<U>(0x8080808080808080ULL);
+    /* bit 7 of each byte is set iff the byte is non-zero, without carries between bytes */
+    U nz = (((x & ~msb) + ~msb) | x) & msb;
+    return static_cast<U>((nz >> 7) * 0xFF);
+}
+
+/**
+ * @brief brev8: reverse the bits of every byte
+ */
+template<typename U>
+inline U brev8(U x) {
+    x = static_cast<U>(((x >> 1) & static_cast<U>(0x5555555555555555ULL)) | ((x & static_cast<U>(0x5555555555555555ULL)) << 1));
+    x = static_cast<U>(((x >> 2) & static_cast<U>(0x3333333333333333ULL)) | ((x & static_cast<U>(0x3333333333333333ULL)) << 2));
+    return static_cast<U>(((x >> 4) & static_cast<U>(0x0F0F0F0F0F0F0F0FULL)) | ((x & static_cast<U>(0x0F0F0F0F0F0F0F0FULL)) << 4));
+}
+
+/**
+ * @brief zip (RV32): bit i of the low half goes to bit 2i, of the high half to 2i+1
+ */
+inline std::uint32_t zip(std::uint32_t x) {
+    std::uint32_t t;
+    t = (x ^ (x >> 8)) & 0x0000FF00u; x ^= t ^ (t << 8);
+    t = (x ^ (x >> 4)) & 0x00F000F0u; x ^= t ^ (t << 4);
+    t = (x ^ (x >> 2)) & 0x0C0C0C0Cu; x ^= t ^ (t << 2);
+    t = (x ^ (x >> 1)) & 0x22222222u; x ^= t ^ (t << 1);
+    return x;
+}
+
+/**
+ * @brief unzip (RV32): inverse of zip()
+ */
+inline std::uint32_t unzip(std::uint32_t x) {
+    std::uint32_t t;
+    t = (x ^ (x >> 1)) & 0x22222222u; x ^= t ^ (t << 1);
+    t = (x ^ (x >> 2)) & 0x0C0C0C0Cu; x ^= t ^ (t << 2);
+    t = (x ^ (x >> 4)) & 0x00F000F0u; x ^= t ^ (t << 4);
+    t = (x ^ (x >> 8)) & 0x0000FF00u; x ^= t ^ (t << 8);
+    return x;
+}
+
+/**
+ * @brief xperm4/xperm8: element i of the result is element idx[i] of @p lut (0 if out of range)
+ */
+template<unsigned int BITS, typename U>
+inline U xperm(U lut, U idx) {
+    constexpr unsigned int N = sizeof(U) * 8 / BITS;
+    constexpr U mask = static_cast<U>((1u << BITS) - 1);
+    U r = 0;
+    for (unsigned int i = 0; i < N; i++) {
+        U sel = (idx >> (i * BITS)) & mask;
+        if (sel < N) {
+            r |= ((lut >> (sel * BITS)) & mask) << (i * BITS);
+        }
+    }
+    return r;
+}
+
+/**
+ * @brief 64 x 64 -> 128 bit carry-less product
+ */
+struct ClmulResult {
+    std::uint64_t lo;
+    std::uint64_t hi;
+};
+
+ClmulResult clmul(std::uint64_t a, std::uint64_t b);
+
+/**
+ * @brief True if clmul() runs on PCLMULQDQ
+ */
+bool clmulIsNative();
+
+} // namespace bitmanip
+
+} // namespace riscv_tlm
+
+#endif // BIT_MANIP_H
@@ -1,6 +1,6 @@
 /**
  @file BusCtrl.h
- @brief Basic TLM-2 Bus controller (extended with UART, CLINT, PLIC, DMA, Syscall stubs)
+ @brief Basic TLM-2 Bus controller (extended with UART, CLINT, CLIC, PLIC, DMA, DVFS, Syscall stubs)
  */
 // SPDX-License-Identifier: GPL-3.0-or-later
 #ifndef __BUSCTRL_H__
@@ -8,6 +8,8 @@
 
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <unordered_map>
 
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 #include "systemc"
@@ -23,17 +25,26 @@ namespace riscv_tlm {
 #define TIMER_MEMORY_ADDRESS_HI   0x40004004
 #define TIMERCMP_MEMORY_ADDRESS_LO 0x40004008
 #define TIMERCMP_MEMORY_ADDRESS_HI 0x4000400C
+#define DVFS_BASE_ADDRESS         0x40008000
 
 #define UART0_BASE_ADDRESS        0x50000000
 
 // New stub blocks (addresses follow common RISC-V conventions)
 #define CLINT_BASE_ADDRESS        0x02000000
+#define CLIC_BASE_ADDRESS         0x02800000
 #define PLIC_BASE_ADDRESS         0x0C000000
 #define DMA_BASE_ADDRESS          0x30000000
+#define VIRTIO_NET_BASE_ADDRESS   0x30001000
 #define SYSCALL_BASE_ADDRESS      0x80000000  // before tohost region
 
 #define TO_HOST_ADDRESS           0x90000000
 
+// Window forwarded to another simulator process (--bridge-out), or the
+// interrupt doorbell of the process at the other end (--bridge-in)
+#define BRIDGE_BASE_ADDRESS       0x60000000
+
+struct BridgeSpec;
+
 class BusCtrl : sc_core::sc_module {
 public:
     tlm_utils::simple_target_socket<BusCtrl>    cpu_instr_socket;
@@ -41,6 +52,7 @@ public:
 
     // Additional target socket to accept DMA master transactions into the Bus
     tlm_utils::simple_target_socket<BusCtrl>    dma_master_socket;
+    tlm_utils::simple_target_socket<BusCtrl>    net_master_socket;
 
     tlm_utils::simple_initiator_socket<BusCtrl> memory_socket;
     tlm_utils::simple_initiator_socket<BusCtrl> trace_socket;
@@ -50,16 +62,45 @@ public:
     tlm_utils::simple_initiator_socket<BusCtrl> uart_socket;
     tlm_utils::simple_initiator_socket<BusCtrl> clint_socket;   // new
     tlm_utils::simple_initiator_socket<BusCtrl> plic_socket;    // new
+    tlm_utils::simple_initiator_socket<BusCtrl> clic_socket;
     tlm_utils::simple_initiator_socket<BusCtrl> dma_socket;     // new (register interface)
     tlm_utils::simple_initiator_socket<BusCtrl> syscall_socket; // new
+    tlm_utils::simple_initiator_socket<BusCtrl> dvfs_socket;
+    tlm_utils::simple_initiator_socket<BusCtrl> net_socket;
 
-    explicit BusCtrl(sc_core::sc_module_name const &name);
+    // Bridge to another simulator process (TlmBridge.h), only created with one
+    std::unique_ptr<tlm_utils::simple_initiator_socket<BusCtrl>> bridge_socket;
+    std::unique_ptr<tlm_utils::simple_target_socket<BusCtrl>> bridge_master_socket;    // --bridge-in only
+
+    /**
+     * @param bridge side of a bridge this bus connects to, if any
+     */
+    explicit BusCtrl(sc_core::sc_module_name const &name, const BridgeSpec *bridge = nullptr);
 
     void b_transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay);
 
 private:
+    void forward(tlm_utils::simple_initiator_socket<BusCtrl> &target, sc_dt::uint64 base,
+                 tlm::tlm_generic_payload &trans, sc_core::sc_time &delay);
+
+    /**
+     * @brief Serve a peripheral read from the DMI region the peripheral granted, if any
+     * @param delay gets the read latency of the region
+     * @return false if the read must go to the peripheral
+     */
+    bool readDirect(tlm_utils::simple_initiator_socket<BusCtrl> &target, sc_dt::uint64 base,
+                    tlm::tlm_generic_payload &trans, sc_core::sc_time &delay);
+
     bool instr_direct_mem_ptr(tlm::tlm_generic_payload &, tlm::tlm_dmi &dmi_data);
+    bool data_direct_mem_ptr(tlm::tlm_generic_payload &gp, tlm::tlm_dmi &dmi_data);
     void invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end);
+    void invalidate_peripheral_dmi(sc_dt::uint64 start, sc_dt::uint64 end);
+
+    // Last region each peripheral granted (read-only) or denied, in its own offsets (RegisterBank::dmi)
+    std::unordered_map<const void *, tlm::tlm_dmi> peripheral_dmi;
+
+    sc_dt::uint64 bridge_base{0};
+    sc_dt::uint64 bridge_size{0};
 };
 }
 #endif
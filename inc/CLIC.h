@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file CLIC.h
+ * @brief Core-Local Interrupt Controller (M-mode CLIC memory map)
+ *
+ * Every interrupt has its own pending, enable, attribute (trigger type and
+ * selective hardware vectoring) and control (level and priority) byte. The
+ * CLIC only ranks the pending and enabled interrupts: the hart compares the
+ * winner against mintstatus.mil and mintthresh and performs the trap entry,
+ * reading the handler address from the mtvt table for vectored interrupts.
+ *
+ * Memory map (offsets from CLIC_BASE_ADDRESS):
+ *  - 0x0000 cliccfg (nlbits in bits 4:1)
+ *  - 0x0004 clicinfo (read-only)
+ *  - 0x1000 + 4 * i: clicintip, clicintie, clicintattr, clicintctl of interrupt i
+ */
+#pragma once
+#ifndef INC_CLIC_H_
+#define INC_CLIC_H_
+
+#include "systemc"
+#include "tlm.h"
+#include "tlm_utils/simple_target_socket.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace riscv_tlm {
+
+    class CLIC : public sc_core::sc_module {
+    public:
+        tlm_utils::simple_target_socket<CLIC> socket;
+
+        static constexpr unsigned int MAX_INTERRUPTS = 4096;
+        static constexpr unsigned int INTCTLBITS = 8;
+
+        /**
+         * @brief Highest-ranked pending and enabled interrupt
+         */
+        struct Request {
+            std::uint32_t id{0};
+            std::uint8_t level{0};      ///< interrupt level, lower bits padded with ones
+            bool shv{false};            ///< selective hardware vectoring
+        };
+
+        SC_HAS_PROCESS(CLIC);
+
+        /**
+         * @param interrupts number of implemented interrupt inputs (at most 4096)
+         */
+        explicit CLIC(sc_core::sc_module_name const &name, unsigned int interrupts = 64);
+
+        /**
+         * @brief Request interrupt @p id (sets clicintip)
+         */
+        void raise(std::uint32_t id);
+
+        /**
+         * @brief Drive the input line of interrupt @p id
+         *
+         * Level-triggered interrupts follow the line (inverted if active-low),
+         * edge-triggered ones become pending on the active edge.
+         */
+        void set_irq(std::uint32_t id, bool line);
+
+        /**
+         * @brief True if some interrupt is pending and enabled
+         */
+        bool pending() const {
+            return active_count != 0;
+        }
+
+        /**
+         * @brief The interrupt to take; only meaningful while pending()
+         */
+        const Request &request() {
+            if (dirty) {
+                arbitrate();
+            }
+            return best;
+        }
+
+        /**
+         * @brief Trap entry or mnxti took @p id: clear it if edge-triggered
+         */
+        void acknowledge(std::uint32_t id);
+
+    private:
+        enum : std::uint8_t {
+            ATTR_SHV = 1 << 0,
+            ATTR_EDGE = 1 << 1,
+            ATTR_NEGATIVE = 1 << 2,
+            ATTR_MODE_M = 3 << 6,
+        };
+
+        void b_transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay);
+
+        std::uint8_t readByte(std::uint64_t offset) const;
+
+        void writeByte(std::uint64_t offset, std::uint8_t value);
+
+        void setPending(std::uint32_t id, bool value);
+
+        /* keep the pending-and-enabled bitmap in step with ip/ie of @p id */
+        void refresh(std::uint32_t id);
+
+        void arbitrate();
+
+        std::uint8_t levelOf(std::uint8_t ctl) const;
+
+        const unsigned int num_interrupts;
+
+        std::vector<std::uint8_t> ip;
+        std::vector<std::uint8_t> ie;
+        std::vector<std::uint8_t> attr;
+        std::vector<std::uint8_t> ctl;
+        std::vector<std::uint8_t> line_state;
+
+        std::vector<std::uint64_t> active;      ///< ip & ie, one bit per interrupt
+        unsigned int active_count{0};
+        bool dirty{false};
+        Request best;
+
+        std::uint8_t nlbits{0};
+    };
+}
+
+#endif /* INC_CLIC_H_ */
@@ -11,6 +11,10 @@
 
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
 #include "systemc"
 #include "tlm.h"
 #include "tlm_utils/simple_initiator_socket.h"
@@ -18,14 +22,23 @@
 
 #include "BASE_ISA.h"
 #include "C_extension.h"
+#include "ClockDomains.h"
+#include "CustomInstructions.h"
+#include "ExecutionHistory.h"
 #include "M_extension.h"
 #include "A_extension.h"
 #include "MemoryInterface.h"
 #include "Performance.h"
+#include "PluginManager.h"
 #include "Registers.h"
+#include "RunControl.h"
 
 namespace riscv_tlm {
 
+    class AotModule;
+
+    class LatchMap;
+
     typedef enum {RV32, RV64} cpu_types_t;
 
     /**
@@ -35,11 +48,19 @@ namespace riscv_tlm {
      */
     class CPU : public sc_core::sc_module  {
     public:
-        virtual void set_clock(sc_core::sc_clock* c) { (void)c; }
+        virtual void set_clock(ClockDomain* c) { core_clock = c; }
         
         // Identify pipelined cores
         virtual bool isPipelined() const { return false; }
 
+        /**
+         * @brief Report the model's own counters (stalls, flushes...) by name,
+         *        for the telemetry page; names fit in TelemetryCounter::name
+         */
+        virtual void visitCounters(const std::function<void(const char *, std::uint64_t)> &visit) const {
+            (void) visit;
+        }
+
         /* Constructors */
         explicit CPU(sc_core::sc_module_name const &name, bool debug);
 
@@ -68,6 +89,29 @@ namespace riscv_tlm {
          */
         tlm_utils::simple_target_socket<CPU> irq_line_socket;
 
+        /**
+         * @brief External interrupt lines from the PLIC
+         *
+         * Each write carries the MIP_MEIP / MIP_SEIP level mask of this hart.
+         */
+        tlm_utils::simple_target_socket<CPU> ext_irq_socket;
+
+        /**
+         * @brief Connect the core-local interrupt controller (mtvec.MODE = 3)
+         */
+        virtual void attachCLIC(CLIC *clic_unit) {
+            clic = clic_unit;
+        }
+
+        /**
+         * @brief Run the translated blocks of @p module where possible (--aot)
+         * @return false if this model only interprets
+         */
+        virtual bool attachAot(const AotModule *module) {
+            (void) module;
+            return false;
+        }
+
         /**
         * @brief DMI pointer is not longer valid
         * @param start memory address region start
@@ -97,6 +141,45 @@ namespace riscv_tlm {
         virtual std::uint64_t getStartDumpAddress() = 0;
         virtual std::uint64_t getEndDumpAddress() = 0;
 
+        /**
+         * @brief Copy of the architectural state of the hart, for reverse execution
+         * @return nullptr if the model cannot save its state
+         */
+        virtual std::shared_ptr<const HartState> saveHart() const {
+            return nullptr;
+        }
+
+        /**
+         * @brief Return to a state saved by saveHart() of this same hart
+         */
+        virtual void restoreHart(const HartState &state) {
+            (void) state;
+        }
+
+        /**
+         * @brief Register access for the debugger, in GDB numbering:
+         *        0-31 x registers, 32 pc, 33-64 f registers, 65 + n CSR n
+         * @return false if the model has no such register
+         */
+        virtual bool readDebugRegister(unsigned int n, std::uint64_t &value) {
+            (void) n;
+            (void) value;
+            return false;
+        }
+
+        virtual bool writeDebugRegister(unsigned int n, std::uint64_t value) {
+            (void) n;
+            (void) value;
+            return false;
+        }
+
+        /**
+         * @brief Add the pipeline latches of the model to @p map, for latch faults (FaultCampaign)
+         */
+        virtual void visitLatches(LatchMap &map) {
+            (void) map;
+        }
+
         /**
          * @brief AT protocol backward path callback
          * 
@@ -123,10 +206,303 @@ namespace riscv_tlm {
         bool interrupt;
         bool irq_already_down;
         sc_core::sc_time default_time;
+        ClockDomain *core_clock{nullptr};
         bool dmi_ptr_valid;
+        std::uint64_t dmi_epoch{0};         ///< DMI invalidations so far
         tlm::tlm_generic_payload trans;
         unsigned char *dmi_ptr = nullptr;
         bool last_mem_access = false;
+        unsigned int plugin_hart{0};
+
+        /**
+         * @brief Data access a pipelined model reports when its instruction retires
+         */
+        struct PluginAccess {
+            std::uint64_t addr;
+            unsigned int size;
+            bool is_store;
+        };
+        std::vector<PluginAccess> plugin_accesses;  ///< made since the last retired instruction
+        std::uint32_t ext_irq_lines{0};     ///< MIP_MEIP / MIP_SEIP levels driven by the PLIC
+        std::uint32_t ext_irq_mirrored{0};  ///< levels last copied into mip
+        CLIC *clic{nullptr};
+        bool irq_vectored{false};           ///< the last CLIC trap read its handler from mtvt
+
+        /**
+         * @brief Take a pending external interrupt, if enabled
+         *
+         * Mirrors the PLIC lines into mip.MEIP/SEIP and traps to M mode, or to
+         * S mode for a SEIP delegated in mideleg, when mie and the global
+         * enable of the target mode allow it. MEI has priority over SEI.
+         * @return true if a trap was taken (the PC now points to the handler)
+         */
+        template<typename T>
+        bool takeExternalInterrupt(Registers<T> *regs) {
+            if ((ext_irq_lines | ext_irq_mirrored) == 0) [[likely]] {
+                return false;
+            }
+            if (ext_irq_lines != ext_irq_mirrored) {
+                T mip = regs->getCSR(CSR_MIP) & ~static_cast<T>(MIP_MEIP | MIP_SEIP);
+                regs->setCSR(CSR_MIP, mip | static_cast<T>(ext_irq_lines));
+                ext_irq_mirrored = ext_irq_lines;
+            }
+
+            T pending = static_cast<T>(ext_irq_lines) & regs->getCSR(CSR_MIE);
+            if (pending == 0) {
+                return false;
+            }
+
+            const T status = regs->getCSR(CSR_MSTATUS);
+            const PrivilegeMode priv = regs->getPrivilege();
+            const T interrupt_bit = static_cast<T>(1) << (sizeof(T) * 8 - 1);
+
+            if (pending & MIP_MEIP) {
+                if (priv != Machine || (status & MSTATUS_MIE)) {
+                    regs->setCSR(CSR_MEPC, regs->getPC());
+                    regs->setCSR(CSR_MCAUSE, regs->machineCause(interrupt_bit | 11));
+                    regs->setCSR(CSR_MTVAL, 0);
+                    regs->enterTrap(Machine);
+                    regs->setPC(regs->trapVector(CSR_MTVEC, 11, true));
+                    return true;
+                }
+            }
+            if (pending & MIP_SEIP) {
+                if (regs->getCSR(CSR_MIDELEG) & MIP_SEIP) {
+                    if (priv == User || (priv == Supervisor && (status & MSTATUS_SIE))) {
+                        regs->setCSR(CSR_SEPC, regs->getPC());
+                        regs->setCSR(CSR_SCAUSE, interrupt_bit | 9);
+                        regs->setCSR(CSR_STVAL, 0);
+                        regs->enterTrap(Supervisor);
+                        regs->setPC(regs->trapVector(CSR_STVEC, 9, true));
+                        return true;
+                    }
+                } else if (priv != Machine || (status & MSTATUS_MIE)) {
+                    regs->setCSR(CSR_MEPC, regs->getPC());
+                    regs->setCSR(CSR_MCAUSE, regs->machineCause(interrupt_bit | 9));
+                    regs->setCSR(CSR_MTVAL, 0);
+                    regs->enterTrap(Machine);
+                    regs->setPC(regs->trapVector(CSR_MTVEC, 9, true));
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief Take the CLIC interrupt, if it preempts the current level
+         *
+         * Only in CLIC mode (mtvec.MODE = 3). Below M mode an interrupt is
+         * always taken; in M mode it needs mstatus.MIE and a level above both
+         * mintstatus.mil and mintthresh. mcause keeps the interrupted level in
+         * mpil and mil becomes the new level. A selectively vectored interrupt
+         * jumps through its mtvt entry (minhv is set while the entry is read),
+         * the others go to the common handler at mtvec.
+         * @return true if a trap was taken (the PC now points to the handler)
+         */
+        template<typename T>
+        bool takeCLICInterrupt(Registers<T> *regs) {
+            irq_vectored = false;
+            if (clic == nullptr || !clic->pending()) [[likely]] {
+                return false;
+            }
+            if (!regs->clicMode()) {
+                return false;
+            }
+
+            const CLIC::Request &req = clic->request();
+            const PrivilegeMode priv = regs->getPrivilege();
+            if (priv == Machine) {
+                const unsigned int level = std::max(regs->getInterruptLevel(),
+                                                    static_cast<unsigned int>(regs->getCSR(CSR_MINTTHRESH)));
+                if (!(regs->getCSR(CSR_MSTATUS) & MSTATUS_MIE) || req.level <= level) {
+                    return false;
+                }
+            }
+
+            const T interrupt_bit = static_cast<T>(1) << (sizeof(T) * 8 - 1);
+            const std::uint32_t id = req.id;
+            const unsigned int level = req.level;
+            const bool shv = req.shv;
+
+            regs->setCSR(CSR_MEPC, regs->getPC());
+            regs->setCSR(CSR_MCAUSE, regs->machineCause(interrupt_bit | id));
+            regs->setCSR(CSR_MTVAL, 0);
+            regs->enterTrap(Machine);
+            regs->setInterruptLevel(level);
+
+            if (!shv) {
+                regs->setPC(regs->trapVector(CSR_MTVEC, id, true));
+                return true;
+            }
+
+            clic->acknowledge(id);
+            const T cause = regs->getCSR(CSR_MCAUSE);
+            const T entry = regs->getCSR(CSR_MTVT) + static_cast<T>(id) * sizeof(T);
+            regs->setCSR(CSR_MCAUSE, cause | MCAUSE_MINHV);
+            try {
+                T handler = sizeof(T) == 8 ? static_cast<T>(mem_intf->readDataMem64(entry, 8))
+                                           : static_cast<T>(mem_intf->readDataMem(entry, 4));
+                regs->setCSR(CSR_MCAUSE, cause);
+                regs->setPC(handler & ~static_cast<T>(1));
+                irq_vectored = true;
+            } catch (const MemoryFault &fault) {
+                /* an instruction fetch fault on the table entry, minhv stays set */
+                const T code = fault.cause >= 12 ? 12 : 1;
+                regs->setCSR(CSR_MEPC, entry);
+                regs->setCSR(CSR_MCAUSE, (cause & ~(interrupt_bit | MCAUSE_EXCCODE_MASK)) | MCAUSE_MINHV | code);
+                regs->setCSR(CSR_MTVAL, entry);
+                regs->setPC(regs->trapVector(CSR_MTVEC, code, false));
+            }
+            return true;
+        }
+
+        /**
+         * @brief Register this hart with the plugin manager
+         *
+         * Every hart registers, plugins or not: they are installed after
+         * elaboration and are told the number of registered harts.
+         * @param regs register bank read by plugins
+         */
+        template<typename T>
+        void registerPluginHart(Registers<T> *regs) {
+            PluginManager::HartAccess access;
+            access.read_reg = [regs](unsigned int reg) -> std::uint64_t {
+                return reg < 32 ? static_cast<std::uint64_t>(regs->getValue(reg))
+                                : static_cast<std::uint64_t>(regs->getPC());
+            };
+            access.read_csr = [regs](int csr) -> std::uint64_t {
+                return static_cast<std::uint64_t>(regs->getCSR(csr));
+            };
+            access.fetch = [this](std::uint64_t addr, std::uint32_t &word) {
+                return fetchForPlugin(addr, word);
+            };
+            plugin_hart = PluginManager::getInstance()->registerHart(std::move(access));
+        }
+
+        /**
+         * @brief Plugin hook, called right before an instruction executes
+         *        (the 6-stage models call it when the instruction retires)
+         */
+        inline void pluginInsnExec(std::uint64_t pc, std::uint32_t instr) {
+            if (PluginManager::active()) {
+                PluginManager::getInstance()->onInsnExec(plugin_hart, pc, instr);
+            }
+        }
+
+        /**
+         * @brief Plugin hook for plugin_accesses, called right after pluginInsnExec()
+         *
+         * A pipelined model reaches memory before its instruction retires, so it
+         * turns off MemoryInterface::setPluginReports() and reports the accesses
+         * here, where the plugins attribute them to the right instruction.
+         */
+        inline void reportPluginAccesses() {
+            for (auto const &a : plugin_accesses) {
+                PluginManager::getInstance()->onMemAccess(a.addr, a.size, a.is_store);
+            }
+            plugin_accesses.clear();
+        }
+
+        /**
+         * @brief Run-control hook, called right after an instruction retires
+         * @param regs register bank, read only when a condition is set
+         * @param pc address of the retired instruction
+         * @param cycle current cycle of the model
+         * @return true if a stop or pause condition fired; retire nothing more this cycle
+         */
+        template<typename T>
+        inline bool runControlRetire(Registers<T> *regs, std::uint64_t pc, std::uint64_t cycle) {
+            if (!RunControl::armed()) [[likely]] {
+                return false;
+            }
+            return RunControl::getInstance()->retire(pc, cycle,
+                                                     static_cast<std::uint64_t>(regs->getValue(Registers<T>::ra)));
+        }
+
+        /**
+         * @brief readDebugRegister() / writeDebugRegister() on a register bank
+         */
+        template<typename T>
+        static bool readRegisterBank(Registers<T> *regs, unsigned int n, std::uint64_t &value) {
+            if (n < 32) {
+                value = static_cast<std::uint64_t>(regs->getValue(n));
+            } else if (n == 32) {
+                value = static_cast<std::uint64_t>(regs->getPC());
+            } else if (n < 65) {
+                value = regs->getFPValue(n - 33);
+            } else if (n < 65 + 4096) {
+                value = static_cast<std::uint64_t>(regs->getCSR(static_cast<int>(n - 65)));
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        template<typename T>
+        static bool writeRegisterBank(Registers<T> *regs, unsigned int n, std::uint64_t value) {
+            if (n < 32) {
+                regs->setValue(n, static_cast<T>(value));
+            } else if (n == 32) {
+                regs->setPC(static_cast<T>(value));
+            } else if (n < 65) {
+                regs->setFPValue(n - 33, value);
+            } else if (n < 65 + 4096) {
+                regs->setCSR(static_cast<int>(n - 65), static_cast<T>(value));
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        std::unique_ptr<CustomInsnContext> custom_ctx;
+        unsigned int ex_cycles{1};   ///< EX cycles of the last instruction (custom, vector)
+
+        /**
+         * @brief Give custom instruction semantics access to this hart
+         * @param regs register bank; mem_intf must already exist
+         */
+        template<typename T>
+        void attachCustomInstructions(Registers<T> *regs) {
+            custom_ctx = std::make_unique<CustomInsnHart<T>>(regs, mem_intf);
+        }
+
+        /**
+         * @brief Execute @p instr if it is a registered custom instruction
+         *
+         * Sets ex_cycles to the cycles the instruction holds EX (1 if
+         * @p instr is not custom).
+         * @param pc address of the instruction
+         * @param now current cycle, for functional unit occupancy
+         */
+        inline CustomInstructions::Result execCustom(std::uint32_t instr, std::uint64_t pc, std::uint64_t now) {
+            ex_cycles = 1;
+            if (!CustomInstructions::active() || !CustomInstructions::isCustomOpcode(instr)) {
+                return CustomInstructions::Result::NotCustom;
+            }
+            return CustomInstructions::getInstance()->execute(*custom_ctx, instr, pc, now, ex_cycles);
+        }
+
+        /**
+         * @brief Period of the core clock domain, which may change at run time
+         */
+        sc_core::sc_time corePeriod() const {
+            return core_clock ? core_clock->period() : default_time;
+        }
+
+        /**
+         * @brief Current cycle for models that advance time every cycle
+         */
+        std::uint64_t cycleNow() const {
+            if (core_clock) {
+                return core_clock->cycles();
+            }
+            return static_cast<std::uint64_t>(sc_core::sc_time_stamp() / default_time);
+        }
+
+    private:
+        bool fetchForPlugin(std::uint64_t addr, std::uint32_t &word) const;
+
+        void call_external_interrupt(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay);
     };
 
 } // namespace riscv_tlm
@@ -5,6 +5,11 @@
  * 
  * Pipeline Stages:
  *   PC -> IF -> ID -> IS -> EX -> MEM -> WB
+ *
+ * Every stage has two lanes. With an issue width of 2 (P6_ISSUE_WIDTH or
+ * --pairing width=2) IF delivers up to two instructions per cycle and IS
+ * issues the second one with the first when the pairing rules allow it;
+ * otherwise only lane 0 is used.
  */
 #pragma once
 #ifndef CPU_P32_6_CYCLE_H
@@ -23,9 +28,13 @@
 #include "BASE_ISA.h"
 #include "C_extension.h"
 #include "M_extension.h"
+#include "B_extension.h"
+#include "K_extension.h"
 #include "Performance.h"
 #include "ROB.h"
 #include "StoreBuffer.h"
+#include "FetchUnit.h"
+#include "IssueRules.h"
 
 namespace riscv_tlm {
 
@@ -38,7 +47,7 @@ public:
     CPURV32P6_Cycle(sc_core::sc_module_name const& name, BaseType PC, bool debug);
     ~CPURV32P6_Cycle() override;
 
-    void set_clock(sc_core::sc_clock* c) override;
+    void set_clock(ClockDomain* c) override;
     bool CPU_step() override { return false; }
     bool cpu_process_IRQ() override;
     void call_interrupt(tlm::tlm_generic_payload& m_trans, sc_core::sc_time& delay) override;
@@ -47,8 +56,30 @@ public:
     std::uint64_t getEndDumpAddress() override;
     bool isPipelined() const override { return true; }
 
+    void attachCLIC(CLIC *clic_unit) override {
+        CPU::attachCLIC(clic_unit);
+        register_bank->attachCLIC(clic_unit);
+    }
+
+    bool readDebugRegister(unsigned int n, std::uint64_t &value) override {
+        return readRegisterBank(register_bank, n, value);
+    }
+
+    bool writeDebugRegister(unsigned int n, std::uint64_t value) override {
+        return writeRegisterBank(register_bank, n, value);
+    }
+
+    void visitLatches(LatchMap &map) override;
+
     void printStats() const;
 
+    void visitCounters(const std::function<void(const char *, std::uint64_t)> &visit) const override {
+        visit("issue_cycles", pair_stats.issue_cycles);
+        visit("dual_issue", pair_stats.dual);
+        visit("hazard_stalls", pair_stats.blocked[PAIR_HAZARD]);
+        visit("rob_full", pair_stats.blocked[PAIR_RESOURCE]);
+    }
+
 private:
     // =========================================================================
     // Components
@@ -58,11 +89,12 @@ private:
     BASE_ISA<BaseType>*     base_inst{nullptr};
     C_extension<BaseType>*  c_inst{nullptr};
     M_extension<BaseType>*  m_inst{nullptr};
+    B_extension<BaseType>*  b_inst{nullptr};
+    K_extension<BaseType>*  k_inst{nullptr};
 
     BaseType int_cause{0};
     
-    sc_core::sc_clock* clk{nullptr};
-    sc_core::sc_time clock_period{10, sc_core::SC_NS};
+    ClockDomain* clk{nullptr};
 
     // =========================================================================
     // Pipeline Latches
@@ -71,14 +103,35 @@ private:
     // --- Pipeline Latches ---
     // These structures hold the state transferred between pipeline stages on each clock cycle.
     // Each latch has a `_reg` (current cycle output) and `_next` (next cycle input) instance.
+    // Both are arrays of LANES entries; lane 0 always holds the older instruction.
+    static constexpr unsigned int LANES = 2;
+
+    // Execution unit of a decoded instruction. Zb* and Zk* share OP and OP-IMM with the
+    // base ISA and compute on b_inst / k_inst; anything else this model does not implement
+    // (A, F/D, V, unknown encodings) stops the simulation when it reaches EX.
+    // A Zcmp/Zcmt instruction (UNIT_SEQUENCE) never reaches EX: IS issues it as micro-ops.
+    // A registered custom-0..3 instruction (UNIT_CUSTOM) runs its semantic in EX.
+    enum : uint8_t {
+        UNIT_BASE,
+        UNIT_BITMANIP,
+        UNIT_CRYPTO,
+        UNIT_SEQUENCE,
+        UNIT_CUSTOM,
+        UNIT_ILLEGAL
+    };
+
+    // Micro-op register holding the jvt entry a cm.jt / cm.jalt jumps through
+    static constexpr uint8_t UOP_TMP = 32;
 
     // IF -> ID Latch (Fetch to Decode)
     // Holds the instruction fetched from memory and its PC.
     struct IF_ID_Latch {
         uint32_t pc{0};     // Program Counter of the instruction
-        uint32_t instr{0};  // Raw instruction word
+        uint32_t instr{0};  // Instruction word (compressed ones expanded by the fetch unit)
+        uint8_t length{4};  // Encoded length: 2 for RVC, 4 otherwise
+        uint32_t encoding{0}; // Instruction as fetched, reported to the plugins at writeback
         bool valid{false};  // Validity flag (false if flushed or bubble)
-    } if_id_reg, if_id_next;
+    };
 
     // ID -> IS Latch (Decode to Issue)
     // Holds the decoded instruction details and extracted operands.
@@ -90,14 +143,20 @@ private:
         uint8_t opcode{0};
         uint8_t funct3{0};
         uint8_t funct7{0};
+        uint8_t length{4};
+        uint8_t unit{UNIT_BASE};       // Execution unit (UNIT_*)
+        uint8_t ext_op{0};             // op_B_Codes / op_K_Codes for the Zb* / Zk* units
+        uint32_t encoding{0};
+        bool retire{true};             // false for all but the last micro-op of a sequence
         bool valid{false};
-    } id_is_reg, id_is_next;
+    };
 
     // IS -> EX Latch (Issue to Execute)
     // Holds the values of the operands needed for execution.
     // At this point, registers have been read and hazards resolved.
     struct IS_EX_Latch {
         uint32_t pc{0};
+        uint32_t instr{0};   // Shift amounts and byte selects of the Zb* / Zk* units
         uint32_t rs1_val{0}; // Value of Source Register 1
         uint32_t rs2_val{0}; // Value of Source Register 2
         int32_t imm{0};
@@ -105,8 +164,13 @@ private:
         uint8_t opcode{0};
         uint8_t funct3{0};
         uint8_t funct7{0};
+        uint8_t length{4};
+        uint8_t unit{UNIT_BASE};
+        uint8_t ext_op{0};
+        uint32_t encoding{0};
+        bool retire{true};
         bool valid{false};
-    } is_ex_reg, is_ex_next;
+    };
 
     // EX -> MEM Latch (Execute to Memory)
     // Holds the ALU result (which might be an address or data) and control signals for memory access.
@@ -120,31 +184,67 @@ private:
         bool mem_write{false};     // Control signal: Write to memory?
         bool branch_taken{false};  // Was a branch taken?
         uint32_t branch_target{0}; // Where to branch to?
+        uint32_t encoding{0};
+        bool retire{true};
         bool valid{false};
-    } ex_mem_reg, ex_mem_next;
+    };
 
     // MEM -> WB Latch (Memory to Write Back)
     // Holds the final result to be written back to the register file.
     struct MEM_WB_Latch {
+        uint32_t pc{0};
         uint32_t result{0};    // Final data (from ALU or Memory)
         uint8_t rd{0};         // Destination Register
         bool reg_write{false}; // Control signal: Write to register?
+        uint32_t mem_addr{0};  // Data access of a load/store, for the plugins
+        uint8_t mem_size{0};   // Bytes accessed, 0 if none
+        bool mem_write{false};
+        uint32_t encoding{0};
+        bool retire{true};     // Counts as a retired instruction
         bool valid{false};
-    } mem_wb_reg, mem_wb_next;
+    };
+
+    std::array<IF_ID_Latch, LANES> if_id_reg, if_id_next;
+    std::array<ID_IS_Latch, LANES> id_is_reg, id_is_next;
+    std::array<IS_EX_Latch, LANES> is_ex_reg, is_ex_next;
+    std::array<EX_MEM_Latch, LANES> ex_mem_reg, ex_mem_next;
+    std::array<MEM_WB_Latch, LANES> mem_wb_reg, mem_wb_next;
+    std::vector<MEM_WB_Latch> wb_held;  // not yet retired when a run-control pause fired
 
     // =========================================================================
     // Control & State
     // =========================================================================
-    uint32_t pc_register{0};       // Current Program Counter
+    FetchUnit fetch_unit;          // Fetch blocks, instruction queue and RVC realignment
     bool stall_fetch{false};       // Stall Signal: Stop fetching new instructions
     bool flush_pipeline{false};    // Flush Signal: Clear pipeline stages (e.g., on misprediction)
     uint32_t pc_redirect_target{0};// Target address for redirect (Branch/Jump)
     bool pc_redirect_valid{false}; // Flag indicating valid redirect
+    unsigned int ex_hold{0};       // Further cycles EX stays busy with a custom or multi-cycle instruction
 
     // Scoreboard for hazard detection
     // Tracks which registers are currently pending a write from an instruction in the pipeline.
     // true = register is busy (being written to), false = register is ready.
-    bool scoreboard[32]{false};
+    // Entry UOP_TMP tracks the micro-op register.
+    bool scoreboard[33]{false};
+
+    // Micro-ops of the Zcmp/Zcmt instruction in IS; uop_next is the next one to issue
+    std::vector<ID_IS_Latch> uops;
+    std::size_t uop_next{0};
+    uint32_t uop_tmp{0};
+
+    // Latencies of the Zb* / Zk* operations (in cycles); the instruction holds EX for its latency.
+    // clmul* runs on the MUL pipe, the others on an ALU.
+    struct LatencyConfig {
+        unsigned int clmul_latency{2};      // Carry-less multiply (Zbc, Zbkc)
+        unsigned int bitcount_latency{1};   // clz/ctz/cpop (Zbb)
+        unsigned int aes_latency{2};        // AES round and key schedule steps (Zkne, Zknd)
+        unsigned int sm4_latency{2};        // SM4 round and key schedule steps (Zksed)
+        unsigned int hash_latency{1};       // SHA-2 and SM3 sigma/sum (Zknh, Zksh)
+    } latency;
+
+    // Issue width and pairing rules (copied from --pairing at construction)
+    PairingRules rules{PairingRules::defaults()};
+    PairStats pair_stats;
 
     // Statistics for cycle-accurate model
     struct Stats {
@@ -167,10 +267,22 @@ private:
 
     void cycle_thread();
 
+    // Per-lane work of the stages above
+    void decode(const IF_ID_Latch& in, ID_IS_Latch& out);
+    uint8_t classify(uint32_t instr, uint8_t& ext_op);
+    void issue(const ID_IS_Latch& in, IS_EX_Latch& out);
+    void issue_sequence(const ID_IS_Latch& in, const ID_IS_Latch& younger);
+    void crack(const ID_IS_Latch& in);
+    void execute(const IS_EX_Latch& in, EX_MEM_Latch& out);
+    uint32_t extension_result(const IS_EX_Latch& in);
+    unsigned int extension_latency(uint8_t unit, uint8_t ext_op) const;
+    void memory(const EX_MEM_Latch& in, MEM_WB_Latch& out);
+    bool writeback(const MEM_WB_Latch& in);     // true if a run-control condition fired
+
     // =========================================================================
     // Helpers
     // =========================================================================
-    bool fetch_instruction(uint32_t addr, uint32_t& data);
+    bool fetch_block(uint64_t addr, uint8_t* data, unsigned int len);
     // DMI uses base class members: dmi_ptr_valid, dmi_ptr (inherited from CPU)
     // Only need to track the address range locally
     sc_dt::uint64 dmi_start_addr{0};
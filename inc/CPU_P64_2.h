@@ -16,6 +16,11 @@
 #include "C_extension.h"
 #include "M_extension.h"
 #include "A_extension.h"
+#include "V_extension.h"
+#include "F_extension.h"
+#include "B_extension.h"
+#include "K_extension.h"
+#include "ExtensionDispatch.h"
 #include "Performance.h"
 
 namespace riscv_tlm {
@@ -40,7 +45,7 @@ public:
     CPURV64P2(sc_core::sc_module_name const& name, BaseType PC, bool debug);
     ~CPURV64P2() override;
 
-    void set_clock(sc_core::sc_clock* c) override { clk = c; }
+    void set_clock(ClockDomain* c) override { CPU::set_clock(c); clk = c; }
 
     bool CPU_step() override;
 
@@ -52,6 +57,19 @@ public:
 
     bool isPipelined() const override { return true; }
 
+    void attachCLIC(CLIC *clic_unit) override {
+        CPU::attachCLIC(clic_unit);
+        register_bank->attachCLIC(clic_unit);
+    }
+
+    bool readDebugRegister(unsigned int n, std::uint64_t &value) override {
+        return readRegisterBank(register_bank, n, value);
+    }
+
+    bool writeDebugRegister(unsigned int n, std::uint64_t value) override {
+        return writeRegisterBank(register_bank, n, value);
+    }
+
     // Pipeline statistics
     struct PipelineStats {
         uint64_t cycles{0};
@@ -62,6 +80,12 @@ public:
     
     PipelineStats getStats() const { return stats; }
 
+    void visitCounters(const std::function<void(const char *, std::uint64_t)> &visit) const override {
+        visit("stalls", stats.stalls);
+        visit("flushes", stats.flushes);
+        visit("control_hazards", stats.control_hazards);
+    }
+
 private:
     // =========================================================================
     // Architectural State
@@ -71,11 +95,16 @@ private:
     C_extension<BaseType>*   c_inst{nullptr};
     M_extension<BaseType>*   m_inst{nullptr};
     A_extension<BaseType>*   a_inst{nullptr};
+    V_extension<BaseType>*   v_inst{nullptr};
+    F_extension<BaseType>*   f_inst{nullptr};
+    B_extension<BaseType>*   b_inst{nullptr};
+    K_extension<BaseType>*   k_inst{nullptr};
+    IsaExtensions<BaseType>  isa;    ///< the decoders above, for dispatchExtensions()
 
     // IRQ bookkeeping
     BaseType int_cause{0};
 
-    sc_core::sc_clock* clk{nullptr};
+    ClockDomain* clk{nullptr};
 
     // Statistics
     PipelineStats stats{};
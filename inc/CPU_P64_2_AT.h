@@ -9,7 +9,7 @@
  * Key AT model features:
  * - Non-blocking transport (nb_transport_fw/nb_transport_bw)
  * - Explicit timing phases (BEGIN_REQ, END_REQ, BEGIN_RESP, END_RESP)
- * - Clock-driven pipeline stages using sc_clock
+ * - Clock-driven pipeline stages using the core clock domain
  * - Pipeline stages run as separate SC_THREADs synchronized to clock
  */
 #pragma once
@@ -31,6 +31,11 @@
 #include "C_extension.h"
 #include "M_extension.h"
 #include "A_extension.h"
+#include "V_extension.h"
+#include "F_extension.h"
+#include "B_extension.h"
+#include "K_extension.h"
+#include "ExtensionDispatch.h"
 #include "Performance.h"
 
 namespace riscv_tlm {
@@ -49,7 +54,7 @@ public:
     CPURV64P2_AT(sc_core::sc_module_name const& name, BaseType PC, bool debug);
     ~CPURV64P2_AT() override;
 
-    void set_clock(sc_core::sc_clock* c) override;
+    void set_clock(ClockDomain* c) override;
 
     bool CPU_step() override;
 
@@ -61,6 +66,19 @@ public:
 
     bool isPipelined() const override { return true; }
 
+    void attachCLIC(CLIC *clic_unit) override {
+        CPU::attachCLIC(clic_unit);
+        register_bank->attachCLIC(clic_unit);
+    }
+
+    bool readDebugRegister(unsigned int n, std::uint64_t &value) override {
+        return readRegisterBank(register_bank, n, value);
+    }
+
+    bool writeDebugRegister(unsigned int n, std::uint64_t value) override {
+        return writeRegisterBank(register_bank, n, value);
+    }
+
     // Pipeline statistics
     struct PipelineStats {
         uint64_t cycles{0};
@@ -73,6 +91,14 @@ public:
     
     PipelineStats getStats() const { return stats; }
 
+    void visitCounters(const std::function<void(const char *, std::uint64_t)> &visit) const override {
+        visit("stalls", stats.stalls);
+        visit("flushes", stats.flushes);
+        visit("control_hazards", stats.control_hazards);
+        visit("if_stalls", stats.if_stalls);
+        visit("mem_latency_cycles", stats.mem_latency_cycles);
+    }
+
     // AT Protocol backward path (overrides base class)
     tlm::tlm_sync_enum nb_transport_bw(tlm::tlm_generic_payload& trans,
                                         tlm::tlm_phase& phase,
@@ -85,10 +111,14 @@ private:
     C_extension<BaseType>*   c_inst{nullptr};
     M_extension<BaseType>*   m_inst{nullptr};
     A_extension<BaseType>*   a_inst{nullptr};
+    V_extension<BaseType>*   v_inst{nullptr};
+    F_extension<BaseType>*   f_inst{nullptr};
+    B_extension<BaseType>*   b_inst{nullptr};
+    K_extension<BaseType>*   k_inst{nullptr};
+    IsaExtensions<BaseType>  isa;    ///< the decoders above, for dispatchExtensions()
 
     BaseType int_cause{0};
-    sc_core::sc_clock* clk{nullptr};
-    sc_core::sc_time clock_period{10, sc_core::SC_NS};
+    ClockDomain* clk{nullptr};
     PipelineStats stats{};
 
     // Pipeline Latch: IF -> EX
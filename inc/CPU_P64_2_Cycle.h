@@ -24,6 +24,11 @@
 #include "C_extension.h"
 #include "M_extension.h"
 #include "A_extension.h"
+#include "V_extension.h"
+#include "F_extension.h"
+#include "B_extension.h"
+#include "K_extension.h"
+#include "ExtensionDispatch.h"
 #include "Performance.h"
 
 namespace riscv_tlm {
@@ -37,7 +42,7 @@ public:
     CPURV64P2_Cycle(sc_core::sc_module_name const& name, BaseType PC, bool debug);
     ~CPURV64P2_Cycle() override;
 
-    void set_clock(sc_core::sc_clock* c) override;
+    void set_clock(ClockDomain* c) override;
 
     bool CPU_step() override;
 
@@ -49,6 +54,21 @@ public:
 
     bool isPipelined() const override { return true; }
 
+    void attachCLIC(CLIC *clic_unit) override {
+        CPU::attachCLIC(clic_unit);
+        register_bank->attachCLIC(clic_unit);
+    }
+
+    bool readDebugRegister(unsigned int n, std::uint64_t &value) override {
+        return readRegisterBank(register_bank, n, value);
+    }
+
+    bool writeDebugRegister(unsigned int n, std::uint64_t value) override {
+        return writeRegisterBank(register_bank, n, value);
+    }
+
+    void visitLatches(LatchMap &map) override;
+
     // Cycle-accurate statistics
     struct CycleStats {
         uint64_t total_cycles{0};
@@ -58,6 +78,8 @@ public:
         uint64_t memory_cycles{0};
         uint64_t branch_penalty{0};
         uint64_t instructions_retired{0};
+        uint64_t irq_entries{0};
+        uint64_t irq_entry_cycles{0};
         
         double get_cpi() const { 
             return instructions_retired > 0 ? 
@@ -72,17 +94,30 @@ public:
     CycleStats getStats() const { return stats; }
     void printStats() const;
 
+    void visitCounters(const std::function<void(const char *, std::uint64_t)> &visit) const override {
+        visit("stall_cycles", stats.stall_cycles);
+        visit("fetch_cycles", stats.fetch_cycles);
+        visit("memory_cycles", stats.memory_cycles);
+        visit("branch_penalty", stats.branch_penalty);
+        visit("irq_entries", stats.irq_entries);
+        visit("irq_entry_cycles", stats.irq_entry_cycles);
+    }
+
 private:
     Registers<BaseType>*     register_bank{nullptr};
     BASE_ISA<BaseType>*      base_inst{nullptr};
     C_extension<BaseType>*   c_inst{nullptr};
     M_extension<BaseType>*   m_inst{nullptr};
     A_extension<BaseType>*   a_inst{nullptr};
+    V_extension<BaseType>*   v_inst{nullptr};
+    F_extension<BaseType>*   f_inst{nullptr};
+    B_extension<BaseType>*   b_inst{nullptr};
+    K_extension<BaseType>*   k_inst{nullptr};
+    IsaExtensions<BaseType>  isa;    ///< the decoders above, for dispatchExtensions()
 
     BaseType int_cause{0};
     
-    sc_core::sc_clock* clk{nullptr};
-    sc_core::sc_time clock_period{10, sc_core::SC_NS};
+    ClockDomain* clk{nullptr};
 
     CycleStats stats{};
 
@@ -109,6 +144,8 @@ private:
         uint32_t store_latency{1};
         uint32_t mul_latency{3};
         uint32_t div_latency{32};
+        uint32_t clmul_latency{2};
+        uint32_t bitcount_latency{1};
         uint32_t branch_penalty{1};
     } latency;
 
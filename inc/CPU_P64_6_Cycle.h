@@ -5,6 +5,12 @@
  * 
  * Pipeline Stages:
  *   PC -> IF -> ID -> IS -> EX -> MEM -> WB
+ *
+ * Every stage has two lanes. With an issue width of 2 (P6_ISSUE_WIDTH or
+ * --pairing width=2) Fetch delivers up to two instructions per cycle, Issue
+ * dispatches the second one with the first when the pairing rules allow it
+ * and a ROB entry is free, and Commit retires up to two per cycle; otherwise
+ * only lane 0 is used.
  */
 #pragma once
 #ifndef CPU_P64_6_CYCLE_H
@@ -23,9 +29,13 @@
 #include "BASE_ISA.h"
 #include "C_extension.h"
 #include "M_extension.h"
+#include "B_extension.h"
+#include "K_extension.h"
 #include "Performance.h"
 #include "ROB.h"
 #include "StoreBuffer.h"
+#include "FetchUnit.h"
+#include "IssueRules.h"
 
 namespace riscv_tlm {
 
@@ -38,7 +48,7 @@ public:
     CPURV64P6_Cycle(sc_core::sc_module_name const& name, BaseType PC, bool debug);
     ~CPURV64P6_Cycle() override;
 
-    void set_clock(sc_core::sc_clock* c) override;
+    void set_clock(ClockDomain* c) override;
     bool CPU_step() override { return false; }
     bool cpu_process_IRQ() override;
     void call_interrupt(tlm::tlm_generic_payload& m_trans, sc_core::sc_time& delay) override;
@@ -47,8 +57,30 @@ public:
     std::uint64_t getEndDumpAddress() override;
     bool isPipelined() const override { return true; }
 
+    void attachCLIC(CLIC *clic_unit) override {
+        CPU::attachCLIC(clic_unit);
+        register_bank->attachCLIC(clic_unit);
+    }
+
+    bool readDebugRegister(unsigned int n, std::uint64_t &value) override {
+        return readRegisterBank(register_bank, n, value);
+    }
+
+    bool writeDebugRegister(unsigned int n, std::uint64_t value) override {
+        return writeRegisterBank(register_bank, n, value);
+    }
+
+    void visitLatches(LatchMap &map) override;
+
     void printStats() const;
 
+    void visitCounters(const std::function<void(const char *, std::uint64_t)> &visit) const override {
+        visit("issue_cycles", pair_stats.issue_cycles);
+        visit("dual_issue", pair_stats.dual);
+        visit("hazard_stalls", pair_stats.blocked[PAIR_HAZARD]);
+        visit("rob_full", pair_stats.blocked[PAIR_RESOURCE]);
+    }
+
 private:
     // =========================================================================
     // Components
@@ -58,11 +90,12 @@ private:
     BASE_ISA<BaseType>*     base_inst{nullptr};
     C_extension<BaseType>*  c_inst{nullptr};
     M_extension<BaseType>*  m_inst{nullptr};
+    B_extension<BaseType>*  b_inst{nullptr};
+    K_extension<BaseType>*  k_inst{nullptr};
 
     BaseType int_cause{0};
     
-    sc_core::sc_clock* clk{nullptr};
-    sc_core::sc_time clock_period{10, sc_core::SC_NS};
+    ClockDomain* clk{nullptr};
 
     // =========================================================================
     // Pipeline Latches
@@ -70,21 +103,39 @@ private:
     
     // --- Pipeline Latches ---
     // These structures hold the state transferred between pipeline stages on each clock cycle.
+    // Each latch is an array of LANES entries; lane 0 always holds the older instruction.
+    static constexpr unsigned int LANES = 2;
+
+    // Execution unit of a decoded instruction. Zb* and Zk* share OP, OP-IMM, OP-32 and
+    // OP-IMM-32 with the base ISA and compute on b_inst / k_inst; anything else this model
+    // does not implement (A, F/D, V, unknown encodings) stops the simulation when it reaches EX.
+    // A Zcmp/Zcmt instruction (UNIT_SEQUENCE) never reaches EX: Issue dispatches it as micro-ops.
+    // A registered custom-0..3 instruction (UNIT_CUSTOM) runs its semantic in EX.
+    enum : uint8_t {
+        UNIT_BASE,
+        UNIT_BITMANIP,
+        UNIT_CRYPTO,
+        UNIT_SEQUENCE,
+        UNIT_CUSTOM,
+        UNIT_ILLEGAL
+    };
+
+    // Micro-op register holding the jvt entry a cm.jt / cm.jalt jumps through
+    static constexpr uint8_t UOP_TMP = 32;
     
-    // PCGen -> Fetch Latch
-    // Holds the next program counter to be fetched.
-    struct PCGen_Fetch_Latch {
-        uint64_t pc{0};    // Address to fetch from
-        bool valid{false}; // Start fetching?
-    } pcgen_fetch_reg, pcgen_fetch_next;
+    // PCGen -> Fetch
+    // PCGen reads fetch blocks into the instruction queue of the fetch unit,
+    // Fetch takes one instruction per cycle from its head.
 
     // Fetch -> ID Latch
     // Holds the fetched instruction and its PC.
     struct Fetch_ID_Latch {
         uint64_t pc{0};
-        uint32_t instr{0}; // Raw instruction data
+        uint32_t instr{0}; // Instruction data (compressed ones expanded by the fetch unit)
+        uint8_t length{4}; // Encoded length: 2 for RVC, 4 otherwise
+        uint32_t encoding{0}; // Instruction as fetched, reported to the plugins at commit
         bool valid{false};
-    } fetch_id_reg, fetch_id_next;
+    };
 
     // ID -> Issue Latch
     // Holds decoded instruction details ready for dispatch.
@@ -96,14 +147,20 @@ private:
         uint8_t opcode{0};
         uint8_t funct3{0};
         uint8_t funct7{0};
+        uint8_t length{4};
+        uint8_t unit{UNIT_BASE};       // Execution unit (UNIT_*)
+        uint8_t ext_op{0};             // op_B_Codes / op_K_Codes for the Zb* / Zk* units
+        uint32_t encoding{0};
+        bool retire{true};             // false for all but the last micro-op of a sequence
         bool valid{0};
-    } id_issue_reg, id_issue_next;
+    };
 
     // Issue -> EX Latch
     // Holds dispatched instruction with operands read from register bank.
     // Also contains the allocated ROB index for retirement.
     struct Issue_EX_Latch {
         uint64_t pc{0};
+        uint32_t instr{0};   // Shift amounts and byte selects of the Zb* / Zk* units
         uint64_t rs1_val{0};
         uint64_t rs2_val{0};
         int64_t imm{0};
@@ -111,9 +168,12 @@ private:
         uint8_t opcode{0};
         uint8_t funct3{0};
         uint8_t funct7{0};
+        uint8_t length{4};
+        uint8_t unit{UNIT_BASE};
+        uint8_t ext_op{0};
         int rob_index{-1};   // Index in Reorder Buffer (for tracking completion)
         bool valid{false};
-    } issue_ex_reg, issue_ex_next;
+    };
 
     // EX -> Commit (ROB/Architectural Update Interface)
     // Conceptually, EX writes to ROB. Commit reads from ROB.
@@ -121,13 +181,17 @@ private:
     // or just let EX update ROB directly.
     // For this model, EX will write to ROB, and Commit will retire from ROB.
 
+    std::array<Fetch_ID_Latch, LANES> fetch_id_reg, fetch_id_next;
+    std::array<ID_Issue_Latch, LANES> id_issue_reg, id_issue_next;
+    std::array<Issue_EX_Latch, LANES> issue_ex_reg, issue_ex_next;
+
     // =========================================================================
     // Control & State
     // =========================================================================
-    uint64_t next_pc{0};           // Next Program Counter (calculated by PCGen)
+    FetchUnit fetch_unit;          // Fetch blocks, instruction queue and RVC realignment
     
     // Stall Signals affecting various stages
-    bool stall_pcgen{false};
+    // (PCGen keeps filling the instruction queue; a full queue is its backpressure)
     bool stall_fetch{false};
     bool stall_issue{false};
     
@@ -135,10 +199,32 @@ private:
     bool flush_pipeline{false};
     uint64_t pc_redirect_target{0};
     bool pc_redirect_valid{false};
+
+    // Further cycles EX stays busy with a custom or multi-cycle instruction
+    unsigned int ex_hold{0};
  
     // Scoreboard for hazard detection
-    // Tracks registers pending writeback.
-    bool scoreboard[32]{false};
+    // Tracks registers pending writeback; entry UOP_TMP tracks the micro-op register.
+    bool scoreboard[33]{false};
+
+    // Micro-ops of the Zcmp/Zcmt instruction in Issue; uop_next is the next one to dispatch
+    std::vector<ID_Issue_Latch> uops;
+    std::size_t uop_next{0};
+    uint64_t uop_tmp{0};
+
+    // Latencies of the Zb* / Zk* operations (in cycles); the instruction holds EX for its latency.
+    // clmul* runs on the MUL pipe, the others on an ALU.
+    struct LatencyConfig {
+        unsigned int clmul_latency{2};      // Carry-less multiply (Zbc, Zbkc)
+        unsigned int bitcount_latency{1};   // clz/ctz/cpop (Zbb)
+        unsigned int aes_latency{2};        // AES round and key schedule steps (Zkne, Zknd)
+        unsigned int sm4_latency{2};        // SM4 round and key schedule steps (Zksed)
+        unsigned int hash_latency{1};       // SHA-2 and SM3 sigma/sum (Zknh, Zksh)
+    } latency;
+
+    // Issue width and pairing rules (copied from --pairing at construction)
+    PairingRules rules{PairingRules::defaults()};
+    PairStats pair_stats;
 
     // =========================================================================
     // Statistics
@@ -180,10 +266,20 @@ private:
 
     void cycle_thread();
 
+    // Per-lane work of the stages above
+    void decode(const Fetch_ID_Latch& in, ID_Issue_Latch& out);
+    uint8_t classify(uint32_t instr, uint8_t& ext_op);
+    void dispatch(const ID_Issue_Latch& in, Issue_EX_Latch& out, int rob_idx);
+    void dispatch_sequence(const ID_Issue_Latch& in, const ID_Issue_Latch& younger);
+    void crack(const ID_Issue_Latch& in);
+    void execute(const Issue_EX_Latch& in);
+    uint64_t extension_result(const Issue_EX_Latch& in);
+    unsigned int extension_latency(uint8_t unit, uint8_t ext_op) const;
+
     // =========================================================================
     // Helpers
     // =========================================================================
-    bool fetch_instruction(uint64_t addr, uint32_t& data);
+    bool fetch_block(uint64_t addr, uint8_t* data, unsigned int len);
     // DMI uses base class members: dmi_ptr_valid, dmi_ptr (inherited from CPU)
     uint64_t dmi_start_addr{0};
     uint64_t dmi_end_addr{0};
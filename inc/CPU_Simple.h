@@ -16,7 +16,13 @@
 #include "C_extension.h"
 #include "M_extension.h"
 #include "A_extension.h"
+#include "V_extension.h"
+#include "F_extension.h"
+#include "B_extension.h"
+#include "K_extension.h"
+#include "ExtensionDispatch.h"
 #include "Performance.h"
+#include "AotModule.h"
 
 namespace riscv_tlm {
 
@@ -34,7 +40,7 @@ public:
     CPURV32Simple(sc_core::sc_module_name const& name, BaseType PC, bool debug);
     ~CPURV32Simple() override;
 
-    void set_clock(sc_core::sc_clock* c) override { clk = c; }
+    void set_clock(ClockDomain* c) override { CPU::set_clock(c); clk = c; }
 
     bool CPU_step() override;
 
@@ -46,16 +52,70 @@ public:
 
     bool isPipelined() const override { return false; }
 
+    std::shared_ptr<const HartState> saveHart() const override;
+    void restoreHart(const HartState &state) override;
+
+    bool readDebugRegister(unsigned int n, std::uint64_t &value) override {
+        return readRegisterBank(register_bank, n, value);
+    }
+
+    bool writeDebugRegister(unsigned int n, std::uint64_t value) override {
+        return writeRegisterBank(register_bank, n, value);
+    }
+
+    void attachCLIC(CLIC *clic_unit) override {
+        CPU::attachCLIC(clic_unit);
+        register_bank->attachCLIC(clic_unit);
+    }
+
+    bool attachAot(const AotModule *module) override {
+        aot = module;
+        return true;
+    }
+
+    /**
+     * @brief Instructions translated code may retire before time advances and interrupts are checked
+     */
+    static constexpr std::uint32_t AOT_QUANTUM = 1024;
+
 private:
+    /**
+     * @brief Run translated blocks from the PC on, if there is one and nothing needs per-instruction hooks
+     * @return false if nothing retired; interpret the instruction instead
+     */
+    bool runTranslated();
+
+    /**
+     * @brief DMI regions around @p pc and @p sp for translated loads and stores
+     */
+    bool aotRegions(std::uint32_t pc, std::uint32_t sp);
+
+    struct AotRegion {
+        unsigned char *host{nullptr};
+        std::uint64_t start{0};
+        std::uint64_t end{0};
+    };
+
+    const AotModule *aot{nullptr};
+    AotRegion aot_region[RVVP_AOT_REGIONS];
+    std::uint64_t aot_epoch{0};
+
     Registers<BaseType>*     register_bank{nullptr};
     BASE_ISA<BaseType>*      base_inst{nullptr};
     C_extension<BaseType>*   c_inst{nullptr};
     M_extension<BaseType>*   m_inst{nullptr};
     A_extension<BaseType>*   a_inst{nullptr};
+    V_extension<BaseType>*   v_inst{nullptr};
+    F_extension<BaseType>*   f_inst{nullptr};
+    B_extension<BaseType>*   b_inst{nullptr};
+    K_extension<BaseType>*   k_inst{nullptr};
+    IsaExtensions<BaseType>  isa;    ///< the decoders above, for dispatchExtensions()
+    MMU*                     mmu{nullptr};
+    PMP*                     pmp{nullptr};
 
     std::uint32_t INSTR{0};
     BaseType int_cause{0};
-    sc_core::sc_clock* clk{nullptr};
+    ClockDomain* clk{nullptr};
 
     void invalidate_direct_mem_ptr(sc_dt::uint64, sc_dt::uint64) { dmi_ptr_valid = false; }
 };
@@ -70,7 +130,7 @@ public:
     CPURV64Simple(sc_core::sc_module_name const& name, BaseType PC, bool debug);
     ~CPURV64Simple() override;
 
-    void set_clock(sc_core::sc_clock* c) override { clk = c; }
+    void set_clock(ClockDomain* c) override { CPU::set_clock(c); clk = c; }
 
     bool CPU_step() override;
 
@@ -82,16 +142,39 @@ public:
 
     bool isPipelined() const override { return false; }
 
+    std::shared_ptr<const HartState> saveHart() const override;
+    void restoreHart(const HartState &state) override;
+
+    bool readDebugRegister(unsigned int n, std::uint64_t &value) override {
+        return readRegisterBank(register_bank, n, value);
+    }
+
+    bool writeDebugRegister(unsigned int n, std::uint64_t value) override {
+        return writeRegisterBank(register_bank, n, value);
+    }
+
+    void attachCLIC(CLIC *clic_unit) override {
+        CPU::attachCLIC(clic_unit);
+        register_bank->attachCLIC(clic_unit);
+    }
+
 private:
     Registers<BaseType>*     register_bank{nullptr};
     BASE_ISA<BaseType>*      base_inst{nullptr};
     C_extension<BaseType>*   c_inst{nullptr};
     M_extension<BaseType>*   m_inst{nullptr};
     A_extension<BaseType>*   a_inst{nullptr};
+    V_extension<BaseType>*   v_inst{nullptr};
+    F_extension<BaseType>*   f_inst{nullptr};
+    B_extension<BaseType>*   b_inst{nullptr};
+    K_extension<BaseType>*   k_inst{nullptr};
+    IsaExtensions<BaseType>  isa;    ///< the decoders above, for dispatchExtensions()
+    MMU*                     mmu{nullptr};
+    PMP*                     pmp{nullptr};
 
     std::uint32_t INSTR{0};
     BaseType int_cause{0};
-    sc_core::sc_clock* clk{nullptr};
+    ClockDomain* clk{nullptr};
 
     void invalidate_direct_mem_ptr(sc_dt::uint64, sc_dt::uint64) { dmi_ptr_valid = false; }
 };
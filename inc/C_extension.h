@@ -10,7 +10,9 @@
 #define C_EXTENSION__H
 
 #include "systemc"
+#include <array>
 #include <cstdint>  
+#include <cstring>
 #include <iostream>
 
 #include "extension_base.h"            
@@ -64,6 +66,32 @@ namespace riscv_tlm {
         OP_C_SWSP,
         OP_C_FSWSP,
         OP_C_SDSP,
+
+        /* Zcb */
+        OP_C_LBU,
+        OP_C_LHU,
+        OP_C_LH,
+        OP_C_SB,
+        OP_C_SH,
+        OP_C_ZEXT_B,
+        OP_C_SEXT_B,
+        OP_C_ZEXT_H,
+        OP_C_SEXT_H,
+        OP_C_ZEXT_W,
+        OP_C_NOT,
+        OP_C_MUL,
+
+        /* Zcmp */
+        OP_CM_PUSH,
+        OP_CM_POP,
+        OP_CM_POPRETZ,
+        OP_CM_POPRET,
+        OP_CM_MVSA01,
+        OP_CM_MVA01S,
+
+        /* Zcmt */
+        OP_CM_JT,
+
         OP_C_ERROR
     } op_C_Codes;
 
@@ -72,6 +100,7 @@ namespace riscv_tlm {
         C_FLD = 0b001,
         C_LW = 0b010,
         C_FLW = 0b011,
+        C_ZCB_MEM = 0b100,
         C_FSD = 0b101,
         C_SW = 0b110,
         C_FSW = 0b111,
@@ -101,8 +130,47 @@ namespace riscv_tlm {
         C_FDSP = 0b101,
         C_SWSP = 0b110,
         C_FWWSP = 0b111,
+
+        /* Zcb loads/stores: bits 12:10 of quadrant 0, funct3 100 */
+        C_4_LBU = 0b000,
+        C_4_LH = 0b001,
+        C_4_SB = 0b010,
+        C_4_SH = 0b011,
+
+        /* Zcb unary ops: bits 4:2 with bits 12:10 = 111, 6:5 = 11 */
+        C_5_ZEXT_B = 0b000,
+        C_5_SEXT_B = 0b001,
+        C_5_ZEXT_H = 0b010,
+        C_5_SEXT_H = 0b011,
+        C_5_ZEXT_W = 0b100,
+        C_5_NOT = 0b101,
+
+        /* Zcmp/Zcmt: bits 12:10 of quadrant 2, funct3 101 */
+        C_6_JT = 0b000,
+        C_6_MV = 0b011,
+        C_6_PUSHPOP = 0b110,
+        C_6_POPRET = 0b111,
     } C_Codes;
 
+    /**
+     * @brief Zcmp and Zcmt take over the C.FSDSP encodings, so they cannot
+     *        coexist with C.FSDSP. Selected at run time (--zcmp) to run both
+     *        kinds of firmware on one VP build; Zcb is always decoded.
+     */
+    class CodeSizeExtensions {
+    public:
+        static bool active() {
+            return s_active;
+        }
+
+        static void enable(bool on) {
+            s_active = on;
+        }
+
+    private:
+        static bool s_active;
+    };
+
 /**
  * @brief Instruction decoding and fields access
  */
@@ -442,6 +510,19 @@ namespace riscv_tlm {
                                 // RV64
                                 return OP_C_LD;
                             }
+                        case C_ZCB_MEM:
+                            switch (this->m_instr.range(12, 10)) {
+                                case C_4_LBU:
+                                    return OP_C_LBU;
+                                case C_4_LH:
+                                    return this->m_instr[6] == 0 ? OP_C_LHU : OP_C_LH;
+                                case C_4_SB:
+                                    return OP_C_SB;
+                                case C_4_SH:
+                                    return this->m_instr[6] == 0 ? OP_C_SH : OP_C_ERROR;
+                                default:
+                                    return OP_C_ERROR;
+                            }
                         case C_FSD:
                             return OP_C_FSD;
                         case C_SW:
@@ -493,9 +574,35 @@ namespace riscv_tlm {
                                                 return OP_C_ADDW;
                                             }
                                         case C_3_OR:
-                                            return OP_C_OR;
+                                            if (this->m_instr[12] == 0) {
+                                                return OP_C_OR;
+                                            } else {
+                                                return OP_C_MUL;
+                                            }
                                         case C_3_AND:
-                                            return OP_C_AND;
+                                            if (this->m_instr[12] == 0) {
+                                                return OP_C_AND;
+                                            }
+                                            switch (this->m_instr.range(4, 2)) {
+                                                case C_5_ZEXT_B:
+                                                    return OP_C_ZEXT_B;
+                                                case C_5_SEXT_B:
+                                                    return OP_C_SEXT_B;
+                                                case C_5_ZEXT_H:
+                                                    return OP_C_ZEXT_H;
+                                                case C_5_SEXT_H:
+                                                    return OP_C_SEXT_H;
+                                                case C_5_ZEXT_W:
+                                                    if constexpr (sizeof(signed_T) == 4) {
+                                                        return OP_C_ERROR;
+                                                    } else {
+                                                        return OP_C_ZEXT_W;
+                                                    }
+                                                case C_5_NOT:
+                                                    return OP_C_NOT;
+                                                default:
+                                                    return OP_C_ERROR;
+                                            }
                                     }
                             }
                             break;
@@ -515,6 +622,7 @@ namespace riscv_tlm {
                         case C_SLLI:
                             return OP_C_SLLI;
                         case C_FLDSP:
+                            return OP_C_FLDSP;
                         case C_LWSP:
                             return OP_C_LWSP;
                         case C_FLWSP:
@@ -540,7 +648,10 @@ namespace riscv_tlm {
                                 }
                             }
                         case C_FDSP:
-                            break;
+                            if (!CodeSizeExtensions::active()) {
+                                return OP_C_FSDSP;
+                            }
+                            return decodeZcmp();
                         case C_SWSP:
                             return OP_C_SWSP;
                         case C_FWWSP:
@@ -560,6 +671,82 @@ namespace riscv_tlm {
             return OP_C_ERROR;
         }
 
+        /**
+         * @brief Zcmp/Zcmt opcodes in the C.FSDSP space
+         */
+        [[nodiscard]] op_C_Codes decodeZcmp() const {
+            switch (this->m_instr.range(12, 10)) {
+                case C_6_JT:
+                    return OP_CM_JT;
+                case C_6_MV:
+                    switch (this->m_instr.range(6, 5)) {
+                        case 0b01:
+                            return OP_CM_MVSA01;
+                        case 0b11:
+                            return OP_CM_MVA01S;
+                        default:
+                            return OP_C_ERROR;
+                    }
+                case C_6_PUSHPOP:
+                    switch (this->m_instr.range(9, 8)) {
+                        case 0b00:
+                            return OP_CM_PUSH;
+                        case 0b10:
+                            return OP_CM_POP;
+                        default:
+                            return OP_C_ERROR;
+                    }
+                case C_6_POPRET:
+                    switch (this->m_instr.range(9, 8)) {
+                        case 0b00:
+                            return OP_CM_POPRETZ;
+                        case 0b10:
+                            return OP_CM_POPRET;
+                        default:
+                            return OP_C_ERROR;
+                    }
+                default:
+                    return OP_C_ERROR;
+            }
+        }
+
+        /**
+         * @brief True for the opcodes that redirect the PC (pipeline flush)
+         */
+        [[nodiscard]] static bool isControlFlow(op_C_Codes code) {
+            switch (code) {
+                case OP_C_J:
+                case OP_C_JAL:
+                case OP_C_JR:
+                case OP_C_JALR:
+                case OP_C_BEQZ:
+                case OP_C_BNEZ:
+                case OP_CM_POPRETZ:
+                case OP_CM_POPRET:
+                case OP_CM_JT:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        /**
+         * @brief Memory and register micro-ops of the last executed instruction
+         *
+         * Zcmp push/pop move one register per load/store and Zcmt reads a
+         * table entry; every other compressed instruction is a single op and
+         * reports zero loads and stores.
+         */
+        struct MicroOps {
+            unsigned int loads{0};
+            unsigned int stores{0};
+            unsigned int alu{1};
+        };
+
+        [[nodiscard]] const MicroOps &lastMicroOps() const {
+            return micro_ops;
+        }
+
         // PASS
         bool Exec_C_JR() const {
             std::uint32_t mem_addr;
@@ -573,7 +760,7 @@ namespace riscv_tlm {
                     static_cast<unsigned_T>((this->regs->getValue(rs1)) + static_cast<unsigned_T>(mem_addr)) &
                     0xFFFFFFFE);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.JR: PC <- 0x{:x}. x{:d}(0x{:x})", sc_core::sc_time_stamp().value(),
+            this->logger->debug("{} ps. PC: 0x{:x}. C.JR: PC <- 0x{:x}. x{:d}(0x{:x})", sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(), new_pc, rs1, this->regs->getValue(rs1));
 
             this->regs->setPC(new_pc);
@@ -591,7 +778,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs2);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.MV: x{:d}(0x{:x}) -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.MV: x{:d}(0x{:x}) -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 rs2, this->regs->getValue(rs2), rd, calc);
 
@@ -609,7 +796,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) + this->regs->getValue(rs2);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.ADD: x{:d} + x{} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.ADD: x{:d} + x{} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, calc);
@@ -635,7 +822,7 @@ namespace riscv_tlm {
             this->perf->dataMemoryRead();
             this->regs->setValue(rd, static_cast<std::int32_t>(data));
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.LWSP: x{:d} + {:d}(@0x{:x}) -> x{:d}({:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.LWSP: x{:d} + {:d}(@0x{:x}) -> x{:d}({:x})",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 rs1, imm, mem_addr, rd, data);
 
@@ -659,7 +846,7 @@ namespace riscv_tlm {
             calc = static_cast<signed_T>(this->regs->getValue(rs1)) + imm;
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.ADDI4SN: x{:d} + (0x{:x}) + {:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.ADDI4SN: x{:d} + (0x{:x}) + {:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 rs1, this->regs->getValue(rs1), imm, rd, calc);
 
@@ -680,7 +867,7 @@ namespace riscv_tlm {
                 calc = this->regs->getValue(rs1) + imm;
                 this->regs->setValue(rd, calc);
 
-                this->logger->debug("{} ns. PC: 0x{:x}. C.ADDI16SP: x{:d} + {:d} -> x{:d} (0x{:x})",
+                this->logger->debug("{} ps. PC: 0x{:x}. C.ADDI16SP: x{:d} + {:d} -> x{:d} (0x{:x})",
                                     sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                     rs1, imm, rd, calc);
             } else {
@@ -689,7 +876,7 @@ namespace riscv_tlm {
                 imm = get_imm_LUI();
                 this->regs->setValue(rd, imm);
 
-                this->logger->debug("{} ns. PC: 0x{:x}. C.LUI: x{:d} <- 0x{:x}", sc_core::sc_time_stamp().value(),
+                this->logger->debug("{} ps. PC: 0x{:x}. C.LUI: x{:d} <- 0x{:x}", sc_core::sc_time_stamp().value(),
                                     this->regs->getPC(),
                                     rd, imm);
             }
@@ -713,7 +900,7 @@ namespace riscv_tlm {
             this->mem_intf->writeDataMem(mem_addr, data, 4);
             this->perf->dataMemoryWrite();
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.SWSP: x{:d}(0x{:x}) -> x{:d} + {} (@0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.SWSP: x{:d}(0x{:x}) -> x{:d} + {} (@0x{:x})",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 rs2, data, rs1, imm, mem_addr);
 
@@ -737,7 +924,7 @@ namespace riscv_tlm {
                 new_pc = static_cast<unsigned_T>(this->regs->getPC());
             }
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.BEQZ: x{:d}(0x{:x}) == 0? -> PC (0xx{:d})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.BEQZ: x{:d}(0x{:x}) == 0? -> PC (0xx{:d})",
                                 sc_core::sc_time_stamp().value(), old_pc,
                                 rs1, val1, new_pc);
 
@@ -761,7 +948,7 @@ namespace riscv_tlm {
                 new_pc = static_cast<unsigned_T>(this->regs->getPC());
             }
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.BNEZ: x{:d}(0x{:x}) != 0? -> PC (0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.BNEZ: x{:d}(0x{:x}) != 0? -> PC (0x{:x})",
                                 sc_core::sc_time_stamp().value(), old_pc,
                                 rs1, val1, new_pc);
 
@@ -780,7 +967,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.LI: x{:d} ({:d}) + {:d} -> x{:d}(0x{:x}) ",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.LI: x{:d} ({:d}) + {:d} -> x{:d}(0x{:x}) ",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 rs1, this->regs->getValue(rs1), imm, rd, calc);
 
@@ -801,7 +988,7 @@ namespace riscv_tlm {
             calc = static_cast<unsigned_T>(this->regs->getValue(rs1)) >> shift;
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.SRLI: x{:d} >> {} -> x{:d}", sc_core::sc_time_stamp().value(),
+            this->logger->debug("{} ps. PC: 0x{:x}. C.SRLI: x{:d} >> {} -> x{:d}", sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, shift, rd);
 
@@ -822,7 +1009,7 @@ namespace riscv_tlm {
             calc = static_cast<signed_T>(this->regs->getValue(rs1)) >> shift;
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.SRAI: x{:d} >> {} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.SRAI: x{:d} >> {} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, shift, rd, calc);
@@ -842,7 +1029,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) << shift;
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.SLLI: x{:d} << {} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.SLLI: x{:d} << {} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, shift, rd, calc);
@@ -862,7 +1049,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) & imm;
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. ANDI: x{:d} C.AND 0x{:x} -> x{:d}",
+            this->logger->debug("{} ps. PC: 0x{:x}. ANDI: x{:d} C.AND 0x{:x} -> x{:d}",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, imm, rd);
@@ -881,7 +1068,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) - this->regs->getValue(rs2);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.SUB: x{:d} - x{:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.SUB: x{:d} - x{:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, calc);
@@ -900,7 +1087,7 @@ namespace riscv_tlm {
             calc =  static_cast<std::int32_t>((this->regs->getValue(rs1) - this->regs->getValue(rs2)) & 0xFFFFFFFF);
             this->regs->setValue(rd, static_cast<std::int32_t>(calc));
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.SUBW: x{:d} - x{:d} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.SUBW: x{:d} - x{:d} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, calc);
@@ -919,7 +1106,7 @@ namespace riscv_tlm {
             calc = static_cast<std::int32_t>((this->regs->getValue(rs1) + this->regs->getValue(rs2)) & 0xFFFFFFFF);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.ADDW: x{:d} + x{} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.ADDW: x{:d} + x{} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, calc);
@@ -940,7 +1127,7 @@ namespace riscv_tlm {
             mem_addr = imm + this->regs->getValue(rs1);
             data = this->regs->getValue(rs2);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.SDSP: 0x{:x} -> x{:d} + 0x{:x}(@0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.SDSP: 0x{:x} -> x{:d} + 0x{:x}(@0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs2, rs1, imm, mem_addr);
@@ -963,7 +1150,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) ^ this->regs->getValue(rs2);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.XOR: x{:d} XOR x{:d} -> x{:d}", sc_core::sc_time_stamp().value(),
+            this->logger->debug("{} ps. PC: 0x{:x}. C.XOR: x{:d} XOR x{:d} -> x{:d}", sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd);
 
@@ -981,7 +1168,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) | this->regs->getValue(rs2);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.OR: x{:d} OR x{:d} -> x{:d}", sc_core::sc_time_stamp().value(),
+            this->logger->debug("{} ps. PC: 0x{:x}. C.OR: x{:d} OR x{:d} -> x{:d}", sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd);
 
@@ -999,7 +1186,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) & this->regs->getValue(rs2);
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.AND: x{:d} AND x{:d} -> x{:d}", sc_core::sc_time_stamp().value(),
+            this->logger->debug("{} ps. PC: 0x{:x}. C.AND: x{:d} AND x{:d} -> x{:d}", sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd);
 
@@ -1018,7 +1205,7 @@ namespace riscv_tlm {
             calc = this->regs->getValue(rs1) + imm;
             this->regs->setValue(rd, calc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.ADDI: x{:d} + {} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.ADDI: x{:d} + {} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(), rs1, imm, rd, calc);
 
@@ -1040,7 +1227,7 @@ namespace riscv_tlm {
             calc = static_cast<std::int32_t>(aux);
 
             this->regs->setValue(rd, calc);
-            this->logger->debug("{} ns. PC: 0x{:x}. C.ADDIW: x{:d} + {} -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.ADDIW: x{:d} + {} -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(), rs1, imm, rd, calc);
 
@@ -1061,7 +1248,7 @@ namespace riscv_tlm {
             this->regs->setValue(rd, old_pc + 2);
             this->regs->setPC(new_pc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.JALR: x{:d} <- 0x{:x} PC <- 0xx{:x}",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.JALR: x{:d} <- 0x{:x} PC <- 0xx{:x}",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rd, old_pc + 4, new_pc);
@@ -1085,7 +1272,7 @@ namespace riscv_tlm {
             this->perf->dataMemoryRead();
             this->regs->setValue(rd, data);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.LW: x{:d}(0x{:x}) + {:d} (@0x{:x}) -> {:d} (0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.LW: x{:d}(0x{:x}) + {:d} (@0x{:x}) -> {:d} (0x{:x})",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 rs1, this->regs->getValue(rs1), imm, mem_addr, rd, data);
 
@@ -1110,7 +1297,7 @@ namespace riscv_tlm {
             this->perf->dataMemoryRead();
             this->regs->setValue(rd, data);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.LD: 0x{:x} + x{:d} (0x{:x}) -> x{:d}(0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.LD: 0x{:x} + x{:d} (0x{:x}) -> x{:d}(0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, imm, mem_addr, rd, data);
@@ -1131,7 +1318,7 @@ namespace riscv_tlm {
             mem_addr = imm + this->regs->getValue(rs1);
             data = this->regs->getValue(rs2);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.SD: 0x{:x} -> x{:d} + 0x{:x}(@0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.SD: 0x{:x} -> x{:d} + 0x{:x}(@0x{:x})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs2, rs1, imm, mem_addr);
@@ -1159,38 +1346,95 @@ namespace riscv_tlm {
             this->mem_intf->writeDataMem(mem_addr, data, 4);
             this->perf->dataMemoryWrite();
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.SW: x{:d}(0x{:x}) -> x{:d} + 0x{:x}(@0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.SW: x{:d}(0x{:x}) -> x{:d} + 0x{:x}(@0x{:x})",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 rs2, data, rs1, imm, mem_addr);
 
             return true;
         }
 
-        bool Exec_C_FSW_SD() const {
-            std::uint32_t mem_addr;
-            unsigned int rs1, rs2;
-            std::int32_t imm;
+        /**
+         * @brief C.FLW, C.FLD, C.FLWSP and C.FLDSP
+         * @param sp_based stack-pointer relative form
+         * @param is_double FLD/FLDSP
+         */
+        bool Exec_C_FLOAD(bool sp_based, bool is_double) {
+            unsigned_T mem_addr;
+            unsigned int rd, rs1;
+            unsigned_T imm;
             std::uint64_t data;
-            std::uint32_t aux;
 
-            rs1 = get_rs1p();
-            rs2 = get_rs2p();
-            imm = get_imm_L();
+            if (!this->regs->isFPEnabled()) {
+                this->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, this->m_instr);
+                return false;
+            }
+
+            if (sp_based) {
+                rd = this->get_rd();
+                rs1 = 2;
+                imm = is_double ? get_imm_LDSP() : get_imm_LWSP();
+            } else {
+                rd = get_rdp();
+                rs1 = get_rs1p();
+                imm = is_double ? get_imm_CL() : get_imm_L();
+            }
 
             mem_addr = imm + this->regs->getValue(rs1);
-            data = this->regs->getValue(rs2);
+            if (is_double) {
+                data = this->mem_intf->readDataMem64(mem_addr, 8);
+            } else {
+                /* NaN-box single precision values */
+                data = 0xFFFFFFFF00000000ULL | this->mem_intf->readDataMem(mem_addr, 4);
+            }
+
+            this->perf->dataMemoryRead();
+            this->regs->setFPValue(rd, data);
+
+            this->logger->debug("{} ps. PC: 0x{:x}. C.FL{}: x{:d} + {:d}(@0x{:x}) -> f{:d}(0x{:x})",
+                                sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                is_double ? "D" : "W", rs1, imm, mem_addr, rd, data);
+
+            return true;
+        }
+
+        /**
+         * @brief C.FSW, C.FSD, C.FSWSP and C.FSDSP
+         * @param sp_based stack-pointer relative form
+         * @param is_double FSD/FSDSP
+         */
+        bool Exec_C_FSTORE(bool sp_based, bool is_double) {
+            unsigned_T mem_addr;
+            unsigned int rs1, rs2;
+            unsigned_T imm;
+            std::uint64_t data;
 
-            aux = data >> 32;
-            this->mem_intf->writeDataMem(mem_addr, aux, 4);
+            if (!this->regs->isFPEnabled()) {
+                this->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, this->m_instr);
+                return false;
+            }
 
-            aux = data & 0x00000000FFFFFFFF;
-            this->mem_intf->writeDataMem(mem_addr+4, aux, 4);
+            if (sp_based) {
+                rs1 = 2;
+                rs2 = get_rs2();
+                imm = is_double ? get_imm_CSDSP() : get_imm_CSS();
+            } else {
+                rs1 = get_rs1p();
+                rs2 = get_rs2p();
+                imm = is_double ? get_imm_CL() : get_imm_L();
+            }
 
+            mem_addr = imm + this->regs->getValue(rs1);
+            data = this->regs->getFPValue(rs2);
+            if (is_double) {
+                this->mem_intf->writeDataMem64(mem_addr, data, 8);
+            } else {
+                this->mem_intf->writeDataMem(mem_addr, static_cast<std::uint32_t>(data), 4);
+            }
             this->perf->dataMemoryWrite();
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.SD: x{:d}(0x{:x}) -> x{:d} + 0x{:x}(@0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.FS{}: f{:d}(0x{:x}) -> x{:d} + {:d}(@0x{:x})",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
-                                rs2, data, rs1, imm, mem_addr);
+                                is_double ? "D" : "W", rs2, data, rs1, imm, mem_addr);
             return true;
         }
 
@@ -1219,7 +1463,7 @@ namespace riscv_tlm {
             this->perf->dataMemoryRead();
             this->regs->setValue(rd, data);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.LDSP: x{:d}(0x{:x}) -> x{:d} + 0x{:x}(@0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.LDSP: x{:d}(0x{:x}) -> x{:d} + 0x{:x}(@0x{:x})",
                                 sc_core::sc_time_stamp().value(), this->regs->getPC(),
                                 2, data, rs1, imm, mem_addr);
             return true;
@@ -1241,16 +1485,231 @@ namespace riscv_tlm {
             old_pc = old_pc + 2;
             this->regs->setValue(rd, old_pc);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.JAL: x{:d} <- 0x{:x}. PC + 0x{:x} -> PC (0x{:x})",
+            this->logger->debug("{} ps. PC: 0x{:x}. C.JAL: x{:d} <- 0x{:x}. PC + 0x{:x} -> PC (0x{:x})",
                                 sc_core::sc_time_stamp().value(), old_pc - 2,
                                 rd, old_pc, mem_addr, new_pc);
 
             return true;
         }
 
+        /**
+         * @brief C.LBU, C.LHU, C.LH (Zcb)
+         */
+        bool Exec_C_LOAD_BH(unsigned int size, bool is_signed) {
+            unsigned_T mem_addr;
+            unsigned int rd, rs1;
+            unsigned_T imm;
+            unsigned_T data;
+
+            rd = get_rdp();
+            rs1 = get_rs1p();
+            imm = size == 1 ? (this->m_instr[6] | (this->m_instr[5] << 1)) : (this->m_instr[5] << 1);
+
+            mem_addr = imm + this->regs->getValue(rs1);
+            data = this->mem_intf->readDataMem(mem_addr, static_cast<int>(size));
+            if (is_signed) {
+                data = static_cast<unsigned_T>(static_cast<signed_T>(static_cast<std::int16_t>(data)));
+            }
+
+            this->perf->dataMemoryRead();
+            this->regs->setValue(rd, data);
+
+            this->logger->debug("{} ps. PC: 0x{:x}. C.L{}{}: x{:d} + {:d}(@0x{:x}) -> x{:d}(0x{:x})",
+                                sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                size == 1 ? "B" : "H", is_signed ? "" : "U", rs1, imm, mem_addr, rd, data);
+            return true;
+        }
+
+        /**
+         * @brief C.SB, C.SH (Zcb)
+         */
+        bool Exec_C_STORE_BH(unsigned int size) {
+            unsigned_T mem_addr;
+            unsigned int rs1, rs2;
+            unsigned_T imm;
+            std::uint32_t data;
+
+            rs1 = get_rs1p();
+            rs2 = get_rs2p();
+            imm = size == 1 ? (this->m_instr[6] | (this->m_instr[5] << 1)) : (this->m_instr[5] << 1);
+
+            mem_addr = imm + this->regs->getValue(rs1);
+            data = static_cast<std::uint32_t>(this->regs->getValue(rs2));
+            this->mem_intf->writeDataMem(mem_addr, data, static_cast<int>(size));
+            this->perf->dataMemoryWrite();
+
+            this->logger->debug("{} ps. PC: 0x{:x}. C.S{}: x{:d}(0x{:x}) -> x{:d} + {:d}(@0x{:x})",
+                                sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                size == 1 ? "B" : "H", rs2, data, rs1, imm, mem_addr);
+            return true;
+        }
+
+        /**
+         * @brief Zcb single-register ops on rd'/rs1': zext/sext.b/h, zext.w, not, mul
+         */
+        bool Exec_C_UNARY(op_C_Codes code) {
+            unsigned int rd = get_rs1p();
+            unsigned_T value = this->regs->getValue(rd);
+            unsigned_T calc;
+
+            switch (code) {
+                case OP_C_ZEXT_B:
+                    calc = static_cast<std::uint8_t>(value);
+                    break;
+                case OP_C_SEXT_B:
+                    calc = static_cast<unsigned_T>(static_cast<signed_T>(static_cast<std::int8_t>(value)));
+                    break;
+                case OP_C_ZEXT_H:
+                    calc = static_cast<std::uint16_t>(value);
+                    break;
+                case OP_C_SEXT_H:
+                    calc = static_cast<unsigned_T>(static_cast<signed_T>(static_cast<std::int16_t>(value)));
+                    break;
+                case OP_C_ZEXT_W:
+                    calc = static_cast<std::uint32_t>(value);
+                    break;
+                case OP_C_MUL:
+                    calc = value * static_cast<unsigned_T>(this->regs->getValue(get_rs2p()));
+                    break;
+                default:
+                    calc = ~value;
+                    break;
+            }
+            this->regs->setValue(rd, calc);
+
+            this->logger->debug("{} ps. PC: 0x{:x}. C.ZCB({:d}): x{:d}(0x{:x}) -> x{:d}(0x{:x})",
+                                sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                static_cast<int>(code), rd, value, rd, calc);
+            return true;
+        }
+
+        /**
+         * @brief CM.PUSH, CM.POP, CM.POPRET, CM.POPRETZ (Zcmp)
+         *
+         * The register list is stored below (push) or loaded from just under
+         * the top of (pop) the adjusted frame, ra lowest and the highest s
+         * register at the top, as one block transfer when the frame is in RAM.
+         */
+        bool Exec_CM_PUSHPOP(bool push, bool ret, bool zero_a0) {
+            static constexpr unsigned int order[13] = {1, 8, 9, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27};
+            constexpr unsigned int xlen_bytes = sizeof(T);
+
+            unsigned int rlist = this->m_instr.range(7, 4);
+            if (rlist < 4) {
+                this->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, this->m_instr);
+                return false;
+            }
+
+            /* rlist 15 is {ra, s0-s11}: s10 alone is not encodable */
+            unsigned int n = rlist == 15 ? 13 : rlist - 3;
+            unsigned_T frame = (n * xlen_bytes + 15) & ~static_cast<unsigned_T>(15);
+            unsigned_T stack_adj = frame + static_cast<unsigned_T>(this->m_instr.range(3, 2)) * 16;
+            unsigned_T sp = this->regs->getValue(2);
+            unsigned_T top = push ? sp : sp + stack_adj;
+            unsigned_T base = top - n * xlen_bytes;
+
+            std::array<std::uint8_t, 13 * 8> block{};
+            if (push) {
+                for (unsigned int k = 0; k < n; k++) {
+                    unsigned_T value = this->regs->getValue(order[k]);
+                    std::memcpy(&block[k * xlen_bytes], &value, xlen_bytes);
+                }
+                blockWrite(base, block.data(), n);
+                sp -= stack_adj;
+            } else {
+                blockRead(base, block.data(), n);
+                for (unsigned int k = 0; k < n; k++) {
+                    unsigned_T value = 0;
+                    std::memcpy(&value, &block[k * xlen_bytes], xlen_bytes);
+                    this->regs->setValue(order[k], value);
+                }
+                sp += stack_adj;
+            }
+            this->regs->setValue(2, sp);
+
+            micro_ops.loads = push ? 0 : n;
+            micro_ops.stores = push ? n : 0;
+            micro_ops.alu = 1 + (zero_a0 ? 1 : 0) + (ret ? 1 : 0);
+
+            if (zero_a0) {
+                this->regs->setValue(10, 0);
+            }
+
+            this->logger->debug("{} ps. PC: 0x{:x}. CM.{}: {:d} regs @0x{:x}, sp -> 0x{:x}",
+                                sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                push ? "PUSH" : (ret ? (zero_a0 ? "POPRETZ" : "POPRET") : "POP"), n, base, sp);
+
+            if (ret) {
+                this->regs->setPC(this->regs->getValue(1) & ~static_cast<unsigned_T>(1));
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief CM.MVSA01 (@p to_s) and CM.MVA01S (Zcmp)
+         */
+        bool Exec_CM_MV(bool to_s) {
+            auto sreg = [](unsigned int v) { return v < 2 ? v + 8 : v + 16; };
+            unsigned int r1s = sreg(this->m_instr.range(9, 7));
+            unsigned int r2s = sreg(this->m_instr.range(4, 2));
+
+            if (to_s && r1s == r2s) {
+                this->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, this->m_instr);
+                return false;
+            }
+
+            if (to_s) {
+                unsigned_T a0 = this->regs->getValue(10);
+                unsigned_T a1 = this->regs->getValue(11);
+                this->regs->setValue(r1s, a0);
+                this->regs->setValue(r2s, a1);
+            } else {
+                unsigned_T v1 = this->regs->getValue(r1s);
+                unsigned_T v2 = this->regs->getValue(r2s);
+                this->regs->setValue(10, v1);
+                this->regs->setValue(11, v2);
+            }
+            micro_ops.alu = 2;
+
+            this->logger->debug("{} ps. PC: 0x{:x}. CM.{}: x{:d}, x{:d}",
+                                sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                to_s ? "MVSA01" : "MVA01S", r1s, r2s);
+            return true;
+        }
+
+        /**
+         * @brief CM.JT and, for index >= 32, CM.JALT (Zcmt): jump through the jvt table
+         */
+        bool Exec_CM_JT() {
+            unsigned int index = this->m_instr.range(9, 2);
+            unsigned_T old_pc = this->regs->getPC();
+            unsigned_T entry = (this->regs->getCSR(CSR_JVT) & ~static_cast<unsigned_T>(63)) + index * sizeof(T);
+            unsigned_T target;
+
+            if constexpr (sizeof(T) == 4) {
+                target = this->mem_intf->readDataMem(entry, 4);
+            } else {
+                target = this->mem_intf->readDataMem64(entry, 8);
+            }
+            this->perf->dataMemoryRead();
+            micro_ops.loads = 1;
+
+            if (index >= 32) {
+                this->regs->setValue(1, old_pc + 2);
+            }
+            target &= ~static_cast<unsigned_T>(1);
+            this->regs->setPC(target);
+
+            this->logger->debug("{} ps. PC: 0x{:x}. CM.{} {:d}: @0x{:x} -> PC (0x{:x})",
+                                sc_core::sc_time_stamp().value(), old_pc,
+                                index >= 32 ? "JALT" : "JT", index, entry, target);
+            return false;
+        }
+
         bool Exec_C_EBREAK() {
 
-            this->logger->debug("{} ns. PC: 0x{:x}. C.EBREAK", sc_core::sc_time_stamp().value(), this->regs->getPC());
+            this->logger->debug("{} ps. PC: 0x{:x}. C.EBREAK", sc_core::sc_time_stamp().value(), this->regs->getPC());
             std::cout << std::endl << "C.EBREAK Instruction called, dumping information"
                       << std::endl;
             this->regs->dump();
@@ -1266,6 +1725,7 @@ namespace riscv_tlm {
             bool PC_not_affected = true;
 
             *breakpoint = false;
+            micro_ops = MicroOps{};
 
             this->setInstr(inst.getInstr());
 
@@ -1348,11 +1808,29 @@ namespace riscv_tlm {
                 case OP_C_AND:
                     Exec_C_AND();
                     break;
-                case OP_C_FSW:
-                    Exec_C_FSW_SD();
+                case OP_C_FLW:
+                    PC_not_affected = Exec_C_FLOAD(false, false);
+                    break;
+                case OP_C_FLD:
+                    PC_not_affected = Exec_C_FLOAD(false, true);
                     break;
                 case OP_C_FLWSP:
-                    //Exec_C_FLWSP_LDSP();
+                    PC_not_affected = Exec_C_FLOAD(true, false);
+                    break;
+                case OP_C_FLDSP:
+                    PC_not_affected = Exec_C_FLOAD(true, true);
+                    break;
+                case OP_C_FSW:
+                    PC_not_affected = Exec_C_FSTORE(false, false);
+                    break;
+                case OP_C_FSD:
+                    PC_not_affected = Exec_C_FSTORE(false, true);
+                    break;
+                case OP_C_FSWSP:
+                    PC_not_affected = Exec_C_FSTORE(true, false);
+                    break;
+                case OP_C_FSDSP:
+                    PC_not_affected = Exec_C_FSTORE(true, true);
                     break;
                 case OP_C_EBREAK:
                     Exec_C_EBREAK();
@@ -1381,6 +1859,51 @@ namespace riscv_tlm {
                 case OP_C_LDSP:
                     Exec_C_LDSP();
                     break;
+                case OP_C_LBU:
+                    Exec_C_LOAD_BH(1, false);
+                    break;
+                case OP_C_LHU:
+                    Exec_C_LOAD_BH(2, false);
+                    break;
+                case OP_C_LH:
+                    Exec_C_LOAD_BH(2, true);
+                    break;
+                case OP_C_SB:
+                    Exec_C_STORE_BH(1);
+                    break;
+                case OP_C_SH:
+                    Exec_C_STORE_BH(2);
+                    break;
+                case OP_C_ZEXT_B:
+                case OP_C_SEXT_B:
+                case OP_C_ZEXT_H:
+                case OP_C_SEXT_H:
+                case OP_C_ZEXT_W:
+                case OP_C_NOT:
+                case OP_C_MUL:
+                    Exec_C_UNARY(code);
+                    break;
+                case OP_CM_PUSH:
+                    PC_not_affected = Exec_CM_PUSHPOP(true, false, false);
+                    break;
+                case OP_CM_POP:
+                    PC_not_affected = Exec_CM_PUSHPOP(false, false, false);
+                    break;
+                case OP_CM_POPRETZ:
+                    PC_not_affected = Exec_CM_PUSHPOP(false, true, true);
+                    break;
+                case OP_CM_POPRET:
+                    PC_not_affected = Exec_CM_PUSHPOP(false, true, false);
+                    break;
+                case OP_CM_MVSA01:
+                    PC_not_affected = Exec_CM_MV(true);
+                    break;
+                case OP_CM_MVA01S:
+                    PC_not_affected = Exec_CM_MV(false);
+                    break;
+                case OP_CM_JT:
+                    PC_not_affected = Exec_CM_JT();
+                    break;
                 default:
                     std::cout << "C instruction not implemented yet" << "\n";
                     inst.dump();
@@ -1391,6 +1914,46 @@ namespace riscv_tlm {
             return PC_not_affected;
         }
 
+    private:
+        /* Zcmp register blocks: one DMI copy when the range is RAM, bus transactions otherwise */
+        void blockRead(unsigned_T addr, std::uint8_t *dst, unsigned int regs_count) {
+            constexpr unsigned int xlen_bytes = sizeof(T);
+            std::size_t len = regs_count * xlen_bytes;
+            unsigned char *p = this->mem_intf->getDMIPointer(addr, len, false);
+            for (unsigned int k = 0; k < regs_count; k++) {
+                if (p == nullptr) {
+                    std::uint64_t v = this->mem_intf->readDataMem64(addr + k * xlen_bytes, xlen_bytes);
+                    std::memcpy(dst + k * xlen_bytes, &v, xlen_bytes);
+                } else if (PluginManager::active()) {
+                    PluginManager::getInstance()->onMemAccess(addr + k * xlen_bytes, xlen_bytes, false);
+                }
+                this->perf->dataMemoryRead();
+            }
+            if (p != nullptr) {
+                std::memcpy(dst, p, len);
+            }
+        }
+
+        void blockWrite(unsigned_T addr, const std::uint8_t *src, unsigned int regs_count) {
+            constexpr unsigned int xlen_bytes = sizeof(T);
+            std::size_t len = regs_count * xlen_bytes;
+            unsigned char *p = this->mem_intf->getDMIPointer(addr, len, true);
+            if (p != nullptr) {
+                std::memcpy(p, src, len);
+            }
+            for (unsigned int k = 0; k < regs_count; k++) {
+                if (p == nullptr) {
+                    std::uint64_t v = 0;
+                    std::memcpy(&v, src + k * xlen_bytes, xlen_bytes);
+                    this->mem_intf->writeDataMem64(addr + k * xlen_bytes, v, xlen_bytes);
+                } else if (PluginManager::active()) {
+                    PluginManager::getInstance()->onMemAccess(addr + k * xlen_bytes, xlen_bytes, true);
+                }
+                this->perf->dataMemoryWrite();
+            }
+        }
+
+        MicroOps micro_ops{};
     };
 }
 
@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file ClockDomains.h
+ * @brief Named clock domains whose frequencies can change while the model runs
+ *
+ * The platform has four domains:
+ *  - core        pipeline cycles of the CPU models, mcycle/cycle CSRs
+ *  - bus         per-transaction cost of BusCtrl
+ *  - memory      per-access cost of the main memory
+ *  - peripheral  mtime of the CLINT and the time CSRs; a fixed timebase whose
+ *                frequency is only set before create(), so DVFS cannot retime it
+ * A domain counts whole cycles since the start of the run. A frequency change
+ * (--clocks, the DVFS controller or ClockDomain::setFrequency()) starts a new
+ * cycle at the time of the change, so the cycle count never jumps or goes
+ * backwards. Periods are rounded to the SystemC time resolution (1 ps), so a
+ * 3 GHz core runs at 333 ps per cycle.
+ *
+ * Bus and memory accesses cost a number of cycles of their own domain
+ * (0 by default); when any is set the CPU waits for them, so memory-bound
+ * code stops scaling with the core frequency.
+ */
+#pragma once
+#ifndef INC_CLOCKDOMAINS_H_
+#define INC_CLOCKDOMAINS_H_
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "systemc"
+
+#ifndef CORE_CLOCK_HZ
+#define CORE_CLOCK_HZ 100000000
+#endif
+
+namespace riscv_tlm {
+
+    class ClockDomain : public sc_core::sc_module {
+    public:
+        SC_HAS_PROCESS(ClockDomain);
+
+        ClockDomain(sc_core::sc_module_name const &name, double hz);
+
+        double frequency() const {
+            return m_hz;
+        }
+
+        const sc_core::sc_time &period() const {
+            return m_period;
+        }
+
+        /**
+         * @brief Change the frequency from now on
+         * @return false if @p hz is outside (0, 1 THz]
+         */
+        bool setFrequency(double hz);
+
+        /**
+         * @brief Whole cycles elapsed since the start of the run
+         */
+        std::uint64_t cycles() const;
+
+        /**
+         * @brief Rising edge of every cycle, as sc_clock::posedge_event()
+         */
+        const sc_core::sc_event &posedge_event() const {
+            return m_posedge;
+        }
+
+        /**
+         * @brief Cost of one access in this domain (bus and memory)
+         */
+        void setAccessCycles(std::uint32_t n);
+
+        std::uint32_t accessCycles() const {
+            return m_access_cycles;
+        }
+
+        sc_core::sc_time accessTime() const {
+            return m_period * m_access_cycles;
+        }
+
+        std::uint64_t transitions() const {
+            return m_transitions;
+        }
+
+        /**
+         * @brief Time spent at each frequency, up to now
+         */
+        std::map<double, sc_core::sc_time> residency() const;
+
+    private:
+        void tick();
+
+        double elapsed(const sc_core::sc_time &now) const;
+
+        double m_hz;
+        sc_core::sc_time m_period;
+        sc_core::sc_time m_base_time;       ///< time of the last frequency change
+        std::uint64_t m_base_cycles{0};     ///< cycles before the last frequency change
+        sc_core::sc_time m_next_edge;
+        std::uint32_t m_access_cycles{0};
+        std::uint64_t m_transitions{0};
+        std::map<double, sc_core::sc_time> m_residency;
+        sc_core::sc_event m_posedge;
+        sc_core::sc_event m_retimed;
+    };
+
+    class ClockDomains {
+    public:
+        enum Id {
+            CORE,
+            BUS,
+            MEMORY,
+            PERIPHERAL,
+            DOMAINS
+        };
+
+        static ClockDomains *getInstance();
+
+        /**
+         * @brief Create the domains; called once by the top level before elaboration ends
+         */
+        void create();
+
+        /**
+         * @brief True when bus or memory accesses cost time the CPU has to wait for
+         */
+        static bool timedAccesses() {
+            return s_timed_accesses;
+        }
+
+        ClockDomain &domain(Id id) {
+            return *m_domains[id];
+        }
+
+        ClockDomain &core() {
+            return domain(CORE);
+        }
+
+        bool created() const {
+            return m_domains[CORE] != nullptr;
+        }
+
+        /**
+         * @brief Apply a comma-separated spec such as
+         *        "core=200MHz,bus=100MHz,memory=50MHz:4,peripheral=1MHz"
+         *
+         * Frequencies take an optional Hz, kHz, MHz or GHz suffix; ":N" sets
+         * the access cost of the domain in its own cycles. Before create() the
+         * values become the initial settings.
+         * @return false with @p error set on an unknown domain or bad value
+         */
+        bool parse(const std::string &spec, std::string &error);
+
+        /**
+         * @brief Change the frequency of a domain (its initial one before create())
+         * @return false for a bad frequency, or for PERIPHERAL once created
+         */
+        bool setFrequency(Id id, double hz);
+
+        /**
+         * @brief mtime: cycles of the peripheral domain, plus what guest writes moved it by
+         */
+        std::uint64_t mtime() const;
+
+        /**
+         * @brief A guest write to mtime: the count goes on from @p value
+         */
+        void setMtime(std::uint64_t value);
+
+        void setAccessCycles(Id id, std::uint32_t n);
+
+        static const char *name(Id id);
+
+        static bool parseFrequency(const std::string &text, double &hz);
+
+        void print(std::ostream &os) const;
+
+    private:
+        ClockDomains() = default;
+
+        static bool s_timed_accesses;
+
+        std::array<ClockDomain *, DOMAINS> m_domains{};
+        std::array<double, DOMAINS> m_initial_hz{{CORE_CLOCK_HZ, CORE_CLOCK_HZ, CORE_CLOCK_HZ, 1000000}};
+        std::array<std::uint32_t, DOMAINS> m_initial_access{};
+        std::uint64_t m_mtime_offset{0};
+    };
+}
+
+#endif /* INC_CLOCKDOMAINS_H_ */
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file CryptoKernels.h
+ * @brief Host implementations of the AES and SM4 scalar crypto instructions
+ *
+ * The RV64 AES instructions operate on half of a 128-bit state held in two
+ * registers, which is what the host AES-NI round instructions compute when
+ * given a zero round key. They run on AES-NI when the host has it (picked
+ * once at start-up) and on T-tables otherwise. The per-byte RV32 AES and SM4
+ * instructions always use tables: one lookup is cheaper than moving the byte
+ * into a vector register.
+ *
+ * The AES state is stored as in the ISA: rs1 holds state bytes 0..7
+ * (columns 0 and 1), rs2 holds bytes 8..15.
+ */
+#pragma once
+#ifndef CRYPTO_KERNELS_H
+#define CRYPTO_KERNELS_H
+
+#include <cstdint>
+
+namespace riscv_tlm {
+
+namespace crypto {
+
+/**
+ * @brief RV64 AES operations on a {rs2:rs1} state
+ */
+enum class Aes64Op {
+    Es,     ///< aes64es: ShiftRows, SubBytes
+    Esm,    ///< aes64esm: ShiftRows, SubBytes, MixColumns
+    Ds,     ///< aes64ds: InvShiftRows, InvSubBytes
+    Dsm,    ///< aes64dsm: InvShiftRows, InvSubBytes, InvMixColumns
+};
+
+std::uint64_t aes64(Aes64Op op, std::uint64_t rs1, std::uint64_t rs2);
+
+/**
+ * @brief aes64im: InvMixColumns on the two columns of @p rs1
+ */
+std::uint64_t aes64im(std::uint64_t rs1);
+
+/**
+ * @brief aes64ks1i: SubWord (RotWord unless rnum is 0xA) of rs1[63:32] xor rcon
+ * @param rnum round number, 0..0xA
+ */
+std::uint64_t aes64ks1i(std::uint64_t rs1, unsigned int rnum);
+
+/**
+ * @brief aes64ks2: the xor chain of the key schedule
+ */
+inline std::uint64_t aes64ks2(std::uint64_t rs1, std::uint64_t rs2) {
+    std::uint32_t w0 = static_cast<std::uint32_t>(rs1 >> 32) ^ static_cast<std::uint32_t>(rs2);
+    std::uint32_t w1 = w0 ^ static_cast<std::uint32_t>(rs2 >> 32);
+    return (static_cast<std::uint64_t>(w1) << 32) | w0;
+}
+
+/**
+ * @brief aes32{e,d}s{,m}i: byte @p bs of rs2 through the (inverse) S-box,
+ *        optionally (inverse) MixColumns, rotated into place and xored into rs1
+ */
+std::uint32_t aes32(std::uint32_t rs1, std::uint32_t rs2, unsigned int bs, bool decrypt, bool mix);
+
+/**
+ * @brief sm4ed / sm4ks: byte @p bs of rs2 through the SM4 S-box and the
+ *        round (L) or key schedule (L') linear transform, xored into rs1
+ */
+std::uint32_t sm4(std::uint32_t rs1, std::uint32_t rs2, unsigned int bs, bool key_schedule);
+
+/**
+ * @brief True if the aes64 instructions run on AES-NI
+ */
+bool aesIsNative();
+
+} // namespace crypto
+
+} // namespace riscv_tlm
+
+#endif // CRYPTO_KERNELS_H
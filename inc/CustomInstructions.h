@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file CustomInstructions.h
+ * @brief Registry of user-defined instructions in the custom-0..3 opcode space
+ *
+ * Accelerator models register a decode mask/match, a semantic function and a
+ * timing descriptor. CPU models test the major opcode before the
+ * extension decode cascade (ExtensionDispatch.h), so standard instructions pay one
+ * compare and custom instructions never walk the cascade.
+ *
+ * Timing: @c latency is the number of cycles the instruction keeps EX busy
+ * (LT models annotate it, cycle models count it as stall cycles).
+ * @c occupancy is the initiation interval of the functional unit: a later
+ * instruction of the same registration issued earlier than that stalls.
+ */
+#pragma once
+#ifndef CUSTOM_INSTRUCTIONS_H
+#define CUSTOM_INSTRUCTIONS_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "MemoryInterface.h"
+#include "Registers.h"
+
+namespace riscv_tlm {
+
+/**
+ * @brief Per-hart view handed to custom instruction semantics
+ */
+class CustomInsnContext {
+public:
+    virtual ~CustomInsnContext() = default;
+
+    virtual std::uint64_t readReg(unsigned int reg) const = 0;
+    virtual void writeReg(unsigned int reg, std::uint64_t value) = 0;
+    virtual std::uint64_t load(std::uint64_t addr, unsigned int size) = 0;
+    virtual void store(std::uint64_t addr, std::uint64_t value, unsigned int size) = 0;
+    virtual unsigned int xlen() const = 0;
+
+    /**
+     * @brief Address of the executing instruction
+     */
+    std::uint64_t pc() const {
+        return cur_pc;
+    }
+
+    /**
+     * @brief Redirect control flow to @p target after this instruction
+     */
+    virtual void jump(std::uint64_t target) = 0;
+
+    /**
+     * @brief Add data-dependent cycles to the registered latency
+     */
+    void addCycles(unsigned int cycles) {
+        extra_cycles += cycles;
+    }
+
+protected:
+    bool jumped{false};
+
+private:
+    friend class CustomInstructions;
+
+    std::uint64_t cur_pc{0};
+    unsigned int extra_cycles{0};
+    std::vector<std::uint64_t> busy_until;   ///< per registration, in cycles
+};
+
+/**
+ * @brief Context over a hart's register bank and data memory interface
+ */
+template<typename T>
+class CustomInsnHart : public CustomInsnContext {
+public:
+    CustomInsnHart(Registers<T> *regs, MemoryInterface *mem) : regs(regs), mem(mem) {}
+
+    std::uint64_t readReg(unsigned int reg) const override {
+        return static_cast<std::uint64_t>(regs->getValue(reg));
+    }
+
+    void writeReg(unsigned int reg, std::uint64_t value) override {
+        regs->setValue(reg, static_cast<T>(value));
+    }
+
+    std::uint64_t load(std::uint64_t addr, unsigned int size) override {
+        return mem->readDataMem64(addr, static_cast<int>(size));
+    }
+
+    void store(std::uint64_t addr, std::uint64_t value, unsigned int size) override {
+        mem->writeDataMem64(addr, value, static_cast<int>(size));
+    }
+
+    unsigned int xlen() const override {
+        return sizeof(T) * 8;
+    }
+
+    void jump(std::uint64_t target) override {
+        regs->setPC(static_cast<T>(target));
+        jumped = true;
+    }
+
+private:
+    Registers<T> *regs;
+    MemoryInterface *mem;
+};
+
+struct CustomInsnTiming {
+    unsigned int latency{1};     ///< cycles in EX, >= 1
+    unsigned int occupancy{1};   ///< initiation interval of the unit, >= 1
+};
+
+class CustomInstructions {
+public:
+    /**
+     * @brief Semantic function
+     * @return false to raise an illegal instruction exception
+     */
+    using Semantic = std::function<bool(CustomInsnContext &ctx, std::uint32_t insn)>;
+
+    using Timing = CustomInsnTiming;
+
+    struct Entry {
+        std::string name;
+        std::uint32_t mask;
+        std::uint32_t match;
+        Semantic exec;
+        Timing timing;
+    };
+
+    enum class Result {
+        NotCustom,      ///< no registration matches, decode normally
+        Sequential,     ///< executed, continue at the next instruction
+        Jump,           ///< executed, PC was redirected
+        Illegal,        ///< semantic rejected the encoding
+    };
+
+    static CustomInstructions *getInstance();
+
+    /**
+     * @brief True once any instruction is registered
+     */
+    static inline bool active() {
+        return s_active;
+    }
+
+    /**
+     * @brief Major opcode is custom-0, custom-1, custom-2 or custom-3
+     */
+    static inline bool isCustomOpcode(std::uint32_t insn) {
+        switch (insn & 0x7F) {
+            case 0x0B:
+            case 0x2B:
+            case 0x5B:
+            case 0x7B:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief Register an instruction; must be called before simulation starts
+     * @param mask bits of the encoding that identify the instruction, including
+     *        the 7 opcode bits
+     * @return registration id, or -1 if the encoding is outside the custom
+     *         space or overlaps an existing registration
+     */
+    int add(const std::string &name, std::uint32_t mask, std::uint32_t match,
+            Semantic exec, Timing timing = Timing());
+
+    const Entry *lookup(std::uint32_t insn) const;
+
+    /**
+     * @brief Decode and execute @p insn if it is a registered custom instruction
+     * @param ctx hart executing the instruction
+     * @param pc address of the instruction
+     * @param now current cycle of the hart, used for unit occupancy
+     * @param cycles [out] cycles spent in EX, including occupancy stalls
+     */
+    Result execute(CustomInsnContext &ctx, std::uint32_t insn, std::uint64_t pc,
+                   std::uint64_t now, unsigned int &cycles);
+
+    /**
+     * @brief First cycle in which the unit of @p insn accepts another
+     *        instruction of this hart (occupancy), 0 if it never issued one
+     */
+    std::uint64_t readyAt(const CustomInsnContext &ctx, std::uint32_t insn) const;
+
+    const std::vector<Entry> &entries() const {
+        return table;
+    }
+
+private:
+    CustomInstructions() = default;
+
+    static bool s_active;
+    static CustomInstructions *instance;
+
+    std::vector<Entry> table;
+    /** Registration ids per custom-N slot (opcode bits 6:5) */
+    std::vector<int> by_slot[4];
+};
+
+} // namespace riscv_tlm
+
+#endif // CUSTOM_INSTRUCTIONS_H
@@ -10,6 +10,8 @@
 #include <atomic>
 #include <cstring>
 
+#include "RegisterBank.h"
+
 namespace riscv_tlm { namespace peripherals {
 // Minimal memory-to-memory DMA: registers for src, dst, length, control (start)
 class DMA : public sc_core::sc_module {
@@ -21,14 +23,30 @@ public:
     void set_debug(bool d) { debug_ = d; }
     static bool is_in_flight() { return in_flight_.load(); }
 
+    /* register map */
+    static constexpr std::uint64_t SRC = 0x00;
+    static constexpr std::uint64_t DST = 0x04;
+    static constexpr std::uint64_t LEN = 0x08;
+    static constexpr std::uint64_t CONTROL = 0x0C;     // bit 0: start, cleared when the transfer is done
+
     SC_HAS_PROCESS(DMA);
     explicit DMA(sc_core::sc_module_name const &name) : sc_module(name), socket("socket"), mem_master("mem_master"),
-        debug_(false), src(0), dst(0), len(0), control(0) {
+        debug_(false), regs(0x1000, RegisterBank::WORD) {
+        regs.add("src", SRC);
+        regs.add("dst", DST);
+        regs.add("len", LEN);
+        regs.add("control", CONTROL).onWrite([this](unsigned int, std::uint64_t value) {
+            if (value & 1u) start_transfer();
+        });
         socket.register_b_transport(this, &DMA::b_transport);
+        socket.register_get_direct_mem_ptr(this, &DMA::get_direct_mem_ptr);
     }
 
 private:
     void start_transfer() {
+        const auto src = static_cast<uint32_t>(regs.get(SRC));
+        const auto dst = static_cast<uint32_t>(regs.get(DST));
+        const auto len = static_cast<uint32_t>(regs.get(LEN));
         if (len == 0) return;
         if (mem_master.size() == 0) {
             SC_REPORT_ERROR("DMA", "mem_master socket not bound");
@@ -60,36 +78,20 @@ private:
         trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
         mem_master->b_transport(trans, delay);
         if (debug_) std::cout << "[DMA] Transfer complete" << std::endl;
-        control &= ~1u; // clear start bit
+        regs.set(CONTROL, regs.get(CONTROL) & ~1u); // clear start bit
         in_flight_.store(false);
     }
 
     void b_transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
         (void)delay;
-        auto cmd = trans.get_command();
-        uint64_t addr = trans.get_address();
-        unsigned char *ptr = trans.get_data_ptr();
-        unsigned len_bytes = trans.get_data_length();
-        if (len_bytes != 4) { trans.set_response_status(tlm::TLM_BURST_ERROR_RESPONSE); return; }
-        uint32_t val = 0;
-        if (cmd == tlm::TLM_WRITE_COMMAND) std::memcpy(&val, ptr, 4);
-        switch (addr) {
-            case 0x00: if (cmd == tlm::TLM_WRITE_COMMAND) src = val; else val = src; break;
-            case 0x04: if (cmd == tlm::TLM_WRITE_COMMAND) dst = val; else val = dst; break;
-            case 0x08: if (cmd == tlm::TLM_WRITE_COMMAND) this->len = val; else val = this->len; break;
-            case 0x0C:
-                if (cmd == tlm::TLM_WRITE_COMMAND) {
-                    control = val;
-                    if (control & 1u) start_transfer();
-                } else { val = control; }
-                break;
-            default: break; // ignore unknown
-        }
-        if (cmd == tlm::TLM_READ_COMMAND) std::memcpy(ptr, &val, 4);
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        regs.access(trans);
+    }
+
+    bool get_direct_mem_ptr(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi_data) {
+        return regs.dmi(trans, dmi_data);
     }
 
-    uint32_t src, dst, len, control;
+    RegisterBank regs;
 };
 
 // Definition of static in_flight_ flag
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+#include "systemc"
+#include "tlm.h"
+#include "tlm_utils/simple_target_socket.h"
+#include <cstdint>
+#include <cstring>
+
+#include "ClockDomains.h"
+
+namespace riscv_tlm { namespace peripherals {
+// DVFS controller: one 16-byte block per clock domain (core, bus, memory, peripheral)
+//   +0x0 FREQ_KHZ   R/W  frequency in kHz; a write retimes the domain from now on
+//                        (rejected for peripheral, the fixed timebase of mtime)
+//   +0x4 ACCESS     R/W  cycles of this domain per bus/memory access
+//   +0x8 CYCLES     R    cycles of the domain since reset (64-bit, low word first)
+// 0x40 STATUS       R/W1C  bit n: the last write to FREQ_KHZ of domain n was rejected
+class DVFS : public sc_core::sc_module {
+public:
+    tlm_utils::simple_target_socket<DVFS> socket;
+
+    explicit DVFS(sc_core::sc_module_name const &name) : sc_module(name), socket("socket") {
+        socket.register_b_transport(this, &DVFS::b_transport);
+    }
+
+private:
+    static constexpr std::uint64_t STATUS = 0x40;
+
+    void b_transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+        (void)delay;
+        auto *clocks = ClockDomains::getInstance();
+        const std::uint64_t addr = trans.get_address();
+        const unsigned len = trans.get_data_length();
+        unsigned char *ptr = trans.get_data_ptr();
+        const unsigned int id = static_cast<unsigned int>(addr >> 4);
+
+        if ((len != 4 && len != 8) || !clocks->created()
+            || (id >= ClockDomains::DOMAINS && addr != STATUS)) {
+            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            return;
+        }
+
+        std::uint64_t value = 0;
+        if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+            std::memcpy(&value, ptr, len);
+            if (addr == STATUS) {
+                m_status &= ~static_cast<std::uint32_t>(value);
+            } else if ((addr & 0xF) == 0x0) {
+                const auto domain = static_cast<ClockDomains::Id>(id);
+                if (clocks->setFrequency(domain, static_cast<double>(value & 0xFFFFFFFF) * 1e3)) {
+                    m_status &= ~(1u << id);
+                } else {
+                    m_status |= 1u << id;
+                }
+            } else if ((addr & 0xF) == 0x4) {
+                clocks->setAccessCycles(static_cast<ClockDomains::Id>(id), static_cast<std::uint32_t>(value));
+            }
+        } else if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+            if (addr == STATUS) {
+                value = m_status;
+            } else {
+                const ClockDomain &d = clocks->domain(static_cast<ClockDomains::Id>(id));
+                switch (addr & 0xF) {
+                    case 0x0: value = static_cast<std::uint64_t>(d.frequency() / 1e3); break;
+                    case 0x4: value = d.accessCycles(); break;
+                    case 0x8: value = d.cycles(); break;
+                    case 0xC: value = d.cycles() >> 32; break;
+                    default: break;
+                }
+            }
+            std::memcpy(ptr, &value, len);
+        }
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+
+    std::uint32_t m_status = 0;
+};
+}} // namespace
@@ -11,29 +11,53 @@
 
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
 #include "systemc"
 
 #include "tlm.h"
 #include "tlm_utils/simple_initiator_socket.h"
 
 #include "CPU.h"
+#include "ExecutionHistory.h"
 #include "Memory.h"
 
 namespace riscv_tlm {
 
     /**
      * @brief GDB Debug connector
-     * 
+     *
+     * Serves the GDB remote protocol on a TCP port and runs the CPU one
+     * instruction at a time (the CPU is created without its own thread).
+     * With a snapshot interval set, reverse-step (bs) and reverse-continue
+     * (bc) are served from an ExecutionHistory: the nearest snapshot is
+     * restored and the program re-executed up to the target instruction.
+     *
      * Note: Debug support for pipelined CPUs is limited.
      * The debugger works best with register access and memory inspection.
      */
     class Debug : sc_core::sc_module {
     public:
+        SC_HAS_PROCESS(Debug);
+
+        static constexpr unsigned short DEFAULT_PORT = 1234;
 
-        Debug(riscv_tlm::CPU *cpu, Memory *mem, cpu_types_t cpu_type);
+        /**
+         * @brief Wait for GDB to connect on @p port
+         */
+        Debug(riscv_tlm::CPU *cpu, Memory *mem, cpu_types_t cpu_type, unsigned short port = DEFAULT_PORT);
 
         ~Debug() override;
 
+        /**
+         * @brief Record for reverse execution, before the simulation starts
+         * @param interval instructions between snapshots (0: no reverse execution)
+         * @param budget bytes of saved RAM pages to keep
+         */
+        void enableReverse(std::uint64_t interval, std::size_t budget);
+
     private:
         static std::string compute_checksum_string(const std::string &msg);
 
@@ -43,17 +67,52 @@ namespace riscv_tlm {
 
         void handle_gdb_loop();
 
+        void end_of_simulation() override;
+
+        /**
+         * @brief One instruction and its interrupt, as CPU_thread() does
+         * @return true if an ebreak was executed
+         */
+        bool step();
+
+        /**
+         * @brief Step until a breakpoint, an ebreak or a Ctrl-C from GDB
+         * @return stop reply
+         */
+        std::string run();
+
+        std::string reverseStep();
+
+        std::string reverseContinue();
+
+        /* restore the nearest snapshot and re-execute up to instruction icount */
+        void replayTo(std::uint64_t icount);
+
+        bool atBreakpoint();
+
+        bool interrupted();
+
+        std::string readRegister(unsigned int n);
+
+        bool writeRegister(unsigned int n, const std::string &hex);
+
+        std::string readMemory(std::uint64_t addr, std::size_t len);
+
+        bool writeMemory(std::uint64_t addr, const std::string &hex);
+
         static constexpr size_t bufsize = 1024 * 8;
         char iobuf[bufsize]{};
+        std::string pending;
         int conn;
         riscv_tlm::CPU *dbg_cpu;
-        Registers<std::uint32_t> *register_bank32;
-        Registers<std::uint64_t> *register_bank64;
         Memory *dbg_mem;
         tlm::tlm_generic_payload dbg_trans;
-        unsigned char pyld_array[128]{};
-        std::unordered_set<uint32_t> breakpoints;
+        std::unordered_set<std::uint64_t> breakpoints;
         riscv_tlm::cpu_types_t cpu_type;
+        unsigned int xlen_bytes;
+        std::uint64_t reverse_interval{0};
+        std::size_t reverse_budget{0};
+        ExecutionHistory *history{nullptr};
     };
 }
 
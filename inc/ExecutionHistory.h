@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file ExecutionHistory.h
+ * @brief Snapshots and input log behind reverse execution in the GDB stub
+ *
+ * While recording, the debugger reports every retired instruction. Every
+ * `interval` instructions the hart state is copied into a snapshot, and each
+ * RAM page is copied the first time it is written after a snapshot (its undo
+ * image). Inputs that re-execution cannot reproduce are logged by instruction
+ * number:
+ *  - values read from the time and cycle CSRs,
+ *  - data read from peripherals, whose writes are dropped on re-execution,
+ *  - the hart state after every interrupt entry.
+ *
+ * seek() restores the latest snapshot at or before an instruction number:
+ * the undo images of that snapshot and all later ones are written back,
+ * newest first, and the hart state is copied. The debugger then re-executes
+ * forward, and the logged inputs are fed back until the newest recorded
+ * instruction (the horizon), where recording resumes. Editing registers or
+ * memory in the past forgets the recorded future.
+ *
+ * DMA transfers and the CLIC state seen through mnxti are not logged.
+ */
+#pragma once
+#ifndef INC_EXECUTIONHISTORY_H_
+#define INC_EXECUTIONHISTORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "tlm.h"
+
+namespace riscv_tlm {
+
+    /**
+     * @brief Architectural state of a hart, as saved by CPU::saveHart()
+     */
+    struct HartState {
+        virtual ~HartState() = default;
+    };
+
+    class ExecutionHistory {
+    public:
+        static constexpr std::size_t PAGE_SIZE = 4096;
+
+        using SaveHart = std::function<std::shared_ptr<const HartState>()>;
+        using RestoreHart = std::function<void(const HartState &)>;
+
+        static ExecutionHistory *getInstance();
+
+        /**
+         * @brief True while recording or re-executing (hooks take the slow path)
+         */
+        static bool active() {
+            return s_mode != Mode::Off;
+        }
+
+        static bool replaying() {
+            return s_mode == Mode::Replay;
+        }
+
+        /**
+         * @brief Start recording from the current instruction
+         * @param ram host address of RAM, which starts at physical address 0
+         * @param interval instructions between snapshots
+         * @param budget bytes of saved RAM pages to keep; the oldest snapshots
+         *        are dropped beyond it
+         */
+        void start(unsigned char *ram, std::size_t size, std::uint64_t interval, std::size_t budget,
+                   SaveHart save, RestoreHart restore);
+
+        /**
+         * @brief Stop recording and forget the history
+         */
+        void stop();
+
+        /**
+         * @brief RAM hook: @p len bytes at @p host are about to be written
+         */
+        static void beforeWrite(const unsigned char *host, std::size_t len) {
+            if (s_mode == Mode::Record) {
+                getInstance()->saveUndo(host, len);
+            }
+        }
+
+        /**
+         * @brief Time and cycle CSR hook
+         * @return @p live while recording, the logged value while re-executing
+         */
+        static std::uint64_t input(std::uint64_t live) {
+            return s_mode == Mode::Off ? live : getInstance()->logInput(live);
+        }
+
+        /**
+         * @brief Peripheral hook before the access
+         * @return true if the access was served from the log (reads) or
+         *         dropped (writes) and must not reach the peripheral
+         */
+        bool replayAccess(tlm::tlm_generic_payload &trans);
+
+        /**
+         * @brief Peripheral hook after the access, logs the data read
+         */
+        void recordAccess(const tlm::tlm_generic_payload &trans);
+
+        /**
+         * @brief Debugger hook after every instruction
+         * @param interrupt the debugger took an interrupt after it (recording only)
+         */
+        void retired(bool interrupt);
+
+        /**
+         * @brief Restore the latest snapshot at or before instruction @p icount
+         *
+         * Does nothing if @p icount is not in the past.
+         * @return the instruction number restored; the caller steps forward from it
+         */
+        std::uint64_t seek(std::uint64_t icount);
+
+        /**
+         * @brief Latest snapshot strictly before instruction @p icount, if any
+         */
+        bool snapshotBefore(std::uint64_t icount, std::uint64_t &snapshot) const;
+
+        /**
+         * @brief Edit registers or memory through @p apply
+         *
+         * The recorded future is forgotten and a snapshot is taken after the
+         * edit, so that later re-execution starts from the edited state.
+         */
+        void edit(const std::function<void()> &apply);
+
+        /**
+         * @brief Instructions stepped since start(), counting re-executed ones once
+         */
+        std::uint64_t position() const {
+            return m_now;
+        }
+
+        std::uint64_t oldest() const;
+
+        std::uint64_t horizon() const {
+            return m_horizon;
+        }
+
+    private:
+        enum class Mode {
+            Off, Record, Replay
+        };
+
+        struct Snapshot {
+            std::uint64_t icount;
+            std::uint64_t serial;       ///< never reused, marks pages saved in this epoch
+            std::shared_ptr<const HartState> hart;
+            std::vector<std::pair<std::size_t, std::vector<std::uint8_t>>> undo;
+        };
+
+        struct Input {
+            std::uint64_t icount;
+            std::uint64_t value;
+        };
+
+        ExecutionHistory() = default;
+
+        void saveUndo(const unsigned char *host, std::size_t len);
+
+        std::uint64_t logInput(std::uint64_t live);
+
+        void takeSnapshot();
+
+        void trim();
+
+        /* forget everything after the present, which becomes the horizon */
+        void truncate();
+
+        /* re-execution left the recorded path */
+        void lost(const char *what);
+
+        static Mode s_mode;
+
+        unsigned char *m_ram{nullptr};
+        std::size_t m_size{0};
+        std::uint64_t m_interval{0};
+        std::size_t m_budget{0};
+        std::size_t m_bytes{0};
+        std::uint64_t m_now{0};
+        std::uint64_t m_horizon{0};
+        std::uint64_t m_serial{0};
+        SaveHart m_save;
+        RestoreHart m_restore;
+
+        std::deque<Snapshot> m_snapshots;
+        std::vector<std::uint64_t> m_page_serial;       ///< serial of the epoch that saved the page
+        std::map<std::uint64_t, std::shared_ptr<const HartState>> m_interrupts;
+        std::deque<Input> m_inputs;
+        std::size_t m_cursor{0};                         ///< next input to feed back
+
+    public:
+        /**
+         * @brief Accesses made by the debugger in this scope are neither
+         *        logged nor served from the log
+         */
+        class Untracked {
+        public:
+            Untracked() : m_saved(s_mode) {
+                s_mode = Mode::Off;
+            }
+
+            ~Untracked() {
+                s_mode = m_saved;
+            }
+
+            Untracked(const Untracked &) = delete;
+            Untracked &operator=(const Untracked &) = delete;
+
+        private:
+            Mode m_saved;
+        };
+    };
+}
+
+#endif /* INC_EXECUTIONHISTORY_H_ */
@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file ExtensionDispatch.h
+ * @brief Decode cascade over the ISA extensions of the interpreting CPU models
+ *
+ * The extension decoders are tried in a fixed order,
+ * BASE -> C -> M -> V -> F/D -> B -> K -> A,
+ * and the first that recognises the instruction executes it. V comes
+ * before A because the A decoder only checks funct5. Every model outside
+ * the 6-stage pipelines calls dispatchExtensions() after the custom
+ * instruction hook (CPU::execCustom) and applies its own timing to the
+ * result, so a new extension is one line in the cascade below.
+ */
+#pragma once
+#ifndef EXTENSION_DISPATCH_H
+#define EXTENSION_DISPATCH_H
+
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+#include "A_extension.h"
+#include "B_extension.h"
+#include "BASE_ISA.h"
+#include "C_extension.h"
+#include "F_extension.h"
+#include "Instruction.h"
+#include "K_extension.h"
+#include "M_extension.h"
+#include "SelfProfile.h"
+#include "V_extension.h"
+
+namespace riscv_tlm {
+
+/**
+ * @brief Extension decoders of a hart (owned by the CPU model)
+ */
+template<typename T>
+struct IsaExtensions {
+    BASE_ISA<T> *base{nullptr};
+    C_extension<T> *c{nullptr};
+    M_extension<T> *m{nullptr};
+    A_extension<T> *a{nullptr};
+    V_extension<T> *v{nullptr};
+    F_extension<T> *f{nullptr};
+    B_extension<T> *b{nullptr};
+    K_extension<T> *k{nullptr};
+
+    /**
+     * @brief misa extension bits of the decoders present (Zk* has no misa bit)
+     */
+    std::uint32_t misa() const {
+        std::uint32_t bits = MISA_I_BASE;
+        bits |= c != nullptr ? MISA_C_EXTENSION : 0;
+        bits |= m != nullptr ? MISA_M_EXTENSION : 0;
+        bits |= a != nullptr ? MISA_A_EXTENSION : 0;
+        bits |= v != nullptr ? MISA_V_EXTENSION : 0;
+        bits |= f != nullptr ? MISA_F_EXTENSION | MISA_D_EXTENSION : 0;
+        bits |= b != nullptr ? MISA_B_EXTENSION : 0;
+        return bits;
+    }
+};
+
+enum class ExtensionUnit : std::uint8_t {
+    Base, C, M, A, V, F, B, K,
+    None        ///< no decoder recognised the instruction
+};
+
+/**
+ * @brief What the executed instruction means for the model's timing
+ */
+struct ExtensionStep {
+    ExtensionUnit unit{ExtensionUnit::None};
+    bool pc_changed{false};     ///< the instruction wrote the PC
+    bool control_flow{false};   ///< the fetched successor is dropped when pc_changed
+    unsigned int cycles{1};     ///< EX cycles (vector instructions)
+};
+
+namespace detail {
+    /**
+     * @brief Decode @p instr with @p ext and execute it if it is one of its opcodes
+     */
+    template<typename Ext, typename Op, typename... Args>
+    inline bool tryExtension(Ext *ext, Op error, std::uint32_t instr, bool &pc_changed, Op &op, Args &&...args) {
+        ext->setInstr(instr);
+        op = RVVP_PROFILE_EXPR(Decode, ext->decode());
+        if (op == error) {
+            return false;
+        }
+        pc_changed = !RVVP_PROFILE_EXPR(Execute, ext->exec_instruction(std::forward<Args>(args)..., op));
+        return true;
+    }
+
+    /**
+     * @brief tryExtension() for an extension that only writes the PC when it traps
+     */
+    template<typename Ext, typename Op>
+    inline bool tryExtension(Ext *ext, Op error, ExtensionUnit unit, std::uint32_t instr, Instruction &inst,
+                             ExtensionStep &step) {
+        Op op;
+        if (!tryExtension(ext, error, instr, step.pc_changed, op, inst)) {
+            return false;
+        }
+        step.unit = unit;
+        return true;
+    }
+}
+
+/**
+ * @brief Decode and execute a standard instruction
+ *
+ * Jumps and taken branches of BASE and C are control flow; any other
+ * extension only writes the PC when it traps, which redirects the fetch
+ * just the same. An instruction no extension decodes is reported and
+ * executed as a NOP.
+ * @param breakpoint set by EBREAK
+ */
+template<typename T>
+ExtensionStep dispatchExtensions(const IsaExtensions<T> &isa, Instruction &inst, std::uint32_t instr,
+                                 bool *breakpoint) {
+    ExtensionStep step;
+
+    opCodes base_op;
+    if (detail::tryExtension(isa.base, OP_ERROR, instr, step.pc_changed, base_op, inst, breakpoint)) {
+        const std::uint32_t opcode = instr & 0x7F;
+        step.unit = ExtensionUnit::Base;
+        step.control_flow = (opcode == 0x63 || opcode == 0x6F || opcode == 0x67);
+        return step;
+    }
+
+    op_C_Codes c_op;
+    if (detail::tryExtension(isa.c, OP_C_ERROR, instr, step.pc_changed, c_op, inst, breakpoint)) {
+        step.unit = ExtensionUnit::C;
+        step.control_flow = C_extension<T>::isControlFlow(c_op);
+        return step;
+    }
+
+    if (detail::tryExtension(isa.m, OP_M_ERROR, ExtensionUnit::M, instr, inst, step)
+        || detail::tryExtension(isa.v, OP_V_ERROR, ExtensionUnit::V, instr, inst, step)
+        || detail::tryExtension(isa.f, OP_F_ERROR, ExtensionUnit::F, instr, inst, step)
+        || detail::tryExtension(isa.b, OP_B_ERROR, ExtensionUnit::B, instr, inst, step)
+        || detail::tryExtension(isa.k, OP_K_ERROR, ExtensionUnit::K, instr, inst, step)
+        || detail::tryExtension(isa.a, OP_A_ERROR, ExtensionUnit::A, instr, inst, step)) {
+        step.control_flow = step.pc_changed;
+        if (step.unit == ExtensionUnit::V) {
+            step.cycles = isa.v->lastCycles();
+        }
+        return step;
+    }
+
+    std::cout << "Extension not implemented yet" << std::endl;
+    inst.dump();
+    isa.base->NOP();
+    return step;
+}
+
+} // namespace riscv_tlm
+
+#endif // EXTENSION_DISPATCH_H
@@ -0,0 +1,425 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file F_extension.h
+ * @brief Implement F and D extensions part of the RISC-V
+ *
+ * Single and double precision loads/stores, arithmetic, fused multiply-add,
+ * conversions, moves, compares and classify for RV32 and RV64. FLEN is 64:
+ * single precision values are NaN-boxed in the FP registers. Arithmetic is
+ * executed by HostFPU on the host floating-point unit.
+ *
+ * Any FP instruction raises an illegal instruction exception while
+ * mstatus.FS is Off; writes to FP registers or fflags set FS to Dirty.
+ */
+#pragma once
+#ifndef F_EXTENSION__H
+#define F_EXTENSION__H
+
+#include "systemc"
+#include <cstdint>
+
+#include "extension_base.h"
+#include "HostFPU.h"
+#include "Instruction.h"
+#include "Registers.h"
+
+namespace riscv_tlm {
+
+    typedef enum {
+        OP_F_FLW,
+        OP_F_FLD,
+        OP_F_FSW,
+        OP_F_FSD,
+        OP_F_FMADD,
+        OP_F_FMSUB,
+        OP_F_FNMSUB,
+        OP_F_FNMADD,
+        OP_F_FADD,
+        OP_F_FSUB,
+        OP_F_FMUL,
+        OP_F_FDIV,
+        OP_F_FSQRT,
+        OP_F_FSGNJ,
+        OP_F_FMINMAX,
+        OP_F_FCVT_FMT,
+        OP_F_FCMP,
+        OP_F_FCVT_INT,
+        OP_F_FCVT_FP,
+        OP_F_FMV_X,
+        OP_F_FCLASS,
+        OP_F_FMV_F,
+        OP_F_ERROR
+    } op_F_Codes;
+
+    typedef enum {
+        F_LOAD_FP = 0b0000111,
+        F_STORE_FP = 0b0100111,
+        F_MADD = 0b1000011,
+        F_MSUB = 0b1000111,
+        F_NMSUB = 0b1001011,
+        F_NMADD = 0b1001111,
+        F_OP_FP = 0b1010011,
+    } F_Codes;
+
+    /** funct5 of OP-FP */
+    typedef enum {
+        F5_FADD = 0b00000,
+        F5_FSUB = 0b00001,
+        F5_FMUL = 0b00010,
+        F5_FDIV = 0b00011,
+        F5_FSGNJ = 0b00100,
+        F5_FMINMAX = 0b00101,
+        F5_FCVT_FMT = 0b01000,
+        F5_FSQRT = 0b01011,
+        F5_FCMP = 0b10100,
+        F5_FCVT_INT = 0b11000,
+        F5_FCVT_FP = 0b11010,
+        F5_FMV_X = 0b11100,
+        F5_FMV_F = 0b11110,
+    } F_Funct5;
+
+    /** fmt field */
+    typedef enum {
+        F_FMT_S = 0b00,
+        F_FMT_D = 0b01,
+    } F_Fmt;
+
+/**
+ * @brief Instruction decoding and fields access
+ */
+    template<typename T>
+    class F_extension : public extension_base<T> {
+    public:
+
+        /**
+         * @brief Constructor, same as base class
+         */
+        using extension_base<T>::extension_base;
+
+        using signed_T = typename std::make_signed<T>::type;
+        using unsigned_T = typename std::make_unsigned<T>::type;
+
+        /**
+         * @brief Access to opcode field
+         * @return return opcode field
+         */
+        inline unsigned_T opcode() const override {
+            return static_cast<unsigned_T>(this->m_instr.range(6, 0));
+        }
+
+        inline unsigned int get_rs3() const {
+            return this->m_instr.range(31, 27);
+        }
+
+        inline unsigned int get_funct5() const {
+            return this->m_instr.range(31, 27);
+        }
+
+        inline unsigned int get_fmt() const {
+            return this->m_instr.range(26, 25);
+        }
+
+        inline signed_T get_imm_I() const {
+            auto imm = static_cast<std::int32_t>(this->m_instr.range(31, 20));
+            return static_cast<signed_T>(imm >= 2048 ? imm - 4096 : imm);
+        }
+
+        inline signed_T get_imm_S() const {
+            auto imm = static_cast<std::int32_t>((this->m_instr.range(31, 25) << 5)
+                                                 | this->m_instr.range(11, 7));
+            return static_cast<signed_T>(imm >= 2048 ? imm - 4096 : imm);
+        }
+
+        /**
+         * @brief Decodes opcode of instruction
+         * @return opcode of instruction
+         */
+        op_F_Codes decode() const {
+            constexpr bool rv64 = sizeof(T) == 8;
+
+            switch (opcode()) {
+                case F_LOAD_FP:
+                case F_STORE_FP:
+                    /* the other widths are vector loads/stores */
+                    switch (this->get_funct3()) {
+                        case 0b010:
+                            return opcode() == F_LOAD_FP ? OP_F_FLW : OP_F_FSW;
+                        case 0b011:
+                            return opcode() == F_LOAD_FP ? OP_F_FLD : OP_F_FSD;
+                        default:
+                            return OP_F_ERROR;
+                    }
+                case F_MADD:
+                case F_MSUB:
+                case F_NMSUB:
+                case F_NMADD:
+                    if (get_fmt() > F_FMT_D) {
+                        return OP_F_ERROR;
+                    }
+                    return opcode() == F_MADD ? OP_F_FMADD
+                         : opcode() == F_MSUB ? OP_F_FMSUB
+                         : opcode() == F_NMSUB ? OP_F_FNMSUB : OP_F_FNMADD;
+                case F_OP_FP:
+                    break;
+                default:
+                    return OP_F_ERROR;
+            }
+
+            unsigned int fmt = get_fmt();
+            unsigned int rs2 = this->get_rs2();
+            unsigned int funct3 = this->get_funct3();
+
+            if (fmt > F_FMT_D) {
+                return OP_F_ERROR;
+            }
+
+            switch (get_funct5()) {
+                case F5_FADD:
+                    return OP_F_FADD;
+                case F5_FSUB:
+                    return OP_F_FSUB;
+                case F5_FMUL:
+                    return OP_F_FMUL;
+                case F5_FDIV:
+                    return OP_F_FDIV;
+                case F5_FSQRT:
+                    return rs2 == 0 ? OP_F_FSQRT : OP_F_ERROR;
+                case F5_FSGNJ:
+                    return funct3 <= 2 ? OP_F_FSGNJ : OP_F_ERROR;
+                case F5_FMINMAX:
+                    return funct3 <= 1 ? OP_F_FMINMAX : OP_F_ERROR;
+                case F5_FCVT_FMT:
+                    /* fcvt.s.d or fcvt.d.s */
+                    return rs2 == (fmt == F_FMT_S ? 1u : 0u) ? OP_F_FCVT_FMT : OP_F_ERROR;
+                case F5_FCMP:
+                    return funct3 <= 2 ? OP_F_FCMP : OP_F_ERROR;
+                case F5_FCVT_INT:
+                    return (rs2 <= 1 || (rv64 && rs2 <= 3)) ? OP_F_FCVT_INT : OP_F_ERROR;
+                case F5_FCVT_FP:
+                    return (rs2 <= 1 || (rv64 && rs2 <= 3)) ? OP_F_FCVT_FP : OP_F_ERROR;
+                case F5_FMV_X:
+                    if (rs2 != 0) {
+                        return OP_F_ERROR;
+                    } else if (funct3 == 1) {
+                        return OP_F_FCLASS;
+                    } else if (funct3 == 0 && (fmt == F_FMT_S || rv64)) {
+                        return OP_F_FMV_X;
+                    }
+                    return OP_F_ERROR;
+                case F5_FMV_F:
+                    return (rs2 == 0 && funct3 == 0 && (fmt == F_FMT_S || rv64)) ? OP_F_FMV_F
+                                                                                  : OP_F_ERROR;
+                default:
+                    return OP_F_ERROR;
+            }
+        }
+
+        bool exec_instruction(Instruction &inst, op_F_Codes code) {
+            bool ok;
+
+            this->setInstr(inst.getInstr());
+
+            if (!this->regs->isFPEnabled()) {
+                ok = false;
+            } else if (get_fmt() == F_FMT_D && code != OP_F_FLW && code != OP_F_FSW
+                       && code != OP_F_FLD && code != OP_F_FSD) {
+                ok = exec<double>(code);
+            } else {
+                ok = exec<float>(code);
+            }
+
+            if (!ok) {
+                this->logger->debug("{} ps. PC: 0x{:x}. F: illegal instruction 0x{:x}",
+                                    sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                    static_cast<std::uint32_t>(this->m_instr));
+                this->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, this->m_instr);
+                return false;
+            }
+
+            this->logger->debug("{} ps. PC: 0x{:x}. F: 0x{:x} fcsr 0x{:x}",
+                                sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                static_cast<std::uint32_t>(this->m_instr),
+                                this->regs->getCSR(CSR_FCSR));
+            return true;
+        }
+
+    private:
+
+        /* --- FP register access ----------------------------------------------- */
+
+        template<typename F>
+        typename HostFPU<F>::Bits readF(unsigned int reg) const {
+            std::uint64_t value = this->regs->getFPValue(reg);
+
+            if constexpr (sizeof(F) == 4) {
+                /* a single precision operand that is not NaN-boxed reads as canonical NaN */
+                return (value >> 32) == 0xFFFFFFFF ? static_cast<std::uint32_t>(value)
+                                                   : HostFPU<float>::CANONICAL_NAN;
+            } else {
+                return value;
+            }
+        }
+
+        template<typename F>
+        void writeF(unsigned int reg, typename HostFPU<F>::Bits value) {
+            if constexpr (sizeof(F) == 4) {
+                this->regs->setFPValue(reg, 0xFFFFFFFF00000000ULL | value);
+            } else {
+                this->regs->setFPValue(reg, value);
+            }
+        }
+
+        /**
+         * @brief Effective rounding mode (rm field, or frm if dynamic)
+         * @return false for reserved encodings
+         */
+        bool roundingMode(unsigned int &rm) {
+            rm = this->get_funct3();
+            if (rm == FRM_DYN) {
+                rm = this->regs->getFRM();
+            }
+            return rm <= FRM_RMM;
+        }
+
+        template<typename F>
+        bool exec(op_F_Codes code) {
+            using Bits = typename HostFPU<F>::Bits;
+            constexpr Bits SIGN = Bits(1) << (sizeof(F) * 8 - 1);
+
+            unsigned int rd = this->get_rd();
+            unsigned int rs1 = this->get_rs1();
+            unsigned int rs2 = this->get_rs2();
+            unsigned int flags = 0;
+            unsigned int rm = FRM_RNE;
+
+            switch (code) {
+                case OP_F_FLW:
+                case OP_F_FLD: {
+                    T addr = this->regs->getValue(rs1) + get_imm_I();
+                    if (code == OP_F_FLW) {
+                        writeF<float>(rd, this->mem_intf->readDataMem(addr, 4));
+                    } else {
+                        writeF<double>(rd, this->mem_intf->readDataMem64(addr, 8));
+                    }
+                    this->perf->dataMemoryRead();
+                    return true;
+                }
+                case OP_F_FSW:
+                case OP_F_FSD: {
+                    /* stores move the raw bits, NaN-boxed or not */
+                    T addr = this->regs->getValue(rs1) + get_imm_S();
+                    std::uint64_t value = this->regs->getFPValue(rs2);
+                    if (code == OP_F_FSW) {
+                        this->mem_intf->writeDataMem(addr, static_cast<std::uint32_t>(value), 4);
+                    } else {
+                        this->mem_intf->writeDataMem64(addr, value, 8);
+                    }
+                    this->perf->dataMemoryWrite();
+                    return true;
+                }
+                case OP_F_FMADD:
+                case OP_F_FMSUB:
+                case OP_F_FNMSUB:
+                case OP_F_FNMADD:
+                    if (!roundingMode(rm)) {
+                        return false;
+                    }
+                    writeF<F>(rd, HostFPU<F>::fma(readF<F>(rs1), readF<F>(rs2), readF<F>(get_rs3()),
+                                                  code == OP_F_FNMSUB || code == OP_F_FNMADD,
+                                                  code == OP_F_FMSUB || code == OP_F_FNMADD,
+                                                  rm, flags));
+                    break;
+                case OP_F_FADD:
+                case OP_F_FSUB:
+                case OP_F_FMUL:
+                case OP_F_FDIV:
+                case OP_F_FSQRT: {
+                    if (!roundingMode(rm)) {
+                        return false;
+                    }
+                    FPArith op = code == OP_F_FADD ? FPArith::Add
+                               : code == OP_F_FSUB ? FPArith::Sub
+                               : code == OP_F_FMUL ? FPArith::Mul
+                               : code == OP_F_FDIV ? FPArith::Div : FPArith::Sqrt;
+                    writeF<F>(rd, HostFPU<F>::arith(op, readF<F>(rs1), readF<F>(rs2), rm, flags));
+                    break;
+                }
+                case OP_F_FMINMAX:
+                    writeF<F>(rd, HostFPU<F>::arith(this->get_funct3() == 0 ? FPArith::Min : FPArith::Max,
+                                                    readF<F>(rs1), readF<F>(rs2), rm, flags));
+                    break;
+                case OP_F_FSGNJ: {
+                    Bits a = readF<F>(rs1);
+                    Bits b = readF<F>(rs2);
+                    switch (this->get_funct3()) {
+                        case 0:
+                            b &= SIGN;
+                            break;
+                        case 1:
+                            b = ~b & SIGN;
+                            break;
+                        default:
+                            b = (a ^ b) & SIGN;
+                            break;
+                    }
+                    writeF<F>(rd, (a & ~SIGN) | b);
+                    break;
+                }
+                case OP_F_FCVT_FMT:
+                    if (!roundingMode(rm)) {
+                        return false;
+                    }
+                    if constexpr (sizeof(F) == 4) {
+                        writeF<float>(rd, fpNarrow(readF<double>(rs1), rm, flags));
+                    } else {
+                        writeF<double>(rd, fpWiden(readF<float>(rs1), flags));
+                    }
+                    break;
+                case OP_F_FCMP: {
+                    unsigned int funct3 = this->get_funct3();
+                    FPCompare op = funct3 == 2 ? FPCompare::Eq
+                                 : funct3 == 1 ? FPCompare::Lt : FPCompare::Le;
+                    this->regs->setValue(rd, HostFPU<F>::compare(op, readF<F>(rs1), readF<F>(rs2), flags) ? 1 : 0);
+                    break;
+                }
+                case OP_F_FCVT_INT:
+                    /* rs2: 0 W, 1 WU, 2 L, 3 LU */
+                    if (!roundingMode(rm)) {
+                        return false;
+                    }
+                    this->regs->setValue(rd, static_cast<T>(HostFPU<F>::toInt(readF<F>(rs1), (rs2 & 1) == 0,
+                                                                              (rs2 & 2) ? 64 : 32, rm, flags)));
+                    break;
+                case OP_F_FCVT_FP:
+                    if (!roundingMode(rm)) {
+                        return false;
+                    }
+                    writeF<F>(rd, HostFPU<F>::fromInt(static_cast<std::uint64_t>(this->regs->getValue(rs1)),
+                                                      (rs2 & 1) == 0, (rs2 & 2) ? 64 : 32, rm, flags));
+                    break;
+                case OP_F_FMV_X:
+                    /* raw bits, single precision sign-extended to XLEN */
+                    if constexpr (sizeof(F) == 4) {
+                        auto value = static_cast<std::int32_t>(this->regs->getFPValue(rs1));
+                        this->regs->setValue(rd, static_cast<T>(static_cast<signed_T>(value)));
+                    } else {
+                        this->regs->setValue(rd, static_cast<T>(this->regs->getFPValue(rs1)));
+                    }
+                    break;
+                case OP_F_FCLASS:
+                    this->regs->setValue(rd, HostFPU<F>::classify(readF<F>(rs1)));
+                    break;
+                case OP_F_FMV_F:
+                    writeF<F>(rd, static_cast<Bits>(this->regs->getValue(rs1)));
+                    break;
+                default:
+                    return false;
+            }
+
+            this->regs->accrueFPFlags(flags);
+            return true;
+        }
+    };
+}
+
+#endif
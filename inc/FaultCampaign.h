@@ -0,0 +1,261 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file FaultCampaign.h
+ * @brief Fault-injection campaigns: bit flips from a golden checkpoint, in parallel
+ *
+ * A campaign first runs the program once without faults (the golden run),
+ * and every `interval` instructions it records a digest of the state:
+ * integer, FP and trap CSRs, pc, simulated time, RAM, and a hash of
+ * everything written to peripherals. RAM is hashed incrementally: each page
+ * is hashed when first written and again at the next boundary, so the
+ * digest costs the pages written since the previous one.
+ *
+ * It then runs the program again and pauses at each injection point, an
+ * instruction or cycle count (RunControl instr= / cycle=). There it forks
+ * one process per fault planned at that point. The child flips one or more
+ * bits in a GPR, a CSR, a RAM word or a pipeline latch of the cycle models
+ * (CPU::visitLatches) and runs on. The fork is the checkpoint restore: the
+ * child shares all pages with the paused parent until it writes them.
+ *
+ * A child ends as soon as its digest equals the golden one at the same
+ * boundary (masked), or at the end of the program, where it is classified:
+ *  - hang:   it ran past `hang` times the golden instruction count, or the
+ *            wall-clock timeout;
+ *  - crash:  it took more exceptions than the golden run, stopped at another
+ *            pc, or the simulator itself died;
+ *  - SDC:    it wrote something else to the peripherals (silent data corruption);
+ *  - masked: otherwise.
+ */
+#pragma once
+#ifndef INC_FAULTCAMPAIGN_H_
+#define INC_FAULTCAMPAIGN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "tlm.h"
+
+namespace riscv_tlm {
+
+    class CPU;
+
+    class Memory;
+
+    /**
+     * @brief Pipeline latch fields a cycle model exposes to latch faults
+     */
+    class LatchMap {
+    public:
+        /**
+         * @brief Add a latch field; @p bits is how many of its low bits hold state
+         */
+        template<typename T>
+        void add(const std::string &name, T &field, unsigned int bits = 8 * sizeof(T)) {
+            static_assert(std::is_integral<T>::value, "latch fields are integers");
+            m_fields.push_back({name, reinterpret_cast<unsigned char *>(&field),
+                                std::is_same<T, bool>::value ? 1u : bits});
+            m_bits += m_fields.back().bits;
+        }
+
+        std::size_t bits() const {
+            return m_bits;
+        }
+
+        /**
+         * @brief Field holding bit @p bit of the map, and the bit within it
+         */
+        std::size_t locate(std::size_t bit, unsigned int &offset) const;
+
+        unsigned int fieldBits(std::size_t field) const {
+            return m_fields[field].bits;
+        }
+
+        const std::string &fieldName(std::size_t field) const {
+            return m_fields[field].name;
+        }
+
+        void flip(std::size_t field, unsigned int offset) {
+            m_fields[field].data[offset / 8] ^= static_cast<unsigned char>(1u << (offset % 8));
+        }
+
+    private:
+        struct Field {
+            std::string name;
+            unsigned char *data;        ///< little-endian host
+            unsigned int bits;
+        };
+
+        std::vector<Field> m_fields;
+        std::size_t m_bits{0};
+    };
+
+    class FaultCampaign {
+    public:
+        enum class Target {
+            GPR, CSR, Memory, Latch
+        };
+
+        enum class Outcome {
+            Masked, SDC, Crash, Hang
+        };
+
+        struct Options {
+            Target target{Target::GPR};
+            std::uint64_t count{1000};      ///< injections
+            unsigned int bits{1};           ///< bits flipped per injection, in one register, word or field
+            bool cycles{false};             ///< the window counts cycles instead of instructions
+            std::uint64_t from{1};          ///< injection window, inclusive; 0 = end of the golden run
+            std::uint64_t to{0};
+            std::uint64_t mem_start{0};     ///< RAM range for memory faults; empty = image and written pages
+            std::uint64_t mem_end{0};
+            std::uint64_t seed{1};
+            unsigned int jobs{0};           ///< processes at a time; 0 = host threads
+            std::uint64_t interval{10000};  ///< instructions between digests
+            double hang{2.0};               ///< of the golden instruction count
+            double timeout{0};              ///< wall-clock seconds per injection; 0 = 10 x the golden run
+            std::uint64_t max_instructions{0};  ///< end of every run (--max-instr), 0 = the program ends
+            std::string report;             ///< CSV file with one line per injection
+        };
+
+        static FaultCampaign *getInstance();
+
+        /**
+         * @brief Parse "target=gpr,count=10000,bits=2,window=1000:50000,..." into @p options
+         * @return false with @p error set on a malformed spec
+         */
+        static bool parse(const std::string &spec, Options &options, std::string &error);
+
+        /**
+         * @brief True while digests are kept (golden run and injections)
+         */
+        static bool tracking() {
+            return s_tracking;
+        }
+
+        /**
+         * @brief RAM hook: @p len bytes at @p host are about to be written
+         */
+        static void beforeWrite(const unsigned char *host, std::size_t len) {
+            if (s_tracking) {
+                getInstance()->markDirty(host, len);
+            }
+        }
+
+        /**
+         * @brief Peripheral hook: a write the program makes visible outside the hart
+         */
+        static void observe(const tlm::tlm_generic_payload &trans) {
+            if (s_tracking && trans.is_write()) {
+                getInstance()->observeWrite(trans);
+            }
+        }
+
+        /**
+         * @brief Exception hook (not interrupts)
+         */
+        static void exception(std::uint64_t cause) {
+            if (s_tracking && cause != 8 && cause != 9 && cause != 11) {    // environment calls
+                getInstance()->m_exceptions++;
+            }
+        }
+
+        /**
+         * @brief Run the campaign on the elaborated platform; sc_start() must not have been called
+         * @param xlen 32 or 64
+         * @return process exit status
+         */
+        int run(const Options &options, CPU *cpu, Memory *memory, unsigned int xlen);
+
+        static const char *outcomeName(Outcome outcome);
+
+    private:
+        static constexpr std::size_t PAGE_SIZE = 4096;
+        static constexpr std::uint64_t DRAIN = 64;     ///< instructions after a fault before digests count
+
+        struct Fault {
+            std::uint64_t at;           ///< instruction or cycle
+            std::uint64_t where;        ///< register, CSR, byte address or latch field
+            std::vector<unsigned int> bits;
+            std::string site;           ///< for the report
+        };
+
+        /** What a child sends back */
+        struct Record {
+            std::uint32_t index;
+            std::uint8_t outcome;
+            std::uint8_t early;         ///< ended at a boundary where it matched the golden run
+            std::uint16_t pad;
+            std::uint64_t instructions; ///< when it ended
+        };
+
+        /** The golden run as the injections compare against it */
+        struct Golden {
+            std::vector<std::uint64_t> digests;     ///< at instruction (i + 1) * interval
+            std::uint64_t instructions{0};
+            std::uint64_t cycles{0};
+            std::uint64_t pc{0};
+            std::uint64_t exceptions{0};
+            std::uint64_t output{0};
+            std::vector<std::uint64_t> written;     ///< pages written
+            double seconds{0};
+        };
+
+        FaultCampaign() = default;
+
+        void markDirty(const unsigned char *host, std::size_t len);
+
+        void observeWrite(const tlm::tlm_generic_payload &trans);
+
+        /**
+         * @brief Digest of the state, after folding the pages written since the last one
+         */
+        std::uint64_t digest();
+
+        /**
+         * @brief Run until the next pause, stop or the end of activity
+         * @return true if a run-control pause fired
+         */
+        static bool advance();
+
+        /**
+         * @brief Pause at instruction (or cycle) @p at, with a stop at @p limit if not 0
+         */
+        static void arm(std::uint64_t at, bool cycles, std::uint64_t limit);
+
+        bool runGolden(Golden &golden, std::string &error);
+
+        std::vector<Fault> plan(const Golden &golden, std::string &error);
+
+        /**
+         * @brief In the child: flip the bits of @p fault, run, and report on @p fd
+         */
+        [[noreturn]] void inject(std::uint32_t index, const Fault &fault, const Golden &golden, int fd);
+
+        Outcome classify(const Golden &golden, bool hang_limit);
+
+        static std::uint64_t hashPage(const unsigned char *page);
+
+        static bool s_tracking;
+
+        Options m_options;
+        CPU *m_cpu{nullptr};
+        Memory *m_memory{nullptr};
+        unsigned int m_xlen{32};
+        LatchMap m_latches;
+
+        unsigned char *m_ram{nullptr};
+        std::size_t m_pages{0};
+        std::vector<std::uint64_t> m_page_hash;     ///< at the last digest, or before the first write
+        std::vector<std::uint8_t> m_page_state;     ///< 0 untouched, 1 hashed, 2 dirty since the last digest
+        std::vector<std::size_t> m_dirty;
+        std::uint64_t m_ram_sum{0};                 ///< sum of page terms, 0 when RAM is as loaded
+        std::uint64_t m_output{0xcbf29ce484222325ULL};
+        std::uint64_t m_exceptions{0};
+    };
+}
+
+#endif /* INC_FAULTCAMPAIGN_H_ */
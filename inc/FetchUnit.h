@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file FetchUnit.h
+ * @brief Fetch-block front end with an instruction byte queue and RVC realignment
+ *
+ * Each cycle the front end reads one naturally aligned block of
+ * FETCH_BLOCK_BYTES (only the part from the fetch PC on after a redirect) into
+ * a byte queue of FETCH_QUEUE_BYTES, if the whole block fits. Decode takes
+ * instructions from the head of the queue: a 16-bit parcel whose low bits are
+ * not 0b11 is a compressed instruction, anything else needs four bytes, so a
+ * 32-bit instruction that straddles two blocks waits for the second one.
+ * Bytes fetched in a cycle are available to decode in the next one.
+ *
+ * Compressed instructions are handed to decode expanded to their 32-bit
+ * equivalent, together with their length for the link address. One that
+ * has none (illegal, or a Zcmp/Zcmt sequence) is handed over as its 16-bit
+ * parcel, which no 32-bit opcode matches. Decode rejects an illegal one; a
+ * Zcmp/Zcmt instruction is issued as the micro-ops crack() and
+ * tableJumpIndex() describe.
+ */
+#pragma once
+#ifndef INC_FETCHUNIT_H_
+#define INC_FETCHUNIT_H_
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#ifndef FETCH_BLOCK_BYTES
+#define FETCH_BLOCK_BYTES 8
+#endif
+
+#ifndef FETCH_QUEUE_BYTES
+#define FETCH_QUEUE_BYTES 16
+#endif
+
+namespace riscv_tlm {
+
+    class FetchUnit {
+    public:
+        /**
+         * @brief Reads @p len instruction bytes at @p addr, false on a bus error
+         */
+        using ReadBlock = std::function<bool(std::uint64_t addr, std::uint8_t *dst, unsigned int len)>;
+
+        /**
+         * @brief One instruction as delivered to decode
+         */
+        struct Slot {
+            std::uint64_t pc{0};
+            std::uint32_t instr{0};     ///< 32-bit encoding, compressed ones expanded (or their parcel)
+            std::uint8_t length{4};     ///< 2 or 4 bytes
+            std::uint32_t encoding{0};  ///< as fetched (the parcel of a compressed one), for the plugin hooks
+        };
+
+        struct Stats {
+            std::uint64_t blocks{0};            ///< fetch blocks read
+            std::uint64_t bytes{0};             ///< bytes read
+            std::uint64_t compressed{0};        ///< 16-bit instructions delivered
+            std::uint64_t uncompressed{0};      ///< 32-bit instructions delivered
+            std::uint64_t straddles{0};         ///< 32-bit instructions split across two blocks
+            std::uint64_t empty_bubbles{0};     ///< decode found the queue empty
+            std::uint64_t straddle_bubbles{0};  ///< decode found half of a 32-bit instruction
+            std::uint64_t full_cycles{0};       ///< no room for the next block
+            std::uint64_t redirects{0};
+            std::uint64_t discarded_bytes{0};   ///< queued bytes dropped by redirects
+        };
+
+        /**
+         * @param pc first fetch address
+         * @param block_bytes fetch block size, a power of two from 4 to 64
+         * @param queue_bytes queue capacity, at least one block
+         */
+        FetchUnit(ReadBlock read, bool rv64, std::uint64_t pc,
+                  unsigned int block_bytes = FETCH_BLOCK_BYTES,
+                  unsigned int queue_bytes = FETCH_QUEUE_BYTES);
+
+        /**
+         * @brief Drop the queued bytes and continue fetching at @p pc
+         */
+        void redirect(std::uint64_t pc);
+
+        /**
+         * @brief Front-end cycle: read the next block if it fits in the queue
+         */
+        void cycle();
+
+        /**
+         * @brief Instruction @p index of the queue (0 is the oldest), no side effects
+         */
+        bool peek(Slot &out, unsigned int index = 0) const;
+
+        /**
+         * @brief Remove the oldest @p n instructions, which must have been peeked
+         */
+        void pop(unsigned int n = 1);
+
+        /**
+         * @brief peek() and pop() of the oldest instruction; counts a fetch
+         *        bubble and its cause when there is none
+         */
+        bool take(Slot &out);
+
+        /**
+         * @brief True once a block read failed and the queue ran dry before it
+         */
+        bool faulted() const {
+            Slot head_slot;
+            return fault && !peek(head_slot);
+        }
+
+        std::uint64_t faultAddress() const {
+            return fault_pc;
+        }
+
+        std::uint64_t fetchPC() const {
+            return fetch_pc;
+        }
+
+        const Stats &stats() const {
+            return counters;
+        }
+
+        void printStats(std::ostream &os) const;
+
+        /**
+         * @brief 32-bit equivalent of a compressed instruction (C, Zcf/Zcd, Zcb),
+         *        0 if illegal or a Zcmp/Zcmt instruction (--zcmp)
+         */
+        static std::uint32_t expand(std::uint16_t c, bool rv64);
+
+        static constexpr unsigned int MAX_MICRO_OPS = 16;
+
+        /**
+         * @brief Zcmp/Zcmt instruction (--zcmp), which expand() leaves to the
+         *        issue stage as a sequence of micro-ops
+         */
+        static bool isSequence(std::uint16_t c);
+
+        /**
+         * @brief Micro-ops of a Zcmp instruction as 32-bit encodings, in order
+         *
+         * cm.push stores the register list below sp, one store per register,
+         * and then lowers sp. cm.pop, cm.popret and cm.popretz load the list,
+         * raise sp, and then clear a0 (popretz) and return (popret*).
+         * cm.mvsa01 and cm.mva01s are two moves.
+         * @return micro-ops written to @p uops (at most MAX_MICRO_OPS), 0 for
+         *         a reserved encoding or a Zcmt table jump
+         */
+        static unsigned int crack(std::uint16_t c, bool rv64, std::uint32_t *uops);
+
+        /**
+         * @brief jvt index of cm.jt (below 32) or cm.jalt, -1 for anything else
+         */
+        static int tableJumpIndex(std::uint16_t c);
+
+    private:
+        std::uint8_t byteAt(unsigned int offset) const {
+            return queue[(head + offset) % queue.size()];
+        }
+
+        ReadBlock read_block;
+        const bool rv64;
+        const unsigned int block_bytes;
+
+        std::vector<std::uint8_t> queue;    ///< ring buffer
+        unsigned int head{0};
+        unsigned int count{0};
+        std::uint64_t head_pc{0};           ///< address of the byte at head
+        std::uint64_t fetch_pc{0};          ///< next byte to read
+
+        bool fault{false};
+        std::uint64_t fault_pc{0};
+
+        Stats counters;
+    };
+}
+
+#endif /* INC_FETCHUNIT_H_ */
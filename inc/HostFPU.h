@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file HostFPU.h
+ * @brief IEEE 754 binary32/binary64 arithmetic with RISC-V semantics on the host FPU
+ *
+ * Operands and results are raw IEEE bit patterns. Arithmetic runs on the
+ * host FPU (SSE scalar instructions on x86-64) with the guest rounding mode
+ * installed and the host exception flags translated to fflags bits. Where
+ * the host cannot match RISC-V the result is fixed up in software:
+ *  - NaN results are replaced by the canonical NaN;
+ *  - min/max, compares, sign injection and classify are bit operations;
+ *  - float to integer conversions saturate as the ISA requires;
+ *  - round-to-nearest-max-magnitude (RMM), which hosts do not implement,
+ *    goes through a soft-float rounding path for inexact results.
+ */
+#pragma once
+#ifndef HOST_FPU_H
+#define HOST_FPU_H
+
+#include <cstdint>
+#include <type_traits>
+
+namespace riscv_tlm {
+
+/** fflags bits */
+constexpr unsigned int FFLAG_NX = 1 << 0;   ///< inexact
+constexpr unsigned int FFLAG_UF = 1 << 1;   ///< underflow
+constexpr unsigned int FFLAG_OF = 1 << 2;   ///< overflow
+constexpr unsigned int FFLAG_DZ = 1 << 3;   ///< divide by zero
+constexpr unsigned int FFLAG_NV = 1 << 4;   ///< invalid operation
+
+/** Rounding modes, as encoded in the rm field and in frm */
+enum FPRounding : unsigned int {
+    FRM_RNE = 0b000,
+    FRM_RTZ = 0b001,
+    FRM_RDN = 0b010,
+    FRM_RUP = 0b011,
+    FRM_RMM = 0b100,
+    FRM_DYN = 0b111,
+};
+
+enum class FPArith {
+    Add, Sub, Mul, Div, Sqrt, Min, Max
+};
+
+enum class FPCompare {
+    Eq, Lt, Le
+};
+
+/**
+ * @brief Host FPU front end, instantiated for float (binary32) and double (binary64)
+ *
+ * All functions accumulate exception flags into @p flags and never clear it.
+ */
+template<typename F>
+class HostFPU {
+public:
+    using Bits = typename std::conditional<sizeof(F) == 4, std::uint32_t, std::uint64_t>::type;
+
+    static constexpr Bits CANONICAL_NAN = sizeof(F) == 4 ? Bits(0x7FC00000u)
+                                                         : Bits(0x7FF8000000000000ull);
+
+    /**
+     * @brief a op b (Sqrt uses a only)
+     */
+    static Bits arith(FPArith op, Bits a, Bits b, unsigned int rm, unsigned int &flags);
+
+    /**
+     * @brief (a * b) + c with a single rounding, product and addend negated on request
+     */
+    static Bits fma(Bits a, Bits b, Bits c, bool negate_product, bool negate_addend,
+                    unsigned int rm, unsigned int &flags);
+
+    /**
+     * @brief feq is quiet, flt/fle signal on any NaN
+     */
+    static bool compare(FPCompare op, Bits a, Bits b, unsigned int &flags);
+
+    /**
+     * @brief fclass result mask
+     */
+    static unsigned int classify(Bits a);
+
+    /**
+     * @brief Convert to a 32 or 64 bit integer, saturating
+     * @return result sign extended to 64 bits (also for unsigned 32 bit)
+     */
+    static std::uint64_t toInt(Bits a, bool is_signed, unsigned int width, unsigned int rm,
+                               unsigned int &flags);
+
+    /**
+     * @brief Convert a 32 or 64 bit integer (in the low bits of @p v)
+     */
+    static Bits fromInt(std::uint64_t v, bool is_signed, unsigned int width, unsigned int rm,
+                        unsigned int &flags);
+
+    /**
+     * @brief Soft-float reference of fma(), also used for RMM
+     *
+     * Only valid for finite operands whose result is not a NaN.
+     */
+    static Bits softFma(Bits a, Bits b, Bits c, unsigned int rm, unsigned int &flags);
+};
+
+/**
+ * @brief binary64 to binary32
+ */
+std::uint32_t fpNarrow(std::uint64_t a, unsigned int rm, unsigned int &flags);
+
+/**
+ * @brief binary32 to binary64 (exact)
+ */
+std::uint64_t fpWiden(std::uint32_t a, unsigned int &flags);
+
+extern template class HostFPU<float>;
+extern template class HostFPU<double>;
+
+} // namespace riscv_tlm
+
+#endif // HOST_FPU_H
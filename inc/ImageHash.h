@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file ImageHash.h
+ * @brief Content hash of a loaded program image
+ *
+ * The hash covers the bytes a loader places in memory and where it places
+ * them, not the file format. So an Intel HEX file and the ELF it was made
+ * from (its allocated sections at their load addresses) hash the same, in
+ * whatever order and record sizes the bytes arrive. Bytes added again at an
+ * address replace the earlier ones.
+ *
+ * Digest: 64-bit FNV-1a over every maximal run of contiguous bytes in
+ * ascending address order, each as its start address and length (8 bytes
+ * little-endian each) followed by its bytes.
+ */
+#pragma once
+#ifndef INC_IMAGEHASH_H_
+#define INC_IMAGEHASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace riscv_tlm {
+
+    class ImageHash {
+    public:
+        void add(std::uint64_t addr, const std::uint8_t *data, std::size_t len) {
+            if (len == 0) {
+                return;
+            }
+            /* the run this one extends, if any */
+            auto it = m_runs.upper_bound(addr);
+            if (it != m_runs.begin() && std::prev(it)->first + std::prev(it)->second.size() >= addr) {
+                --it;
+            } else {
+                it = m_runs.emplace(addr, std::vector<std::uint8_t>()).first;
+            }
+
+            auto &run = it->second;
+            std::size_t offset = static_cast<std::size_t>(addr - it->first);
+            if (run.size() < offset + len) {
+                run.resize(offset + len);
+            }
+            std::memcpy(run.data() + offset, data, len);
+
+            /* absorb the runs the new bytes now reach */
+            std::uint64_t end = it->first + run.size();
+            auto next = std::next(it);
+            while (next != m_runs.end() && next->first <= end) {
+                std::uint64_t next_end = next->first + next->second.size();
+                if (next_end > end) {
+                    std::size_t keep = static_cast<std::size_t>(end - next->first);
+                    run.insert(run.end(), next->second.begin() + static_cast<std::ptrdiff_t>(keep),
+                               next->second.end());
+                    end = next_end;
+                }
+                next = m_runs.erase(next);
+            }
+        }
+
+        std::uint64_t digest() const {
+            std::uint64_t h = 0xcbf29ce484222325ULL;
+            auto mix = [&h](const std::uint8_t *p, std::size_t n) {
+                for (std::size_t i = 0; i < n; i++) {
+                    h ^= p[i];
+                    h *= 0x100000001b3ULL;
+                }
+            };
+            auto mix64 = [&mix](std::uint64_t v) {
+                std::uint8_t le[8];
+                for (unsigned int i = 0; i < 8; i++) {
+                    le[i] = static_cast<std::uint8_t>(v >> (8 * i));
+                }
+                mix(le, 8);
+            };
+            for (const auto &run : m_runs) {
+                mix64(run.first);
+                mix64(run.second.size());
+                mix(run.second.data(), run.second.size());
+            }
+            return h;
+        }
+
+        bool empty() const {
+            return m_runs.empty();
+        }
+
+        /**
+         * @brief Call @p visit(start, length) for each run of contiguous bytes, in address order
+         */
+        template<typename Visit>
+        void visitRuns(Visit visit) const {
+            for (const auto &run : m_runs) {
+                visit(run.first, static_cast<std::uint64_t>(run.second.size()));
+            }
+        }
+
+    private:
+        std::map<std::uint64_t, std::vector<std::uint8_t>> m_runs;     ///< by start address, never touching
+    };
+}
+
+#endif /* INC_IMAGEHASH_H_ */
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file IssueRules.h
+ * @brief Pairing rules and pairing statistics of the dual-issue 6-stage models
+ *
+ * Every instruction is classified by the pipe it needs. Two consecutive
+ * instructions issue in the same cycle when the older one issues and
+ *  - the pipes of their classes are not oversubscribed (one LSU shared by
+ *    loads and stores, one multiplier for M and clmul*, two ALUs and one branch
+ *    unit by default),
+ *  - the pair of classes is not excluded,
+ *  - the younger one does not read (RAW) or, unless allowed, write (WAW) the
+ *    destination of the older one,
+ *  - the older one is not a branch or jump: a control transfer ends the pair,
+ *  - neither is a system instruction (ecall, csr*, fence), which issue alone.
+ * Otherwise the younger one issues in a later cycle and the first rule it
+ * broke is counted, per reason and per pair of classes.
+ */
+#pragma once
+#ifndef INC_ISSUERULES_H_
+#define INC_ISSUERULES_H_
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#ifndef P6_ISSUE_WIDTH
+#define P6_ISSUE_WIDTH 1
+#endif
+
+namespace riscv_tlm {
+
+    enum IssueClass : std::uint8_t {
+        ISSUE_ALU,
+        ISSUE_MUL,
+        ISSUE_LOAD,
+        ISSUE_STORE,
+        ISSUE_BRANCH,
+        ISSUE_SYSTEM,
+        ISSUE_CLASSES
+    };
+
+    /**
+     * @brief Why the younger instruction of a pair did not issue with the older one
+     */
+    enum PairBlock : std::uint8_t {
+        PAIR_OK,
+        PAIR_NO_SECOND,     ///< front end delivered a single instruction
+        PAIR_RAW,           ///< younger reads the older one's destination
+        PAIR_WAW,           ///< both write the same register
+        PAIR_PIPE,          ///< pipe of the class already taken
+        PAIR_EXCLUDED,      ///< class pair excluded by the rules
+        PAIR_CONTROL,       ///< older is a branch or jump
+        PAIR_SYSTEM,        ///< system instructions issue alone
+        PAIR_HAZARD,        ///< younger waits for an older in-flight result
+        PAIR_RESOURCE,      ///< no free ROB entry for the younger one
+        PAIR_REASONS
+    };
+
+    /**
+     * @brief Register usage of a decoded instruction, as seen by the pairing check
+     */
+    struct IssueOp {
+        IssueClass cls{ISSUE_ALU};
+        std::uint8_t rd{0};
+        std::uint8_t rs1{0};        ///< 0 when not read
+        std::uint8_t rs2{0};        ///< 0 when not read
+
+        static IssueOp fromDecode(std::uint8_t opcode, std::uint8_t funct3, std::uint8_t funct7,
+                                  std::uint8_t rd, std::uint8_t rs1, std::uint8_t rs2);
+    };
+
+    struct PairingRules {
+        unsigned int width{P6_ISSUE_WIDTH};     ///< 1 or 2
+        std::array<unsigned int, ISSUE_CLASSES> pipes{{2, 1, 1, 1, 1, 1}};
+        bool lsu_shared{true};                  ///< loads and stores share the LSU pipes
+        bool allow_waw{false};
+        std::array<std::array<bool, ISSUE_CLASSES>, ISSUE_CLASSES> excluded{};  ///< [older][younger]
+
+        /**
+         * @brief First rule that keeps @p younger from issuing with @p older
+         */
+        PairBlock check(const IssueOp &older, const IssueOp &younger) const;
+
+        /**
+         * @brief Apply a comma-separated spec such as
+         *        "width=2,alu=2,lsu=1,mul=1,waw=0,no=load+mul"
+         *
+         * Keys: width, alu, mul, lsu (loads and stores), load and store
+         * (separate pipes), branch, waw (0/1) and no=<older>+<younger>
+         * with classes alu, mul, load, store, branch.
+         * @return false with @p error set on an unknown key or value
+         */
+        bool parse(const std::string &spec, std::string &error);
+
+        /**
+         * @brief Rules the 6-stage models copy at construction (--pairing)
+         */
+        static const PairingRules &defaults() {
+            return s_defaults;
+        }
+
+        static void setDefaults(const PairingRules &rules) {
+            s_defaults = rules;
+        }
+
+        static const char *className(IssueClass cls);
+
+    private:
+        static PairingRules s_defaults;
+    };
+
+    struct PairStats {
+        std::uint64_t issue_cycles{0};      ///< cycles in which at least one instruction issued
+        std::uint64_t dual{0};              ///< cycles in which two issued
+        std::array<std::uint64_t, PAIR_REASONS> blocked{};
+        std::array<std::array<std::uint64_t, ISSUE_CLASSES>, ISSUE_CLASSES> paired{};
+        std::array<std::array<std::uint64_t, ISSUE_CLASSES>, ISSUE_CLASSES> split{};
+
+        /**
+         * @brief Account one issue cycle; @p younger is ignored for PAIR_NO_SECOND
+         */
+        void record(IssueClass older, IssueClass younger, PairBlock reason);
+
+        void print(std::ostream &os) const;
+    };
+}
+
+#endif /* INC_ISSUERULES_H_ */
@@ -0,0 +1,389 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file K_extension.h
+ * @brief Implement the scalar cryptography extensions part of the RISC-V
+ *
+ * Zkne/Zknd (AES encryption/decryption), Zknh (SHA-256/SHA-512 sigma and sum
+ * functions), Zksed (SM4) and Zksh (SM3) for RV32 and RV64. The bit
+ * manipulation instructions Zkn and Zks also include (Zbkb, Zbkc, Zbkx) are
+ * in B_extension. AES and SM4 run on CryptoKernels; the SHA and SM3
+ * functions are rotates and xors the host executes directly.
+ */
+#pragma once
+#ifndef K_EXTENSION__H
+#define K_EXTENSION__H
+
+#include "systemc"
+#include <cstdint>
+
+#include "extension_base.h"
+#include "BitManip.h"
+#include "CryptoKernels.h"
+#include "Instruction.h"
+#include "Registers.h"
+
+namespace riscv_tlm {
+
+    typedef enum {
+        /* Zkne/Zknd, RV32 */
+        OP_K_AES32ESI,
+        OP_K_AES32ESMI,
+        OP_K_AES32DSI,
+        OP_K_AES32DSMI,
+        /* Zkne/Zknd, RV64 */
+        OP_K_AES64ES,
+        OP_K_AES64ESM,
+        OP_K_AES64DS,
+        OP_K_AES64DSM,
+        OP_K_AES64IM,
+        OP_K_AES64KS1I,
+        OP_K_AES64KS2,
+        /* Zknh */
+        OP_K_SHA256SIG0,
+        OP_K_SHA256SIG1,
+        OP_K_SHA256SUM0,
+        OP_K_SHA256SUM1,
+        OP_K_SHA512SIG0,
+        OP_K_SHA512SIG1,
+        OP_K_SHA512SUM0,
+        OP_K_SHA512SUM1,
+        OP_K_SHA512SIG0L,
+        OP_K_SHA512SIG0H,
+        OP_K_SHA512SIG1L,
+        OP_K_SHA512SIG1H,
+        OP_K_SHA512SUM0R,
+        OP_K_SHA512SUM1R,
+        /* Zksed */
+        OP_K_SM4ED,
+        OP_K_SM4KS,
+        /* Zksh */
+        OP_K_SM3P0,
+        OP_K_SM3P1,
+        OP_K_ERROR
+    } op_K_Codes;
+
+    typedef enum {
+        K_OP = 0b0110011,
+        K_OP_IMM = 0b0010011,
+    } K_Codes;
+
+    /** instr[29:25] of the instructions with a byte select in instr[31:30] */
+    typedef enum {
+        K5_AES32ESI = 0b10001,
+        K5_AES32ESMI = 0b10011,
+        K5_AES32DSI = 0b10101,
+        K5_AES32DSMI = 0b10111,
+        K5_SM4ED = 0b11000,
+        K5_SM4KS = 0b11010,
+    } K_Funct5;
+
+    /** funct7 of the other register forms */
+    typedef enum {
+        K7_AES64ES = 0b0011001,
+        K7_AES64ESM = 0b0011011,
+        K7_AES64DS = 0b0011101,
+        K7_AES64DSM = 0b0011111,
+        K7_AES64KS2 = 0b0111111,
+        K7_SHA512SUM0R = 0b0101000,
+        K7_SHA512SUM1R = 0b0101001,
+        K7_SHA512SIG0L = 0b0101010,
+        K7_SHA512SIG1L = 0b0101011,
+        K7_SHA512SIG0H = 0b0101110,
+        K7_SHA512SIG1H = 0b0101111,
+    } K_Funct7;
+
+    /** imm[11:0] of the unary forms (OP-IMM, funct3 001) */
+    typedef enum {
+        K12_SHA256SUM0 = 0x100,
+        K12_SHA256SUM1 = 0x101,
+        K12_SHA256SIG0 = 0x102,
+        K12_SHA256SIG1 = 0x103,
+        K12_SHA512SUM0 = 0x104,
+        K12_SHA512SUM1 = 0x105,
+        K12_SHA512SIG0 = 0x106,
+        K12_SHA512SIG1 = 0x107,
+        K12_SM3P0 = 0x108,
+        K12_SM3P1 = 0x109,
+        K12_AES64IM = 0x300,
+        K8_AES64KS1I = 0x31,    ///< imm[11:4], rnum in imm[3:0]
+    } K_Imm12;
+
+/**
+ * @brief Instruction decoding and fields access
+ */
+    template<typename T>
+    class K_extension : public extension_base<T> {
+    public:
+
+        /**
+         * @brief Constructor, same as base class
+         */
+        using extension_base<T>::extension_base;
+
+        using signed_T = typename std::make_signed<T>::type;
+        using unsigned_T = typename std::make_unsigned<T>::type;
+
+        /**
+         * @brief Access to opcode field
+         * @return return opcode field
+         */
+        inline unsigned_T opcode() const override {
+            return static_cast<unsigned_T>(this->m_instr.range(6, 0));
+        }
+
+        inline unsigned int get_funct7() const {
+            return this->m_instr.range(31, 25);
+        }
+
+        /**
+         * @brief Byte select of aes32* and sm4*
+         */
+        inline unsigned int get_bs() const {
+            return this->m_instr.range(31, 30);
+        }
+
+        inline unsigned int get_rnum() const {
+            return this->m_instr.range(23, 20);
+        }
+
+        /**
+         * @brief Decodes opcode of instruction
+         * @return opcode of instruction
+         */
+        op_K_Codes decode() const {
+            constexpr bool rv64 = sizeof(T) == 8;
+
+            if (opcode() == K_OP && this->get_funct3() == 0b000) {
+                switch (this->m_instr.range(29, 25)) {
+                    case K5_SM4ED:
+                        return OP_K_SM4ED;
+                    case K5_SM4KS:
+                        return OP_K_SM4KS;
+                    case K5_AES32ESI:
+                        return rv64 ? OP_K_ERROR : OP_K_AES32ESI;
+                    case K5_AES32ESMI:
+                        return rv64 ? OP_K_ERROR : OP_K_AES32ESMI;
+                    case K5_AES32DSI:
+                        return rv64 ? OP_K_ERROR : OP_K_AES32DSI;
+                    case K5_AES32DSMI:
+                        return rv64 ? OP_K_ERROR : OP_K_AES32DSMI;
+                    default:
+                        break;
+                }
+                if constexpr (rv64) {
+                    switch (get_funct7()) {
+                        case K7_AES64ES:
+                            return OP_K_AES64ES;
+                        case K7_AES64ESM:
+                            return OP_K_AES64ESM;
+                        case K7_AES64DS:
+                            return OP_K_AES64DS;
+                        case K7_AES64DSM:
+                            return OP_K_AES64DSM;
+                        case K7_AES64KS2:
+                            return OP_K_AES64KS2;
+                        default:
+                            return OP_K_ERROR;
+                    }
+                } else {
+                    switch (get_funct7()) {
+                        case K7_SHA512SUM0R:
+                            return OP_K_SHA512SUM0R;
+                        case K7_SHA512SUM1R:
+                            return OP_K_SHA512SUM1R;
+                        case K7_SHA512SIG0L:
+                            return OP_K_SHA512SIG0L;
+                        case K7_SHA512SIG0H:
+                            return OP_K_SHA512SIG0H;
+                        case K7_SHA512SIG1L:
+                            return OP_K_SHA512SIG1L;
+                        case K7_SHA512SIG1H:
+                            return OP_K_SHA512SIG1H;
+                        default:
+                            return OP_K_ERROR;
+                    }
+                }
+            }
+
+            if (opcode() == K_OP_IMM && this->get_funct3() == 0b001) {
+                unsigned int imm12 = this->m_instr.range(31, 20);
+                switch (imm12) {
+                    case K12_SHA256SUM0:
+                        return OP_K_SHA256SUM0;
+                    case K12_SHA256SUM1:
+                        return OP_K_SHA256SUM1;
+                    case K12_SHA256SIG0:
+                        return OP_K_SHA256SIG0;
+                    case K12_SHA256SIG1:
+                        return OP_K_SHA256SIG1;
+                    case K12_SM3P0:
+                        return OP_K_SM3P0;
+                    case K12_SM3P1:
+                        return OP_K_SM3P1;
+                    case K12_SHA512SUM0:
+                        return rv64 ? OP_K_SHA512SUM0 : OP_K_ERROR;
+                    case K12_SHA512SUM1:
+                        return rv64 ? OP_K_SHA512SUM1 : OP_K_ERROR;
+                    case K12_SHA512SIG0:
+                        return rv64 ? OP_K_SHA512SIG0 : OP_K_ERROR;
+                    case K12_SHA512SIG1:
+                        return rv64 ? OP_K_SHA512SIG1 : OP_K_ERROR;
+                    case K12_AES64IM:
+                        return rv64 ? OP_K_AES64IM : OP_K_ERROR;
+                    default:
+                        break;
+                }
+                /* rnum 0xB..0xF are reserved */
+                if (rv64 && (imm12 >> 4) == K8_AES64KS1I && get_rnum() <= 0xA) {
+                    return OP_K_AES64KS1I;
+                }
+            }
+
+            return OP_K_ERROR;
+        }
+
+        /**
+         * @brief Result of @p code for the current instruction on operands @p a (rs1) and @p b (rs2)
+         * @return false if @p code is not an instruction of this extension
+         */
+        bool compute(op_K_Codes code, unsigned_T a, unsigned_T b, unsigned_T &result) const {
+            auto a32 = static_cast<std::uint32_t>(a);
+            auto b32 = static_cast<std::uint32_t>(b);
+
+            switch (code) {
+                case OP_K_AES32ESI:
+                case OP_K_AES32ESMI:
+                case OP_K_AES32DSI:
+                case OP_K_AES32DSMI:
+                    result = signExtendWord(crypto::aes32(a32, b32, get_bs(),
+                                                          code == OP_K_AES32DSI || code == OP_K_AES32DSMI,
+                                                          code == OP_K_AES32ESMI || code == OP_K_AES32DSMI));
+                    break;
+                case OP_K_AES64ES:
+                    result = static_cast<unsigned_T>(crypto::aes64(crypto::Aes64Op::Es, a, b));
+                    break;
+                case OP_K_AES64ESM:
+                    result = static_cast<unsigned_T>(crypto::aes64(crypto::Aes64Op::Esm, a, b));
+                    break;
+                case OP_K_AES64DS:
+                    result = static_cast<unsigned_T>(crypto::aes64(crypto::Aes64Op::Ds, a, b));
+                    break;
+                case OP_K_AES64DSM:
+                    result = static_cast<unsigned_T>(crypto::aes64(crypto::Aes64Op::Dsm, a, b));
+                    break;
+                case OP_K_AES64IM:
+                    result = static_cast<unsigned_T>(crypto::aes64im(a));
+                    break;
+                case OP_K_AES64KS1I:
+                    result = static_cast<unsigned_T>(crypto::aes64ks1i(a, get_rnum()));
+                    break;
+                case OP_K_AES64KS2:
+                    result = static_cast<unsigned_T>(crypto::aes64ks2(a, b));
+                    break;
+
+                case OP_K_SHA256SIG0:
+                    result = signExtendWord(bitmanip::rotr(a32, 7) ^ bitmanip::rotr(a32, 18) ^ (a32 >> 3));
+                    break;
+                case OP_K_SHA256SIG1:
+                    result = signExtendWord(bitmanip::rotr(a32, 17) ^ bitmanip::rotr(a32, 19) ^ (a32 >> 10));
+                    break;
+                case OP_K_SHA256SUM0:
+                    result = signExtendWord(bitmanip::rotr(a32, 2) ^ bitmanip::rotr(a32, 13)
+                                            ^ bitmanip::rotr(a32, 22));
+                    break;
+                case OP_K_SHA256SUM1:
+                    result = signExtendWord(bitmanip::rotr(a32, 6) ^ bitmanip::rotr(a32, 11)
+                                            ^ bitmanip::rotr(a32, 25));
+                    break;
+                case OP_K_SHA512SIG0:
+                    result = static_cast<unsigned_T>(sha512(a, 1, 8, 7, true));
+                    break;
+                case OP_K_SHA512SIG1:
+                    result = static_cast<unsigned_T>(sha512(a, 19, 61, 6, true));
+                    break;
+                case OP_K_SHA512SUM0:
+                    result = static_cast<unsigned_T>(sha512(a, 28, 34, 39, false));
+                    break;
+                case OP_K_SHA512SUM1:
+                    result = static_cast<unsigned_T>(sha512(a, 14, 18, 41, false));
+                    break;
+                /* RV32: one half of the 64-bit function, rs1 holding that half and rs2 the other */
+                case OP_K_SHA512SIG0L:
+                    result = static_cast<unsigned_T>(sha512(join(a32, b32), 1, 8, 7, true));
+                    break;
+                case OP_K_SHA512SIG0H:
+                    result = static_cast<unsigned_T>(sha512(join(b32, a32), 1, 8, 7, true) >> 32);
+                    break;
+                case OP_K_SHA512SIG1L:
+                    result = static_cast<unsigned_T>(sha512(join(a32, b32), 19, 61, 6, true));
+                    break;
+                case OP_K_SHA512SIG1H:
+                    result = static_cast<unsigned_T>(sha512(join(b32, a32), 19, 61, 6, true) >> 32);
+                    break;
+                case OP_K_SHA512SUM0R:
+                    result = static_cast<unsigned_T>(sha512(join(a32, b32), 28, 34, 39, false));
+                    break;
+                case OP_K_SHA512SUM1R:
+                    result = static_cast<unsigned_T>(sha512(join(a32, b32), 14, 18, 41, false));
+                    break;
+
+                case OP_K_SM4ED:
+                case OP_K_SM4KS:
+                    result = signExtendWord(crypto::sm4(a32, b32, get_bs(), code == OP_K_SM4KS));
+                    break;
+                case OP_K_SM3P0:
+                    result = signExtendWord(a32 ^ bitmanip::rotl(a32, 9) ^ bitmanip::rotl(a32, 17));
+                    break;
+                case OP_K_SM3P1:
+                    result = signExtendWord(a32 ^ bitmanip::rotl(a32, 15) ^ bitmanip::rotl(a32, 23));
+                    break;
+
+                default:
+                    return false;
+            }
+            return true;
+        }
+
+        bool exec_instruction(Instruction &inst, op_K_Codes code) {
+            this->setInstr(inst.getInstr());
+
+            unsigned int rd = this->get_rd();
+            auto a = static_cast<unsigned_T>(this->regs->getValue(this->get_rs1()));
+            auto b = static_cast<unsigned_T>(this->regs->getValue(this->get_rs2()));
+            unsigned_T result;
+
+            if (!compute(code, a, b, result)) {
+                this->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, this->m_instr);
+                return false;
+            }
+
+            this->regs->setValue(rd, static_cast<T>(result));
+
+            this->logger->debug("{} ps. PC: 0x{:x}. K: 0x{:x} -> x{:d}(0x{:x})",
+                                sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                static_cast<std::uint32_t>(this->m_instr), rd, result);
+            return true;
+        }
+
+    private:
+
+        static unsigned_T signExtendWord(std::uint32_t value) {
+            return static_cast<unsigned_T>(static_cast<signed_T>(static_cast<std::int32_t>(value)));
+        }
+
+        static std::uint64_t join(std::uint32_t lo, std::uint32_t hi) {
+            return (static_cast<std::uint64_t>(hi) << 32) | lo;
+        }
+
+        /**
+         * @brief SHA-512 sigma (two rotates and a shift) or sum (three rotates)
+         */
+        static std::uint64_t sha512(std::uint64_t x, unsigned int r1, unsigned int r2, unsigned int r3,
+                                    bool sigma) {
+            return bitmanip::rotr(x, r1) ^ bitmanip::rotr(x, r2)
+                   ^ (sigma ? x >> r3 : bitmanip::rotr(x, r3));
+        }
+    };
+}
+
+#endif
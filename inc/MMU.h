@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file MMU.h
+ * @brief Sv32/Sv39 address translation with a host-side software TLB
+ *
+ * Translation is active when satp selects Sv32 (RV32) or Sv39 (RV64) and the
+ * effective privilege is S or U (mstatus.MPRV applies MPP to M-mode loads and
+ * stores). Page tables are walked through the physical side of the
+ * MemoryInterface, A and D bits are updated in hardware.
+ *
+ * The TLB is direct-mapped and split by context (U, S, S with SUM) and by
+ * access type, so a hit already implies the permission check passed. Each
+ * entry maps one 4 KiB page (superpages are cached per 4 KiB slice) and keeps
+ * the host DMI pointer of the physical page, so a translated RAM access is a
+ * single lookup followed by a memcpy. Entries are invalidated in O(1) by
+ * bumping an epoch counter.
+ */
+#pragma once
+#ifndef INC_MMU_H_
+#define INC_MMU_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace riscv_tlm {
+
+    class MemoryInterface;
+    class PMP;
+
+    enum class AccessType {
+        Fetch = 0,
+        Load = 1,
+        Store = 2,
+    };
+
+    /**
+     * @brief Thrown by an access that page faults or fails its PMP check
+     *
+     * The CPU step catches it and raises the exception, so the faulting
+     * instruction has no architectural side effect.
+     */
+    struct MemoryFault {
+        unsigned int cause;         ///< page fault (12, 13, 15) or access fault (1, 5, 7)
+        std::uint64_t vaddr;        ///< faulting virtual address, for xtval
+    };
+
+    class MMU {
+    public:
+        enum class Mode {
+            Bare,
+            Sv32,
+            Sv39,
+        };
+
+        static constexpr unsigned int PAGE_SHIFT = 12;
+        static constexpr std::uint64_t PAGE_SIZE = 1ULL << PAGE_SHIFT;
+        static constexpr std::uint64_t PAGE_MASK = PAGE_SIZE - 1;
+        static constexpr unsigned int TLB_BITS = 12;     ///< 4096 entries per context and access type
+
+        /**
+         * @param mem_interface physical side used for page table walks and DMI
+         * @param rv64 Sv39 (true) or Sv32 (false) satp layout
+         */
+        MMU(MemoryInterface *mem_interface, bool rv64);
+
+        /**
+         * @brief Check page table accesses against @p pmp_unit and only cache
+         *        host pointers of pages it fully allows
+         */
+        void setPMP(PMP *pmp_unit) {
+            pmp = pmp_unit;
+            flush();
+        }
+
+        /**
+         * @brief WARL check for satp writes: unsupported modes are ignored
+         */
+        static bool satpModeSupported(std::uint64_t satp, bool rv64) {
+            if (!rv64) {
+                return true;
+            }
+            auto mode = satp >> 60;
+            return mode == 0 || mode == 8;
+        }
+
+        /**
+         * @brief Track satp, mstatus (SUM, MXR, MPRV, MPP) and the current privilege
+         *
+         * Called by Registers whenever one of them changes. A new satp or MXR
+         * value flushes the TLB.
+         */
+        void setState(std::uint64_t satp, std::uint64_t mstatus, unsigned int privilege);
+
+        /**
+         * @brief True if accesses of @p type are currently translated
+         */
+        bool translates(AccessType type) const {
+            return type == AccessType::Fetch ? fetch_ctx >= 0 : data_ctx >= 0;
+        }
+
+        static bool crossesPage(std::uint64_t vaddr, std::uint64_t size) {
+            return (vaddr & PAGE_MASK) + size > PAGE_SIZE;
+        }
+
+        /**
+         * @brief Translate @p vaddr; only valid while translates(type) is true
+         * @param host if not null, receives the host pointer of the byte, or
+         *        nullptr if the page is not DMI-accessible
+         * @return physical address
+         * @throws MemoryFault
+         */
+        std::uint64_t translate(std::uint64_t vaddr, AccessType type, unsigned char **host = nullptr) {
+            int ctx = type == AccessType::Fetch ? fetch_ctx : data_ctx;
+            std::uint64_t vpn = vaddr >> PAGE_SHIFT;
+            const TlbEntry &e = tlb[slot(ctx, type, vpn)];
+
+            if (e.vpn == vpn && e.epoch == epoch) [[likely]] {
+                if (host != nullptr) {
+                    *host = e.host != nullptr ? e.host + (vaddr & PAGE_MASK) : nullptr;
+                }
+                return e.ppage | (vaddr & PAGE_MASK);
+            }
+            return refill(vaddr, type, ctx, host);
+        }
+
+        /**
+         * @brief Fetch an instruction that straddles a page boundary
+         *
+         * The second page is only translated if the first half-word is not a
+         * compressed instruction.
+         * @throws MemoryFault
+         */
+        std::uint32_t fetchAcrossPages(std::uint64_t vaddr);
+
+        /**
+         * @brief SFENCE.VMA
+         * @param vaddr address operand, ignored if @p all_addresses
+         * @param asid ASID operand, ignored if @p all_asids
+         */
+        void sfence(std::uint64_t vaddr, bool all_addresses, std::uint64_t asid, bool all_asids);
+
+        /**
+         * @brief Drop every cached translation (and host pointer)
+         */
+        void flush();
+
+        std::uint64_t tlbMisses() const {
+            return misses;
+        }
+
+    private:
+        struct TlbEntry {
+            std::uint64_t vpn{0};
+            std::uint64_t ppage{0};         ///< physical page base
+            unsigned char *host{nullptr};   ///< host pointer to ppage, if DMI-accessible
+            std::uint32_t epoch{0};         ///< valid while equal to MMU::epoch
+        };
+
+        static constexpr std::uint64_t TLB_ENTRIES = 1ULL << TLB_BITS;
+        static constexpr int CONTEXTS = 3;              ///< U, S, S with SUM
+        static constexpr std::size_t MAX_SUPERPAGES = 64;
+
+        static std::size_t slot(int ctx, AccessType type, std::uint64_t vpn) {
+            return ((static_cast<std::size_t>(ctx) * 3 + static_cast<std::size_t>(type)) << TLB_BITS)
+                   | (vpn & (TLB_ENTRIES - 1));
+        }
+
+        std::uint64_t refill(std::uint64_t vaddr, AccessType type, int ctx, unsigned char **host);
+
+        /**
+         * @brief Walk the page table
+         * @param[out] level 0 for a 4 KiB page, 1 or 2 for superpages
+         * @return physical base of the 4 KiB page holding @p vaddr
+         * @throws MemoryFault
+         */
+        std::uint64_t walk(std::uint64_t vaddr, AccessType type, int ctx, unsigned int &level);
+
+        [[noreturn]] static void fault(std::uint64_t vaddr, AccessType type);
+
+        /* page table accesses are implicit S-mode accesses, checked by PMP */
+        std::uint64_t readPTE(std::uint64_t addr, std::uint64_t vaddr, AccessType type) const;
+
+        void checkPTE(std::uint64_t addr, AccessType access, std::uint64_t vaddr, AccessType type) const;
+
+        MemoryInterface *mem_intf;
+        PMP *pmp{nullptr};
+        bool rv64;
+
+        std::vector<TlbEntry> tlb;
+        std::uint32_t epoch{1};
+
+        /* superpages cached since the last flush, as {first vpn, vpn count} */
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> superpages;
+        bool superpages_overflow{false};
+
+        Mode mode{Mode::Bare};
+        std::uint64_t satp{0};
+        std::uint64_t root{0};          ///< physical address of the root page table
+        std::uint64_t asid{0};
+        bool mxr{false};
+        int fetch_ctx{-1};              ///< TLB context of fetches, -1 if untranslated
+        int data_ctx{-1};               ///< TLB context of loads and stores, -1 if untranslated
+
+        std::uint64_t misses{0};
+    };
+}
+
+#endif /* INC_MMU_H_ */
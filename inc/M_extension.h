@@ -73,6 +73,11 @@ namespace riscv_tlm {
          */
         [[nodiscard]] op_M_Codes decode() const {
 
+            /* OP and OP-32 also carry Zb* instructions, told apart by funct7 */
+            if (this->m_instr.range(31, 25) != 0b0000001) {
+                return OP_M_ERROR;
+            }
+
             if (this->m_instr.range(6,0) == 0b110011) {
                 switch (opcode()) {
                     case M_MUL:
@@ -103,7 +108,7 @@ namespace riscv_tlm {
                         return OP_M_ERROR;
                         break;
                 }
-            } else {
+            } else if (this->m_instr.range(6,0) == 0b0111011) {
                 switch (opcode()) {
                     case M_MULW:
                         return OP_M_MULW;
@@ -149,7 +154,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, static_cast<signed_T>(result));
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.MUL: x{:d}({:d}) * x{:d}({:d}) -> x{:d}({:d})",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.MUL: x{:d}({:d}) * x{:d}({:d}) -> x{:d}({:d})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, multiplier, multiplicand, rd, result);
@@ -178,7 +183,7 @@ namespace riscv_tlm {
                 this->regs->setValue(rd, hi);
             }
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.MULH: x{:d}({:d}) * x{:d}({:d}) -> x{:d}(hi)",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.MULH: x{:d}({:d}) * x{:d}({:d}) -> x{:d}(hi)",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, multiplier, rs2, multiplicand, rd);
@@ -208,7 +213,7 @@ namespace riscv_tlm {
                 this->regs->setValue(rd, hi);
             }
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.MULHSU: x{:d} * x{:d} -> x{:d}(hi)",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.MULHSU: x{:d} * x{:d} -> x{:d}(hi)",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd);
@@ -237,7 +242,7 @@ namespace riscv_tlm {
                 this->regs->setValue(rd, hi);
             }
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.MULHU: x{:d} * x{:d} -> x{:d}(hi)",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.MULHU: x{:d} * x{:d} -> x{:d}(hi)",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd);
@@ -265,7 +270,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, result);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.DIV: x{:d} / x{:d} -> x{:d}({:d})",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.DIV: x{:d} / x{:d} -> x{:d}({:d})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, result);
@@ -291,7 +296,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, result);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.DIVU: x{:d} / x{:d} -> x{:d}({:d})",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.DIVU: x{:d} / x{:d} -> x{:d}({:d})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, result);
@@ -319,7 +324,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, result);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.REM: x{:d} % x{:d} -> x{:d}({:d})",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.REM: x{:d} % x{:d} -> x{:d}({:d})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, result);
@@ -345,7 +350,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, result);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.REMU: x{:d} % x{:d} -> x{:d}({:d})",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.REMU: x{:d} % x{:d} -> x{:d}({:d})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, result);
@@ -366,7 +371,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, result);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.MULW: x{:d}({:d}) * x{:d}({:d}) -> x{:d}({:d})",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.MULW: x{:d}({:d}) * x{:d}({:d}) -> x{:d}({:d})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, multiplier, multiplicand, rd, result);
@@ -394,7 +399,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, result);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.DIVW: x{:d} / x{:d} -> x{:d}({:d})",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.DIVW: x{:d} / x{:d} -> x{:d}({:d})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, result);
@@ -422,7 +427,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, result);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.DIVUW: x{:d} / x{:d} -> x{:d}({:d})",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.DIVUW: x{:d} / x{:d} -> x{:d}({:d})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, result);
@@ -450,7 +455,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, result);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.REMW: x{:d} % x{:d} -> x{:d}({:d})",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.REMW: x{:d} % x{:d} -> x{:d}({:d})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, rs2, rd, result);
@@ -476,7 +481,7 @@ namespace riscv_tlm {
 
             this->regs->setValue(rd, result);
 
-            this->logger->debug("{} ns. PC: 0x{:x}. M.REMUW: x{:d}({:d}) % x{:d}({:d}) -> x{:d}({:d})",
+            this->logger->debug("{} ps. PC: 0x{:x}. M.REMUW: x{:d}({:d}) % x{:d}({:d}) -> x{:d}({:d})",
                                 sc_core::sc_time_stamp().value(),
                                 this->regs->getPC(),
                                 rs1, dividend, rs2, divisor, rd, result);
@@ -12,6 +12,9 @@
 #include <iostream>
 #include <fstream>
 #include <array>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 
@@ -23,6 +26,8 @@
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/basic_file_sink.h"
 
+#include "ImageHash.h"
+
 namespace riscv_tlm {
 /**
  * @brief Basic TLM-2 memory
@@ -65,12 +70,49 @@ namespace riscv_tlm {
         // *********************************************
         virtual unsigned int transport_dbg(tlm::tlm_generic_payload &trans);
 
+        /**
+         * @brief Host address of physical address 0, for snapshots of the RAM
+         */
+        unsigned char *hostBase() {
+            return mem;
+        }
+
+        /**
+         * @brief Read Intel hex file
+         * @param filename file name to read
+         */
+        void readHexFile(const std::string &filename);
+
+        /**
+         * @brief ImageHash of the bytes the hex file loaded (finds translated code, --aot)
+         */
+        std::uint64_t imageHash() const {
+            return image_hash;
+        }
+
+        /**
+         * @brief Address ranges the hex file loaded, as (start, length) in address order
+         */
+        const std::vector<std::pair<std::uint64_t, std::uint64_t>> &imageRuns() const {
+            return image_runs;
+        }
+
     private:
 
+        /**
+         * @brief Point mem at the shared RAM of the telemetry page or at storage
+         */
+        void allocate();
+
         /**
          * @brief Memory array in bytes
          */
-        std::array<uint8_t, Memory::SIZE> mem{};
+        uint8_t *mem{nullptr};
+
+        /**
+         * @brief Owns mem unless the RAM is shared (--telemetry-ram)
+         */
+        std::unique_ptr<uint8_t[]> storage;
 
         /**
          * @brief Log class
@@ -82,6 +124,9 @@ namespace riscv_tlm {
          */
         std::uint32_t program_counter;
 
+        std::uint64_t image_hash{0};
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> image_runs;
+
         /**
          * @brief DMI can be used?
          */
@@ -91,12 +136,6 @@ namespace riscv_tlm {
          * @brief Optional configured latency (via env RVSIM_MEM_LAT_NS)
          */
         sc_core::sc_time m_latency{sc_core::SC_ZERO_TIME};
-
-        /**
-         * @brief Read Intel hex file
-         * @param filename file name to read
-         */
-        void readHexFile(const std::string &filename);
     };
 }
 #endif /* __MEMORY_H__ */
@@ -17,6 +17,8 @@
 #include "tlm_utils/tlm_quantumkeeper.h"
 
 #include "Memory.h"
+#include "MMU.h"
+#include "PMP.h"
 #include <cstdint>
 
 namespace riscv_tlm {
@@ -50,6 +52,93 @@ namespace riscv_tlm {
          * @param size size of the data to write in bytes (1, 2, 4, or 8)
          */
         void writeDataMem64(std::uint64_t addr, std::uint64_t data, int size);
+
+        /**
+         * @brief Host pointer to @p len bytes of RAM at @p addr (DMI)
+         * @param addr first byte to access
+         * @param len number of bytes, all inside one DMI region
+         * @param is_write access type
+         * @return nullptr if the range is not DMI-accessible (peripherals, DMI
+         *         disabled, crosses a page while translation is on, not fully
+         *         allowed by PMP); use the read/write calls above instead
+         * @throws MemoryFault if translation is on and the page is not mapped
+         */
+        unsigned char *getDMIPointer(std::uint64_t addr, std::size_t len, bool is_write);
+
+        /**
+         * @brief Translate the accesses above through @p mmu (nullptr: physical only)
+         */
+        void setMMU(MMU *mmu_unit) {
+            mmu = mmu_unit;
+        }
+
+        MMU *getMMU() const {
+            return mmu;
+        }
+
+        /**
+         * @brief Check physical accesses against @p pmp_unit (nullptr: no checks)
+         */
+        void setPMP(PMP *pmp_unit) {
+            pmp = pmp_unit;
+        }
+
+        /**
+         * @brief Report the accesses above to the plugins (PluginManager::onMemAccess)
+         *
+         * The pipelined models turn this off and report an access themselves,
+         * after the instruction that made it retires.
+         */
+        void setPluginReports(bool on) {
+            plugin_reports = on;
+        }
+
+        /**
+         * @brief Untranslated accesses, for page table walks
+         */
+        std::uint32_t readPhysical(std::uint64_t addr, int size);
+
+        void writePhysical(std::uint64_t addr, std::uint32_t data, int size);
+
+        unsigned char *getPhysicalDMIPointer(std::uint64_t addr, std::size_t len, bool is_write);
+
+        /**
+         * @brief The whole DMI region around physical address @p addr, readable and writable
+         * @param start, end first and last physical address of the region
+         * @return host address of @p start, or nullptr if @p addr has no DMI
+         */
+        unsigned char *getPhysicalDMIRegion(std::uint64_t addr, std::uint64_t &start, std::uint64_t &end);
+
+    private:
+        void invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end);
+
+        bool dmiCovers(std::uint64_t addr, std::size_t len, bool is_write) const;
+
+        /**
+         * @brief Translated access: RAM pages through the TLB host pointer,
+         *        anything else on the bus. Accesses that cross a page are
+         *        split into bytes once both pages are known to be mapped.
+         * @return true if done, false if @p addr now holds the physical
+         *         address and the access must go on the bus
+         */
+        bool translatedAccess(std::uint64_t &addr, unsigned char *data, int size, bool is_write);
+
+        /* accesses through a TLB host pointer were already checked for the whole page */
+        void checkPMP(std::uint64_t paddr, int size, AccessType type, std::uint64_t vaddr) {
+            if (pmp != nullptr && pmp->checks(type)) {
+                pmp->check(paddr, size, type, vaddr);
+            }
+        }
+
+        void transport(tlm::tlm_command cmd, std::uint64_t addr, unsigned char *data, int size,
+                       unsigned int width, const char *what);
+
+        MMU *mmu{nullptr};
+        PMP *pmp{nullptr};
+        bool plugin_reports{true};
+
+        tlm::tlm_dmi dmi_data;
+        bool dmi_valid{false};
     };
 }
 #endif /* INC_MEMORYINTERFACE_H_ */
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file NetLink.h
+ * @brief Ethernet segment between VP processes over shared memory
+ *
+ * Up to NET_PORTS simulators on one host attach to a segment, the POSIX
+ * shared-memory object /riscv_vp.net.<name>. Each pair of ports has its own
+ * lock-free ring (ShmRing.h) per direction, so every ring has a single
+ * producer and a single consumer. A frame goes to the port that owns its
+ * destination MAC address. Broadcast, multicast and unknown unicast frames
+ * go to every other port, as a switch would flood them.
+ *
+ * The link model is set by whoever creates the segment:
+ *  - bandwidth: a frame occupies the sender's link for its length plus
+ *    preamble, FCS and inter-frame gap, and frames queue behind each other;
+ *  - latency: the frame arrives this long after its last bit was sent.
+ *
+ * Frames carry their arrival time and are delivered at that simulated time.
+ * The latency is also the lookahead of a conservative synchronisation, as
+ * in TlmBridge.h: every port advances in steps of the latency, and only once
+ * every other running port has promised (granted) that nothing it sends
+ * from then on arrives earlier. So no frame arrives in a receiver's past,
+ * and the port that is furthest behind can always move.
+ */
+#pragma once
+#ifndef INC_NETLINK_H_
+#define INC_NETLINK_H_
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "systemc"
+
+#include "SharedMemory.h"
+#include "ShmRing.h"
+
+namespace riscv_tlm {
+
+    constexpr std::size_t NET_PORTS = 8;
+    constexpr std::size_t NET_FRAME_MAX = 1514;     ///< Ethernet frame without FCS
+    constexpr std::size_t NET_RING_SLOTS = 32;
+
+    struct NetFrame {
+        std::uint64_t time_ps;      ///< arrival at the receiver
+        std::uint32_t length;
+        std::uint32_t reserved;
+        std::uint8_t data[NET_FRAME_MAX];
+    };
+
+    struct NetPort {
+        enum State : std::uint32_t {
+            Absent, Running, Finished
+        };
+
+        alignas(64) std::atomic<std::uint64_t> grant_ps;   ///< nothing sent from now on arrives earlier
+        std::atomic<std::uint32_t> state;
+        std::atomic<std::uint32_t> pid;                 ///< owner, 0 if the port is free
+        std::uint8_t mac[8];
+    };
+
+    struct NetSegment {
+        static constexpr std::uint32_t MAGIC = 0x4e505652;     // "RVPN"
+        static constexpr std::uint32_t VERSION = 1;
+
+        std::atomic<std::uint32_t> magic;   ///< set last by the creator
+        std::uint32_t version;
+        std::uint64_t latency_ps;
+        std::uint64_t bandwidth_bps;
+        NetPort port[NET_PORTS];
+        ShmRing<NetFrame, NET_RING_SLOTS> ring[NET_PORTS][NET_PORTS];     ///< [to][from]
+    };
+
+    /**
+     * @brief Segment a platform attaches to (--net)
+     */
+    struct NetSpec {
+        std::string segment;            ///< empty: no network
+        std::array<std::uint8_t, 6> mac{};
+        bool has_mac{false};            ///< otherwise 52:54:00:12:34:<port + 1>
+        std::uint64_t latency_ps{10000000};
+        std::uint64_t bandwidth_bps{100000000};
+        bool has_link{false};           ///< latency or bandwidth given
+        unsigned int nodes{2};          ///< ports that must be running before time starts
+
+        /**
+         * @brief Parse "name[,mac=M][,latency=T][,bandwidth=R][,nodes=N]"
+         *
+         * T is a number with a unit: ps, ns, us or ms. R is in bit/s, with an
+         * optional k, M or G prefix and "bps" or "bit/s" suffix, e.g. 100Mbps.
+         * @return false with @p error set
+         */
+        bool parse(const std::string &spec, std::string &error);
+
+        /**
+         * @brief Segment of the platform built by the top level (--net)
+         */
+        static const NetSpec &platform() {
+            return s_platform;
+        }
+
+        static void setPlatform(const NetSpec &spec) {
+            s_platform = spec;
+        }
+
+    private:
+        static NetSpec s_platform;
+    };
+
+    /**
+     * @brief One port of a segment, with the time synchronisation of its simulator
+     */
+    class NetLink : public sc_core::sc_module {
+    public:
+        SC_HAS_PROCESS(NetLink);
+
+        /**
+         * @brief Attach to the segment named in @p spec, creating it if needed
+         */
+        NetLink(sc_core::sc_module_name const &name, const NetSpec &spec);
+
+        ~NetLink() override;
+
+        /**
+         * @brief Send @p frame now
+         * @return time until its last bit has left, after the frames queued before it
+         */
+        sc_core::sc_time send(const std::uint8_t *frame, std::size_t length);
+
+        /**
+         * @brief Where frames go at their arrival time
+         */
+        void onReceive(std::function<void(const std::uint8_t *, std::size_t)> handler) {
+            m_on_receive = std::move(handler);
+        }
+
+        const std::uint8_t *mac() const {
+            return m_mac.data();
+        }
+
+        unsigned int port() const {
+            return m_port;
+        }
+
+        const sc_core::sc_time &latency() const {
+            return m_latency;
+        }
+
+        std::uint64_t bandwidth() const {
+            return m_bandwidth_bps;
+        }
+
+        struct Stats {
+            std::uint64_t tx_frames{0};
+            std::uint64_t tx_bytes{0};
+            std::uint64_t tx_dropped{0};    ///< no running port to take them
+            std::uint64_t rx_frames{0};
+            std::uint64_t rx_bytes{0};
+            std::uint64_t rx_late{0};       ///< from a port that joined late, delivered on receipt
+            std::uint64_t rx_dropped{0};    ///< backlog full
+        };
+
+        const Stats &stats() const {
+            return m_stats;
+        }
+
+    private:
+        static constexpr std::size_t MAX_BACKLOG = 1024;
+
+        void sync_thread();
+
+        void deliver_method();
+
+        void end_of_simulation() override;
+
+        /**
+         * @brief Move every frame waiting in the incoming rings to the backlog
+         */
+        void poll();
+
+        bool push(unsigned int to, const NetFrame &frame);
+
+        void leave();
+
+        SharedMemory m_shm;
+        NetSegment *m_segment{nullptr};
+        unsigned int m_port{0};
+        std::array<std::uint8_t, 6> m_mac{};
+        unsigned int m_nodes{2};
+        std::uint64_t m_latency_ps{0};
+        sc_core::sc_time m_latency;
+        std::uint64_t m_bandwidth_bps{0};
+        std::uint64_t m_link_free_ps{0};    ///< when the sender's link is idle again
+        std::multimap<std::uint64_t, std::vector<std::uint8_t>> m_backlog;     ///< by arrival time
+        sc_core::sc_event m_arrival_event;
+        std::function<void(const std::uint8_t *, std::size_t)> m_on_receive;
+        Stats m_stats;
+    };
+}
+
+#endif /* INC_NETLINK_H_ */
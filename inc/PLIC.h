@@ -1,96 +1,316 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file PLIC.h
+ * @brief Platform-Level Interrupt Controller (RISC-V PLIC 1.0.0 register map)
+ *
+ * Up to 1023 sources and an M and an S context per hart. Pending, claimed and
+ * enable state are bitmaps of 64-bit words, and sources are also kept in one
+ * bitmap per priority level. A claim walks the levels above the context
+ * threshold from the highest down, skipping empty levels by their pending
+ * count, and takes the first set bit of pending & enable & level in the
+ * words that hold a pending source: the cost depends on the number of
+ * priority levels, not on the number of sources.
+ *
+ * Every change re-evaluates the contexts and drives, per hart, a TLM
+ * interrupt line whose payload is the MIP_MEIP / MIP_SEIP level mask.
+ *
+ * The registers are a RegisterBank table. Priorities, pending bits,
+ * enables and thresholds are kept in the bank as they change, so reads of
+ * them need no code here; only claim/complete call back.
+ */
 #pragma once
+#ifndef INC_PLIC_H_
+#define INC_PLIC_H_
+
 #include "systemc"
 #include "tlm.h"
 #include "tlm_utils/simple_target_socket.h"
+#include "tlm_utils/simple_initiator_socket.h"
+#include <algorithm>
 #include <cstdint>
 #include <array>
-#include <iostream>
 #include <cstring>
-#include <unordered_set>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BitManip.h"
+#include "RegisterBank.h"
+#include "Registers.h"
 
 namespace riscv_tlm { namespace peripherals {
-// Minimal PLIC: fixed number of interrupt sources, priority and pending registers
+
 class PLIC : public sc_core::sc_module {
 public:
     tlm_utils::simple_target_socket<PLIC> socket;
 
-    static constexpr size_t MAX_SOURCES = 32; // simple
+    /**
+     * @brief External interrupt line of each hart, see CPU::ext_irq_socket
+     */
+    std::vector<std::unique_ptr<tlm_utils::simple_initiator_socket<PLIC>>> irq_lines;
+
+    static constexpr unsigned int MAX_SOURCES = 1024;      ///< including the reserved source 0
+    static constexpr unsigned int PRIORITY_BITS = 3;
+    static constexpr unsigned int MAX_PRIORITY = (1u << PRIORITY_BITS) - 1;
+
+    /* register map */
+    static constexpr std::uint64_t PRIORITY_BASE = 0x000000;
+    static constexpr std::uint64_t PENDING_BASE = 0x001000;
+    static constexpr std::uint64_t ENABLE_BASE = 0x002000;
+    static constexpr std::uint64_t ENABLE_STRIDE = 0x80;
+    static constexpr std::uint64_t CONTEXT_BASE = 0x200000;
+    static constexpr std::uint64_t CONTEXT_STRIDE = 0x1000;
+    static constexpr std::uint64_t WINDOW = 0x400000;       ///< as the bus decodes it
 
     SC_HAS_PROCESS(PLIC);
-    explicit PLIC(sc_core::sc_module_name const &name) : sc_module(name), socket("socket") {
+
+    /**
+     * @param sources number of interrupt sources plus one (source 0 does not exist)
+     * @param harts number of harts; context 2h is hart h in M mode, 2h+1 in S mode
+     */
+    explicit PLIC(sc_core::sc_module_name const &name, unsigned int sources = MAX_SOURCES,
+                  unsigned int harts = 1)
+        : sc_module(name), socket("socket"),
+          num_sources(sources < 2 ? 2 : (sources > MAX_SOURCES ? MAX_SOURCES : sources)),
+          num_contexts(2 * (harts == 0 ? 1 : harts)),
+          words((num_sources + 63) / 64),
+          priorities(num_sources, 0), pending(words, 0), claimed(words, 0), level(words, 0),
+          enabled(num_contexts * words, 0), thresholds(num_contexts, 0), lines(harts == 0 ? 1 : harts, 0),
+          regs(std::max(WINDOW, CONTEXT_BASE + num_contexts * CONTEXT_STRIDE), RegisterBank::WORD) {
+        /* source 0 does not exist */
+        regs.add("priority", PRIORITY_BASE + 4).array(num_sources - 1).mask(MAX_PRIORITY)
+                .onWrite([this](unsigned int i, std::uint64_t value) {
+                    setPriority(i + 1, static_cast<std::uint32_t>(value));
+                });
+        regs.add("pending", PENDING_BASE, 4, Access::RO).array(2 * words);
+        for (unsigned int context = 0; context < num_contexts; context++) {
+            regs.add("enable", ENABLE_BASE + context * ENABLE_STRIDE).array(2 * words)
+                    .onWrite([this, context](unsigned int reg, std::uint64_t value) {
+                        setEnable(context, reg, static_cast<std::uint32_t>(value));
+                    });
+        }
+        regs.add("threshold", CONTEXT_BASE).array(num_contexts, CONTEXT_STRIDE).mask(MAX_PRIORITY)
+                .onWrite([this](unsigned int context, std::uint64_t value) {
+                    thresholds[context] = static_cast<std::uint32_t>(value);
+                    update();
+                });
+        regs.add("claim", CONTEXT_BASE + 4).array(num_contexts, CONTEXT_STRIDE)
+                .onRead([this](unsigned int context) {
+                    return claim(context);
+                })
+                .onWrite([this](unsigned int context, std::uint64_t value) {
+                    complete(context, static_cast<std::uint32_t>(value));
+                });
         socket.register_b_transport(this, &PLIC::b_transport);
-        priorities.fill(0);
-        pending_bits = 0;
-        enabled_bits = 0;
-        threshold = 0;
-        claim_complete = 0;
+        socket.register_get_direct_mem_ptr(this, &PLIC::get_direct_mem_ptr);
+        for (auto &bucket : by_priority) {
+            bucket.assign(words, 0);
+        }
+        pending_count.fill(0);
+        for (unsigned int h = 0; h < lines.size(); h++) {
+            irq_lines.emplace_back(new tlm_utils::simple_initiator_socket<PLIC>(
+                    ("irq_line_" + std::to_string(h)).c_str()));
+        }
+    }
+
+    /**
+     * @brief Edge-triggered request of source @p id
+     */
+    void raise(std::uint32_t id) {
+        if (id == 0 || id >= num_sources) {
+            return;
+        }
+        if (setPending(id)) {
+            update();
+        }
     }
 
-    // Simple method to raise an interrupt source (not wired yet externally)
-    void raise(uint32_t id) {
-        if (id > 0 && id < MAX_SOURCES) {
-            pending_bits |= (1u << id);
+    /**
+     * @brief Level of a level-triggered source; a source still high when its
+     *        claim completes becomes pending again
+     */
+    void set_irq(std::uint32_t id, bool active) {
+        if (id == 0 || id >= num_sources) {
+            return;
+        }
+        setBit(level, id, active);
+        if (active && setPending(id)) {
+            update();
         }
     }
 
+    /**
+     * @brief Source the context would get from a claim now, 0 if none
+     */
+    std::uint32_t highest(unsigned int context) const {
+        if (context >= num_contexts || pending_summary == 0) {
+            return 0;
+        }
+        const std::uint64_t *enable = &enabled[context * words];
+        for (unsigned int prio = MAX_PRIORITY; prio > thresholds[context]; prio--) {
+            if (pending_count[prio] == 0) {
+                continue;
+            }
+            const std::vector<std::uint64_t> &bucket = by_priority[prio];
+            for (std::uint64_t summary = pending_summary; summary != 0; summary &= summary - 1) {
+                unsigned int w = bitmanip::ctz(summary);
+                std::uint64_t candidates = pending[w] & enable[w] & bucket[w];
+                if (candidates != 0) {
+                    return w * 64 + bitmanip::ctz(candidates);
+                }
+            }
+        }
+        return 0;
+    }
+
 private:
-    // Register map (offsets chosen similar to spec subset)
-    // 0x0000 .. priorities (4 bytes each)
-    // 0x1000 pending bits (4 bytes)
-    // 0x2000 enable bits (hart 0) (4 bytes)
-    // 0x200000 threshold (4 bytes)
-    // 0x200004 claim/complete (4 bytes)
     void b_transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
         (void)delay;
-        auto cmd = trans.get_command();
-        uint64_t addr = trans.get_address();
-        unsigned char *ptr = trans.get_data_ptr();
-        unsigned len = trans.get_data_length();
-        if (len != 4) { trans.set_response_status(tlm::TLM_BURST_ERROR_RESPONSE); return; }
-        uint32_t data = 0;
-        if (cmd == tlm::TLM_WRITE_COMMAND) std::memcpy(&data, ptr, 4);
-        if (addr < 0x1000) { // priorities
-            size_t idx = addr / 4;
-            if (idx < MAX_SOURCES) {
-                if (cmd == tlm::TLM_WRITE_COMMAND) priorities[idx] = data & 0x7; // 3-bit priority
-                else data = priorities[idx];
-            }
-        } else if (addr == 0x1000) { // pending (read only)
-            if (cmd == tlm::TLM_READ_COMMAND) data = pending_bits;
-        } else if (addr == 0x2000) { // enable bits
-            if (cmd == tlm::TLM_WRITE_COMMAND) enabled_bits = data;
-            else data = enabled_bits;
-        } else if (addr == 0x200000) { // threshold
-            if (cmd == tlm::TLM_WRITE_COMMAND) threshold = data & 0x7;
-            else data = threshold;
-        } else if (addr == 0x200004) { // claim / complete
-            if (cmd == tlm::TLM_READ_COMMAND) {
-                // return highest-priority pending enabled source > threshold
-                uint32_t best = 0; uint32_t best_prio = 0;
-                for (uint32_t i = 1; i < MAX_SOURCES; ++i) {
-                    if ((pending_bits & (1u << i)) && (enabled_bits & (1u << i))) {
-                        uint32_t p = priorities[i];
-                        if (p > best_prio && p > threshold) { best_prio = p; best = i; }
-                    }
-                }
-                data = best;
-                claim_complete = best;
-                if (best) pending_bits &= ~(1u << best); // auto clear on claim
-            } else { // write = complete
-                // writing the source id signals completion
-                pending_bits &= ~(1u << data);
-                claim_complete = 0;
+        regs.access(trans);
+    }
+
+    bool get_direct_mem_ptr(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi_data) {
+        return regs.dmi(trans, dmi_data);
+    }
+
+    void setEnable(unsigned int context, unsigned int reg, std::uint32_t data) {
+        std::uint64_t &word = enabled[context * words + reg / 2];
+        unsigned int shift = (reg & 1) * 32;
+        std::uint64_t value = static_cast<std::uint64_t>(data) << shift;
+        if (reg == 0) {
+            value &= ~1ULL;     // source 0 does not exist
+        }
+        value &= validMask(reg / 2);
+        word = (word & ~(0xFFFFFFFFULL << shift)) | value;
+        regs.set(ENABLE_BASE + context * ENABLE_STRIDE + 4 * reg, value >> shift);
+        update();
+    }
+
+    std::uint32_t claim(unsigned int context) {
+        std::uint32_t id = highest(context);
+        if (id != 0) {
+            clearPending(id);
+            setBit(claimed, id, true);
+            update();
+        }
+        return id;
+    }
+
+    void complete(unsigned int context, std::uint32_t id) {
+        /* ignored unless the source is enabled for the context */
+        if (id == 0 || id >= num_sources || !testBit(enabled, context * words, id) || !testBit(claimed, 0, id)) {
+            return;
+        }
+        setBit(claimed, id, false);
+        if (testBit(level, 0, id)) {
+            setPending(id);
+        }
+        update();
+    }
+
+    void setPriority(std::uint32_t id, std::uint32_t prio) {
+        std::uint32_t old = priorities[id];
+        if (old == prio) {
+            return;
+        }
+        setBit(by_priority[old], id, false);
+        setBit(by_priority[prio], id, true);
+        if (testBit(pending, 0, id)) {
+            pending_count[old]--;
+            pending_count[prio]++;
+        }
+        priorities[id] = prio;
+        update();
+    }
+
+    /* gateway: at most one request per source in flight */
+    bool setPending(std::uint32_t id) {
+        if (testBit(pending, 0, id) || testBit(claimed, 0, id)) {
+            return false;
+        }
+        setBit(pending, id, true);
+        pending_summary |= 1ULL << (id / 64);
+        pending_count[priorities[id]]++;
+        mirrorPending(id);
+        return true;
+    }
+
+    void clearPending(std::uint32_t id) {
+        setBit(pending, id, false);
+        if (pending[id / 64] == 0) {
+            pending_summary &= ~(1ULL << (id / 64));
+        }
+        pending_count[priorities[id]]--;
+        mirrorPending(id);
+    }
+
+    /* the 32-bit pending register holding @p id, as software reads it */
+    void mirrorPending(std::uint32_t id) {
+        unsigned int reg = id / 32;
+        regs.set(PENDING_BASE + 4 * reg, static_cast<std::uint32_t>(pending[reg / 2] >> ((reg & 1) * 32)));
+    }
+
+    /* recompute the eip of every context and signal the harts whose lines changed */
+    void update() {
+        for (unsigned int h = 0; h < lines.size(); h++) {
+            std::uint32_t mask = (highest(2 * h) != 0 ? MIP_MEIP : 0)
+                                 | (highest(2 * h + 1) != 0 ? MIP_SEIP : 0);
+            if (mask != lines[h]) {
+                lines[h] = mask;
+                signal(h, mask);
             }
         }
-        if (cmd == tlm::TLM_READ_COMMAND) std::memcpy(ptr, &data, 4);
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
     }
 
-    std::array<uint32_t, MAX_SOURCES> priorities;
-    uint32_t pending_bits;
-    uint32_t enabled_bits;
-    uint32_t threshold;
-    uint32_t claim_complete;
+    void signal(unsigned int hart, std::uint32_t mask) {
+        if ((*irq_lines[hart]).size() == 0) {
+            return;
+        }
+        tlm::tlm_generic_payload trans;
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        trans.set_command(tlm::TLM_WRITE_COMMAND);
+        trans.set_address(0);
+        trans.set_data_ptr(reinterpret_cast<unsigned char *>(&mask));
+        trans.set_data_length(4);
+        trans.set_streaming_width(4);
+        trans.set_byte_enable_ptr(nullptr);
+        trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+        (*irq_lines[hart])->b_transport(trans, delay);
+    }
+
+    std::uint64_t validMask(unsigned int word) const {
+        unsigned int valid = num_sources - word * 64;
+        return valid >= 64 ? ~0ULL : (1ULL << valid) - 1;
+    }
+
+    bool testBit(const std::vector<std::uint64_t> &bits, unsigned int base, std::uint32_t id) const {
+        return (bits[base + id / 64] >> (id % 64)) & 1;
+    }
+
+    static void setBit(std::vector<std::uint64_t> &bits, std::uint32_t id, bool value) {
+        if (value) {
+            bits[id / 64] |= 1ULL << (id % 64);
+        } else {
+            bits[id / 64] &= ~(1ULL << (id % 64));
+        }
+    }
+
+    const unsigned int num_sources;
+    const unsigned int num_contexts;
+    const unsigned int words;                       ///< 64-bit words per source bitmap
+
+    std::vector<std::uint32_t> priorities;
+    std::vector<std::uint64_t> pending;
+    std::vector<std::uint64_t> claimed;
+    std::vector<std::uint64_t> level;
+    std::vector<std::uint64_t> enabled;             ///< words per context, context-major
+    std::vector<std::uint32_t> thresholds;
+    std::array<std::vector<std::uint64_t>, MAX_PRIORITY + 1> by_priority;
+    std::array<unsigned int, MAX_PRIORITY + 1> pending_count{};
+    std::uint64_t pending_summary{0};               ///< bit w set if pending[w] != 0
+    std::vector<std::uint32_t> lines;               ///< last mask sent to each hart
+    RegisterBank regs;
 };
 }} // namespace
+
+#endif /* INC_PLIC_H_ */
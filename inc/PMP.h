@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file PMP.h
+ * @brief Physical memory protection (pmpcfg/pmpaddr, TOR/NA4/NAPOT, locking)
+ *
+ * Checks are answered from a direct-mapped per-page cache: the first access
+ * to a 4 KiB page resolves the entry list once for the whole page. If one
+ * entry covers the page (or none touches it) the page is uniform and every
+ * access inside it costs one lookup; only pages split by a region boundary
+ * fall back to matching the entry list per access. The cache is dropped, by
+ * bumping an epoch, when a PMP CSR changes.
+ */
+#pragma once
+#ifndef INC_PMP_H_
+#define INC_PMP_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "MMU.h"
+
+#ifndef PMP_ENTRIES
+#define PMP_ENTRIES 16
+#endif
+
+#define CSR_PMPCFG0 (0x3A0)
+#define CSR_PMPADDR0 (0x3B0)
+#define CSR_PMPADDR63 (0x3EF)
+
+namespace riscv_tlm {
+
+    class PMP {
+    public:
+        static constexpr unsigned int MAX_ENTRIES = 64;
+
+        static_assert(PMP_ENTRIES == 0 || PMP_ENTRIES == 16 || PMP_ENTRIES == 64,
+                      "PMP_ENTRIES must be 0, 16 or 64");
+
+        /**
+         * @param rv64 pmpcfg and pmpaddr layout
+         * @param entries implemented entries; with 0 nothing is checked
+         */
+        explicit PMP(bool rv64, unsigned int entries = PMP_ENTRIES);
+
+        static bool isPMPCSR(int csr) {
+            return csr >= CSR_PMPCFG0 && csr <= CSR_PMPADDR63;
+        }
+
+        std::uint64_t readCSR(int csr) const;
+
+        /**
+         * @brief WARL write of a pmpcfg or pmpaddr CSR; locked entries ignore it
+         * @return true if the configuration changed
+         */
+        bool writeCSR(int csr, std::uint64_t value);
+
+        /**
+         * @brief Track the privilege of fetches and of loads/stores (mstatus.MPRV)
+         */
+        void setState(std::uint64_t mstatus, unsigned int privilege);
+
+        /**
+         * @brief True if accesses of @p type can be denied at the current
+         *        privilege (always below M, only with locked entries in M)
+         */
+        bool checks(AccessType type) const {
+            return type == AccessType::Fetch ? fetch_checked : data_checked;
+        }
+
+        /**
+         * @brief True if [addr, addr+size) allows @p type at the current privilege
+         */
+        bool permits(std::uint64_t addr, std::uint64_t size, AccessType type) {
+            return allows(addr, size, type, type == AccessType::Fetch ? fetch_priv : data_priv);
+        }
+
+        /**
+         * @brief Raise the access fault of @p type unless permits()
+         * @param tval virtual address reported in xtval
+         * @throws MemoryFault
+         */
+        void check(std::uint64_t addr, std::uint64_t size, AccessType type, std::uint64_t tval) {
+            if (!permits(addr, size, type)) {
+                fault(type, tval);
+            }
+        }
+
+        /**
+         * @brief Permission check at privilege @p priv (0 U, 1 S, 3 M)
+         */
+        bool allows(std::uint64_t addr, std::uint64_t size, AccessType type, unsigned int priv) {
+            std::uint64_t page = addr >> PAGE_SHIFT;
+            if (((addr + size - 1) >> PAGE_SHIFT) == page) [[likely]] {
+                const PageInfo &info = pageInfo(page);
+                if (info.uniform) [[likely]] {
+                    return (info.perm[priv == 3 ? 0 : 1] & permBit(type)) != 0;
+                }
+            }
+            return matchEntries(addr, size, type, priv);
+        }
+
+        /**
+         * @brief True if every byte of the 4 KiB page at @p page_base allows @p type
+         */
+        bool pageAllows(std::uint64_t page_base, AccessType type, unsigned int priv) {
+            const PageInfo &info = pageInfo(page_base >> PAGE_SHIFT);
+            return info.uniform && (info.perm[priv == 3 ? 0 : 1] & permBit(type)) != 0;
+        }
+
+        [[noreturn]] static void fault(AccessType type, std::uint64_t tval);
+
+    private:
+        enum : std::uint8_t {
+            CFG_R = 1 << 0,
+            CFG_W = 1 << 1,
+            CFG_X = 1 << 2,
+            CFG_A = 3 << 3,
+            CFG_L = 1 << 7,
+        };
+
+        enum {
+            A_OFF = 0,
+            A_TOR = 1,
+            A_NA4 = 2,
+            A_NAPOT = 3,
+        };
+
+        static constexpr unsigned int PAGE_SHIFT = 12;
+        static constexpr unsigned int CACHE_BITS = 10;
+
+        struct PageInfo {
+            std::uint64_t page{0};
+            std::uint32_t epoch{0};
+            std::uint8_t perm[2]{0, 0};     ///< R/W/X for M and for S/U
+            bool uniform{false};
+        };
+
+        static std::uint8_t permBit(AccessType type) {
+            static constexpr std::uint8_t bits[] = {CFG_X, CFG_R, CFG_W};
+            return bits[static_cast<int>(type)];
+        }
+
+        const PageInfo &pageInfo(std::uint64_t page) {
+            PageInfo &info = cache[page & ((1u << CACHE_BITS) - 1)];
+            if (info.page != page || info.epoch != epoch) [[unlikely]] {
+                fillPage(info, page);
+            }
+            return info;
+        }
+
+        void fillPage(PageInfo &info, std::uint64_t page);
+
+        bool matchEntries(std::uint64_t addr, std::uint64_t size, AccessType type, unsigned int priv) const;
+
+        bool locked(unsigned int i) const {
+            return (cfg[i] & CFG_L) != 0;
+        }
+
+        /* [first, last] of every entry, recomputed when the CSRs change */
+        void decode();
+
+        bool rv64;
+        unsigned int entries;
+
+        std::array<std::uint8_t, MAX_ENTRIES> cfg{};
+        std::array<std::uint64_t, MAX_ENTRIES> addr{};
+        std::array<std::uint64_t, MAX_ENTRIES> first{};
+        std::array<std::uint64_t, MAX_ENTRIES> last{};
+        std::array<bool, MAX_ENTRIES> active{};
+        bool any_locked{false};
+
+        std::vector<PageInfo> cache;
+        std::uint32_t epoch{1};
+
+        unsigned int fetch_priv{3};
+        unsigned int data_priv{3};
+        bool fetch_checked{false};
+        bool data_checked{false};
+    };
+}
+
+#endif /* INC_PMP_H_ */
@@ -78,6 +78,16 @@ public:
 		instructions_executed++;
 	}
 
+	/**
+	 * @brief Count a run of instructions executed at once (translated code)
+	 */
+	inline void instructionsInc(uint_fast64_t n, uint_fast64_t loads, uint_fast64_t stores) {
+		instructions_executed += n;
+		code_memory_read += n;
+		data_memory_read += loads;
+		data_memory_write += stores;
+	}
+
 	/**
 	 * @brief Dump counters to cout
 	 */
@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file PluginAPI.h
+ * @brief Stable C API for instrumentation plugins (shared libraries)
+ *
+ * A plugin is a shared library loaded with `--plugin lib.so[,arg[,arg...]]`.
+ * It must export:
+ *   - `int rvvp_plugin_version` set to RVVP_PLUGIN_VERSION
+ *   - `int rvvp_plugin_install(rvvp_plugin_id_t, const rvvp_plugin_info_t *, int argc, char **argv)`
+ *     returning 0 on success.
+ *
+ * Instrumentation follows a translate/execute split: the first time a block
+ * of straight-line code is reached, every plugin's block translation callback
+ * is invoked and may subscribe individual instructions to execution or
+ * memory callbacks, or attach inline counters. Instructions nobody subscribed
+ * to make no call into a plugin, but the simulator still follows every
+ * executed instruction through its blocks while a plugin is loaded:
+ * instrumentation is zero cost only when no plugin is loaded.
+ *
+ * All callbacks run on the simulation thread; the simulator is single threaded.
+ */
+#ifndef RVVP_PLUGIN_API_H
+#define RVVP_PLUGIN_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Bumped on any incompatible change of this header */
+#define RVVP_PLUGIN_VERSION 1
+
+#if defined(_WIN32)
+#define RVVP_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define RVVP_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+typedef unsigned int rvvp_plugin_id_t;
+
+/** Opaque handles, valid only inside the callback they are passed to */
+struct rvvp_plugin_tb;
+struct rvvp_plugin_insn;
+/** Opaque per-hart scratch area, valid until exit */
+struct rvvp_plugin_scratch;
+
+typedef struct {
+    int version;         /**< RVVP_PLUGIN_VERSION of the simulator */
+    unsigned int xlen;   /**< 32 or 64 */
+    unsigned int n_harts; /**< harts of the platform, hart indices run from 0 to n_harts - 1 */
+} rvvp_plugin_info_t;
+
+/** Reasons reported to the ROI callback */
+enum rvvp_plugin_roi {
+    RVVP_ROI_END = 0,
+    RVVP_ROI_BEGIN = 1,
+};
+
+typedef void (*rvvp_plugin_tb_trans_cb_t)(rvvp_plugin_id_t id, struct rvvp_plugin_tb *tb);
+typedef void (*rvvp_plugin_insn_exec_cb_t)(unsigned int hart, void *udata);
+typedef void (*rvvp_plugin_mem_cb_t)(unsigned int hart, uint64_t vaddr, unsigned int size,
+                                     int is_store, void *udata);
+typedef void (*rvvp_plugin_trap_cb_t)(rvvp_plugin_id_t id, unsigned int hart, uint64_t cause,
+                                      uint64_t pc, int is_interrupt);
+typedef void (*rvvp_plugin_roi_cb_t)(rvvp_plugin_id_t id, unsigned int hart, int begin);
+typedef void (*rvvp_plugin_atexit_cb_t)(rvvp_plugin_id_t id, void *udata);
+
+/* --- Global callbacks ---------------------------------------------------- */
+
+void rvvp_plugin_register_tb_trans_cb(rvvp_plugin_id_t id, rvvp_plugin_tb_trans_cb_t cb);
+
+/**
+ * @brief Synchronous traps (exceptions) and taken interrupts
+ */
+void rvvp_plugin_register_trap_cb(rvvp_plugin_id_t id, rvvp_plugin_trap_cb_t cb);
+
+/**
+ * @brief Region-of-interest markers executed by the guest
+ *
+ * `slti x0, x0, 1` begins and `slti x0, x0, 2` ends a region; both are
+ * HINT encodings that execute as no-ops on real hardware.
+ */
+void rvvp_plugin_register_roi_cb(rvvp_plugin_id_t id, rvvp_plugin_roi_cb_t cb);
+
+void rvvp_plugin_register_atexit_cb(rvvp_plugin_id_t id, rvvp_plugin_atexit_cb_t cb, void *udata);
+
+/* --- Translation-time queries and subscriptions -------------------------- */
+
+size_t rvvp_plugin_tb_n_insns(const struct rvvp_plugin_tb *tb);
+uint64_t rvvp_plugin_tb_vaddr(const struct rvvp_plugin_tb *tb);
+struct rvvp_plugin_insn *rvvp_plugin_tb_get_insn(const struct rvvp_plugin_tb *tb, size_t idx);
+
+uint64_t rvvp_plugin_insn_vaddr(const struct rvvp_plugin_insn *insn);
+uint32_t rvvp_plugin_insn_data(const struct rvvp_plugin_insn *insn);
+/** @return 2 for compressed instructions, 4 otherwise */
+unsigned int rvvp_plugin_insn_size(const struct rvvp_plugin_insn *insn);
+
+void rvvp_plugin_register_insn_exec_cb(struct rvvp_plugin_insn *insn,
+                                       rvvp_plugin_insn_exec_cb_t cb, void *udata);
+
+/** Memory callbacks fire for every data access made by this instruction */
+void rvvp_plugin_register_insn_mem_cb(struct rvvp_plugin_insn *insn,
+                                      rvvp_plugin_mem_cb_t cb, void *udata);
+
+/** Add @p imm to @p *counter each time the instruction executes, without a call */
+void rvvp_plugin_register_insn_exec_inline_add(struct rvvp_plugin_insn *insn,
+                                               uint64_t *counter, uint64_t imm);
+
+/* --- Per-hart scratch data ------------------------------------------------ */
+
+/** Allocate @p size zeroed bytes per hart */
+struct rvvp_plugin_scratch *rvvp_plugin_scratch_new(size_t size);
+void *rvvp_plugin_scratch_get(struct rvvp_plugin_scratch *scratch, unsigned int hart);
+
+/** Inline add to the uint64_t at @p offset of the executing hart's scratch area */
+void rvvp_plugin_register_insn_exec_inline_add_per_hart(struct rvvp_plugin_insn *insn,
+                                                        struct rvvp_plugin_scratch *scratch,
+                                                        size_t offset, uint64_t imm);
+
+/* --- Custom instructions (custom-0..3 opcode space) ------------------------ */
+
+/** Hart state handed to a custom instruction, valid during the call only */
+struct rvvp_custom_ctx;
+
+/** @return 0 on success, non-zero to raise an illegal instruction exception */
+typedef int (*rvvp_custom_insn_fn_t)(struct rvvp_custom_ctx *ctx, uint32_t insn, void *udata);
+
+/**
+ * @brief Register an instruction; call from rvvp_plugin_install
+ * @param mask encoding bits identifying the instruction, opcode bits included
+ * @param latency cycles the instruction keeps the execute stage busy
+ * @param occupancy initiation interval of the functional unit in cycles
+ * @return registration id, or -1 if the encoding is invalid or overlaps
+ */
+int rvvp_plugin_register_custom_insn(const char *name, uint32_t mask, uint32_t match,
+                                     rvvp_custom_insn_fn_t fn, void *udata,
+                                     unsigned int latency, unsigned int occupancy);
+
+/** @param reg 0..31; writes to x0 are ignored */
+uint64_t rvvp_custom_read_reg(const struct rvvp_custom_ctx *ctx, unsigned int reg);
+void rvvp_custom_write_reg(struct rvvp_custom_ctx *ctx, unsigned int reg, uint64_t value);
+/** Data accesses go through the hart's data bus; @p size is 1, 2, 4 or 8 */
+uint64_t rvvp_custom_load(struct rvvp_custom_ctx *ctx, uint64_t addr, unsigned int size);
+void rvvp_custom_store(struct rvvp_custom_ctx *ctx, uint64_t addr, uint64_t value, unsigned int size);
+uint64_t rvvp_custom_pc(const struct rvvp_custom_ctx *ctx);
+void rvvp_custom_jump(struct rvvp_custom_ctx *ctx, uint64_t target);
+/** Add data-dependent cycles to the registered latency */
+void rvvp_custom_add_cycles(struct rvvp_custom_ctx *ctx, unsigned int cycles);
+
+/* --- Run-time queries ------------------------------------------------------ */
+
+/** @param reg 0..31 for x0..x31, 32 for the PC */
+uint64_t rvvp_plugin_read_register(unsigned int hart, unsigned int reg);
+unsigned int rvvp_plugin_n_harts(void);
+void rvvp_plugin_outs(const char *msg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RVVP_PLUGIN_API_H */
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file PluginManager.h
+ * @brief Loader and dispatcher for instrumentation plugins (see PluginAPI.h)
+ *
+ * CPU models call the hooks below only when PluginManager::active() is true,
+ * so a run without plugins pays one predictable branch per instruction.
+ * With plugins loaded, executed code is split into translation blocks
+ * (straight-line runs ending at a control transfer). Each block is announced
+ * once to the plugins, which subscribe the instructions they care about;
+ * sequential execution inside a block then costs a single compare per
+ * instruction, and only subscribed instructions dispatch callbacks.
+ * A block whose code changed (self-modifying code) is re-translated.
+ */
+#pragma once
+#ifndef PLUGIN_MANAGER_H
+#define PLUGIN_MANAGER_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "PluginAPI.h"
+
+struct rvvp_plugin_insn {
+    struct ExecCb {
+        rvvp_plugin_insn_exec_cb_t cb;
+        void *udata;
+    };
+    struct MemCb {
+        rvvp_plugin_mem_cb_t cb;
+        void *udata;
+    };
+    struct InlineAdd {
+        uint64_t *counter;                  ///< shared counter, or nullptr
+        struct rvvp_plugin_scratch *scratch;///< per-hart counter, or nullptr
+        size_t offset;
+        uint64_t imm;
+    };
+
+    uint64_t pc{0};
+    uint32_t data{0};
+    unsigned int size{4};
+    int roi{-1};                ///< RVVP_ROI_BEGIN / RVVP_ROI_END, -1 if not a marker
+    bool instrumented{false};   ///< any callback, inline op or ROI marker attached
+    std::vector<ExecCb> exec_cbs;
+    std::vector<MemCb> mem_cbs;
+    std::vector<InlineAdd> inline_ops;
+};
+
+struct rvvp_plugin_tb {
+    uint64_t pc{0};
+    std::vector<rvvp_plugin_insn> insns;
+};
+
+struct rvvp_plugin_scratch {
+    size_t size{0};
+    std::vector<std::unique_ptr<uint8_t[]>> per_hart;
+};
+
+namespace riscv_tlm {
+
+class PluginManager {
+public:
+    /**
+     * @brief Accessors a CPU model provides for its hart
+     */
+    struct HartAccess {
+        std::function<std::uint64_t(unsigned int)> read_reg;   ///< x0..x31, 32 = PC
+        std::function<std::uint64_t(int)> read_csr;
+        std::function<bool(std::uint64_t, std::uint32_t &)> fetch; ///< read code without side effects
+    };
+
+    static PluginManager *getInstance();
+
+    /**
+     * @brief True once at least one plugin is loaded
+     */
+    static inline bool active() {
+        return s_active;
+    }
+
+    /**
+     * @brief Load and install a plugin; the harts must be registered by then
+     * @param spec "path/lib.so[,arg[,arg...]]"
+     * @param xlen 32 or 64
+     * @return false if the library could not be loaded or refused to install
+     */
+    bool load(const std::string &spec, unsigned int xlen);
+
+    /**
+     * @brief Register a hart; must be called before plugins are loaded
+     * @return hart index passed back to the hooks
+     */
+    unsigned int registerHart(HartAccess access);
+
+    /**
+     * @brief Hook: instruction at @p pc is about to execute
+     */
+    void onInsnExec(unsigned int hart, std::uint64_t pc, std::uint32_t insn);
+
+    /**
+     * @brief Hook: data access made by the executing instruction
+     */
+    inline void onMemAccess(std::uint64_t addr, unsigned int size, bool is_store) {
+        if (current_hart >= harts.size()) {
+            return;
+        }
+        rvvp_plugin_insn *insn = harts[current_hart].cur;
+        if (insn != nullptr && !insn->mem_cbs.empty()) {
+            for (auto const &m : insn->mem_cbs) {
+                m.cb(current_hart, addr, size, is_store ? 1 : 0, m.udata);
+            }
+        }
+    }
+
+    /**
+     * @brief Hook: synchronous exception on the executing hart
+     */
+    void onTrap(std::uint64_t cause, std::uint64_t pc);
+
+    /**
+     * @brief Hook: interrupt taken (cause and EPC are read from the hart CSRs)
+     */
+    void onInterrupt(unsigned int hart);
+
+    /**
+     * @brief Run at-exit callbacks and unload all plugins
+     */
+    void shutdown();
+
+    /* Used by the C API in PluginManager.cpp */
+    struct Plugin {
+        void *handle{nullptr};
+        std::string path;
+        rvvp_plugin_tb_trans_cb_t tb_trans{nullptr};
+        rvvp_plugin_trap_cb_t trap{nullptr};
+        rvvp_plugin_roi_cb_t roi{nullptr};
+        std::vector<std::pair<rvvp_plugin_atexit_cb_t, void *>> atexit;
+    };
+
+    Plugin *plugin(rvvp_plugin_id_t id);
+    rvvp_plugin_scratch *newScratch(size_t size);
+    void *scratchFor(rvvp_plugin_scratch *scratch, unsigned int hart);
+    std::uint64_t readRegister(unsigned int hart, unsigned int reg) const;
+    unsigned int numHarts() const {
+        return static_cast<unsigned int>(harts.size());
+    }
+
+private:
+    PluginManager() = default;
+
+    struct Hart {
+        HartAccess access;
+        rvvp_plugin_tb *tb{nullptr};
+        std::size_t next{0};
+        rvvp_plugin_insn *cur{nullptr};
+    };
+
+    rvvp_plugin_tb *translate(unsigned int hart, std::uint64_t pc, std::uint32_t insn);
+    void execute(unsigned int hart, rvvp_plugin_insn &insn);
+    void releaseStaleBlocks();  ///< free the replaced blocks no hart is in any more
+
+    static bool s_active;
+    static PluginManager *instance;
+
+    static constexpr std::size_t MAX_TB_INSNS = 64;
+
+    std::vector<Plugin> plugins;
+    std::vector<Hart> harts;
+    unsigned int current_hart{0};
+    std::unordered_map<std::uint64_t, std::unique_ptr<rvvp_plugin_tb>> tb_cache;
+    std::vector<std::unique_ptr<rvvp_plugin_tb>> stale_tbs; ///< replaced blocks a hart may still point into
+    std::vector<std::unique_ptr<rvvp_plugin_scratch>> scratches;
+};
+
+} // namespace riscv_tlm
+
+#endif // PLUGIN_MANAGER_H
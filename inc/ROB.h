@@ -26,6 +26,10 @@ struct ROBEntry {
     bool is_branch{false};          // Is this a branch/jump instruction?
     bool exception{false};          // Did an exception occur?
     uint64_t pc{0};                 // PC of this instruction (for debugging/exceptions)
+    bool retire{true};              // Counts as a retired instruction (false for all but the last micro-op)
+    uint32_t encoding{0};           // Instruction as fetched (for the plugin hooks)
+    uint64_t mem_addr{0};           // Data access of a load/store (for the plugin hooks)
+    uint8_t mem_size{0};            // Bytes accessed, 0 if none
 };
 
 /**
@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file RegisterBank.h
+ * @brief Table-driven register file of a memory-mapped peripheral
+ *
+ * A peripheral describes its registers once, in its constructor:
+ *
+ *     regs.add("mtimecmp", MTIMECMP, 8);
+ *     regs.add("priority", 0x4, 4).array(sources - 1, 4).mask(7)
+ *         .onWrite([this](unsigned int i, std::uint64_t value) { ... });
+ *
+ * and forwards its b_transport and get_direct_mem_ptr to access() and dmi().
+ *
+ * Each register is 4 or 8 bytes at a 4-byte aligned offset and may be an
+ * array. Its bits follow an access policy (RW, RO, WO, W1C), for the whole
+ * register or per field; bits outside mask() are not implemented and read
+ * as 0. The value is kept in the bank, in a little-endian image of the
+ * window: a read returns it unless the register has an onRead() callback
+ * (a computed value, or a read with side effects), and a write applies the
+ * policies to it and then calls onWrite() with the result. The device
+ * changes what software sees with set().
+ *
+ * Decoding is direct: the window is split in 4 KB pages, and each page that
+ * holds registers has a table with the register of every 4-byte slot and
+ * its part of the image. Any access of 1, 2, 4 or 8 bytes the bank allows
+ * may cover part of a register or two 4-byte registers.
+ *
+ * Registers without onRead() are side-effect free, so dmi() grants
+ * read-only direct access to the image around them; BusCtrl serves reads
+ * from there without calling the peripheral.
+ */
+#pragma once
+#ifndef INC_REGISTERBANK_H_
+#define INC_REGISTERBANK_H_
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tlm.h"
+
+namespace riscv_tlm { namespace peripherals {
+
+enum class Access : std::uint8_t {
+    RW,     ///< read-write
+    RO,     ///< writes ignored
+    WO,     ///< reads as 0, written value only passed to onWrite()
+    W1C     ///< writing 1 clears the bit, writing 0 leaves it
+};
+
+class RegisterBank {
+public:
+    using ReadFn = std::function<std::uint64_t(unsigned int index)>;
+    using WriteFn = std::function<void(unsigned int index, std::uint64_t value)>;
+
+    /** Access sizes a bank accepts, as a mask of byte counts */
+    static constexpr unsigned int BYTE = 1, HALF = 2, WORD = 4, DWORD = 8;
+
+    /**
+     * @brief A register, or an array of them, as the table describes it
+     */
+    class Register {
+    public:
+        /**
+         * @brief @p count registers, @p stride bytes apart (default: packed); onRead/onWrite get the index
+         */
+        Register &array(unsigned int count, std::uint64_t stride = 0) {
+            m_count = count;
+            m_stride = stride;
+            return *this;
+        }
+
+        Register &reset(std::uint64_t value) {
+            m_reset = value;
+            return *this;
+        }
+
+        /**
+         * @brief Implemented bits
+         */
+        Register &mask(std::uint64_t bits) {
+            m_mask = bits;
+            return *this;
+        }
+
+        /**
+         * @brief Bits [@p lsb, @p lsb + @p width) with their own policy
+         */
+        Register &field(const char *name, unsigned int lsb, unsigned int width, Access access) {
+            m_fields.push_back({name, lsb, width, access});
+            return *this;
+        }
+
+        Register &onRead(ReadFn fn) {
+            m_read = std::move(fn);
+            return *this;
+        }
+
+        Register &onWrite(WriteFn fn) {
+            m_write = std::move(fn);
+            return *this;
+        }
+
+    private:
+        friend class RegisterBank;
+
+        struct Field {
+            const char *name;
+            unsigned int lsb;
+            unsigned int width;
+            Access access;
+        };
+
+        Register(const char *name, std::uint64_t offset, unsigned int bytes, Access access)
+            : m_name(name), m_offset(offset), m_bytes(bytes), m_access(access) {
+        }
+
+        std::string m_name;
+        std::uint64_t m_offset;
+        unsigned int m_bytes;
+        Access m_access;
+        unsigned int m_count{1};
+        std::uint64_t m_stride{0};
+        std::uint64_t m_reset{0};
+        std::uint64_t m_mask{~0ULL};
+        std::vector<Field> m_fields;
+        ReadFn m_read;
+        WriteFn m_write;
+
+        /* policy masks, from access, mask and fields when the bank is built */
+        std::uint64_t m_rw{0};
+        std::uint64_t m_wo{0};
+        std::uint64_t m_w1c{0};
+        std::uint64_t m_implemented{0};
+    };
+
+    /**
+     * @param size bytes of the window, offsets 0 to size - 1
+     * @param sizes access sizes accepted (BYTE | HALF | WORD | DWORD), naturally aligned
+     * @param strict unmapped offsets answer TLM_ADDRESS_ERROR_RESPONSE instead of reading 0
+     */
+    explicit RegisterBank(std::uint64_t size, unsigned int sizes = BYTE | HALF | WORD | DWORD, bool strict = false)
+        : m_size(size), m_sizes(sizes), m_strict(strict) {
+    }
+
+    RegisterBank(const RegisterBank &) = delete;
+    RegisterBank &operator=(const RegisterBank &) = delete;
+
+    /**
+     * @brief Describe a register of @p bytes (4 or 8) at @p offset
+     */
+    Register &add(const char *name, std::uint64_t offset, unsigned int bytes = 4, Access access = Access::RW) {
+        m_built = false;
+        m_table.push_back(Register(name, offset, bytes, access));
+        return m_table.back();
+    }
+
+    /**
+     * @brief Device side: value of the register at @p offset, without onRead()
+     */
+    std::uint64_t get(std::uint64_t offset) {
+        const Entry &entry = at(offset);
+        return load(entry);
+    }
+
+    /**
+     * @brief Device side: set the register at @p offset, without policies or onWrite()
+     */
+    void set(std::uint64_t offset, std::uint64_t value) {
+        const Entry &entry = at(offset);
+        store(entry, value & m_table[entry.reg].m_implemented & ~m_table[entry.reg].m_wo);
+    }
+
+    /**
+     * @brief b_transport of the window: decode, apply the policies and call back
+     */
+    void access(tlm::tlm_generic_payload &trans);
+
+    /**
+     * @brief get_direct_mem_ptr of the window: read-only access to the image
+     *        around side-effect free registers, or the range that has none
+     */
+    bool dmi(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi_data);
+
+private:
+    static constexpr std::uint64_t PAGE_SIZE = 4096;
+    static constexpr unsigned int SLOTS = PAGE_SIZE / 4;
+
+    /** One register of an array */
+    struct Entry {
+        std::uint64_t offset;
+        std::uint32_t reg;          ///< in m_table
+        std::uint32_t index;        ///< in its array
+        unsigned char *image;       ///< its bytes
+    };
+
+    struct Page {
+        std::array<std::uint32_t, SLOTS> slot{};    ///< entry + 1, 0 if unmapped
+        std::array<unsigned char, PAGE_SIZE> image{};
+    };
+
+    void build();
+
+    /**
+     * @brief Entry whose slot holds @p offset, or nullptr
+     */
+    const Entry *decode(std::uint64_t offset) const {
+        std::int32_t page = m_page_of[offset / PAGE_SIZE];
+        if (page < 0) {
+            return nullptr;
+        }
+        std::uint32_t slot = m_pages[page]->slot[(offset % PAGE_SIZE) / 4];
+        return slot != 0 ? &m_entries[slot - 1] : nullptr;
+    }
+
+    const Entry &at(std::uint64_t offset);
+
+    bool readable(std::int32_t page, unsigned int slot) const;
+
+    std::uint64_t load(const Entry &entry) const;
+
+    void store(const Entry &entry, std::uint64_t value);
+
+    std::uint64_t read(const Entry &entry);
+
+    void write(const Entry &entry, std::uint64_t data, std::uint64_t bytes);
+
+    const std::uint64_t m_size;
+    const unsigned int m_sizes;
+    const bool m_strict;
+
+    std::deque<Register> m_table;           ///< stable references for the add() chains
+    bool m_built{false};
+    std::vector<Entry> m_entries;
+    std::vector<std::int32_t> m_page_of;    ///< page of the window -> m_pages, -1 if no registers
+    std::vector<std::unique_ptr<Page>> m_pages;
+};
+
+}} // namespace
+
+#endif /* INC_REGISTERBANK_H_ */
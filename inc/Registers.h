@@ -17,17 +17,26 @@
 #include "systemc"
 #include "tlm.h"
 
+#include "ClockDomains.h"
+#include "ExecutionHistory.h"
 #include "Performance.h"
 #include "Memory.h"
+#include "MMU.h"
+#include "PMP.h"
+#include "CLIC.h"
 
 namespace riscv_tlm {
 
 #define MISA_A_EXTENSION (1 << 0)
 #define MISA_B_EXTENSION (1 << 1)
 #define MISA_C_EXTENSION (1 << 2)
+#define MISA_D_EXTENSION (1 << 3)
+#define MISA_F_EXTENSION (1 << 5)
 #define MISA_I_BASE (1 << 8)
 #define MISA_M_EXTENSION (1 << 12)
+#define MISA_V_EXTENSION (1 << 21)
 #define MISA_MXL (1 << 30)
+#define MISA_EXTENSIONS_MASK (0x03FFFFFF)
 
 #define CSR_MVENDORID (0xF11)
 #define CSR_MARCHID (0xF12)
@@ -35,6 +44,10 @@ namespace riscv_tlm {
 #define CSR_MHARTID (0xF14)
 
 #define CSR_USTATUS (0x000)
+#define CSR_FFLAGS (0x001)
+#define CSR_FRM (0x002)
+#define CSR_FCSR (0x003)
+#define CSR_JVT (0x017)
 #define CSR_SSTATUS (0x100)
 #define CSR_SEDELEG (0x102)
 
@@ -45,6 +58,7 @@ namespace riscv_tlm {
 #define CSR_MIE (0x304)
 #define CSR_MTVEC (0x305)
 #define CSR_MCOUNTEREN (0x306)
+#define CSR_MTVT (0x307)
 #define CSR_MSTATUSH (0x310)
 
 #define CSR_MSCRATCH (0x340)
@@ -52,6 +66,9 @@ namespace riscv_tlm {
 #define CSR_MCAUSE (0x342)
 #define CSR_MTVAL (0x343)
 #define CSR_MIP (0x344)
+#define CSR_MNXTI (0x345)
+#define CSR_MINTTHRESH (0x347)
+#define CSR_MINTSTATUS (0xFB1)
 
 #define CSR_SSCRATCH (0x140)
 #define CSR_SEPC (0x141)
@@ -73,6 +90,15 @@ namespace riscv_tlm {
 #define CSR_INSTRETH (0xC02)
 
 #define CSR_STVEC (0x105)
+#define CSR_SATP (0x180)
+
+#define CSR_VSTART (0x008)
+#define CSR_VXSAT (0x009)
+#define CSR_VXRM (0x00A)
+#define CSR_VCSR (0x00F)
+#define CSR_VL (0xC20)
+#define CSR_VTYPE (0xC21)
+#define CSR_VLENB (0xC22)
 
 #define MSTATUS_UIE (1 << 0)
 #define MSTATUS_SIE (1 << 1)
@@ -82,7 +108,14 @@ namespace riscv_tlm {
 #define MSTATUS_MPIE (1 << 7)
 #define MSTATUS_SPP (1 << 8)
 #define MSTATUS_MPP (1 << 11)
+#define MSTATUS_MPP_MASK (3 << 11)
+#define MSTATUS_VS_MASK (3 << 9)
+#define MSTATUS_VS_INITIAL (1 << 9)
+#define MSTATUS_VS_DIRTY (3 << 9)
 #define MSTATUS_FS  (1 << 13)
+#define MSTATUS_FS_MASK (3 << 13)
+#define MSTATUS_FS_INITIAL (1 << 13)
+#define MSTATUS_FS_DIRTY (3 << 13)
 #define MSTATUS_XS    (1 << 15)
 #define MSTATUS_MPRV (1 << 17)
 #define MSTATUS_SUM (1 << 18)
@@ -91,6 +124,10 @@ namespace riscv_tlm {
 #define MSTATUS_TW (1 << 21)
 #define MSTATUS_TSR (1 << 22)
 
+/* mstatus fields visible through sstatus (SD is added on read) */
+#define SSTATUS_MASK (MSTATUS_SIE | MSTATUS_SPIE | MSTATUS_SPP | MSTATUS_VS_MASK | MSTATUS_FS_MASK \
+                      | (3 << 15) | MSTATUS_SUM | MSTATUS_MXR)
+
 #define MIP_USIP (1 << 0)
 #define MIP_SSIP (1 << 1)
 #define MIP_MSIP (1 << 3)
@@ -111,9 +148,27 @@ namespace riscv_tlm {
 #define MIE_SEIE (1 << 9)
 #define MIE_MEIE (1 << 11)
 
-/* 1 ns tick in CYCLE & TIME counters */
+/* xtvec.MODE; CLIC mode is only accepted with a CLIC attached */
+#define MTVEC_MODE_VECTORED (1)
+#define MTVEC_MODE_CLIC (3)
+
+/* mcause fields in CLIC mode (MPP and MPIE alias mstatus) */
+#define MCAUSE_MINHV (1 << 30)
+#define MCAUSE_MPP_SHIFT (28)
+#define MCAUSE_MPIE (1 << 27)
+#define MCAUSE_MPIL_SHIFT (16)
+#define MCAUSE_EXCCODE_MASK (0xFFF)
+
+/* Default tick rate of mtime and the TIME counters (the peripheral clock domain) */
 #define TICKS_PER_SECOND (1000000)
 
+    typedef enum {
+        User = 0,
+        Supervisor = 1,
+        Reserved = 2,
+        Machine = 3,
+    } PrivilegeMode;
+
 /**
  * @brief Register file implementation
  */
@@ -227,6 +282,13 @@ namespace riscv_tlm {
             }
         }
 
+        /**
+         * @brief x0..x31 in place, for translated code (AotAPI.h), which never writes x0
+         */
+        T *rawValues() {
+            return register_bank.data();
+        }
+
         /**
          * Returns PC value
          * @return PC value
@@ -265,31 +327,56 @@ namespace riscv_tlm {
             switch (csr) {
                 case CSR_CYCLE:
                 case CSR_MCYCLE:
-                    ret_value = static_cast<std::uint64_t>(sc_core::sc_time(
-                            sc_core::sc_time_stamp()
-                            - sc_core::sc_time(sc_core::SC_ZERO_TIME)).to_double())
-                                & 0x00000000FFFFFFFF;
+                    ret_value = coreCycles() & 0x00000000FFFFFFFF;
                     break;
                 case CSR_CYCLEH:
                 case CSR_MCYCLEH:
-                    ret_value = static_cast<std::uint32_t>((std::uint64_t) (sc_core::sc_time(
-                            sc_core::sc_time_stamp()
-                            - sc_core::sc_time(sc_core::SC_ZERO_TIME)).to_double())
-                                                                   >> 32 & 0x00000000FFFFFFFF);
+                    ret_value = static_cast<std::uint32_t>(coreCycles() >> 32 & 0x00000000FFFFFFFF);
                     break;
                 case CSR_TIME:
-                    ret_value = static_cast<std::uint64_t>(sc_core::sc_time(
-                            sc_core::sc_time_stamp()
-                            - sc_core::sc_time(sc_core::SC_ZERO_TIME)).to_double())
-                                & 0x00000000FFFFFFFF;
+                    ret_value = timeNow() & 0x00000000FFFFFFFF;
                     break;
                 case CSR_TIMEH:
-                    ret_value = static_cast<std::uint32_t>((std::uint64_t) (sc_core::sc_time(
-                            sc_core::sc_time_stamp()
-                            - sc_core::sc_time(sc_core::SC_ZERO_TIME)).to_double())
-                                                                   >> 32 & 0x00000000FFFFFFFF);
+                    ret_value = static_cast<std::uint32_t>(timeNow() >> 32 & 0x00000000FFFFFFFF);
+                    break;
+                case CSR_FFLAGS:
+                    ret_value = CSR[CSR_FCSR] & 0x1F;
+                    break;
+                case CSR_FRM:
+                    ret_value = (CSR[CSR_FCSR] >> 5) & 0x7;
+                    break;
+                case CSR_FCSR:
+                    ret_value = CSR[CSR_FCSR] & 0xFF;
+                    break;
+                case CSR_MSTATUS:
+                    ret_value = CSR[CSR_MSTATUS];
+                    /* SD summarizes a dirty FS or VS */
+                    if ((ret_value & MSTATUS_FS_MASK) == MSTATUS_FS_DIRTY
+                        || (ret_value & MSTATUS_VS_MASK) == MSTATUS_VS_DIRTY) {
+                        ret_value |= static_cast<T>(1) << (sizeof(T) * 8 - 1);
+                    }
+                    break;
+                case CSR_SSTATUS:
+                    ret_value = getCSR(CSR_MSTATUS)
+                                & (SSTATUS_MASK | static_cast<T>(1) << (sizeof(T) * 8 - 1));
+                    break;
+                case CSR_SATP:
+                    ret_value = satp;
+                    break;
+                case CSR_MCAUSE:
+                    ret_value = CSR[CSR_MCAUSE];
+                    if (clicMode()) {
+                        const T status = CSR[CSR_MSTATUS];
+                        ret_value = (ret_value & ~static_cast<T>((3 << MCAUSE_MPP_SHIFT) | MCAUSE_MPIE))
+                                    | (((status >> 11) & 3) << MCAUSE_MPP_SHIFT)
+                                    | ((status & MSTATUS_MPIE) ? MCAUSE_MPIE : 0);
+                    }
                     break;
                     [[likely]] default:
+                    if (PMP::isPMPCSR(csr)) [[unlikely]] {
+                        ret_value = pmp != nullptr ? static_cast<T>(pmp->readCSR(csr)) : 0;
+                        break;
+                    }
                     ret_value = CSR[csr];
                     break;
             }
@@ -305,11 +392,328 @@ namespace riscv_tlm {
             /* @FIXME: rv32mi-p-ma_fetch tests doesn't allow MISA to be writable,
              * but Volume II: Privileged Architecture v1.10 says MISA is writable (?)
              */
-            if (csr != CSR_MISA) {
-                CSR[csr] = value;
+            switch (csr) {
+                case CSR_MISA:
+                    break;
+                case CSR_FFLAGS:
+                    CSR[CSR_FCSR] = (CSR[CSR_FCSR] & ~0x1FU) | (value & 0x1F);
+                    setFPDirty();
+                    break;
+                case CSR_FRM:
+                    CSR[CSR_FCSR] = (CSR[CSR_FCSR] & 0x1F) | ((value & 0x7) << 5);
+                    setFPDirty();
+                    break;
+                case CSR_FCSR:
+                    CSR[CSR_FCSR] = value & 0xFF;
+                    setFPDirty();
+                    break;
+                case CSR_VSTART:
+                case CSR_VXSAT:
+                case CSR_VXRM:
+                case CSR_VCSR:
+                    CSR[csr] = value;
+                    setVectorDirty();
+                    break;
+                case CSR_MSTATUS:
+                    /* SD is read-only, derived from FS and VS */
+                    CSR[csr] = value & ~(static_cast<T>(1) << (sizeof(T) * 8 - 1));
+                    syncMemoryUnits();
+                    break;
+                case CSR_SSTATUS:
+                    CSR[CSR_MSTATUS] = (CSR[CSR_MSTATUS] & ~static_cast<T>(SSTATUS_MASK))
+                                       | (value & SSTATUS_MASK);
+                    syncMemoryUnits();
+                    break;
+                case CSR_SATP:
+                    /* WARL, and read-only zero without an MMU */
+                    if (mmu != nullptr && MMU::satpModeSupported(value, sizeof(T) == 8)) {
+                        satp = value;
+                        syncMemoryUnits();
+                    }
+                    break;
+                case CSR_MTVEC:
+                    if ((value & 3) == MTVEC_MODE_CLIC && clic == nullptr) {
+                        value &= ~static_cast<T>(3);
+                    }
+                    CSR[csr] = value;
+                    break;
+                case CSR_MTVT:
+                case CSR_JVT:
+                    /* 64-byte aligned tables; jvt.mode only supports the jump table mode 0 */
+                    CSR[csr] = value & ~static_cast<T>(63);
+                    break;
+                case CSR_MCAUSE:
+                    CSR[csr] = value;
+                    if (clicMode()) {
+                        /* restoring mcause before mret restores the previous context */
+                        CSR[CSR_MSTATUS] = (CSR[CSR_MSTATUS] & ~static_cast<T>(MSTATUS_MPP_MASK | MSTATUS_MPIE))
+                                           | (((value >> MCAUSE_MPP_SHIFT) & 3) << 11)
+                                           | ((value & MCAUSE_MPIE) ? MSTATUS_MPIE : 0);
+                        syncMemoryUnits();
+                    }
+                    break;
+                case CSR_MINTTHRESH:
+                    CSR[csr] = value & 0xFF;
+                    break;
+                case CSR_MINTSTATUS:
+                case CSR_MNXTI:
+                    /* read-only; mnxti is handled by the CSR instructions */
+                    break;
+                [[likely]] default:
+                    if (PMP::isPMPCSR(csr)) [[unlikely]] {
+                        /* cached translations carry host pointers checked against the old regions */
+                        if (pmp != nullptr && pmp->writeCSR(csr, value)) {
+                            syncMemoryUnits();
+                            if (mmu != nullptr) {
+                                mmu->flush();
+                            }
+                        }
+                        break;
+                    }
+                    CSR[csr] = value;
+                    break;
             }
         }
 
+        /**
+         * @brief Raw FP register value (single precision values are NaN-boxed)
+         * @param reg_num register number
+         * @return 64-bit register contents
+         */
+        std::uint64_t getFPValue(unsigned int reg_num) const {
+            perf->registerRead();
+            return fp_bank[reg_num & 0x1F];
+        }
+
+        /**
+         * @brief Write a FP register, marking the FP state dirty
+         * @param reg_num register number
+         * @param value 64-bit register contents
+         */
+        void setFPValue(unsigned int reg_num, std::uint64_t value) {
+            fp_bank[reg_num & 0x1F] = value;
+            perf->registerWrite();
+            setFPDirty();
+        }
+
+        /**
+         * @brief FP instructions are illegal while mstatus.FS is Off
+         */
+        bool isFPEnabled() {
+            return (CSR[CSR_MSTATUS] & MSTATUS_FS_MASK) != 0;
+        }
+
+        /**
+         * @brief Vector instructions are illegal while mstatus.VS is Off
+         */
+        bool isVectorEnabled() {
+            return (CSR[CSR_MSTATUS] & MSTATUS_VS_MASK) != 0;
+        }
+
+        void setVectorDirty() {
+            CSR[CSR_MSTATUS] |= MSTATUS_VS_DIRTY;
+        }
+
+        /**
+         * @brief Set the extension bits of misa to what the CPU model's decoders
+         *        execute. FS and VS start Initial when F/D and V are present, Off otherwise.
+         * @param extensions MISA_*_EXTENSION bits and MISA_I_BASE
+         */
+        void setExtensions(std::uint32_t extensions) {
+            CSR[CSR_MISA] = (CSR[CSR_MISA] & ~static_cast<T>(MISA_EXTENSIONS_MASK)) | extensions;
+            CSR[CSR_MSTATUS] &= ~static_cast<T>(MSTATUS_FS_MASK | MSTATUS_VS_MASK);
+            if ((extensions & (MISA_F_EXTENSION | MISA_D_EXTENSION)) != 0) {
+                CSR[CSR_MSTATUS] |= MSTATUS_FS_INITIAL;
+            }
+            if ((extensions & MISA_V_EXTENSION) != 0) {
+                CSR[CSR_MSTATUS] |= MSTATUS_VS_INITIAL;
+            }
+        }
+
+        /**
+         * @brief OR exception flags into fflags
+         */
+        void accrueFPFlags(unsigned int flags) {
+            if (flags != 0) {
+                CSR[CSR_FCSR] |= flags & 0x1F;
+                setFPDirty();
+            }
+        }
+
+        unsigned int getFRM() {
+            return (CSR[CSR_FCSR] >> 5) & 0x7;
+        }
+
+        PrivilegeMode getPrivilege() const {
+            return privilege;
+        }
+
+        void setPrivilege(PrivilegeMode mode) {
+            privilege = mode;
+            syncMemoryUnits();
+        }
+
+        /**
+         * @brief Connect the MMU that satp, mstatus and the privilege drive
+         */
+        void attachMMU(MMU *mmu_unit) {
+            mmu = mmu_unit;
+            syncMemoryUnits();
+        }
+
+        /**
+         * @brief Connect the PMP behind the pmpcfg/pmpaddr CSRs
+         */
+        void attachPMP(PMP *pmp_unit) {
+            pmp = pmp_unit;
+            syncMemoryUnits();
+        }
+
+        /**
+         * @brief Connect the CLIC that mnxti queries; enables mtvec.MODE = 3
+         */
+        void attachCLIC(CLIC *clic_unit) {
+            clic = clic_unit;
+        }
+
+        bool clicMode() const {
+            auto it = CSR.find(CSR_MTVEC);
+            return it != CSR.end() && (it->second & 3) == MTVEC_MODE_CLIC;
+        }
+
+        /**
+         * @brief Current interrupt level (mintstatus.mil)
+         */
+        unsigned int getInterruptLevel() const {
+            auto it = CSR.find(CSR_MINTSTATUS);
+            return it != CSR.end() ? static_cast<unsigned int>((it->second >> 24) & 0xFF) : 0;
+        }
+
+        void setInterruptLevel(unsigned int level) {
+            CSR[CSR_MINTSTATUS] = static_cast<T>(level & 0xFF) << 24;
+        }
+
+        /**
+         * @brief Handler address for a trap to the mode whose xtvec is @p tvec_csr
+         * @param cause exception or interrupt code
+         * @param interrupt true for interrupts (vectored mode adds 4 * cause)
+         */
+        T trapVector(int tvec_csr, T cause, bool interrupt) {
+            const T tvec = CSR[tvec_csr];
+            switch (tvec & 3) {
+                case MTVEC_MODE_VECTORED:
+                    return (tvec & ~static_cast<T>(3)) + (interrupt ? 4 * cause : 0);
+                case MTVEC_MODE_CLIC:
+                    return tvec & ~static_cast<T>(63);
+                default:
+                    return tvec & ~static_cast<T>(3);
+            }
+        }
+
+        /**
+         * @brief mcause of an M-mode trap; in CLIC mode it also records the
+         *        interrupted level in mpil
+         */
+        T machineCause(T cause) {
+            if (clicMode()) {
+                cause |= static_cast<T>(getInterruptLevel()) << MCAUSE_MPIL_SHIFT;
+            }
+            return cause;
+        }
+
+        /**
+         * @brief Access to mnxti: update mstatus like csrrs/csrrc, then return the
+         *        mtvt entry of a pending non-vectored interrupt above the
+         *        interrupted level and mintthresh, or 0
+         *
+         * When @p write, the interrupt is also claimed: mil and mcause.exccode
+         * take its level and id, and an edge-triggered interrupt is cleared.
+         */
+        T nextInterrupt(T mask, bool clear, bool write) {
+            if (write) {
+                T status = getCSR(CSR_MSTATUS);
+                setCSR(CSR_MSTATUS, clear ? status & ~mask : status | mask);
+            }
+            if (clic == nullptr || !clicMode() || !clic->pending()) {
+                return 0;
+            }
+
+            const CLIC::Request &req = clic->request();
+            const unsigned int mpil = (CSR[CSR_MCAUSE] >> MCAUSE_MPIL_SHIFT) & 0xFF;
+            if (req.shv || req.level <= mpil || req.level <= (CSR[CSR_MINTTHRESH] & 0xFF)) {
+                return 0;
+            }
+
+            const std::uint32_t id = req.id;
+            if (write) {
+                setInterruptLevel(req.level);
+                CSR[CSR_MCAUSE] = (CSR[CSR_MCAUSE] & ~static_cast<T>(MCAUSE_EXCCODE_MASK)) | id;
+                clic->acknowledge(id);
+            }
+            return CSR[CSR_MTVT] + static_cast<T>(id) * sizeof(T);
+        }
+
+        /**
+         * @brief Trap entry: stack xIE and the current privilege in mstatus, enter @p target
+         */
+        void enterTrap(PrivilegeMode target) {
+            T status = CSR[CSR_MSTATUS];
+            if (target == Machine) {
+                status = (status & ~static_cast<T>(MSTATUS_MPP_MASK | MSTATUS_MPIE | MSTATUS_MIE))
+                         | (static_cast<T>(privilege) << 11)
+                         | ((status & MSTATUS_MIE) ? MSTATUS_MPIE : 0);
+            } else {
+                status = (status & ~static_cast<T>(MSTATUS_SPP | MSTATUS_SPIE | MSTATUS_SIE))
+                         | (privilege == Supervisor ? MSTATUS_SPP : 0)
+                         | ((status & MSTATUS_SIE) ? MSTATUS_SPIE : 0);
+            }
+            CSR[CSR_MSTATUS] = status;
+            setPrivilege(target);
+        }
+
+        /**
+         * @brief MRET (@p from Machine) or SRET: unstack xIE and the privilege
+         */
+        void returnFromTrap(PrivilegeMode from) {
+            T status = CSR[CSR_MSTATUS];
+            PrivilegeMode target;
+            if (from == Machine) {
+                if (clicMode()) {
+                    setInterruptLevel((CSR[CSR_MCAUSE] >> MCAUSE_MPIL_SHIFT) & 0xFF);
+                }
+                target = static_cast<PrivilegeMode>((status >> 11) & 3);
+                status = (status & ~static_cast<T>(MSTATUS_MPP_MASK | MSTATUS_MIE))
+                         | ((status & MSTATUS_MPIE) ? MSTATUS_MIE : 0) | MSTATUS_MPIE;
+            } else {
+                target = (status & MSTATUS_SPP) ? Supervisor : User;
+                status = (status & ~static_cast<T>(MSTATUS_SPP | MSTATUS_SIE))
+                         | ((status & MSTATUS_SPIE) ? MSTATUS_SIE : 0) | MSTATUS_SPIE;
+            }
+            if (target != Machine) {
+                status &= ~static_cast<T>(MSTATUS_MPRV);
+            }
+            CSR[CSR_MSTATUS] = status;
+            setPrivilege(target);
+        }
+
+        /**
+         * @brief Copy the architectural state of @p saved (reverse execution)
+         *
+         * The attached MMU, PMP and CLIC stay; cached translations are dropped.
+         */
+        void restoreFrom(const Registers &saved) {
+            register_bank = saved.register_bank;
+            fp_bank = saved.fp_bank;
+            register_PC = saved.register_PC;
+            CSR = saved.CSR;
+            satp = saved.satp;
+            privilege = saved.privilege;
+            if (mmu != nullptr) {
+                mmu->flush();
+            }
+            syncMemoryUnits();
+        }
+
         /**
          * Dump register data to console
          */
@@ -321,6 +725,11 @@ namespace riscv_tlm {
          */
         std::array<T, 32> register_bank = {{0}};
 
+        /**
+         * FP registers (F and D extensions, FLEN = 64)
+         */
+        std::array<std::uint64_t, 32> fp_bank = {{0}};
+
         /**
          * Program counter (32 bits width)
          */
@@ -329,11 +738,50 @@ namespace riscv_tlm {
         /**
          * CSR registers (4096 maximum)
          */
-        std::unordered_map<T, unsigned int> CSR;
+        std::unordered_map<T, T> CSR;
+
+        T satp{0};
+        PrivilegeMode privilege{Machine};
+        MMU *mmu{nullptr};
+        PMP *pmp{nullptr};
+        CLIC *clic{nullptr};
 
         Performance *perf;
 
         void initCSR();
+
+        /**
+         * @brief Cycles of the core clock domain (nanoseconds when there are no domains)
+         */
+        static std::uint64_t coreCycles() {
+            ClockDomains *clocks = ClockDomains::getInstance();
+            if (clocks->created()) {
+                return ExecutionHistory::input(clocks->core().cycles());
+            }
+            return ExecutionHistory::input(
+                    static_cast<std::uint64_t>(sc_core::sc_time_stamp() / sc_core::sc_time(1, sc_core::SC_NS)));
+        }
+
+        /**
+         * @brief mtime of the CLINT, which the time CSRs shadow; replayed from
+         *        the recording while the debugger re-executes
+         */
+        static std::uint64_t timeNow() {
+            return ExecutionHistory::input(ClockDomains::getInstance()->mtime());
+        }
+
+        void setFPDirty() {
+            CSR[CSR_MSTATUS] |= MSTATUS_FS_DIRTY;
+        }
+
+        void syncMemoryUnits() {
+            if (mmu != nullptr) {
+                mmu->setState(satp, CSR[CSR_MSTATUS], privilege);
+            }
+            if (pmp != nullptr) {
+                pmp->setState(CSR[CSR_MSTATUS], privilege);
+            }
+        }
     };
 }
 #endif
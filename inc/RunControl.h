@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file RunControl.h
+ * @brief Exact stop and pause conditions checked on the retire path
+ *
+ * CPU models report every retired instruction through CPU::runControlRetire(),
+ * which costs one predictable branch while no condition is set. Each
+ * condition is a single comparison against the retired instruction:
+ *  - instr=N      the N-th instruction retired (counted from the start of the run)
+ *  - cycle=N      the first instruction retired at or after cycle N (once)
+ *  - pc=A         the instruction at A retired (A may be a symbol)
+ *  - enter=SYM    the first instruction of SYM retired
+ *  - exit=SYM     the first instruction at the return address of SYM retired
+ *  - write=A[+L]  an instruction that wrote to [A, A+L) retired
+ * A condition that fires calls sc_pause() or sc_stop() before the next
+ * instruction retires, so the host regains control exactly at the boundary
+ * and resumes with another sc_start().
+ */
+#pragma once
+#ifndef INC_RUNCONTROL_H_
+#define INC_RUNCONTROL_H_
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace riscv_tlm {
+
+    class RunControl {
+    public:
+        enum class Action {
+            Pause,      ///< sc_pause(): sc_start() returns and may be called again
+            Stop        ///< sc_stop(): end of simulation
+        };
+
+        /**
+         * @brief A condition that fired
+         */
+        struct Hit {
+            std::string condition;      ///< as given to add()
+            Action action{Action::Pause};
+            std::uint64_t instructions{0};  ///< retired instructions, including this one
+            std::uint64_t cycle{0};
+            std::uint64_t pc{0};        ///< address of the retired instruction
+        };
+
+        static RunControl *getInstance();
+
+        /**
+         * @brief True while at least one condition is set
+         */
+        static bool armed() {
+            return s_armed;
+        }
+
+        /**
+         * @brief True while a write=... condition is set
+         */
+        static bool watchesWrites() {
+            return s_watch_writes;
+        }
+
+        /**
+         * @brief Read the symbol table of an ELF file for pc=, enter=, exit= and write=
+         * @return false with @p error set if the file is not a readable ELF file
+         */
+        bool loadSymbols(const std::string &elf_path, std::string &error);
+
+        /**
+         * @brief Add a condition such as "instr=1000000" or "enter=main"
+         * @return false with @p error set on a malformed spec or unknown symbol
+         */
+        bool add(const std::string &spec, Action action, std::string &error);
+
+        void clear();
+
+        /**
+         * @brief Retire hook
+         * @param pc address of the retired instruction
+         * @param cycle current cycle of the model
+         * @param ra return address register, for enter=/exit=
+         * @return true if a condition fired: the caller retires nothing more this cycle
+         */
+        bool retire(std::uint64_t pc, std::uint64_t cycle, std::uint64_t ra);
+
+        /**
+         * @brief Data write hook; a match fires when the writing instruction retires
+         */
+        void write(std::uint64_t addr, unsigned int size);
+
+        /**
+         * @brief Oldest hit not yet taken by the host
+         */
+        bool takeHit(Hit &hit);
+
+    private:
+        enum class Kind {
+            Instructions, Cycles, PC, Exit, Write
+        };
+
+        struct Condition {
+            Kind kind;
+            Action action;
+            std::uint64_t value;        ///< count, cycle or address compared on retire
+            std::uint64_t entry;        ///< Exit: function address; Write: watched length
+            bool returning;             ///< Exit: value holds the return address
+            bool written;               ///< Write: a matching write is waiting to retire
+            std::string text;
+        };
+
+        RunControl() = default;
+
+        bool resolve(const std::string &text, std::uint64_t &addr) const;
+
+        bool matches(Condition &cond, std::uint64_t pc, std::uint64_t cycle, std::uint64_t ra);
+
+        static bool s_armed;
+        static bool s_watch_writes;
+
+        std::vector<Condition> conditions;
+        std::unordered_map<std::string, std::uint64_t> symbols;
+        std::deque<Hit> hits;
+    };
+}
+
+#endif /* INC_RUNCONTROL_H_ */
@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file SelfProfile.h
+ * @brief Host-time attribution of simulator components
+ *
+ * Coarse, rdtsc-based scoped timers that split host time between decode,
+ * execute, bus routing, memory, peripherals, logging and the SystemC kernel,
+ * plus optional Linux perf_event counters (host IPC, cache and branch misses)
+ * per simulation phase. Built only with -DENABLE_SELF_PROFILE=ON; otherwise
+ * the RVVP_PROFILE_* macros expand to nothing.
+ *
+ * Time is attributed exclusively: a scope's self time excludes any nested
+ * scope, so nested bus -> memory accesses are not double counted. Scopes must
+ * not span a SystemC wait(), since the kernel time would land in them.
+ */
+#pragma once
+#ifndef SELF_PROFILE_H
+#define SELF_PROFILE_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "spdlog/sinks/base_sink.h"
+
+namespace riscv_tlm {
+
+/**
+ * @brief Self-profiling singleton (one per simulation, SystemC is single threaded)
+ */
+class SelfProfile {
+public:
+    enum Component {
+        Decode = 0,
+        Execute,
+        Bus,
+        Memory,
+        Peripherals,
+        Logging,
+        Kernel,     ///< sc_start() minus everything attributed above
+        NumComponents
+    };
+
+    enum Phase {
+        Elaboration = 0,
+        Simulation,
+        NumPhases
+    };
+
+    /** Deepest scope nesting tracked; deeper scopes are not timed */
+    static constexpr unsigned MAX_DEPTH = 32;
+
+    static SelfProfile *getInstance();
+
+    /**
+     * @brief Enable or disable collection at run time
+     */
+    void setEnabled(bool enable);
+
+    bool isEnabled() const {
+        return enabled;
+    }
+
+    /**
+     * @brief Host timestamp in ticks (TSC on x86, virtual counter on AArch64)
+     */
+    static inline std::uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        std::uint64_t v;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+        return v;
+#else
+        return static_cast<std::uint64_t>(
+                std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    inline void enter(Component c) {
+        if (depth == MAX_DEPTH) {
+            overflow++;
+            return;
+        }
+        Frame &f = stack[depth++];
+        f.component = c;
+        f.start = now();
+        f.children = 0;
+    }
+
+    inline void leave() {
+        if (overflow > 0) {
+            overflow--;
+            return;
+        }
+        Frame &f = stack[--depth];
+        std::uint64_t elapsed = now() - f.start;
+        ticks[f.component] += elapsed - f.children;
+        calls[f.component]++;
+        if (depth > 0) {
+            stack[depth - 1].children += elapsed;
+        }
+    }
+
+    /**
+     * @brief Close the scopes open above the kernel one, before a wait()
+     * @return number of scopes closed, their components in @p saved
+     */
+    inline unsigned suspend(std::array<Component, MAX_DEPTH> &saved) {
+        if (overflow > 0) {
+            return 0;
+        }
+        const std::uint64_t t = now();
+        unsigned n = 0;
+        while (depth > 0 && stack[depth - 1].component != Kernel) {
+            Frame &f = stack[--depth];
+            std::uint64_t elapsed = t - f.start;
+            ticks[f.component] += elapsed - f.children;
+            if (depth > 0) {
+                stack[depth - 1].children += elapsed;
+            }
+            saved[n++] = f.component;
+        }
+        return n;
+    }
+
+    /**
+     * @brief Reopen the scopes suspend() closed, once the wait() returned
+     */
+    inline void resume(const std::array<Component, MAX_DEPTH> &saved, unsigned n) {
+        while (n > 0) {
+            enter(saved[--n]);
+        }
+    }
+
+    /**
+     * @brief Start/stop host performance counters for a phase
+     */
+    void beginPhase(Phase p);
+    void endPhase(Phase p);
+
+    /**
+     * @brief Print the report to cout
+     * @param delta_cycles SystemC delta cycles executed (context switch proxy)
+     */
+    void dump(std::uint64_t delta_cycles) const;
+
+private:
+    SelfProfile();
+    static SelfProfile *instance;
+
+    struct Frame {
+        Component component;
+        std::uint64_t start;
+        std::uint64_t children;
+    };
+
+    struct PhaseCounters {
+        bool valid{false};
+        double seconds{0};
+        std::uint64_t instructions{0};
+        std::uint64_t cycles{0};
+        std::uint64_t cache_misses{0};
+        std::uint64_t branch_misses{0};
+    };
+
+    static constexpr unsigned NUM_HW_COUNTERS = 4;
+
+    bool enabled{false};
+    unsigned depth{0};
+    unsigned overflow{0};
+    std::array<Frame, MAX_DEPTH> stack{};
+    std::array<std::uint64_t, NumComponents> ticks{};
+    std::array<std::uint64_t, NumComponents> calls{};
+
+    /* perf_event file descriptors (group leader first), -1 if unavailable */
+    std::array<int, NUM_HW_COUNTERS> perf_fd{{-1, -1, -1, -1}};
+    std::array<PhaseCounters, NumPhases> phases{};
+    std::chrono::steady_clock::time_point phase_start{};
+
+    /* Tick rate calibration against steady_clock */
+    std::uint64_t calib_ticks{0};
+    std::chrono::steady_clock::time_point calib_time{};
+
+    void openCounters();
+    bool readCounters(std::array<std::uint64_t, NUM_HW_COUNTERS> &values) const;
+    std::array<std::uint64_t, NUM_HW_COUNTERS> phase_base{};
+};
+
+/**
+ * @brief RAII timer attributing the enclosed host time to one component
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(SelfProfile::Component c) {
+        prof = SelfProfile::getInstance();
+        if (prof->isEnabled()) {
+            prof->enter(c);
+        } else {
+            prof = nullptr;
+        }
+    }
+
+    ~ProfileScope() {
+        if (prof != nullptr) {
+            prof->leave();
+        }
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    SelfProfile *prof;
+};
+
+/**
+ * @brief RAII guard keeping a SystemC wait() out of the open scopes
+ */
+class ProfileSuspend {
+public:
+    ProfileSuspend() {
+        prof = SelfProfile::getInstance();
+        if (prof->isEnabled()) {
+            count = prof->suspend(saved);
+        } else {
+            prof = nullptr;
+        }
+    }
+
+    ~ProfileSuspend() {
+        if (prof != nullptr) {
+            prof->resume(saved, count);
+        }
+    }
+
+    ProfileSuspend(const ProfileSuspend &) = delete;
+    ProfileSuspend &operator=(const ProfileSuspend &) = delete;
+
+private:
+    SelfProfile *prof;
+    std::array<SelfProfile::Component, SelfProfile::MAX_DEPTH> saved{};
+    unsigned count{0};
+};
+
+/**
+ * @brief spdlog sink wrapper charging formatting and I/O to Logging
+ */
+class ProfilingSink : public spdlog::sinks::base_sink<std::mutex> {
+public:
+    explicit ProfilingSink(spdlog::sink_ptr inner) : wrapped(std::move(inner)) {}
+
+protected:
+    void sink_it_(const spdlog::details::log_msg &msg) override {
+        ProfileScope scope(SelfProfile::Logging);
+        wrapped->log(msg);
+    }
+
+    void flush_() override {
+        ProfileScope scope(SelfProfile::Logging);
+        wrapped->flush();
+    }
+
+private:
+    spdlog::sink_ptr wrapped;
+};
+
+} // namespace riscv_tlm
+
+#if defined(ENABLE_SELF_PROFILE)
+#define RVVP_PROFILE_CAT2(a, b) a##b
+#define RVVP_PROFILE_CAT(a, b) RVVP_PROFILE_CAT2(a, b)
+/** Attribute the rest of the enclosing block to component @p c */
+#define RVVP_PROFILE_SCOPE(c) \
+    ::riscv_tlm::ProfileScope RVVP_PROFILE_CAT(rvvp_prof_, __LINE__)(::riscv_tlm::SelfProfile::c)
+/** Suspend the open scopes for the rest of the enclosing block (around a wait()) */
+#define RVVP_PROFILE_SUSPEND() \
+    ::riscv_tlm::ProfileSuspend RVVP_PROFILE_CAT(rvvp_prof_, __LINE__)
+/** Evaluate @p expr attributing its host time to component @p c */
+#define RVVP_PROFILE_EXPR(c, expr) \
+    ([&]() { RVVP_PROFILE_SCOPE(c); return (expr); }())
+#else
+#define RVVP_PROFILE_SCOPE(c) do { } while (0)
+#define RVVP_PROFILE_SUSPEND() do { } while (0)
+#define RVVP_PROFILE_EXPR(c, expr) (expr)
+#endif
+
+#endif // SELF_PROFILE_H
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file SharedMemory.h
+ * @brief POSIX shared-memory object mapped into the simulator
+ *
+ * Used by the telemetry page and by the links between VP processes
+ * (TlmBridge.h, NetLink.h). The creator removes the object when it is
+ * closed; the object a crashed run left behind under the same name is
+ * replaced. Objects shared by several peers (open()) are removed by
+ * whoever leaves last, with remove().
+ */
+#pragma once
+#ifndef INC_SHAREDMEMORY_H_
+#define INC_SHAREDMEMORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace riscv_tlm {
+
+    class SharedMemory {
+    public:
+        SharedMemory() = default;
+
+        ~SharedMemory() {
+            close();
+        }
+
+        SharedMemory(const SharedMemory &) = delete;
+        SharedMemory &operator=(const SharedMemory &) = delete;
+
+        /**
+         * @brief Create @p name with @p size zero bytes, mapped read-write
+         * @param mode permissions of the object, e.g. 0644 for read-only readers
+         * @return false with @p error set
+         */
+        bool create(const std::string &name, std::size_t size, unsigned int mode, std::string &error);
+
+        /**
+         * @brief Map the object another process created, read-write
+         * @return false with @p error set if it does not exist or is smaller than @p size
+         */
+        bool attach(const std::string &name, std::size_t size, std::string &error);
+
+        /**
+         * @brief Attach to @p name, creating it with @p size zero bytes if it does not exist
+         *
+         * Nobody owns the object: close() leaves it in place.
+         * @param created set if this call created it
+         * @return false with @p error set
+         */
+        bool open(const std::string &name, std::size_t size, unsigned int mode, bool &created,
+                  std::string &error);
+
+        /**
+         * @brief Remove @p name; processes that have it mapped keep their mapping
+         */
+        static void remove(const std::string &name);
+
+        /**
+         * @brief Id of this process, as peers record it in shared objects
+         */
+        static std::uint32_t processId();
+
+        /**
+         * @brief False once process @p pid has exited, e.g. a peer that crashed
+         */
+        static bool processAlive(std::uint32_t pid);
+
+        /**
+         * @brief Unmap, and remove the object if this side created it
+         */
+        void close();
+
+        void *data() const {
+            return m_addr;
+        }
+
+        std::size_t size() const {
+            return m_size;
+        }
+
+        const std::string &name() const {
+            return m_name;
+        }
+
+    private:
+        void *m_addr{nullptr};
+        std::size_t m_size{0};
+        std::string m_name;
+        bool m_owner{false};
+    };
+}
+
+#endif /* INC_SHAREDMEMORY_H_ */
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file ShmRing.h
+ * @brief Lock-free single-producer, single-consumer ring in shared memory
+ *
+ * The ring lives inside a SharedMemory object that the creator zero-fills,
+ * which is the empty state. One process pushes and one process pops;
+ * neither ever blocks the other. Head and tail sit on separate cache lines
+ * so that the two cores do not share one.
+ */
+#pragma once
+#ifndef INC_SHMRING_H_
+#define INC_SHMRING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace riscv_tlm {
+
+    template<typename T, std::size_t N>
+    struct ShmRing {
+        static_assert(N > 0 && (N & (N - 1)) == 0, "ring size must be a power of two");
+        static_assert(std::is_trivially_copyable<T>::value, "slots are copied between processes");
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the ring is shared between processes");
+
+        alignas(64) std::atomic<std::uint64_t> head;    ///< next slot the producer fills
+        alignas(64) std::atomic<std::uint64_t> tail;    ///< next slot the consumer reads
+        alignas(64) T slots[N];
+
+        /**
+         * @return false if the ring is full
+         */
+        bool push(const T &item) {
+            const std::uint64_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) == N) {
+                return false;
+            }
+            slots[h & (N - 1)] = item;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @return false if the ring is empty
+         */
+        bool pop(T &item) {
+            const std::uint64_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire)) {
+                return false;
+            }
+            item = slots[t & (N - 1)];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Oldest item without consuming it
+         * @return nullptr if the ring is empty
+         */
+        const T *peek() const {
+            const std::uint64_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            return &slots[t & (N - 1)];
+        }
+    };
+}
+
+#endif /* INC_SHMRING_H_ */
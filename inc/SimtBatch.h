@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file SimtBatch.h
+ * @brief Many independent RV32IM guests stepped in lockstep by one interpreter
+ *
+ * A batch runs N instances (lanes) of the same program, for example over N
+ * different inputs. The register files are stored structure-of-arrays: row
+ * r holds register x<r> of every lane, so an ALU instruction is one
+ * VectorKernels operation over N elements (AVX2 or SSE2 when the host has
+ * them) instead of N interpreted instructions.
+ *
+ * Lanes diverge at branches and indirect jumps. The interpreter then picks
+ * the lowest PC among the running lanes, and runs the basic block there for
+ * the lanes at that PC only (the active mask); results of the others are
+ * left alone. Lanes that skipped ahead wait until the ones behind reach the
+ * same PC, which is where they reconverge. Loads, stores and system
+ * instructions go lane by lane.
+ *
+ * All lanes share one memory image. A lane that writes a page gets its own
+ * copy of it (copy-on-write), so lanes never see each other's stores and an
+ * untouched image costs no memory per lane.
+ *
+ * The model is functional and has no peripherals: there is no SystemC, no
+ * timing, no interrupts and no privileged architecture. ECALL ends a lane
+ * with exit code a0; EBREAK halts it. Stores to the trace port or the UART
+ * transmit register are captured as the lane's output, and a store to tohost
+ * ends the lane as on the VP.
+ */
+#pragma once
+#ifndef INC_SIMTBATCH_H_
+#define INC_SIMTBATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "VectorKernels.h"
+
+namespace riscv_tlm {
+
+    /**
+     * @brief Program image shared by every lane of a batch
+     */
+    class SimtImage {
+    public:
+        static constexpr std::uint32_t PAGE_SIZE = 4096;
+
+        /**
+         * @param size guest memory in bytes, rounded up to whole pages
+         */
+        explicit SimtImage(std::uint32_t size);
+
+        /**
+         * @brief Load an Intel HEX file, with the records Memory::readHexFile knows
+         * @return false with @p error set
+         */
+        bool loadHex(const std::string &filename, std::string &error);
+
+        /**
+         * @brief Copy @p data to @p addr; bytes past the end of memory are dropped
+         */
+        void write(std::uint32_t addr, const std::uint8_t *data, std::size_t len);
+
+        /**
+         * @brief Page @p index, or nullptr if nothing was loaded there (reads as zero)
+         */
+        const std::uint8_t *page(std::uint32_t index) const {
+            return m_pages[index].get();
+        }
+
+        std::uint32_t size() const {
+            return m_size;
+        }
+
+        std::uint32_t pages() const {
+            return static_cast<std::uint32_t>(m_pages.size());
+        }
+
+        /**
+         * @brief Start address, from a 03 or 05 record (0 without one)
+         */
+        std::uint32_t entry() const {
+            return m_entry;
+        }
+
+        void setEntry(std::uint32_t pc) {
+            m_entry = pc;
+        }
+
+    private:
+        std::uint32_t m_size;
+        std::uint32_t m_entry{0};
+        std::vector<std::unique_ptr<std::uint8_t[]>> m_pages;
+    };
+
+    class SimtBatch {
+    public:
+        static constexpr unsigned int MAX_LANES = 1024;
+        static constexpr std::uint32_t MAX_BLOCK = 256;   ///< instructions before the lanes are re-picked
+
+        enum class LaneState {
+            Running,
+            Exited,     ///< ECALL or tohost
+            Halted,     ///< EBREAK
+            Faulted,    ///< exception; see cause and tval
+            Limit       ///< instruction limit reached
+        };
+
+        struct Lane {
+            LaneState state{LaneState::Running};
+            std::uint32_t pc{0};            ///< of the last instruction once stopped
+            std::uint32_t exit_code{0};
+            std::uint32_t cause{0};         ///< mcause of the fault
+            std::uint32_t tval{0};
+            std::uint64_t instret{0};
+            std::uint32_t private_pages{0}; ///< pages copied on write
+            std::string output;             ///< bytes written to the trace port or UART
+        };
+
+        struct Stats {
+            std::uint64_t blocks{0};            ///< basic blocks issued
+            std::uint64_t issued{0};            ///< instructions issued, once per block for all its lanes
+            std::uint64_t lane_instructions{0}; ///< instructions retired, summed over lanes
+            std::uint64_t divergent_blocks{0};  ///< blocks issued for only part of the running lanes
+        };
+
+        /**
+         * @brief @p lanes instances of @p image, all at its entry point
+         *
+         * The image must outlive the batch. sp starts at the top of memory,
+         * every other register at zero.
+         */
+        SimtBatch(const SimtImage &image, unsigned int lanes,
+                  const VectorKernels &kernels = VectorKernels::get());
+
+        /**
+         * @brief Put @p data in the memory of @p lane at @p addr, and pass it in a0 (address) and a1 (length)
+         * @return false if it does not fit in memory
+         */
+        bool setInput(unsigned int lane, std::uint32_t addr, const std::uint8_t *data, std::size_t len);
+
+        /**
+         * @brief Run until every lane has stopped
+         * @param max_instructions per lane, 0 for no limit
+         */
+        void run(std::uint64_t max_instructions = 0);
+
+        unsigned int lanes() const {
+            return m_lanes;
+        }
+
+        const Lane &lane(unsigned int index) const {
+            return m_lane[index];
+        }
+
+        std::uint32_t reg(unsigned int lane, unsigned int r) const {
+            return m_x[r * m_stride + lane];
+        }
+
+        void setReg(unsigned int lane, unsigned int r, std::uint32_t value) {
+            if (r != 0) {
+                m_x[r * m_stride + lane] = value;
+            }
+        }
+
+        const Stats &stats() const {
+            return m_stats;
+        }
+
+        const VectorKernels &kernels() const {
+            return m_kernels;
+        }
+
+        static const char *stateName(LaneState state);
+
+    private:
+        std::uint32_t *row(unsigned int r) {
+            return &m_x[r * m_stride];
+        }
+
+        /**
+         * @brief Pick the lanes at the lowest PC as the active mask
+         * @return false once no lane is running
+         */
+        bool select(std::uint64_t max_instructions);
+
+        void execBlock();
+
+        /**
+         * @brief Instruction at @p pc for the active lanes
+         *
+         * Lanes whose private copy of the page holds other code leave the block.
+         * @return false if no lane is left
+         */
+        bool fetch(std::uint32_t pc, std::uint32_t executed, std::uint32_t &insn);
+
+        /**
+         * @brief Where an ALU result goes: the register row itself when every lane is active
+         */
+        std::uint32_t *dest(unsigned int rd) {
+            return m_full && rd != 0 ? row(rd) : m_tmp.data();
+        }
+
+        /**
+         * @brief Copy the active lanes of m_tmp to @p rd if dest() did not write it directly
+         */
+        void commit(unsigned int rd);
+
+        const std::uint32_t *immediate(std::uint32_t value);
+
+        /**
+         * @brief rd = 1 for lanes whose bit is set in m_cmp, else 0
+         */
+        void setFromMask(unsigned int rd);
+
+        bool load(unsigned int lane, std::uint32_t addr, unsigned int size, std::uint32_t &value);
+
+        /**
+         * @return false on an access fault; @p stop is set when the store ended the lane
+         */
+        bool store(unsigned int lane, std::uint32_t addr, unsigned int size, std::uint32_t value,
+                   bool &stop);
+
+        const std::uint8_t *readPage(unsigned int lane, std::uint32_t index) const;
+
+        std::uint8_t *writePage(unsigned int lane, std::uint32_t index);
+
+        /**
+         * @brief Take @p lane out of the block after @p executed instructions, at @p pc
+         */
+        void leave(unsigned int lane, std::uint32_t executed, std::uint32_t pc);
+
+        void stop(unsigned int lane, LaneState state, std::uint32_t executed, std::uint32_t pc);
+
+        void fault(unsigned int lane, std::uint32_t cause, std::uint32_t tval, std::uint32_t executed,
+                   std::uint32_t pc);
+
+        /**
+         * @brief Drop lanes that left the block from the active list
+         */
+        void compact();
+
+        static bool maskBit(const std::vector<std::uint8_t> &mask, unsigned int i) {
+            return (mask[i >> 3] >> (i & 7)) & 1;
+        }
+
+        const SimtImage &m_image;
+        const VectorKernels &m_kernels;
+        unsigned int m_lanes;
+        unsigned int m_stride;          ///< lanes rounded up to a whole AVX2 register
+        std::uint32_t m_pages;
+
+        std::vector<std::uint32_t> m_x;     ///< [register][lane]
+        std::vector<std::uint32_t> m_pc;
+        std::vector<Lane> m_lane;
+        std::vector<std::unique_ptr<std::uint8_t[]>> m_private;    ///< [lane][page], null if shared
+        std::vector<std::uint32_t> m_private_count;                ///< lanes with their own copy, by page
+
+        /* current block */
+        std::uint32_t m_block_pc{0};
+        std::uint32_t m_budget{0};
+        std::vector<std::uint8_t> m_mask;       ///< active lanes, VectorKernels mask layout
+        std::vector<unsigned int> m_active;
+        bool m_full{false};                     ///< every lane of the batch is active
+        bool m_left{false};                     ///< a lane left the block during this instruction
+
+        std::vector<std::uint32_t> m_tmp;
+        std::vector<std::uint32_t> m_imm;
+        std::uint32_t m_imm_value{0};
+        std::vector<std::uint8_t> m_cmp;
+
+        Stats m_stats;
+    };
+}
+
+#endif /* INC_SIMTBATCH_H_ */
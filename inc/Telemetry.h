@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file Telemetry.h
+ * @brief Publishes the telemetry page (TelemetryPage.h) of a running VP
+ *
+ * RISCV_VP calls publish() between its sc_start() slices, so the simulation
+ * itself carries no instrumentation: the counters it already keeps are
+ * copied into the page, with the model's own counters from
+ * CPU::visitCounters(). With shared RAM, Memory allocates the guest RAM in
+ * a second shared-memory object and readers see every store as it happens.
+ * Both objects are removed at exit. POSIX hosts only.
+ */
+#pragma once
+#ifndef INC_TELEMETRY_H_
+#define INC_TELEMETRY_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "SharedMemory.h"
+#include "TelemetryPage.h"
+
+namespace riscv_tlm {
+
+    class CPU;
+
+    class Telemetry {
+    public:
+        static Telemetry *getInstance();
+
+        /**
+         * @brief Create /riscv_vp.<pid>, before the platform is built
+         * @param share_ram let Memory allocate the guest RAM in /riscv_vp.<pid>.ram
+         * @return false with @p error set if the object cannot be created
+         */
+        bool open(bool share_ram, std::string &error);
+
+        bool isOpen() const {
+            return m_page != nullptr;
+        }
+
+        /**
+         * @brief Name of the page's shared-memory object
+         */
+        const std::string &name() const {
+            return m_page_shm.name();
+        }
+
+        /**
+         * @brief Memory hook: @p size bytes of guest RAM in shared memory
+         * @return nullptr unless open() was asked to share the RAM
+         */
+        unsigned char *sharedRam(std::size_t size);
+
+        /**
+         * @brief Name the model and the program in the page
+         */
+        void describe(const std::string &model, const std::string &image);
+
+        /**
+         * @brief Copy the counters of @p cpu and the time into the page
+         */
+        void publish(CPU *cpu, TelemetryState state = TelemetryState::Running);
+
+        /**
+         * @brief Unmap and remove both shared-memory objects
+         */
+        void close();
+
+        ~Telemetry();
+
+        Telemetry(const Telemetry &) = delete;
+        Telemetry &operator=(const Telemetry &) = delete;
+
+    private:
+        Telemetry() = default;
+
+        SharedMemory m_page_shm;
+        SharedMemory m_ram_shm;
+        TelemetryPage *m_page{nullptr};
+        bool m_share_ram{false};
+
+        std::chrono::steady_clock::time_point m_start;
+        std::chrono::steady_clock::time_point m_last;
+        std::uint64_t m_last_instructions{0};
+    };
+}
+
+#endif /* INC_TELEMETRY_H_ */
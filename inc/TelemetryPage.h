@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file TelemetryPage.h
+ * @brief Layout of the shared-memory telemetry page, shared with vp_top
+ *
+ * A running RISCV_VP started with --telemetry publishes one page in the POSIX
+ * shared-memory object /riscv_vp.<pid>, and with --telemetry-ram the guest
+ * RAM in /riscv_vp.<pid>.ram. The simulator is the only writer. Readers map
+ * the page read-only and copy it under the sequence lock below, so they never
+ * stop or slow the simulation.
+ *
+ * This header has no SystemC dependency: tools include it on their own.
+ * Readers must check magic and version before anything else. A new field is
+ * only ever appended, with version bumped.
+ */
+#pragma once
+#ifndef INC_TELEMETRYPAGE_H_
+#define INC_TELEMETRYPAGE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace riscv_tlm {
+
+    constexpr std::uint32_t TELEMETRY_MAGIC = 0x54505652;     // "RVPT"
+    constexpr std::uint32_t TELEMETRY_VERSION = 1;
+    constexpr std::size_t TELEMETRY_COUNTERS = 16;
+
+    /* "/riscv_vp.<pid>" and "/riscv_vp.<pid>.ram" */
+    constexpr const char *TELEMETRY_PREFIX = "/riscv_vp.";
+
+    enum class TelemetryState : std::uint32_t {
+        Running = 0,
+        Finished = 1
+    };
+
+    /**
+     * @brief A per-model counter, e.g. "stalls" or "branch_penalty"
+     */
+    struct TelemetryCounter {
+        char name[24];
+        std::uint64_t value;
+    };
+
+    struct TelemetryPage {
+        std::uint32_t magic;        ///< TELEMETRY_MAGIC once the page is initialised
+        std::uint32_t version;
+        std::uint32_t size;         ///< sizeof(TelemetryPage) of the writer
+        std::uint32_t pid;
+        std::atomic<std::uint32_t> sequence;  ///< odd while the writer updates the fields below
+        TelemetryState state;
+        char model[48];             ///< timing model and architecture
+        char image[128];            ///< hex file being run
+
+        std::uint64_t instructions;
+        std::uint64_t cycles;       ///< core clock domain
+        std::uint64_t pc;
+        std::uint64_t sim_time_ps;
+        std::uint64_t wall_ns;      ///< since the start of the simulation
+        std::uint64_t core_hz;
+        double mips;                ///< over the last update interval
+
+        std::uint32_t counter_count;
+        std::uint32_t reserved;
+        TelemetryCounter counters[TELEMETRY_COUNTERS];
+
+        std::uint64_t ram_size;     ///< 0 without --telemetry-ram
+        char ram_name[64];          ///< shared-memory object holding the guest RAM
+    };
+
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free,
+                  "the sequence lock is shared between processes");
+
+    /**
+     * @brief Writer side: run @p update with the sequence odd
+     */
+    template<typename Update>
+    inline void telemetryWrite(TelemetryPage &page, Update &&update) {
+        const std::uint32_t seq = page.sequence.load(std::memory_order_relaxed);
+        page.sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        update(page);
+        page.sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Reader side: copy a consistent page into @p copy
+     * @return false if the writer kept updating for @p attempts tries
+     */
+    inline bool telemetryRead(const TelemetryPage &shared, TelemetryPage &copy, unsigned int attempts = 1000) {
+        while (attempts-- > 0) {
+            const std::uint32_t before = shared.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            std::memcpy(static_cast<void *>(&copy), static_cast<const void *>(&shared), sizeof(copy));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (shared.sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+#endif /* INC_TELEMETRYPAGE_H_ */
@@ -21,6 +21,7 @@
 #include "tlm_utils/simple_target_socket.h"
 
 #include "BusCtrl.h"
+#include "RegisterBank.h"
 
 namespace riscv_tlm::peripherals {
 /**
@@ -36,6 +37,12 @@ namespace riscv_tlm::peripherals {
 
         tlm_utils::simple_initiator_socket<Timer> irq_line;
 
+        /* register map, from TIMER_MEMORY_ADDRESS_LO */
+        static constexpr std::uint64_t MTIME_LO = 0x0;
+        static constexpr std::uint64_t MTIME_HI = 0x4;
+        static constexpr std::uint64_t MTIMECMP_LO = 0x8;
+        static constexpr std::uint64_t MTIMECMP_HI = 0xC;
+
         /**
          *
          * @brief Constructor
@@ -63,9 +70,13 @@ namespace riscv_tlm::peripherals {
         virtual void b_transport(tlm::tlm_generic_payload &trans,
                                  sc_core::sc_time &delay);
 
+        /**
+         * @brief DMI on the side-effect free registers, see RegisterBank::dmi
+         */
+        bool get_direct_mem_ptr(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi_data);
+
     private:
-        sc_dt::sc_uint<64> m_mtime; /**< mtime register */
-        sc_dt::sc_uint<64> m_mtimecmp; /**< mtimecmp register */
+        RegisterBank regs; /**< mtime and mtimecmp, 32-bit halves */
         sc_core::sc_event timer_event; /**< event */
     };
 }
@@ -0,0 +1,298 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file TlmBridge.h
+ * @brief TLM bridge between two simulator processes over shared memory
+ *
+ * A bridge splits a platform at the bus. The two halves run as separate
+ * OS processes, each with its own SystemC kernel:
+ *  - BridgeTargetStub stands in for the remote targets. It is bound into
+ *    the local bus like a peripheral and forwards each b_transport to the
+ *    other process. Interrupts it receives are handed to a callback.
+ *  - BridgeInitiatorStub stands in for the remote initiator. It replays
+ *    the forwarded transactions through its initiator socket, and sends
+ *    interrupts back with setInterrupt().
+ *
+ * Messages travel in two lock-free rings (ShmRing.h), one per direction.
+ * They are exchanged in a SharedMemory object named /riscv_vp.bridge.<name>,
+ * which the target side creates.
+ *
+ * Time is kept conservatively, with a fixed lookahead L. Each message
+ * takes effect L after it was sent, and each side promises (grants) that
+ * nothing it sends from now on takes effect before its own time plus L. A
+ * side advances in steps of L, and only once the other side has granted
+ * at least that far. So neither side can receive a message in its own past,
+ * and the side that is behind can always move. While the target side
+ * waits for a response, its kernel is stopped and it sends nothing, so the
+ * initiator side runs ahead as far as it needs to answer. A forwarded
+ * access therefore costs about 2L of simulated time, plus whatever the
+ * remote target adds.
+ */
+#pragma once
+#ifndef INC_TLMBRIDGE_H_
+#define INC_TLMBRIDGE_H_
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+
+#include "systemc"
+#include "tlm.h"
+#include "tlm_utils/simple_initiator_socket.h"
+#include "tlm_utils/simple_target_socket.h"
+
+#include "BusCtrl.h"
+#include "SharedMemory.h"
+#include "ShmRing.h"
+
+namespace riscv_tlm {
+
+    constexpr std::size_t BRIDGE_MAX_DATA = 64;
+    constexpr std::size_t BRIDGE_RING_SLOTS = 256;
+
+    struct BridgeMessage {
+        enum Kind : std::uint32_t {
+            Request, Response, Interrupt
+        };
+
+        std::uint32_t kind;
+        std::uint32_t command;      ///< tlm_command of a request, line of an interrupt
+        std::uint64_t time_ps;      ///< when the receiver acts on it
+        std::uint64_t address;
+        std::uint32_t length;
+        std::int32_t status;        ///< tlm_response_status of a response, level of an interrupt
+        std::uint8_t data[BRIDGE_MAX_DATA];
+    };
+
+    /**
+     * @brief One direction of a bridge, written by the sending process
+     */
+    struct BridgeLink {
+        enum State : std::uint32_t {
+            Absent, Running, Finished
+        };
+
+        alignas(64) std::atomic<std::uint64_t> grant_ps;   ///< nothing sent from now on acts earlier
+        std::atomic<std::uint32_t> blocked;     ///< waits for a response and sends nothing before it
+        std::atomic<std::uint32_t> state;
+        ShmRing<BridgeMessage, BRIDGE_RING_SLOTS> ring;
+    };
+
+    struct BridgeChannel {
+        static constexpr std::uint32_t MAGIC = 0x42505652;     // "RVPB"
+        static constexpr std::uint32_t VERSION = 1;
+
+        std::atomic<std::uint32_t> magic;   ///< set last by the creator
+        std::uint32_t version;
+        std::uint32_t creator_pid;
+        std::uint32_t reserved;
+        std::uint64_t lookahead_ps;
+        BridgeLink link[2];                 ///< [0] from the target stub, [1] from the initiator stub
+    };
+
+    /**
+     * @brief Which side of a bridge the platform builds, and where
+     */
+    struct BridgeSpec {
+        enum class Role {
+            None,
+            Out,        ///< BridgeTargetStub on [base, base + size)
+            In          ///< BridgeInitiatorStub, interrupt doorbell at base
+        };
+
+        Role role{Role::None};
+        std::string channel;
+        std::uint64_t base{BRIDGE_BASE_ADDRESS};
+        std::uint64_t size{0x10000000};
+        std::uint64_t remote{0};            ///< remote address of base
+        std::uint64_t lookahead_ps{10000000};
+
+        /**
+         * @brief Parse "name[,base=A][,size=N][,remote=A][,lookahead=T]"
+         *
+         * T is a number with a unit: ps, ns, us or ms. Only the creating (Out)
+         * side sets the lookahead; the other side reads it from the channel.
+         * @return false with @p error set
+         */
+        bool parse(const std::string &spec, Role side, std::string &error);
+
+        /**
+         * @brief Bridge of the platform built by the top level (--bridge-out, --bridge-in)
+         */
+        static const BridgeSpec &platform() {
+            return s_platform;
+        }
+
+        static void setPlatform(const BridgeSpec &spec) {
+            s_platform = spec;
+        }
+
+    private:
+        static BridgeSpec s_platform;
+    };
+
+    /**
+     * @brief Channel set-up and time synchronisation shared by both stubs
+     */
+    class BridgeEndpoint : public sc_core::sc_module {
+    public:
+        SC_HAS_PROCESS(BridgeEndpoint);
+
+        ~BridgeEndpoint() override;
+
+        const sc_core::sc_time &lookahead() const {
+            return m_lookahead;
+        }
+
+    protected:
+        /**
+         * @param side 0 creates the channel, 1 attaches to it
+         */
+        BridgeEndpoint(sc_core::sc_module_name const &name, const BridgeSpec &spec, unsigned int side);
+
+        /**
+         * @brief Queue @p msg; it never acts before what this side has granted
+         */
+        void send(BridgeMessage &msg);
+
+        /**
+         * @brief Hand every message waiting in the incoming ring to receive()
+         */
+        void poll();
+
+        virtual void receive(const BridgeMessage &msg) = 0;
+
+        /**
+         * @brief True while a request of the blocked other side is unanswered;
+         *        until then this side may run ahead of its grant
+         */
+        virtual bool owesResponse() const {
+            return false;
+        }
+
+        /**
+         * @brief Promise that nothing sent from now on acts before @p time_ps
+         */
+        void grant(std::uint64_t time_ps);
+
+        void setBlocked(bool blocked);
+
+        bool peerFinished() const;
+
+        /**
+         * @brief Host-side wait between polls, longer the longer it lasts
+         */
+        static void backoff(unsigned int &spins);
+
+        static std::uint64_t toPs(const sc_core::sc_time &t);
+
+        static sc_core::sc_time fromPs(std::uint64_t ps);
+
+        static std::uint64_t nowPs() {
+            return toPs(sc_core::sc_time_stamp());
+        }
+
+        /**
+         * @brief Time from now until @p time_ps, zero if already reached
+         */
+        static sc_core::sc_time until(std::uint64_t time_ps);
+
+        std::uint64_t m_lookahead_ps{0};
+        sc_core::sc_time m_lookahead;
+        bool m_stop_with_peer{false};       ///< sc_stop() when the other side finishes
+
+    private:
+        void sync_thread();
+
+        void end_of_simulation() override;
+
+        SharedMemory m_shm;
+        BridgeChannel *m_channel{nullptr};
+        BridgeLink *m_out{nullptr};
+        BridgeLink *m_in{nullptr};
+        std::uint64_t m_granted{0};
+    };
+
+    /**
+     * @brief Target side: forwards the transactions of the local bus
+     *
+     * Addresses arrive as offsets into the bus window and are sent as
+     * remote + offset. Up to BRIDGE_MAX_DATA bytes per transaction.
+     */
+    class BridgeTargetStub : public BridgeEndpoint {
+    public:
+        tlm_utils::simple_target_socket<BridgeTargetStub> socket;
+
+        SC_HAS_PROCESS(BridgeTargetStub);
+
+        /**
+         * @brief Create the channel named in @p spec
+         */
+        BridgeTargetStub(sc_core::sc_module_name const &name, const BridgeSpec &spec);
+
+        /**
+         * @brief Where interrupts from the other side go, e.g. PLIC::set_irq
+         */
+        void onInterrupt(std::function<void(std::uint32_t, bool)> handler) {
+            m_on_interrupt = std::move(handler);
+        }
+
+    private:
+        void b_transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay);
+
+        void receive(const BridgeMessage &msg) override;
+
+        void interrupt_method();
+
+        std::uint64_t m_remote;
+        BridgeMessage m_response{};
+        bool m_has_response{false};
+        std::deque<BridgeMessage> m_interrupts;
+        sc_core::sc_event m_interrupt_event;
+        std::function<void(std::uint32_t, bool)> m_on_interrupt;
+    };
+
+    /**
+     * @brief Initiator side: replays forwarded transactions into the local bus
+     *
+     * The guest raises interrupts on the other side by writing to the
+     * doorbell (irq_socket): bits 30-0 hold the line, bit 31 the level.
+     */
+    class BridgeInitiatorStub : public BridgeEndpoint {
+    public:
+        tlm_utils::simple_initiator_socket<BridgeInitiatorStub> socket;
+        tlm_utils::simple_target_socket<BridgeInitiatorStub> irq_socket;
+
+        SC_HAS_PROCESS(BridgeInitiatorStub);
+
+        /**
+         * @brief Attach to the channel named in @p spec, waiting for it to be created
+         */
+        BridgeInitiatorStub(sc_core::sc_module_name const &name, const BridgeSpec &spec);
+
+        /**
+         * @brief Drive interrupt @p line of the other side
+         */
+        void setInterrupt(std::uint32_t line, bool level);
+
+    private:
+        void receive(const BridgeMessage &msg) override;
+
+        bool owesResponse() const override {
+            return m_unanswered > 0;
+        }
+
+        void request_thread();
+
+        void doorbell(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay);
+
+        std::deque<BridgeMessage> m_requests;
+        unsigned int m_unanswered{0};
+        sc_core::sc_event m_request_event;
+    };
+}
+
+#endif /* INC_TLMBRIDGE_H_ */
@@ -6,29 +6,36 @@
 #include <cstdint>
 #include <iostream>
 
+#include "RegisterBank.h"
+
 namespace riscv_tlm { namespace peripherals {
 
 class UART : public sc_core::sc_module {
 public:
     tlm_utils::simple_target_socket<UART> socket;
 
+    static constexpr std::uint64_t TXDATA = 0x00;   ///< write a byte to stdout
+
     SC_HAS_PROCESS(UART);
-    explicit UART(sc_core::sc_module_name const& name): sc_module(name), socket("socket") {
+    explicit UART(sc_core::sc_module_name const& name): sc_module(name), socket("socket"), regs(0x100) {
+        regs.add("txdata", TXDATA, 4, Access::WO).mask(0xFF).onWrite([](unsigned int, std::uint64_t value) {
+            std::cout << static_cast<char>(value) << std::flush;
+        });
         socket.register_b_transport(this, &UART::b_transport);
+        socket.register_get_direct_mem_ptr(this, &UART::get_direct_mem_ptr);
     }
 
 private:
     void b_transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
         (void)delay;
-        unsigned char* ptr = trans.get_data_ptr();
-        unsigned int len = trans.get_data_length();
-        if (trans.get_command() == tlm::TLM_WRITE_COMMAND && len > 0) {
-            // Simple: write first byte to stdout
-            char c = static_cast<char>(ptr[0]);
-            std::cout << c << std::flush;
-        }
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        regs.access(trans);
     }
+
+    bool get_direct_mem_ptr(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi_data) {
+        return regs.dmi(trans, dmi_data);
+    }
+
+    RegisterBank regs;
 };
 
 }} // namespace
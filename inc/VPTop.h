@@ -26,8 +26,12 @@
 #include "UART.h"
 #include "CLINT.h"
 #include "PLIC.h"
+#include "CLIC.h"
 #include "DMA.h"
+#include "DVFS.h"
 #include "SyscallIf.h"
+#include "TlmBridge.h"
+#include "VirtioNet.h"
 
 // CPU models based on timing selection
 #if defined(ENABLE_PIPELINED_ISS)
@@ -74,8 +78,16 @@ public:
     riscv_tlm::peripherals::UART *uart;
     riscv_tlm::peripherals::CLINT *clint;
     riscv_tlm::peripherals::PLIC *plic;
+    riscv_tlm::CLIC *clic;
     riscv_tlm::peripherals::DMA *dma;
     riscv_tlm::peripherals::SyscallIf *sysif;
+    riscv_tlm::peripherals::DVFS *dvfs;
+    riscv_tlm::peripherals::VirtioNet *net;
+    riscv_tlm::NetLink *net_link;       // --net only
+
+    // Bridge to another VP process (--bridge-out / --bridge-in), at most one
+    riscv_tlm::BridgeTargetStub *bridge_out;
+    riscv_tlm::BridgeInitiatorStub *bridge_in;
 
     SC_HAS_PROCESS(VPTop);
 
@@ -114,7 +126,6 @@ private:
 #ifndef _WIN32
     std::unique_ptr<riscv_tlm::Debug> m_debugger;
 #endif
-    sc_core::sc_clock clk;
 };
 
 } // namespace vp
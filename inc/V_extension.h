@@ -0,0 +1,1162 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file V_extension.h
+ * @brief Implement V extension (RVV 1.0, integer subset) part of the RISC-V
+ *
+ * Supported: vsetvl{i}/vsetivli; unit-stride, strided, indexed, segment,
+ * mask and whole-register loads/stores; integer add/sub/logic/min/max,
+ * shifts, multiply, divide, multiply-add, compares, merge/move, slides,
+ * vrgather, reductions, mask logical and mask manipulation instructions.
+ * Floating-point, fixed-point, widening/narrowing and carry instructions
+ * raise an illegal instruction exception.
+ *
+ * Whole-vector operations run on host SIMD through VectorKernels. Tail and
+ * masked-off elements are left undisturbed (valid for both policies), and
+ * vstart is treated as zero.
+ */
+#pragma once
+#ifndef V_EXTENSION__H
+#define V_EXTENSION__H
+
+#include "systemc"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "Registers.h"
+#include "MemoryInterface.h"
+#include "VectorKernels.h"
+#include "extension_base.h"
+
+#ifndef RVV_VLEN
+#define RVV_VLEN 256
+#endif
+
+namespace riscv_tlm {
+
+    typedef enum {
+        OP_V_CFG,
+        OP_V_LOAD,
+        OP_V_STORE,
+        OP_V_ARITH,
+
+        OP_V_ERROR
+    } op_V_Codes;
+
+    typedef enum {
+        V_LOAD_FP = 0b0000111,
+        V_STORE_FP = 0b0100111,
+        V_OP = 0b1010111,
+    } V_Codes;
+
+    /** funct3 of OP-V: operand category */
+    typedef enum {
+        OPIVV = 0b000,
+        OPFVV = 0b001,
+        OPMVV = 0b010,
+        OPIVI = 0b011,
+        OPIVX = 0b100,
+        OPFVF = 0b101,
+        OPMVX = 0b110,
+        OPCFG = 0b111,
+    } V_Funct3;
+
+    /**
+     * @brief Executed vector instruction, as seen by the timing model
+     */
+    struct VectorOpInfo {
+        enum class Kind {
+            Config,         ///< vsetvl*
+            UnitStride,     ///< contiguous memory access
+            Strided,        ///< one memory access per element
+            Indexed,        ///< one memory access per element
+            Arith,          ///< element-parallel datapath operation
+            Serial,         ///< iterative unit (divide), one element per cycle
+            Reduction,      ///< datapath pass plus a reduction tree
+            Permute,        ///< gather through a crossbar, one element per cycle
+        };
+
+        Kind kind{Kind::Arith};
+        unsigned int sew{8};        ///< element width in bits (EEW for memory)
+        std::uint64_t vl{0};        ///< elements processed
+        unsigned int fields{1};     ///< segment fields
+    };
+
+    /**
+     * @brief Cycles charged to EX for vector instructions
+     *
+     * The default model has a VLEN-bit datapath and a VLEN-bit memory port:
+     * ceil(vl * SEW / VLEN) cycles per operation, with strided and indexed
+     * accesses and divides processed one element per cycle.
+     */
+    class VectorTiming {
+    public:
+        using Model = std::function<unsigned int(const VectorOpInfo &op)>;
+
+        /**
+         * @brief Replace the timing model (empty function restores the default)
+         */
+        static void setModel(Model m);
+
+        static unsigned int cycles(const VectorOpInfo &op) {
+            return model ? model(op) : defaultCycles(op);
+        }
+
+        static unsigned int defaultCycles(const VectorOpInfo &op);
+
+    private:
+        static Model model;
+    };
+
+/**
+ * @brief Instruction decoding and fields access
+ */
+    template<typename T>
+    class V_extension : public extension_base<T> {
+    public:
+
+        using signed_T = typename std::make_signed<T>::type;
+        using unsigned_T = typename std::make_unsigned<T>::type;
+
+        static constexpr unsigned int VLEN = RVV_VLEN;
+        static constexpr unsigned int VLENB = VLEN / 8;
+        static constexpr unsigned int ELEN = 64;
+
+        static_assert(VLEN >= 64 && VLEN <= 65536 && (VLEN & (VLEN - 1)) == 0,
+                      "RVV_VLEN must be a power of two between 64 and 65536");
+
+        /**
+         * @brief Constructor, same as base class; resets vtype to vill
+         */
+        V_extension(const T &instr, Registers<T> *register_bank, MemoryInterface *mem_interface) :
+                extension_base<T>(instr, register_bank, mem_interface),
+                kern(VectorKernels::get()),
+                vreg(32 * VLENB, 0), tmp_a(8 * VLENB), tmp_b(8 * VLENB), tmp_d(8 * VLENB) {
+            this->regs->setCSR(CSR_VLENB, VLENB);
+            setVtype(~0ULL);
+            setVl(0);
+        }
+
+        /**
+         * @brief Access to opcode field
+         * @return return opcode field
+         */
+        inline unsigned_T opcode() const override {
+            return static_cast<unsigned_T>(this->m_instr.range(6, 0));
+        }
+
+        inline unsigned int get_funct6() const {
+            return this->m_instr.range(31, 26);
+        }
+
+        /** @brief vm = 1: unmasked */
+        inline bool get_vm() const {
+            return this->m_instr[25] == 1;
+        }
+
+        inline unsigned int get_nf() const {
+            return this->m_instr.range(31, 29);
+        }
+
+        inline unsigned int get_mop() const {
+            return this->m_instr.range(27, 26);
+        }
+
+        inline std::int64_t get_simm5() const {
+            auto imm = static_cast<std::int64_t>(this->m_instr.range(19, 15));
+            return imm >= 16 ? imm - 32 : imm;
+        }
+
+        /**
+         * @brief Decodes opcode of instruction
+         * @return opcode of instruction
+         */
+        op_V_Codes decode() const {
+            switch (opcode()) {
+                case V_OP:
+                    return this->get_funct3() == OPCFG ? OP_V_CFG : OP_V_ARITH;
+                case V_LOAD_FP:
+                case V_STORE_FP:
+                    /* widths 1..4 are the scalar FP loads/stores */
+                    switch (this->get_funct3()) {
+                        case 0b000:
+                        case 0b101:
+                        case 0b110:
+                        case 0b111:
+                            return opcode() == V_LOAD_FP ? OP_V_LOAD : OP_V_STORE;
+                        default:
+                            return OP_V_ERROR;
+                    }
+                default:
+                    return OP_V_ERROR;
+            }
+        }
+
+        inline void dump() const override {
+            std::cout << std::hex << "0x" << this->m_instr << std::dec << std::endl;
+        }
+
+        /**
+         * @brief Cycles the last executed instruction spends in EX
+         */
+        unsigned int lastCycles() const {
+            return last_cycles;
+        }
+
+        /**
+         * @brief Raw register file, VLENB bytes per register
+         */
+        std::uint8_t *vregs() {
+            return vreg.data();
+        }
+
+        /**
+         * @brief Vector register file and vtype state, saved and restored with the hart
+         */
+        struct State {
+            std::vector<std::uint8_t> vreg;
+            std::uint64_t vl;
+            unsigned int sew;
+            int lmul_log2;
+            bool vill;
+        };
+
+        State saveState() const {
+            return {vreg, vl, sew, lmul_log2, vill};
+        }
+
+        void restoreState(const State &state) {
+            vreg = state.vreg;
+            vl = state.vl;
+            sew = state.sew;
+            lmul_log2 = state.lmul_log2;
+            vill = state.vill;
+        }
+
+        bool exec_instruction(Instruction &inst, op_V_Codes code) {
+            bool ok;
+
+            this->setInstr(inst.getInstr());
+            info = VectorOpInfo();
+            info.sew = sew;
+            info.vl = vl;
+
+            if (!this->regs->isVectorEnabled()) {
+                ok = false;
+            } else {
+                switch (code) {
+                    case OP_V_CFG:
+                        ok = Exec_V_CFG();
+                        break;
+                    case OP_V_LOAD:
+                        ok = Exec_V_LOADSTORE(false);
+                        break;
+                    case OP_V_STORE:
+                        ok = Exec_V_LOADSTORE(true);
+                        break;
+                    case OP_V_ARITH:
+                        ok = Exec_V_ARITH();
+                        break;
+                    default:
+                        ok = false;
+                        break;
+                }
+            }
+
+            if (!ok) {
+                this->logger->debug("{} ps. PC: 0x{:x}. V: unsupported or reserved encoding 0x{:x}",
+                                    sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                    static_cast<std::uint32_t>(this->m_instr));
+                last_cycles = 1;
+                this->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, this->m_instr);
+                return false;
+            }
+
+            /* vstart is cleared, which also marks the vector state dirty */
+            this->regs->setCSR(CSR_VSTART, 0);
+            last_cycles = std::max(1u, VectorTiming::cycles(info));
+
+            this->logger->debug("{} ps. PC: 0x{:x}. V: 0x{:x} vl={:d} sew={:d} ({:d} cycles)",
+                                sc_core::sc_time_stamp().value(), this->regs->getPC(),
+                                static_cast<std::uint32_t>(this->m_instr), vl, sew, last_cycles);
+            return true;
+        }
+
+    private:
+        const VectorKernels &kern;
+        std::vector<std::uint8_t> vreg;
+        std::vector<std::uint8_t> tmp_a;
+        std::vector<std::uint8_t> tmp_b;
+        std::vector<std::uint8_t> tmp_d;
+
+        std::uint64_t vl{0};
+        unsigned int sew{8};
+        int lmul_log2{0};
+        bool vill{true};
+        VectorOpInfo info;
+        unsigned int last_cycles{1};
+
+        /* --- helpers ---------------------------------------------------------- */
+
+        std::uint8_t *vr(unsigned int reg) {
+            return vreg.data() + reg * VLENB;
+        }
+
+        static bool getBit(const std::uint8_t *bits, std::uint64_t i) {
+            return ((bits[i >> 3] >> (i & 7)) & 1) != 0;
+        }
+
+        static void setBit(std::uint8_t *bits, std::uint64_t i, bool v) {
+            auto mask = static_cast<std::uint8_t>(1u << (i & 7));
+            bits[i >> 3] = static_cast<std::uint8_t>(v ? (bits[i >> 3] | mask) : (bits[i >> 3] & ~mask));
+        }
+
+        static std::uint64_t getElem(const std::uint8_t *base, std::uint64_t i, unsigned int width) {
+            std::uint64_t v = 0;
+            std::memcpy(&v, base + i * (width / 8), width / 8);
+            return v;
+        }
+
+        static void setElem(std::uint8_t *base, std::uint64_t i, unsigned int width, std::uint64_t v) {
+            std::memcpy(base + i * (width / 8), &v, width / 8);
+        }
+
+        static std::int64_t sext(std::uint64_t v, unsigned int width) {
+            unsigned int shift = 64 - width;
+            return static_cast<std::int64_t>(v << shift) >> shift;
+        }
+
+        bool active(std::uint64_t i) {
+            return get_vm() || getBit(vr(0), i);
+        }
+
+        std::uint64_t vlmax() const {
+            return lmul_log2 >= 0 ? (VLEN / sew) << lmul_log2 : (VLEN / sew) >> -lmul_log2;
+        }
+
+        unsigned int lmulRegs() const {
+            return lmul_log2 > 0 ? 1u << lmul_log2 : 1u;
+        }
+
+        static bool groupOk(unsigned int reg, unsigned int nregs) {
+            return reg % nregs == 0 && reg + nregs <= 32;
+        }
+
+        static bool overlaps(unsigned int a, unsigned int na, unsigned int b, unsigned int nb) {
+            return a < b + nb && b < a + na;
+        }
+
+        std::uint64_t xreg(unsigned int reg) const {
+            return static_cast<unsigned_T>(this->regs->getValue(reg));
+        }
+
+        void setVl(std::uint64_t new_vl) {
+            vl = new_vl;
+            this->regs->setCSR(CSR_VL, static_cast<T>(vl));
+        }
+
+        /**
+         * @brief Decode and install vtype; an unsupported setting sets vill
+         * @note CSRs are 32-bit wide in this model, so on RV64 the vill bit
+         *       (bit 63) is not visible through csrr vtype
+         */
+        bool setVtype(std::uint64_t v) {
+            unsigned int vlmul = v & 0x7;
+            unsigned int vsew = (v >> 3) & 0x7;
+            int l = vlmul < 4 ? static_cast<int>(vlmul) : static_cast<int>(vlmul) - 8;
+            unsigned int s = 8u << (vsew & 0x3);
+
+            bool bad = (v >> 8) != 0 || vlmul == 4 || vsew > 3;
+            /* Fractional LMUL needs SEW <= LMUL * ELEN and at least one element */
+            if (!bad && l < 0 && (s > (ELEN >> -l) || ((VLEN / s) >> -l) == 0)) {
+                bad = true;
+            }
+
+            vill = bad;
+            if (bad) {
+                sew = 8;
+                lmul_log2 = 0;
+                this->regs->setCSR(CSR_VTYPE, static_cast<T>(static_cast<unsigned_T>(1) << (sizeof(T) * 8 - 1)));
+            } else {
+                sew = s;
+                lmul_log2 = l;
+                this->regs->setCSR(CSR_VTYPE, static_cast<T>(v & 0xFF));
+            }
+            return !bad;
+        }
+
+        /* Memory accesses: DMI when the whole range is RAM, bus transactions otherwise */
+        void memRead(std::uint64_t addr, std::uint8_t *dst, std::size_t len, unsigned int esize) {
+            unsigned char *p = this->mem_intf->getDMIPointer(addr, len, false);
+            for (std::size_t off = 0; off < len; off += esize) {
+                if (p == nullptr) {
+                    std::uint64_t v = this->mem_intf->readDataMem64(addr + off, static_cast<int>(esize));
+                    std::memcpy(dst + off, &v, esize);
+                } else if (PluginManager::active()) {
+                    PluginManager::getInstance()->onMemAccess(addr + off, esize, false);
+                }
+                this->perf->dataMemoryRead();
+            }
+            if (p != nullptr) {
+                std::memcpy(dst, p, len);
+            }
+        }
+
+        void memWrite(std::uint64_t addr, const std::uint8_t *src, std::size_t len, unsigned int esize) {
+            unsigned char *p = this->mem_intf->getDMIPointer(addr, len, true);
+            if (p != nullptr) {
+                std::memcpy(p, src, len);
+            }
+            for (std::size_t off = 0; off < len; off += esize) {
+                if (p == nullptr) {
+                    std::uint64_t v = 0;
+                    std::memcpy(&v, src + off, esize);
+                    this->mem_intf->writeDataMem64(addr + off, v, static_cast<int>(esize));
+                } else if (PluginManager::active()) {
+                    PluginManager::getInstance()->onMemAccess(addr + off, esize, true);
+                }
+                this->perf->dataMemoryWrite();
+            }
+        }
+
+        /**
+         * @brief Second operand: vs1, or x[rs1] / imm5 broadcast to vl elements
+         */
+        const std::uint8_t *operandB(unsigned int f3, bool uimm = false) {
+            switch (f3) {
+                case OPIVV:
+                case OPMVV:
+                    return vr(this->get_rs1());
+                case OPIVI:
+                    VectorKernels::splat(sew, tmp_b.data(),
+                                         uimm ? static_cast<std::uint64_t>(this->get_rs1())
+                                              : static_cast<std::uint64_t>(get_simm5()), vl);
+                    return tmp_b.data();
+                default:
+                    VectorKernels::splat(sew, tmp_b.data(),
+                                         static_cast<std::uint64_t>(this->regs->getValue(this->get_rs1())), vl);
+                    return tmp_b.data();
+            }
+        }
+
+        static bool isVV(unsigned int f3) {
+            return f3 == OPIVV || f3 == OPMVV;
+        }
+
+        /**
+         * @brief Vector operands and destination are LMUL-aligned groups, and
+         *        a masked destination does not overwrite v0
+         */
+        bool checkGroups(unsigned int f3) {
+            unsigned int g = lmulRegs();
+            if (!groupOk(this->get_rd(), g) || !groupOk(this->get_rs2(), g)) {
+                return false;
+            }
+            if (isVV(f3) && !groupOk(this->get_rs1(), g)) {
+                return false;
+            }
+            return get_vm() || this->get_rd() != 0;
+        }
+
+        /**
+         * @brief Copy vl elements of tmp_d to vd, active elements only
+         */
+        void commit(unsigned int vd) {
+            if (get_vm()) {
+                std::memcpy(vr(vd), tmp_d.data(), vl * (sew / 8));
+            } else {
+                VectorKernels::merge(sew, vr(vd), tmp_d.data(), vr(0), vl);
+            }
+        }
+
+        /**
+         * @brief Copy vl mask bits to vd, active elements only
+         */
+        void commitMask(unsigned int vd, const std::uint8_t *bits) {
+            std::uint8_t *d = vr(vd);
+            std::uint64_t i = 0;
+            if (get_vm()) {
+                std::memcpy(d, bits, vl / 8);
+                i = vl & ~static_cast<std::uint64_t>(7);
+            }
+            for (; i < vl; i++) {
+                if (active(i)) {
+                    setBit(d, i, getBit(bits, i));
+                }
+            }
+        }
+
+        /* --- vsetvl ------------------------------------------------------------ */
+
+        bool Exec_V_CFG() {
+            unsigned int rd = this->get_rd();
+            unsigned int rs1 = this->get_rs1();
+            std::uint64_t new_vtype;
+            std::uint64_t avl;
+            bool avl_reg = true;
+
+            if (this->m_instr[31] == 0) {
+                new_vtype = this->m_instr.range(30, 20);            // vsetvli
+            } else if (this->m_instr[30] == 1) {
+                new_vtype = this->m_instr.range(29, 20);            // vsetivli
+                avl_reg = false;
+            } else if (this->m_instr.range(31, 25) == 0b1000000) {
+                new_vtype = xreg(this->get_rs2());                  // vsetvl
+                if (new_vtype >> (sizeof(T) * 8 - 1)) {
+                    new_vtype = ~0ULL;                              // vill requested
+                }
+            } else {
+                return false;
+            }
+
+            if (!avl_reg) {
+                avl = rs1;
+            } else if (rs1 != 0) {
+                avl = xreg(rs1);
+            } else if (rd != 0) {
+                avl = ~0ULL;                                        // vl = VLMAX
+            } else {
+                avl = vl;                                           // keep vl
+            }
+
+            bool ok = setVtype(new_vtype);
+            setVl(ok ? std::min(avl, vlmax()) : 0);
+            this->regs->setValue(rd, static_cast<T>(vl));
+
+            info.kind = VectorOpInfo::Kind::Config;
+            return true;
+        }
+
+        /* --- loads and stores -------------------------------------------------- */
+
+        bool Exec_V_LOADSTORE(bool store) {
+            unsigned int width = this->get_funct3();
+            unsigned int eew = width == 0 ? 8 : 8u << (width - 4);
+            unsigned int esize = eew / 8;
+            unsigned int nf = get_nf() + 1;
+            unsigned int mop = get_mop();
+            unsigned int vd = this->get_rd();           // vs3 for stores
+            unsigned int lumop = this->get_rs2();
+            std::uint64_t base = xreg(this->get_rs1());
+
+            if (this->m_instr[28] == 1) {
+                return false;                           // mew: EEW > 64
+            }
+
+            if (mop == 0 && lumop == 0b01000) {
+                /* Whole registers: independent of vtype and vl */
+                if (!get_vm() || (nf != 1 && nf != 2 && nf != 4 && nf != 8) || !groupOk(vd, nf)) {
+                    return false;
+                }
+                std::size_t bytes = nf * VLENB;
+                if (store) {
+                    memWrite(base, vr(vd), bytes, esize);
+                } else {
+                    memRead(base, vr(vd), bytes, esize);
+                }
+                info.kind = VectorOpInfo::Kind::UnitStride;
+                info.sew = eew;
+                info.vl = bytes / esize;
+                return true;
+            }
+
+            if (vill) {
+                return false;
+            }
+
+            if (mop == 0 && lumop == 0b01011) {
+                /* vlm.v / vsm.v: ceil(vl / 8) bytes */
+                if (width != 0 || nf != 1 || !get_vm()) {
+                    return false;
+                }
+                std::size_t bytes = (vl + 7) / 8;
+                if (store) {
+                    memWrite(base, vr(vd), bytes, 1);
+                } else {
+                    memRead(base, vr(vd), bytes, 1);
+                }
+                info.kind = VectorOpInfo::Kind::UnitStride;
+                info.sew = 8;
+                info.vl = bytes;
+                return true;
+            }
+
+            if (mop == 0 && lumop != 0 && !(lumop == 0b10000 && !store)) {
+                return false;
+            }
+
+            bool indexed = (mop & 1) != 0;
+            /* Data EMUL = EEW/SEW * LMUL for unit-stride/strided, LMUL for indexed */
+            int ew_log2 = width == 0 ? 0 : static_cast<int>(width) - 4;
+            int sew_log2 = sew == 8 ? 0 : sew == 16 ? 1 : sew == 32 ? 2 : 3;
+            int emul_log2 = ew_log2 - sew_log2 + lmul_log2;
+            if (emul_log2 < -3 || emul_log2 > 3) {
+                return false;
+            }
+            unsigned int data_regs = indexed ? lmulRegs() : (emul_log2 > 0 ? 1u << emul_log2 : 1u);
+            unsigned int index_regs = emul_log2 > 0 ? 1u << emul_log2 : 1u;
+            unsigned int dsize = indexed ? sew / 8 : esize;
+
+            if (data_regs * nf > 8 || !groupOk(vd, data_regs) || vd + data_regs * nf > 32) {
+                return false;
+            }
+            if (indexed && !groupOk(this->get_rs2(), index_regs)) {
+                return false;
+            }
+            if (!get_vm() && !store && vd == 0) {
+                return false;
+            }
+
+            info.sew = dsize * 8;
+            info.fields = nf;
+
+            if (mop == 0 && nf == 1 && get_vm()) {
+                /* Unmasked unit-stride: a single block transfer */
+                if (store) {
+                    memWrite(base, vr(vd), vl * esize, esize);
+                } else {
+                    memRead(base, vr(vd), vl * esize, esize);
+                }
+                info.kind = VectorOpInfo::Kind::UnitStride;
+                return true;
+            }
+
+            std::int64_t stride = static_cast<signed_T>(this->regs->getValue(this->get_rs2()));
+            const std::uint8_t *index = vr(this->get_rs2());
+
+            for (std::uint64_t i = 0; i < vl; i++) {
+                if (!active(i)) {
+                    continue;
+                }
+                for (unsigned int f = 0; f < nf; f++) {
+                    std::uint64_t addr;
+                    if (mop == 0) {
+                        addr = base + (i * nf + f) * esize;
+                    } else if (mop == 2) {
+                        addr = base + static_cast<std::uint64_t>(stride) * i + f * esize;
+                    } else {
+                        addr = base + getElem(index, i, eew) + f * dsize;
+                    }
+                    addr = static_cast<unsigned_T>(addr);
+
+                    std::uint8_t *elem = vr(vd + f * data_regs) + i * dsize;
+                    if (store) {
+                        memWrite(addr, elem, dsize, dsize);
+                    } else {
+                        memRead(addr, elem, dsize, dsize);
+                    }
+                }
+            }
+
+            info.kind = mop == 0 ? VectorOpInfo::Kind::UnitStride
+                                 : mop == 2 ? VectorOpInfo::Kind::Strided : VectorOpInfo::Kind::Indexed;
+            return true;
+        }
+
+        /* --- arithmetic -------------------------------------------------------- */
+
+        bool Exec_V_ARITH() {
+            unsigned int f3 = this->get_funct3();
+            unsigned int f6 = get_funct6();
+
+            if (f3 == OPFVV || f3 == OPFVF) {
+                return false;
+            }
+            if (f3 == OPIVI && f6 == 0b100111) {
+                return Exec_V_MVNR();
+            }
+            if (vill) {
+                return false;
+            }
+            if (f3 == OPMVV || f3 == OPMVX) {
+                return Exec_V_OPM(f3, f6);
+            }
+            return Exec_V_OPI(f3, f6);
+        }
+
+        bool Exec_V_OPI(unsigned int f3, unsigned int f6) {
+            switch (f6) {
+                case 0b000000:
+                    return binaryOp(VecBinOp::Add, f3);
+                case 0b000010:
+                    return f3 != OPIVI && binaryOp(VecBinOp::Sub, f3);
+                case 0b000011:
+                    return f3 != OPIVV && binaryOp(VecBinOp::RSub, f3);
+                case 0b000100:
+                    return f3 != OPIVI && binaryOp(VecBinOp::MinU, f3);
+                case 0b000101:
+                    return f3 != OPIVI && binaryOp(VecBinOp::Min, f3);
+                case 0b000110:
+                    return f3 != OPIVI && binaryOp(VecBinOp::MaxU, f3);
+                case 0b000111:
+                    return f3 != OPIVI && binaryOp(VecBinOp::Max, f3);
+                case 0b001001:
+                    return binaryOp(VecBinOp::And, f3);
+                case 0b001010:
+                    return binaryOp(VecBinOp::Or, f3);
+                case 0b001011:
+                    return binaryOp(VecBinOp::Xor, f3);
+                case 0b001100:
+                    return Exec_V_RGATHER(f3);
+                case 0b001110:
+                    return f3 != OPIVV && Exec_V_SLIDEUP(f3);
+                case 0b001111:
+                    return f3 != OPIVV && Exec_V_SLIDEDOWN(f3);
+                case 0b010111:
+                    return Exec_V_MERGE(f3);
+                case 0b011000:
+                    return compareOp(VecCmpOp::Eq, f3);
+                case 0b011001:
+                    return compareOp(VecCmpOp::Ne, f3);
+                case 0b011010:
+                    return f3 != OPIVI && compareOp(VecCmpOp::LtU, f3);
+                case 0b011011:
+                    return f3 != OPIVI && compareOp(VecCmpOp::Lt, f3);
+                case 0b011100:
+                    return compareOp(VecCmpOp::LeU, f3);
+                case 0b011101:
+                    return compareOp(VecCmpOp::Le, f3);
+                case 0b011110:
+                    return f3 != OPIVV && compareOp(VecCmpOp::GtU, f3);
+                case 0b011111:
+                    return f3 != OPIVV && compareOp(VecCmpOp::Gt, f3);
+                case 0b100101:
+                    return binaryOp(VecBinOp::Sll, f3, true);
+                case 0b101000:
+                    return binaryOp(VecBinOp::Srl, f3, true);
+                case 0b101001:
+                    return binaryOp(VecBinOp::Sra, f3, true);
+                default:
+                    return false;
+            }
+        }
+
+        bool Exec_V_OPM(unsigned int f3, unsigned int f6) {
+            if (f3 == OPMVV) {
+                if (f6 <= 0b000111) {
+                    static const VecRedOp red[] = {VecRedOp::Sum, VecRedOp::And, VecRedOp::Or, VecRedOp::Xor,
+                                                   VecRedOp::MinU, VecRedOp::Min, VecRedOp::MaxU, VecRedOp::Max};
+                    return reduceOp(red[f6]);
+                }
+                if (f6 == 0b010000) {
+                    return Exec_V_WXUNARY0();
+                }
+                if (f6 == 0b010100) {
+                    return Exec_V_MUNARY0();
+                }
+                if (f6 >= 0b011000 && f6 <= 0b011111) {
+                    return Exec_V_MASKLOGICAL(f6);
+                }
+            } else {
+                if (f6 == 0b010000) {
+                    return Exec_V_MV_S_X();
+                }
+                if (f6 == 0b001110) {
+                    return Exec_V_SLIDE1UP();
+                }
+                if (f6 == 0b001111) {
+                    return Exec_V_SLIDE1DOWN();
+                }
+            }
+
+            switch (f6) {
+                case 0b100000:
+                    return binaryOp(VecBinOp::DivU, f3);
+                case 0b100001:
+                    return binaryOp(VecBinOp::Div, f3);
+                case 0b100010:
+                    return binaryOp(VecBinOp::RemU, f3);
+                case 0b100011:
+                    return binaryOp(VecBinOp::Rem, f3);
+                case 0b100100:
+                    return binaryOp(VecBinOp::MulHU, f3);
+                case 0b100101:
+                    return binaryOp(VecBinOp::Mul, f3);
+                case 0b100110:
+                    return binaryOp(VecBinOp::MulHSU, f3);
+                case 0b100111:
+                    return binaryOp(VecBinOp::MulH, f3);
+                case 0b101001:
+                case 0b101011:
+                case 0b101101:
+                case 0b101111:
+                    return Exec_V_MULADD(f3, f6);
+                default:
+                    return false;
+            }
+        }
+
+        bool binaryOp(VecBinOp op, unsigned int f3, bool uimm = false) {
+            if (!checkGroups(f3)) {
+                return false;
+            }
+            const std::uint8_t *b = operandB(f3, uimm);
+            kern.binary(op, sew, tmp_d.data(), vr(this->get_rs2()), b, vl);
+            commit(this->get_rd());
+
+            bool serial = op == VecBinOp::DivU || op == VecBinOp::Div || op == VecBinOp::RemU || op == VecBinOp::Rem;
+            info.kind = serial ? VectorOpInfo::Kind::Serial : VectorOpInfo::Kind::Arith;
+            return true;
+        }
+
+        bool compareOp(VecCmpOp op, unsigned int f3) {
+            unsigned int g = lmulRegs();
+            if (!groupOk(this->get_rs2(), g) || (isVV(f3) && !groupOk(this->get_rs1(), g))) {
+                return false;
+            }
+            const std::uint8_t *b = operandB(f3);
+            kern.compare(op, sew, tmp_d.data(), vr(this->get_rs2()), b, vl);
+            commitMask(this->get_rd(), tmp_d.data());
+            return true;
+        }
+
+        bool reduceOp(VecRedOp op) {
+            if (!groupOk(this->get_rs2(), lmulRegs())) {
+                return false;
+            }
+            if (vl == 0) {
+                return true;
+            }
+
+            const std::uint8_t *src = vr(this->get_rs2());
+            std::uint64_t n = vl;
+            if (!get_vm()) {
+                /* Fold only active elements: compact them first */
+                n = 0;
+                for (std::uint64_t i = 0; i < vl; i++) {
+                    if (active(i)) {
+                        setElem(tmp_a.data(), n++, sew, getElem(src, i, sew));
+                    }
+                }
+                src = tmp_a.data();
+            }
+
+            std::uint64_t init = getElem(vr(this->get_rs1()), 0, sew);
+            setElem(vr(this->get_rd()), 0, sew, kern.reduce(op, sew, src, n, init));
+            info.kind = VectorOpInfo::Kind::Reduction;
+            return true;
+        }
+
+        bool Exec_V_MULADD(unsigned int f3, unsigned int f6) {
+            if (!checkGroups(f3)) {
+                return false;
+            }
+            const std::uint8_t *b = operandB(f3);
+            const std::uint8_t *vs2 = vr(this->get_rs2());
+            const std::uint8_t *d = vr(this->get_rd());
+            std::uint8_t *t = tmp_d.data();
+
+            switch (f6) {
+                case 0b101101:      // vmacc:  vd = vs1 * vs2 + vd
+                    kern.binary(VecBinOp::Mul, sew, t, vs2, b, vl);
+                    kern.binary(VecBinOp::Add, sew, t, t, d, vl);
+                    break;
+                case 0b101111:      // vnmsac: vd = -(vs1 * vs2) + vd
+                    kern.binary(VecBinOp::Mul, sew, t, vs2, b, vl);
+                    kern.binary(VecBinOp::Sub, sew, t, d, t, vl);
+                    break;
+                case 0b101001:      // vmadd:  vd = vs1 * vd + vs2
+                    kern.binary(VecBinOp::Mul, sew, t, d, b, vl);
+                    kern.binary(VecBinOp::Add, sew, t, t, vs2, vl);
+                    break;
+                default:            // vnmsub: vd = -(vs1 * vd) + vs2
+                    kern.binary(VecBinOp::Mul, sew, t, d, b, vl);
+                    kern.binary(VecBinOp::Sub, sew, t, vs2, t, vl);
+                    break;
+            }
+            commit(this->get_rd());
+            return true;
+        }
+
+        /** vmerge.v{v,x,i}m (vm = 0) and vmv.v.{v,x,i} (vm = 1) */
+        bool Exec_V_MERGE(unsigned int f3) {
+            unsigned int vd = this->get_rd();
+            unsigned int g = lmulRegs();
+            if (!groupOk(vd, g) || (isVV(f3) && !groupOk(this->get_rs1(), g))) {
+                return false;
+            }
+
+            const std::uint8_t *b = operandB(f3);
+            std::size_t bytes = vl * (sew / 8);
+            if (get_vm()) {
+                if (this->get_rs2() != 0) {
+                    return false;
+                }
+                std::memmove(vr(vd), b, bytes);
+            } else {
+                if (vd == 0 || !groupOk(this->get_rs2(), g)) {
+                    return false;
+                }
+                std::memcpy(tmp_d.data(), vr(this->get_rs2()), bytes);
+                VectorKernels::merge(sew, tmp_d.data(), b, vr(0), vl);
+                std::memcpy(vr(vd), tmp_d.data(), bytes);
+            }
+            return true;
+        }
+
+        /** vmv<nr>r.v: whole register move, independent of vtype */
+        bool Exec_V_MVNR() {
+            unsigned int nr = this->get_rs1() + 1;
+            unsigned int vd = this->get_rd();
+            unsigned int vs2 = this->get_rs2();
+            if (!get_vm() || (nr != 1 && nr != 2 && nr != 4 && nr != 8) || !groupOk(vd, nr) || !groupOk(vs2, nr)) {
+                return false;
+            }
+            std::memmove(vr(vd), vr(vs2), nr * VLENB);
+            info.sew = 8;
+            info.vl = nr * VLENB;
+            return true;
+        }
+
+        /* --- permutations ------------------------------------------------------ */
+
+        std::uint64_t slideAmount(unsigned int f3) const {
+            return f3 == OPIVI ? this->get_rs1() : xreg(this->get_rs1());
+        }
+
+        bool Exec_V_SLIDEUP(unsigned int f3) {
+            unsigned int vd = this->get_rd();
+            if (!checkGroups(f3) || vd == this->get_rs2()) {
+                return false;
+            }
+            std::uint64_t off = slideAmount(f3);
+            const std::uint8_t *vs2 = vr(this->get_rs2());
+
+            std::memcpy(tmp_d.data(), vr(vd), vl * (sew / 8));
+            for (std::uint64_t i = off; i < vl; i++) {
+                setElem(tmp_d.data(), i, sew, getElem(vs2, i - off, sew));
+            }
+            commit(vd);
+            return true;
+        }
+
+        bool Exec_V_SLIDEDOWN(unsigned int f3) {
+            if (!checkGroups(f3)) {
+                return false;
+            }
+            std::uint64_t off = slideAmount(f3);
+            std::uint64_t max = vlmax();
+            const std::uint8_t *vs2 = vr(this->get_rs2());
+
+            for (std::uint64_t i = 0; i < vl; i++) {
+                bool in = off < max && i < max - off;
+                setElem(tmp_d.data(), i, sew, in ? getElem(vs2, i + off, sew) : 0);
+            }
+            commit(this->get_rd());
+            return true;
+        }
+
+        bool Exec_V_SLIDE1UP() {
+            unsigned int vd = this->get_rd();
+            if (!checkGroups(OPMVX) || vd == this->get_rs2()) {
+                return false;
+            }
+            if (vl == 0) {
+                return true;
+            }
+            const std::uint8_t *vs2 = vr(this->get_rs2());
+            setElem(tmp_d.data(), 0, sew, xreg(this->get_rs1()));
+            std::memcpy(tmp_d.data() + sew / 8, vs2, (vl - 1) * (sew / 8));
+            commit(vd);
+            return true;
+        }
+
+        bool Exec_V_SLIDE1DOWN() {
+            if (!checkGroups(OPMVX)) {
+                return false;
+            }
+            if (vl == 0) {
+                return true;
+            }
+            const std::uint8_t *vs2 = vr(this->get_rs2());
+            std::memcpy(tmp_d.data(), vs2 + sew / 8, (vl - 1) * (sew / 8));
+            setElem(tmp_d.data(), vl - 1, sew, xreg(this->get_rs1()));
+            commit(this->get_rd());
+            return true;
+        }
+
+        bool Exec_V_RGATHER(unsigned int f3) {
+            unsigned int vd = this->get_rd();
+            unsigned int g = lmulRegs();
+            if (!checkGroups(f3) || overlaps(vd, g, this->get_rs2(), g) ||
+                (f3 == OPIVV && overlaps(vd, g, this->get_rs1(), g))) {
+                return false;
+            }
+            std::uint64_t max = vlmax();
+            const std::uint8_t *vs2 = vr(this->get_rs2());
+            const std::uint8_t *vs1 = vr(this->get_rs1());
+            std::uint64_t scalar_idx = slideAmount(f3);
+
+            for (std::uint64_t i = 0; i < vl; i++) {
+                std::uint64_t idx = f3 == OPIVV ? getElem(vs1, i, sew) : scalar_idx;
+                setElem(tmp_d.data(), i, sew, idx < max ? getElem(vs2, idx, sew) : 0);
+            }
+            commit(vd);
+            info.kind = VectorOpInfo::Kind::Permute;
+            return true;
+        }
+
+        /* --- scalar moves and mask instructions -------------------------------- */
+
+        /** vmv.x.s, vcpop.m, vfirst.m */
+        bool Exec_V_WXUNARY0() {
+            const std::uint8_t *vs2 = vr(this->get_rs2());
+            unsigned int rd = this->get_rd();
+
+            switch (this->get_rs1()) {
+                case 0b00000:
+                    if (!get_vm()) {
+                        return false;
+                    }
+                    this->regs->setValue(rd, static_cast<T>(sext(getElem(vs2, 0, sew), sew)));
+                    return true;
+                case 0b10000: {
+                    std::uint64_t count = 0;
+                    for (std::uint64_t i = 0; i < vl; i++) {
+                        count += (active(i) && getBit(vs2, i)) ? 1 : 0;
+                    }
+                    this->regs->setValue(rd, static_cast<T>(count));
+                    info.kind = VectorOpInfo::Kind::Reduction;
+                    info.sew = 1;
+                    return true;
+                }
+                case 0b10001: {
+                    std::int64_t first = -1;
+                    for (std::uint64_t i = 0; i < vl; i++) {
+                        if (active(i) && getBit(vs2, i)) {
+                            first = static_cast<std::int64_t>(i);
+                            break;
+                        }
+                    }
+                    this->regs->setValue(rd, static_cast<T>(first));
+                    info.kind = VectorOpInfo::Kind::Reduction;
+                    info.sew = 1;
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+
+        /** vmv.s.x */
+        bool Exec_V_MV_S_X() {
+            if (this->get_rs2() != 0 || !get_vm()) {
+                return false;
+            }
+            if (vl > 0) {
+                setElem(vr(this->get_rd()), 0, sew, xreg(this->get_rs1()));
+            }
+            return true;
+        }
+
+        /** vmsbf.m, vmsof.m, vmsif.m, viota.m, vid.v */
+        bool Exec_V_MUNARY0() {
+            unsigned int vd = this->get_rd();
+            unsigned int vs2 = this->get_rs2();
+            unsigned int op = this->get_rs1();
+            const std::uint8_t *src = vr(vs2);
+
+            if (op == 0b10000 || op == 0b10001) {
+                /* viota.m / vid.v write SEW elements */
+                if (!groupOk(vd, lmulRegs()) || (!get_vm() && vd == 0)) {
+                    return false;
+                }
+                if (op == 0b10000 && (overlaps(vd, lmulRegs(), vs2, 1))) {
+                    return false;
+                }
+                if (op == 0b10001 && vs2 != 0) {
+                    return false;
+                }
+                std::uint64_t sum = 0;
+                for (std::uint64_t i = 0; i < vl; i++) {
+                    if (op == 0b10001) {
+                        setElem(tmp_d.data(), i, sew, i);
+                    } else if (active(i)) {
+                        setElem(tmp_d.data(), i, sew, sum);
+                        sum += getBit(src, i) ? 1 : 0;
+                    }
+                }
+                commit(vd);
+                return true;
+            }
+
+            if ((op != 0b00001 && op != 0b00010 && op != 0b00011) || vd == vs2 || (!get_vm() && vd == 0)) {
+                return false;
+            }
+
+            bool found = false;
+            for (std::uint64_t i = 0; i < vl; i++) {
+                if (!active(i)) {
+                    continue;
+                }
+                bool bit = getBit(src, i);
+                bool res;
+                switch (op) {
+                    case 0b00001:       // vmsbf: before first
+                        res = !found && !bit;
+                        break;
+                    case 0b00010:       // vmsof: only first
+                        res = !found && bit;
+                        break;
+                    default:            // vmsif: including first
+                        res = !found;
+                        break;
+                }
+                found = found || bit;
+                setBit(vr(vd), i, res);
+            }
+            info.sew = 1;
+            return true;
+        }
+
+        bool Exec_V_MASKLOGICAL(unsigned int f6) {
+            if (!get_vm()) {
+                return false;
+            }
+            const std::uint8_t *a = vr(this->get_rs2());
+            const std::uint8_t *b = vr(this->get_rs1());
+            std::uint8_t *t = tmp_d.data();
+            std::size_t bytes = (vl + 7) / 8;
+
+            for (std::size_t i = 0; i < bytes; i++) {
+                unsigned int x = a[i];
+                unsigned int y = b[i];
+                unsigned int r;
+                switch (f6) {
+                    case 0b011000:
+                        r = x & ~y;         // vmandn
+                        break;
+                    case 0b011001:
+                        r = x & y;          // vmand
+                        break;
+                    case 0b011010:
+                        r = x | y;          // vmor
+                        break;
+                    case 0b011011:
+                        r = x ^ y;          // vmxor
+                        break;
+                    case 0b011100:
+                        r = x | ~y;         // vmorn
+                        break;
+                    case 0b011101:
+                        r = ~(x & y);       // vmnand
+                        break;
+                    case 0b011110:
+                        r = ~(x | y);       // vmnor
+                        break;
+                    default:
+                        r = ~(x ^ y);       // vmxnor
+                        break;
+                }
+                t[i] = static_cast<std::uint8_t>(r);
+            }
+            commitMask(this->get_rd(), t);
+            info.sew = 1;
+            return true;
+        }
+    };
+}
+
+#endif
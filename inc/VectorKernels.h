@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file VectorKernels.h
+ * @brief Host SIMD kernels behind the RISC-V V extension
+ *
+ * Whole vector operations (all vl elements of a register group at once)
+ * executed with AVX2 or SSE2 when the host supports them, with a portable
+ * scalar fallback. The implementation is picked once at start-up.
+ *
+ * Element operands are little-endian arrays of SEW-bit elements, as stored
+ * in the vector register file. Operand order follows the ISA: @c a is vs2,
+ * @c b is vs1 (or the broadcast scalar), e.g. Sub computes a - b.
+ */
+#pragma once
+#ifndef VECTOR_KERNELS_H
+#define VECTOR_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace riscv_tlm {
+
+enum class VecBinOp : unsigned int {
+    Add, Sub, RSub,
+    And, Or, Xor,
+    MinU, Min, MaxU, Max,
+    Sll, Srl, Sra,
+    Mul, MulH, MulHU, MulHSU,
+    DivU, Div, RemU, Rem,
+    Count
+};
+
+enum class VecCmpOp : unsigned int {
+    Eq, Ne, LtU, Lt, LeU, Le, GtU, Gt,
+    Count
+};
+
+enum class VecRedOp : unsigned int {
+    Sum, And, Or, Xor, MinU, Min, MaxU, Max,
+    Count
+};
+
+class VectorKernels {
+public:
+    enum class HostIsa {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    /**
+     * @brief Kernels for the best ISA of this host
+     */
+    static const VectorKernels &get();
+
+    /**
+     * @brief Kernels for a given ISA (falls back if the host lacks it)
+     */
+    static const VectorKernels &get(HostIsa isa);
+
+    HostIsa isa() const {
+        return host_isa;
+    }
+
+    static const char *isaName(HostIsa isa);
+
+    /**
+     * @brief dst[i] = a[i] op b[i], i < n; dst may alias a or b
+     * @param sew element width in bits (8, 16, 32 or 64)
+     */
+    void binary(VecBinOp op, unsigned int sew, void *dst, const void *a, const void *b,
+                std::size_t n) const {
+        bin[static_cast<unsigned int>(op)][sewIndex(sew)](dst, a, b, n);
+    }
+
+    /**
+     * @brief Mask bit i = a[i] cmp b[i], i < n; bits from n on are not written
+     */
+    void compare(VecCmpOp op, unsigned int sew, std::uint8_t *mask, const void *a, const void *b,
+                 std::size_t n) const {
+        cmp[static_cast<unsigned int>(op)][sewIndex(sew)](mask, a, b, n);
+    }
+
+    /**
+     * @brief Fold n elements of @p a into @p init
+     * @return result truncated to SEW bits, zero extended
+     */
+    std::uint64_t reduce(VecRedOp op, unsigned int sew, const void *a, std::size_t n,
+                         std::uint64_t init) const {
+        return red[static_cast<unsigned int>(op)][sewIndex(sew)](a, n, init);
+    }
+
+    /**
+     * @brief dst[i] = mask bit i ? src[i] : dst[i]
+     */
+    static void merge(unsigned int sew, void *dst, const void *src, const std::uint8_t *mask,
+                      std::size_t n);
+
+    /**
+     * @brief dst[i] = value for n elements
+     */
+    static void splat(unsigned int sew, void *dst, std::uint64_t value, std::size_t n);
+
+    static inline unsigned int sewIndex(unsigned int sew) {
+        return sew == 8 ? 0 : sew == 16 ? 1 : sew == 32 ? 2 : 3;
+    }
+
+    using BinFn = void (*)(void *, const void *, const void *, std::size_t);
+    using CmpFn = void (*)(std::uint8_t *, const void *, const void *, std::size_t);
+    using RedFn = std::uint64_t (*)(const void *, std::size_t, std::uint64_t);
+
+private:
+    explicit VectorKernels(HostIsa isa);
+
+    HostIsa host_isa;
+    BinFn bin[static_cast<unsigned int>(VecBinOp::Count)][4];
+    CmpFn cmp[static_cast<unsigned int>(VecCmpOp::Count)][4];
+    RedFn red[static_cast<unsigned int>(VecRedOp::Count)][4];
+};
+
+} // namespace riscv_tlm
+
+#endif // VECTOR_KERNELS_H
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file VirtioNet.h
+ * @brief virtio-mmio network device on a shared-memory Ethernet segment
+ *
+ * Virtio 1.x over MMIO (register layout version 2) with split virtqueues:
+ * queue 0 receives, queue 1 transmits. The device offers VIRTIO_F_VERSION_1,
+ * VIRTIO_NET_F_MAC and VIRTIO_NET_F_STATUS, so every buffer starts with the
+ * 12-byte virtio_net_hdr and no offloads are negotiated. Frames go to and
+ * come from a NetLink port (NetLink.h), which models latency and bandwidth
+ * in simulated time. Without a port the slot reports device ID 0 (no
+ * device), as an unused virtio-mmio slot does.
+ *
+ * Descriptors and buffers are read and written through mem_master in bus
+ * words, and the time the bus takes is charged to the transfer. Frames
+ * larger than the receive buffers are truncated. The interrupt is
+ * level-triggered and stays high while InterruptStatus is non-zero.
+ */
+#pragma once
+#ifndef INC_VIRTIONET_H_
+#define INC_VIRTIONET_H_
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "systemc"
+#include "tlm.h"
+#include "tlm_utils/simple_initiator_socket.h"
+#include "tlm_utils/simple_target_socket.h"
+
+#include "NetLink.h"
+
+namespace riscv_tlm::peripherals {
+
+    class VirtioNet : public sc_core::sc_module {
+    public:
+        tlm_utils::simple_target_socket<VirtioNet> socket;          ///< registers
+        tlm_utils::simple_initiator_socket<VirtioNet> mem_master;   ///< virtqueues and buffers
+
+        static constexpr std::uint32_t PLIC_SOURCE = 8;
+        static constexpr std::uint32_t QUEUE_SIZE = 256;
+
+        /* register map */
+        static constexpr std::uint64_t MAGIC_VALUE = 0x000;
+        static constexpr std::uint64_t VERSION = 0x004;
+        static constexpr std::uint64_t DEVICE_ID = 0x008;
+        static constexpr std::uint64_t VENDOR_ID = 0x00c;
+        static constexpr std::uint64_t DEVICE_FEATURES = 0x010;
+        static constexpr std::uint64_t DEVICE_FEATURES_SEL = 0x014;
+        static constexpr std::uint64_t DRIVER_FEATURES = 0x020;
+        static constexpr std::uint64_t DRIVER_FEATURES_SEL = 0x024;
+        static constexpr std::uint64_t QUEUE_SEL = 0x030;
+        static constexpr std::uint64_t QUEUE_NUM_MAX = 0x034;
+        static constexpr std::uint64_t QUEUE_NUM = 0x038;
+        static constexpr std::uint64_t QUEUE_READY = 0x044;
+        static constexpr std::uint64_t QUEUE_NOTIFY = 0x050;
+        static constexpr std::uint64_t INTERRUPT_STATUS = 0x060;
+        static constexpr std::uint64_t INTERRUPT_ACK = 0x064;
+        static constexpr std::uint64_t STATUS = 0x070;
+        static constexpr std::uint64_t QUEUE_DESC_LOW = 0x080;
+        static constexpr std::uint64_t QUEUE_DESC_HIGH = 0x084;
+        static constexpr std::uint64_t QUEUE_DRIVER_LOW = 0x090;
+        static constexpr std::uint64_t QUEUE_DRIVER_HIGH = 0x094;
+        static constexpr std::uint64_t QUEUE_DEVICE_LOW = 0x0a0;
+        static constexpr std::uint64_t QUEUE_DEVICE_HIGH = 0x0a4;
+        static constexpr std::uint64_t CONFIG_GENERATION = 0x0fc;
+        static constexpr std::uint64_t CONFIG = 0x100;      ///< mac[6], status
+        static constexpr std::uint64_t CONFIG_SIZE = 8;
+
+        SC_HAS_PROCESS(VirtioNet);
+
+        /**
+         * @param link port of the segment the device is plugged into, if any
+         */
+        explicit VirtioNet(sc_core::sc_module_name const &name, NetLink *link = nullptr);
+
+        /**
+         * @brief Where the interrupt level goes, e.g. PLIC::set_irq(PLIC_SOURCE, level)
+         */
+        void onInterrupt(std::function<void(bool)> handler) {
+            m_on_interrupt = std::move(handler);
+        }
+
+        /**
+         * @brief Frames lost because the driver was not ready or posted no buffers in time
+         */
+        std::uint64_t rxDropped() const {
+            return m_rx_dropped;
+        }
+
+    private:
+        static constexpr std::size_t NET_HDR_SIZE = 12;
+        static constexpr std::size_t MAX_PENDING = 256;
+
+        struct Queue {
+            std::uint32_t num{0};
+            std::uint32_t ready{0};
+            std::uint64_t desc{0};
+            std::uint64_t driver{0};        ///< available ring
+            std::uint64_t device{0};        ///< used ring
+            std::uint16_t last_avail{0};
+            std::uint16_t used_idx{0};
+        };
+
+        struct Descriptor {
+            std::uint64_t addr;
+            std::uint32_t len;
+            std::uint16_t flags;
+            std::uint16_t next;
+        };
+
+        void b_transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay);
+
+        std::uint32_t readRegister(std::uint64_t addr) const;
+
+        void writeRegister(std::uint64_t addr, std::uint32_t value);
+
+        void reset();
+
+        void receive(const std::uint8_t *frame, std::size_t length);
+
+        void rx_thread();
+
+        void tx_thread();
+
+        bool driverOk() const;
+
+        /**
+         * @brief Head of the next chain the driver made available, if any
+         */
+        bool nextAvail(Queue &q, std::uint16_t &head, sc_core::sc_time &delay);
+
+        /**
+         * @brief Return a chain to the driver, and interrupt unless it asked not to be
+         */
+        void putUsed(Queue &q, std::uint16_t head, std::uint32_t len, sc_core::sc_time &delay);
+
+        Descriptor readDescriptor(const Queue &q, std::uint16_t index, sc_core::sc_time &delay);
+
+        void updateLine();
+
+        /**
+         * @brief Guest memory access in bus words; adds the bus time to @p delay
+         */
+        void dma(tlm::tlm_command cmd, std::uint64_t addr, std::uint8_t *data, std::size_t len,
+                 sc_core::sc_time &delay);
+
+        std::uint16_t load16(std::uint64_t addr, sc_core::sc_time &delay);
+
+        void store16(std::uint64_t addr, std::uint16_t value, sc_core::sc_time &delay);
+
+        NetLink *m_link;
+        std::function<void(bool)> m_on_interrupt;
+        bool m_line{false};
+
+        std::uint32_t m_device_features_sel{0};
+        std::uint32_t m_driver_features_sel{0};
+        std::uint64_t m_driver_features{0};
+        std::uint32_t m_queue_sel{0};
+        std::uint32_t m_status{0};
+        std::uint32_t m_isr{0};
+        std::array<Queue, 2> m_queues;
+        std::array<std::uint8_t, CONFIG_SIZE> m_config{};
+
+        std::deque<std::vector<std::uint8_t>> m_rx_frames;
+        std::uint64_t m_rx_dropped{0};
+        sc_core::sc_event m_rx_event;
+        sc_core::sc_event m_tx_event;
+    };
+}
+
+#endif /* INC_VIRTIONET_H_ */
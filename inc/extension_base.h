@@ -14,6 +14,8 @@
 #include "Instruction.h"
 #include "Registers.h"
 #include "MemoryInterface.h"
+#include "PluginManager.h"
+#include "FaultCampaign.h"
 
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/basic_file_sink.h"
@@ -28,16 +30,16 @@ namespace riscv_tlm {
         BREAK = 3,
         LOAD_ADDR_MISALIGN = 4,
         LOAD_ACCESS_FAULT = 5,
+        STORE_ADDR_MISALIGN = 6,
+        STORE_ACCESS_FAULT = 7,
+        CALL_FROM_U_MODE = 8,
+        CALL_FROM_S_MODE = 9,
         CALL_FROM_M_MODE = 11,
+        INSTRUCTION_PAGE_FAULT = 12,
+        LOAD_PAGE_FAULT = 13,
+        STORE_PAGE_FAULT = 15,
     } Exception_cause;
 
-    typedef enum {
-        User = 0,
-        Supervisor = 1,
-        Reserved = 2,
-        Machine = 3,
-    } PrivilegeMode;
-
     template<typename T>
     class extension_base {
 
@@ -59,38 +61,65 @@ namespace riscv_tlm {
             m_instr = sc_dt::sc_uint<32>(p_instr);
         }
 
-        void RaiseException(Exception_cause cause, std::uint32_t inst) {
-            std::uint32_t new_pc, current_pc, m_cause;
+        /**
+         * @brief Take a synchronous exception
+         *
+         * Traps to S-mode when raised below M-mode and delegated in medeleg,
+         * to M-mode otherwise.
+         * @param inst instruction bits, for xtval on illegal instructions
+         * @param tval faulting address, for xtval on page and access faults
+         */
+        void RaiseException(Exception_cause cause, std::uint32_t inst, std::uint64_t tval = 0) {
+            T new_pc, current_pc, trap_value;
 
             current_pc = regs->getPC();
-            m_cause = regs->getCSR(CSR_MSTATUS);
-            m_cause |= static_cast<uint32_t>(cause);
-
-            new_pc = regs->getCSR(CSR_MTVEC);
-
-            regs->setCSR(CSR_MEPC, current_pc);
 
             if (cause == Exception_cause::ILLEGAL_INSTRUCTION) {
-                regs->setCSR(CSR_MTVAL, inst);
+                trap_value = inst;
             } else if (cause == Exception_cause::LOAD_ADDR_MISALIGN) {
-                regs->setCSR(CSR_MTVAL, current_pc);
-            } else if (cause == Exception_cause::BREAK) {
-                sc_core::sc_stop();
+                trap_value = current_pc;
+            } else if (cause == Exception_cause::INSTRUCTION_ACCESS
+                       || cause == Exception_cause::LOAD_ACCESS_FAULT
+                       || cause == Exception_cause::STORE_ACCESS_FAULT
+                       || cause == Exception_cause::INSTRUCTION_PAGE_FAULT
+                       || cause == Exception_cause::LOAD_PAGE_FAULT
+                       || cause == Exception_cause::STORE_PAGE_FAULT) {
+                trap_value = static_cast<T>(tval);
+            } else {
+                if (cause == Exception_cause::BREAK) {
+                    sc_core::sc_stop();
+                }
+                trap_value = 0;
+            }
+
+            if (regs->getPrivilege() != Machine && ((regs->getCSR(CSR_MEDELEG) >> cause) & 1)) {
+                regs->setCSR(CSR_SEPC, current_pc);
+                regs->setCSR(CSR_SCAUSE, static_cast<T>(cause));
+                regs->setCSR(CSR_STVAL, trap_value);
+                regs->enterTrap(Supervisor);
+                new_pc = regs->trapVector(CSR_STVEC, cause, false);
             } else {
-                regs->setCSR(CSR_MTVAL, 0);
+                regs->setCSR(CSR_MEPC, current_pc);
+                regs->setCSR(CSR_MCAUSE, regs->machineCause(static_cast<T>(cause)));
+                regs->setCSR(CSR_MTVAL, trap_value);
+                regs->enterTrap(Machine);
+                new_pc = regs->trapVector(CSR_MTVEC, cause, false);
             }
 
-            regs->setCSR(CSR_MCAUSE, static_cast<uint32_t>(cause));
-            regs->setCSR(CSR_MSTATUS, m_cause);
             regs->setPC(new_pc);
+            FaultCampaign::exception(static_cast<std::uint64_t>(cause));
 
-            logger->debug("{} ns. PC: 0x{:x}. Exception! new PC 0x{:x} ", sc_core::sc_time_stamp().value(),
+            if (PluginManager::active()) {
+                PluginManager::getInstance()->onTrap(static_cast<std::uint64_t>(cause), current_pc);
+            }
+
+            logger->debug("{} ps. PC: 0x{:x}. Exception! new PC 0x{:x} ", sc_core::sc_time_stamp().value(),
                           current_pc, new_pc);
 
         }
 
         bool NOP() {
-            logger->debug("{} ns. PC: 0x{:x}. NOP! new PC 0x{:x} ", sc_core::sc_time_stamp().value(), regs->getPC(), regs->getPC() + 4);
+            logger->debug("{} ps. PC: 0x{:x}. NOP! new PC 0x{:x} ", sc_core::sc_time_stamp().value(), regs->getPC(), regs->getPC() + 4);
             logger->flush();
             sc_core::sc_stop();
             return true;
@@ -145,8 +174,6 @@ namespace riscv_tlm {
         Performance *perf;
         MemoryInterface *mem_intf;
         std::shared_ptr<spdlog::logger> logger;
-
-        PrivilegeMode privilege_mode = PrivilegeMode::Supervisor;
     };
 }
 
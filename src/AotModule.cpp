@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file AotModule.cpp
+ * @brief Loader for ahead-of-time translated programs
+ */
+
+#include "AotModule.h"
+
+#include <fstream>
+
+#if !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+namespace riscv_tlm {
+
+std::unique_ptr<AotModule> AotModule::load(const std::string &dir, std::uint64_t hash, std::string &error) {
+    std::string path = dir.empty() ? fileName(hash) : dir + "/" + fileName(hash);
+
+#if defined(_WIN32)
+    (void) path;
+    error = "translated programs are not supported on this platform";
+    return nullptr;
+#else
+    if (!std::ifstream(path).good()) {
+        error = "no translation " + path;
+        return nullptr;
+    }
+
+    void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        error = std::string("cannot load ") + path + ": " + dlerror();
+        return nullptr;
+    }
+
+    auto *version = static_cast<const int *>(dlsym(handle, "rvvp_aot_version"));
+    auto *image = static_cast<const std::uint64_t *>(dlsym(handle, "rvvp_aot_image_hash"));
+    auto *count = static_cast<const std::uint32_t *>(dlsym(handle, "rvvp_aot_block_count"));
+    auto *blocks = static_cast<const rvvp_aot_block_t *>(dlsym(handle, "rvvp_aot_blocks"));
+
+    if (version == nullptr || image == nullptr || count == nullptr || blocks == nullptr) {
+        error = path + " is not a translated program";
+    } else if (*version != RVVP_AOT_VERSION) {
+        error = path + " was translated for version " + std::to_string(*version) + ", simulator provides " +
+                std::to_string(RVVP_AOT_VERSION);
+    } else if (*image != hash) {
+        error = path + " was translated from another image";
+    } else {
+        std::unique_ptr<AotModule> module(new AotModule());
+        module->m_handle = handle;
+        module->m_path = path;
+        module->m_blocks.reserve(*count);
+        for (std::uint32_t i = 0; i < *count; i++) {
+            module->m_blocks.emplace(blocks[i].pc, blocks[i].fn);
+        }
+        return module;
+    }
+    dlclose(handle);
+    return nullptr;
+#endif
+}
+
+AotModule::~AotModule() {
+#if !defined(_WIN32)
+    if (m_handle != nullptr) {
+        dlclose(m_handle);
+    }
+#endif
+}
+
+} // namespace riscv_tlm
@@ -101,7 +101,7 @@ namespace riscv_tlm {
         calc = static_cast<unsigned_T>(this->regs->getValue(rs1)) << shift;
         this->regs->setValue(rd, calc);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. SLLI: x{:d} << {:d} -> x{:d}(0x{:x})",
+        this->logger->debug("{} ps. PC: 0x{:x}. SLLI: x{:d} << {:d} -> x{:d}(0x{:x})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, shift, rd, calc);
@@ -124,7 +124,7 @@ namespace riscv_tlm {
         calc = static_cast<unsigned_T>(this->regs->getValue(rs1)) >> shift;
         this->regs->setValue(rd, calc);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. SRLI: x{:d} >> {:d} -> x{:d}(0x{:x})",
+        this->logger->debug("{} ps. PC: 0x{:x}. SRLI: x{:d} >> {:d} -> x{:d}(0x{:x})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, shift, rd, calc);
@@ -147,7 +147,7 @@ namespace riscv_tlm {
         calc = static_cast<signed_T>(this->regs->getValue(rs1)) >> shift;
         this->regs->setValue(rd, calc);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. SRAI: x{:d} >> {:d} -> x{:d}(0x{:x})",
+        this->logger->debug("{} ps. PC: 0x{:x}. SRAI: x{:d} >> {:d} -> x{:d}(0x{:x})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, shift, rd, calc);
@@ -170,7 +170,7 @@ namespace riscv_tlm {
 
         this->regs->setValue(rd, calc);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. SRL: x{:d} >> {:d} -> x{:d}(0x{:x})",
+        this->logger->debug("{} ps. PC: 0x{:x}. SRL: x{:d} >> {:d} -> x{:d}(0x{:x})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, shift, rd, calc);
@@ -192,7 +192,7 @@ namespace riscv_tlm {
         calc = static_cast<signed_T>(this->regs->getValue(rs1)) >> shift;
         this->regs->setValue(rd, calc);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. SRA: x{:d} >> {:d} -> x{:d}(0x{:x})",
+        this->logger->debug("{} ps. PC: 0x{:x}. SRA: x{:d} >> {:d} -> x{:d}(0x{:x})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, shift, rd, calc);
@@ -215,7 +215,7 @@ namespace riscv_tlm {
         calc = this->regs->getValue(rs1) << shift;
         this->regs->setValue(rd, calc);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. SLL: x{:d} << x{:d} -> x{:d}(0x{:x})",
+        this->logger->debug("{} ps. PC: 0x{:x}. SLL: x{:d} << x{:d} -> x{:d}(0x{:x})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, shift, rd, calc);
@@ -316,7 +316,7 @@ namespace riscv_tlm {
 
         this->regs->setValue(rd, calc);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. SLLI: x{:d} << {:d} -> x{:d}(0x{:x})",
+        this->logger->debug("{} ps. PC: 0x{:x}. SLLI: x{:d} << {:d} -> x{:d}(0x{:x})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, shift, rd, calc);
@@ -339,7 +339,7 @@ namespace riscv_tlm {
         calc = static_cast<unsigned_T>(this->regs->getValue(rs1)) >> shift;
         this->regs->setValue(rd, calc);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. SRLI: x{:d} >> {:d} -> x{:d}(0x{:x})",
+        this->logger->debug("{} ps. PC: 0x{:x}. SRLI: x{:d} >> {:d} -> x{:d}(0x{:x})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, shift, rd, calc);
@@ -362,7 +362,7 @@ namespace riscv_tlm {
         calc = static_cast<signed_T>(static_cast<signed_T>(this->regs->getValue(rs1)) >> shift);
         this->regs->setValue(rd, calc);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. SRAI: x{:d} >> {:d} -> x{:d}(0x{:x})",
+        this->logger->debug("{} ps. PC: 0x{:x}. SRAI: x{:d} >> {:d} -> x{:d}(0x{:x})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, shift, rd, calc);
@@ -385,7 +385,7 @@ namespace riscv_tlm {
 
         this->regs->setValue(rd, calc);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. SRL: x{:d} >> {:d} -> x{:d}(0x{:x})",
+        this->logger->debug("{} ps. PC: 0x{:x}. SRL: x{:d} >> {:d} -> x{:d}(0x{:x})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, shift, rd, calc);
@@ -407,7 +407,7 @@ namespace riscv_tlm {
         calc = static_cast<signed_T>(this->regs->getValue(rs1)) >> shift;
         this->regs->setValue(rd, calc);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. SRA: x{:d} >> {:d} -> x{:d}(0x{:x})",
+        this->logger->debug("{} ps. PC: 0x{:x}. SRA: x{:d} >> {:d} -> x{:d}(0x{:x})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, shift, rd, calc);
@@ -430,7 +430,7 @@ namespace riscv_tlm {
         calc = this->regs->getValue(rs1) << shift;
         this->regs->setValue(rd, calc);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. SLL: x{:d} << x{:d} -> x{:d}(0x{:x})",
+        this->logger->debug("{} ps. PC: 0x{:x}. SLL: x{:d} << x{:d} -> x{:d}(0x{:x})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, shift, rd, calc);
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file BitManip.cpp
+ * @brief Carry-less multiply on PCLMULQDQ or in software
+ */
+
+#include "BitManip.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BITMANIP_HOST_X86_64 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define BITMANIP_TARGET_PCLMUL
+#else
+#define BITMANIP_TARGET_PCLMUL __attribute__((target("pclmul,sse2")))
+#endif
+#else
+#define BITMANIP_HOST_X86_64 0
+#endif
+
+namespace riscv_tlm {
+
+namespace bitmanip {
+
+namespace {
+
+ClmulResult clmulScalar(std::uint64_t a, std::uint64_t b) {
+    ClmulResult r{0, 0};
+    for (unsigned int i = 0; i < 64; i++) {
+        if ((b >> i) & 1) {
+            r.lo ^= a << i;
+            if (i != 0) {
+                r.hi ^= a >> (64 - i);
+            }
+        }
+    }
+    return r;
+}
+
+#if BITMANIP_HOST_X86_64
+BITMANIP_TARGET_PCLMUL
+ClmulResult clmulPclmul(std::uint64_t a, std::uint64_t b) {
+    __m128i va = _mm_cvtsi64_si128(static_cast<long long>(a));
+    __m128i vb = _mm_cvtsi64_si128(static_cast<long long>(b));
+    __m128i p = _mm_clmulepi64_si128(va, vb, 0x00);
+    return {static_cast<std::uint64_t>(_mm_cvtsi128_si64(p)),
+            static_cast<std::uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(p, p)))};
+}
+
+bool hostHasPclmul() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul");
+#endif
+}
+#endif
+
+using ClmulFn = ClmulResult (*)(std::uint64_t, std::uint64_t);
+
+ClmulFn pickClmul() {
+#if BITMANIP_HOST_X86_64
+    if (hostHasPclmul()) {
+        return clmulPclmul;
+    }
+#endif
+    return clmulScalar;
+}
+
+const ClmulFn clmul_impl = pickClmul();
+
+} // namespace
+
+ClmulResult clmul(std::uint64_t a, std::uint64_t b) {
+    return clmul_impl(a, b);
+}
+
+bool clmulIsNative() {
+    return clmul_impl != clmulScalar;
+}
+
+} // namespace bitmanip
+
+} // namespace riscv_tlm
@@ -6,44 +6,82 @@
 
 #include "BusCtrl.h"
 
+#include <cstring>
+
+#include "ClockDomains.h"
+#include "ExecutionHistory.h"
+#include "FaultCampaign.h"
+#include "SelfProfile.h"
+#include "TlmBridge.h"
+
 namespace riscv_tlm {
 
     SC_HAS_PROCESS(BusCtrl);
 
-    BusCtrl::BusCtrl(sc_core::sc_module_name const &name) :
+    BusCtrl::BusCtrl(sc_core::sc_module_name const &name, const BridgeSpec *bridge) :
             sc_module(name),
             cpu_instr_socket("cpu_instr_socket"),
             cpu_data_socket("cpu_data_socket"),
             dma_master_socket("dma_master_socket"),
+            net_master_socket("net_master_socket"),
             memory_socket("memory_socket"),
             trace_socket("trace_socket"),
             timer_socket("timer_socket"),
             uart_socket("uart_socket"),
             clint_socket("clint_socket"),
             plic_socket("plic_socket"),
+            clic_socket("clic_socket"),
             dma_socket("dma_socket"),
-            syscall_socket("syscall_socket") {
+            syscall_socket("syscall_socket"),
+            dvfs_socket("dvfs_socket"),
+            net_socket("net_socket") {
 
         // All masters enter through the same b_transport
         cpu_instr_socket.register_b_transport(this, &BusCtrl::b_transport);
         cpu_data_socket.register_b_transport(this, &BusCtrl::b_transport);
         dma_master_socket.register_b_transport(this, &BusCtrl::b_transport);
+        net_master_socket.register_b_transport(this, &BusCtrl::b_transport);
 
         cpu_instr_socket.register_get_direct_mem_ptr(this,
                                                      &BusCtrl::instr_direct_mem_ptr);
+        cpu_data_socket.register_get_direct_mem_ptr(this,
+                                                    &BusCtrl::data_direct_mem_ptr);
         memory_socket.register_invalidate_direct_mem_ptr(this,
                                                          &BusCtrl::invalidate_direct_mem_ptr);
+        for (auto *socket : {&trace_socket, &timer_socket, &uart_socket, &clint_socket, &plic_socket, &clic_socket,
+                             &dma_socket, &syscall_socket, &dvfs_socket, &net_socket}) {
+            socket->register_invalidate_direct_mem_ptr(this, &BusCtrl::invalidate_peripheral_dmi);
+        }
+
+        if (bridge != nullptr && bridge->role != BridgeSpec::Role::None) {
+            bridge_socket.reset(new tlm_utils::simple_initiator_socket<BusCtrl>("bridge_socket"));
+            bridge_socket->register_invalidate_direct_mem_ptr(this, &BusCtrl::invalidate_peripheral_dmi);
+            bridge_base = bridge->base;
+            if (bridge->role == BridgeSpec::Role::Out) {
+                bridge_size = bridge->size;
+            } else {
+                bridge_size = 0x10;     // interrupt doorbell
+                bridge_master_socket.reset(new tlm_utils::simple_target_socket<BusCtrl>("bridge_master_socket"));
+                bridge_master_socket->register_b_transport(this, &BusCtrl::b_transport);
+            }
+        }
     }
 
     void BusCtrl::b_transport(tlm::tlm_generic_payload &trans,
                               sc_core::sc_time &delay) {
+        RVVP_PROFILE_SCOPE(Bus);
 
         sc_dt::uint64 adr_bytes = trans.get_address();
         sc_dt::uint64 adr = adr_bytes / 4;
 
+        if (ClockDomains::timedAccesses()) {
+            delay += ClockDomains::getInstance()->domain(ClockDomains::BUS).accessTime();
+        }
+
         // Specific check for legacy TO_HOST (0x90000000)
         // Check EXACT match avoid trapping high memory usage (stack)
         if (adr == TO_HOST_ADDRESS / 4) {
+            FaultCampaign::observe(trans);
             std::cout << "To host (legacy)\n" << std::flush;
             trans.set_response_status(tlm::TLM_OK_RESPONSE);
             sc_core::sc_stop();
@@ -60,6 +98,7 @@ namespace riscv_tlm {
                      memcpy(&val, trans.get_data_ptr(), 4);
                  }
                  if (val != 0) { // Only stop if non-zero is written (return code)
+                     FaultCampaign::observe(trans);
                      std::cout << "To host (0x80001000) detected. termination code: " << val << "\n" << std::flush;
                      sc_core::sc_stop();
                      return;
@@ -69,51 +108,54 @@ namespace riscv_tlm {
 
         // Decode by region (simple range checks). Optional targets are checked for binding.
         if (adr_bytes >= UART0_BASE_ADDRESS && adr_bytes < UART0_BASE_ADDRESS + 0x100) {
-            if (uart_socket.size() > 0) {
-                uart_socket->b_transport(trans, delay);
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            forward(uart_socket, UART0_BASE_ADDRESS, trans, delay);
             return;
         }
         if (adr_bytes >= CLINT_BASE_ADDRESS && adr_bytes < CLINT_BASE_ADDRESS + 0x10000) {
-            if (clint_socket.size() > 0) {
-                clint_socket->b_transport(trans, delay);
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            forward(clint_socket, CLINT_BASE_ADDRESS, trans, delay);
+            return;
+        }
+        if (adr_bytes >= CLIC_BASE_ADDRESS && adr_bytes < CLIC_BASE_ADDRESS + 0x10000) {
+            forward(clic_socket, CLIC_BASE_ADDRESS, trans, delay);
             return;
         }
         if (adr_bytes >= PLIC_BASE_ADDRESS && adr_bytes < PLIC_BASE_ADDRESS + 0x400000) {
-            if (plic_socket.size() > 0) {
-                plic_socket->b_transport(trans, delay);
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            forward(plic_socket, PLIC_BASE_ADDRESS, trans, delay);
             return;
         }
         if (adr_bytes >= DMA_BASE_ADDRESS && adr_bytes < DMA_BASE_ADDRESS + 0x1000) {
-            if (dma_socket.size() > 0) {
-                dma_socket->b_transport(trans, delay);
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            forward(dma_socket, DMA_BASE_ADDRESS, trans, delay);
+            return;
+        }
+        if (adr_bytes >= VIRTIO_NET_BASE_ADDRESS && adr_bytes < VIRTIO_NET_BASE_ADDRESS + 0x1000) {
+            forward(net_socket, VIRTIO_NET_BASE_ADDRESS, trans, delay);
             return;
         }
         if (adr_bytes >= SYSCALL_BASE_ADDRESS && adr_bytes < SYSCALL_BASE_ADDRESS + 0x1000) {
-            if (syscall_socket.size() > 0) {
-                syscall_socket->b_transport(trans, delay);
-            }
-            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            forward(syscall_socket, SYSCALL_BASE_ADDRESS, trans, delay);
             return;
         }
 
+        if (adr_bytes >= DVFS_BASE_ADDRESS && adr_bytes < DVFS_BASE_ADDRESS + 0x100) {
+            forward(dvfs_socket, DVFS_BASE_ADDRESS, trans, delay);
+            return;
+        }
+        if (adr_bytes >= bridge_base && adr_bytes - bridge_base < bridge_size) {
+            forward(*bridge_socket, bridge_base, trans, delay);
+            return;
+        }
+
+        // The trace port decodes absolute addresses
         switch (adr) {
             case TIMER_MEMORY_ADDRESS_HI / 4:
             case TIMER_MEMORY_ADDRESS_LO / 4:
             case TIMERCMP_MEMORY_ADDRESS_HI / 4:
             case TIMERCMP_MEMORY_ADDRESS_LO / 4:
-                timer_socket->b_transport(trans, delay);
-                break;
+                forward(timer_socket, TIMER_MEMORY_ADDRESS_LO, trans, delay);
+                return;
             case TRACE_MEMORY_ADDRESS / 4:
-                trace_socket->b_transport(trans, delay);
-                break;
+                forward(trace_socket, 0, trans, delay);
+                return;
             default:
                 memory_socket->b_transport(trans, delay);
                 break;
@@ -122,13 +164,135 @@ namespace riscv_tlm {
         trans.set_response_status(tlm::TLM_OK_RESPONSE);
     }
 
+    void BusCtrl::forward(tlm_utils::simple_initiator_socket<BusCtrl> &target, sc_dt::uint64 base,
+                          tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+        // Peripherals decode offsets into their own window
+        if (target.size() > 0) {
+            RVVP_PROFILE_SCOPE(Peripherals);
+            FaultCampaign::observe(trans);
+            // Re-executing for the debugger: peripheral state is already in the present
+            ExecutionHistory *history = ExecutionHistory::active() ? ExecutionHistory::getInstance() : nullptr;
+            if (history == nullptr && trans.is_read() && readDirect(target, base, trans, delay)) {
+                trans.set_response_status(tlm::TLM_OK_RESPONSE);
+                return;
+            }
+            if (history == nullptr || !history->replayAccess(trans)) {
+                const sc_dt::uint64 addr = trans.get_address();
+                trans.set_address(addr - base);
+                target->b_transport(trans, delay);
+                trans.set_address(addr);
+                if (history != nullptr) {
+                    history->recordAccess(trans);
+                }
+            }
+        }
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+
+    bool BusCtrl::readDirect(tlm_utils::simple_initiator_socket<BusCtrl> &target, sc_dt::uint64 base,
+                             tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+        if (trans.get_byte_enable_ptr() != nullptr || trans.get_data_length() == 0) {
+            return false;
+        }
+        const sc_dt::uint64 start = trans.get_address() - base;
+        const sc_dt::uint64 end = start + trans.get_data_length() - 1;
+
+        /* one region per peripheral, replaced when a read falls outside it */
+        auto cached = peripheral_dmi.find(&target);
+        if (cached == peripheral_dmi.end() || start < cached->second.get_start_address()
+            || start > cached->second.get_end_address()) {
+            /* a denial is remembered for the whole range the peripheral reports */
+            tlm::tlm_generic_payload probe;
+            probe.set_command(tlm::TLM_READ_COMMAND);
+            probe.set_address(start);
+            tlm::tlm_dmi dmi_data;
+            if (!target->get_direct_mem_ptr(probe, dmi_data)) {
+                dmi_data.allow_none();
+            }
+            if (start < dmi_data.get_start_address() || start > dmi_data.get_end_address()) {
+                dmi_data.allow_none();
+                dmi_data.set_start_address(start);
+                dmi_data.set_end_address(start);
+            }
+            cached = peripheral_dmi.insert_or_assign(&target, dmi_data).first;
+        }
+
+        const tlm::tlm_dmi &region = cached->second;
+        if (!region.is_read_allowed() || end > region.get_end_address()) {
+            return false;
+        }
+        std::memcpy(trans.get_data_ptr(), region.get_dmi_ptr() + (start - region.get_start_address()),
+                    trans.get_data_length());
+        delay += region.get_read_latency();
+        return true;
+    }
+
     bool BusCtrl::instr_direct_mem_ptr(tlm::tlm_generic_payload &gp,
                                        tlm::tlm_dmi &dmi_data) {
         return memory_socket->get_direct_mem_ptr(gp, dmi_data);
     }
 
+    bool BusCtrl::data_direct_mem_ptr(tlm::tlm_generic_payload &gp,
+                                      tlm::tlm_dmi &dmi_data) {
+        /* Peripheral windows that alias the RAM range must stay on b_transport */
+        const struct {
+            sc_dt::uint64 base;
+            sc_dt::uint64 size;
+        } windows[] = {
+                {CLINT_BASE_ADDRESS, 0x10000},
+                {CLIC_BASE_ADDRESS, 0x10000},
+                {PLIC_BASE_ADDRESS, 0x400000},
+                {DMA_BASE_ADDRESS, 0x1000},
+                {VIRTIO_NET_BASE_ADDRESS, 0x1000},
+                {TRACE_MEMORY_ADDRESS, 4},
+                {TIMER_MEMORY_ADDRESS_LO, 0x10},
+                {UART0_BASE_ADDRESS, 0x100},
+                {SYSCALL_BASE_ADDRESS, 0x2000},     // includes tohost at 0x80001000
+                {TO_HOST_ADDRESS, 4},
+                {bridge_base, bridge_size},
+        };
+
+        sc_dt::uint64 addr = gp.get_address();
+        for (auto const &w : windows) {
+            if (addr >= w.base && addr < w.base + w.size) {
+                return false;
+            }
+        }
+
+        if (!memory_socket->get_direct_mem_ptr(gp, dmi_data)) {
+            return false;
+        }
+
+        /* Clip the granted region to the hole between neighbouring windows */
+        sc_dt::uint64 start = dmi_data.get_start_address();
+        sc_dt::uint64 end = dmi_data.get_end_address();
+        for (auto const &w : windows) {
+            if (w.base > addr && w.base <= end) {
+                end = w.base - 1;
+            } else if (w.base + w.size <= addr && w.base + w.size > start) {
+                start = w.base + w.size;
+            }
+        }
+        dmi_data.set_dmi_ptr(dmi_data.get_dmi_ptr() + (start - dmi_data.get_start_address()));
+        dmi_data.set_start_address(start);
+        dmi_data.set_end_address(end);
+        return true;
+    }
+
     void BusCtrl::invalidate_direct_mem_ptr(sc_dt::uint64 start,
                                             sc_dt::uint64 end) {
         cpu_instr_socket->invalidate_direct_mem_ptr(start, end);
+        cpu_data_socket->invalidate_direct_mem_ptr(start, end);
+    }
+
+    void BusCtrl::invalidate_peripheral_dmi(sc_dt::uint64 start, sc_dt::uint64 end) {
+        /* the callback does not say which peripheral; their offsets overlap, so drop every match */
+        for (auto it = peripheral_dmi.begin(); it != peripheral_dmi.end();) {
+            if (it->second.get_start_address() <= end && start <= it->second.get_end_address()) {
+                it = peripheral_dmi.erase(it);
+            } else {
+                ++it;
+            }
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file CLIC.cpp
+ * @brief CLIC register interface, trigger handling and arbitration
+ */
+
+#include "CLIC.h"
+#include "BitManip.h"
+
+#include <cstring>
+
+namespace riscv_tlm {
+
+    namespace {
+        constexpr std::uint64_t CLICCFG = 0x0000;
+        constexpr std::uint64_t CLICINFO = 0x0004;
+        constexpr std::uint64_t CLICINT_BASE = 0x1000;
+        constexpr unsigned int CLIC_VERSION = 0x09;
+    }
+
+    CLIC::CLIC(sc_core::sc_module_name const &name, unsigned int interrupts) :
+            sc_module(name), socket("socket"),
+            num_interrupts(interrupts == 0 ? 1 : (interrupts > MAX_INTERRUPTS ? MAX_INTERRUPTS : interrupts)),
+            ip(num_interrupts, 0), ie(num_interrupts, 0), attr(num_interrupts, ATTR_MODE_M),
+            ctl(num_interrupts, 0), line_state(num_interrupts, 0),
+            active((num_interrupts + 63) / 64, 0) {
+        socket.register_b_transport(this, &CLIC::b_transport);
+    }
+
+    void CLIC::raise(std::uint32_t id) {
+        if (id < num_interrupts) {
+            setPending(id, true);
+        }
+    }
+
+    void CLIC::set_irq(std::uint32_t id, bool line) {
+        if (id >= num_interrupts) {
+            return;
+        }
+        bool asserted = line != ((attr[id] & ATTR_NEGATIVE) != 0);
+        bool was_asserted = line_state[id] != ((attr[id] & ATTR_NEGATIVE) != 0);
+        line_state[id] = line;
+
+        if (!(attr[id] & ATTR_EDGE)) {
+            setPending(id, asserted);
+        } else if (asserted && !was_asserted) {
+            setPending(id, true);
+        }
+    }
+
+    void CLIC::acknowledge(std::uint32_t id) {
+        if (id < num_interrupts && (attr[id] & ATTR_EDGE)) {
+            setPending(id, false);
+        }
+    }
+
+    void CLIC::b_transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+        (void) delay;
+        std::uint64_t addr = trans.get_address();
+        unsigned char *ptr = trans.get_data_ptr();
+        unsigned int len = trans.get_data_length();
+
+        if (len == 0 || len > 4 || (addr & 3) + len > 4) {
+            trans.set_response_status(tlm::TLM_BURST_ERROR_RESPONSE);
+            return;
+        }
+
+        /* the interrupt registers are byte-wide; sb/lb and word accesses both work */
+        for (unsigned int i = 0; i < len; i++) {
+            if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+                writeByte(addr + i, ptr[i]);
+            } else {
+                ptr[i] = readByte(addr + i);
+            }
+        }
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+
+    std::uint8_t CLIC::readByte(std::uint64_t offset) const {
+        if (offset == CLICCFG) {
+            return static_cast<std::uint8_t>(nlbits << 1);
+        }
+        if (offset >= CLICINFO && offset < CLICINFO + 4) {
+            std::uint32_t info = (num_interrupts & 0x1FFF) | (CLIC_VERSION << 13) | (INTCTLBITS << 21);
+            return static_cast<std::uint8_t>(info >> ((offset - CLICINFO) * 8));
+        }
+        if (offset >= CLICINT_BASE && offset < CLICINT_BASE + 4ULL * num_interrupts) {
+            std::uint32_t id = static_cast<std::uint32_t>((offset - CLICINT_BASE) / 4);
+            switch ((offset - CLICINT_BASE) % 4) {
+                case 0:
+                    return ip[id];
+                case 1:
+                    return ie[id];
+                case 2:
+                    return attr[id];
+                default:
+                    return ctl[id];
+            }
+        }
+        return 0;
+    }
+
+    void CLIC::writeByte(std::uint64_t offset, std::uint8_t value) {
+        if (offset == CLICCFG) {
+            nlbits = (value >> 1) & 0xF;
+            if (nlbits > 8) {
+                nlbits = 8;
+            }
+            dirty = true;
+            return;
+        }
+        if (offset < CLICINT_BASE || offset >= CLICINT_BASE + 4ULL * num_interrupts) {
+            return;
+        }
+
+        std::uint32_t id = static_cast<std::uint32_t>((offset - CLICINT_BASE) / 4);
+        switch ((offset - CLICINT_BASE) % 4) {
+            case 0:
+                /* the pending bit of a level-triggered interrupt follows its line */
+                if (attr[id] & ATTR_EDGE) {
+                    setPending(id, value & 1);
+                }
+                break;
+            case 1:
+                ie[id] = value & 1;
+                refresh(id);
+                break;
+            case 2:
+                /* only M-mode interrupts exist */
+                attr[id] = (value & (ATTR_SHV | ATTR_EDGE | ATTR_NEGATIVE)) | ATTR_MODE_M;
+                if (!(attr[id] & ATTR_EDGE)) {
+                    set_irq(id, line_state[id]);
+                }
+                dirty = true;
+                break;
+            default:
+                ctl[id] = value;
+                dirty = true;
+                break;
+        }
+    }
+
+    void CLIC::setPending(std::uint32_t id, bool value) {
+        ip[id] = value ? 1 : 0;
+        refresh(id);
+    }
+
+    void CLIC::refresh(std::uint32_t id) {
+        std::uint64_t &word = active[id / 64];
+        std::uint64_t bit = 1ULL << (id % 64);
+        bool now = ip[id] && ie[id];
+        if (now != ((word & bit) != 0)) {
+            word ^= bit;
+            active_count += now ? 1 : -1;
+        }
+        dirty = true;
+    }
+
+    void CLIC::arbitrate() {
+        /* highest clicintctl wins (level, then priority), then the highest id */
+        int best_id = -1;
+        unsigned int best_ctl = 0;
+        for (unsigned int w = 0; w < active.size(); w++) {
+            for (std::uint64_t bits = active[w]; bits != 0; bits &= bits - 1) {
+                unsigned int id = w * 64 + bitmanip::ctz(bits);
+                if (best_id < 0 || ctl[id] >= best_ctl) {
+                    best_id = static_cast<int>(id);
+                    best_ctl = ctl[id];
+                }
+            }
+        }
+
+        if (best_id >= 0) {
+            best.id = static_cast<std::uint32_t>(best_id);
+            best.level = levelOf(static_cast<std::uint8_t>(best_ctl));
+            best.shv = (attr[best_id] & ATTR_SHV) != 0;
+        } else {
+            best = Request{};
+        }
+        dirty = false;
+    }
+
+    std::uint8_t CLIC::levelOf(std::uint8_t control) const {
+        if (nlbits == 0) {
+            return 0xFF;
+        }
+        std::uint8_t low = static_cast<std::uint8_t>((1u << (8 - nlbits)) - 1);
+        return static_cast<std::uint8_t>(control | low);
+    }
+}
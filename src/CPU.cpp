@@ -7,6 +7,10 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "CPU.h"
 
+#include <cstring>
+
+#include "Memory.h"
+
 namespace riscv_tlm {
 
     SC_HAS_PROCESS(CPU);
@@ -24,6 +28,7 @@ namespace riscv_tlm {
         interrupt = false;
 
         irq_line_socket.register_b_transport(this, &CPU::call_interrupt);
+        ext_irq_socket.register_b_transport(this, &CPU::call_external_interrupt);
         
         // Register AT backward path - uses virtual dispatch so AT models can override
         instr_bus.register_nb_transport_bw(this, &CPU::nb_transport_bw);
@@ -45,6 +50,24 @@ namespace riscv_tlm {
         (void) start;
         (void) end;
         dmi_ptr_valid = false;
+        dmi_epoch++;
+    }
+
+    void CPU::call_external_interrupt(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+        std::uint32_t lines = 0;
+        std::memcpy(&lines, trans.get_data_ptr(), sizeof(lines));
+        ext_irq_lines = lines & (MIP_MEIP | MIP_SEIP);
+        delay = sc_core::SC_ZERO_TIME;
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+
+    bool CPU::fetchForPlugin(std::uint64_t addr, std::uint32_t &word) const {
+        /* Read-ahead for block translation: DMI only, no bus side effects */
+        if (!dmi_ptr_valid || dmi_ptr == nullptr || addr + 4 > Memory::SIZE) {
+            return false;
+        }
+        std::memcpy(&word, dmi_ptr + addr, 4);
+        return true;
     }
 
     tlm::tlm_sync_enum CPU::nb_transport_bw(tlm::tlm_generic_payload &trans,
@@ -65,18 +88,20 @@ namespace riscv_tlm {
             CPU_step();
 
             /* Process IRQ (if any) */
-            cpu_process_IRQ();
+            if (cpu_process_IRQ() && PluginManager::active()) {
+                PluginManager::getInstance()->onInterrupt(plugin_hart);
+            }
 
 #ifdef USE_QK
             // Model time used for additional processing
-            m_qk->inc(default_time);
+            m_qk->inc(corePeriod());
             if (m_qk->need_sync()) {
                 m_qk->sync();
             }
 #else
             // Only add base 1-cycle wait for pipelined cores; non-pipelined already wait internally
             if (isPipelined()) {
-                sc_core::wait(default_time);
+                sc_core::wait(corePeriod());
             }
 #endif
         } // while(1)
@@ -11,6 +11,7 @@
  * Branch taken causes 1-cycle flush penalty.
  */
 #include "CPU_P32_2.h"
+#include "SelfProfile.h"
 #include "spdlog/spdlog.h"
 
 namespace riscv_tlm {
@@ -19,7 +20,9 @@ CPURV32P2::CPURV32P2(sc_core::sc_module_name const& name, BaseType PC, bool debu
     : CPU(name, debug) {
 
     register_bank = new Registers<BaseType>();
+    registerPluginHart(register_bank);
     mem_intf = new MemoryInterface();
+    attachCustomInstructions(register_bank);
 
     register_bank->setPC(PC);
     register_bank->setValue(Registers<BaseType>::sp, (Memory::SIZE / 4) - 1);
@@ -31,6 +34,12 @@ CPURV32P2::CPURV32P2(sc_core::sc_module_name const& name, BaseType PC, bool debu
     c_inst    = new C_extension<BaseType>(0, register_bank, mem_intf);
     m_inst    = new M_extension<BaseType>(0, register_bank, mem_intf);
     a_inst    = new A_extension<BaseType>(0, register_bank, mem_intf);
+    v_inst    = new V_extension<BaseType>(0, register_bank, mem_intf);
+    f_inst    = new F_extension<BaseType>(0, register_bank, mem_intf);
+    b_inst    = new B_extension<BaseType>(0, register_bank, mem_intf);
+    k_inst    = new K_extension<BaseType>(0, register_bank, mem_intf);
+    isa       = {base_inst, c_inst, m_inst, a_inst, v_inst, f_inst, b_inst, k_inst};
+    register_bank->setExtensions(isa.misa());
 
     trans.set_data_ptr(reinterpret_cast<unsigned char*>(&if_ex_latch.instruction));
     trans.set_command(tlm::TLM_READ_COMMAND);
@@ -57,6 +66,10 @@ CPURV32P2::~CPURV32P2() {
     delete c_inst;
     delete m_inst;
     delete a_inst;
+    delete v_inst;
+    delete f_inst;
+    delete b_inst;
+    delete k_inst;
     delete m_qk;
 }
 
@@ -131,47 +144,19 @@ bool CPURV32P2::EX_stage() {
     bool is_branch = false;
 
     // Decode and execute using extension handlers
-    base_inst->setInstr(instr);
-    auto deco = base_inst->decode();
-
-    if (deco != OP_ERROR) {
-        // Check if branch instruction
-        std::uint32_t opcode = instr & 0x7F;
-        is_branch = (opcode == 0x63 || opcode == 0x6F || opcode == 0x67);
-
-        pc_changed = !base_inst->exec_instruction(inst, &breakpoint, deco);
-    } else {
-        // Try C extension
-        c_inst->setInstr(instr);
-        auto c_deco = c_inst->decode();
-
-        if (c_deco != OP_C_ERROR) {
-            is_branch = (c_deco == OP_C_J || c_deco == OP_C_JAL || 
-                        c_deco == OP_C_JR || c_deco == OP_C_JALR ||
-                        c_deco == OP_C_BEQZ || c_deco == OP_C_BNEZ);
-
-            pc_changed = !c_inst->exec_instruction(inst, &breakpoint, c_deco);
-        } else {
-            // Try M extension
-            m_inst->setInstr(instr);
-            auto m_deco = m_inst->decode();
-
-            if (m_deco != OP_M_ERROR) {
-                pc_changed = !m_inst->exec_instruction(inst, m_deco);
-            } else {
-                // Try A extension
-                a_inst->setInstr(instr);
-                auto a_deco = a_inst->decode();
-
-                if (a_deco != OP_A_ERROR) {
-                    pc_changed = !a_inst->exec_instruction(inst, a_deco);
-                } else {
-                    std::cout << "Extension not implemented yet" << std::endl;
-                    inst.dump();
-                    base_inst->NOP();
-                }
-            }
+    pluginInsnExec(if_ex_latch.pc, instr);
+    auto custom = execCustom(instr, if_ex_latch.pc, cycleNow());
+    if (custom != CustomInstructions::Result::NotCustom) {
+        if (custom == CustomInstructions::Result::Illegal) {
+            base_inst->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, instr);
         }
+        // A jump or trap redirected the PC: drop the fetched instruction
+        is_branch = pc_changed = (custom != CustomInstructions::Result::Sequential);
+    } else {
+        auto step = dispatchExtensions(isa, inst, instr, &breakpoint);
+        pc_changed = step.pc_changed;
+        is_branch = step.control_flow;
+        ex_cycles = step.cycles;
     }
 
     // If branch taken, flush the IF stage (next cycle will be bubble)
@@ -182,6 +167,7 @@ bool CPURV32P2::EX_stage() {
     }
 
     perf->instructionsInc();
+    runControlRetire(register_bank, if_ex_latch.pc, stats.cycles);
     return breakpoint;
 }
 
@@ -212,8 +198,15 @@ bool CPURV32P2::CPU_step() {
         stats.cycles++;  // Flush costs 1 extra cycle
     }
 
-    // LT timing: one clock cycle
-    sc_core::wait(sc_core::sc_time(10, sc_core::SC_NS));
+    // Multi-cycle custom or vector instruction holds EX
+    if (ex_cycles > 1) {
+        stats.cycles += ex_cycles - 1;
+        stats.stalls += ex_cycles - 1;
+    }
+
+    // LT timing: one clock cycle, plus any multi-cycle EX latency
+    sc_core::wait(corePeriod() * ex_cycles);
+    ex_cycles = 1;
 
     return breakpoint;
 }
@@ -225,10 +218,19 @@ bool CPURV32P2::cpu_process_IRQ() {
     BaseType csr_temp;
     bool ret_value = false;
 
+    if (takeCLICInterrupt(register_bank) || takeExternalInterrupt(register_bank)) {
+        // Flush pipeline on interrupt
+        pipeline_flush = true;
+        if_ex_latch.valid = false;
+        stats.flushes++;
+        stats.cycles += 2;  // IRQ latency
+        return true;
+    }
+
     if (interrupt) {
         csr_temp = register_bank->getCSR(CSR_MSTATUS);
         if ((csr_temp & MSTATUS_MIE) == 0) {
-            logger->debug("{} ns. PC: 0x{:x}. Interrupt delayed", 
+            logger->debug("{} ps. PC: 0x{:x}. Interrupt delayed", 
                          sc_core::sc_time_stamp().value(), register_bank->getPC());
             return ret_value;
         }
@@ -238,12 +240,13 @@ bool CPURV32P2::cpu_process_IRQ() {
             csr_temp |= MIP_MEIP;
             register_bank->setCSR(CSR_MIP, csr_temp);
 
-            logger->debug("{} ns. PC: 0x{:x}. Interrupt!", 
+            logger->debug("{} ps. PC: 0x{:x}. Interrupt!", 
                          sc_core::sc_time_stamp().value(), register_bank->getPC());
 
             BaseType old_pc = register_bank->getPC();
             register_bank->setCSR(CSR_MEPC, old_pc);
             register_bank->setCSR(CSR_MCAUSE, 0x80000000);
+            register_bank->enterTrap(Machine);
             BaseType new_pc = register_bank->getCSR(CSR_MTVEC);
             register_bank->setPC(new_pc);
 
@@ -13,6 +13,7 @@
  * - Memory latency is explicitly modeled
  */
 #include "CPU_P32_2_AT.h"
+#include "SelfProfile.h"
 #include "spdlog/spdlog.h"
 
 namespace riscv_tlm {
@@ -26,7 +27,9 @@ CPURV32P2_AT::CPURV32P2_AT(sc_core::sc_module_name const& name, BaseType PC, boo
       m_peq(this, &CPURV32P2_AT::peq_callback) {
 
     register_bank = new Registers<BaseType>();
+    registerPluginHart(register_bank);
     mem_intf = new MemoryInterface();
+    attachCustomInstructions(register_bank);
 
     register_bank->setPC(PC);
     register_bank->setValue(Registers<BaseType>::sp, (Memory::SIZE / 4) - 1);
@@ -40,6 +43,12 @@ CPURV32P2_AT::CPURV32P2_AT(sc_core::sc_module_name const& name, BaseType PC, boo
     c_inst    = new C_extension<BaseType>(0, register_bank, mem_intf);
     m_inst    = new M_extension<BaseType>(0, register_bank, mem_intf);
     a_inst    = new A_extension<BaseType>(0, register_bank, mem_intf);
+    v_inst    = new V_extension<BaseType>(0, register_bank, mem_intf);
+    f_inst    = new F_extension<BaseType>(0, register_bank, mem_intf);
+    b_inst    = new B_extension<BaseType>(0, register_bank, mem_intf);
+    k_inst    = new K_extension<BaseType>(0, register_bank, mem_intf);
+    isa       = {base_inst, c_inst, m_inst, a_inst, v_inst, f_inst, b_inst, k_inst};
+    register_bank->setExtensions(isa.misa());
 
     // Initialize pipeline latch (empty on startup - first cycle is IF only)
     if_ex_latch.instruction = 0;
@@ -69,14 +78,16 @@ CPURV32P2_AT::~CPURV32P2_AT() {
     delete c_inst;
     delete m_inst;
     delete a_inst;
+    delete v_inst;
+    delete f_inst;
+    delete b_inst;
+    delete k_inst;
     delete m_qk;
 }
 
-void CPURV32P2_AT::set_clock(sc_core::sc_clock* c) {
+void CPURV32P2_AT::set_clock(ClockDomain* c) {
+    CPU::set_clock(c);
     clk = c;
-    if (clk) {
-        clock_period = clk->period();
-    }
 }
 
 // =============================================================================
@@ -213,7 +224,7 @@ bool CPURV32P2_AT::initiate_fetch(std::uint32_t address) {
 std::uint32_t CPURV32P2_AT::wait_for_fetch() {
     if (if_stage_busy) {
         // Wait for fetch completion with timeout
-        sc_core::sc_time timeout = clock_period * 100; // Max 100 cycles
+        sc_core::sc_time timeout = corePeriod() * 100; // Max 100 cycles
         sc_core::sc_time start = sc_core::sc_time_stamp();
         
         while (if_stage_busy) {
@@ -239,7 +250,7 @@ void CPURV32P2_AT::pipeline_thread() {
     if (clk) {
         sc_core::wait(clk->posedge_event());
     } else {
-        sc_core::wait(clock_period);
+        sc_core::wait(corePeriod());
     }
     
     while (true) {
@@ -264,9 +275,19 @@ void CPURV32P2_AT::pipeline_thread() {
         
         // IF Stage: Fetch next instruction (non-blocking)
         IF_stage();
+
+        // Multi-cycle custom or vector instruction holds EX
+        if (ex_cycles > 1) {
+            stats.cycles += ex_cycles - 1;
+            stats.stalls += ex_cycles - 1;
+            sc_core::wait(corePeriod() * (ex_cycles - 1));
+            ex_cycles = 1;
+        }
         
         // Process IRQ between cycles
-        cpu_process_IRQ();
+        if (cpu_process_IRQ() && PluginManager::active()) {
+            PluginManager::getInstance()->onInterrupt(plugin_hart);
+        }
         
         // Handle breakpoint
         if (breakpoint) {
@@ -278,7 +299,7 @@ void CPURV32P2_AT::pipeline_thread() {
         if (clk) {
             sc_core::wait(clk->posedge_event());
         } else {
-            sc_core::wait(clock_period);
+            sc_core::wait(corePeriod());
         }
     }
 }
@@ -357,47 +378,19 @@ bool CPURV32P2_AT::EX_stage() {
     bool is_branch = false;
 
     // Decode and execute using extension handlers
-    base_inst->setInstr(instr);
-    auto deco = base_inst->decode();
-
-    if (deco != OP_ERROR) {
-        // Check if branch instruction
-        std::uint32_t opcode = instr & 0x7F;
-        is_branch = (opcode == 0x63 || opcode == 0x6F || opcode == 0x67);
-
-        pc_changed = !base_inst->exec_instruction(inst, &breakpoint, deco);
-    } else {
-        // Try C extension
-        c_inst->setInstr(instr);
-        auto c_deco = c_inst->decode();
-
-        if (c_deco != OP_C_ERROR) {
-            is_branch = (c_deco == OP_C_J || c_deco == OP_C_JAL || 
-                        c_deco == OP_C_JR || c_deco == OP_C_JALR ||
-                        c_deco == OP_C_BEQZ || c_deco == OP_C_BNEZ);
-
-            pc_changed = !c_inst->exec_instruction(inst, &breakpoint, c_deco);
-        } else {
-            // Try M extension
-            m_inst->setInstr(instr);
-            auto m_deco = m_inst->decode();
-
-            if (m_deco != OP_M_ERROR) {
-                pc_changed = !m_inst->exec_instruction(inst, m_deco);
-            } else {
-                // Try A extension
-                a_inst->setInstr(instr);
-                auto a_deco = a_inst->decode();
-
-                if (a_deco != OP_A_ERROR) {
-                    pc_changed = !a_inst->exec_instruction(inst, a_deco);
-                } else {
-                    std::cout << "Extension not implemented yet" << std::endl;
-                    inst.dump();
-                    base_inst->NOP();
-                }
-            }
+    pluginInsnExec(if_ex_latch.pc, instr);
+    auto custom = execCustom(instr, if_ex_latch.pc, cycleNow());
+    if (custom != CustomInstructions::Result::NotCustom) {
+        if (custom == CustomInstructions::Result::Illegal) {
+            base_inst->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, instr);
         }
+        // A jump or trap redirected the PC: drop the fetched instruction
+        is_branch = pc_changed = (custom != CustomInstructions::Result::Sequential);
+    } else {
+        auto step = dispatchExtensions(isa, inst, instr, &breakpoint);
+        pc_changed = step.pc_changed;
+        is_branch = step.control_flow;
+        ex_cycles = step.cycles;
     }
 
     // If branch taken, flush the IF stage (next cycle will be bubble)
@@ -407,6 +400,7 @@ bool CPURV32P2_AT::EX_stage() {
     }
 
     perf->instructionsInc();
+    runControlRetire(register_bank, if_ex_latch.pc, stats.cycles);
     return breakpoint;
 }
 
@@ -431,11 +425,19 @@ bool CPURV32P2_AT::CPU_step() {
     // IF Stage: Fetch next instruction
     IF_stage();
 
+    // Multi-cycle custom or vector instruction holds EX
+    if (ex_cycles > 1) {
+        stats.cycles += ex_cycles - 1;
+        stats.stalls += ex_cycles - 1;
+        sc_core::wait(corePeriod() * (ex_cycles - 1));
+        ex_cycles = 1;
+    }
+
     // Wait one clock cycle
     if (clk) {
         sc_core::wait(clk->posedge_event());
     } else {
-        sc_core::wait(clock_period);
+        sc_core::wait(corePeriod());
     }
 
     return breakpoint;
@@ -449,10 +451,20 @@ bool CPURV32P2_AT::cpu_process_IRQ() {
     BaseType csr_temp;
     bool ret_value = false;
 
+    if (takeCLICInterrupt(register_bank) || takeExternalInterrupt(register_bank)) {
+        // Flush pipeline on interrupt
+        pipeline_flush = true;
+        if_ex_latch.valid = false;
+        if_ex_latch_next.valid = false;
+        stats.flushes++;
+        stats.cycles += 2;  // IRQ latency
+        return true;
+    }
+
     if (interrupt) {
         csr_temp = register_bank->getCSR(CSR_MSTATUS);
         if ((csr_temp & MSTATUS_MIE) == 0) {
-            logger->debug("{} ns. PC: 0x{:x}. Interrupt delayed", 
+            logger->debug("{} ps. PC: 0x{:x}. Interrupt delayed", 
                          sc_core::sc_time_stamp().value(), register_bank->getPC());
             return ret_value;
         }
@@ -462,12 +474,13 @@ bool CPURV32P2_AT::cpu_process_IRQ() {
             csr_temp |= MIP_MEIP;
             register_bank->setCSR(CSR_MIP, csr_temp);
 
-            logger->debug("{} ns. PC: 0x{:x}. Interrupt!", 
+            logger->debug("{} ps. PC: 0x{:x}. Interrupt!", 
                          sc_core::sc_time_stamp().value(), register_bank->getPC());
 
             BaseType old_pc = register_bank->getPC();
             register_bank->setCSR(CSR_MEPC, old_pc);
             register_bank->setCSR(CSR_MCAUSE, 0x80000000);
+            register_bank->enterTrap(Machine);
             BaseType new_pc = register_bank->getCSR(CSR_MTVEC);
             register_bank->setPC(new_pc);
 
@@ -9,6 +9,8 @@
  * - Precise stall and hazard modeling
  */
 #include "CPU_P32_2_Cycle.h"
+#include "SelfProfile.h"
+#include "FaultCampaign.h"
 #include "spdlog/spdlog.h"
 #include <iostream>
 #include <iomanip>
@@ -23,7 +25,9 @@ CPURV32P2_Cycle::CPURV32P2_Cycle(sc_core::sc_module_name const& name, BaseType P
     : CPU(name, debug) {
 
     register_bank = new Registers<BaseType>();
+    registerPluginHart(register_bank);
     mem_intf = new MemoryInterface();
+    attachCustomInstructions(register_bank);
 
     register_bank->setPC(PC);
     register_bank->setValue(Registers<BaseType>::sp, (Memory::SIZE / 4) - 1);
@@ -35,6 +39,12 @@ CPURV32P2_Cycle::CPURV32P2_Cycle(sc_core::sc_module_name const& name, BaseType P
     c_inst    = new C_extension<BaseType>(0, register_bank, mem_intf);
     m_inst    = new M_extension<BaseType>(0, register_bank, mem_intf);
     a_inst    = new A_extension<BaseType>(0, register_bank, mem_intf);
+    v_inst    = new V_extension<BaseType>(0, register_bank, mem_intf);
+    f_inst    = new F_extension<BaseType>(0, register_bank, mem_intf);
+    b_inst    = new B_extension<BaseType>(0, register_bank, mem_intf);
+    k_inst    = new K_extension<BaseType>(0, register_bank, mem_intf);
+    isa       = {base_inst, c_inst, m_inst, a_inst, v_inst, f_inst, b_inst, k_inst};
+    register_bank->setExtensions(isa.misa());
 
     // Initialize pipeline latches
     if_ex_latch.instruction = 0;
@@ -66,14 +76,16 @@ CPURV32P2_Cycle::~CPURV32P2_Cycle() {
     delete c_inst;
     delete m_inst;
     delete a_inst;
+    delete v_inst;
+    delete f_inst;
+    delete b_inst;
+    delete k_inst;
     delete m_qk;
 }
 
-void CPURV32P2_Cycle::set_clock(sc_core::sc_clock* c) {
+void CPURV32P2_Cycle::set_clock(ClockDomain* c) {
+    CPU::set_clock(c);
     clk = c;
-    if (clk) {
-        clock_period = clk->period();
-    }
 }
 
 // =============================================================================
@@ -93,6 +105,8 @@ void CPURV32P2_Cycle::printStats() const {
     std::cout << "Fetch Cycles:          " << stats.fetch_cycles << std::endl;
     std::cout << "Memory Cycles:         " << stats.memory_cycles << std::endl;
     std::cout << "Branch Penalty Cycles: " << stats.branch_penalty << std::endl;
+    std::cout << "Interrupts Taken:      " << stats.irq_entries << std::endl;
+    std::cout << "IRQ Entry Cycles:      " << stats.irq_entry_cycles << std::endl;
     std::cout << "===================================================" << std::endl;
 }
 
@@ -105,7 +119,7 @@ void CPURV32P2_Cycle::cycle_thread() {
     if (clk) {
         sc_core::wait(clk->posedge_event());
     } else {
-        sc_core::wait(clock_period);
+        sc_core::wait(corePeriod());
     }
     
     while (true) {
@@ -115,7 +129,7 @@ void CPURV32P2_Cycle::cycle_thread() {
         on_posedge();
         
         // Wait half clock period
-        sc_core::wait(clock_period / 2);
+        sc_core::wait(corePeriod() / 2);
         
         // =====================================================================
         // FALLING EDGE: IF stage (fetch)
@@ -126,7 +140,7 @@ void CPURV32P2_Cycle::cycle_thread() {
         if (clk) {
             sc_core::wait(clk->posedge_event());
         } else {
-            sc_core::wait(clock_period / 2);
+            sc_core::wait(corePeriod() / 2);
         }
     }
 }
@@ -139,7 +153,9 @@ void CPURV32P2_Cycle::on_posedge() {
     stats.total_cycles++;
     
     // Process IRQ at cycle boundary
-    cpu_process_IRQ();
+    if (cpu_process_IRQ() && PluginManager::active()) {
+        PluginManager::getInstance()->onInterrupt(plugin_hart);
+    }
     
     // Handle pipeline flush
     if (pipeline_flush) {
@@ -301,6 +317,16 @@ uint32_t CPURV32P2_Cycle::get_instruction_latency(std::uint32_t instruction) {
         }
     }
     
+    // Zbc carry-less multiply
+    if (opcode == 0x33 && funct7 == 0x05 && funct3 >= 1 && funct3 <= 3) {
+        return latency.clmul_latency;
+    }
+
+    // Zbb clz/ctz/cpop (and the W forms on RV64)
+    if ((opcode == 0x13 || opcode == 0x1B) && funct3 == 1 && (instruction >> 22) == 0x180) {
+        return latency.bitcount_latency;
+    }
+
     // Load instructions
     if (opcode == 0x03) {
         return latency.load_latency;
@@ -344,43 +370,35 @@ bool CPURV32P2_Cycle::EX_stage() {
     bool is_branch = false;
 
     // Decode and execute
-    base_inst->setInstr(instr);
-    auto deco = base_inst->decode();
-
-    if (deco != OP_ERROR) {
-        std::uint32_t opcode = instr & 0x7F;
-        is_branch = (opcode == 0x63 || opcode == 0x6F || opcode == 0x67);
-        pc_changed = !base_inst->exec_instruction(inst, &breakpoint, deco);
+    pluginInsnExec(if_ex_latch.pc, instr);
+    auto custom = execCustom(instr, if_ex_latch.pc, stats.total_cycles);
+    if (custom != CustomInstructions::Result::NotCustom) {
+        if (custom == CustomInstructions::Result::Illegal) {
+            base_inst->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, instr);
+        }
+        // A jump or trap redirected the PC: drop the fetched instruction
+        is_branch = pc_changed = (custom != CustomInstructions::Result::Sequential);
     } else {
-        c_inst->setInstr(instr);
-        auto c_deco = c_inst->decode();
-
-        if (c_deco != OP_C_ERROR) {
-            is_branch = (c_deco == OP_C_J || c_deco == OP_C_JAL || 
-                        c_deco == OP_C_JR || c_deco == OP_C_JALR ||
-                        c_deco == OP_C_BEQZ || c_deco == OP_C_BNEZ);
-            pc_changed = !c_inst->exec_instruction(inst, &breakpoint, c_deco);
-        } else {
-            m_inst->setInstr(instr);
-            auto m_deco = m_inst->decode();
-
-            if (m_deco != OP_M_ERROR) {
-                pc_changed = !m_inst->exec_instruction(inst, m_deco);
-            } else {
-                a_inst->setInstr(instr);
-                auto a_deco = a_inst->decode();
-
-                if (a_deco != OP_A_ERROR) {
-                    pc_changed = !a_inst->exec_instruction(inst, a_deco);
-                } else {
-                    std::cout << "Extension not implemented" << std::endl;
-                    inst.dump();
-                    base_inst->NOP();
-                }
+        auto step = dispatchExtensions(isa, inst, instr, &breakpoint);
+        pc_changed = step.pc_changed;
+        is_branch = step.control_flow;
+        ex_cycles = step.cycles;
+        // Zcmp/Zcmt sequence one memory micro-op per register or table entry
+        if (step.unit == ExtensionUnit::C) {
+            const auto &uops = c_inst->lastMicroOps();
+            if (uops.loads + uops.stores > 0) {
+                ex_cycles = uops.loads * latency.load_latency + uops.stores * latency.store_latency + uops.alu;
             }
         }
     }
 
+    // Multi-cycle custom or vector instruction holds EX
+    if (ex_cycles > 1) {
+        stats.instruction_cycles += ex_cycles - 1;
+        stats.stall_cycles += ex_cycles - 1;
+        stats.total_cycles += ex_cycles - 1;
+    }
+
     // Branch taken - flush pipeline
     if (is_branch && pc_changed) {
         pipeline_flush = true;
@@ -390,6 +408,7 @@ bool CPURV32P2_Cycle::EX_stage() {
 
     stats.instructions_retired++;
     perf->instructionsInc();
+    runControlRetire(register_bank, if_ex_latch.pc, stats.total_cycles);
     return breakpoint;
 }
 
@@ -399,9 +418,9 @@ bool CPURV32P2_Cycle::EX_stage() {
 
 bool CPURV32P2_Cycle::CPU_step() {
     on_posedge();
-    sc_core::wait(clock_period / 2);
+    sc_core::wait(corePeriod() / 2);
     on_negedge();
-    sc_core::wait(clock_period / 2);
+    sc_core::wait(corePeriod() / 2);
     return false;
 }
 
@@ -413,6 +432,19 @@ bool CPURV32P2_Cycle::cpu_process_IRQ() {
     BaseType csr_temp;
     bool ret_value = false;
 
+    if (takeCLICInterrupt(register_bank) || takeExternalInterrupt(register_bank)) {
+        pipeline_flush = true;
+        if_ex_latch.valid = false;
+        if_ex_latch_next.valid = false;
+        // IRQ latency, plus the mtvt read of a vectored CLIC interrupt
+        std::uint64_t entry = 2 + (irq_vectored ? latency.load_latency : 0);
+        stats.stall_cycles += entry;
+        stats.total_cycles += entry;
+        stats.irq_entries++;
+        stats.irq_entry_cycles += entry;
+        return true;
+    }
+
     if (interrupt) {
         csr_temp = register_bank->getCSR(CSR_MSTATUS);
         if ((csr_temp & MSTATUS_MIE) == 0) {
@@ -427,6 +459,7 @@ bool CPURV32P2_Cycle::cpu_process_IRQ() {
             BaseType old_pc = register_bank->getPC();
             register_bank->setCSR(CSR_MEPC, old_pc);
             register_bank->setCSR(CSR_MCAUSE, 0x80000000);
+            register_bank->enterTrap(Machine);
             BaseType new_pc = register_bank->getCSR(CSR_MTVEC);
             register_bank->setPC(new_pc);
 
@@ -465,4 +498,10 @@ std::uint64_t CPURV32P2_Cycle::getEndDumpAddress() {
     return register_bank->getValue(Registers<std::uint32_t>::t1);
 }
 
+void CPURV32P2_Cycle::visitLatches(LatchMap &map) {
+    map.add("if_ex.instruction", if_ex_latch.instruction);
+    map.add("if_ex.pc", if_ex_latch.pc);
+    map.add("if_ex.valid", if_ex_latch.valid);
+}
+
 } // namespace riscv_tlm
@@ -1,7 +1,10 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "CPU_P32_6_Cycle.h"
+#include "SelfProfile.h"
 #include "DMA.h"
+#include "FaultCampaign.h"
 #include "spdlog/spdlog.h"
+#include <algorithm>
 #include <iostream>
 
 namespace riscv_tlm {
@@ -9,11 +12,16 @@ namespace riscv_tlm {
 CPURV32P6_Cycle::CPURV32P6_Cycle(sc_core::sc_module_name const& name,
                                  BaseType PC,
                                  bool debug)
-    : CPU(name, debug) {
+    : CPU(name, debug),
+      fetch_unit([this](uint64_t addr, uint8_t* data, unsigned int len) { return fetch_block(addr, data, len); },
+                 false, PC) {
 
     // Initialize the register bank and memory interface
     register_bank = new Registers<BaseType>();
     mem_intf = new MemoryInterface();
+    attachCustomInstructions(register_bank);
+    registerPluginHart(register_bank);
+    mem_intf->setPluginReports(false);  // reported at retirement, see reportPluginAccesses()
 
     // Set the initial Program Counter (PC) and Stack Pointer (SP)
     register_bank->setPC(PC);
@@ -27,8 +35,10 @@ CPURV32P6_Cycle::CPURV32P6_Cycle(sc_core::sc_module_name const& name,
     base_inst = new BASE_ISA<BaseType>(0, register_bank, mem_intf);
     c_inst    = new C_extension<BaseType>(0, register_bank, mem_intf);
     m_inst    = new M_extension<BaseType>(0, register_bank, mem_intf);
-
-    pc_register = PC;
+    b_inst    = new B_extension<BaseType>(0, register_bank, mem_intf);
+    k_inst    = new K_extension<BaseType>(0, register_bank, mem_intf);
+    // What execute() implements: RV32IMC (RVC is expanded in fetch) and Zb*/Zk*; no A, F/D or V
+    register_bank->setExtensions(MISA_I_BASE | MISA_M_EXTENSION | MISA_C_EXTENSION | MISA_B_EXTENSION);
 
     // Start the main simulation thread
     SC_THREAD(cycle_thread);
@@ -42,13 +52,15 @@ CPURV32P6_Cycle::~CPURV32P6_Cycle() {
     delete base_inst;
     delete c_inst;
     delete m_inst;
+    delete b_inst;
+    delete k_inst;
     // Note: m_qk is allocated by base CPU class but not used by cycle-accurate model
     // Base class destructor should handle cleanup if needed
 }
 
-void CPURV32P6_Cycle::set_clock(sc_core::sc_clock* c) {
+void CPURV32P6_Cycle::set_clock(ClockDomain* c) {
+    CPU::set_clock(c);
     clk = c;
-    if (clk) clock_period = clk->period();
 }
 
 void CPURV32P6_Cycle::cycle_thread() {
@@ -76,7 +88,7 @@ void CPURV32P6_Cycle::cycle_thread() {
              sc_core::wait(clk->posedge_event());
         }
         else {
-             sc_core::wait(clock_period);
+             sc_core::wait(corePeriod());
              std::cout << "[DEBUG] Wait period" << std::endl;
         }
 
@@ -118,24 +130,19 @@ void CPURV32P6_Cycle::cycle_thread() {
     }
 }
 
-// Logic to select the next Program Counter (PC)
+// Logic to select the next fetch address
 void CPURV32P6_Cycle::pc_select() {
-    // Priority 1: Handle Branch/Jump Redirection
-    // If a branch was taken or a jump occurred in the EX stage, update the PC to the target address.
+    // Branch/Jump Redirection
+    // If a branch was taken or a jump occurred in the EX stage, the fetch unit drops its
+    // queued bytes and restarts at the target address.
     if (pc_redirect_valid) {
-        pc_register = pc_redirect_target;
+        fetch_unit.redirect(pc_redirect_target);
         pc_redirect_valid = false;
         flush_pipeline = false; // We have handled the redirect, so we can stop flushing.
-        return;
     }
-    
-    // Priority 2: Valid Stall
-    // If the pipeline is stalled (e.g., due to a data hazard), do not change the PC.
-    if (stall_fetch) return;
-    
-    // Default: Sequential Execution
-    // Move to the next instruction address (4 bytes ahead).
-    pc_register += 4;
+
+    // Otherwise the fetch unit continues with the next sequential fetch block,
+    // whatever the length of the instructions it delivers.
 }
 
 void CPURV32P6_Cycle::IF_stage() {
@@ -144,40 +151,47 @@ void CPURV32P6_Cycle::IF_stage() {
     // until it releases the bus to avoid bus contention.
     while (riscv_tlm::peripherals::DMA::is_in_flight()) {
         if (clk) wait(clk->posedge_event());
-        else wait(clock_period);
+        else wait(corePeriod());
     }
 
-    // 2. Capture the current PC to fetch
-    uint32_t current_pc = pc_register;
-
-    // 3. Compute the next PC for the *following* cycle
-    pc_select();
-
-    // 4. Handle Pipeline Flush
-    // If a flush signal is active (e.g., from a mispredicted branch), invalidate the fetched instruction.
+    // 2. Handle Pipeline Flush
+    // If a flush signal is active (e.g., from a mispredicted branch), redirect the fetch unit.
+    // The queue is empty afterwards, so nothing is delivered this cycle.
     if (flush_pipeline) {
-        if_id_next.valid = false;
-        return;
+        for (auto& lane : if_id_next) lane.valid = false;
+        pc_select();
+    } else if (!stall_fetch) {
+        // 3. Deliver the oldest complete instructions of the queue to the ID stage, one per
+        // issue lane (ID holds its instructions while stalled, so nothing is taken then).
+        for (auto& lane : if_id_next) lane.valid = false;
+        FetchUnit::Slot slot;
+        for (unsigned int lane = 0; lane < rules.width; lane++) {
+            // Only a missing first instruction counts as a fetch bubble.
+            if (lane == 0 ? !fetch_unit.take(slot) : !fetch_unit.peek(slot)) {
+                if (lane == 0 && fetch_unit.faulted()) {
+                    // Fetch Error: Typically means accessing invalid memory (Segfault). Stop simulation.
+                    std::cout << "[Sim] Error: Fetch failed at PC=" << std::hex << fetch_unit.faultAddress() << std::dec << " (Out of bounds). Stopping." << std::endl;
+                    sc_core::sc_stop();
+                }
+                // Fetch bubble: the queue is empty or holds only half of a 32-bit instruction.
+                break;
+            }
+            if (lane != 0) fetch_unit.pop();
+            if_id_next[lane].pc = static_cast<uint32_t>(slot.pc);
+            if_id_next[lane].instr = slot.instr;
+            if_id_next[lane].length = slot.length;
+            if_id_next[lane].encoding = slot.encoding;
+            if_id_next[lane].valid = true;
+        }
     }
 
-    // 5. Fetch Instruction
-    uint32_t instr = 0;
-    if (fetch_instruction(current_pc, instr)) {
-        // Successful fetch: Pass the instruction and PC to the ID stage.
-        if_id_next.pc = current_pc;
-        if_id_next.instr = instr;
-        if_id_next.valid = true;
-    } else {
-        // Fetch Error: Typically means accessing invalid memory (Segfault). Stop simulation.
-        std::cout << "[Sim] Error: Fetch failed at PC=" << std::hex << current_pc << std::dec << " (Out of bounds). Stopping." << std::endl;
-        sc_core::sc_stop();
-        if_id_next.valid = false;
-    }
+    // 4. Read the next fetch block into the queue; it reaches decode next cycle.
+    fetch_unit.cycle();
 }
 
-bool CPURV32P6_Cycle::fetch_instruction(uint32_t addr, uint32_t& data) {
-    if (dmi_ptr_valid && addr >= dmi_start_addr && (addr + 4) <= dmi_end_addr) {
-        std::memcpy(&data, dmi_ptr + (addr - dmi_start_addr), 4);
+bool CPURV32P6_Cycle::fetch_block(uint64_t addr, uint8_t* data, unsigned int len) {
+    if (dmi_ptr_valid && addr >= dmi_start_addr && (addr + len) <= dmi_end_addr) {
+        std::memcpy(data, dmi_ptr + (addr - dmi_start_addr), len);
         return true;
     }
 
@@ -186,9 +200,9 @@ bool CPURV32P6_Cycle::fetch_instruction(uint32_t addr, uint32_t& data) {
 
     trans.set_command(tlm::TLM_READ_COMMAND);
     trans.set_address(addr);
-    trans.set_data_ptr(reinterpret_cast<unsigned char*>(&data));
-    trans.set_data_length(4);
-    trans.set_streaming_width(4);
+    trans.set_data_ptr(data);
+    trans.set_data_length(len);
+    trans.set_streaming_width(len);
     trans.set_byte_enable_ptr(nullptr);
     trans.set_dmi_allowed(false);
     trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
@@ -210,118 +224,349 @@ bool CPURV32P6_Cycle::fetch_instruction(uint32_t addr, uint32_t& data) {
 }
 
 void CPURV32P6_Cycle::ID_stage() {
+    RVVP_PROFILE_SCOPE(Decode);
     // Handle flushes and stalls
-    if (flush_pipeline) { id_is_next.valid = false; return; }
+    if (flush_pipeline) {
+        for (auto& lane : id_is_next) lane.valid = false;
+        return;
+    }
     if (stall_fetch) return;
-    
+
+    for (unsigned int lane = 0; lane < LANES; lane++) {
+        decode(if_id_reg[lane], id_is_next[lane]);
+    }
+}
+
+void CPURV32P6_Cycle::decode(const IF_ID_Latch& in, ID_IS_Latch& out) {
     // If the incoming instruction is not valid, propagate the invalid state.
-    if (!if_id_reg.valid) {
-        id_is_next.valid = false;
+    if (!in.valid) {
+        out.valid = false;
         return;
     }
 
-    uint32_t instr = if_id_reg.instr;
+    uint32_t instr = in.instr;
     
     // Pass PC and Instruction to proper fields
-    id_is_next.pc = if_id_reg.pc;
-    id_is_next.instr = instr;
+    out.pc = in.pc;
+    out.instr = instr;
+    out.length = in.length;
+    out.encoding = in.encoding;
+    out.retire = true;
+
+    // A Zcmp/Zcmt instruction stays a 16-bit parcel; IS cracks it into micro-ops.
+    if (in.length == 2 && FetchUnit::isSequence(static_cast<uint16_t>(instr))) {
+        out.opcode = out.funct3 = out.funct7 = 0;
+        out.rd = out.rs1 = out.rs2 = 0;
+        out.imm = 0;
+        out.unit = UNIT_SEQUENCE;
+        out.valid = true;
+        return;
+    }
     
     // --- Decode Fields ---
-    id_is_next.opcode = instr & 0x7F;
+    out.opcode = instr & 0x7F;
     
     // Destination Register (rd)
     // Note: S-Type (Store) and B-Type (Branch) instructions do NOT write to a register, so rd is 0.
-    if (id_is_next.opcode == 0x23 || id_is_next.opcode == 0x63) {
-        id_is_next.rd = 0;
+    if (out.opcode == 0x23 || out.opcode == 0x63) {
+        out.rd = 0;
     } else {
-        id_is_next.rd = (instr >> 7) & 0x1F;
+        out.rd = (instr >> 7) & 0x1F;
     }
     
     // Source Registers (rs1, rs2) and Function Codes (funct3, funct7)
-    id_is_next.funct3 = (instr >> 12) & 0x7;
-    id_is_next.rs1 = (instr >> 15) & 0x1F;
-    id_is_next.rs2 = (instr >> 20) & 0x1F;
-    id_is_next.funct7 = (instr >> 25) & 0x7F;
+    out.funct3 = (instr >> 12) & 0x7;
+    out.rs1 = (instr >> 15) & 0x1F;
+    out.rs2 = (instr >> 20) & 0x1F;
+    out.funct7 = (instr >> 25) & 0x7F;
+    out.unit = classify(instr, out.ext_op);
+    if (out.unit == UNIT_CUSTOM) {
+        // The semantic writes its results itself; nothing goes through WB.
+        out.rd = 0;
+    }
 
     // --- Immediate Generation ---
     // Extract and sign-extend the immediate value based on the instruction type.
-    switch (id_is_next.opcode) {
+    switch (out.opcode) {
         case 0x13: case 0x03: case 0x67: // I-Type
-            id_is_next.imm = static_cast<int32_t>(instr) >> 20;
+            out.imm = static_cast<int32_t>(instr) >> 20;
             break;
         case 0x23: // S-Type
-            id_is_next.imm = static_cast<int32_t>(((instr >> 25) << 5) | ((instr >> 7) & 0x1F)) << 20 >> 20;
+            out.imm = static_cast<int32_t>(((instr >> 25) << 5) | ((instr >> 7) & 0x1F)) << 20 >> 20;
             break;
         case 0x63: // B-Type
-            id_is_next.imm = static_cast<int32_t>(
+            out.imm = static_cast<int32_t>(
                 ((instr >> 31) << 12) | (((instr >> 7) & 1) << 11) |
                 (((instr >> 25) & 0x3F) << 5) | (((instr >> 8) & 0xF) << 1)) << 19 >> 19;
             break;
         case 0x37: case 0x17: // U-Type
-            id_is_next.imm = static_cast<int32_t>(instr & 0xFFFFF000);
+            out.imm = static_cast<int32_t>(instr & 0xFFFFF000);
             break;
         case 0x6F: // J-Type
-            id_is_next.imm = static_cast<int32_t>(
+            out.imm = static_cast<int32_t>(
                 ((instr >> 31) << 20) | (((instr >> 12) & 0xFF) << 12) |
                 (((instr >> 20) & 1) << 11) | (((instr >> 21) & 0x3FF) << 1)) << 11 >> 11;
             break;
         default:
-            id_is_next.imm = 0;
+            out.imm = 0;
     }
     
+    // Only the sources the instruction actually reads take part in hazard detection and pairing.
+    IssueOp op = IssueOp::fromDecode(out.opcode, out.funct3, out.funct7, out.rd, out.rs1, out.rs2);
+    out.rs1 = op.rs1;
+    out.rs2 = op.rs2;
+
     // Mark the decoded instruction as valid for the next stage.
-    id_is_next.valid = true;
+    out.valid = true;
+}
+
+// Execution unit of an instruction: the RV32IM encodings execute() implements, then Zb* and Zk*.
+uint8_t CPURV32P6_Cycle::classify(uint32_t instr, uint8_t& ext_op) {
+    const uint32_t funct3 = (instr >> 12) & 0x7;
+    const uint32_t funct7 = (instr >> 25) & 0x7F;
+    switch (instr & 0x7F) {
+        case 0x33: // ADD..AND, SUB / SRA and M
+            if (funct7 == 0x00 || funct7 == 0x01 || (funct7 == 0x20 && (funct3 == 0x0 || funct3 == 0x5))) {
+                return UNIT_BASE;
+            }
+            break;
+        case 0x13: // Only the shifts encode a funct7
+            if ((funct3 != 0x1 && funct3 != 0x5) || funct7 == 0x00 || (funct3 == 0x5 && funct7 == 0x20)) {
+                return UNIT_BASE;
+            }
+            break;
+        case 0x03:
+            return (funct3 != 0x3 && funct3 < 0x6) ? UNIT_BASE : UNIT_ILLEGAL;
+        case 0x23:
+            return funct3 <= 0x2 ? UNIT_BASE : UNIT_ILLEGAL;
+        case 0x63:
+            return (funct3 != 0x2 && funct3 != 0x3) ? UNIT_BASE : UNIT_ILLEGAL;
+        case 0x67: case 0x6F: case 0x37: case 0x17: case 0x0F: case 0x73:
+            return UNIT_BASE;
+        case 0x0B: case 0x2B: case 0x5B: case 0x7B: // custom-0..3
+            return CustomInstructions::active() && CustomInstructions::getInstance()->lookup(instr) != nullptr
+                   ? UNIT_CUSTOM : UNIT_ILLEGAL;
+        default:
+            return UNIT_ILLEGAL;
+    }
+
+    b_inst->setInstr(instr);
+    const op_B_Codes b_op = b_inst->decode();
+    if (b_op != OP_B_ERROR) {
+        ext_op = static_cast<uint8_t>(b_op);
+        return UNIT_BITMANIP;
+    }
+    k_inst->setInstr(instr);
+    const op_K_Codes k_op = k_inst->decode();
+    if (k_op != OP_K_ERROR) {
+        ext_op = static_cast<uint8_t>(k_op);
+        return UNIT_CRYPTO;
+    }
+    return UNIT_ILLEGAL;
 }
 
 void CPURV32P6_Cycle::IS_stage() {
-    if (flush_pipeline) { is_ex_next.valid = false; return; }
+    for (auto& lane : is_ex_next) lane.valid = false;
+    if (flush_pipeline) {
+        // Whatever waited in IS is younger than the redirect and is dropped.
+        stall_fetch = false;
+        uops.clear();
+        uop_next = 0;
+        return;
+    }
     
     // Check if we have a valid instruction from the decode stage.
-    if (!id_is_reg.valid) {
-        is_ex_next.valid = false;
+    const ID_IS_Latch& older = id_is_reg[0];
+    const ID_IS_Latch& younger = id_is_reg[1];
+    if (!older.valid) {
+        return;
+    }
+
+    // A custom or multi-cycle instruction holds EX for its latency; nothing issues behind it until then.
+    if (ex_hold > 0) {
+        id_is_next = id_is_reg;
+        stall_fetch = true;
+        return;
+    }
+
+    // A Zcmp/Zcmt instruction issues alone, one micro-op per cycle.
+    if (older.unit == UNIT_SEQUENCE) {
+        issue_sequence(older, younger);
+        return;
+    }
+
+    // A custom instruction reads and writes the register file from EX, so it waits until
+    // every older result is written. Its unit is a structural hazard: it issues no earlier
+    // than the occupancy of the previous instruction of the same registration allows.
+    if (older.unit == UNIT_CUSTOM
+        && (std::find(std::begin(scoreboard), std::end(scoreboard), true) != std::end(scoreboard)
+            || CustomInstructions::getInstance()->readyAt(*custom_ctx, older.instr) > stats.cycles + 1)) {
+        id_is_next = id_is_reg;
+        stall_fetch = true;
         return;
     }
 
     // --- Hazard Detection (Scoreboarding) ---
     // Check if any of the source registers (rs1, rs2) are currently pending a write from a later stage.
     // If so, we have a data hazard.
-    if (scoreboard[id_is_reg.rs1] || scoreboard[id_is_reg.rs2]) {
+    if (scoreboard[older.rs1] || scoreboard[older.rs2]) {
         // Stall Logic:
-        // 1. Send a "bubble" (nop/invalid) to the Execute stage.
-        is_ex_next.valid = false; 
-        
-        // 2. Keep the current instruction in the Issue stage (hold the latch).
+        // 1. Send a "bubble" (nop/invalid) to the Execute stage (done above).
+        // 2. Keep the current instructions in the Issue stage (hold the latch).
         id_is_next = id_is_reg;
         
         // 3. Signal the fetch stage to stop fetching new instructions.
         stall_fetch = true; 
         return;
     }
-    
-    // No stall required: Clear the stall signal (unless forced by another mechanism).
-    stall_fetch = false; 
 
+    // --- Pairing ---
+    // The younger instruction issues in the same cycle if the pairing rules allow it and none
+    // of its sources is pending. This is checked before the older one marks its destination.
+    IssueOp older_op = IssueOp::fromDecode(older.opcode, older.funct3, older.funct7, older.rd, older.rs1, older.rs2);
+    IssueOp younger_op;
+    PairBlock pairing = PAIR_NO_SECOND;
+    if (younger.valid) {
+        younger_op = IssueOp::fromDecode(younger.opcode, younger.funct3, younger.funct7, younger.rd, younger.rs1, younger.rs2);
+        const bool alone = older.unit == UNIT_CUSTOM || younger.unit == UNIT_CUSTOM
+                           || younger.unit == UNIT_SEQUENCE;
+        pairing = alone ? PAIR_SYSTEM : rules.check(older_op, younger_op);
+        if (pairing == PAIR_OK && (scoreboard[younger.rs1] || scoreboard[younger.rs2])) {
+            pairing = PAIR_HAZARD;
+        }
+    }
+    if (rules.width > 1) {
+        pair_stats.record(older_op.cls, younger_op.cls, pairing);
+    }
+
+    issue(older, is_ex_next[0]);
+
+    if (pairing == PAIR_OK) {
+        issue(younger, is_ex_next[1]);
+        stall_fetch = false;
+    } else if (younger.valid) {
+        // The younger instruction moves to lane 0 and issues on its own next cycle;
+        // fetch and decode hold until it has left.
+        id_is_next[0] = younger;
+        id_is_next[1].valid = false;
+        stall_fetch = true;
+    } else {
+        // No stall required: Clear the stall signal.
+        stall_fetch = false;
+    }
+}
+
+void CPURV32P6_Cycle::issue(const ID_IS_Latch& in, IS_EX_Latch& out) {
     // --- Operand Fetch ---
     // Read the values from the register bank and pass them to the Execute stage.
-    is_ex_next.pc = id_is_reg.pc;
-    is_ex_next.rs1_val = register_bank->getValue(id_is_reg.rs1);
-    is_ex_next.rs2_val = register_bank->getValue(id_is_reg.rs2);
-    is_ex_next.imm = id_is_reg.imm;
-    is_ex_next.rd = id_is_reg.rd;
-    is_ex_next.opcode = id_is_reg.opcode;
-    is_ex_next.funct3 = id_is_reg.funct3;
-    is_ex_next.funct7 = id_is_reg.funct7;
-    is_ex_next.valid = true;
+    out.pc = in.pc;
+    out.instr = in.instr;
+    out.rs1_val = in.rs1 == UOP_TMP ? uop_tmp : register_bank->getValue(in.rs1);
+    out.rs2_val = register_bank->getValue(in.rs2);
+    out.imm = in.imm;
+    out.rd = in.rd;
+    out.opcode = in.opcode;
+    out.funct3 = in.funct3;
+    out.funct7 = in.funct7;
+    out.length = in.length;
+    out.unit = in.unit;
+    out.ext_op = in.ext_op;
+    out.encoding = in.encoding;
+    out.retire = in.retire;
+    out.valid = true;
 
     // --- Update Scoreboard ---
     // Mark the destination register as "pending write" to prevent future instructions from 
     // reading it until the write-back is complete.
-    if (id_is_reg.rd != 0) scoreboard[id_is_reg.rd] = true;
+    if (in.rd != 0) scoreboard[in.rd] = true;
+}
+
+// Zcmp push/pop and Zcmt table jumps move one register or table entry per load/store
+// micro-op, so they hold the LSU pipe for as many cycles: IS keeps the instruction and
+// stalls fetch while it issues them in order, each one after its sources are ready.
+void CPURV32P6_Cycle::issue_sequence(const ID_IS_Latch& in, const ID_IS_Latch& younger) {
+    if (uops.empty()) {
+        crack(in);
+    }
+
+    const ID_IS_Latch& uop = uops[uop_next];
+    if (scoreboard[uop.rs1] || scoreboard[uop.rs2]) {
+        id_is_next = id_is_reg;
+        stall_fetch = true;
+        return;
+    }
+    issue(uop, is_ex_next[0]);
+
+    if (++uop_next < uops.size()) {
+        id_is_next = id_is_reg;
+        stall_fetch = true;
+        return;
+    }
+    uops.clear();
+    uop_next = 0;
+
+    if (younger.valid) {
+        // The younger instruction moves to lane 0 and issues next cycle.
+        id_is_next[0] = younger;
+        id_is_next[1].valid = false;
+        stall_fetch = true;
+    } else {
+        stall_fetch = false;
+    }
+}
+
+// Micro-ops of a Zcmp/Zcmt instruction, decoded like any other instruction at its PC.
+// cm.jt / cm.jalt load the jvt entry into UOP_TMP and jump through it.
+void CPURV32P6_Cycle::crack(const ID_IS_Latch& in) {
+    const auto parcel = static_cast<uint16_t>(in.instr);
+    ID_IS_Latch uop;
+
+    uint32_t words[FetchUnit::MAX_MICRO_OPS];
+    const unsigned int n = FetchUnit::crack(parcel, false, words);
+    for (unsigned int k = 0; k < n; k++) {
+        decode(IF_ID_Latch{in.pc, words[k], 2, in.encoding, true}, uop);
+        uops.push_back(uop);
+    }
+
+    const int index = FetchUnit::tableJumpIndex(parcel);
+    if (index >= 0) {
+        uop = in;
+        uop.unit = UNIT_BASE;
+        uop.opcode = 0x03;
+        uop.funct3 = 0x2;
+        uop.rd = UOP_TMP;
+        uop.rs1 = uop.rs2 = 0;
+        uop.imm = static_cast<int32_t>((register_bank->getCSR(CSR_JVT) & ~63u) + static_cast<uint32_t>(index) * 4);
+        uops.push_back(uop);
+        uop.opcode = 0x67;
+        uop.funct3 = 0;
+        uop.rd = index >= 32 ? 1 : 0;
+        uop.rs1 = UOP_TMP;
+        uop.imm = 0;
+        uops.push_back(uop);
+    }
+
+    if (uops.empty()) {
+        // Reserved encoding: EX stops on it like on any other unimplemented instruction.
+        uop = in;
+        uop.unit = UNIT_ILLEGAL;
+        uops.push_back(uop);
+    }
+    for (auto& u : uops) u.retire = false;
+    uops.back().retire = true;
 }
 
 void CPURV32P6_Cycle::EX_stage() {
-    if (!is_ex_reg.valid) {
-        ex_mem_next.valid = false;
+    RVVP_PROFILE_SCOPE(Execute);
+    if (ex_hold > 0) ex_hold--;
+    for (unsigned int lane = 0; lane < LANES; lane++) {
+        execute(is_ex_reg[lane], ex_mem_next[lane]);
+    }
+}
+
+void CPURV32P6_Cycle::execute(const IS_EX_Latch& in, EX_MEM_Latch& out) {
+    if (!in.valid) {
+        out.valid = false;
         return;
     }
 
@@ -331,81 +576,149 @@ void CPURV32P6_Cycle::EX_stage() {
     bool mem_read = false;
     bool mem_write = false;
 
+    if (in.unit == UNIT_ILLEGAL) {
+        // Not implemented by this model: stop instead of executing it as something else.
+        std::cout << "[Sim] Error: Illegal instruction 0x" << std::hex << in.instr << " at PC=" << in.pc << std::dec
+                  << " (not implemented by the 6-stage model). Stopping." << std::endl;
+        sc_core::sc_stop();
+        out.valid = false;
+        return;
+    }
+
+    if (in.unit == UNIT_CUSTOM) {
+        // Registered custom instruction: its semantic reads and writes the hart directly.
+        auto custom = execCustom(in.instr, in.pc, stats.cycles);
+        if (custom == CustomInstructions::Result::Illegal) {
+            std::cout << "[Sim] Error: Custom instruction 0x" << std::hex << in.instr << " at PC=" << in.pc << std::dec
+                      << " rejected its encoding. Stopping." << std::endl;
+            sc_core::sc_stop();
+            out.valid = false;
+            return;
+        }
+        if (custom == CustomInstructions::Result::Jump) {
+            pc_redirect_target = register_bank->getPC();
+            pc_redirect_valid = true;
+            flush_pipeline = true;
+        }
+        ex_hold = ex_cycles - 1;
+    }
+    if (in.unit == UNIT_BITMANIP || in.unit == UNIT_CRYPTO) {
+        // A multi-cycle Zb* / Zk* operation holds EX; a paired instruction may already hold it longer.
+        ex_hold = std::max(ex_hold, extension_latency(in.unit, in.ext_op) - 1);
+    }
+
     // Execute the operation based on the opcode
-    switch (is_ex_reg.opcode) {
+    switch (in.opcode) {
         case 0x33: // R-type Instructions (Register-Register)
-            switch (is_ex_reg.funct3) {
+            if (in.unit != UNIT_BASE) { // Zb* / Zk* (ALU pipe, clmul* on the MUL pipe)
+                result = extension_result(in);
+                break;
+            }
+            if (in.funct7 == 0x01) { // M extension (MUL pipe)
+                const int32_t a = static_cast<int32_t>(in.rs1_val);
+                const int32_t b = static_cast<int32_t>(in.rs2_val);
+                switch (in.funct3) {
+                    case 0x0: // MUL
+                        result = in.rs1_val * in.rs2_val; break;
+                    case 0x1: // MULH
+                        result = static_cast<uint32_t>((static_cast<int64_t>(a) * b) >> 32); break;
+                    case 0x2: // MULHSU
+                        result = static_cast<uint32_t>((static_cast<int64_t>(a) * static_cast<int64_t>(in.rs2_val)) >> 32); break;
+                    case 0x3: // MULHU
+                        result = static_cast<uint32_t>((static_cast<uint64_t>(in.rs1_val) * in.rs2_val) >> 32); break;
+                    case 0x4: // DIV (divide by zero gives -1, overflow gives the dividend)
+                        if (b == 0) result = UINT32_MAX;
+                        else if (a == INT32_MIN && b == -1) result = in.rs1_val;
+                        else result = static_cast<uint32_t>(a / b);
+                        break;
+                    case 0x5: // DIVU
+                        result = (in.rs2_val == 0) ? UINT32_MAX : in.rs1_val / in.rs2_val; break;
+                    case 0x6: // REM (remainder by zero gives the dividend, overflow gives 0)
+                        if (b == 0) result = in.rs1_val;
+                        else if (a == INT32_MIN && b == -1) result = 0;
+                        else result = static_cast<uint32_t>(a % b);
+                        break;
+                    case 0x7: // REMU
+                        result = (in.rs2_val == 0) ? in.rs1_val : in.rs1_val % in.rs2_val; break;
+                }
+                break;
+            }
+            switch (in.funct3) {
                 case 0x0: // ADD / SUB
-                    if (is_ex_reg.funct7 == 0x20) result = is_ex_reg.rs1_val - is_ex_reg.rs2_val;
-                    else result = is_ex_reg.rs1_val + is_ex_reg.rs2_val;
+                    if (in.funct7 == 0x20) result = in.rs1_val - in.rs2_val;
+                    else result = in.rs1_val + in.rs2_val;
                     break;
                 case 0x1: // SLL (Shift Left Logical)
-                    result = is_ex_reg.rs1_val << (is_ex_reg.rs2_val & 0x1F); break;
+                    result = in.rs1_val << (in.rs2_val & 0x1F); break;
                 case 0x2: // SLT (Set Less Than)
-                    result = (static_cast<int32_t>(is_ex_reg.rs1_val) < static_cast<int32_t>(is_ex_reg.rs2_val)); break;
+                    result = (static_cast<int32_t>(in.rs1_val) < static_cast<int32_t>(in.rs2_val)); break;
                 case 0x3: // SLTU (Set Less Than Unsigned)
-                    result = (is_ex_reg.rs1_val < is_ex_reg.rs2_val); break;
+                    result = (in.rs1_val < in.rs2_val); break;
                 case 0x4: // XOR
-                    result = is_ex_reg.rs1_val ^ is_ex_reg.rs2_val; break;
+                    result = in.rs1_val ^ in.rs2_val; break;
                 case 0x5: // SRL / SRA (Shift Right Logical / Arithmetic)
-                    if (is_ex_reg.funct7 == 0x20) result = static_cast<int32_t>(is_ex_reg.rs1_val) >> (is_ex_reg.rs2_val & 0x1F);
-                    else result = is_ex_reg.rs1_val >> (is_ex_reg.rs2_val & 0x1F);
+                    if (in.funct7 == 0x20) result = static_cast<int32_t>(in.rs1_val) >> (in.rs2_val & 0x1F);
+                    else result = in.rs1_val >> (in.rs2_val & 0x1F);
                     break;
                 case 0x6: // OR
-                    result = is_ex_reg.rs1_val | is_ex_reg.rs2_val; break;
+                    result = in.rs1_val | in.rs2_val; break;
                 case 0x7: // AND
-                    result = is_ex_reg.rs1_val & is_ex_reg.rs2_val; break;
+                    result = in.rs1_val & in.rs2_val; break;
             }
             break;
 
         case 0x13: // I-type Instructions (Immediate-Register)
-            switch (is_ex_reg.funct3) {
+            if (in.unit != UNIT_BASE) { // Zb* / Zk* (ALU pipe)
+                result = extension_result(in);
+                break;
+            }
+            switch (in.funct3) {
                 case 0x0: // ADDI
-                    result = is_ex_reg.rs1_val + is_ex_reg.imm; break;
+                    result = in.rs1_val + in.imm; break;
                 case 0x2: // SLTI
-                    result = (static_cast<int32_t>(is_ex_reg.rs1_val) < is_ex_reg.imm); break;
+                    result = (static_cast<int32_t>(in.rs1_val) < in.imm); break;
                 case 0x3: // SLTIU
-                    result = (is_ex_reg.rs1_val < static_cast<uint32_t>(is_ex_reg.imm)); break;
+                    result = (in.rs1_val < static_cast<uint32_t>(in.imm)); break;
                 case 0x4: // XORI
-                    result = is_ex_reg.rs1_val ^ is_ex_reg.imm; break;
+                    result = in.rs1_val ^ in.imm; break;
                 case 0x6: // ORI
-                    result = is_ex_reg.rs1_val | is_ex_reg.imm; break;
+                    result = in.rs1_val | in.imm; break;
                 case 0x7: // ANDI
-                    result = is_ex_reg.rs1_val & is_ex_reg.imm; break;
+                    result = in.rs1_val & in.imm; break;
                 case 0x1: // SLLI
-                    result = is_ex_reg.rs1_val << (is_ex_reg.imm & 0x1F); break;
+                    result = in.rs1_val << (in.imm & 0x1F); break;
                 case 0x5: // SRLI / SRAI
-                    if ((is_ex_reg.imm & 0x400) != 0) result = static_cast<int32_t>(is_ex_reg.rs1_val) >> (is_ex_reg.imm & 0x1F);
-                    else result = is_ex_reg.rs1_val >> (is_ex_reg.imm & 0x1F);
+                    if ((in.imm & 0x400) != 0) result = static_cast<int32_t>(in.rs1_val) >> (in.imm & 0x1F);
+                    else result = in.rs1_val >> (in.imm & 0x1F);
                     break;
             }
             break;
 
         case 0x03: // Load Instructions
-            result = is_ex_reg.rs1_val + is_ex_reg.imm; // Calculate effective address
+            result = in.rs1_val + in.imm; // Calculate effective address
             mem_read = true; 
             break;
 
         case 0x23: // Store Instructions
-            result = is_ex_reg.rs1_val + is_ex_reg.imm; // Calculate effective address
+            result = in.rs1_val + in.imm; // Calculate effective address
             mem_write = true; 
             break;
 
         case 0x63: // Branch Instructions
-            branch_target = is_ex_reg.pc + is_ex_reg.imm;
-            switch (is_ex_reg.funct3) {
+            branch_target = in.pc + in.imm;
+            switch (in.funct3) {
                 case 0x0: // BEQ
-                    branch_taken = (is_ex_reg.rs1_val == is_ex_reg.rs2_val); break;
+                    branch_taken = (in.rs1_val == in.rs2_val); break;
                 case 0x1: // BNE
-                    branch_taken = (is_ex_reg.rs1_val != is_ex_reg.rs2_val); break;
+                    branch_taken = (in.rs1_val != in.rs2_val); break;
                 case 0x4: // BLT
-                    branch_taken = (static_cast<int32_t>(is_ex_reg.rs1_val) < static_cast<int32_t>(is_ex_reg.rs2_val)); break;
+                    branch_taken = (static_cast<int32_t>(in.rs1_val) < static_cast<int32_t>(in.rs2_val)); break;
                 case 0x5: // BGE
-                    branch_taken = (static_cast<int32_t>(is_ex_reg.rs1_val) >= static_cast<int32_t>(is_ex_reg.rs2_val)); break;
+                    branch_taken = (static_cast<int32_t>(in.rs1_val) >= static_cast<int32_t>(in.rs2_val)); break;
                 case 0x6: // BLTU
-                    branch_taken = (is_ex_reg.rs1_val < is_ex_reg.rs2_val); break;
+                    branch_taken = (in.rs1_val < in.rs2_val); break;
                 case 0x7: // BGEU
-                    branch_taken = (is_ex_reg.rs1_val >= is_ex_reg.rs2_val); break;
+                    branch_taken = (in.rs1_val >= in.rs2_val); break;
             }
             // If branch is taken, redirect PC and flush next cycle
             if (branch_taken) {
@@ -416,29 +729,29 @@ void CPURV32P6_Cycle::EX_stage() {
             break;
 
         case 0x6F: // JAL (Jump and Link)
-            result = is_ex_reg.pc + 4; // Save return address
-            pc_redirect_target = is_ex_reg.pc + is_ex_reg.imm; 
+            result = in.pc + in.length; // Save return address (pc + 2 for C.JAL)
+            pc_redirect_target = in.pc + in.imm; 
             pc_redirect_valid = true; 
             flush_pipeline = true; 
             break;
 
         case 0x67: // JALR (Jump and Link Register)
-            result = is_ex_reg.pc + 4; // Save return address
-            pc_redirect_target = (is_ex_reg.rs1_val + is_ex_reg.imm) & ~1; // Target is rs1 + imm, LSB masked to 0
+            result = in.pc + in.length; // Save return address (pc + 2 for C.JALR)
+            pc_redirect_target = (in.rs1_val + in.imm) & ~1; // Target is rs1 + imm, LSB masked to 0
             pc_redirect_valid = true; 
             flush_pipeline = true; 
             break;
 
         case 0x37: // LUI (Load Upper Immediate)
-            result = is_ex_reg.imm; 
+            result = in.imm; 
             break;
 
         case 0x17: // AUIPC (Add Upper Immediate to PC)
-            result = is_ex_reg.pc + is_ex_reg.imm; 
+            result = in.pc + in.imm; 
             break;
 
         case 0x73: // SYSTEM (ECALL, etc.)
-            if (is_ex_reg.funct3 == 0 && is_ex_reg.imm == 0) {
+            if (in.funct3 == 0 && in.imm == 0) {
                  // ECALL: Get syscall number from A7 (x17)
                  uint32_t syscall_num = register_bank->getValue(17);
                  if (syscall_num == 93 || syscall_num == 1) { // exit (93) or (1)
@@ -461,86 +774,177 @@ void CPURV32P6_Cycle::EX_stage() {
     }
 
     // Forward results to MEM stage
-    ex_mem_next.pc = is_ex_reg.pc;
-    ex_mem_next.alu_result = result;
-    ex_mem_next.store_data = is_ex_reg.rs2_val;
-    ex_mem_next.rd = is_ex_reg.rd;
-    ex_mem_next.funct3 = is_ex_reg.funct3;
-    ex_mem_next.mem_read = mem_read;
-    ex_mem_next.mem_write = mem_write;
-    ex_mem_next.branch_taken = branch_taken;
-    ex_mem_next.branch_target = branch_target;
-    ex_mem_next.valid = true;
+    out.pc = in.pc;
+    out.alu_result = result;
+    out.store_data = in.rs2_val;
+    out.rd = in.rd;
+    out.funct3 = in.funct3;
+    out.mem_read = mem_read;
+    out.mem_write = mem_write;
+    out.branch_taken = branch_taken;
+    out.branch_target = branch_target;
+    out.encoding = in.encoding;
+    out.retire = in.retire;
+    out.valid = true;
+}
+
+// Zb* / Zk* operation decoded in ID, on the operands read at issue
+uint32_t CPURV32P6_Cycle::extension_result(const IS_EX_Latch& in) {
+    uint32_t result = 0;
+    if (in.unit == UNIT_BITMANIP) {
+        b_inst->setInstr(in.instr);
+        b_inst->compute(static_cast<op_B_Codes>(in.ext_op), in.rs1_val, in.rs2_val, result);
+    } else {
+        k_inst->setInstr(in.instr);
+        k_inst->compute(static_cast<op_K_Codes>(in.ext_op), in.rs1_val, in.rs2_val, result);
+    }
+    return result;
+}
+
+// Cycles a Zb* / Zk* operation holds EX
+unsigned int CPURV32P6_Cycle::extension_latency(uint8_t unit, uint8_t ext_op) const {
+    if (unit == UNIT_BITMANIP) {
+        switch (static_cast<op_B_Codes>(ext_op)) {
+            case OP_B_CLMUL: case OP_B_CLMULH: case OP_B_CLMULR:
+                return latency.clmul_latency;
+            case OP_B_CLZ: case OP_B_CTZ: case OP_B_CPOP:
+            case OP_B_CLZW: case OP_B_CTZW: case OP_B_CPOPW:
+                return latency.bitcount_latency;
+            default:
+                return 1;
+        }
+    }
+    switch (static_cast<op_K_Codes>(ext_op)) {
+        case OP_K_SM4ED: case OP_K_SM4KS:
+            return latency.sm4_latency;
+        case OP_K_SHA256SIG0: case OP_K_SHA256SIG1: case OP_K_SHA256SUM0: case OP_K_SHA256SUM1:
+        case OP_K_SHA512SIG0: case OP_K_SHA512SIG1: case OP_K_SHA512SUM0: case OP_K_SHA512SUM1:
+        case OP_K_SHA512SIG0L: case OP_K_SHA512SIG0H: case OP_K_SHA512SIG1L: case OP_K_SHA512SIG1H:
+        case OP_K_SHA512SUM0R: case OP_K_SHA512SUM1R:
+        case OP_K_SM3P0: case OP_K_SM3P1:
+            return latency.hash_latency;
+        case OP_K_AES64KS2: // XOR of two words
+            return 1;
+        default:            // aes32* / aes64*
+            return latency.aes_latency;
+    }
 }
 
 void CPURV32P6_Cycle::MEM_stage() {
-    if (!ex_mem_reg.valid) {
-        mem_wb_next.valid = false;
+    for (unsigned int lane = 0; lane < LANES; lane++) {
+        memory(ex_mem_reg[lane], mem_wb_next[lane]);
+    }
+}
+
+void CPURV32P6_Cycle::memory(const EX_MEM_Latch& in, MEM_WB_Latch& out) {
+    if (!in.valid) {
+        out.valid = false;
         return;
     }
 
-    uint32_t result = ex_mem_reg.alu_result;
+    uint32_t result = in.alu_result;
 
     // Handle Memory Read Operations
-    if (ex_mem_reg.mem_read) {
-        switch (ex_mem_reg.funct3) {
+    if (in.mem_read) {
+        switch (in.funct3) {
             case 0x0: // LB (Load Byte)
-                result = static_cast<int32_t>(static_cast<int8_t>(mem_intf->readDataMem(ex_mem_reg.alu_result, 1))); 
+                result = static_cast<int32_t>(static_cast<int8_t>(mem_intf->readDataMem(in.alu_result, 1))); 
                 break;
             case 0x1: // LH (Load Halfword)
-                result = static_cast<int32_t>(static_cast<int16_t>(mem_intf->readDataMem(ex_mem_reg.alu_result, 2))); 
+                result = static_cast<int32_t>(static_cast<int16_t>(mem_intf->readDataMem(in.alu_result, 2))); 
                 break;
             case 0x2: // LW (Load Word)
-                result = mem_intf->readDataMem(ex_mem_reg.alu_result, 4); 
+                result = mem_intf->readDataMem(in.alu_result, 4); 
                 break;
             case 0x4: // LBU (Load Byte Unsigned)
-                result = mem_intf->readDataMem(ex_mem_reg.alu_result, 1); 
+                result = mem_intf->readDataMem(in.alu_result, 1); 
                 break;
             case 0x5: // LHU (Load Halfword Unsigned)
-                result = mem_intf->readDataMem(ex_mem_reg.alu_result, 2); 
+                result = mem_intf->readDataMem(in.alu_result, 2); 
                 break;
         }
     } 
     // Handle Memory Write Operations
-    else if (ex_mem_reg.mem_write) {
-        switch (ex_mem_reg.funct3) {
+    else if (in.mem_write) {
+        switch (in.funct3) {
             case 0x0: // SB (Store Byte)
-                mem_intf->writeDataMem(ex_mem_reg.alu_result, ex_mem_reg.store_data, 1); 
+                mem_intf->writeDataMem(in.alu_result, in.store_data, 1); 
                 break;
             case 0x1: // SH (Store Halfword)
-                mem_intf->writeDataMem(ex_mem_reg.alu_result, ex_mem_reg.store_data, 2); 
+                mem_intf->writeDataMem(in.alu_result, in.store_data, 2); 
                 break;
             case 0x2: // SW (Store Word)
-                mem_intf->writeDataMem(ex_mem_reg.alu_result, ex_mem_reg.store_data, 4); 
+                mem_intf->writeDataMem(in.alu_result, in.store_data, 4); 
                 break;
         }
     }
 
     // Pass results to Write Back stage
-    mem_wb_next.result = result;
-    mem_wb_next.rd = ex_mem_reg.rd;
+    out.pc = in.pc;
+    out.result = result;
+    out.rd = in.rd;
     // We only write to the register if the destination is not x0 (hardwired to 0) 
     // and this is not a store instruction.
-    mem_wb_next.reg_write = (ex_mem_reg.rd != 0) && !ex_mem_reg.mem_write;
-    mem_wb_next.valid = true;
+    out.reg_write = (in.rd != 0) && !in.mem_write;
+    out.mem_addr = in.alu_result;
+    out.mem_size = (in.mem_read || in.mem_write) ? static_cast<uint8_t>(1u << (in.funct3 & 0x3)) : 0;
+    out.mem_write = in.mem_write;
+    out.encoding = in.encoding;
+    out.retire = in.retire;
+    out.valid = true;
 }
 
 void CPURV32P6_Cycle::WB_stage() {
+    // Instructions held back by a run-control pause retire first.
+    bool paused = false;
+    std::size_t done = 0;
+    while (done < wb_held.size() && !paused) {
+        paused = writeback(wb_held[done++]);
+    }
+    wb_held.erase(wb_held.begin(), wb_held.begin() + done);
+
+    // Lane 0 holds the older instruction and writes back first.
+    for (unsigned int lane = 0; lane < LANES; lane++) {
+        if (paused) {
+            if (mem_wb_reg[lane].valid) wb_held.push_back(mem_wb_reg[lane]);
+        } else {
+            paused = writeback(mem_wb_reg[lane]);
+        }
+    }
+}
+
+bool CPURV32P6_Cycle::writeback(const MEM_WB_Latch& in) {
     // If the instruction coming from MEM is invalid, do nothing.
-    if (!mem_wb_reg.valid) return;
+    if (!in.valid) return false;
     
     // Perform the actual register write
-    if (mem_wb_reg.reg_write && mem_wb_reg.rd != 0) {
-        register_bank->setValue(mem_wb_reg.rd, mem_wb_reg.result);
+    if (in.reg_write && in.rd == UOP_TMP) {
+        uop_tmp = in.result;
+        scoreboard[UOP_TMP] = false;
+    } else if (in.reg_write && in.rd != 0) {
+        register_bank->setValue(in.rd, in.result);
         
         // Critical: Release the lock on the destination register in the scoreboard
         // effectively indicating that the dependency is resolved.
-        scoreboard[mem_wb_reg.rd] = false;
+        scoreboard[in.rd] = false;
+    }
+
+    // Plugins see the data accesses after the instruction that made them
+    if (in.mem_size != 0 && PluginManager::active()) {
+        plugin_accesses.push_back({in.mem_addr, in.mem_size, in.mem_write});
     }
+
+    // The micro-ops of a sequence retire as one instruction, with the last of them.
+    if (!in.retire) return false;
+
+    // Plugins see retired instructions only, never wrong-path ones.
+    pluginInsnExec(in.pc, in.encoding);
+    reportPluginAccesses();
     
     // Increment stats for retired instructions
     stats.instructions++;
     perf->instructionsInc();
+    return runControlRetire(register_bank, in.pc, stats.cycles);
 }
 
 
@@ -566,6 +970,64 @@ void CPURV32P6_Cycle::printStats() const {
     std::cout << "  Cycles:       " << stats.cycles << "\n";
     std::cout << "  Instructions: " << stats.instructions << "\n";
     std::cout << "  CPI:          " << std::fixed << std::setprecision(2) << stats.get_cpi() << "\n";
+    fetch_unit.printStats(std::cout);
+    if (rules.width > 1) pair_stats.print(std::cout);
+}
+
+void CPURV32P6_Cycle::visitLatches(LatchMap &map) {
+    for (unsigned int lane = 0; lane < rules.width; lane++) {
+        const std::string n = "[" + std::to_string(lane) + "].";
+        auto &f = if_id_reg[lane];
+        map.add("if_id" + n + "pc", f.pc);
+        map.add("if_id" + n + "instr", f.instr);
+        map.add("if_id" + n + "length", f.length, 3);
+        map.add("if_id" + n + "valid", f.valid);
+        auto &d = id_is_reg[lane];
+        map.add("id_is" + n + "pc", d.pc);
+        map.add("id_is" + n + "instr", d.instr);
+        map.add("id_is" + n + "rd", d.rd, 5);
+        map.add("id_is" + n + "rs1", d.rs1, 5);
+        map.add("id_is" + n + "rs2", d.rs2, 5);
+        map.add("id_is" + n + "imm", d.imm);
+        map.add("id_is" + n + "opcode", d.opcode, 7);
+        map.add("id_is" + n + "funct3", d.funct3, 3);
+        map.add("id_is" + n + "funct7", d.funct7, 7);
+        map.add("id_is" + n + "length", d.length, 3);
+        map.add("id_is" + n + "unit", d.unit, 2);
+        map.add("id_is" + n + "ext_op", d.ext_op);
+        map.add("id_is" + n + "valid", d.valid);
+        auto &i = is_ex_reg[lane];
+        map.add("is_ex" + n + "pc", i.pc);
+        map.add("is_ex" + n + "instr", i.instr);
+        map.add("is_ex" + n + "rs1_val", i.rs1_val);
+        map.add("is_ex" + n + "rs2_val", i.rs2_val);
+        map.add("is_ex" + n + "imm", i.imm);
+        map.add("is_ex" + n + "rd", i.rd, 5);
+        map.add("is_ex" + n + "opcode", i.opcode, 7);
+        map.add("is_ex" + n + "funct3", i.funct3, 3);
+        map.add("is_ex" + n + "funct7", i.funct7, 7);
+        map.add("is_ex" + n + "length", i.length, 3);
+        map.add("is_ex" + n + "unit", i.unit, 2);
+        map.add("is_ex" + n + "ext_op", i.ext_op);
+        map.add("is_ex" + n + "valid", i.valid);
+        auto &e = ex_mem_reg[lane];
+        map.add("ex_mem" + n + "pc", e.pc);
+        map.add("ex_mem" + n + "alu_result", e.alu_result);
+        map.add("ex_mem" + n + "store_data", e.store_data);
+        map.add("ex_mem" + n + "rd", e.rd, 5);
+        map.add("ex_mem" + n + "funct3", e.funct3, 3);
+        map.add("ex_mem" + n + "mem_read", e.mem_read);
+        map.add("ex_mem" + n + "mem_write", e.mem_write);
+        map.add("ex_mem" + n + "branch_taken", e.branch_taken);
+        map.add("ex_mem" + n + "branch_target", e.branch_target);
+        map.add("ex_mem" + n + "valid", e.valid);
+        auto &m = mem_wb_reg[lane];
+        map.add("mem_wb" + n + "pc", m.pc);
+        map.add("mem_wb" + n + "result", m.result);
+        map.add("mem_wb" + n + "rd", m.rd, 5);
+        map.add("mem_wb" + n + "reg_write", m.reg_write);
+        map.add("mem_wb" + n + "valid", m.valid);
+    }
 }
 
 } // namespace riscv_tlm
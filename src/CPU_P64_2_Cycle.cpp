@@ -4,6 +4,8 @@
  * @brief 2-Stage Pipelined RISC-V 64-bit CPU - Cycle-Accurate Implementation
  */
 #include "CPU_P64_2_Cycle.h"
+#include "SelfProfile.h"
+#include "FaultCampaign.h"
 #include "spdlog/spdlog.h"
 #include <iostream>
 #include <iomanip>
@@ -14,7 +16,9 @@ CPURV64P2_Cycle::CPURV64P2_Cycle(sc_core::sc_module_name const& name, BaseType P
     : CPU(name, debug) {
 
     register_bank = new Registers<BaseType>();
+    registerPluginHart(register_bank);
     mem_intf = new MemoryInterface();
+    attachCustomInstructions(register_bank);
 
     register_bank->setPC(PC);
     register_bank->setValue(Registers<BaseType>::sp, (Memory::SIZE / 4) - 1); // This might be small for 64-bit, but follows pattern
@@ -26,6 +30,12 @@ CPURV64P2_Cycle::CPURV64P2_Cycle(sc_core::sc_module_name const& name, BaseType P
     c_inst    = new C_extension<BaseType>(0, register_bank, mem_intf);
     m_inst    = new M_extension<BaseType>(0, register_bank, mem_intf);
     a_inst    = new A_extension<BaseType>(0, register_bank, mem_intf);
+    v_inst    = new V_extension<BaseType>(0, register_bank, mem_intf);
+    f_inst    = new F_extension<BaseType>(0, register_bank, mem_intf);
+    b_inst    = new B_extension<BaseType>(0, register_bank, mem_intf);
+    k_inst    = new K_extension<BaseType>(0, register_bank, mem_intf);
+    isa       = {base_inst, c_inst, m_inst, a_inst, v_inst, f_inst, b_inst, k_inst};
+    register_bank->setExtensions(isa.misa());
 
     if_ex_latch.instruction = 0;
     if_ex_latch.pc = 0;
@@ -55,14 +65,16 @@ CPURV64P2_Cycle::~CPURV64P2_Cycle() {
     delete c_inst;
     delete m_inst;
     delete a_inst;
+    delete v_inst;
+    delete f_inst;
+    delete b_inst;
+    delete k_inst;
     delete m_qk;
 }
 
-void CPURV64P2_Cycle::set_clock(sc_core::sc_clock* c) {
+void CPURV64P2_Cycle::set_clock(ClockDomain* c) {
+    CPU::set_clock(c);
     clk = c;
-    if (clk) {
-        clock_period = clk->period();
-    }
 }
 
 void CPURV64P2_Cycle::printStats() const {
@@ -72,6 +84,8 @@ void CPURV64P2_Cycle::printStats() const {
     std::cout << "Instructions Retired:  " << stats.instructions_retired << std::endl;
     std::cout << "CPI (Cycles/Instr):    " << stats.get_cpi() << std::endl;
     std::cout << "IPC (Instr/Cycle):     " << stats.get_ipc() << std::endl;
+    std::cout << "Interrupts Taken:      " << stats.irq_entries << std::endl;
+    std::cout << "IRQ Entry Cycles:      " << stats.irq_entry_cycles << std::endl;
     std::cout << "==========================================================" << std::endl;
 }
 
@@ -79,24 +93,26 @@ void CPURV64P2_Cycle::cycle_thread() {
     if (clk) {
         sc_core::wait(clk->posedge_event());
     } else {
-        sc_core::wait(clock_period);
+        sc_core::wait(corePeriod());
     }
     
     while (true) {
         on_posedge();
-        sc_core::wait(clock_period / 2);
+        sc_core::wait(corePeriod() / 2);
         on_negedge();
         if (clk) {
             sc_core::wait(clk->posedge_event());
         } else {
-            sc_core::wait(clock_period / 2);
+            sc_core::wait(corePeriod() / 2);
         }
     }
 }
 
 void CPURV64P2_Cycle::on_posedge() {
     stats.total_cycles++;
-    cpu_process_IRQ();
+    if (cpu_process_IRQ() && PluginManager::active()) {
+        PluginManager::getInstance()->onInterrupt(plugin_hart);
+    }
     
     if (pipeline_flush) {
         if_ex_latch.valid = false;
@@ -215,6 +231,12 @@ uint32_t CPURV64P2_Cycle::get_instruction_latency(std::uint32_t instruction) {
         if (funct3 < 4) return latency.mul_latency;
         else return latency.div_latency;
     }
+    if (opcode == 0x33 && funct7 == 0x05 && funct3 >= 1 && funct3 <= 3) {
+        return latency.clmul_latency;
+    }
+    if ((opcode == 0x13 || opcode == 0x1B) && funct3 == 1 && (instruction >> 22) == 0x180) {
+        return latency.bitcount_latency;
+    }
     if (opcode == 0x03) return latency.load_latency;
     if (opcode == 0x23) return latency.store_latency;
     return 1;
@@ -242,38 +264,35 @@ bool CPURV64P2_Cycle::EX_stage() {
     bool pc_changed = false;
     bool is_branch = false;
 
-    base_inst->setInstr(instr);
-    auto deco = base_inst->decode();
-
-    if (deco != OP_ERROR) {
-        std::uint32_t opcode = instr & 0x7F;
-        is_branch = (opcode == 0x63 || opcode == 0x6F || opcode == 0x67);
-        pc_changed = !base_inst->exec_instruction(inst, &breakpoint, deco);
+    pluginInsnExec(if_ex_latch.pc, instr);
+    auto custom = execCustom(instr, if_ex_latch.pc, stats.total_cycles);
+    if (custom != CustomInstructions::Result::NotCustom) {
+        if (custom == CustomInstructions::Result::Illegal) {
+            base_inst->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, instr);
+        }
+        // A jump or trap redirected the PC: drop the fetched instruction
+        is_branch = pc_changed = (custom != CustomInstructions::Result::Sequential);
     } else {
-        c_inst->setInstr(instr);
-        auto c_deco = c_inst->decode();
-        if (c_deco != OP_C_ERROR) {
-            is_branch = (c_deco == OP_C_J || c_deco == OP_C_JAL || 
-                        c_deco == OP_C_JR || c_deco == OP_C_JALR ||
-                        c_deco == OP_C_BEQZ || c_deco == OP_C_BNEZ);
-            pc_changed = !c_inst->exec_instruction(inst, &breakpoint, c_deco);
-        } else {
-            m_inst->setInstr(instr);
-            auto m_deco = m_inst->decode();
-            if (m_deco != OP_M_ERROR) {
-                pc_changed = !m_inst->exec_instruction(inst, m_deco);
-            } else {
-                a_inst->setInstr(instr);
-                auto a_deco = a_inst->decode();
-                if (a_deco != OP_A_ERROR) {
-                    pc_changed = !a_inst->exec_instruction(inst, a_deco);
-                } else {
-                     base_inst->NOP();
-                }
+        auto step = dispatchExtensions(isa, inst, instr, &breakpoint);
+        pc_changed = step.pc_changed;
+        is_branch = step.control_flow;
+        ex_cycles = step.cycles;
+        // Zcmp/Zcmt sequence one memory micro-op per register or table entry
+        if (step.unit == ExtensionUnit::C) {
+            const auto &uops = c_inst->lastMicroOps();
+            if (uops.loads + uops.stores > 0) {
+                ex_cycles = uops.loads * latency.load_latency + uops.stores * latency.store_latency + uops.alu;
             }
         }
     }
 
+    // Multi-cycle custom or vector instruction holds EX
+    if (ex_cycles > 1) {
+        stats.instruction_cycles += ex_cycles - 1;
+        stats.stall_cycles += ex_cycles - 1;
+        stats.total_cycles += ex_cycles - 1;
+    }
+
     if (is_branch && pc_changed) {
         pipeline_flush = true;
         stats.branch_penalty += latency.branch_penalty;
@@ -282,14 +301,15 @@ bool CPURV64P2_Cycle::EX_stage() {
 
     stats.instructions_retired++;
     perf->instructionsInc();
+    runControlRetire(register_bank, if_ex_latch.pc, stats.total_cycles);
     return breakpoint;
 }
 
 bool CPURV64P2_Cycle::CPU_step() {
     on_posedge();
-    sc_core::wait(clock_period / 2);
+    sc_core::wait(corePeriod() / 2);
     on_negedge();
-    sc_core::wait(clock_period / 2);
+    sc_core::wait(corePeriod() / 2);
     return false;
 }
 
@@ -297,6 +317,18 @@ bool CPURV64P2_Cycle::cpu_process_IRQ() {
     BaseType csr_temp;
     bool ret_value = false;
 
+    if (takeCLICInterrupt(register_bank) || takeExternalInterrupt(register_bank)) {
+        pipeline_flush = true;
+        if_ex_latch.valid = false;
+        if_ex_latch_next.valid = false;
+        std::uint64_t entry = 2 + (irq_vectored ? latency.load_latency : 0);
+        stats.stall_cycles += entry;
+        stats.total_cycles += entry;
+        stats.irq_entries++;
+        stats.irq_entry_cycles += entry;
+        return true;
+    }
+
     if (interrupt) {
         csr_temp = register_bank->getCSR(CSR_MSTATUS);
         if ((csr_temp & MSTATUS_MIE) == 0) return ret_value;
@@ -309,6 +341,7 @@ bool CPURV64P2_Cycle::cpu_process_IRQ() {
             BaseType old_pc = register_bank->getPC();
             register_bank->setCSR(CSR_MEPC, old_pc);
             register_bank->setCSR(CSR_MCAUSE, 0x80000000 | 11);
+            register_bank->enterTrap(Machine);
             BaseType new_pc = register_bank->getCSR(CSR_MTVEC);
             register_bank->setPC(new_pc);
 
@@ -347,4 +380,10 @@ std::uint64_t CPURV64P2_Cycle::getEndDumpAddress() {
     return register_bank->getValue(Registers<std::uint64_t>::t1);
 }
 
+void CPURV64P2_Cycle::visitLatches(LatchMap &map) {
+    map.add("if_ex.instruction", if_ex_latch.instruction);
+    map.add("if_ex.pc", if_ex_latch.pc);
+    map.add("if_ex.valid", if_ex_latch.valid);
+}
+
 } // namespace riscv_tlm
@@ -1,6 +1,9 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "CPU_P64_6_Cycle.h"
+#include "SelfProfile.h"
+#include "FaultCampaign.h"
 #include "spdlog/spdlog.h"
+#include <algorithm>
 #include <iostream>
 
 namespace riscv_tlm {
@@ -8,11 +11,16 @@ namespace riscv_tlm {
 CPURV64P6_Cycle::CPURV64P6_Cycle(sc_core::sc_module_name const& name,
                                  BaseType PC,
                                  bool debug)
-    : CPU(name, debug) {
+    : CPU(name, debug),
+      fetch_unit([this](uint64_t addr, uint8_t* data, unsigned int len) { return fetch_block(addr, data, len); },
+                 true, PC) {
 
     // Initialize Register Bank and Memory Interface
     register_bank = new Registers<BaseType>();
     mem_intf = new MemoryInterface();
+    attachCustomInstructions(register_bank);
+    registerPluginHart(register_bank);
+    mem_intf->setPluginReports(false);  // reported at retirement, see reportPluginAccesses()
 
     // Set Initial State
     register_bank->setPC(PC);
@@ -27,8 +35,10 @@ CPURV64P6_Cycle::CPURV64P6_Cycle(sc_core::sc_module_name const& name,
     base_inst = new BASE_ISA<BaseType>(0, register_bank, mem_intf);
     c_inst    = new C_extension<BaseType>(0, register_bank, mem_intf);
     m_inst    = new M_extension<BaseType>(0, register_bank, mem_intf);
-
-    next_pc = PC; // Initialize the Next Program Counter
+    b_inst    = new B_extension<BaseType>(0, register_bank, mem_intf);
+    k_inst    = new K_extension<BaseType>(0, register_bank, mem_intf);
+    // What execute() implements: RV64IMC (RVC is expanded in fetch) and Zb*/Zk*; no A, F/D or V
+    register_bank->setExtensions(MISA_I_BASE | MISA_M_EXTENSION | MISA_C_EXTENSION | MISA_B_EXTENSION);
 
     // Start the main simulation thread
     SC_THREAD(cycle_thread);
@@ -42,11 +52,13 @@ CPURV64P6_Cycle::~CPURV64P6_Cycle() {
     delete base_inst;
     delete c_inst;
     delete m_inst;
+    delete b_inst;
+    delete k_inst;
 }
 
-void CPURV64P6_Cycle::set_clock(sc_core::sc_clock* c) {
+void CPURV64P6_Cycle::set_clock(ClockDomain* c) {
+    CPU::set_clock(c);
     clk = c;
-    if (clk) clock_period = clk->period();
 }
 
 // =============================================================================
@@ -65,7 +77,7 @@ void CPURV64P6_Cycle::cycle_thread() {
             sc_core::wait(clk->posedge_event());
         } else {
              // Fallback if clock is not bound (should not happen in proper VP setup)
-            sc_core::wait(clock_period);
+            sc_core::wait(corePeriod());
         }
 
         // --- Pipeline Latch Transfer ---
@@ -73,7 +85,6 @@ void CPURV64P6_Cycle::cycle_thread() {
         issue_ex_reg = issue_ex_next;
         id_issue_reg = id_issue_next;
         fetch_id_reg = fetch_id_next;
-        pcgen_fetch_reg = pcgen_fetch_next;
 
         // --- Execute Pipeline Stages (Reverse Order) ---
         // Executing in reverse order allows stages to read the state produced by the previous 
@@ -107,14 +118,14 @@ void CPURV64P6_Cycle::cycle_thread() {
         }
 
         // --- Termination Logic ---
-        // Stop simulation if the pipeline is completely empty and no new instructions are being fetched.
+        // Stop simulation if the pipeline is completely empty and the front end cannot fetch
+        // anything more (a fetch block read failed and the instruction queue has drained).
         // We add a grace period (> 100 cycles) to allow the pipeline to fill up initially.
         if (stats.cycles > 100 && 
-            !pcgen_fetch_reg.valid && 
-            !pcgen_fetch_next.valid &&  // Ensure no new instruction is being generated
-            !fetch_id_reg.valid && 
-            !id_issue_reg.valid && 
-            !issue_ex_reg.valid && 
+            fetch_unit.faulted() &&
+            !fetch_id_reg[0].valid && 
+            !id_issue_reg[0].valid && 
+            !issue_ex_reg[0].valid && 
             rob.is_empty()) {
             
             std::cout << "Pipeline Empty & ROB Empty. Stopping Simulation." << std::endl;
@@ -133,34 +144,20 @@ void CPURV64P6_Cycle::PCGen_stage() {
     // 1. Check for Flush/Redirect from EX Stage (Highest Priority)
     // If a branch/jump misprediction or exception occurred, we must redirect the PC immediately.
     if (flush_pipeline) {
-        // Redirect PC to the target address calculated in the EX stage.
-        next_pc = pc_redirect_target;
+        // Drop the queued instruction bytes and restart fetching at the target address.
+        fetch_unit.redirect(pc_redirect_target);
         flush_pipeline = false; // Reset the flush flag after handling it.
         pc_redirect_valid = false;
-        
-        // Invalidate the instruction being fetched in this cycle.
-        pcgen_fetch_next.valid = false;
-        
-        // Note: downstream stages (Fetch, ID, etc.) will see the flush signal in their next cycle 
-        // or check invalid flags. We invalidate the NEXT state here to propagate the pipeline flush.
-        return;
-    }
 
-    // 2. Stall Check
-    // If a structural hazard or backpressure exists (e.g., ROB full), do not update the PC.
-    if (stall_pcgen) {
-        // Keep current state (effectively repeating the same PC for next cycle if we were outputting it)
-        // or just doing nothing creates a bubble if not careful, but here 'next_pc' is persistent state.
+        // Note: downstream stages (Fetch, ID, etc.) already invalidated their outputs this cycle.
+        // The target block is read next cycle and reaches Fetch the cycle after.
         return;
     }
 
-    // 3. Normal Operation
-    // Pass the current PC to the Fetch stage.
-    pcgen_fetch_next.pc = next_pc;
-    pcgen_fetch_next.valid = true;
-
-    // Advance PC for the NEXT cycle (standard 4-byte increment).
-    next_pc += 4;
+    // 2. Normal Operation
+    // Read the next aligned fetch block into the instruction queue if it has room.
+    // This continues while the back end stalls: a full queue is the backpressure.
+    fetch_unit.cycle();
 }
 
 // =============================================================================
@@ -169,44 +166,40 @@ void CPURV64P6_Cycle::PCGen_stage() {
 
 void CPURV64P6_Cycle::Fetch_stage() {
     // Check for Stalls
-    // If the Fetch stage is stalled (e.g., waiting for instruction memory), do not proceed.
+    // If the Fetch stage is stalled (backpressure from Issue), do not proceed.
     if (stall_fetch) {
         return; // Retain current output state
     }
-    
-    // Check if input from PCGen is valid
-    if (!pcgen_fetch_reg.valid) {
-        fetch_id_next.valid = false;
-        return;
-    }
 
     // Check for Pipeline Flush
-    // Even if PCGen handled it, we double check here to be safe and ensure no trash instruction propagates.
+    // PCGen redirects the fetch unit; no trash instruction may propagate.
+    for (auto& lane : fetch_id_next) lane.valid = false;
     if (flush_pipeline) {
-        fetch_id_next.valid = false;
         return;
     }
 
-    uint64_t current_pc = pcgen_fetch_reg.pc;
-    uint32_t instr = 0;
-
-    // Attempt to Fetch Instruction from Memory
-    if (fetch_instruction(current_pc, instr)) {
-        // Successful Fetch: Pass instruction and PC to Decode stage.
-        fetch_id_next.pc = current_pc;
-        fetch_id_next.instr = instr;
-        fetch_id_next.valid = true;
-    } else {
-        // Fetch Failed: This usually indicates a bus error or access violation.
-        // We invalidate the pipeline slot here. 
-        // Real hardware might trigger an Instruction Access Fault exception here.
-        fetch_id_next.valid = false;
+    // Take the oldest complete instructions from the queue, one per issue lane. 16-bit instructions
+    // arrive expanded; a 32-bit instruction that straddles two fetch blocks waits for the second block.
+    FetchUnit::Slot slot;
+    for (unsigned int lane = 0; lane < rules.width; lane++) {
+        // Fetch bubble: the queue is empty or holds half an instruction, or a block read
+        // failed (bus error or access violation) and the pipeline drains.
+        // Only a missing first instruction is counted as one.
+        if (lane == 0 ? !fetch_unit.take(slot) : !fetch_unit.peek(slot)) {
+            break;
+        }
+        if (lane != 0) fetch_unit.pop();
+        fetch_id_next[lane].pc = slot.pc;
+        fetch_id_next[lane].instr = slot.instr;
+        fetch_id_next[lane].length = slot.length;
+        fetch_id_next[lane].encoding = slot.encoding;
+        fetch_id_next[lane].valid = true;
     }
 }
 
-bool CPURV64P6_Cycle::fetch_instruction(uint64_t addr, uint32_t& data) {
-    if (dmi_ptr_valid && addr >= dmi_start_addr && (addr + 4) <= dmi_end_addr) {
-        std::memcpy(&data, dmi_ptr + (addr - dmi_start_addr), 4);
+bool CPURV64P6_Cycle::fetch_block(uint64_t addr, uint8_t* data, unsigned int len) {
+    if (dmi_ptr_valid && addr >= dmi_start_addr && (addr + len) <= dmi_end_addr) {
+        std::memcpy(data, dmi_ptr + (addr - dmi_start_addr), len);
         return true;
     }
 
@@ -215,9 +208,9 @@ bool CPURV64P6_Cycle::fetch_instruction(uint64_t addr, uint32_t& data) {
 
     trans.set_command(tlm::TLM_READ_COMMAND);
     trans.set_address(addr);
-    trans.set_data_ptr(reinterpret_cast<unsigned char*>(&data));
-    trans.set_data_length(4);
-    trans.set_streaming_width(4);
+    trans.set_data_ptr(data);
+    trans.set_data_length(len);
+    trans.set_streaming_width(len);
     trans.set_byte_enable_ptr(nullptr);
     trans.set_dmi_allowed(false);
     trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
@@ -243,9 +236,10 @@ bool CPURV64P6_Cycle::fetch_instruction(uint64_t addr, uint32_t& data) {
 // =============================================================================
 
 void CPURV64P6_Cycle::ID_stage() {
+    RVVP_PROFILE_SCOPE(Decode);
     // Check for Flush
     if (flush_pipeline) {
-        id_issue_next.valid = false;
+        for (auto& lane : id_issue_next) lane.valid = false;
         return;
     }
 
@@ -254,65 +248,155 @@ void CPURV64P6_Cycle::ID_stage() {
         return; // Hold current state
     }
 
+    for (unsigned int lane = 0; lane < LANES; lane++) {
+        decode(fetch_id_reg[lane], id_issue_next[lane]);
+    }
+}
+
+void CPURV64P6_Cycle::decode(const Fetch_ID_Latch& in, ID_Issue_Latch& out) {
     // Check Validity of Input
-    if (!fetch_id_reg.valid) {
-        id_issue_next.valid = false;
+    if (!in.valid) {
+        out.valid = false;
         return;
     }
 
-    uint32_t instr = fetch_id_reg.instr;
+    uint32_t instr = in.instr;
     
-    id_issue_next.pc = fetch_id_reg.pc;
-    id_issue_next.instr = instr;
-    id_issue_next.opcode = instr & 0x7F;
-    id_issue_next.funct3 = (instr >> 12) & 0x7;
-    id_issue_next.rs1 = (instr >> 15) & 0x1F;
-    id_issue_next.rs2 = (instr >> 20) & 0x1F;
-    id_issue_next.funct7 = (instr >> 25) & 0x7F;
+    out.pc = in.pc;
+    out.instr = instr;
+    out.length = in.length;
+    out.encoding = in.encoding;
+    out.retire = true;
+
+    // A Zcmp/Zcmt instruction stays a 16-bit parcel; Issue cracks it into micro-ops.
+    if (in.length == 2 && FetchUnit::isSequence(static_cast<uint16_t>(instr))) {
+        out.opcode = out.funct3 = out.funct7 = 0;
+        out.rd = out.rs1 = out.rs2 = 0;
+        out.imm = 0;
+        out.unit = UNIT_SEQUENCE;
+        out.valid = true;
+        return;
+    }
+
+    out.opcode = instr & 0x7F;
+    out.funct3 = (instr >> 12) & 0x7;
+    out.rs1 = (instr >> 15) & 0x1F;
+    out.rs2 = (instr >> 20) & 0x1F;
+    out.funct7 = (instr >> 25) & 0x7F;
+    out.unit = classify(instr, out.ext_op);
 
     // Decode Destination Register (rd)
     // S-Type (Store) and B-Type (Branch) do not have a destination register.
-    if (id_issue_next.opcode == 0x23 || id_issue_next.opcode == 0x63) {
-        id_issue_next.rd = 0; 
+    if (out.opcode == 0x23 || out.opcode == 0x63) {
+        out.rd = 0; 
     } else {
-        id_issue_next.rd = (instr >> 7) & 0x1F;
+        out.rd = (instr >> 7) & 0x1F;
+    }
+    if (out.unit == UNIT_CUSTOM) {
+        // The semantic writes its results itself; the ROB entry carries none.
+        out.rd = 0;
     }
 
     // Decode Immediate Value (Sign-Extended)
-    switch (id_issue_next.opcode) {
+    switch (out.opcode) {
         case 0x13: // I-type
+        case 0x1B: // I-type, 32-bit
         case 0x03: // Load
         case 0x67: // JALR
-            id_issue_next.imm = static_cast<int64_t>(static_cast<int32_t>(instr) >> 20);
+            out.imm = static_cast<int64_t>(static_cast<int32_t>(instr) >> 20);
             break;
         case 0x23: // S-type
-            id_issue_next.imm = static_cast<int64_t>(
+            out.imm = static_cast<int64_t>(
                 static_cast<int32_t>(((instr >> 25) << 5) | ((instr >> 7) & 0x1F)) << 20 >> 20);
             break;
         case 0x63: // B-type
-            id_issue_next.imm = static_cast<int64_t>(
+            out.imm = static_cast<int64_t>(
                 static_cast<int32_t>(
                     ((instr >> 31) << 12) | (((instr >> 7) & 1) << 11) |
                     (((instr >> 25) & 0x3F) << 5) | (((instr >> 8) & 0xF) << 1)) << 19 >> 19);
             break;
         case 0x37: // LUI
         case 0x17: // AUIPC
-            id_issue_next.imm = static_cast<int64_t>(static_cast<int32_t>(instr & 0xFFFFF000));
+            out.imm = static_cast<int64_t>(static_cast<int32_t>(instr & 0xFFFFF000));
             break;
         case 0x6F: // JAL
-            id_issue_next.imm = static_cast<int64_t>(
+            out.imm = static_cast<int64_t>(
                 static_cast<int32_t>(
                     ((instr >> 31) << 20) | (((instr >> 12) & 0xFF) << 12) |
                     (((instr >> 20) & 1) << 11) | (((instr >> 21) & 0x3FF) << 1)) << 11 >> 11);
             break;
         case 0x73: // SYSTEM
-            id_issue_next.imm = static_cast<int64_t>(static_cast<int32_t>(instr) >> 20);
+            out.imm = static_cast<int64_t>(static_cast<int32_t>(instr) >> 20);
             break;
         default:
-            id_issue_next.imm = 0;
+            out.imm = 0;
     }
 
-    id_issue_next.valid = true;
+    // Only the sources the instruction actually reads take part in hazard detection and pairing.
+    IssueOp op = IssueOp::fromDecode(out.opcode, out.funct3, out.funct7, out.rd, out.rs1, out.rs2);
+    out.rs1 = op.rs1;
+    out.rs2 = op.rs2;
+
+    out.valid = true;
+}
+
+// Execution unit of an instruction: the RV64IM encodings execute() implements, then Zb* and Zk*.
+uint8_t CPURV64P6_Cycle::classify(uint32_t instr, uint8_t& ext_op) {
+    const uint32_t funct3 = (instr >> 12) & 0x7;
+    const uint32_t funct7 = (instr >> 25) & 0x7F;
+    const uint32_t funct6 = (instr >> 26) & 0x3F;   // RV64 shifts take a 6-bit shamt
+    switch (instr & 0x7F) {
+        case 0x33: // ADD..AND, SUB / SRA and M
+            if (funct7 == 0x00 || funct7 == 0x01 || (funct7 == 0x20 && (funct3 == 0x0 || funct3 == 0x5))) {
+                return UNIT_BASE;
+            }
+            break;
+        case 0x13: // Only the shifts encode a funct6
+            if ((funct3 != 0x1 && funct3 != 0x5) || funct6 == 0x00 || (funct3 == 0x5 && funct6 == 0x10)) {
+                return UNIT_BASE;
+            }
+            break;
+        case 0x3B: // ADDW, SUBW, SLLW, SRLW, SRAW and the M word ops
+            if ((funct7 == 0x00 && (funct3 == 0x0 || funct3 == 0x1 || funct3 == 0x5))
+                || (funct7 == 0x20 && (funct3 == 0x0 || funct3 == 0x5))
+                || (funct7 == 0x01 && (funct3 == 0x0 || funct3 >= 0x4))) {
+                return UNIT_BASE;
+            }
+            break;
+        case 0x1B: // ADDIW, SLLIW, SRLIW, SRAIW
+            if (funct3 == 0x0 || (funct3 == 0x1 && funct7 == 0x00)
+                || (funct3 == 0x5 && (funct7 == 0x00 || funct7 == 0x20))) {
+                return UNIT_BASE;
+            }
+            break;
+        case 0x03:
+            return funct3 != 0x7 ? UNIT_BASE : UNIT_ILLEGAL;
+        case 0x23:
+            return funct3 <= 0x3 ? UNIT_BASE : UNIT_ILLEGAL;
+        case 0x63:
+            return (funct3 != 0x2 && funct3 != 0x3) ? UNIT_BASE : UNIT_ILLEGAL;
+        case 0x67: case 0x6F: case 0x37: case 0x17: case 0x0F: case 0x73:
+            return UNIT_BASE;
+        case 0x0B: case 0x2B: case 0x5B: case 0x7B: // custom-0..3
+            return CustomInstructions::active() && CustomInstructions::getInstance()->lookup(instr) != nullptr
+                   ? UNIT_CUSTOM : UNIT_ILLEGAL;
+        default:
+            return UNIT_ILLEGAL;
+    }
+
+    b_inst->setInstr(instr);
+    const op_B_Codes b_op = b_inst->decode();
+    if (b_op != OP_B_ERROR) {
+        ext_op = static_cast<uint8_t>(b_op);
+        return UNIT_BITMANIP;
+    }
+    k_inst->setInstr(instr);
+    const op_K_Codes k_op = k_inst->decode();
+    if (k_op != OP_K_ERROR) {
+        ext_op = static_cast<uint8_t>(k_op);
+        return UNIT_CRYPTO;
+    }
+    return UNIT_ILLEGAL;
 }
 
 // =============================================================================
@@ -321,19 +405,49 @@ void CPURV64P6_Cycle::ID_stage() {
 
 void CPURV64P6_Cycle::Issue_stage() {
     // Reset control signals initially
-    stall_pcgen = false;
     stall_fetch = false;
     stall_issue = false;
+    for (auto& lane : issue_ex_next) lane.valid = false;
 
     // Check for Pipeline Flush
     if (flush_pipeline) {
-        issue_ex_next.valid = false;
+        uops.clear();
+        uop_next = 0;
         return;
     }
 
     // Check validity of input
-    if (!id_issue_reg.valid) {
-        issue_ex_next.valid = false;
+    const ID_Issue_Latch& older = id_issue_reg[0];
+    const ID_Issue_Latch& younger = id_issue_reg[1];
+    if (!older.valid) {
+        return;
+    }
+
+    // A custom or multi-cycle instruction holds EX for its latency; nothing is dispatched behind it until then.
+    if (ex_hold > 0) {
+        stall_issue = true;
+        stall_fetch = true;
+        id_issue_next = id_issue_reg;
+        stats.stalls++;
+        return;
+    }
+
+    // A Zcmp/Zcmt instruction is dispatched alone, one micro-op per cycle.
+    if (older.unit == UNIT_SEQUENCE) {
+        dispatch_sequence(older, younger);
+        return;
+    }
+
+    // A custom instruction reads and writes registers and memory from EX, so it waits until
+    // every older instruction has committed. Its unit is a structural hazard: it is dispatched
+    // no earlier than the occupancy of the previous instruction of the same registration allows.
+    if (older.unit == UNIT_CUSTOM
+        && (!rob.is_empty()
+            || CustomInstructions::getInstance()->readyAt(*custom_ctx, older.instr) > stats.cycles + 1)) {
+        stall_issue = true;
+        stall_fetch = true;
+        id_issue_next = id_issue_reg;
+        stats.stalls++;
         return;
     }
 
@@ -341,11 +455,10 @@ void CPURV64P6_Cycle::Issue_stage() {
     // Check if the source registers (rs1, rs2) are marked in the scoreboard.
     // If they are, it means there is a pending write to these registers from an older instruction
     // that has not yet committed. We must stall to avoid a Read-After-Write (RAW) hazard.
-    if (scoreboard[id_issue_reg.rs1] || scoreboard[id_issue_reg.rs2]) {
+    if (scoreboard[older.rs1] || scoreboard[older.rs2]) {
         stall_issue = true;
         stall_fetch = true;
-        stall_pcgen = true; // Backpressure all the way to PCGen
-        issue_ex_next.valid = false;
+        id_issue_next = id_issue_reg;
         stats.stalls++; // Increment stall counter
         return;
     }
@@ -359,121 +472,381 @@ void CPURV64P6_Cycle::Issue_stage() {
         // ROB is Full: We must stall until slots become available.
         stall_issue = true;
         stall_fetch = true;
-        stall_pcgen = true;
-        issue_ex_next.valid = false;
+        id_issue_next = id_issue_reg;
         stats.stalls++; 
         return;
     }
 
+    // --- Pairing ---
+    // The younger instruction is dispatched in the same cycle if the pairing rules allow it,
+    // none of its sources is pending and it gets a ROB entry as well. The scoreboard is
+    // checked before the older one marks its destination.
+    IssueOp older_op = IssueOp::fromDecode(older.opcode, older.funct3, older.funct7, older.rd, older.rs1, older.rs2);
+    IssueOp younger_op;
+    PairBlock pairing = PAIR_NO_SECOND;
+    int younger_rob_idx = -1;
+    if (younger.valid) {
+        younger_op = IssueOp::fromDecode(younger.opcode, younger.funct3, younger.funct7, younger.rd, younger.rs1, younger.rs2);
+        const bool alone = older.unit == UNIT_CUSTOM || younger.unit == UNIT_CUSTOM
+                           || younger.unit == UNIT_SEQUENCE;
+        pairing = alone ? PAIR_SYSTEM : rules.check(older_op, younger_op);
+        if (pairing == PAIR_OK && (scoreboard[younger.rs1] || scoreboard[younger.rs2])) {
+            pairing = PAIR_HAZARD;
+        }
+        if (pairing == PAIR_OK && (younger_rob_idx = rob.allocate()) < 0) {
+            pairing = PAIR_RESOURCE;
+        }
+    }
+    if (rules.width > 1) {
+        pair_stats.record(older_op.cls, younger_op.cls, pairing);
+    }
+
+    dispatch(older, issue_ex_next[0], rob_idx);
+
+    if (pairing == PAIR_OK) {
+        dispatch(younger, issue_ex_next[1], younger_rob_idx);
+    } else if (younger.valid) {
+        // The younger instruction moves to lane 0 and is dispatched on its own next cycle;
+        // Fetch and ID hold until it has left.
+        id_issue_next[0] = younger;
+        id_issue_next[1].valid = false;
+        stall_issue = true;
+        stall_fetch = true;
+    }
+}
+
+void CPURV64P6_Cycle::dispatch(const ID_Issue_Latch& in, Issue_EX_Latch& out, int rob_idx) {
     // --- ROB Setup ---
     // Record instruction metadata in the allocated ROB entry.
-    rob[rob_idx].pc = id_issue_reg.pc;
-    rob[rob_idx].is_store = (id_issue_reg.opcode == 0x23);
-    rob[rob_idx].is_branch = (id_issue_reg.opcode == 0x63 || id_issue_reg.opcode == 0x6F || id_issue_reg.opcode == 0x67);
+    rob[rob_idx].pc = in.pc;
+    rob[rob_idx].is_store = (in.opcode == 0x23);
+    rob[rob_idx].is_branch = (in.opcode == 0x63 || in.opcode == 0x6F || in.opcode == 0x67);
+    rob[rob_idx].retire = in.retire;
+    rob[rob_idx].encoding = in.encoding;
+    rob[rob_idx].mem_size = 0;
 
     // --- Dispatch & Operand Read ---
     // Read operands from the register file (since we passed the scoreboard check, we know they are valid).
-    issue_ex_next.pc = id_issue_reg.pc;
-    issue_ex_next.rs1_val = register_bank->getValue(id_issue_reg.rs1);
-    issue_ex_next.rs2_val = register_bank->getValue(id_issue_reg.rs2);
-    issue_ex_next.imm = id_issue_reg.imm;
-    issue_ex_next.rd = id_issue_reg.rd;
-    issue_ex_next.opcode = id_issue_reg.opcode;
-    issue_ex_next.funct3 = id_issue_reg.funct3;
-    issue_ex_next.funct7 = id_issue_reg.funct7;
-    issue_ex_next.rob_index = rob_idx; // Tag the instruction with its ROB index
-    issue_ex_next.valid = true;
+    out.pc = in.pc;
+    out.instr = in.instr;
+    out.rs1_val = in.rs1 == UOP_TMP ? uop_tmp : register_bank->getValue(in.rs1);
+    out.rs2_val = register_bank->getValue(in.rs2);
+    out.imm = in.imm;
+    out.rd = in.rd;
+    out.opcode = in.opcode;
+    out.funct3 = in.funct3;
+    out.funct7 = in.funct7;
+    out.length = in.length;
+    out.unit = in.unit;
+    out.ext_op = in.ext_op;
+    out.rob_index = rob_idx; // Tag the instruction with its ROB index
+    out.valid = true;
 
     // --- Scoreboard Update ---
     // Mark the destination register as pending.
-    if (id_issue_reg.rd != 0) {
-        scoreboard[id_issue_reg.rd] = true;
+    if (in.rd != 0) {
+        scoreboard[in.rd] = true;
     }
 }
 
+// Zcmp push/pop and Zcmt table jumps move one register or table entry per load/store
+// micro-op, so they hold the LSU for as many cycles: Issue keeps the instruction and
+// stalls the front end while it dispatches them in order, each with its own ROB entry
+// once its sources are ready.
+void CPURV64P6_Cycle::dispatch_sequence(const ID_Issue_Latch& in, const ID_Issue_Latch& younger) {
+    if (uops.empty()) {
+        crack(in);
+    }
+
+    const ID_Issue_Latch& uop = uops[uop_next];
+    int rob_idx = -1;
+    if (scoreboard[uop.rs1] || scoreboard[uop.rs2] || (rob_idx = rob.allocate()) < 0) {
+        stall_issue = true;
+        stall_fetch = true;
+        id_issue_next = id_issue_reg;
+        stats.stalls++;
+        return;
+    }
+    dispatch(uop, issue_ex_next[0], rob_idx);
+
+    if (++uop_next < uops.size()) {
+        stall_issue = true;
+        stall_fetch = true;
+        id_issue_next = id_issue_reg;
+        return;
+    }
+    uops.clear();
+    uop_next = 0;
+
+    if (younger.valid) {
+        // The younger instruction moves to lane 0 and is dispatched next cycle.
+        id_issue_next[0] = younger;
+        id_issue_next[1].valid = false;
+        stall_issue = true;
+        stall_fetch = true;
+    }
+}
+
+// Micro-ops of a Zcmp/Zcmt instruction, decoded like any other instruction at its PC.
+// cm.jt / cm.jalt load the jvt entry into UOP_TMP and jump through it.
+void CPURV64P6_Cycle::crack(const ID_Issue_Latch& in) {
+    const auto parcel = static_cast<uint16_t>(in.instr);
+    ID_Issue_Latch uop;
+
+    uint32_t words[FetchUnit::MAX_MICRO_OPS];
+    const unsigned int n = FetchUnit::crack(parcel, true, words);
+    for (unsigned int k = 0; k < n; k++) {
+        decode(Fetch_ID_Latch{in.pc, words[k], 2, in.encoding, true}, uop);
+        uops.push_back(uop);
+    }
+
+    const int index = FetchUnit::tableJumpIndex(parcel);
+    if (index >= 0) {
+        uop = in;
+        uop.unit = UNIT_BASE;
+        uop.opcode = 0x03;
+        uop.funct3 = 0x3;
+        uop.rd = UOP_TMP;
+        uop.rs1 = uop.rs2 = 0;
+        uop.imm = static_cast<int64_t>((register_bank->getCSR(CSR_JVT) & ~static_cast<uint64_t>(63))
+                                       + static_cast<uint64_t>(index) * 8);
+        uops.push_back(uop);
+        uop.opcode = 0x67;
+        uop.funct3 = 0;
+        uop.rd = index >= 32 ? 1 : 0;
+        uop.rs1 = UOP_TMP;
+        uop.imm = 0;
+        uops.push_back(uop);
+    }
+
+    if (uops.empty()) {
+        // Reserved encoding: EX stops on it like on any other unimplemented instruction.
+        uop = in;
+        uop.unit = UNIT_ILLEGAL;
+        uops.push_back(uop);
+    }
+    for (auto& u : uops) u.retire = false;
+    uops.back().retire = true;
+}
+
 // =============================================================================
 // EX Stage (Execute & Memory Access)
 // =============================================================================
 
 void CPURV64P6_Cycle::EX_stage() {
+    RVVP_PROFILE_SCOPE(Execute);
     // Note: The EX stage in this model does NOT latch to a "next" stage like EX->MEM. 
     // Instead, it completes execution and writes the result directly to the ROB (for registers) 
     // or the Store Buffer (for memory stores).
-    
-    if (!issue_ex_reg.valid) {
+    if (ex_hold > 0) ex_hold--;
+    for (const auto& lane : issue_ex_reg) {
+        execute(lane);
+    }
+}
+
+void CPURV64P6_Cycle::execute(const Issue_EX_Latch& in) {
+    if (!in.valid) {
         return;
     }
 
     uint64_t result = 0;
     bool branch_taken = false;
     uint64_t branch_target = 0;
+
+    if (in.unit == UNIT_ILLEGAL) {
+        // Not implemented by this model: stop instead of executing it as something else.
+        std::cout << "[Sim] Error: Illegal instruction 0x" << std::hex << in.instr << " at PC=" << in.pc << std::dec
+                  << " (not implemented by the 6-stage model). Stopping." << std::endl;
+        sc_core::sc_stop();
+        return;
+    }
+
+    if (in.unit == UNIT_CUSTOM) {
+        // Registered custom instruction: its semantic reads and writes the hart directly.
+        auto custom = execCustom(in.instr, in.pc, stats.cycles);
+        if (custom == CustomInstructions::Result::Illegal) {
+            std::cout << "[Sim] Error: Custom instruction 0x" << std::hex << in.instr << " at PC=" << in.pc << std::dec
+                      << " rejected its encoding. Stopping." << std::endl;
+            sc_core::sc_stop();
+            return;
+        }
+        if (custom == CustomInstructions::Result::Jump) {
+            branch_target = register_bank->getPC();
+            branch_taken = true;
+        }
+        ex_hold = ex_cycles - 1;
+    }
+    if (in.unit == UNIT_BITMANIP || in.unit == UNIT_CRYPTO) {
+        // A multi-cycle Zb* / Zk* operation holds EX; a paired instruction may already hold it longer.
+        ex_hold = std::max(ex_hold, extension_latency(in.unit, in.ext_op) - 1);
+    }
     
     // 1. Execute ALU Operations
-    switch (issue_ex_reg.opcode) {
+    switch (in.opcode) {
         case 0x33: // R-type (Register-Register)
-            switch (issue_ex_reg.funct3) {
+            if (in.unit != UNIT_BASE) { // Zb* / Zk* (ALU pipe, clmul* on the MUL pipe)
+                result = extension_result(in);
+                break;
+            }
+            if (in.funct7 == 0x01) { // M extension (MUL pipe)
+                const int64_t a = static_cast<int64_t>(in.rs1_val);
+                const int64_t b = static_cast<int64_t>(in.rs2_val);
+                switch (in.funct3) {
+                    case 0x0: result = in.rs1_val * in.rs2_val; break; // MUL
+                    case 0x1: { // MULH
+                        sc_dt::sc_bigint<128> product = sc_dt::sc_bigint<128>(a) * sc_dt::sc_bigint<128>(b);
+                        result = product.range(127, 64).to_int64();
+                        break;
+                    }
+                    case 0x2: { // MULHSU
+                        sc_dt::sc_bigint<128> product = sc_dt::sc_bigint<128>(a) * sc_dt::sc_bigint<128>(in.rs2_val);
+                        result = product.range(127, 64).to_int64();
+                        break;
+                    }
+                    case 0x3: { // MULHU
+                        sc_dt::sc_bigint<128> product = sc_dt::sc_bigint<128>(in.rs1_val) * sc_dt::sc_bigint<128>(in.rs2_val);
+                        result = product.range(127, 64).to_uint64();
+                        break;
+                    }
+                    case 0x4: // DIV (divide by zero gives -1, overflow gives the dividend)
+                        if (b == 0) result = UINT64_MAX;
+                        else if (a == INT64_MIN && b == -1) result = in.rs1_val;
+                        else result = static_cast<uint64_t>(a / b);
+                        break;
+                    case 0x5: result = (in.rs2_val == 0) ? UINT64_MAX : in.rs1_val / in.rs2_val; break; // DIVU
+                    case 0x6: // REM (remainder by zero gives the dividend, overflow gives 0)
+                        if (b == 0) result = in.rs1_val;
+                        else if (a == INT64_MIN && b == -1) result = 0;
+                        else result = static_cast<uint64_t>(a % b);
+                        break;
+                    case 0x7: result = (in.rs2_val == 0) ? in.rs1_val : in.rs1_val % in.rs2_val; break; // REMU
+                }
+                break;
+            }
+            switch (in.funct3) {
                 case 0x0: 
-                    if (issue_ex_reg.funct7 == 0x20) result = issue_ex_reg.rs1_val - issue_ex_reg.rs2_val;
-                    else result = issue_ex_reg.rs1_val + issue_ex_reg.rs2_val;
+                    if (in.funct7 == 0x20) result = in.rs1_val - in.rs2_val;
+                    else result = in.rs1_val + in.rs2_val;
                     break;
-                case 0x1: result = issue_ex_reg.rs1_val << (issue_ex_reg.rs2_val & 0x3F); break;
-                case 0x2: result = (static_cast<int64_t>(issue_ex_reg.rs1_val) < static_cast<int64_t>(issue_ex_reg.rs2_val)); break;
-                case 0x3: result = (issue_ex_reg.rs1_val < issue_ex_reg.rs2_val); break;
-                case 0x4: result = issue_ex_reg.rs1_val ^ issue_ex_reg.rs2_val; break;
+                case 0x1: result = in.rs1_val << (in.rs2_val & 0x3F); break;
+                case 0x2: result = (static_cast<int64_t>(in.rs1_val) < static_cast<int64_t>(in.rs2_val)); break;
+                case 0x3: result = (in.rs1_val < in.rs2_val); break;
+                case 0x4: result = in.rs1_val ^ in.rs2_val; break;
                 case 0x5: 
-                    if (issue_ex_reg.funct7 == 0x20) result = static_cast<int64_t>(issue_ex_reg.rs1_val) >> (issue_ex_reg.rs2_val & 0x3F);
-                    else result = issue_ex_reg.rs1_val >> (issue_ex_reg.rs2_val & 0x3F);
+                    if (in.funct7 == 0x20) result = static_cast<int64_t>(in.rs1_val) >> (in.rs2_val & 0x3F);
+                    else result = in.rs1_val >> (in.rs2_val & 0x3F);
                     break;
-                case 0x6: result = issue_ex_reg.rs1_val | issue_ex_reg.rs2_val; break;
-                case 0x7: result = issue_ex_reg.rs1_val & issue_ex_reg.rs2_val; break;
+                case 0x6: result = in.rs1_val | in.rs2_val; break;
+                case 0x7: result = in.rs1_val & in.rs2_val; break;
             }
             break;
         case 0x13: // I-type ALU (Immediate-Register)
-             switch (issue_ex_reg.funct3) {
-                case 0x0: result = issue_ex_reg.rs1_val + issue_ex_reg.imm; break; 
-                case 0x2: result = (static_cast<int64_t>(issue_ex_reg.rs1_val) < issue_ex_reg.imm); break; 
-                case 0x3: result = (issue_ex_reg.rs1_val < static_cast<uint64_t>(issue_ex_reg.imm)); break; 
-                case 0x4: result = issue_ex_reg.rs1_val ^ issue_ex_reg.imm; break; 
-                case 0x6: result = issue_ex_reg.rs1_val | issue_ex_reg.imm; break; 
-                case 0x7: result = issue_ex_reg.rs1_val & issue_ex_reg.imm; break; 
-                case 0x1: result = issue_ex_reg.rs1_val << (issue_ex_reg.imm & 0x3F); break; 
+            if (in.unit != UNIT_BASE) { // Zb* / Zk* (ALU pipe)
+                result = extension_result(in);
+                break;
+            }
+             switch (in.funct3) {
+                case 0x0: result = in.rs1_val + in.imm; break; 
+                case 0x2: result = (static_cast<int64_t>(in.rs1_val) < in.imm); break; 
+                case 0x3: result = (in.rs1_val < static_cast<uint64_t>(in.imm)); break; 
+                case 0x4: result = in.rs1_val ^ in.imm; break; 
+                case 0x6: result = in.rs1_val | in.imm; break; 
+                case 0x7: result = in.rs1_val & in.imm; break; 
+                case 0x1: result = in.rs1_val << (in.imm & 0x3F); break; 
                 case 0x5: 
-                    if ((issue_ex_reg.imm & 0x400) != 0) result = static_cast<int64_t>(issue_ex_reg.rs1_val) >> (issue_ex_reg.imm & 0x3F);
-                    else result = issue_ex_reg.rs1_val >> (issue_ex_reg.imm & 0x3F);
+                    if ((in.imm & 0x400) != 0) result = static_cast<int64_t>(in.rs1_val) >> (in.imm & 0x3F);
+                    else result = in.rs1_val >> (in.imm & 0x3F);
+                    break;
+            }
+            break;
+        case 0x3B: { // R-type, 32-bit (results sign-extended from bit 31)
+            if (in.unit != UNIT_BASE) {
+                result = extension_result(in);
+                break;
+            }
+            const int32_t a = static_cast<int32_t>(in.rs1_val);
+            const int32_t b = static_cast<int32_t>(in.rs2_val);
+            const uint32_t ua = static_cast<uint32_t>(in.rs1_val);
+            const uint32_t ub = static_cast<uint32_t>(in.rs2_val);
+            int32_t word = 0;
+            if (in.funct7 == 0x01) { // MULW, DIVW, DIVUW, REMW, REMUW (MUL pipe)
+                switch (in.funct3) {
+                    case 0x0: word = static_cast<int32_t>(ua * ub); break;
+                    case 0x4:
+                        if (b == 0) word = -1;
+                        else if (a == INT32_MIN && b == -1) word = a;
+                        else word = a / b;
+                        break;
+                    case 0x5: word = static_cast<int32_t>(ub == 0 ? UINT32_MAX : ua / ub); break;
+                    case 0x6:
+                        if (b == 0) word = a;
+                        else if (a == INT32_MIN && b == -1) word = 0;
+                        else word = a % b;
+                        break;
+                    case 0x7: word = static_cast<int32_t>(ub == 0 ? ua : ua % ub); break;
+                }
+            } else {
+                switch (in.funct3) {
+                    case 0x0: word = static_cast<int32_t>(in.funct7 == 0x20 ? ua - ub : ua + ub); break;
+                    case 0x1: word = static_cast<int32_t>(ua << (ub & 0x1F)); break;
+                    case 0x5:
+                        if (in.funct7 == 0x20) word = a >> (ub & 0x1F);
+                        else word = static_cast<int32_t>(ua >> (ub & 0x1F));
+                        break;
+                }
+            }
+            result = static_cast<int64_t>(word);
+            break;
+        }
+        case 0x1B: { // I-type, 32-bit (results sign-extended from bit 31)
+            if (in.unit != UNIT_BASE) {
+                result = extension_result(in);
+                break;
+            }
+            const uint32_t ua = static_cast<uint32_t>(in.rs1_val);
+            int32_t word = 0;
+            switch (in.funct3) {
+                case 0x0: word = static_cast<int32_t>(ua + static_cast<uint32_t>(in.imm)); break;
+                case 0x1: word = static_cast<int32_t>(ua << (in.imm & 0x1F)); break;
+                case 0x5:
+                    if ((in.imm & 0x400) != 0) word = static_cast<int32_t>(ua) >> (in.imm & 0x1F);
+                    else word = static_cast<int32_t>(ua >> (in.imm & 0x1F));
                     break;
             }
+            result = static_cast<int64_t>(word);
             break;
-        case 0x37: result = issue_ex_reg.imm; break; // LUI
-        case 0x17: result = issue_ex_reg.pc + issue_ex_reg.imm; break; // AUIPC
+        }
+        case 0x37: result = in.imm; break; // LUI
+        case 0x17: result = in.pc + in.imm; break; // AUIPC
         case 0x6F: // JAL
-            result = issue_ex_reg.pc + 4;
-            branch_target = issue_ex_reg.pc + issue_ex_reg.imm;
+            result = in.pc + in.length;
+            branch_target = in.pc + in.imm;
             branch_taken = true;
             break;
         case 0x67: // JALR
-            result = issue_ex_reg.pc + 4;
-            branch_target = (issue_ex_reg.rs1_val + issue_ex_reg.imm) & ~1;
+            result = in.pc + in.length;
+            branch_target = (in.rs1_val + in.imm) & ~1;
             branch_taken = true;
             break;
         case 0x63: // Branch
             stats.branches++; // Count Branch
-            branch_target = issue_ex_reg.pc + issue_ex_reg.imm;
-             switch (issue_ex_reg.funct3) {
-                case 0x0: branch_taken = (issue_ex_reg.rs1_val == issue_ex_reg.rs2_val); break;
-                case 0x1: branch_taken = (issue_ex_reg.rs1_val != issue_ex_reg.rs2_val); break;
-                case 0x4: branch_taken = (static_cast<int64_t>(issue_ex_reg.rs1_val) < static_cast<int64_t>(issue_ex_reg.rs2_val)); break;
-                case 0x5: branch_taken = (static_cast<int64_t>(issue_ex_reg.rs1_val) >= static_cast<int64_t>(issue_ex_reg.rs2_val)); break;
-                case 0x6: branch_taken = (issue_ex_reg.rs1_val < issue_ex_reg.rs2_val); break;
-                case 0x7: branch_taken = (issue_ex_reg.rs1_val >= issue_ex_reg.rs2_val); break;
+            branch_target = in.pc + in.imm;
+             switch (in.funct3) {
+                case 0x0: branch_taken = (in.rs1_val == in.rs2_val); break;
+                case 0x1: branch_taken = (in.rs1_val != in.rs2_val); break;
+                case 0x4: branch_taken = (static_cast<int64_t>(in.rs1_val) < static_cast<int64_t>(in.rs2_val)); break;
+                case 0x5: branch_taken = (static_cast<int64_t>(in.rs1_val) >= static_cast<int64_t>(in.rs2_val)); break;
+                case 0x6: branch_taken = (in.rs1_val < in.rs2_val); break;
+                case 0x7: branch_taken = (in.rs1_val >= in.rs2_val); break;
             }
             break;
     }
 
     // 2. Load/Store Execution (LSU)
     // Perform memory access synchronously.
-    if (issue_ex_reg.opcode == 0x03) { // Load
-        uint64_t addr = issue_ex_reg.rs1_val + issue_ex_reg.imm;
-        switch (issue_ex_reg.funct3) {
+    if (in.opcode == 0x03) { // Load
+        uint64_t addr = in.rs1_val + in.imm;
+        switch (in.funct3) {
             case 0x0: result = static_cast<int64_t>(static_cast<int8_t>(mem_intf->readDataMem(addr, 1))); break;
             case 0x1: result = static_cast<int64_t>(static_cast<int16_t>(mem_intf->readDataMem(addr, 2))); break;
             case 0x2: result = static_cast<int64_t>(static_cast<int32_t>(mem_intf->readDataMem(addr, 4))); break;
@@ -482,10 +855,14 @@ void CPURV64P6_Cycle::EX_stage() {
             case 0x5: result = mem_intf->readDataMem(addr, 2); break;
             case 0x6: result = mem_intf->readDataMem(addr, 4); break;
         }
-    } else if (issue_ex_reg.opcode == 0x23) { // Store
-        uint64_t addr = issue_ex_reg.rs1_val + issue_ex_reg.imm;
+        if (in.rob_index >= 0) {
+            rob[in.rob_index].mem_addr = addr;
+            rob[in.rob_index].mem_size = static_cast<uint8_t>(1u << (in.funct3 & 0x3));
+        }
+    } else if (in.opcode == 0x23) { // Store
+        uint64_t addr = in.rs1_val + in.imm;
         int size = 0;
-        switch (issue_ex_reg.funct3) {
+        switch (in.funct3) {
             case 0x0: size = 1; break;
             case 0x1: size = 2; break;
             case 0x2: size = 4; break;
@@ -493,7 +870,11 @@ void CPURV64P6_Cycle::EX_stage() {
         }
         // Instead of writing to memory immediately, add it to the Store Buffer.
         // It will be committed to memory in the Commit stage.
-        store_buffer.add_store(addr, issue_ex_reg.rs2_val, size, issue_ex_reg.rob_index);
+        store_buffer.add_store(addr, in.rs2_val, size, in.rob_index);
+        if (in.rob_index >= 0) {
+            rob[in.rob_index].mem_addr = addr;
+            rob[in.rob_index].mem_size = static_cast<uint8_t>(size);
+        }
     }
 
     // 3. Handle Branch Redirection
@@ -505,8 +886,8 @@ void CPURV64P6_Cycle::EX_stage() {
     }
     
     // 4. Handle System (ECALL)
-    if (issue_ex_reg.opcode == 0x73) {
-        if (issue_ex_reg.funct3 == 0 && issue_ex_reg.imm == 0) {
+    if (in.opcode == 0x73) {
+        if (in.funct3 == 0 && in.imm == 0) {
             uint64_t syscall_num = register_bank->getValue(17);
             if (syscall_num == 93) { // Exit
                  sc_core::sc_stop();
@@ -516,8 +897,50 @@ void CPURV64P6_Cycle::EX_stage() {
 
     // 5. Complete Instruction in ROB (State Update)
     // Mark the instruction as "complete" in the ROB, making it ready for retirement.
-    if (issue_ex_reg.rob_index >= 0) {
-        rob.complete(issue_ex_reg.rob_index, result, issue_ex_reg.rd);
+    if (in.rob_index >= 0) {
+        rob.complete(in.rob_index, result, in.rd);
+    }
+}
+
+// Zb* / Zk* operation decoded in ID, on the operands read at dispatch
+uint64_t CPURV64P6_Cycle::extension_result(const Issue_EX_Latch& in) {
+    uint64_t result = 0;
+    if (in.unit == UNIT_BITMANIP) {
+        b_inst->setInstr(in.instr);
+        b_inst->compute(static_cast<op_B_Codes>(in.ext_op), in.rs1_val, in.rs2_val, result);
+    } else {
+        k_inst->setInstr(in.instr);
+        k_inst->compute(static_cast<op_K_Codes>(in.ext_op), in.rs1_val, in.rs2_val, result);
+    }
+    return result;
+}
+
+// Cycles a Zb* / Zk* operation holds EX
+unsigned int CPURV64P6_Cycle::extension_latency(uint8_t unit, uint8_t ext_op) const {
+    if (unit == UNIT_BITMANIP) {
+        switch (static_cast<op_B_Codes>(ext_op)) {
+            case OP_B_CLMUL: case OP_B_CLMULH: case OP_B_CLMULR:
+                return latency.clmul_latency;
+            case OP_B_CLZ: case OP_B_CTZ: case OP_B_CPOP:
+            case OP_B_CLZW: case OP_B_CTZW: case OP_B_CPOPW:
+                return latency.bitcount_latency;
+            default:
+                return 1;
+        }
+    }
+    switch (static_cast<op_K_Codes>(ext_op)) {
+        case OP_K_SM4ED: case OP_K_SM4KS:
+            return latency.sm4_latency;
+        case OP_K_SHA256SIG0: case OP_K_SHA256SIG1: case OP_K_SHA256SUM0: case OP_K_SHA256SUM1:
+        case OP_K_SHA512SIG0: case OP_K_SHA512SIG1: case OP_K_SHA512SUM0: case OP_K_SHA512SUM1:
+        case OP_K_SHA512SIG0L: case OP_K_SHA512SIG0H: case OP_K_SHA512SIG1L: case OP_K_SHA512SIG1H:
+        case OP_K_SHA512SUM0R: case OP_K_SHA512SUM1R:
+        case OP_K_SM3P0: case OP_K_SM3P1:
+            return latency.hash_latency;
+        case OP_K_AES64KS2: // XOR of two words
+            return 1;
+        default:            // aes32* / aes64*
+            return latency.aes_latency;
     }
 }
 
@@ -526,8 +949,8 @@ void CPURV64P6_Cycle::EX_stage() {
 // =============================================================================
 
 void CPURV64P6_Cycle::Commit_stage() {
-    // Check if the ROB has a completed instruction at its head
-    if (rob.head_ready()) {
+    // Retire up to one instruction per issue lane, in order, while the ROB head is complete
+    for (unsigned int retired = 0; retired < rules.width && rob.head_ready(); retired++) {
         const ROBEntry& entry = rob.get_head();
         
         // 1. Commit Store Operations
@@ -545,18 +968,44 @@ void CPURV64P6_Cycle::Commit_stage() {
         // 2. Commit Register Results (Architectural Update)
         // Write the result to the register file and release the scoreboard lock.
         // This makes the result visible to new instructions (and clears the hazard).
-        if (entry.dest_reg != 0) {
+        if (entry.dest_reg == UOP_TMP) {
+            uop_tmp = entry.result;
+            scoreboard[UOP_TMP] = false;
+        } else if (entry.dest_reg != 0) {
             register_bank->setValue(entry.dest_reg, entry.result);
             scoreboard[entry.dest_reg] = false; // Release Lock
         }
+
+        // Plugins see the data accesses after the instruction that made them
+        if (entry.mem_size != 0 && PluginManager::active()) {
+            plugin_accesses.push_back({entry.mem_addr, entry.mem_size, entry.is_store});
+        }
+
+        // The micro-ops of a sequence retire as one instruction, with the last of them.
+        if (!entry.retire) {
+            rob.retire();
+            continue;
+        }
+
+        // 3. Plugin Hooks
+        // Plugins see committed instructions only, never wrong-path ones.
+        pluginInsnExec(entry.pc, entry.encoding);
+        reportPluginAccesses();
         
-        // 3. Update Performance Statistics
+        // 4. Update Performance Statistics
         stats.instructions++;
         if (perf) perf->instructionsInc();
 
-        // 4. Retire Instruction
+        // 5. Retire Instruction
         // Remove the instruction from the ROB/Pipeline.
+        const uint64_t pc = entry.pc;
         rob.retire();
+
+        // 6. Run Control
+        // A stop or pause condition ends the commit group: younger instructions stay in the ROB.
+        if (runControlRetire(register_bank, pc, stats.cycles)) {
+            break;
+        }
     }
 }
 
@@ -589,6 +1038,48 @@ void CPURV64P6_Cycle::printStats() const {
     std::cout << "  CPI:          " << std::fixed << std::setprecision(2) << stats.get_cpi() << "\n";
     std::cout << "  Stalls:       " << stats.stalls << "\n";
     std::cout << "  Branches:     " << stats.branches << "\n";
+    fetch_unit.printStats(std::cout);
+    if (rules.width > 1) pair_stats.print(std::cout);
+}
+
+void CPURV64P6_Cycle::visitLatches(LatchMap &map) {
+    // rob_index is bookkeeping of the model, not a latch
+    for (unsigned int lane = 0; lane < rules.width; lane++) {
+        const std::string n = "[" + std::to_string(lane) + "].";
+        auto &f = fetch_id_reg[lane];
+        map.add("fetch_id" + n + "pc", f.pc);
+        map.add("fetch_id" + n + "instr", f.instr);
+        map.add("fetch_id" + n + "length", f.length, 3);
+        map.add("fetch_id" + n + "valid", f.valid);
+        auto &d = id_issue_reg[lane];
+        map.add("id_issue" + n + "pc", d.pc);
+        map.add("id_issue" + n + "instr", d.instr);
+        map.add("id_issue" + n + "rd", d.rd, 5);
+        map.add("id_issue" + n + "rs1", d.rs1, 5);
+        map.add("id_issue" + n + "rs2", d.rs2, 5);
+        map.add("id_issue" + n + "imm", d.imm);
+        map.add("id_issue" + n + "opcode", d.opcode, 7);
+        map.add("id_issue" + n + "funct3", d.funct3, 3);
+        map.add("id_issue" + n + "funct7", d.funct7, 7);
+        map.add("id_issue" + n + "length", d.length, 3);
+        map.add("id_issue" + n + "unit", d.unit, 2);
+        map.add("id_issue" + n + "ext_op", d.ext_op);
+        map.add("id_issue" + n + "valid", d.valid);
+        auto &i = issue_ex_reg[lane];
+        map.add("issue_ex" + n + "pc", i.pc);
+        map.add("issue_ex" + n + "instr", i.instr);
+        map.add("issue_ex" + n + "rs1_val", i.rs1_val);
+        map.add("issue_ex" + n + "rs2_val", i.rs2_val);
+        map.add("issue_ex" + n + "imm", i.imm);
+        map.add("issue_ex" + n + "rd", i.rd, 5);
+        map.add("issue_ex" + n + "opcode", i.opcode, 7);
+        map.add("issue_ex" + n + "funct3", i.funct3, 3);
+        map.add("issue_ex" + n + "funct7", i.funct7, 7);
+        map.add("issue_ex" + n + "length", i.length, 3);
+        map.add("issue_ex" + n + "unit", i.unit, 2);
+        map.add("issue_ex" + n + "ext_op", i.ext_op);
+        map.add("issue_ex" + n + "valid", i.valid);
+    }
 }
 
 } // namespace riscv_tlm
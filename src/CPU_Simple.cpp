@@ -7,10 +7,29 @@
  * No pipeline timing - just functional execution.
  */
 #include "CPU_Simple.h"
+#include "SelfProfile.h"
 #include "spdlog/spdlog.h"
 
 namespace riscv_tlm {
 
+namespace {
+/* Everything CPU_step() and cpu_process_IRQ() read; the interrupt lines are inputs */
+template<typename T>
+struct SimpleHartState : HartState {
+    SimpleHartState(const Registers<T> &r, const PMP &p, typename V_extension<T>::State v,
+                    const std::unordered_set<std::uint32_t> &res, bool irq_down, std::uint32_t mirrored)
+        : regs(r), pmp(p), vector(std::move(v)), reservations(res),
+          irq_already_down(irq_down), ext_irq_mirrored(mirrored) {}
+
+    Registers<T> regs;
+    PMP pmp;
+    typename V_extension<T>::State vector;
+    std::unordered_set<std::uint32_t> reservations;
+    bool irq_already_down;
+    std::uint32_t ext_irq_mirrored;
+};
+}
+
 // =============================================================================
 // CPURV32Simple Implementation
 // =============================================================================
@@ -19,7 +38,18 @@ CPURV32Simple::CPURV32Simple(sc_core::sc_module_name const& name, BaseType PC, b
     : CPU(name, debug) {
 
     register_bank = new Registers<BaseType>();
+    registerPluginHart(register_bank);
     mem_intf = new MemoryInterface();
+    attachCustomInstructions(register_bank);
+
+    mmu = new MMU(mem_intf, sizeof(BaseType) == 8);
+    mem_intf->setMMU(mmu);
+    register_bank->attachMMU(mmu);
+
+    pmp = new PMP(sizeof(BaseType) == 8);
+    mem_intf->setPMP(pmp);
+    mmu->setPMP(pmp);
+    register_bank->attachPMP(pmp);
 
     register_bank->setPC(PC);
     register_bank->setValue(Registers<BaseType>::sp, (Memory::SIZE / 4) - 1);
@@ -31,6 +61,12 @@ CPURV32Simple::CPURV32Simple(sc_core::sc_module_name const& name, BaseType PC, b
     c_inst    = new C_extension<BaseType>(0, register_bank, mem_intf);
     m_inst    = new M_extension<BaseType>(0, register_bank, mem_intf);
     a_inst    = new A_extension<BaseType>(0, register_bank, mem_intf);
+    v_inst    = new V_extension<BaseType>(0, register_bank, mem_intf);
+    f_inst    = new F_extension<BaseType>(0, register_bank, mem_intf);
+    b_inst    = new B_extension<BaseType>(0, register_bank, mem_intf);
+    k_inst    = new K_extension<BaseType>(0, register_bank, mem_intf);
+    isa       = {base_inst, c_inst, m_inst, a_inst, v_inst, f_inst, b_inst, k_inst};
+    register_bank->setExtensions(isa.misa());
 
     trans.set_data_ptr(reinterpret_cast<unsigned char*>(&INSTR));
     trans.set_command(tlm::TLM_READ_COMMAND);
@@ -47,98 +83,194 @@ CPURV32Simple::CPURV32Simple(sc_core::sc_module_name const& name, BaseType PC, b
 CPURV32Simple::~CPURV32Simple() {
     delete register_bank;
     delete mem_intf;
+    delete mmu;
+    delete pmp;
     delete base_inst;
     delete c_inst;
     delete m_inst;
     delete a_inst;
+    delete v_inst;
+    delete f_inst;
+    delete b_inst;
+    delete k_inst;
     delete m_qk;
 }
 
 bool CPURV32Simple::CPU_step() {
     bool breakpoint = false;
 
+    if (aot != nullptr && runTranslated()) {
+        return breakpoint;
+    }
+
     // Fetch instruction
-    if (dmi_ptr_valid) {
-        std::memcpy(&INSTR, dmi_ptr + register_bank->getPC(), 4);
-    } else {
-        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
-        tlm::tlm_dmi dmi_data;
-        trans.set_address(register_bank->getPC());
-        trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
-        instr_bus->b_transport(trans, delay);
-
-        if (trans.is_response_error()) {
-            SC_REPORT_ERROR("CPURV32Simple", "Instruction fetch error");
+    const std::uint64_t pc = register_bank->getPC();
+    std::uint64_t fetch_addr = pc;
+    bool fetched = false;
+    try {
+        if (mmu->translates(AccessType::Fetch)) {
+            if (MMU::crossesPage(fetch_addr, 4)) {
+                INSTR = mmu->fetchAcrossPages(fetch_addr);
+                fetched = true;
+            } else {
+                fetch_addr = mmu->translate(fetch_addr, AccessType::Fetch);
+            }
+        }
+
+        bool pmp_checked = !fetched && pmp->checks(AccessType::Fetch);
+        if (pmp_checked) {
+            pmp->check(fetch_addr, 2, AccessType::Fetch, pc);
         }
-        if (trans.is_dmi_allowed()) {
-            dmi_ptr_valid = instr_bus->get_direct_mem_ptr(trans, dmi_data);
-            if (dmi_ptr_valid) {
-                dmi_ptr = dmi_data.get_dmi_ptr();
+
+        if (fetched) {
+            // already assembled (and checked) from both pages
+        } else if (dmi_ptr_valid) {
+            std::memcpy(&INSTR, dmi_ptr + fetch_addr, 4);
+        } else {
+            sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+            tlm::tlm_dmi dmi_data;
+            trans.set_address(fetch_addr);
+            trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+            instr_bus->b_transport(trans, delay);
+
+            if (trans.is_response_error()) {
+                SC_REPORT_ERROR("CPURV32Simple", "Instruction fetch error");
+            }
+            if (trans.is_dmi_allowed()) {
+                dmi_ptr_valid = instr_bus->get_direct_mem_ptr(trans, dmi_data);
+                if (dmi_ptr_valid) {
+                    dmi_ptr = dmi_data.get_dmi_ptr();
+                }
             }
         }
+
+        if (pmp_checked && (INSTR & 3) == 3) {
+            pmp->check(fetch_addr + 2, 2, AccessType::Fetch, pc + 2);
+        }
+    } catch (const MemoryFault &fault) {
+        base_inst->RaiseException(static_cast<Exception_cause>(fault.cause), 0, fault.vaddr);
+        sc_core::wait(corePeriod());
+        return breakpoint;
     }
 
     perf->codeMemoryRead();
     inst.setInstr(INSTR);
 
     // Decode and execute
-    base_inst->setInstr(INSTR);
-    auto deco = base_inst->decode();
-
-    if (deco != OP_ERROR) {
-        bool pc_changed = !base_inst->exec_instruction(inst, &breakpoint, deco);
-        if (!pc_changed) {
-            register_bank->incPC();
-        }
-    } else {
-        c_inst->setInstr(INSTR);
-        auto c_deco = c_inst->decode();
-
-        if (c_deco != OP_C_ERROR) {
-            bool pc_changed = !c_inst->exec_instruction(inst, &breakpoint, c_deco);
-            if (!pc_changed) {
-                register_bank->incPCby2();
+    try {
+        pluginInsnExec(register_bank->getPC(), INSTR);
+        auto custom = execCustom(INSTR, register_bank->getPC(), cycleNow());
+        if (custom != CustomInstructions::Result::NotCustom) {
+            if (custom == CustomInstructions::Result::Illegal) {
+                base_inst->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, INSTR);
+            } else if (custom == CustomInstructions::Result::Sequential) {
+                register_bank->incPC();
             }
         } else {
-            m_inst->setInstr(INSTR);
-            auto m_deco = m_inst->decode();
-
-            if (m_deco != OP_M_ERROR) {
-                bool pc_changed = !m_inst->exec_instruction(inst, m_deco);
-                if (!pc_changed) {
-                    register_bank->incPC();
-                }
-            } else {
-                a_inst->setInstr(INSTR);
-                auto a_deco = a_inst->decode();
-
-                if (a_deco != OP_A_ERROR) {
-                    bool pc_changed = !a_inst->exec_instruction(inst, a_deco);
-                    if (!pc_changed) {
-                        register_bank->incPC();
-                    }
+            auto step = dispatchExtensions(isa, inst, INSTR, &breakpoint);
+            ex_cycles = step.cycles;
+            if (!step.pc_changed) {
+                if (step.unit == ExtensionUnit::C) {
+                    register_bank->incPCby2();
                 } else {
-                    std::cout << "Extension not implemented yet" << std::endl;
-                    inst.dump();
-                    base_inst->NOP();
                     register_bank->incPC();
                 }
             }
         }
+    } catch (const MemoryFault &fault) {
+        /* the access threw before the instruction changed any state */
+        base_inst->RaiseException(static_cast<Exception_cause>(fault.cause), INSTR, fault.vaddr);
     }
 
     perf->instructionsInc();
+    runControlRetire(register_bank, pc, cycleNow());
 
-    // Simple timing: wait one cycle
-    sc_core::wait(sc_core::sc_time(10, sc_core::SC_NS));
+    // Simple timing: wait one cycle (custom and vector instructions: their latency)
+    sc_core::wait(corePeriod() * ex_cycles);
 
     return breakpoint;
 }
 
+bool CPURV32Simple::aotRegions(std::uint32_t pc, std::uint32_t sp) {
+    auto covers = [](const AotRegion &r, std::uint64_t addr) {
+        return r.host != nullptr && addr >= r.start && addr <= r.end;
+    };
+
+    if (aot_epoch != dmi_epoch) {
+        for (auto &r : aot_region) {
+            r = AotRegion();
+        }
+        aot_epoch = dmi_epoch;
+    }
+    if (!covers(aot_region[0], pc)) {
+        aot_region[0].host = mem_intf->getPhysicalDMIRegion(pc, aot_region[0].start, aot_region[0].end);
+        if (aot_region[0].host == nullptr) {
+            return false;
+        }
+    }
+    /* the stack may live in another hole between peripheral windows */
+    if (!covers(aot_region[0], sp) && !covers(aot_region[1], sp)) {
+        aot_region[1].host = mem_intf->getPhysicalDMIRegion(sp, aot_region[1].start, aot_region[1].end);
+    }
+    return true;
+}
+
+bool CPURV32Simple::runTranslated() {
+    if (!dmi_ptr_valid || PluginManager::active() || RunControl::armed() || RunControl::watchesWrites()
+        || ClockDomains::timedAccesses()
+        || mmu->translates(AccessType::Fetch) || mmu->translates(AccessType::Load)
+        || mmu->translates(AccessType::Store)
+        || pmp->checks(AccessType::Fetch) || pmp->checks(AccessType::Load) || pmp->checks(AccessType::Store)) {
+        return false;
+    }
+
+    const BaseType pc = register_bank->getPC();
+    rvvp_aot_block_fn block = aot->find(pc);
+    if (block == nullptr || !aotRegions(pc, register_bank->getValue(Registers<BaseType>::sp))) {
+        return false;
+    }
+
+    rvvp_aot_state_t state{};
+    state.x = register_bank->rawValues();
+    state.code = dmi_ptr;
+    state.code_size = Memory::SIZE;
+    for (unsigned int i = 0; i < RVVP_AOT_REGIONS; i++) {
+        const AotRegion &r = aot_region[i];
+        if (r.host != nullptr) {
+            state.mem[i] = r.host;
+            state.lo[i] = static_cast<std::uint32_t>(r.start);
+            state.span[i] = static_cast<std::uint32_t>(std::min<std::uint64_t>(r.end - r.start + 1, 0xFFFFFFFFu));
+        }
+    }
+    state.budget = AOT_QUANTUM;
+
+    /* follow indirect jumps here too, as long as they land on translated blocks */
+    do {
+        std::uint32_t before = state.retired;
+        block(&state);
+        if (state.retired == before) {
+            break;
+        }
+        block = state.retired < state.budget ? aot->find(state.pc) : nullptr;
+    } while (block != nullptr);
+
+    if (state.retired == 0) {
+        return false;
+    }
+    register_bank->setPC(state.pc);
+    perf->instructionsInc(state.retired, state.loads, state.stores);
+    sc_core::wait(corePeriod() * state.retired);
+    return true;
+}
+
 bool CPURV32Simple::cpu_process_IRQ() {
     BaseType csr_temp;
     bool ret_value = false;
 
+    if (takeCLICInterrupt(register_bank) || takeExternalInterrupt(register_bank)) {
+        return true;
+    }
+
     if (interrupt) {
         csr_temp = register_bank->getCSR(CSR_MSTATUS);
         if ((csr_temp & MSTATUS_MIE) == 0) {
@@ -153,6 +285,7 @@ bool CPURV32Simple::cpu_process_IRQ() {
             BaseType old_pc = register_bank->getPC();
             register_bank->setCSR(CSR_MEPC, old_pc);
             register_bank->setCSR(CSR_MCAUSE, 0x80000000);
+            register_bank->enterTrap(Machine);
             BaseType new_pc = register_bank->getCSR(CSR_MTVEC);
             register_bank->setPC(new_pc);
 
@@ -185,6 +318,22 @@ std::uint64_t CPURV32Simple::getEndDumpAddress() {
     return register_bank->getValue(Registers<std::uint32_t>::t1);
 }
 
+std::shared_ptr<const HartState> CPURV32Simple::saveHart() const {
+    return std::make_shared<SimpleHartState<BaseType>>(*register_bank, *pmp, v_inst->saveState(),
+                                                        a_inst->reservations(), irq_already_down,
+                                                        ext_irq_mirrored);
+}
+
+void CPURV32Simple::restoreHart(const HartState &state) {
+    const auto &saved = static_cast<const SimpleHartState<BaseType> &>(state);
+    *pmp = saved.pmp;
+    register_bank->restoreFrom(saved.regs);
+    v_inst->restoreState(saved.vector);
+    a_inst->setReservations(saved.reservations);
+    irq_already_down = saved.irq_already_down;
+    ext_irq_mirrored = saved.ext_irq_mirrored;
+}
+
 // =============================================================================
 // CPURV64Simple Implementation
 // =============================================================================
@@ -193,7 +342,18 @@ CPURV64Simple::CPURV64Simple(sc_core::sc_module_name const& name, BaseType PC, b
     : CPU(name, debug) {
 
     register_bank = new Registers<BaseType>();
+    registerPluginHart(register_bank);
     mem_intf = new MemoryInterface();
+    attachCustomInstructions(register_bank);
+
+    mmu = new MMU(mem_intf, sizeof(BaseType) == 8);
+    mem_intf->setMMU(mmu);
+    register_bank->attachMMU(mmu);
+
+    pmp = new PMP(sizeof(BaseType) == 8);
+    mem_intf->setPMP(pmp);
+    mmu->setPMP(pmp);
+    register_bank->attachPMP(pmp);
 
     register_bank->setPC(PC);
     register_bank->setValue(Registers<BaseType>::sp, (Memory::SIZE / 8) - 1);
@@ -205,6 +365,12 @@ CPURV64Simple::CPURV64Simple(sc_core::sc_module_name const& name, BaseType PC, b
     c_inst    = new C_extension<BaseType>(0, register_bank, mem_intf);
     m_inst    = new M_extension<BaseType>(0, register_bank, mem_intf);
     a_inst    = new A_extension<BaseType>(0, register_bank, mem_intf);
+    v_inst    = new V_extension<BaseType>(0, register_bank, mem_intf);
+    f_inst    = new F_extension<BaseType>(0, register_bank, mem_intf);
+    b_inst    = new B_extension<BaseType>(0, register_bank, mem_intf);
+    k_inst    = new K_extension<BaseType>(0, register_bank, mem_intf);
+    isa       = {base_inst, c_inst, m_inst, a_inst, v_inst, f_inst, b_inst, k_inst};
+    register_bank->setExtensions(isa.misa());
 
     trans.set_data_ptr(reinterpret_cast<unsigned char*>(&INSTR));
     trans.set_command(tlm::TLM_READ_COMMAND);
@@ -221,10 +387,16 @@ CPURV64Simple::CPURV64Simple(sc_core::sc_module_name const& name, BaseType PC, b
 CPURV64Simple::~CPURV64Simple() {
     delete register_bank;
     delete mem_intf;
+    delete mmu;
+    delete pmp;
     delete base_inst;
     delete c_inst;
     delete m_inst;
     delete a_inst;
+    delete v_inst;
+    delete f_inst;
+    delete b_inst;
+    delete k_inst;
     delete m_qk;
 }
 
@@ -232,79 +404,89 @@ bool CPURV64Simple::CPU_step() {
     bool breakpoint = false;
 
     // Fetch instruction
-    if (dmi_ptr_valid) {
-        std::memcpy(&INSTR, dmi_ptr + register_bank->getPC(), 4);
-    } else {
-        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
-        tlm::tlm_dmi dmi_data;
-        trans.set_address(register_bank->getPC());
-        trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
-        instr_bus->b_transport(trans, delay);
-
-        if (trans.is_response_error()) {
-            SC_REPORT_ERROR("CPURV64Simple", "Instruction fetch error");
+    const std::uint64_t pc = register_bank->getPC();
+    std::uint64_t fetch_addr = pc;
+    bool fetched = false;
+    try {
+        if (mmu->translates(AccessType::Fetch)) {
+            if (MMU::crossesPage(fetch_addr, 4)) {
+                INSTR = mmu->fetchAcrossPages(fetch_addr);
+                fetched = true;
+            } else {
+                fetch_addr = mmu->translate(fetch_addr, AccessType::Fetch);
+            }
+        }
+
+        bool pmp_checked = !fetched && pmp->checks(AccessType::Fetch);
+        if (pmp_checked) {
+            pmp->check(fetch_addr, 2, AccessType::Fetch, pc);
         }
-        if (trans.is_dmi_allowed()) {
-            dmi_ptr_valid = instr_bus->get_direct_mem_ptr(trans, dmi_data);
-            if (dmi_ptr_valid) {
-                dmi_ptr = dmi_data.get_dmi_ptr();
+
+        if (fetched) {
+            // already assembled (and checked) from both pages
+        } else if (dmi_ptr_valid) {
+            std::memcpy(&INSTR, dmi_ptr + fetch_addr, 4);
+        } else {
+            sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+            tlm::tlm_dmi dmi_data;
+            trans.set_address(fetch_addr);
+            trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+            instr_bus->b_transport(trans, delay);
+
+            if (trans.is_response_error()) {
+                SC_REPORT_ERROR("CPURV64Simple", "Instruction fetch error");
+            }
+            if (trans.is_dmi_allowed()) {
+                dmi_ptr_valid = instr_bus->get_direct_mem_ptr(trans, dmi_data);
+                if (dmi_ptr_valid) {
+                    dmi_ptr = dmi_data.get_dmi_ptr();
+                }
             }
         }
+
+        if (pmp_checked && (INSTR & 3) == 3) {
+            pmp->check(fetch_addr + 2, 2, AccessType::Fetch, pc + 2);
+        }
+    } catch (const MemoryFault &fault) {
+        base_inst->RaiseException(static_cast<Exception_cause>(fault.cause), 0, fault.vaddr);
+        sc_core::wait(corePeriod());
+        return breakpoint;
     }
 
     perf->codeMemoryRead();
     inst.setInstr(INSTR);
 
     // Decode and execute
-    base_inst->setInstr(INSTR);
-    auto deco = base_inst->decode();
-
-    if (deco != OP_ERROR) {
-        bool pc_changed = !base_inst->exec_instruction(inst, &breakpoint, deco);
-        if (!pc_changed) {
-            register_bank->incPC();
-        }
-    } else {
-        c_inst->setInstr(INSTR);
-        auto c_deco = c_inst->decode();
-
-        if (c_deco != OP_C_ERROR) {
-            bool pc_changed = !c_inst->exec_instruction(inst, &breakpoint, c_deco);
-            if (!pc_changed) {
-                register_bank->incPCby2();
+    try {
+        pluginInsnExec(register_bank->getPC(), INSTR);
+        auto custom = execCustom(INSTR, register_bank->getPC(), cycleNow());
+        if (custom != CustomInstructions::Result::NotCustom) {
+            if (custom == CustomInstructions::Result::Illegal) {
+                base_inst->RaiseException(Exception_cause::ILLEGAL_INSTRUCTION, INSTR);
+            } else if (custom == CustomInstructions::Result::Sequential) {
+                register_bank->incPC();
             }
         } else {
-            m_inst->setInstr(INSTR);
-            auto m_deco = m_inst->decode();
-
-            if (m_deco != OP_M_ERROR) {
-                bool pc_changed = !m_inst->exec_instruction(inst, m_deco);
-                if (!pc_changed) {
-                    register_bank->incPC();
-                }
-            } else {
-                a_inst->setInstr(INSTR);
-                auto a_deco = a_inst->decode();
-
-                if (a_deco != OP_A_ERROR) {
-                    bool pc_changed = !a_inst->exec_instruction(inst, a_deco);
-                    if (!pc_changed) {
-                        register_bank->incPC();
-                    }
+            auto step = dispatchExtensions(isa, inst, INSTR, &breakpoint);
+            ex_cycles = step.cycles;
+            if (!step.pc_changed) {
+                if (step.unit == ExtensionUnit::C) {
+                    register_bank->incPCby2();
                 } else {
-                    std::cout << "Extension not implemented yet" << std::endl;
-                    inst.dump();
-                    base_inst->NOP();
                     register_bank->incPC();
                 }
             }
         }
+    } catch (const MemoryFault &fault) {
+        /* the access threw before the instruction changed any state */
+        base_inst->RaiseException(static_cast<Exception_cause>(fault.cause), INSTR, fault.vaddr);
     }
 
     perf->instructionsInc();
+    runControlRetire(register_bank, pc, cycleNow());
 
-    // Simple timing: wait one cycle
-    sc_core::wait(sc_core::sc_time(10, sc_core::SC_NS));
+    // Simple timing: wait one cycle (custom and vector instructions: their latency)
+    sc_core::wait(corePeriod() * ex_cycles);
 
     return breakpoint;
 }
@@ -313,6 +495,10 @@ bool CPURV64Simple::cpu_process_IRQ() {
     BaseType csr_temp;
     bool ret_value = false;
 
+    if (takeCLICInterrupt(register_bank) || takeExternalInterrupt(register_bank)) {
+        return true;
+    }
+
     if (interrupt) {
         csr_temp = register_bank->getCSR(CSR_MSTATUS);
         if ((csr_temp & MSTATUS_MIE) == 0) {
@@ -327,6 +513,7 @@ bool CPURV64Simple::cpu_process_IRQ() {
             BaseType old_pc = register_bank->getPC();
             register_bank->setCSR(CSR_MEPC, old_pc);
             register_bank->setCSR(CSR_MCAUSE, 0x80000000);
+            register_bank->enterTrap(Machine);
             BaseType new_pc = register_bank->getCSR(CSR_MTVEC);
             register_bank->setPC(new_pc);
 
@@ -359,4 +546,20 @@ std::uint64_t CPURV64Simple::getEndDumpAddress() {
     return register_bank->getValue(Registers<std::uint64_t>::t1);
 }
 
+std::shared_ptr<const HartState> CPURV64Simple::saveHart() const {
+    return std::make_shared<SimpleHartState<BaseType>>(*register_bank, *pmp, v_inst->saveState(),
+                                                        a_inst->reservations(), irq_already_down,
+                                                        ext_irq_mirrored);
+}
+
+void CPURV64Simple::restoreHart(const HartState &state) {
+    const auto &saved = static_cast<const SimpleHartState<BaseType> &>(state);
+    *pmp = saved.pmp;
+    register_bank->restoreFrom(saved.regs);
+    v_inst->restoreState(saved.vector);
+    a_inst->setReservations(saved.reservations);
+    irq_already_down = saved.irq_already_down;
+    ext_irq_mirrored = saved.ext_irq_mirrored;
+}
+
 } // namespace riscv_tlm
@@ -5,3 +5,8 @@
  \date August 2018
 */
 #include "C_extension.h"
+
+namespace riscv_tlm {
+
+    bool CodeSizeExtensions::s_active = false;
+}
@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file ClockDomains.cpp
+ * @brief Clock domains, their cycle counts and the --clocks parser
+ */
+
+#include "ClockDomains.h"
+
+#include <cctype>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace riscv_tlm {
+
+    bool ClockDomains::s_timed_accesses = false;
+
+    namespace {
+        const char *const domain_names[ClockDomains::DOMAINS] = {"core", "bus", "memory", "peripheral"};
+
+        constexpr double MAX_HZ = 1e12;     // a period of at least the 1 ps time resolution
+
+        sc_core::sc_time periodOf(double hz) {
+            return sc_core::sc_time(std::round(1e12 / hz), sc_core::SC_PS);
+        }
+    }
+
+    ClockDomain::ClockDomain(sc_core::sc_module_name const &name, double hz) :
+            sc_module(name), m_hz(hz), m_period(periodOf(hz)) {
+        SC_METHOD(tick);
+    }
+
+    double ClockDomain::elapsed(const sc_core::sc_time &now) const {
+        return std::floor((now - m_base_time) / m_period);
+    }
+
+    std::uint64_t ClockDomain::cycles() const {
+        return m_base_cycles + static_cast<std::uint64_t>(elapsed(sc_core::sc_time_stamp()));
+    }
+
+    void ClockDomain::tick() {
+        const sc_core::sc_time now = sc_core::sc_time_stamp();
+        if (now >= m_next_edge) {
+            m_posedge.notify();
+        }
+        m_next_edge = m_base_time + m_period * (elapsed(now) + 1);
+        next_trigger(m_next_edge - now, m_retimed);
+    }
+
+    bool ClockDomain::setFrequency(double hz) {
+        if (!(hz > 0) || hz > MAX_HZ) {
+            return false;
+        }
+        const sc_core::sc_time now = sc_core::sc_time_stamp();
+        m_residency[m_hz] += now - m_base_time;
+        m_base_cycles = cycles();
+        m_base_time = now;
+        m_hz = hz;
+        m_period = periodOf(hz);
+        m_transitions++;
+        m_retimed.notify();
+        return true;
+    }
+
+    void ClockDomain::setAccessCycles(std::uint32_t n) {
+        m_access_cycles = n;
+    }
+
+    std::map<double, sc_core::sc_time> ClockDomain::residency() const {
+        std::map<double, sc_core::sc_time> result = m_residency;
+        result[m_hz] += sc_core::sc_time_stamp() - m_base_time;
+        return result;
+    }
+
+    ClockDomains *ClockDomains::getInstance() {
+        static ClockDomains instance;
+        return &instance;
+    }
+
+    void ClockDomains::create() {
+        if (created()) {
+            return;
+        }
+        for (unsigned int i = 0; i < DOMAINS; i++) {
+            m_domains[i] = new ClockDomain((std::string("clock_") + domain_names[i]).c_str(), m_initial_hz[i]);
+            m_domains[i]->setAccessCycles(m_initial_access[i]);
+        }
+    }
+
+    bool ClockDomains::setFrequency(Id id, double hz) {
+        if (!created()) {
+            if (!(hz > 0) || hz > MAX_HZ) {
+                return false;
+            }
+            m_initial_hz[id] = hz;
+            return true;
+        }
+        if (id == PERIPHERAL) {
+            return false;       // the timebase of mtime runs at a fixed rate
+        }
+        return m_domains[id]->setFrequency(hz);
+    }
+
+    std::uint64_t ClockDomains::mtime() const {
+        const std::uint64_t ticks = created() ? m_domains[PERIPHERAL]->cycles()
+                : static_cast<std::uint64_t>(sc_core::sc_time_stamp() / periodOf(m_initial_hz[PERIPHERAL]));
+        return ticks + m_mtime_offset;
+    }
+
+    void ClockDomains::setMtime(std::uint64_t value) {
+        m_mtime_offset += value - mtime();
+    }
+
+    void ClockDomains::setAccessCycles(Id id, std::uint32_t n) {
+        if (created()) {
+            m_domains[id]->setAccessCycles(n);
+        } else {
+            m_initial_access[id] = n;
+        }
+        const auto access = [this](Id d) {
+            return created() ? m_domains[d]->accessCycles() : m_initial_access[d];
+        };
+        s_timed_accesses = access(BUS) != 0 || access(MEMORY) != 0;
+    }
+
+    const char *ClockDomains::name(Id id) {
+        return id < DOMAINS ? domain_names[id] : "?";
+    }
+
+    bool ClockDomains::parseFrequency(const std::string &text, double &hz) {
+        std::size_t used = 0;
+        try {
+            hz = std::stod(text, &used);
+        } catch (...) {
+            return false;
+        }
+        std::string unit = text.substr(used);
+        for (auto &c : unit) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        if (unit == "ghz") {
+            hz *= 1e9;
+        } else if (unit == "mhz") {
+            hz *= 1e6;
+        } else if (unit == "khz") {
+            hz *= 1e3;
+        } else if (!unit.empty() && unit != "hz") {
+            return false;
+        }
+        return hz > 0 && hz <= MAX_HZ;
+    }
+
+    bool ClockDomains::parse(const std::string &spec, std::string &error) {
+        std::stringstream items(spec);
+        std::string item;
+        while (std::getline(items, item, ',')) {
+            if (item.empty()) {
+                continue;
+            }
+            std::string::size_type eq = item.find('=');
+            if (eq == std::string::npos) {
+                error = "expected <domain>=<frequency>[:<access cycles>]: " + item;
+                return false;
+            }
+            const std::string key = item.substr(0, eq);
+            std::string value = item.substr(eq + 1);
+
+            unsigned int id = 0;
+            while (id < DOMAINS && key != domain_names[id]) {
+                id++;
+            }
+            if (id == DOMAINS) {
+                error = "unknown clock domain (core, bus, memory, peripheral): " + item;
+                return false;
+            }
+
+            std::string::size_type colon = value.find(':');
+            if (colon != std::string::npos) {
+                unsigned long n = 0;
+                try {
+                    std::size_t used = 0;
+                    n = std::stoul(value.substr(colon + 1), &used);
+                    if (used != value.size() - colon - 1) {
+                        throw std::invalid_argument(item);
+                    }
+                } catch (...) {
+                    error = "bad access cycles: " + item;
+                    return false;
+                }
+                setAccessCycles(static_cast<Id>(id), static_cast<std::uint32_t>(n));
+                value = value.substr(0, colon);
+            }
+
+            double hz = 0;
+            if (created() && id == PERIPHERAL) {
+                error = "the peripheral clock is fixed once the run starts: " + item;
+                return false;
+            }
+            if (!parseFrequency(value, hz) || !setFrequency(static_cast<Id>(id), hz)) {
+                error = "bad frequency (up to 1THz): " + item;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void ClockDomains::print(std::ostream &os) const {
+        if (!created()) {
+            return;
+        }
+        os << "Clock domains:\n";
+        for (unsigned int i = 0; i < DOMAINS; i++) {
+            const ClockDomain &d = *m_domains[i];
+            os << "  " << domain_names[i] << ": " << d.frequency() / 1e6 << " MHz, "
+               << d.cycles() << " cycles";
+            if (d.accessCycles() != 0) {
+                os << ", " << d.accessCycles() << " cycles per access";
+            }
+            os << "\n";
+            if (d.transitions() != 0) {
+                os << "    " << d.transitions() << " frequency changes, residency:";
+                for (const auto &r : d.residency()) {
+                    os << " " << r.first / 1e6 << " MHz " << r.second;
+                }
+                os << "\n";
+            }
+        }
+    }
+}
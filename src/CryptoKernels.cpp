@@ -0,0 +1,323 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file CryptoKernels.cpp
+ * @brief AES on AES-NI or T-tables, SM4 on tables
+ */
+
+#include "CryptoKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRYPTO_HOST_X86_64 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define CRYPTO_TARGET_AES
+#else
+#define CRYPTO_TARGET_AES __attribute__((target("aes,sse2")))
+#endif
+#else
+#define CRYPTO_HOST_X86_64 0
+#endif
+
+namespace riscv_tlm {
+
+namespace crypto {
+
+namespace {
+
+constexpr std::uint32_t rol32(std::uint32_t x, unsigned int n) {
+    return n == 0 ? x : (x << n) | (x >> (32 - n));
+}
+
+constexpr std::uint8_t xtime(std::uint8_t x) {
+    return static_cast<std::uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1B : 0));
+}
+
+constexpr std::uint8_t gfMul(std::uint8_t a, std::uint8_t b) {
+    std::uint8_t r = 0;
+    for (; b != 0; b >>= 1) {
+        if (b & 1) {
+            r ^= a;
+        }
+        a = xtime(a);
+    }
+    return r;
+}
+
+/** one (Inv)MixColumns column for a single input byte in row 0 */
+constexpr std::uint32_t mixColumn(std::uint8_t x, std::uint8_t m0, std::uint8_t m1, std::uint8_t m2,
+                                  std::uint8_t m3) {
+    return gfMul(x, m0) | (gfMul(x, m1) << 8) | (gfMul(x, m2) << 16)
+           | (static_cast<std::uint32_t>(gfMul(x, m3)) << 24);
+}
+
+struct AesTables {
+    std::uint8_t fwd[256];      ///< S-box
+    std::uint8_t inv[256];      ///< inverse S-box
+    std::uint32_t te[256];      ///< MixColumns(S-box(x))
+    std::uint32_t td[256];      ///< InvMixColumns(InvS-box(x))
+    std::uint32_t im[256];      ///< InvMixColumns(x)
+};
+
+constexpr AesTables makeAesTables() {
+    AesTables t{};
+    for (unsigned int x = 0; x < 256; x++) {
+        /* multiplicative inverse as x^254, then the affine transform */
+        std::uint8_t inv = 0;
+        if (x != 0) {
+            std::uint8_t sq = static_cast<std::uint8_t>(x);
+            inv = 1;
+            for (unsigned int e = 254; e != 0; e >>= 1) {
+                if (e & 1) {
+                    inv = gfMul(inv, sq);
+                }
+                sq = gfMul(sq, sq);
+            }
+        }
+        unsigned int s = inv;
+        for (unsigned int i = 1; i <= 4; i++) {
+            s ^= static_cast<std::uint8_t>((inv << i) | (inv >> (8 - i)));
+        }
+        s ^= 0x63;
+        t.fwd[x] = static_cast<std::uint8_t>(s);
+        t.inv[s] = static_cast<std::uint8_t>(x);
+    }
+    for (unsigned int x = 0; x < 256; x++) {
+        t.te[x] = mixColumn(t.fwd[x], 2, 1, 1, 3);
+        t.td[x] = mixColumn(t.inv[x], 0xE, 0x9, 0xD, 0xB);
+        t.im[x] = mixColumn(static_cast<std::uint8_t>(x), 0xE, 0x9, 0xD, 0xB);
+    }
+    return t;
+}
+
+constexpr AesTables aes_tbl = makeAesTables();
+
+constexpr std::uint8_t AES_RCON[10] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36};
+
+constexpr std::uint8_t SM4_SBOX[256] = {
+    0xD6, 0x90, 0xE9, 0xFE, 0xCC, 0xE1, 0x3D, 0xB7, 0x16, 0xB6, 0x14, 0xC2, 0x28, 0xFB, 0x2C, 0x05,
+    0x2B, 0x67, 0x9A, 0x76, 0x2A, 0xBE, 0x04, 0xC3, 0xAA, 0x44, 0x13, 0x26, 0x49, 0x86, 0x06, 0x99,
+    0x9C, 0x42, 0x50, 0xF4, 0x91, 0xEF, 0x98, 0x7A, 0x33, 0x54, 0x0B, 0x43, 0xED, 0xCF, 0xAC, 0x62,
+    0xE4, 0xB3, 0x1C, 0xA9, 0xC9, 0x08, 0xE8, 0x95, 0x80, 0xDF, 0x94, 0xFA, 0x75, 0x8F, 0x3F, 0xA6,
+    0x47, 0x07, 0xA7, 0xFC, 0xF3, 0x73, 0x17, 0xBA, 0x83, 0x59, 0x3C, 0x19, 0xE6, 0x85, 0x4F, 0xA8,
+    0x68, 0x6B, 0x81, 0xB2, 0x71, 0x64, 0xDA, 0x8B, 0xF8, 0xEB, 0x0F, 0x4B, 0x70, 0x56, 0x9D, 0x35,
+    0x1E, 0x24, 0x0E, 0x5E, 0x63, 0x58, 0xD1, 0xA2, 0x25, 0x22, 0x7C, 0x3B, 0x01, 0x21, 0x78, 0x87,
+    0xD4, 0x00, 0x46, 0x57, 0x9F, 0xD3, 0x27, 0x52, 0x4C, 0x36, 0x02, 0xE7, 0xA0, 0xC4, 0xC8, 0x9E,
+    0xEA, 0xBF, 0x8A, 0xD2, 0x40, 0xC7, 0x38, 0xB5, 0xA3, 0xF7, 0xF2, 0xCE, 0xF9, 0x61, 0x15, 0xA1,
+    0xE0, 0xAE, 0x5D, 0xA4, 0x9B, 0x34, 0x1A, 0x55, 0xAD, 0x93, 0x32, 0x30, 0xF5, 0x8C, 0xB1, 0xE3,
+    0x1D, 0xF6, 0xE2, 0x2E, 0x82, 0x66, 0xCA, 0x60, 0xC0, 0x29, 0x23, 0xAB, 0x0D, 0x53, 0x4E, 0x6F,
+    0xD5, 0xDB, 0x37, 0x45, 0xDE, 0xFD, 0x8E, 0x2F, 0x03, 0xFF, 0x6A, 0x72, 0x6D, 0x6C, 0x5B, 0x51,
+    0x8D, 0x1B, 0xAF, 0x92, 0xBB, 0xDD, 0xBC, 0x7F, 0x11, 0xD9, 0x5C, 0x41, 0x1F, 0x10, 0x5A, 0xD8,
+    0x0A, 0xC1, 0x31, 0x88, 0xA5, 0xCD, 0x7B, 0xBD, 0x2D, 0x74, 0xD0, 0x12, 0xB8, 0xE5, 0xB4, 0xB0,
+    0x89, 0x69, 0x97, 0x4A, 0x0C, 0x96, 0x77, 0x7E, 0x65, 0xB9, 0xF1, 0x09, 0xC5, 0x6E, 0xC6, 0x84,
+    0x18, 0xF0, 0x7D, 0xEC, 0x3A, 0xDC, 0x4D, 0x20, 0x79, 0xEE, 0x5F, 0x3E, 0xD7, 0xCB, 0x39, 0x48,
+};
+
+struct Sm4Tables {
+    std::uint32_t ed[256];      ///< L(S-box(x))
+    std::uint32_t ks[256];      ///< L'(S-box(x))
+};
+
+constexpr Sm4Tables makeSm4Tables() {
+    Sm4Tables t{};
+    for (unsigned int x = 0; x < 256; x++) {
+        std::uint32_t s = SM4_SBOX[x];
+        t.ed[x] = s ^ rol32(s, 2) ^ rol32(s, 10) ^ rol32(s, 18) ^ rol32(s, 24);
+        t.ks[x] = s ^ rol32(s, 13) ^ rol32(s, 23);
+    }
+    return t;
+}
+
+constexpr Sm4Tables sm4_tbl = makeSm4Tables();
+
+std::uint64_t aes64Table(Aes64Op op, std::uint64_t rs1, std::uint64_t rs2) {
+    std::uint8_t in[16];
+    for (unsigned int i = 0; i < 8; i++) {
+        in[i] = static_cast<std::uint8_t>(rs1 >> (8 * i));
+        in[i + 8] = static_cast<std::uint8_t>(rs2 >> (8 * i));
+    }
+
+    bool decrypt = op == Aes64Op::Ds || op == Aes64Op::Dsm;
+    std::uint64_t result = 0;
+    for (unsigned int c = 0; c < 2; c++) {
+        std::uint32_t col = 0;
+        for (unsigned int r = 0; r < 4; r++) {
+            /* (Inv)ShiftRows: row r rotates left (right) by r columns */
+            std::uint8_t b = in[4 * ((decrypt ? c + 4 - r : c + r) & 3) + r];
+            switch (op) {
+                case Aes64Op::Es:
+                    col |= static_cast<std::uint32_t>(aes_tbl.fwd[b]) << (8 * r);
+                    break;
+                case Aes64Op::Esm:
+                    col ^= rol32(aes_tbl.te[b], 8 * r);
+                    break;
+                case Aes64Op::Ds:
+                    col |= static_cast<std::uint32_t>(aes_tbl.inv[b]) << (8 * r);
+                    break;
+                case Aes64Op::Dsm:
+                    col ^= rol32(aes_tbl.td[b], 8 * r);
+                    break;
+            }
+        }
+        result |= static_cast<std::uint64_t>(col) << (32 * c);
+    }
+    return result;
+}
+
+std::uint64_t aes64imTable(std::uint64_t rs1) {
+    std::uint64_t result = 0;
+    for (unsigned int c = 0; c < 2; c++) {
+        std::uint32_t col = 0;
+        for (unsigned int r = 0; r < 4; r++) {
+            col ^= rol32(aes_tbl.im[(rs1 >> (32 * c + 8 * r)) & 0xFF], 8 * r);
+        }
+        result |= static_cast<std::uint64_t>(col) << (32 * c);
+    }
+    return result;
+}
+
+std::uint64_t aes64ks1iTable(std::uint64_t rs1, unsigned int rnum) {
+    auto w = static_cast<std::uint32_t>(rs1 >> 32);
+    std::uint32_t rcon = 0;
+    if (rnum != 0xA) {
+        w = rol32(w, 24);
+        rcon = AES_RCON[rnum];
+    }
+    std::uint32_t sub = 0;
+    for (unsigned int i = 0; i < 4; i++) {
+        sub |= static_cast<std::uint32_t>(aes_tbl.fwd[(w >> (8 * i)) & 0xFF]) << (8 * i);
+    }
+    sub ^= rcon;
+    return (static_cast<std::uint64_t>(sub) << 32) | sub;
+}
+
+#if CRYPTO_HOST_X86_64
+CRYPTO_TARGET_AES
+std::uint64_t aes64Ni(Aes64Op op, std::uint64_t rs1, std::uint64_t rs2) {
+    __m128i state = _mm_set_epi64x(static_cast<long long>(rs2), static_cast<long long>(rs1));
+    __m128i zero = _mm_setzero_si128();
+    switch (op) {
+        case Aes64Op::Es:
+            state = _mm_aesenclast_si128(state, zero);
+            break;
+        case Aes64Op::Esm:
+            state = _mm_aesenc_si128(state, zero);
+            break;
+        case Aes64Op::Ds:
+            state = _mm_aesdeclast_si128(state, zero);
+            break;
+        case Aes64Op::Dsm:
+            state = _mm_aesdec_si128(state, zero);
+            break;
+    }
+    return static_cast<std::uint64_t>(_mm_cvtsi128_si64(state));
+}
+
+CRYPTO_TARGET_AES
+std::uint64_t aes64imNi(std::uint64_t rs1) {
+    __m128i col = _mm_aesimc_si128(_mm_cvtsi64_si128(static_cast<long long>(rs1)));
+    return static_cast<std::uint64_t>(_mm_cvtsi128_si64(col));
+}
+
+/* aeskeygenassist takes rcon as an immediate */
+template<int RCON>
+CRYPTO_TARGET_AES
+std::uint32_t keygenAssist(__m128i w) {
+    /* dword 1: RotWord(SubWord(X1)) ^ rcon */
+    return static_cast<std::uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(_mm_aeskeygenassist_si128(w, RCON), 4)));
+}
+
+CRYPTO_TARGET_AES
+std::uint64_t aes64ks1iNi(std::uint64_t rs1, unsigned int rnum) {
+    /* X1 = rs1[63:32] */
+    __m128i w = _mm_cvtsi64_si128(static_cast<long long>(rs1));
+    std::uint32_t sub;
+    switch (rnum) {
+        case 0: sub = keygenAssist<0x01>(w); break;
+        case 1: sub = keygenAssist<0x02>(w); break;
+        case 2: sub = keygenAssist<0x04>(w); break;
+        case 3: sub = keygenAssist<0x08>(w); break;
+        case 4: sub = keygenAssist<0x10>(w); break;
+        case 5: sub = keygenAssist<0x20>(w); break;
+        case 6: sub = keygenAssist<0x40>(w); break;
+        case 7: sub = keygenAssist<0x80>(w); break;
+        case 8: sub = keygenAssist<0x1B>(w); break;
+        case 9: sub = keygenAssist<0x36>(w); break;
+        default:
+            /* 0xA: dword 0 is SubWord(X1) without rotation or rcon */
+            sub = static_cast<std::uint32_t>(_mm_cvtsi128_si32(_mm_aeskeygenassist_si128(w, 0)));
+            break;
+    }
+    return (static_cast<std::uint64_t>(sub) << 32) | sub;
+}
+
+bool hostHasAesNi() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 25)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("aes");
+#endif
+}
+#else
+bool hostHasAesNi() {
+    return false;
+}
+#endif
+
+const bool aes_ni = hostHasAesNi();
+
+} // namespace
+
+std::uint64_t aes64(Aes64Op op, std::uint64_t rs1, std::uint64_t rs2) {
+#if CRYPTO_HOST_X86_64
+    if (aes_ni) {
+        return aes64Ni(op, rs1, rs2);
+    }
+#endif
+    return aes64Table(op, rs1, rs2);
+}
+
+std::uint64_t aes64im(std::uint64_t rs1) {
+#if CRYPTO_HOST_X86_64
+    if (aes_ni) {
+        return aes64imNi(rs1);
+    }
+#endif
+    return aes64imTable(rs1);
+}
+
+std::uint64_t aes64ks1i(std::uint64_t rs1, unsigned int rnum) {
+#if CRYPTO_HOST_X86_64
+    if (aes_ni) {
+        return aes64ks1iNi(rs1, rnum);
+    }
+#endif
+    return aes64ks1iTable(rs1, rnum);
+}
+
+std::uint32_t aes32(std::uint32_t rs1, std::uint32_t rs2, unsigned int bs, bool decrypt, bool mix) {
+    std::uint8_t b = static_cast<std::uint8_t>(rs2 >> (8 * bs));
+    std::uint32_t t;
+    if (mix) {
+        t = decrypt ? aes_tbl.td[b] : aes_tbl.te[b];
+    } else {
+        t = decrypt ? aes_tbl.inv[b] : aes_tbl.fwd[b];
+    }
+    return rol32(t, 8 * bs) ^ rs1;
+}
+
+std::uint32_t sm4(std::uint32_t rs1, std::uint32_t rs2, unsigned int bs, bool key_schedule) {
+    std::uint8_t b = static_cast<std::uint8_t>(rs2 >> (8 * bs));
+    return rol32(key_schedule ? sm4_tbl.ks[b] : sm4_tbl.ed[b], 8 * bs) ^ rs1;
+}
+
+bool aesIsNative() {
+    return aes_ni;
+}
+
+} // namespace crypto
+
+} // namespace riscv_tlm
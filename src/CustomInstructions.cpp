@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file CustomInstructions.cpp
+ * @brief Registry of user-defined instructions in the custom-0..3 opcode space
+ */
+
+#include "CustomInstructions.h"
+
+#include <iostream>
+
+#include "PluginAPI.h"
+
+namespace riscv_tlm {
+
+bool CustomInstructions::s_active = false;
+CustomInstructions *CustomInstructions::instance = nullptr;
+
+CustomInstructions *CustomInstructions::getInstance() {
+    if (instance == nullptr) {
+        instance = new CustomInstructions();
+    }
+    return instance;
+}
+
+int CustomInstructions::add(const std::string &name, std::uint32_t mask, std::uint32_t match,
+                            Semantic exec, Timing timing) {
+    if ((mask & 0x7F) != 0x7F || (match & ~mask) != 0 || !isCustomOpcode(match)) {
+        std::cerr << "CustomInstructions: " << name
+                  << " is not a custom-0..3 encoding (mask/match must cover opcode bits)\n";
+        return -1;
+    }
+    if (!exec) {
+        std::cerr << "CustomInstructions: " << name << " has no semantic function\n";
+        return -1;
+    }
+
+    /* Two encodings overlap if they agree on every bit both masks check */
+    for (auto const &e : table) {
+        if (((e.match ^ match) & e.mask & mask) == 0) {
+            std::cerr << "CustomInstructions: " << name << " overlaps " << e.name << "\n";
+            return -1;
+        }
+    }
+
+    if (timing.latency == 0) {
+        timing.latency = 1;
+    }
+    if (timing.occupancy == 0) {
+        timing.occupancy = 1;
+    }
+
+    int id = static_cast<int>(table.size());
+    table.push_back({name, mask, match, std::move(exec), timing});
+    by_slot[(match >> 5) & 0x3].push_back(id);
+    s_active = true;
+    return id;
+}
+
+const CustomInstructions::Entry *CustomInstructions::lookup(std::uint32_t insn) const {
+    if (!isCustomOpcode(insn)) {
+        return nullptr;
+    }
+    for (int id : by_slot[(insn >> 5) & 0x3]) {
+        const Entry &e = table[id];
+        if ((insn & e.mask) == e.match) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+CustomInstructions::Result CustomInstructions::execute(CustomInsnContext &ctx, std::uint32_t insn,
+                                                       std::uint64_t pc, std::uint64_t now,
+                                                       unsigned int &cycles) {
+    const Entry *e = lookup(insn);
+    if (e == nullptr) {
+        return Result::NotCustom;
+    }
+
+    auto id = static_cast<std::size_t>(e - table.data());
+    if (ctx.busy_until.size() < table.size()) {
+        ctx.busy_until.resize(table.size(), 0);
+    }
+
+    /* Structural stall while the unit is still busy with a previous issue */
+    unsigned int stall = 0;
+    if (ctx.busy_until[id] > now) {
+        stall = static_cast<unsigned int>(ctx.busy_until[id] - now);
+    }
+    ctx.busy_until[id] = now + stall + e->timing.occupancy;
+
+    ctx.cur_pc = pc;
+    ctx.jumped = false;
+    ctx.extra_cycles = 0;
+
+    if (!e->exec(ctx, insn)) {
+        cycles = 1;
+        return Result::Illegal;
+    }
+
+    cycles = stall + e->timing.latency + ctx.extra_cycles;
+    return ctx.jumped ? Result::Jump : Result::Sequential;
+}
+
+std::uint64_t CustomInstructions::readyAt(const CustomInsnContext &ctx, std::uint32_t insn) const {
+    const Entry *e = lookup(insn);
+    if (e == nullptr) {
+        return 0;
+    }
+    auto id = static_cast<std::size_t>(e - table.data());
+    return id < ctx.busy_until.size() ? ctx.busy_until[id] : 0;
+}
+
+} // namespace riscv_tlm
+
+/* --- C API for plugins ------------------------------------------------------ */
+
+using riscv_tlm::CustomInsnContext;
+using riscv_tlm::CustomInstructions;
+
+/* rvvp_custom_ctx is an opaque alias of the hart's CustomInsnContext */
+static inline CustomInsnContext *fromHandle(struct rvvp_custom_ctx *ctx) {
+    return reinterpret_cast<CustomInsnContext *>(ctx);
+}
+
+static inline const CustomInsnContext *fromHandle(const struct rvvp_custom_ctx *ctx) {
+    return reinterpret_cast<const CustomInsnContext *>(ctx);
+}
+
+extern "C" {
+
+int rvvp_plugin_register_custom_insn(const char *name, uint32_t mask, uint32_t match,
+                                     rvvp_custom_insn_fn_t fn, void *udata,
+                                     unsigned int latency, unsigned int occupancy) {
+    if (fn == nullptr) {
+        return -1;
+    }
+    CustomInstructions::Timing timing;
+    timing.latency = latency;
+    timing.occupancy = occupancy;
+    return CustomInstructions::getInstance()->add(
+            name != nullptr ? name : "plugin", mask, match,
+            [fn, udata](CustomInsnContext &ctx, std::uint32_t insn) {
+                return fn(reinterpret_cast<rvvp_custom_ctx *>(&ctx), insn, udata) == 0;
+            },
+            timing);
+}
+
+uint64_t rvvp_custom_read_reg(const struct rvvp_custom_ctx *ctx, unsigned int reg) {
+    return fromHandle(ctx)->readReg(reg);
+}
+
+void rvvp_custom_write_reg(struct rvvp_custom_ctx *ctx, unsigned int reg, uint64_t value) {
+    fromHandle(ctx)->writeReg(reg, value);
+}
+
+uint64_t rvvp_custom_load(struct rvvp_custom_ctx *ctx, uint64_t addr, unsigned int size) {
+    return fromHandle(ctx)->load(addr, size);
+}
+
+void rvvp_custom_store(struct rvvp_custom_ctx *ctx, uint64_t addr, uint64_t value, unsigned int size) {
+    fromHandle(ctx)->store(addr, value, size);
+}
+
+uint64_t rvvp_custom_pc(const struct rvvp_custom_ctx *ctx) {
+    return fromHandle(ctx)->pc();
+}
+
+void rvvp_custom_jump(struct rvvp_custom_ctx *ctx, uint64_t target) {
+    fromHandle(ctx)->jump(target);
+}
+
+void rvvp_custom_add_cycles(struct rvvp_custom_ctx *ctx, unsigned int cycles) {
+    fromHandle(ctx)->addCycles(cycles);
+}
+
+} // extern "C"
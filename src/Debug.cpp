@@ -1,38 +1,457 @@
 /*!
  \file Debug.cpp
- \brief GDB connector (stub for pipelined CPUs)
+ \brief GDB connector
  \author Màrius Montón
  \date February 2021
  */
 // SPDX-License-Identifier: GPL-3.0-or-later
 
-#include <cstdio>
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
-#include <sstream>
-#include <iomanip>
+#include <functional>
 #include <iostream>
+#include <vector>
+
+#ifndef _WIN32
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
 #include "Debug.h"
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 namespace riscv_tlm {
     constexpr char nibble_to_hex[16] = {'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
 
-    Debug::Debug(riscv_tlm::CPU *cpu, Memory *mem, cpu_types_t type) 
+    namespace {
+        bool startsWith(const std::string &msg, const char *prefix) {
+            return msg.compare(0, std::strlen(prefix), prefix) == 0;
+        }
+
+        /* registers and memory travel in target byte order: least significant byte first */
+        std::string toHex(const unsigned char *data, std::size_t len) {
+            std::string out;
+            out.reserve(len * 2);
+            for (std::size_t i = 0; i < len; i++) {
+                out += nibble_to_hex[data[i] >> 4];
+                out += nibble_to_hex[data[i] & 0xF];
+            }
+            return out;
+        }
+
+        std::string toHex(std::uint64_t value, unsigned int bytes) {
+            unsigned char data[8];
+            for (unsigned int i = 0; i < bytes; i++) {
+                data[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+            return toHex(data, bytes);
+        }
+
+        bool fromHex(const std::string &hex, std::vector<unsigned char> &data) {
+            if (hex.size() % 2 != 0) {
+                return false;
+            }
+            data.clear();
+            for (std::size_t i = 0; i < hex.size(); i += 2) {
+                char *end = nullptr;
+                const std::string byte = hex.substr(i, 2);
+                data.push_back(static_cast<unsigned char>(std::strtoul(byte.c_str(), &end, 16)));
+                if (*end != '\0') {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /* "addr,len" at the start of @p args; @p rest points after len */
+        bool parseRange(const char *args, std::uint64_t &addr, std::size_t &len, const char **rest = nullptr) {
+            char *end = nullptr;
+            addr = std::strtoull(args, &end, 16);
+            if (*end != ',') {
+                return false;
+            }
+            len = std::strtoul(end + 1, &end, 16);
+            if (rest != nullptr) {
+                *rest = end;
+            }
+            return true;
+        }
+    }
+
+    Debug::Debug(riscv_tlm::CPU *cpu, Memory *mem, cpu_types_t type, unsigned short port)
         : sc_module(sc_core::sc_module_name("Debug")) {
         dbg_cpu = cpu;
-        register_bank32 = nullptr;
-        register_bank64 = nullptr;
         dbg_mem = mem;
         cpu_type = type;
+        xlen_bytes = type == RV32 ? 4 : 8;
         conn = -1;
-        std::cout << "[Debug] GDB remote stub not fully supported for pipelined CPUs." << std::endl;
+
+        dbg_trans.set_byte_enable_ptr(nullptr);
+        dbg_trans.set_dmi_allowed(false);
+
+#ifndef _WIN32
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        int optval = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = INADDR_ANY;
+        addr.sin_port = htons(port);
+        if (sock < 0 || bind(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(sock, 1) < 0) {
+            SC_REPORT_ERROR("Debug", ("cannot listen on port " + std::to_string(port)).c_str());
+        }
+
+        std::cout << "[Debug] Waiting for GDB on port " << port << std::endl;
+        socklen_t len = sizeof(addr);
+        conn = accept(sock, reinterpret_cast<sockaddr *>(&addr), &len);
+        close(sock);
+#else
+        (void) port;
+        std::cout << "[Debug] GDB remote stub not supported on Windows." << std::endl;
+#endif
+
+        SC_THREAD(handle_gdb_loop);
+    }
+
+    Debug::~Debug() {
+#ifndef _WIN32
+        if (conn >= 0) {
+            close(conn);
+        }
+#endif
+    }
+
+    void Debug::enableReverse(std::uint64_t interval, std::size_t budget) {
+        reverse_interval = interval;
+        reverse_budget = budget;
+    }
+
+    void Debug::send_packet(int m_conn, const std::string &msg) {
+#ifndef _WIN32
+        std::string frame = "$" + msg + "#" + compute_checksum_string(msg);
+        ::send(m_conn, frame.data(), frame.size(), MSG_NOSIGNAL);
+#else
+        (void) m_conn;
+        (void) msg;
+#endif
+    }
+
+    std::string Debug::receive_packet() {
+#ifndef _WIN32
+        while (true) {
+            std::string::size_type start = pending.find('$');
+            if (start == std::string::npos) {
+                /* acks, and Ctrl-C while already stopped */
+                pending.clear();
+            } else {
+                std::string::size_type end = pending.find('#', start);
+                if (end != std::string::npos && end + 2 < pending.size()) {
+                    std::string msg = pending.substr(start + 1, end - start - 1);
+                    pending.erase(0, end + 3);
+                    ::send(conn, "+", 1, MSG_NOSIGNAL);
+                    return msg;
+                }
+            }
+
+            ssize_t nbytes = ::recv(conn, iobuf, bufsize, 0);
+            if (nbytes <= 0) {
+                return "";
+            }
+            pending.append(iobuf, static_cast<std::size_t>(nbytes));
+        }
+#else
+        return "";
+#endif
+    }
+
+    bool Debug::interrupted() {
+#ifndef _WIN32
+        char c;
+        if (::recv(conn, &c, 1, MSG_DONTWAIT) != 1) {
+            return false;
+        }
+        if (c == 0x03) {
+            return true;
+        }
+        pending += c;
+#endif
+        return false;
+    }
+
+    void Debug::end_of_simulation() {
+        if (conn >= 0) {
+            send_packet(conn, "W00");
+#ifndef _WIN32
+            close(conn);
+#endif
+            conn = -1;
+        }
+    }
+
+    bool Debug::step() {
+        bool ebreak = dbg_cpu->CPU_step();
+        /* interrupts taken while recording are replayed from the history */
+        bool irq = !ExecutionHistory::replaying() && dbg_cpu->cpu_process_IRQ();
+        if (history != nullptr) {
+            history->retired(irq);
+        }
+        return ebreak;
+    }
+
+    bool Debug::atBreakpoint() {
+        std::uint64_t pc = 0;
+        return !breakpoints.empty() && dbg_cpu->readDebugRegister(32, pc) && breakpoints.count(pc) != 0;
+    }
+
+    std::string Debug::run() {
+        for (std::uint64_t n = 1;; n++) {
+            if (step() || atBreakpoint()) {
+                return "S05";
+            }
+            if ((n & 0xFFF) == 0 && interrupted()) {
+                return "S02";
+            }
+        }
+    }
+
+    void Debug::replayTo(std::uint64_t icount) {
+        history->seek(icount);
+        while (history->position() < icount) {
+            step();
+        }
+    }
+
+    std::string Debug::reverseStep() {
+        if (history->position() <= history->oldest()) {
+            return "T05replaylog:begin;";
+        }
+        replayTo(history->position() - 1);
+        return "S05";
+    }
+
+    std::string Debug::reverseContinue() {
+        /* scan the snapshot intervals backwards for the last breakpoint before now */
+        std::uint64_t end = history->position();
+        std::uint64_t from = 0;
+        while (history->snapshotBefore(end, from)) {
+            history->seek(from);
+            bool found = false;
+            std::uint64_t hit = 0;
+            while (history->position() < end) {
+                if (atBreakpoint()) {
+                    found = true;
+                    hit = history->position();
+                }
+                step();
+            }
+            if (found) {
+                replayTo(hit);
+                return "S05";
+            }
+            end = from;
+        }
+        replayTo(history->oldest());
+        return "T05replaylog:begin;";
+    }
+
+    std::string Debug::readRegister(unsigned int n) {
+        ExecutionHistory::Untracked untracked;
+        std::uint64_t value = 0;
+        if (!dbg_cpu->readDebugRegister(n, value)) {
+            return "";
+        }
+        return toHex(value, n >= 33 && n < 65 ? 8 : xlen_bytes);
+    }
+
+    bool Debug::writeRegister(unsigned int n, const std::string &hex) {
+        std::vector<unsigned char> data;
+        if (!fromHex(hex, data) || data.empty() || data.size() > 8) {
+            return false;
+        }
+        std::uint64_t value = 0;
+        for (std::size_t i = 0; i < data.size(); i++) {
+            value |= static_cast<std::uint64_t>(data[i]) << (8 * i);
+        }
+
+        bool ok = false;
+        auto apply = [&]() { ok = dbg_cpu->writeDebugRegister(n, value); };
+        if (history != nullptr) {
+            history->edit(apply);
+        } else {
+            apply();
+        }
+        return ok;
+    }
+
+    std::string Debug::readMemory(std::uint64_t addr, std::size_t len) {
+        /* the reply must fit in PacketSize (4 KiB), two characters per byte */
+        std::vector<unsigned char> data(std::min(len, bufsize / 4));
+        dbg_trans.set_command(tlm::TLM_READ_COMMAND);
+        dbg_trans.set_address(addr);
+        dbg_trans.set_data_ptr(data.data());
+        dbg_trans.set_data_length(static_cast<unsigned int>(data.size()));
+        dbg_trans.set_streaming_width(static_cast<unsigned int>(data.size()));
+        unsigned int done = dbg_mem->transport_dbg(dbg_trans);
+        if (done == 0 && !data.empty()) {
+            return "E01";
+        }
+        return toHex(data.data(), done);
+    }
+
+    bool Debug::writeMemory(std::uint64_t addr, const std::string &hex) {
+        std::vector<unsigned char> data;
+        if (!fromHex(hex, data)) {
+            return false;
+        }
+        if (data.empty()) {
+            return true;
+        }
+
+        unsigned int done = 0;
+        auto apply = [&]() {
+            dbg_trans.set_command(tlm::TLM_WRITE_COMMAND);
+            dbg_trans.set_address(addr);
+            dbg_trans.set_data_ptr(data.data());
+            dbg_trans.set_data_length(static_cast<unsigned int>(data.size()));
+            dbg_trans.set_streaming_width(static_cast<unsigned int>(data.size()));
+            done = dbg_mem->transport_dbg(dbg_trans);
+        };
+        if (history != nullptr) {
+            history->edit(apply);
+        } else {
+            apply();
+        }
+        return done == data.size();
     }
 
-    Debug::~Debug() = default;
+    void Debug::handle_gdb_loop() {
+        if (reverse_interval != 0) {
+            if (dbg_cpu->saveHart() == nullptr) {
+                std::cout << "[Debug] Reverse execution not supported by this CPU model." << std::endl;
+            } else {
+                history = ExecutionHistory::getInstance();
+                history->start(dbg_mem->hostBase(), Memory::SIZE, reverse_interval, reverse_budget,
+                               [this]() { return dbg_cpu->saveHart(); },
+                               [this](const HartState &state) { dbg_cpu->restoreHart(state); });
+            }
+        }
 
-    void Debug::send_packet(int, const std::string &) { /* no-op */ }
-    std::string Debug::receive_packet() { return ""; }
-    void Debug::handle_gdb_loop() { /* no-op */ }
+        while (conn >= 0) {
+            std::string msg = receive_packet();
+            if (msg.empty()) {
+                std::cout << "[Debug] Remote connection closed" << std::endl;
+                break;
+            }
+
+            std::string reply;
+            std::uint64_t addr = 0;
+            std::size_t len = 0;
+            const char *rest = nullptr;
+
+            if (msg == "?") {
+                reply = "S05";
+            } else if (startsWith(msg, "qSupported")) {
+                reply = "PacketSize=1000";
+                if (history != nullptr) {
+                    reply += ";ReverseStep+;ReverseContinue+";
+                }
+            } else if (msg == "qAttached") {
+                reply = "1";
+            } else if (msg == "qC") {
+                reply = "QC1";
+            } else if (msg == "qfThreadInfo") {
+                reply = "m1";
+            } else if (msg == "qsThreadInfo") {
+                reply = "l";
+            } else if (msg[0] == 'H' || msg[0] == 'T') {
+                reply = "OK";
+            } else if (msg == "g") {
+                for (unsigned int n = 0; n <= 32; n++) {
+                    reply += readRegister(n);
+                }
+            } else if (msg[0] == 'G') {
+                reply = "OK";
+                for (unsigned int n = 0; n <= 32; n++) {
+                    const std::string value = msg.substr(1 + n * xlen_bytes * 2, xlen_bytes * 2);
+                    if (value.size() != xlen_bytes * 2 || !writeRegister(n, value)) {
+                        reply = "E01";
+                        break;
+                    }
+                }
+            } else if (msg[0] == 'p') {
+                reply = readRegister(static_cast<unsigned int>(std::strtoul(msg.c_str() + 1, nullptr, 16)));
+                if (reply.empty()) {
+                    reply = "E01";
+                }
+            } else if (msg[0] == 'P') {
+                char *end = nullptr;
+                unsigned int n = static_cast<unsigned int>(std::strtoul(msg.c_str() + 1, &end, 16));
+                reply = (*end == '=' && writeRegister(n, end + 1)) ? "OK" : "E01";
+            } else if (msg[0] == 'm') {
+                reply = parseRange(msg.c_str() + 1, addr, len) ? readMemory(addr, len) : "E01";
+            } else if (msg[0] == 'M') {
+                bool ok = parseRange(msg.c_str() + 1, addr, len, &rest) && *rest == ':'
+                          && std::strlen(rest + 1) == len * 2 && writeMemory(addr, rest + 1);
+                reply = ok ? "OK" : "E01";
+            } else if ((msg[0] == 'Z' || msg[0] == 'z') && msg.size() > 3
+                       && (msg[1] == '0' || msg[1] == '1') && msg[2] == ',') {
+                /* software and hardware breakpoints are both checked on the PC */
+                addr = std::strtoull(msg.c_str() + 3, nullptr, 16);
+                if (msg[0] == 'Z') {
+                    breakpoints.insert(addr);
+                } else {
+                    breakpoints.erase(addr);
+                }
+                reply = "OK";
+            } else if (msg[0] == 'c') {
+                reply = run();
+            } else if (msg[0] == 's') {
+                step();
+                reply = "S05";
+            } else if (msg == "bs" && history != nullptr) {
+                reply = reverseStep();
+            } else if (msg == "bc" && history != nullptr) {
+                reply = reverseContinue();
+            } else if (msg == "k" || startsWith(msg, "vKill")) {
+                std::cout << "[Debug] Killed by GDB" << std::endl;
+#ifndef _WIN32
+                close(conn);
+#endif
+                conn = -1;
+                sc_core::sc_stop();
+                return;
+            } else if (msg[0] == 'D') {
+                send_packet(conn, "OK");
+                break;
+            }
+            /* anything else (vCont?, X, qTStatus...) is unsupported: empty reply */
+
+            send_packet(conn, reply);
+        }
+
+#ifndef _WIN32
+        if (conn >= 0) {
+            close(conn);
+        }
+#endif
+        conn = -1;
+
+        /* detached: back to the present, then run freely */
+        while (ExecutionHistory::replaying()) {
+            step();
+        }
+        if (history != nullptr) {
+            history->stop();
+            history = nullptr;
+        }
+        dbg_cpu->CPU_thread();
+    }
 
     std::string Debug::compute_checksum_string(const std::string &msg) {
         unsigned sum = 0;
@@ -42,4 +461,4 @@ namespace riscv_tlm {
         char high = nibble_to_hex[(sum >> 4) & 0xF];
         return {high, low};
     }
-}
\ No newline at end of file
+}
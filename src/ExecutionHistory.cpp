@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file ExecutionHistory.cpp
+ * @brief Snapshots, RAM undo pages and the input log for reverse execution
+ */
+
+#include "ExecutionHistory.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace riscv_tlm {
+
+    ExecutionHistory::Mode ExecutionHistory::s_mode = ExecutionHistory::Mode::Off;
+
+    ExecutionHistory *ExecutionHistory::getInstance() {
+        static ExecutionHistory instance;
+        return &instance;
+    }
+
+    void ExecutionHistory::start(unsigned char *ram, std::size_t size, std::uint64_t interval, std::size_t budget,
+                                 SaveHart save, RestoreHart restore) {
+        stop();
+        m_ram = ram;
+        m_size = size;
+        m_interval = std::max<std::uint64_t>(interval, 1);
+        m_budget = budget;
+        m_save = std::move(save);
+        m_restore = std::move(restore);
+        m_page_serial.assign((size + PAGE_SIZE - 1) / PAGE_SIZE, 0);
+        s_mode = Mode::Record;
+        takeSnapshot();
+    }
+
+    void ExecutionHistory::stop() {
+        s_mode = Mode::Off;
+        m_snapshots.clear();
+        m_page_serial.clear();
+        m_interrupts.clear();
+        m_inputs.clear();
+        m_cursor = 0;
+        m_bytes = 0;
+        m_now = 0;
+        m_horizon = 0;
+    }
+
+    void ExecutionHistory::saveUndo(const unsigned char *host, std::size_t len) {
+        const auto base = reinterpret_cast<std::uintptr_t>(m_ram);
+        const auto addr = reinterpret_cast<std::uintptr_t>(host);
+        if (len == 0 || addr < base || addr >= base + m_size) {
+            return;
+        }
+
+        const std::size_t offset = addr - base;
+        const std::size_t last = (std::min(offset + len, m_size) - 1) / PAGE_SIZE;
+        Snapshot &epoch = m_snapshots.back();
+        for (std::size_t page = offset / PAGE_SIZE; page <= last; page++) {
+            if (m_page_serial[page] == epoch.serial) {
+                continue;
+            }
+            m_page_serial[page] = epoch.serial;
+            const unsigned char *data = m_ram + page * PAGE_SIZE;
+            epoch.undo.emplace_back(page, std::vector<std::uint8_t>(data, data + PAGE_SIZE));
+            m_bytes += PAGE_SIZE;
+        }
+    }
+
+    std::uint64_t ExecutionHistory::logInput(std::uint64_t live) {
+        if (s_mode == Mode::Replay) {
+            if (m_cursor < m_inputs.size() && m_inputs[m_cursor].icount == m_now) {
+                return m_inputs[m_cursor++].value;
+            }
+            lost("a time or cycle CSR read");
+        }
+        m_inputs.push_back({m_now, live});
+        return live;
+    }
+
+    bool ExecutionHistory::replayAccess(tlm::tlm_generic_payload &trans) {
+        if (s_mode != Mode::Replay) {
+            return false;
+        }
+        if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+            /* the peripheral saw this write when it was recorded */
+            return true;
+        }
+
+        const unsigned int len = trans.get_data_length();
+        if (len <= sizeof(std::uint64_t) && m_cursor < m_inputs.size() && m_inputs[m_cursor].icount == m_now) {
+            std::memcpy(trans.get_data_ptr(), &m_inputs[m_cursor++].value, len);
+            return true;
+        }
+        lost("a peripheral read");
+        return false;
+    }
+
+    void ExecutionHistory::recordAccess(const tlm::tlm_generic_payload &trans) {
+        if (s_mode != Mode::Record || trans.get_command() != tlm::TLM_READ_COMMAND
+            || trans.get_data_length() > sizeof(std::uint64_t)) {
+            return;
+        }
+        std::uint64_t value = 0;
+        std::memcpy(&value, trans.get_data_ptr(), trans.get_data_length());
+        m_inputs.push_back({m_now, value});
+    }
+
+    void ExecutionHistory::retired(bool interrupt) {
+        if (s_mode == Mode::Off) {
+            return;
+        }
+        m_now++;
+
+        if (s_mode == Mode::Replay) {
+            auto it = m_interrupts.find(m_now);
+            if (it != m_interrupts.end()) {
+                m_restore(*it->second);
+            }
+            if (m_now >= m_horizon) {
+                s_mode = Mode::Record;
+            }
+            return;
+        }
+
+        if (interrupt) {
+            m_interrupts[m_now] = m_save();
+        }
+        m_horizon = m_now;
+        if (m_now - m_snapshots.back().icount >= m_interval) {
+            takeSnapshot();
+            trim();
+        }
+    }
+
+    std::uint64_t ExecutionHistory::seek(std::uint64_t icount) {
+        if (s_mode == Mode::Off || icount >= m_now) {
+            /* undo images only lead backwards; going forward is re-execution */
+            return m_now;
+        }
+        icount = std::max(icount, oldest());
+
+        /* latest snapshot at or before icount */
+        auto target = std::upper_bound(m_snapshots.begin(), m_snapshots.end(), icount,
+                                       [](std::uint64_t n, const Snapshot &s) { return n < s.icount; });
+        --target;
+
+        for (auto it = m_snapshots.end(); it != target;) {
+            --it;
+            for (const auto &page : it->undo) {
+                std::memcpy(m_ram + page.first * PAGE_SIZE, page.second.data(), PAGE_SIZE);
+            }
+        }
+        m_restore(*target->hart);
+
+        m_now = target->icount;
+        m_cursor = static_cast<std::size_t>(
+                std::lower_bound(m_inputs.begin(), m_inputs.end(), m_now,
+                                 [](const Input &in, std::uint64_t n) { return in.icount < n; })
+                - m_inputs.begin());
+        s_mode = m_now < m_horizon ? Mode::Replay : Mode::Record;
+        return m_now;
+    }
+
+    bool ExecutionHistory::snapshotBefore(std::uint64_t icount, std::uint64_t &snapshot) const {
+        auto it = std::lower_bound(m_snapshots.begin(), m_snapshots.end(), icount,
+                                   [](const Snapshot &s, std::uint64_t n) { return s.icount < n; });
+        if (it == m_snapshots.begin()) {
+            return false;
+        }
+        snapshot = std::prev(it)->icount;
+        return true;
+    }
+
+    void ExecutionHistory::edit(const std::function<void()> &apply) {
+        if (s_mode == Mode::Off) {
+            apply();
+            return;
+        }
+        truncate();
+        apply();
+        takeSnapshot();
+        trim();
+    }
+
+    std::uint64_t ExecutionHistory::oldest() const {
+        return m_snapshots.empty() ? m_now : m_snapshots.front().icount;
+    }
+
+    void ExecutionHistory::takeSnapshot() {
+        m_snapshots.push_back({m_now, ++m_serial, m_save(), {}});
+    }
+
+    void ExecutionHistory::trim() {
+        while (m_bytes > m_budget && m_snapshots.size() > 1) {
+            m_bytes -= m_snapshots.front().undo.size() * PAGE_SIZE;
+            m_snapshots.pop_front();
+
+            /* what re-execution from the new oldest snapshot still needs */
+            const std::uint64_t first = m_snapshots.front().icount;
+            while (!m_inputs.empty() && m_inputs.front().icount < first) {
+                m_inputs.pop_front();
+            }
+            m_interrupts.erase(m_interrupts.begin(), m_interrupts.upper_bound(first));
+        }
+        m_cursor = std::min(m_cursor, m_inputs.size());
+    }
+
+    void ExecutionHistory::truncate() {
+        while (m_snapshots.size() > 1 && m_snapshots.back().icount > m_now) {
+            m_bytes -= m_snapshots.back().undo.size() * PAGE_SIZE;
+            m_snapshots.pop_back();
+        }
+        if (s_mode == Mode::Replay) {
+            m_inputs.erase(m_inputs.begin() + static_cast<std::ptrdiff_t>(m_cursor), m_inputs.end());
+        }
+        m_cursor = m_inputs.size();
+        m_interrupts.erase(m_interrupts.upper_bound(m_now), m_interrupts.end());
+        m_horizon = m_now;
+        s_mode = Mode::Record;
+    }
+
+    void ExecutionHistory::lost(const char *what) {
+        std::cerr << "[Debug] re-execution diverged at instruction " << m_now << " (" << what
+                  << "), recording from here\n";
+        truncate();
+    }
+}
@@ -0,0 +1,822 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file FaultCampaign.cpp
+ * @brief Golden run, fault plan, forked injections and their classification
+ */
+
+#include "FaultCampaign.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "systemc"
+
+#include "CPU.h"
+#include "ClockDomains.h"
+#include "Memory.h"
+#include "Performance.h"
+#include "RunControl.h"
+
+namespace riscv_tlm {
+
+    bool FaultCampaign::s_tracking = false;
+
+    namespace {
+        constexpr std::uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+        constexpr std::uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+        /* CSRs in the digest and the targets of CSR faults */
+        constexpr unsigned int STATE_CSRS[] = {
+                0x300, 0x302, 0x303, 0x304, 0x305, 0x340, 0x341, 0x342, 0x343, 0x344,   // machine
+                0x105, 0x140, 0x141, 0x142, 0x143, 0x180,                               // supervisor
+                0x003                                                                   // fcsr
+        };
+
+        std::uint64_t mix(std::uint64_t h, std::uint64_t value) {
+            for (unsigned int i = 0; i < 8; i++) {
+                h ^= (value >> (8 * i)) & 0xFF;
+                h *= FNV_PRIME;
+            }
+            return h;
+        }
+
+        /* contribution of page p with content hash h to the RAM sum */
+        std::uint64_t pageTerm(std::uint64_t p, std::uint64_t h) {
+            std::uint64_t z = h ^ (p * 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        bool number(const std::string &text, std::uint64_t &value) {
+            try {
+                std::size_t used = 0;
+                value = std::stoull(text, &used, 0);
+                return used == text.size();
+            } catch (...) {
+                return false;
+            }
+        }
+
+        bool real(const std::string &text, double &value) {
+            try {
+                std::size_t used = 0;
+                value = std::stod(text, &used);
+                return used == text.size() && value >= 0;
+            } catch (...) {
+                return false;
+            }
+        }
+
+        /* "A:B" with either side optional */
+        bool range(const std::string &text, std::uint64_t &from, std::uint64_t &to) {
+            std::string::size_type colon = text.find(':');
+            if (colon == std::string::npos) {
+                return false;
+            }
+            const std::string a = text.substr(0, colon);
+            const std::string b = text.substr(colon + 1);
+            return (a.empty() || number(a, from)) && (b.empty() || number(b, to));
+        }
+
+        std::string hex(std::uint64_t value) {
+            char text[24];
+            std::snprintf(text, sizeof(text), "0x%llx", static_cast<unsigned long long>(value));
+            return text;
+        }
+
+        const char *targetName(FaultCampaign::Target target) {
+            switch (target) {
+                case FaultCampaign::Target::GPR:
+                    return "gpr";
+                case FaultCampaign::Target::CSR:
+                    return "csr";
+                case FaultCampaign::Target::Memory:
+                    return "mem";
+                default:
+                    return "latch";
+            }
+        }
+
+#if !defined(_WIN32)
+        bool writeAll(int fd, const void *data, std::size_t len) {
+            const auto *p = static_cast<const char *>(data);
+            while (len > 0) {
+                ssize_t n = ::write(fd, p, len);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    return false;
+                }
+                p += n;
+                len -= static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+
+        bool readAll(int fd, void *data, std::size_t len) {
+            auto *p = static_cast<char *>(data);
+            while (len > 0) {
+                ssize_t n = ::read(fd, p, len);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    return false;
+                }
+                p += n;
+                len -= static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+#endif
+    }
+
+    std::size_t LatchMap::locate(std::size_t bit, unsigned int &offset) const {
+        for (std::size_t f = 0; f < m_fields.size(); f++) {
+            if (bit < m_fields[f].bits) {
+                offset = static_cast<unsigned int>(bit);
+                return f;
+            }
+            bit -= m_fields[f].bits;
+        }
+        offset = 0;
+        return m_fields.size();
+    }
+
+    FaultCampaign *FaultCampaign::getInstance() {
+        static FaultCampaign instance;
+        return &instance;
+    }
+
+    const char *FaultCampaign::outcomeName(Outcome outcome) {
+        switch (outcome) {
+            case Outcome::Masked:
+                return "masked";
+            case Outcome::SDC:
+                return "sdc";
+            case Outcome::Crash:
+                return "crash";
+            default:
+                return "hang";
+        }
+    }
+
+    bool FaultCampaign::parse(const std::string &spec, Options &options, std::string &error) {
+        std::string::size_type pos = 0;
+        while (pos <= spec.size()) {
+            std::string::size_type comma = spec.find(',', pos);
+            const std::string item = spec.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+            pos = comma == std::string::npos ? spec.size() + 1 : comma + 1;
+            if (item.empty()) {
+                continue;
+            }
+
+            std::string::size_type eq = item.find('=');
+            if (eq == std::string::npos) {
+                error = "expected <key>=<value>: " + item;
+                return false;
+            }
+            const std::string key = item.substr(0, eq);
+            const std::string value = item.substr(eq + 1);
+            std::uint64_t n = 0;
+            bool ok = true;
+
+            if (key == "target") {
+                if (value == "gpr") {
+                    options.target = Target::GPR;
+                } else if (value == "csr") {
+                    options.target = Target::CSR;
+                } else if (value == "mem") {
+                    options.target = Target::Memory;
+                } else if (value == "latch") {
+                    options.target = Target::Latch;
+                } else {
+                    ok = false;
+                }
+            } else if (key == "count") {
+                ok = number(value, options.count) && options.count > 0 && options.count <= 0xFFFFFFFFu;
+            } else if (key == "bits") {
+                ok = number(value, n) && n >= 1 && n <= 32;
+                options.bits = static_cast<unsigned int>(n);
+            } else if (key == "window") {
+                ok = range(value, options.from, options.to) && (options.to == 0 || options.from <= options.to);
+            } else if (key == "unit") {
+                ok = value == "instr" || value == "cycle";
+                options.cycles = value == "cycle";
+            } else if (key == "mem") {
+                ok = range(value, options.mem_start, options.mem_end) && options.mem_start < options.mem_end;
+            } else if (key == "seed") {
+                ok = number(value, options.seed);
+            } else if (key == "jobs") {
+                ok = number(value, n) && n >= 1 && n <= 4096;
+                options.jobs = static_cast<unsigned int>(n);
+            } else if (key == "interval") {
+                ok = number(value, options.interval) && options.interval > 0;
+            } else if (key == "hang") {
+                ok = real(value, options.hang) && options.hang >= 1.0;
+            } else if (key == "timeout") {
+                ok = real(value, options.timeout);
+            } else if (key == "report") {
+                options.report = value;
+                ok = !value.empty();
+            } else {
+                error = "unknown key: " + key;
+                return false;
+            }
+            if (!ok) {
+                error = "bad value: " + item;
+                return false;
+            }
+        }
+        if (options.from == 0) {
+            options.from = 1;
+        }
+        return true;
+    }
+
+    void FaultCampaign::markDirty(const unsigned char *host, std::size_t len) {
+        if (host < m_ram || len == 0) {
+            return;
+        }
+        const std::size_t offset = static_cast<std::size_t>(host - m_ram);
+        if (offset >= m_pages * PAGE_SIZE) {
+            return;
+        }
+        const std::size_t last = std::min((offset + len - 1) / PAGE_SIZE, m_pages - 1);
+        for (std::size_t p = offset / PAGE_SIZE; p <= last; p++) {
+            if (m_page_state[p] != 2) {
+                if (m_page_state[p] == 0) {
+                    m_page_hash[p] = hashPage(m_ram + p * PAGE_SIZE);     // as loaded
+                }
+                m_page_state[p] = 2;
+                m_dirty.push_back(p);
+            }
+        }
+    }
+
+    void FaultCampaign::observeWrite(const tlm::tlm_generic_payload &trans) {
+        m_output = mix(m_output, trans.get_address());
+        const unsigned char *data = trans.get_data_ptr();
+        for (unsigned int i = 0; i < trans.get_data_length(); i++) {
+            m_output = (m_output ^ data[i]) * FNV_PRIME;
+        }
+    }
+
+    std::uint64_t FaultCampaign::hashPage(const unsigned char *page) {
+        std::uint64_t h = FNV_OFFSET;
+        for (std::size_t i = 0; i < PAGE_SIZE; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, page + i, 8);
+            h = (h ^ word) * FNV_PRIME;
+            h ^= h >> 29;
+        }
+        return h;
+    }
+
+    std::uint64_t FaultCampaign::digest() {
+        for (std::size_t p : m_dirty) {
+            const std::uint64_t h = hashPage(m_ram + p * PAGE_SIZE);
+            m_ram_sum += pageTerm(p, h) - pageTerm(p, m_page_hash[p]);
+            m_page_hash[p] = h;
+            m_page_state[p] = 1;
+        }
+        m_dirty.clear();
+
+        std::uint64_t h = mix(FNV_OFFSET, m_ram_sum);
+        h = mix(h, m_output);
+        h = mix(h, m_exceptions);
+        h = mix(h, sc_core::sc_time_stamp().value());
+        for (unsigned int n = 1; n < 65; n++) {     // x1-x31, pc, f0-f31
+            std::uint64_t value = 0;
+            m_cpu->readDebugRegister(n, value);
+            h = mix(h, value);
+        }
+        for (unsigned int csr : STATE_CSRS) {
+            std::uint64_t value = 0;
+            m_cpu->readDebugRegister(65 + csr, value);
+            h = mix(h, value);
+        }
+        return h;
+    }
+
+    bool FaultCampaign::advance() {
+        sc_core::sc_start();
+        RunControl::Hit hit;
+        bool paused = false;
+        while (RunControl::getInstance()->takeHit(hit)) {
+            paused |= hit.action == RunControl::Action::Pause;
+        }
+        return paused && sc_core::sc_get_status() != sc_core::SC_STOPPED;
+    }
+
+    void FaultCampaign::arm(std::uint64_t at, bool cycles, std::uint64_t limit) {
+        RunControl *run_control = RunControl::getInstance();
+        std::string error;
+        run_control->clear();
+        if (at != 0) {
+            run_control->add((cycles ? "cycle=" : "instr=") + std::to_string(at), RunControl::Action::Pause, error);
+        }
+        if (limit != 0) {
+            run_control->add("instr=" + std::to_string(limit), RunControl::Action::Stop, error);
+        }
+    }
+
+#if defined(_WIN32)
+
+    int FaultCampaign::run(const Options &options, CPU *cpu, Memory *memory, unsigned int xlen) {
+        (void) options;
+        (void) cpu;
+        (void) memory;
+        (void) xlen;
+        std::cerr << "--inject: fault campaigns need fork(), not available on this platform\n";
+        return 1;
+    }
+
+#else
+
+    bool FaultCampaign::runGolden(Golden &golden, std::string &error) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            error = std::string("pipe: ") + std::strerror(errno);
+            return false;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            error = std::string("fork: ") + std::strerror(errno);
+            return false;
+        }
+
+        if (pid == 0) {
+            close(fds[0]);
+            auto *perf = Performance::getInstance();
+            const auto start = std::chrono::steady_clock::now();
+            s_tracking = true;
+
+            std::uint64_t boundary = m_options.interval;
+            arm(boundary, false, m_options.max_instructions);
+            while (advance()) {
+                if (perf->getInstructions() == boundary) {
+                    golden.digests.push_back(digest());
+                    boundary += m_options.interval;
+                }
+                arm(boundary, false, m_options.max_instructions);
+            }
+
+            golden.instructions = perf->getInstructions();
+            golden.cycles = ClockDomains::getInstance()->core().cycles();
+            m_cpu->readDebugRegister(32, golden.pc);
+            golden.exceptions = m_exceptions;
+            golden.output = m_output;
+            for (std::size_t p = 0; p < m_pages; p++) {
+                if (m_page_state[p] != 0) {
+                    golden.written.push_back(p);
+                }
+            }
+            golden.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            const std::uint64_t header[] = {golden.instructions, golden.cycles, golden.pc, golden.exceptions,
+                                            golden.output, golden.digests.size(), golden.written.size()};
+            bool ok = writeAll(fds[1], header, sizeof(header)) &&
+                      writeAll(fds[1], &golden.seconds, sizeof(golden.seconds)) &&
+                      writeAll(fds[1], golden.digests.data(), golden.digests.size() * sizeof(std::uint64_t)) &&
+                      writeAll(fds[1], golden.written.data(), golden.written.size() * sizeof(std::uint64_t));
+            _exit(ok ? 0 : 1);
+        }
+
+        close(fds[1]);
+        std::uint64_t header[7];
+        bool ok = readAll(fds[0], header, sizeof(header)) && readAll(fds[0], &golden.seconds, sizeof(golden.seconds));
+        if (ok) {
+            golden.instructions = header[0];
+            golden.cycles = header[1];
+            golden.pc = header[2];
+            golden.exceptions = header[3];
+            golden.output = header[4];
+            golden.digests.resize(header[5]);
+            golden.written.resize(header[6]);
+            ok = readAll(fds[0], golden.digests.data(), golden.digests.size() * sizeof(std::uint64_t)) &&
+                 readAll(fds[0], golden.written.data(), golden.written.size() * sizeof(std::uint64_t));
+        }
+        close(fds[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            error = "the golden run failed";
+            return false;
+        }
+        if (golden.instructions == 0) {
+            error = "the golden run retired no instructions";
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<FaultCampaign::Fault> FaultCampaign::plan(const Golden &golden, std::string &error) {
+        std::mt19937_64 rng(m_options.seed);
+        auto uniform = [&rng](std::uint64_t lo, std::uint64_t hi) {
+            return std::uniform_int_distribution<std::uint64_t>(lo, hi)(rng);
+        };
+        /* @p n distinct bits below @p width */
+        auto pick = [&](unsigned int width) {
+            std::vector<unsigned int> all(width);
+            for (unsigned int i = 0; i < width; i++) {
+                all[i] = i;
+            }
+            std::shuffle(all.begin(), all.end(), rng);
+            all.resize(std::min(m_options.bits, width));
+            std::sort(all.begin(), all.end());
+            return all;
+        };
+        auto bitList = [](const std::vector<unsigned int> &bits) {
+            std::string text;
+            for (unsigned int b : bits) {
+                text += (text.empty() ? " bit " : "+") + std::to_string(b);
+            }
+            return text;
+        };
+
+        /* what can be hit */
+        std::vector<unsigned int> csrs;
+        std::vector<std::uint64_t> pages;
+        switch (m_options.target) {
+            case Target::CSR:
+                for (unsigned int csr : STATE_CSRS) {
+                    std::uint64_t value;
+                    if (m_cpu->readDebugRegister(65 + csr, value)) {
+                        csrs.push_back(csr);
+                    }
+                }
+                if (csrs.empty()) {
+                    error = "this model has no CSRs to inject into";
+                }
+                break;
+            case Target::Memory:
+                if (m_options.mem_end > m_options.mem_start) {
+                    if (m_options.mem_start >= Memory::SIZE) {
+                        error = "mem= is outside the RAM";
+                    }
+                } else {
+                    std::set<std::uint64_t> set(golden.written.begin(), golden.written.end());
+                    for (const auto &run : m_memory->imageRuns()) {
+                        for (std::uint64_t a = run.first; a < run.first + run.second && a < Memory::SIZE;
+                             a = (a / PAGE_SIZE + 1) * PAGE_SIZE) {
+                            set.insert(a / PAGE_SIZE);
+                        }
+                    }
+                    pages.assign(set.begin(), set.end());
+                    if (pages.empty()) {
+                        error = "no RAM was loaded or written; give mem=<start>:<end>";
+                    }
+                }
+                break;
+            case Target::Latch:
+                m_cpu->visitLatches(m_latches);
+                if (m_latches.bits() == 0) {
+                    error = "this model has no pipeline latches (cycle models only)";
+                }
+                break;
+            default:
+                break;
+        }
+        if (!error.empty()) {
+            return {};
+        }
+
+        const std::uint64_t end = m_options.cycles ? golden.cycles : golden.instructions;
+        const std::uint64_t from = std::min(m_options.from, end);
+        const std::uint64_t to = m_options.to == 0 ? end : std::max(m_options.to, from);
+
+        std::vector<Fault> faults(m_options.count);
+        for (auto &fault : faults) {
+            fault.at = uniform(from, to);
+            switch (m_options.target) {
+                case Target::GPR:
+                    fault.where = uniform(1, 31);
+                    fault.bits = pick(m_xlen);
+                    fault.site = "x" + std::to_string(fault.where) + bitList(fault.bits);
+                    break;
+                case Target::CSR:
+                    fault.where = csrs[uniform(0, csrs.size() - 1)];
+                    fault.bits = pick(fault.where == 0x003 ? 8 : m_xlen);
+                    fault.site = "csr " + hex(fault.where) + bitList(fault.bits);
+                    break;
+                case Target::Memory:
+                    if (pages.empty()) {
+                        fault.where = uniform(m_options.mem_start / 4, (std::min<std::uint64_t>(m_options.mem_end,
+                                                                                                 Memory::SIZE) - 1) / 4) * 4;
+                    } else {
+                        fault.where = pages[uniform(0, pages.size() - 1)] * PAGE_SIZE + uniform(0, PAGE_SIZE / 4 - 1) * 4;
+                    }
+                    fault.bits = pick(32);
+                    fault.site = "mem " + hex(fault.where) + bitList(fault.bits);
+                    break;
+                case Target::Latch: {
+                    unsigned int offset;
+                    fault.where = m_latches.locate(uniform(0, m_latches.bits() - 1), offset);
+                    const unsigned int width = m_latches.fieldBits(fault.where);
+                    fault.bits = pick(width);
+                    if (std::find(fault.bits.begin(), fault.bits.end(), offset) == fault.bits.end()) {
+                        fault.bits[0] = offset;     // the bit drawn is always one of them
+                        std::sort(fault.bits.begin(), fault.bits.end());
+                    }
+                    fault.site = m_latches.fieldName(fault.where) + bitList(fault.bits);
+                    break;
+                }
+            }
+        }
+        std::stable_sort(faults.begin(), faults.end(), [](const Fault &a, const Fault &b) {
+            return a.at < b.at;
+        });
+        return faults;
+    }
+
+    FaultCampaign::Outcome FaultCampaign::classify(const Golden &golden, bool hang_limit) {
+        if (hang_limit) {
+            return Outcome::Hang;
+        }
+        std::uint64_t pc = 0;
+        m_cpu->readDebugRegister(32, pc);
+        const bool ended_alike = m_options.max_instructions != 0 || pc == golden.pc;
+        if (m_exceptions > golden.exceptions || !ended_alike) {
+            return Outcome::Crash;
+        }
+        return m_output != golden.output ? Outcome::SDC : Outcome::Masked;
+    }
+
+    void FaultCampaign::inject(std::uint32_t index, const Fault &fault, const Golden &golden, int fd) {
+        auto *perf = Performance::getInstance();
+
+        std::uint64_t value = 0;
+        switch (m_options.target) {
+            case Target::GPR:
+            case Target::CSR: {
+                const unsigned int n = static_cast<unsigned int>(m_options.target == Target::GPR ? fault.where
+                                                                                                 : 65 + fault.where);
+                m_cpu->readDebugRegister(n, value);
+                for (unsigned int b : fault.bits) {
+                    value ^= std::uint64_t(1) << b;
+                }
+                m_cpu->writeDebugRegister(n, value);
+                break;
+            }
+            case Target::Memory: {
+                unsigned char *word = m_ram + fault.where;
+                markDirty(word, 4);
+                for (unsigned int b : fault.bits) {
+                    word[b / 8] ^= static_cast<unsigned char>(1u << (b % 8));
+                }
+                break;
+            }
+            case Target::Latch:
+                for (unsigned int b : fault.bits) {
+                    m_latches.flip(fault.where, b);
+                }
+                break;
+        }
+
+        /* a run past this is a hang, unless every run ends at --max-instr */
+        const std::uint64_t start = perf->getInstructions();
+        const std::uint64_t limit = m_options.max_instructions != 0
+                                    ? m_options.max_instructions
+                                    : std::max(static_cast<std::uint64_t>(std::ceil(golden.instructions * m_options.hang)),
+                                               start + DRAIN);
+        const std::uint64_t last = golden.digests.size() * m_options.interval;
+        std::uint64_t boundary = (start + DRAIN + m_options.interval - 1) / m_options.interval * m_options.interval;
+
+        if (m_options.timeout > 0) {
+            alarm(static_cast<unsigned int>(std::ceil(m_options.timeout)));
+        }
+
+        Record record{index, static_cast<std::uint8_t>(Outcome::Masked), 0, 0, 0};
+        arm(boundary <= last ? boundary : 0, false, limit);
+        while (advance()) {
+            if (perf->getInstructions() == boundary) {
+                if (digest() == golden.digests[boundary / m_options.interval - 1]) {
+                    record.early = 1;
+                    break;
+                }
+                boundary += m_options.interval;
+            }
+            arm(boundary <= last ? boundary : 0, false, limit);
+        }
+        record.instructions = perf->getInstructions();
+        if (!record.early) {
+            const bool hang = m_options.max_instructions == 0 && record.instructions >= limit;
+            record.outcome = static_cast<std::uint8_t>(classify(golden, hang));
+        }
+        writeAll(fd, &record, sizeof(record));
+        _exit(0);
+    }
+
+    int FaultCampaign::run(const Options &options, CPU *cpu, Memory *memory, unsigned int xlen) {
+        m_options = options;
+        m_cpu = cpu;
+        m_memory = memory;
+        m_xlen = xlen;
+        m_ram = memory->hostBase();
+        m_pages = Memory::SIZE / PAGE_SIZE;
+        m_page_hash.assign(m_pages, 0);
+        m_page_state.assign(m_pages, 0);
+        if (m_options.jobs == 0) {
+            m_options.jobs = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        /* the program's own output goes nowhere; the campaign reports on the real stdout */
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(nullptr);
+        const int out_fd = dup(STDOUT_FILENO);
+        const int err_fd = dup(STDERR_FILENO);
+        const int null_fd = open("/dev/null", O_WRONLY);
+        if (out_fd < 0 || err_fd < 0 || null_fd < 0) {
+            std::cerr << "--inject: cannot redirect the program output\n";
+            return 1;
+        }
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        close(null_fd);
+        FILE *out = fdopen(out_fd, "w");
+        auto restore = [&]() {
+            std::fflush(out);
+            std::cout.flush();
+            std::fflush(nullptr);
+            dup2(out_fd, STDOUT_FILENO);
+            dup2(err_fd, STDERR_FILENO);
+            close(err_fd);
+        };
+
+        const auto wall_start = std::chrono::steady_clock::now();
+        Golden golden;
+        std::string error;
+        if (!runGolden(golden, error)) {
+            restore();
+            std::cerr << "--inject: " << error << "\n";
+            return 1;
+        }
+        std::vector<Fault> faults = plan(golden, error);
+        if (!error.empty()) {
+            restore();
+            std::cerr << "--inject: " << error << "\n";
+            return 1;
+        }
+        if (m_options.timeout == 0) {
+            m_options.timeout = std::max(1.0, 10 * golden.seconds);
+        }
+
+        std::fprintf(out, "Fault campaign: %llu x %u-bit %s faults, %s %llu..%llu, %u jobs\n",
+                     static_cast<unsigned long long>(faults.size()), m_options.bits, targetName(m_options.target),
+                     m_options.cycles ? "cycles" : "instructions",
+                     static_cast<unsigned long long>(faults.empty() ? 0 : faults.front().at),
+                     static_cast<unsigned long long>(faults.empty() ? 0 : faults.back().at), m_options.jobs);
+        std::fprintf(out, "  golden : %llu instructions, %llu cycles, %zu digests, %.3f s\n",
+                     static_cast<unsigned long long>(golden.instructions),
+                     static_cast<unsigned long long>(golden.cycles), golden.digests.size(), golden.seconds);
+        std::fflush(out);
+
+        /* second pass: the golden run again, forking at every injection point */
+        int fds[2];
+        if (pipe(fds) != 0) {
+            restore();
+            std::cerr << "--inject: pipe: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+        std::vector<Record> results(faults.size(), Record{0, 0, 0, 0, 0});
+        std::vector<bool> done(faults.size(), false);
+        std::vector<bool> reported(faults.size(), false);
+        std::map<pid_t, std::uint32_t> running;
+
+        auto drain = [&]() {
+            Record record;
+            while (readAll(fds[0], &record, sizeof(record))) {
+                if (record.index < results.size()) {
+                    results[record.index] = record;
+                    reported[record.index] = true;
+                }
+            }
+        };
+        auto reap = [&]() {
+            int status = 0;
+            pid_t pid = waitpid(-1, &status, 0);
+            if (pid <= 0) {
+                return;
+            }
+            drain();
+            auto it = running.find(pid);
+            if (it == running.end()) {
+                return;
+            }
+            const std::uint32_t index = it->second;
+            running.erase(it);
+            done[index] = true;
+            if (!reported[index]) {
+                /* killed by the timeout, or the simulator itself died */
+                const bool timeout = WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM;
+                results[index] = Record{index, static_cast<std::uint8_t>(timeout ? Outcome::Hang : Outcome::Crash),
+                                        0, 0, 0};
+            }
+        };
+
+        s_tracking = true;
+        std::size_t next = 0;
+        std::size_t skipped = 0;
+        while (next < faults.size()) {
+            const std::uint64_t at = faults[next].at;
+            arm(at, m_options.cycles, m_options.max_instructions);
+            if (!advance()) {
+                skipped = faults.size() - next;     // the program ended first
+                break;
+            }
+            for (; next < faults.size() && faults[next].at == at; next++) {
+                while (running.size() >= m_options.jobs) {
+                    reap();
+                }
+                std::fflush(out);
+                pid_t pid = fork();
+                if (pid == 0) {
+                    close(fds[0]);
+                    inject(static_cast<std::uint32_t>(next), faults[next], golden, fds[1]);
+                }
+                if (pid < 0) {
+                    results[next] = Record{static_cast<std::uint32_t>(next),
+                                           static_cast<std::uint8_t>(Outcome::Crash), 0, 0, 0};
+                    done[next] = true;
+                    continue;
+                }
+                running[pid] = static_cast<std::uint32_t>(next);
+            }
+        }
+        while (!running.empty()) {
+            reap();
+        }
+        close(fds[0]);
+        close(fds[1]);
+        s_tracking = false;
+
+        /* results */
+        std::uint64_t counts[4] = {0, 0, 0, 0};
+        std::uint64_t early = 0;
+        std::uint64_t ran = 0;
+        for (std::size_t i = 0; i < faults.size(); i++) {
+            if (!done[i]) {
+                continue;
+            }
+            ran++;
+            counts[results[i].outcome]++;
+            early += results[i].early;
+        }
+        const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+        for (Outcome o : {Outcome::Masked, Outcome::SDC, Outcome::Crash, Outcome::Hang}) {
+            const std::uint64_t n = counts[static_cast<unsigned int>(o)];
+            std::fprintf(out, "  %-7s: %8llu  %5.1f%%", outcomeName(o), static_cast<unsigned long long>(n),
+                         ran != 0 ? 100.0 * static_cast<double>(n) / static_cast<double>(ran) : 0.0);
+            if (o == Outcome::Masked) {
+                std::fprintf(out, "  (%llu ended early on reconvergence)", static_cast<unsigned long long>(early));
+            }
+            std::fprintf(out, "\n");
+        }
+        if (skipped != 0) {
+            std::fprintf(out, "  skipped: %8zu  (past the end of the program)\n", skipped);
+        }
+        std::fprintf(out, "  wall   : %.3f s, %.0f injections/s\n", wall,
+                     wall > 0 ? static_cast<double>(ran) / wall : 0.0);
+
+        if (!m_options.report.empty()) {
+            std::ofstream csv(m_options.report);
+            if (!csv) {
+                std::fprintf(out, "  cannot write %s\n", m_options.report.c_str());
+            } else {
+                csv << "index," << (m_options.cycles ? "cycle" : "instruction") << ",site,outcome,early,instructions\n";
+                for (std::size_t i = 0; i < faults.size(); i++) {
+                    csv << i << ',' << faults[i].at << ",\"" << faults[i].site << "\","
+                        << (done[i] ? outcomeName(static_cast<Outcome>(results[i].outcome)) : "skipped") << ','
+                        << static_cast<unsigned int>(results[i].early) << ',' << results[i].instructions << '\n';
+                }
+                std::fprintf(out, "  report : %s\n", m_options.report.c_str());
+            }
+        }
+
+        restore();
+        std::fclose(out);
+        return 0;
+    }
+
+#endif
+}
@@ -0,0 +1,461 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file FetchUnit.cpp
+ * @brief Fetch-block front end and compressed instruction expansion
+ */
+
+#include "FetchUnit.h"
+
+#include <utility>
+
+#include "C_extension.h"
+
+namespace riscv_tlm {
+
+    namespace {
+        constexpr std::uint32_t OP_LOAD = 0x03;
+        constexpr std::uint32_t OP_LOAD_FP = 0x07;
+        constexpr std::uint32_t OP_IMM = 0x13;
+        constexpr std::uint32_t OP_IMM_32 = 0x1B;
+        constexpr std::uint32_t OP_STORE = 0x23;
+        constexpr std::uint32_t OP_STORE_FP = 0x27;
+        constexpr std::uint32_t OP_REG = 0x33;
+        constexpr std::uint32_t OP_LUI = 0x37;
+        constexpr std::uint32_t OP_REG_32 = 0x3B;
+        constexpr std::uint32_t OP_BRANCH = 0x63;
+        constexpr std::uint32_t OP_JALR = 0x67;
+        constexpr std::uint32_t OP_JAL = 0x6F;
+        constexpr std::uint32_t EBREAK = 0x00100073;
+
+        inline std::uint32_t bits(std::uint32_t v, unsigned int hi, unsigned int lo) {
+            return (v >> lo) & ((1u << (hi - lo + 1)) - 1);
+        }
+
+        inline std::int32_t sext(std::uint32_t v, unsigned int width) {
+            return static_cast<std::int32_t>(v << (32 - width)) >> (32 - width);
+        }
+
+        inline std::uint32_t itype(std::int32_t imm, std::uint32_t rs1, std::uint32_t f3, std::uint32_t rd,
+                                   std::uint32_t op) {
+            return (static_cast<std::uint32_t>(imm) << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op;
+        }
+
+        inline std::uint32_t stype(std::uint32_t imm, std::uint32_t rs2, std::uint32_t rs1, std::uint32_t f3,
+                                   std::uint32_t op = OP_STORE) {
+            return (bits(imm, 11, 5) << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (bits(imm, 4, 0) << 7) | op;
+        }
+
+        inline std::uint32_t rtype(std::uint32_t f7, std::uint32_t rs2, std::uint32_t rs1, std::uint32_t f3,
+                                   std::uint32_t rd, std::uint32_t op) {
+            return (f7 << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op;
+        }
+
+        inline std::uint32_t btype(std::int32_t offset, std::uint32_t rs1, std::uint32_t f3) {
+            auto imm = static_cast<std::uint32_t>(offset);
+            return (bits(imm, 12, 12) << 31) | (bits(imm, 10, 5) << 25) | (rs1 << 15) | (f3 << 12) |
+                   (bits(imm, 4, 1) << 8) | (bits(imm, 11, 11) << 7) | OP_BRANCH;
+        }
+
+        inline std::uint32_t jtype(std::int32_t offset, std::uint32_t rd) {
+            auto imm = static_cast<std::uint32_t>(offset);
+            return (bits(imm, 20, 20) << 31) | (bits(imm, 10, 1) << 21) | (bits(imm, 11, 11) << 20) |
+                   (bits(imm, 19, 12) << 12) | (rd << 7) | OP_JAL;
+        }
+
+        /* CJ-format offset of c.j / c.jal */
+        inline std::int32_t cjOffset(std::uint32_t c) {
+            std::uint32_t imm = (bits(c, 12, 12) << 11) | (bits(c, 11, 11) << 4) | (bits(c, 10, 9) << 8) |
+                                (bits(c, 8, 8) << 10) | (bits(c, 7, 7) << 6) | (bits(c, 6, 6) << 7) |
+                                (bits(c, 5, 3) << 1) | (bits(c, 2, 2) << 5);
+            return sext(imm, 12);
+        }
+    }
+
+    FetchUnit::FetchUnit(ReadBlock read, bool rv64, std::uint64_t pc, unsigned int block_bytes,
+                         unsigned int queue_bytes) :
+            read_block(std::move(read)), rv64(rv64),
+            block_bytes(block_bytes < 4 ? 4 : (block_bytes > 64 ? 64 : block_bytes)),
+            queue(queue_bytes < this->block_bytes ? this->block_bytes : queue_bytes, 0),
+            head_pc(pc), fetch_pc(pc) {
+    }
+
+    void FetchUnit::redirect(std::uint64_t pc) {
+        counters.redirects++;
+        counters.discarded_bytes += count;
+        head = 0;
+        count = 0;
+        head_pc = pc;
+        fetch_pc = pc;
+        fault = false;
+    }
+
+    void FetchUnit::cycle() {
+        if (fault) {
+            return;
+        }
+
+        unsigned int len = block_bytes - static_cast<unsigned int>(fetch_pc % block_bytes);
+        if (queue.size() - count < len) {
+            counters.full_cycles++;
+            return;
+        }
+
+        std::uint8_t block[64];
+        if (!read_block(fetch_pc, block, len)) {
+            fault = true;
+            fault_pc = fetch_pc;
+            return;
+        }
+
+        for (unsigned int i = 0; i < len; i++) {
+            queue[(head + count + i) % queue.size()] = block[i];
+        }
+        count += len;
+        fetch_pc += len;
+        counters.blocks++;
+        counters.bytes += len;
+    }
+
+    bool FetchUnit::peek(Slot &out, unsigned int index) const {
+        unsigned int offset = 0;
+        for (unsigned int i = 0;; i++) {
+            if (offset + 2 > count) {
+                return false;
+            }
+            std::uint16_t low = static_cast<std::uint16_t>(byteAt(offset) | (byteAt(offset + 1) << 8));
+            unsigned int length = (low & 3) == 3 ? 4 : 2;
+            if (offset + length > count) {
+                return false;
+            }
+            if (i == index) {
+                out.pc = head_pc + offset;
+                out.length = static_cast<std::uint8_t>(length);
+                if (length == 2) {
+                    out.instr = expand(low, rv64);
+                    if (out.instr == 0) {
+                        out.instr = low;
+                    }
+                } else {
+                    out.instr = low | (static_cast<std::uint32_t>(byteAt(offset + 2)) << 16)
+                                | (static_cast<std::uint32_t>(byteAt(offset + 3)) << 24);
+                }
+                out.encoding = (length == 2) ? low : out.instr;
+                return true;
+            }
+            offset += length;
+        }
+    }
+
+    void FetchUnit::pop(unsigned int n) {
+        for (unsigned int i = 0; i < n && count >= 2; i++) {
+            unsigned int length = (byteAt(0) & 3) == 3 ? 4 : 2;
+            if (length == 2) {
+                counters.compressed++;
+            } else {
+                counters.uncompressed++;
+                if (head_pc / block_bytes != (head_pc + 3) / block_bytes) {
+                    counters.straddles++;
+                }
+            }
+            head = (head + length) % static_cast<unsigned int>(queue.size());
+            count -= length;
+            head_pc += length;
+        }
+    }
+
+    bool FetchUnit::take(Slot &out) {
+        if (peek(out)) {
+            pop();
+            return true;
+        }
+        if (count == 0) {
+            counters.empty_bubbles++;
+        } else {
+            counters.straddle_bubbles++;
+        }
+        return false;
+    }
+
+    void FetchUnit::printStats(std::ostream &os) const {
+        os << "  Fetch blocks: " << counters.blocks << " (" << block_bytes << " B, "
+           << counters.bytes << " B read)\n";
+        os << "  RVC / 32-bit: " << counters.compressed << " / " << counters.uncompressed
+           << " (" << counters.straddles << " straddling)\n";
+        os << "  Fetch bubbles: " << counters.empty_bubbles + counters.straddle_bubbles
+           << " (empty " << counters.empty_bubbles << ", straddle " << counters.straddle_bubbles << ")\n";
+        os << "  Queue full:   " << counters.full_cycles << " cycles\n";
+        os << "  Redirects:    " << counters.redirects << " (" << counters.discarded_bytes
+           << " B discarded)\n";
+    }
+
+    std::uint32_t FetchUnit::expand(std::uint16_t c, bool rv64) {
+        const std::uint32_t rdp = 8 + bits(c, 4, 2);        // rd' / rs2'
+        const std::uint32_t rs1p = 8 + bits(c, 9, 7);       // rs1' / rd'
+        const std::uint32_t rd = bits(c, 11, 7);
+        const std::uint32_t rs2 = bits(c, 6, 2);
+        const std::int32_t imm6 = sext((bits(c, 12, 12) << 5) | bits(c, 6, 2), 6);
+        const std::uint32_t shamt = (bits(c, 12, 12) << 5) | bits(c, 6, 2);
+
+        switch ((bits(c, 1, 0) << 3) | bits(c, 15, 13)) {
+            /* quadrant 0 */
+            case 0b00000: {
+                std::uint32_t nzuimm = (bits(c, 12, 11) << 4) | (bits(c, 10, 7) << 6) | (bits(c, 6, 6) << 2)
+                                       | (bits(c, 5, 5) << 3);
+                return nzuimm == 0 ? 0 : itype(static_cast<std::int32_t>(nzuimm), 2, 0, rdp, OP_IMM);
+            }
+            case 0b00010: {
+                std::uint32_t uimm = (bits(c, 12, 10) << 3) | (bits(c, 6, 6) << 2) | (bits(c, 5, 5) << 6);
+                return itype(static_cast<std::int32_t>(uimm), rs1p, 2, rdp, OP_LOAD);
+            }
+            case 0b00001: {
+                std::uint32_t uimm = (bits(c, 12, 10) << 3) | (bits(c, 6, 5) << 6);
+                return itype(static_cast<std::int32_t>(uimm), rs1p, 3, rdp, OP_LOAD_FP);
+            }
+            case 0b00011: {
+                if (!rv64) {
+                    std::uint32_t uimm = (bits(c, 12, 10) << 3) | (bits(c, 6, 6) << 2) | (bits(c, 5, 5) << 6);
+                    return itype(static_cast<std::int32_t>(uimm), rs1p, 2, rdp, OP_LOAD_FP);
+                }
+                std::uint32_t uimm = (bits(c, 12, 10) << 3) | (bits(c, 6, 5) << 6);
+                return itype(static_cast<std::int32_t>(uimm), rs1p, 3, rdp, OP_LOAD);
+            }
+            case 0b00100: {
+                /* Zcb byte and halfword loads/stores */
+                std::uint32_t uimm = (bits(c, 5, 5) << 1) | bits(c, 6, 6);
+                switch (bits(c, 12, 10)) {
+                    case 0b000:
+                        return itype(static_cast<std::int32_t>(uimm), rs1p, 4, rdp, OP_LOAD);
+                    case 0b001:
+                        return itype(static_cast<std::int32_t>(uimm & 2), rs1p, bits(c, 6, 6) ? 1 : 5, rdp, OP_LOAD);
+                    case 0b010:
+                        return stype(uimm, rdp, rs1p, 0);
+                    case 0b011:
+                        return bits(c, 6, 6) ? 0 : stype(uimm, rdp, rs1p, 1);
+                    default:
+                        return 0;
+                }
+            }
+            case 0b00101: {
+                std::uint32_t uimm = (bits(c, 12, 10) << 3) | (bits(c, 6, 5) << 6);
+                return stype(uimm, rdp, rs1p, 3, OP_STORE_FP);
+            }
+            case 0b00110: {
+                std::uint32_t uimm = (bits(c, 12, 10) << 3) | (bits(c, 6, 6) << 2) | (bits(c, 5, 5) << 6);
+                return stype(uimm, rdp, rs1p, 2);
+            }
+            case 0b00111: {
+                if (!rv64) {
+                    std::uint32_t uimm = (bits(c, 12, 10) << 3) | (bits(c, 6, 6) << 2) | (bits(c, 5, 5) << 6);
+                    return stype(uimm, rdp, rs1p, 2, OP_STORE_FP);
+                }
+                std::uint32_t uimm = (bits(c, 12, 10) << 3) | (bits(c, 6, 5) << 6);
+                return stype(uimm, rdp, rs1p, 3);
+            }
+
+            /* quadrant 1 */
+            case 0b01000:
+                return itype(imm6, rd, 0, rd, OP_IMM);
+            case 0b01001:
+                if (!rv64) {
+                    return jtype(cjOffset(c), 1);
+                }
+                return rd == 0 ? 0 : itype(imm6, rd, 0, rd, OP_IMM_32);
+            case 0b01010:
+                return itype(imm6, 0, 0, rd, OP_IMM);
+            case 0b01011:
+                if (rd == 2) {
+                    std::uint32_t nzimm = (bits(c, 12, 12) << 9) | (bits(c, 6, 6) << 4) | (bits(c, 5, 5) << 6)
+                                          | (bits(c, 4, 3) << 7) | (bits(c, 2, 2) << 5);
+                    return nzimm == 0 ? 0 : itype(sext(nzimm, 10), 2, 0, 2, OP_IMM);
+                }
+                if (imm6 == 0) {
+                    return 0;
+                }
+                return (static_cast<std::uint32_t>(imm6) << 12) | (rd << 7) | OP_LUI;
+            case 0b01100:
+                switch (bits(c, 11, 10)) {
+                    case 0b00:
+                    case 0b01:
+                        if (!rv64 && bits(c, 12, 12)) {
+                            return 0;
+                        }
+                        return itype(static_cast<std::int32_t>(shamt | (bits(c, 10, 10) << 10)), rs1p, 5, rs1p,
+                                     OP_IMM);
+                    case 0b10:
+                        return itype(imm6, rs1p, 7, rs1p, OP_IMM);
+                    default: {
+                        static constexpr std::uint32_t f3[4] = {0, 4, 6, 7};
+                        std::uint32_t op = bits(c, 6, 5);
+                        if (!bits(c, 12, 12)) {
+                            return rtype(op == 0 ? 0x20 : 0, rdp, rs1p, f3[op], rs1p, OP_REG);
+                        }
+                        if (op < 2) {
+                            return rv64 ? rtype(op == 0 ? 0x20 : 0, rdp, rs1p, 0, rs1p, OP_REG_32) : 0;
+                        }
+                        if (op == 2) {
+                            return rtype(0x01, rdp, rs1p, 0, rs1p, OP_REG);     // c.mul
+                        }
+                        /* Zcb unary ops on rd'; the sign/zero extensions are Zbb instructions */
+                        switch (bits(c, 4, 2)) {
+                            case 0b000:
+                                return itype(0xFF, rs1p, 7, rs1p, OP_IMM);      // andi rd', rd', 0xff
+                            case 0b001:
+                                return itype(0x604, rs1p, 1, rs1p, OP_IMM);     // sext.b
+                            case 0b010:
+                                return rtype(0x04, 0, rs1p, 4, rs1p, rv64 ? OP_REG_32 : OP_REG);    // zext.h
+                            case 0b011:
+                                return itype(0x605, rs1p, 1, rs1p, OP_IMM);     // sext.h
+                            case 0b100:
+                                return rv64 ? rtype(0x04, 0, rs1p, 0, rs1p, OP_REG_32) : 0;     // add.uw rd', rd', x0
+                            case 0b101:
+                                return itype(-1, rs1p, 4, rs1p, OP_IMM);        // xori rd', rd', -1
+                            default:
+                                return 0;
+                        }
+                    }
+                }
+            case 0b01101:
+                return jtype(cjOffset(c), 0);
+            case 0b01110:
+            case 0b01111: {
+                std::uint32_t offset = (bits(c, 12, 12) << 8) | (bits(c, 11, 10) << 3) | (bits(c, 6, 5) << 6)
+                                       | (bits(c, 4, 3) << 1) | (bits(c, 2, 2) << 5);
+                return btype(sext(offset, 9), rs1p, bits(c, 13, 13));
+            }
+
+            /* quadrant 2 */
+            case 0b10000:
+                if (!rv64 && bits(c, 12, 12)) {
+                    return 0;
+                }
+                return itype(static_cast<std::int32_t>(shamt), rd, 1, rd, OP_IMM);
+            case 0b10001: {
+                std::uint32_t uimm = (bits(c, 12, 12) << 5) | (bits(c, 6, 5) << 3) | (bits(c, 4, 2) << 6);
+                return itype(static_cast<std::int32_t>(uimm), 2, 3, rd, OP_LOAD_FP);
+            }
+            case 0b10010: {
+                std::uint32_t uimm = (bits(c, 12, 12) << 5) | (bits(c, 6, 4) << 2) | (bits(c, 3, 2) << 6);
+                return rd == 0 ? 0 : itype(static_cast<std::int32_t>(uimm), 2, 2, rd, OP_LOAD);
+            }
+            case 0b10011: {
+                if (!rv64) {
+                    std::uint32_t uimm = (bits(c, 12, 12) << 5) | (bits(c, 6, 4) << 2) | (bits(c, 3, 2) << 6);
+                    return itype(static_cast<std::int32_t>(uimm), 2, 2, rd, OP_LOAD_FP);
+                }
+                std::uint32_t uimm = (bits(c, 12, 12) << 5) | (bits(c, 6, 5) << 3) | (bits(c, 4, 2) << 6);
+                return rd == 0 ? 0 : itype(static_cast<std::int32_t>(uimm), 2, 3, rd, OP_LOAD);
+            }
+            case 0b10100:
+                if (!bits(c, 12, 12)) {
+                    if (rs2 == 0) {
+                        return rd == 0 ? 0 : itype(0, rd, 0, 0, OP_JALR);
+                    }
+                    return rtype(0, rs2, 0, 0, rd, OP_REG);
+                }
+                if (rs2 == 0) {
+                    return rd == 0 ? EBREAK : itype(0, rd, 0, 1, OP_JALR);
+                }
+                return rtype(0, rs2, rd, 0, rd, OP_REG);
+            case 0b10101: {
+                /* Zcmp/Zcmt push/pop and table jumps have no single 32-bit equivalent */
+                if (CodeSizeExtensions::active()) {
+                    return 0;
+                }
+                std::uint32_t uimm = (bits(c, 12, 10) << 3) | (bits(c, 9, 7) << 6);
+                return stype(uimm, rs2, 2, 3, OP_STORE_FP);
+            }
+            case 0b10110: {
+                std::uint32_t uimm = (bits(c, 12, 9) << 2) | (bits(c, 8, 7) << 6);
+                return stype(uimm, rs2, 2, 2);
+            }
+            case 0b10111: {
+                if (!rv64) {
+                    std::uint32_t uimm = (bits(c, 12, 9) << 2) | (bits(c, 8, 7) << 6);
+                    return stype(uimm, rs2, 2, 2, OP_STORE_FP);
+                }
+                std::uint32_t uimm = (bits(c, 12, 10) << 3) | (bits(c, 9, 7) << 6);
+                return stype(uimm, rs2, 2, 3);
+            }
+            default:
+                return 0;
+        }
+    }
+
+    bool FetchUnit::isSequence(std::uint16_t c) {
+        return CodeSizeExtensions::active() && (c & 0xE003) == 0xA002;
+    }
+
+    unsigned int FetchUnit::crack(std::uint16_t c, bool rv64, std::uint32_t *uops) {
+        if (!isSequence(c)) {
+            return 0;
+        }
+
+        const std::uint32_t xlen_bytes = rv64 ? 8 : 4;
+        const std::uint32_t f3 = rv64 ? 3 : 2;      // sd / ld, sw / lw
+        unsigned int n_uops = 0;
+
+        switch (bits(c, 12, 10)) {
+            case C_6_MV: {
+                auto sreg = [](std::uint32_t v) { return v < 2 ? v + 8 : v + 16; };
+                const std::uint32_t r1s = sreg(bits(c, 9, 7));
+                const std::uint32_t r2s = sreg(bits(c, 4, 2));
+                switch (bits(c, 6, 5)) {
+                    case 0b01:      // cm.mvsa01
+                        if (r1s == r2s) {
+                            return 0;
+                        }
+                        uops[n_uops++] = itype(0, 10, 0, r1s, OP_IMM);
+                        uops[n_uops++] = itype(0, 11, 0, r2s, OP_IMM);
+                        return n_uops;
+                    case 0b11:      // cm.mva01s
+                        uops[n_uops++] = itype(0, r1s, 0, 10, OP_IMM);
+                        uops[n_uops++] = itype(0, r2s, 0, 11, OP_IMM);
+                        return n_uops;
+                    default:
+                        return 0;
+                }
+            }
+            case C_6_PUSHPOP:
+            case C_6_POPRET: {
+                /* ra lowest and the highest s register at the top of the frame, as C_extension stores them */
+                static constexpr std::uint32_t order[13] = {1, 8, 9, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27};
+                const bool ret = bits(c, 12, 10) == C_6_POPRET;
+                const bool push = !ret && bits(c, 9, 8) == 0b00;
+                const bool zero_a0 = ret && bits(c, 9, 8) == 0b00;
+                const std::uint32_t rlist = bits(c, 7, 4);
+                if ((bits(c, 9, 8) != 0b00 && bits(c, 9, 8) != 0b10) || rlist < 4) {
+                    return 0;
+                }
+
+                const std::uint32_t n = rlist == 15 ? 13 : rlist - 3;
+                const std::uint32_t frame = (n * xlen_bytes + 15) & ~15u;
+                const std::int32_t stack_adj = static_cast<std::int32_t>(frame + bits(c, 3, 2) * 16);
+                /* offset from the sp the sequence starts with to the lowest saved register */
+                const std::int32_t base = (push ? 0 : stack_adj) - static_cast<std::int32_t>(n * xlen_bytes);
+
+                for (std::uint32_t k = 0; k < n; k++) {
+                    const std::int32_t offset = base + static_cast<std::int32_t>(k * xlen_bytes);
+                    uops[n_uops++] = push ? stype(static_cast<std::uint32_t>(offset), order[k], 2, f3)
+                                          : itype(offset, 2, f3, order[k], OP_LOAD);
+                }
+                uops[n_uops++] = itype(push ? -stack_adj : stack_adj, 2, 0, 2, OP_IMM);
+                if (zero_a0) {
+                    uops[n_uops++] = itype(0, 0, 0, 10, OP_IMM);
+                }
+                if (ret) {
+                    uops[n_uops++] = itype(0, 1, 0, 0, OP_JALR);
+                }
+                return n_uops;
+            }
+            default:
+                return 0;
+        }
+    }
+
+    int FetchUnit::tableJumpIndex(std::uint16_t c) {
+        if (!isSequence(c) || bits(c, 12, 10) != C_6_JT) {
+            return -1;
+        }
+        return static_cast<int>(bits(c, 9, 2));
+    }
+}
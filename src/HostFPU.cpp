@@ -0,0 +1,834 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file HostFPU.cpp
+ * @brief RISC-V F/D arithmetic on the host FPU, with soft-float fix-ups
+ *
+ * Built with -frounding-math -ffp-contract=off (see CMakeLists.txt): the
+ * compiler must neither fold operations under the default rounding mode nor
+ * fuse the separate multiply and add of the host code paths.
+ */
+
+#include "HostFPU.h"
+
+#include <cfenv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define RVVP_HOST_MXCSR 1
+#endif
+
+namespace riscv_tlm {
+
+namespace {
+
+template<typename F>
+struct Format;
+
+template<>
+struct Format<float> {
+    using Bits = std::uint32_t;
+    static constexpr int MANT = 23;
+    static constexpr int BIAS = 127;
+};
+
+template<>
+struct Format<double> {
+    using Bits = std::uint64_t;
+    static constexpr int MANT = 52;
+    static constexpr int BIAS = 1023;
+};
+
+template<typename F>
+struct Fmt : Format<F> {
+    using Bits = typename Format<F>::Bits;
+    using Format<F>::MANT;
+    using Format<F>::BIAS;
+
+    static constexpr int WIDTH = sizeof(F) * 8;
+    static constexpr Bits SIGN = Bits(1) << (WIDTH - 1);
+    static constexpr Bits MANT_MASK = (Bits(1) << MANT) - 1;
+    static constexpr Bits EXP_MASK = ~SIGN & ~MANT_MASK;
+    static constexpr Bits QUIET = Bits(1) << (MANT - 1);
+    static constexpr int MAX_BIASED = 2 * BIAS + 1;     ///< exponent field of Inf/NaN
+    static constexpr int EMIN_LSB = 1 - BIAS - MANT;    ///< weight of the subnormal LSB
+
+    static bool isNaN(Bits b) {
+        return (b & EXP_MASK) == EXP_MASK && (b & MANT_MASK) != 0;
+    }
+
+    static bool isSNaN(Bits b) {
+        return isNaN(b) && (b & QUIET) == 0;
+    }
+
+    static bool isInf(Bits b) {
+        return (b & ~SIGN) == EXP_MASK;
+    }
+
+    static bool isZero(Bits b) {
+        return (b & ~SIGN) == 0;
+    }
+
+    static F toFloat(Bits b) {
+        F f;
+        std::memcpy(&f, &b, sizeof(f));
+        return f;
+    }
+
+    static Bits toBits(F f) {
+        Bits b;
+        std::memcpy(&b, &f, sizeof(b));
+        return b;
+    }
+
+    /** RISC-V never propagates NaN payloads */
+    static Bits canonical(F f) {
+        Bits b = toBits(f);
+        return isNaN(b) ? HostFPU<F>::CANONICAL_NAN : b;
+    }
+};
+
+/**
+ * @brief Hide a value from the optimizer so the host operation stays between
+ *        installing the guest rounding mode and reading back the flags
+ */
+template<typename V>
+inline V opaque(V v) {
+#if defined(__GNUC__)
+    __asm__ __volatile__("" : "+m"(v));
+    return v;
+#else
+    volatile V t = v;
+    return t;
+#endif
+}
+
+/**
+ * @brief Guest rounding mode with clear exception flags for the lifetime of
+ *        the object; the host environment is restored on destruction
+ *
+ * RMM is run as RNE: the two only differ on exact ties, which the callers
+ * resolve in software.
+ */
+class GuestFPEnv {
+public:
+    explicit GuestFPEnv(unsigned int rm) {
+#ifdef RVVP_HOST_MXCSR
+        saved = _mm_getcsr();
+        _mm_setcsr((saved & ~(MXCSR_FLAGS | MXCSR_RC | MXCSR_DAZ | MXCSR_FTZ)) | roundingBits(rm));
+#else
+        std::feholdexcept(&saved);
+        std::fesetround(hostRounding(rm));
+#endif
+    }
+
+    ~GuestFPEnv() {
+#ifdef RVVP_HOST_MXCSR
+        _mm_setcsr(saved);
+#else
+        std::fesetenv(&saved);
+#endif
+    }
+
+    GuestFPEnv(const GuestFPEnv &) = delete;
+    GuestFPEnv &operator=(const GuestFPEnv &) = delete;
+
+    /**
+     * @brief Host exceptions raised so far, as fflags bits
+     */
+    unsigned int flags() const {
+        unsigned int fl = 0;
+#ifdef RVVP_HOST_MXCSR
+        unsigned int csr = _mm_getcsr();
+        fl |= (csr & 0x01) ? FFLAG_NV : 0;  // IE
+        fl |= (csr & 0x04) ? FFLAG_DZ : 0;  // ZE
+        fl |= (csr & 0x08) ? FFLAG_OF : 0;  // OE
+        fl |= (csr & 0x10) ? FFLAG_UF : 0;  // UE
+        fl |= (csr & 0x20) ? FFLAG_NX : 0;  // PE
+#else
+        int ex = std::fetestexcept(FE_ALL_EXCEPT);
+        fl |= (ex & FE_INVALID) ? FFLAG_NV : 0;
+        fl |= (ex & FE_DIVBYZERO) ? FFLAG_DZ : 0;
+        fl |= (ex & FE_OVERFLOW) ? FFLAG_OF : 0;
+        fl |= (ex & FE_UNDERFLOW) ? FFLAG_UF : 0;
+        fl |= (ex & FE_INEXACT) ? FFLAG_NX : 0;
+#endif
+        return fl;
+    }
+
+private:
+#ifdef RVVP_HOST_MXCSR
+    static constexpr unsigned int MXCSR_FLAGS = 0x003F;
+    static constexpr unsigned int MXCSR_DAZ = 0x0040;
+    static constexpr unsigned int MXCSR_RC = 0x6000;
+    static constexpr unsigned int MXCSR_FTZ = 0x8000;
+
+    static unsigned int roundingBits(unsigned int rm) {
+        switch (rm) {
+            case FRM_RTZ:
+                return 0x6000;
+            case FRM_RDN:
+                return 0x2000;
+            case FRM_RUP:
+                return 0x4000;
+            default:
+                return 0x0000;
+        }
+    }
+
+    unsigned int saved;
+#else
+    static int hostRounding(unsigned int rm) {
+        switch (rm) {
+            case FRM_RTZ:
+                return FE_TOWARDZERO;
+            case FRM_RDN:
+                return FE_DOWNWARD;
+            case FRM_RUP:
+                return FE_UPWARD;
+            default:
+                return FE_TONEAREST;
+        }
+    }
+
+    std::fenv_t saved;
+#endif
+};
+
+/* --- soft-float rounding ---------------------------------------------------- */
+
+/**
+ * @brief Minimal unsigned 128-bit integer for the exact fma intermediate
+ */
+struct U128 {
+    std::uint64_t hi{0};
+    std::uint64_t lo{0};
+
+    bool isZero() const {
+        return (hi | lo) == 0;
+    }
+
+    int msb() const {
+        for (int i = 63; i >= 0; i--) {
+            if ((hi >> i) & 1) {
+                return i + 64;
+            }
+        }
+        for (int i = 63; i >= 0; i--) {
+            if ((lo >> i) & 1) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    bool bit(int n) const {
+        if (n < 0 || n > 127) {
+            return false;
+        }
+        return n >= 64 ? (hi >> (n - 64)) & 1 : (lo >> n) & 1;
+    }
+
+    /** true if any bit below position n is set */
+    bool anyBelow(int n) const {
+        if (n <= 0) {
+            return false;
+        }
+        if (n >= 128) {
+            return !isZero();
+        }
+        if (n >= 64) {
+            return lo != 0 || (n > 64 && (hi & ((~0ULL) >> (128 - n))) != 0);
+        }
+        return (lo & ((~0ULL) >> (64 - n))) != 0;
+    }
+
+    U128 shl(int n) const {
+        U128 r;
+        if (n >= 128) {
+            return r;
+        } else if (n >= 64) {
+            r.hi = lo << (n - 64);
+        } else if (n > 0) {
+            r.hi = (hi << n) | (lo >> (64 - n));
+            r.lo = lo << n;
+        } else {
+            r = *this;
+        }
+        return r;
+    }
+
+    U128 shr(int n) const {
+        U128 r;
+        if (n >= 128) {
+            return r;
+        } else if (n >= 64) {
+            r.lo = hi >> (n - 64);
+        } else if (n > 0) {
+            r.lo = (lo >> n) | (hi << (64 - n));
+            r.hi = hi >> n;
+        } else {
+            r = *this;
+        }
+        return r;
+    }
+
+    /** shift right, OR-ing any bit shifted out into the LSB */
+    U128 shrJam(int n) const {
+        U128 r = shr(n);
+        r.lo |= anyBelow(n) ? 1 : 0;
+        return r;
+    }
+
+    U128 operator+(const U128 &o) const {
+        U128 r;
+        r.lo = lo + o.lo;
+        r.hi = hi + o.hi + (r.lo < lo ? 1 : 0);
+        return r;
+    }
+
+    U128 operator-(const U128 &o) const {
+        U128 r;
+        r.lo = lo - o.lo;
+        r.hi = hi - o.hi - (lo < o.lo ? 1 : 0);
+        return r;
+    }
+
+    bool operator<(const U128 &o) const {
+        return hi != o.hi ? hi < o.hi : lo < o.lo;
+    }
+
+    static U128 mul(std::uint64_t a, std::uint64_t b) {
+        std::uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+        std::uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+        std::uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+        std::uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+        U128 r;
+        r.lo = (mid << 32) | (ll & 0xFFFFFFFF);
+        r.hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+        return r;
+    }
+};
+
+/**
+ * @brief Round sig >> s (a magnitude) to an integer according to rm
+ * @return rounded quotient, small enough for 64 bits in all callers
+ */
+inline std::uint64_t roundShift(const U128 &sig, int s, bool negative, unsigned int rm, bool &inexact) {
+    if (s <= 0) {
+        inexact = false;
+        return sig.shl(-s).lo;
+    }
+
+    std::uint64_t q = sig.shr(s).lo;
+    bool round = sig.bit(s - 1);
+    bool sticky = sig.anyBelow(s - 1);
+    bool inc;
+
+    inexact = round || sticky;
+    switch (rm) {
+        case FRM_RNE:
+            inc = round && (sticky || (q & 1));
+            break;
+        case FRM_RMM:
+            inc = round;
+            break;
+        case FRM_RDN:
+            inc = negative && inexact;
+            break;
+        case FRM_RUP:
+            inc = !negative && inexact;
+            break;
+        default:
+            inc = false;
+            break;
+    }
+    return q + (inc ? 1 : 0);
+}
+
+/**
+ * @brief Round and encode (-1)^negative * sig * 2^exp, sig != 0
+ *
+ * Tininess is detected after rounding, as RISC-V specifies.
+ */
+template<typename F>
+typename Fmt<F>::Bits roundPack(bool negative, int exp, const U128 &sig, unsigned int rm,
+                                unsigned int &flags) {
+    using Fm = Fmt<F>;
+    using Bits = typename Fm::Bits;
+    constexpr int P = Fm::MANT + 1;
+    constexpr int EMIN = 1 - Fm::BIAS;
+
+    Bits sign = negative ? Fm::SIGN : 0;
+    int msb_exp = exp + sig.msb();
+    int lsb = msb_exp - (P - 1);
+    bool inexact;
+
+    bool tiny = false;
+    if (msb_exp < EMIN) {
+        /* rounded with an unbounded exponent range, still below the normal range? */
+        std::uint64_t q = roundShift(sig, lsb - exp, negative, rm, inexact);
+        tiny = (q >> P) == 0 ? msb_exp < EMIN : msb_exp + 1 < EMIN;
+    }
+
+    if (lsb < Fm::EMIN_LSB) {
+        lsb = Fm::EMIN_LSB;
+    }
+    std::uint64_t q = roundShift(sig, lsb - exp, negative, rm, inexact);
+    if ((q >> P) != 0) {
+        q >>= 1;
+        lsb++;
+    }
+
+    if (inexact) {
+        flags |= FFLAG_NX | (tiny ? FFLAG_UF : 0);
+    }
+
+    if ((q >> (P - 1)) == 0) {
+        /* subnormal (or zero): lsb is EMIN_LSB, exponent field 0 */
+        return sign | static_cast<Bits>(q);
+    }
+
+    int biased = lsb + Fm::MANT + Fm::BIAS;
+    if (biased >= Fm::MAX_BIASED) {
+        flags |= FFLAG_OF | FFLAG_NX;
+        bool to_inf = rm == FRM_RNE || rm == FRM_RMM
+                      || (rm == FRM_RDN && negative) || (rm == FRM_RUP && !negative);
+        return sign | (to_inf ? Fm::EXP_MASK : Bits(Fm::EXP_MASK - 1));
+    }
+
+    return sign | (static_cast<Bits>(biased) << Fm::MANT) | (static_cast<Bits>(q) & Fm::MANT_MASK);
+}
+
+/**
+ * @brief Split a finite value into sign, integer significand and LSB weight
+ */
+template<typename F>
+void unpack(typename Fmt<F>::Bits b, bool &negative, int &exp, std::uint64_t &sig) {
+    using Fm = Fmt<F>;
+    int field = static_cast<int>((b & Fm::EXP_MASK) >> Fm::MANT);
+
+    negative = (b & Fm::SIGN) != 0;
+    sig = b & Fm::MANT_MASK;
+    if (field == 0) {
+        exp = Fm::EMIN_LSB;
+    } else {
+        sig |= std::uint64_t(1) << Fm::MANT;
+        exp = field - Fm::BIAS - Fm::MANT;
+    }
+}
+
+template<typename F>
+typename Fmt<F>::Bits minMax(bool is_max, typename Fmt<F>::Bits a, typename Fmt<F>::Bits b,
+                             unsigned int &flags) {
+    using Fm = Fmt<F>;
+
+    if (Fm::isSNaN(a) || Fm::isSNaN(b)) {
+        flags |= FFLAG_NV;
+    }
+    if (Fm::isNaN(a) && Fm::isNaN(b)) {
+        return HostFPU<F>::CANONICAL_NAN;
+    } else if (Fm::isNaN(a)) {
+        return b;
+    } else if (Fm::isNaN(b)) {
+        return a;
+    }
+
+    F x = Fm::toFloat(a), y = Fm::toFloat(b);
+    if (x == y) {
+        /* only +0/-0 compare equal with different encodings: -0 < +0 */
+        return is_max ? (a & b) : (a | b);
+    }
+    return ((x < y) != is_max) ? a : b;
+}
+
+/**
+ * @brief Round to an integral value in the guest rounding mode (exact, no flags)
+ */
+template<typename F>
+F roundIntegral(F x, unsigned int rm) {
+    switch (rm) {
+        case FRM_RTZ:
+            return std::trunc(x);
+        case FRM_RDN:
+            return std::floor(x);
+        case FRM_RUP:
+            return std::ceil(x);
+        case FRM_RMM:
+            return std::round(x);
+        default: {
+            F r = std::round(x);
+            if (std::fabs(r - x) == F(0.5)) {
+                r = 2 * std::round(x / 2);
+            }
+            return r;
+        }
+    }
+}
+
+/**
+ * @brief @p x / @p y times 2^QUOTIENT_SCALE, if that is exact
+ *
+ * A tiny quotient can fall exactly halfway between two subnormals. Such a tie
+ * has at most MANT + 2 significant bits, so scaled into the normal range it is
+ * representable and the scaled division raises no inexact flag.
+ */
+constexpr int QUOTIENT_SCALE = 64;
+
+template<typename F>
+bool exactScaledQuotient(F x, F y, F &q) {
+    GuestFPEnv env(FRM_RNE);
+    q = opaque(opaque(std::ldexp(x, QUOTIENT_SCALE)) / opaque(y));
+    return (env.flags() & FFLAG_NX) == 0;
+}
+
+} // anonymous namespace
+
+template<typename F>
+typename HostFPU<F>::Bits HostFPU<F>::arith(FPArith op, Bits a, Bits b, unsigned int rm,
+                                            unsigned int &flags) {
+    using Fm = Fmt<F>;
+
+    if (op == FPArith::Min || op == FPArith::Max) {
+        return minMax<F>(op == FPArith::Max, a, b, flags);
+    }
+
+    F x = Fm::toFloat(a), y = Fm::toFloat(b), r;
+    unsigned int fl;
+    {
+        GuestFPEnv env(rm);
+        x = opaque(x);
+        y = opaque(y);
+        switch (op) {
+            case FPArith::Add:
+                r = x + y;
+                break;
+            case FPArith::Sub:
+                r = x - y;
+                break;
+            case FPArith::Mul:
+                r = x * y;
+                break;
+            case FPArith::Div:
+                r = x / y;
+                break;
+            default:
+                r = std::sqrt(x);
+                break;
+        }
+        r = opaque(r);
+        fl = env.flags();
+    }
+
+    /*
+     * RMM differs from RNE only on exact ties. A square root is never exactly
+     * halfway between two floating-point numbers; a quotient can be, but only
+     * at subnormal spacing, so division takes the soft path when it is tiny.
+     */
+    if (rm == FRM_RMM && (fl & FFLAG_NX) && !(fl & FFLAG_OF)) {
+        const Bits one = Fm::toBits(F(1));
+        F q;
+        switch (op) {
+            case FPArith::Add:
+                flags |= fl & ~(FFLAG_NX | FFLAG_UF);
+                return softFma(a, one, b, rm, flags);
+            case FPArith::Sub:
+                flags |= fl & ~(FFLAG_NX | FFLAG_UF);
+                return softFma(a, one, b ^ Fm::SIGN, rm, flags);
+            case FPArith::Mul:
+                flags |= fl & ~(FFLAG_NX | FFLAG_UF);
+                return softFma(a, b, Fm::SIGN, rm, flags);
+            case FPArith::Div:
+                /* an exact scaled quotient is rounded back down by a multiply */
+                if (std::fabs(r) <= std::numeric_limits<F>::min() && exactScaledQuotient(x, y, q)) {
+                    flags |= fl & ~(FFLAG_NX | FFLAG_UF);
+                    return softFma(Fm::toBits(q), Fm::toBits(std::ldexp(F(1), -QUOTIENT_SCALE)), Fm::SIGN, rm,
+                                   flags);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    flags |= fl;
+    return Fm::canonical(r);
+}
+
+template<typename F>
+typename HostFPU<F>::Bits HostFPU<F>::fma(Bits a, Bits b, Bits c, bool negate_product,
+                                          bool negate_addend, unsigned int rm,
+                                          unsigned int &flags) {
+    using Fm = Fmt<F>;
+
+    /* invalid even when the addend is a quiet NaN; hosts differ here */
+    if ((Fm::isInf(a) && Fm::isZero(b)) || (Fm::isZero(a) && Fm::isInf(b))) {
+        flags |= FFLAG_NV;
+        return CANONICAL_NAN;
+    }
+
+    if (negate_product) {
+        a ^= Fm::SIGN;
+    }
+    if (negate_addend) {
+        c ^= Fm::SIGN;
+    }
+
+    F x = Fm::toFloat(a), y = Fm::toFloat(b), z = Fm::toFloat(c), r;
+    unsigned int fl;
+    {
+        GuestFPEnv env(rm);
+        x = opaque(x);
+        y = opaque(y);
+        z = opaque(z);
+        r = std::fma(x, y, z);
+        r = opaque(r);
+        fl = env.flags();
+    }
+
+    if (rm == FRM_RMM && (fl & FFLAG_NX) && !(fl & FFLAG_OF)) {
+        flags |= fl & ~(FFLAG_NX | FFLAG_UF);
+        return softFma(a, b, c, rm, flags);
+    }
+
+    flags |= fl;
+    return Fm::canonical(r);
+}
+
+template<typename F>
+typename HostFPU<F>::Bits HostFPU<F>::softFma(Bits a, Bits b, Bits c, unsigned int rm,
+                                              unsigned int &flags) {
+    using Fm = Fmt<F>;
+    constexpr int TOP = 125;
+
+    bool sa, sb, sc;
+    int ea, eb, ec;
+    std::uint64_t ma, mb, mc;
+    unpack<F>(a, sa, ea, ma);
+    unpack<F>(b, sb, eb, mb);
+    unpack<F>(c, sc, ec, mc);
+
+    U128 x = U128::mul(ma, mb);
+    U128 y;
+    y.lo = mc;
+    bool sx = sa != sb;
+    bool sy = sc;
+    int ex = ea + eb;
+    int ey = ec;
+
+    if (x.isZero() || y.isZero()) {
+        if (x.isZero() && y.isZero()) {
+            /* exact zero sum: -0 only if both are -0, or when rounding down */
+            bool neg = (sx && sy) || (sx != sy && rm == FRM_RDN);
+            return neg ? Fm::SIGN : 0;
+        }
+        return x.isZero() ? roundPack<F>(sy, ey, y, rm, flags)
+                          : roundPack<F>(sx, ex, x, rm, flags);
+    }
+
+    /* align both at bit TOP; the smaller term is shifted right with jamming */
+    int sh = TOP - x.msb();
+    x = x.shl(sh);
+    ex -= sh;
+    sh = TOP - y.msb();
+    y = y.shl(sh);
+    ey -= sh;
+
+    if (ex < ey) {
+        std::swap(x, y);
+        std::swap(ex, ey);
+        std::swap(sx, sy);
+    }
+    y = y.shrJam(ex - ey);
+
+    U128 sum;
+    bool negative = sx;
+    if (sx == sy) {
+        sum = x + y;
+    } else if (y < x) {
+        sum = x - y;
+    } else {
+        sum = y - x;
+        negative = sy;
+    }
+
+    if (sum.isZero()) {
+        return rm == FRM_RDN ? Fm::SIGN : 0;
+    }
+    return roundPack<F>(negative, ex, sum, rm, flags);
+}
+
+template<typename F>
+bool HostFPU<F>::compare(FPCompare op, Bits a, Bits b, unsigned int &flags) {
+    using Fm = Fmt<F>;
+
+    if (Fm::isNaN(a) || Fm::isNaN(b)) {
+        if (op != FPCompare::Eq || Fm::isSNaN(a) || Fm::isSNaN(b)) {
+            flags |= FFLAG_NV;
+        }
+        return false;
+    }
+
+    F x = Fm::toFloat(a), y = Fm::toFloat(b);
+    switch (op) {
+        case FPCompare::Eq:
+            return x == y;
+        case FPCompare::Lt:
+            return x < y;
+        default:
+            return x <= y;
+    }
+}
+
+template<typename F>
+unsigned int HostFPU<F>::classify(Bits a) {
+    using Fm = Fmt<F>;
+    bool negative = (a & Fm::SIGN) != 0;
+    Bits exp = a & Fm::EXP_MASK;
+    Bits mant = a & Fm::MANT_MASK;
+
+    if (exp == Fm::EXP_MASK) {
+        if (mant == 0) {
+            return negative ? 1u << 0 : 1u << 7;
+        }
+        return (mant & Fm::QUIET) ? 1u << 9 : 1u << 8;
+    }
+    if (exp == 0) {
+        if (mant == 0) {
+            return negative ? 1u << 3 : 1u << 4;
+        }
+        return negative ? 1u << 2 : 1u << 5;
+    }
+    return negative ? 1u << 1 : 1u << 6;
+}
+
+template<typename F>
+std::uint64_t HostFPU<F>::toInt(Bits a, bool is_signed, unsigned int width, unsigned int rm,
+                                unsigned int &flags) {
+    using Fm = Fmt<F>;
+
+    std::uint64_t max_val, min_val;
+    if (is_signed) {
+        max_val = (std::uint64_t(1) << (width - 1)) - 1;
+        min_val = ~max_val;
+    } else {
+        max_val = width == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << width) - 1;
+        min_val = 0;
+    }
+
+    std::uint64_t result;
+    if (Fm::isNaN(a)) {
+        flags |= FFLAG_NV;
+        result = max_val;
+    } else {
+        F x = Fm::toFloat(a);
+        F r = roundIntegral(x, rm);
+        F lo = is_signed ? -std::ldexp(F(1), width - 1) : F(0);
+        F hi = std::ldexp(F(1), is_signed ? width - 1 : width);
+
+        if (r < lo || r >= hi) {
+            flags |= FFLAG_NV;
+            result = r < 0 ? min_val : max_val;
+        } else {
+            if (r != x) {
+                flags |= FFLAG_NX;
+            }
+            result = is_signed ? static_cast<std::uint64_t>(static_cast<std::int64_t>(r))
+                               : static_cast<std::uint64_t>(r);
+        }
+    }
+
+    if (width == 32) {
+        result = static_cast<std::uint64_t>(static_cast<std::int64_t>(static_cast<std::int32_t>(result)));
+    }
+    return result;
+}
+
+template<typename F>
+typename HostFPU<F>::Bits HostFPU<F>::fromInt(std::uint64_t v, bool is_signed, unsigned int width,
+                                              unsigned int rm, unsigned int &flags) {
+    using Fm = Fmt<F>;
+
+    F r;
+    unsigned int fl;
+    {
+        GuestFPEnv env(rm);
+        v = opaque(v);
+        if (width == 32) {
+            r = is_signed ? static_cast<F>(static_cast<std::int32_t>(v))
+                          : static_cast<F>(static_cast<std::uint32_t>(v));
+        } else {
+            r = is_signed ? static_cast<F>(static_cast<std::int64_t>(v)) : static_cast<F>(v);
+        }
+        r = opaque(r);
+        fl = env.flags();
+    }
+
+    if (rm == FRM_RMM && (fl & FFLAG_NX)) {
+        std::uint64_t mag = v;
+        bool negative = false;
+        if (width == 32) {
+            mag &= 0xFFFFFFFF;
+        }
+        if (is_signed) {
+            std::int64_t s = width == 32 ? static_cast<std::int32_t>(v) : static_cast<std::int64_t>(v);
+            negative = s < 0;
+            mag = negative ? 0 - static_cast<std::uint64_t>(s) : static_cast<std::uint64_t>(s);
+        }
+        U128 sig;
+        sig.lo = mag;
+        return roundPack<F>(negative, 0, sig, rm, flags);
+    }
+
+    flags |= fl;
+    return Fm::toBits(r);
+}
+
+std::uint32_t fpNarrow(std::uint64_t a, unsigned int rm, unsigned int &flags) {
+    using Fd = Fmt<double>;
+
+    if (Fd::isNaN(a)) {
+        flags |= Fd::isSNaN(a) ? FFLAG_NV : 0;
+        return HostFPU<float>::CANONICAL_NAN;
+    }
+
+    double x = Fd::toFloat(a);
+    float r;
+    unsigned int fl;
+    {
+        GuestFPEnv env(rm);
+        x = opaque(x);
+        r = static_cast<float>(x);
+        r = opaque(r);
+        fl = env.flags();
+    }
+
+    if (rm == FRM_RMM && (fl & FFLAG_NX) && !(fl & FFLAG_OF)) {
+        bool negative;
+        int exp;
+        U128 sig;
+        unpack<double>(a, negative, exp, sig.lo);
+        return roundPack<float>(negative, exp, sig, rm, flags);
+    }
+
+    flags |= fl;
+    return Fmt<float>::toBits(r);
+}
+
+std::uint64_t fpWiden(std::uint32_t a, unsigned int &flags) {
+    using Fs = Fmt<float>;
+
+    if (Fs::isNaN(a)) {
+        flags |= Fs::isSNaN(a) ? FFLAG_NV : 0;
+        return HostFPU<double>::CANONICAL_NAN;
+    }
+    return Fmt<double>::toBits(static_cast<double>(Fs::toFloat(a)));
+}
+
+template class HostFPU<float>;
+template class HostFPU<double>;
+
+} // namespace riscv_tlm
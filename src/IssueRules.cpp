@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file IssueRules.cpp
+ * @brief Instruction classes, pairing check and pairing statistics
+ */
+
+#include "IssueRules.h"
+
+#include <sstream>
+
+namespace riscv_tlm {
+
+    PairingRules PairingRules::s_defaults;
+
+    namespace {
+        const char *const class_names[ISSUE_CLASSES] = {"alu", "mul", "load", "store", "branch", "system"};
+
+        const char *const reason_names[PAIR_REASONS] = {
+                "paired", "single", "raw", "waw", "pipe", "excluded", "control", "system", "hazard", "rob"};
+
+        bool classOf(const std::string &name, IssueClass &cls) {
+            for (unsigned int i = 0; i < ISSUE_SYSTEM; i++) {
+                if (name == class_names[i]) {
+                    cls = static_cast<IssueClass>(i);
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    IssueOp IssueOp::fromDecode(std::uint8_t opcode, std::uint8_t funct3, std::uint8_t funct7,
+                                std::uint8_t rd, std::uint8_t rs1, std::uint8_t rs2) {
+        IssueOp op;
+        op.rd = rd;
+        switch (opcode) {
+            case 0x33:  // OP: M and clmul/clmulr/clmulh use the multiplier
+            case 0x3B:  // OP-32
+                op.cls = funct7 == 0x01 || (opcode == 0x33 && funct7 == 0x05 && funct3 >= 0x1 && funct3 <= 0x3)
+                         ? ISSUE_MUL : ISSUE_ALU;
+                op.rs1 = rs1;
+                op.rs2 = rs2;
+                break;
+            case 0x13:  // OP-IMM
+            case 0x1B:  // OP-IMM-32
+                op.rs1 = rs1;
+                break;
+            case 0x03:  // LOAD
+                op.cls = ISSUE_LOAD;
+                op.rs1 = rs1;
+                break;
+            case 0x23:  // STORE
+                op.cls = ISSUE_STORE;
+                op.rd = 0;
+                op.rs1 = rs1;
+                op.rs2 = rs2;
+                break;
+            case 0x63:  // BRANCH
+                op.cls = ISSUE_BRANCH;
+                op.rd = 0;
+                op.rs1 = rs1;
+                op.rs2 = rs2;
+                break;
+            case 0x67:  // JALR
+                op.cls = ISSUE_BRANCH;
+                op.rs1 = rs1;
+                break;
+            case 0x6F:  // JAL
+                op.cls = ISSUE_BRANCH;
+                break;
+            case 0x0F:  // MISC-MEM
+            case 0x73:  // SYSTEM
+                op.cls = ISSUE_SYSTEM;
+                op.rs1 = rs1;
+                break;
+            default:    // LUI, AUIPC and unsupported encodings
+                break;
+        }
+        return op;
+    }
+
+    PairBlock PairingRules::check(const IssueOp &older, const IssueOp &younger) const {
+        if (older.cls == ISSUE_SYSTEM || younger.cls == ISSUE_SYSTEM) {
+            return PAIR_SYSTEM;
+        }
+        if (older.cls == ISSUE_BRANCH) {
+            return PAIR_CONTROL;
+        }
+        if (excluded[older.cls][younger.cls]) {
+            return PAIR_EXCLUDED;
+        }
+
+        auto pipe = [this](IssueClass cls) {
+            return (lsu_shared && cls == ISSUE_STORE) ? ISSUE_LOAD : cls;
+        };
+        if (pipe(older.cls) == pipe(younger.cls) && pipes[pipe(younger.cls)] < 2) {
+            return PAIR_PIPE;
+        }
+
+        if (older.rd != 0 && (younger.rs1 == older.rd || younger.rs2 == older.rd)) {
+            return PAIR_RAW;
+        }
+        if (!allow_waw && older.rd != 0 && younger.rd == older.rd) {
+            return PAIR_WAW;
+        }
+        return PAIR_OK;
+    }
+
+    bool PairingRules::parse(const std::string &spec, std::string &error) {
+        std::stringstream items(spec);
+        std::string item;
+        while (std::getline(items, item, ',')) {
+            if (item.empty()) {
+                continue;
+            }
+            std::string::size_type eq = item.find('=');
+            if (eq == std::string::npos) {
+                error = "expected key=value: " + item;
+                return false;
+            }
+            std::string key = item.substr(0, eq);
+            std::string value = item.substr(eq + 1);
+
+            if (key == "no") {
+                std::string::size_type plus = value.find('+');
+                IssueClass a, b;
+                if (plus == std::string::npos || !classOf(value.substr(0, plus), a)
+                    || !classOf(value.substr(plus + 1), b)) {
+                    error = "expected no=<older>+<younger>: " + item;
+                    return false;
+                }
+                excluded[a][b] = true;
+                continue;
+            }
+
+            unsigned int n = 0;
+            try {
+                n = static_cast<unsigned int>(std::stoul(value));
+            } catch (...) {
+                error = "bad value: " + item;
+                return false;
+            }
+
+            IssueClass cls;
+            if (key == "width" && (n == 1 || n == 2)) {
+                width = n;
+            } else if (key == "waw" && n <= 1) {
+                allow_waw = n == 1;
+            } else if (key == "lsu" && n >= 1) {
+                lsu_shared = true;
+                pipes[ISSUE_LOAD] = n;
+                pipes[ISSUE_STORE] = n;
+            } else if ((key == "load" || key == "store") && n >= 1) {
+                lsu_shared = false;
+                pipes[key == "load" ? ISSUE_LOAD : ISSUE_STORE] = n;
+            } else if (classOf(key, cls) && n >= 1) {
+                pipes[cls] = n;
+            } else {
+                error = "unknown key or value: " + item;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const char *PairingRules::className(IssueClass cls) {
+        return cls < ISSUE_CLASSES ? class_names[cls] : "?";
+    }
+
+    void PairStats::record(IssueClass older, IssueClass younger, PairBlock reason) {
+        issue_cycles++;
+        blocked[reason]++;
+        if (reason == PAIR_OK) {
+            dual++;
+            paired[older][younger]++;
+        } else if (reason != PAIR_NO_SECOND) {
+            split[older][younger]++;
+        }
+    }
+
+    void PairStats::print(std::ostream &os) const {
+        os << "  Dual issue:   " << dual << " of " << issue_cycles << " issue cycles";
+        if (issue_cycles > 0) {
+            os << " (" << (100 * dual / issue_cycles) << "%)";
+        }
+        os << "\n  Not paired:  ";
+        for (unsigned int r = PAIR_NO_SECOND; r < PAIR_REASONS; r++) {
+            if (blocked[r] != 0) {
+                os << " " << reason_names[r] << " " << blocked[r];
+            }
+        }
+        os << "\n";
+        for (unsigned int a = 0; a < ISSUE_CLASSES; a++) {
+            for (unsigned int b = 0; b < ISSUE_CLASSES; b++) {
+                if (paired[a][b] != 0 || split[a][b] != 0) {
+                    os << "    " << class_names[a] << "+" << class_names[b] << ": "
+                       << paired[a][b] << " paired, " << split[a][b] << " split\n";
+                }
+            }
+        }
+    }
+}
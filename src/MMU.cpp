@@ -0,0 +1,273 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file MMU.cpp
+ * @brief Sv32/Sv39 page table walker and TLB maintenance
+ */
+
+#include "MMU.h"
+#include "MemoryInterface.h"
+#include "PMP.h"
+#include "Registers.h"
+
+#include <algorithm>
+
+namespace riscv_tlm {
+
+    namespace {
+        constexpr std::uint64_t PTE_V = 1 << 0;
+        constexpr std::uint64_t PTE_R = 1 << 1;
+        constexpr std::uint64_t PTE_W = 1 << 2;
+        constexpr std::uint64_t PTE_X = 1 << 3;
+        constexpr std::uint64_t PTE_U = 1 << 4;
+        constexpr std::uint64_t PTE_A = 1 << 6;
+        constexpr std::uint64_t PTE_D = 1 << 7;
+
+        constexpr unsigned int PRIV_U = 0;
+        constexpr unsigned int PRIV_S = 1;
+        constexpr unsigned int PRIV_M = 3;
+
+        enum {
+            CTX_USER = 0,
+            CTX_SUPERVISOR = 1,
+            CTX_SUPERVISOR_SUM = 2,
+        };
+    }
+
+    MMU::MMU(MemoryInterface *mem_interface, bool rv64) :
+            mem_intf(mem_interface), rv64(rv64), tlb(CONTEXTS * 3 * TLB_ENTRIES) {
+    }
+
+    void MMU::setState(std::uint64_t new_satp, std::uint64_t mstatus, unsigned int privilege) {
+        if (new_satp != satp) {
+            satp = new_satp;
+            if (rv64) {
+                mode = (satp >> 60) == 8 ? Mode::Sv39 : Mode::Bare;
+                asid = (satp >> 44) & 0xFFFF;
+                root = (satp & ((1ULL << 44) - 1)) << PAGE_SHIFT;
+            } else {
+                mode = (satp >> 31) & 1 ? Mode::Sv32 : Mode::Bare;
+                asid = (satp >> 22) & 0x1FF;
+                root = (satp & 0x3FFFFF) << PAGE_SHIFT;
+            }
+            /* entries are not ASID-tagged: the TLB only holds the current address space */
+            flush();
+        }
+
+        bool new_mxr = (mstatus & MSTATUS_MXR) != 0;
+        if (new_mxr != mxr) {
+            mxr = new_mxr;
+            flush();
+        }
+
+        unsigned int data_priv = privilege;
+        if ((mstatus & MSTATUS_MPRV) && privilege == PRIV_M) {
+            data_priv = (mstatus >> 11) & 3;
+        }
+
+        auto context = [this](unsigned int priv, bool sum) {
+            if (mode == Mode::Bare || priv == PRIV_M) {
+                return -1;
+            }
+            if (priv == PRIV_U) {
+                return static_cast<int>(CTX_USER);
+            }
+            return static_cast<int>(sum ? CTX_SUPERVISOR_SUM : CTX_SUPERVISOR);
+        };
+        fetch_ctx = context(privilege, false);
+        data_ctx = context(data_priv, (mstatus & MSTATUS_SUM) != 0);
+    }
+
+    std::uint32_t MMU::fetchAcrossPages(std::uint64_t vaddr) {
+        std::uint64_t paddr = translate(vaddr, AccessType::Fetch);
+        if (pmp != nullptr && pmp->checks(AccessType::Fetch)) {
+            pmp->check(paddr, 2, AccessType::Fetch, vaddr);
+        }
+        std::uint32_t low = mem_intf->readPhysical(paddr, 2);
+        if ((low & 3) != 3) {
+            return low;
+        }
+        paddr = translate(vaddr + 2, AccessType::Fetch);
+        if (pmp != nullptr && pmp->checks(AccessType::Fetch)) {
+            pmp->check(paddr, 2, AccessType::Fetch, vaddr + 2);
+        }
+        std::uint32_t high = mem_intf->readPhysical(paddr, 2);
+        return low | (high << 16);
+    }
+
+    void MMU::sfence(std::uint64_t vaddr, bool all_addresses, std::uint64_t asid_op, bool all_asids) {
+        std::uint64_t asid_mask = rv64 ? 0xFFFF : 0x1FF;
+        if (!all_asids && (asid_op & asid_mask) != asid) {
+            /* other address spaces are never cached */
+            return;
+        }
+        if (all_addresses || superpages_overflow) {
+            flush();
+            return;
+        }
+
+        std::uint64_t vpn = (rv64 ? vaddr : vaddr & 0xFFFFFFFF) >> PAGE_SHIFT;
+        for (const auto &sp : superpages) {
+            if (vpn - sp.first < sp.second) {
+                /* a superpage is cached in many slots */
+                flush();
+                return;
+            }
+        }
+
+        for (int ctx = 0; ctx < CONTEXTS; ctx++) {
+            for (auto type : {AccessType::Fetch, AccessType::Load, AccessType::Store}) {
+                TlbEntry &e = tlb[slot(ctx, type, vpn)];
+                if (e.vpn == vpn) {
+                    e.epoch = 0;
+                }
+            }
+        }
+    }
+
+    void MMU::flush() {
+        superpages.clear();
+        superpages_overflow = false;
+        if (++epoch == 0) {
+            for (auto &e : tlb) {
+                e.epoch = 0;
+            }
+            epoch = 1;
+        }
+    }
+
+    std::uint64_t MMU::refill(std::uint64_t vaddr, AccessType type, int ctx, unsigned char **host) {
+        misses++;
+
+        unsigned int level = 0;
+        std::uint64_t ppage = walk(vaddr, type, ctx, level);
+        std::uint64_t vpn = vaddr >> PAGE_SHIFT;
+
+        TlbEntry &e = tlb[slot(ctx, type, vpn)];
+        e.vpn = vpn;
+        e.ppage = ppage;
+        /* a host pointer skips the PMP check, so it is only kept for pages PMP fully allows */
+        if (pmp == nullptr || pmp->pageAllows(ppage, type, ctx == CTX_USER ? PRIV_U : PRIV_S)) {
+            e.host = mem_intf->getPhysicalDMIPointer(ppage, PAGE_SIZE, type == AccessType::Store);
+        } else {
+            e.host = nullptr;
+        }
+        e.epoch = epoch;
+
+        if (level > 0 && !superpages_overflow) {
+            std::uint64_t pages = 1ULL << (level * (rv64 ? 9 : 10));
+            std::pair<std::uint64_t, std::uint64_t> sp{vpn & ~(pages - 1), pages};
+            if (std::find(superpages.begin(), superpages.end(), sp) == superpages.end()) {
+                if (superpages.size() == MAX_SUPERPAGES) {
+                    superpages_overflow = true;
+                } else {
+                    superpages.push_back(sp);
+                }
+            }
+        }
+
+        if (host != nullptr) {
+            *host = e.host != nullptr ? e.host + (vaddr & PAGE_MASK) : nullptr;
+        }
+        return ppage | (vaddr & PAGE_MASK);
+    }
+
+    std::uint64_t MMU::walk(std::uint64_t vaddr, AccessType type, int ctx, unsigned int &level) {
+        const unsigned int levels = rv64 ? 3 : 2;
+        const unsigned int vpn_bits = rv64 ? 9 : 10;
+        const std::uint64_t pte_size = rv64 ? 8 : 4;
+
+        if (rv64) {
+            /* bits 63:39 must all equal bit 38 */
+            auto sext = static_cast<std::int64_t>(vaddr << 25) >> 25;
+            if (static_cast<std::uint64_t>(sext) != vaddr) {
+                fault(vaddr, type);
+            }
+        } else {
+            vaddr &= 0xFFFFFFFF;
+        }
+
+        std::uint64_t table = root;
+        for (int i = static_cast<int>(levels) - 1; i >= 0; i--) {
+            std::uint64_t index = (vaddr >> (PAGE_SHIFT + i * vpn_bits)) & ((1ULL << vpn_bits) - 1);
+            std::uint64_t pte_addr = table + index * pte_size;
+            std::uint64_t pte = readPTE(pte_addr, vaddr, type);
+
+            if (!(pte & PTE_V) || (!(pte & PTE_R) && (pte & PTE_W))) {
+                fault(vaddr, type);
+            }
+            if (rv64 && (pte >> 54) != 0) {
+                /* reserved, Svnapot and Svpbmt bits */
+                fault(vaddr, type);
+            }
+
+            std::uint64_t ppn = (pte >> 10) & (rv64 ? ((1ULL << 44) - 1) : 0x3FFFFF);
+
+            if (!(pte & (PTE_R | PTE_X))) {
+                table = ppn << PAGE_SHIFT;
+                continue;
+            }
+
+            /* leaf */
+            bool user_page = (pte & PTE_U) != 0;
+            if (ctx == CTX_USER ? !user_page
+                                : user_page && (type == AccessType::Fetch || ctx != CTX_SUPERVISOR_SUM)) {
+                fault(vaddr, type);
+            }
+
+            bool allowed;
+            switch (type) {
+                case AccessType::Fetch:
+                    allowed = (pte & PTE_X) != 0;
+                    break;
+                case AccessType::Load:
+                    allowed = (pte & PTE_R) || (mxr && (pte & PTE_X));
+                    break;
+                default:
+                    allowed = (pte & PTE_W) != 0;
+                    break;
+            }
+            if (!allowed) {
+                fault(vaddr, type);
+            }
+
+            std::uint64_t low_mask = (1ULL << (i * vpn_bits)) - 1;
+            if (ppn & low_mask) {
+                /* misaligned superpage */
+                fault(vaddr, type);
+            }
+
+            std::uint64_t ad = PTE_A | (type == AccessType::Store ? PTE_D : 0);
+            if ((pte & ad) != ad) {
+                checkPTE(pte_addr, AccessType::Store, vaddr, type);
+                mem_intf->writePhysical(pte_addr, static_cast<std::uint32_t>(pte | ad), 4);
+            }
+
+            level = static_cast<unsigned int>(i);
+            return ((ppn & ~low_mask) | ((vaddr >> PAGE_SHIFT) & low_mask)) << PAGE_SHIFT;
+        }
+
+        /* non-leaf entry at the last level */
+        fault(vaddr, type);
+    }
+
+    void MMU::fault(std::uint64_t vaddr, AccessType type) {
+        static constexpr unsigned int causes[] = {12, 13, 15};
+        throw MemoryFault{causes[static_cast<int>(type)], vaddr};
+    }
+
+    std::uint64_t MMU::readPTE(std::uint64_t addr, std::uint64_t vaddr, AccessType type) const {
+        checkPTE(addr, AccessType::Load, vaddr, type);
+        std::uint64_t pte = mem_intf->readPhysical(addr, 4);
+        if (rv64) {
+            pte |= static_cast<std::uint64_t>(mem_intf->readPhysical(addr + 4, 4)) << 32;
+        }
+        return pte;
+    }
+
+    void MMU::checkPTE(std::uint64_t addr, AccessType access, std::uint64_t vaddr, AccessType type) const {
+        if (pmp != nullptr && !pmp->allows(addr, rv64 ? 8 : 4, access, PRIV_S)) {
+            /* reported as an access fault of the original access */
+            PMP::fault(type, vaddr);
+        }
+    }
+}
@@ -29,7 +29,7 @@ namespace riscv_tlm {
 
         this->regs->setValue(rd, ret_value);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. M.MULH: x{:d}({:d}) * x{:d}({:d}) -> x{:d}({:d})",
+        this->logger->debug("{} ps. PC: 0x{:x}. M.MULH: x{:d}({:d}) * x{:d}({:d}) -> x{:d}({:d})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, multiplier, rs2, multiplicand, rd, result);
@@ -53,7 +53,7 @@ namespace riscv_tlm {
         result = (result >> 32) & 0x00000000FFFFFFFF;
         this->regs->setValue(rd, static_cast<std::int32_t>(result));
 
-        this->logger->debug("{} ns. PC: 0x{:x}. M.MULHSU: x{:d} * x{:d} -> x{:d}({:d})",
+        this->logger->debug("{} ps. PC: 0x{:x}. M.MULHSU: x{:d} * x{:d} -> x{:d}({:d})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, rs2, rd, result);
@@ -77,7 +77,7 @@ namespace riscv_tlm {
         ret_value = static_cast<std::int32_t>((result >> 32) & 0x00000000FFFFFFFF);
         this->regs->setValue(rd, ret_value);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. M.MULHU: x{:d} * x{:d} -> x{:d}({:d})",
+        this->logger->debug("{} ps. PC: 0x{:x}. M.MULHU: x{:d} * x{:d} -> x{:d}({:d})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, rs2, rd, result);
@@ -106,7 +106,7 @@ namespace riscv_tlm {
 
         this->regs->setValue(rd, result);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. M.MULH: x{:d}({:d}) * x{:d}({:d}) -> x{:d}({:d})",
+        this->logger->debug("{} ps. PC: 0x{:x}. M.MULH: x{:d}({:d}) * x{:d}({:d}) -> x{:d}({:d})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, multiplier, rs2, multiplicand, rd, result);
@@ -133,7 +133,7 @@ namespace riscv_tlm {
 
         this->regs->setValue(rd, result);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. M.MULHSU: x{:d} * x{:d} -> x{:d}({:d})",
+        this->logger->debug("{} ps. PC: 0x{:x}. M.MULHSU: x{:d} * x{:d} -> x{:d}({:d})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, rs2, rd, result);
@@ -159,7 +159,7 @@ namespace riscv_tlm {
 
         this->regs->setValue(rd, result);
 
-        this->logger->debug("{} ns. PC: 0x{:x}. M.MULHU: x{:d} * x{:d} -> x{:d}({:d})",
+        this->logger->debug("{} ps. PC: 0x{:x}. M.MULHU: x{:d} * x{:d} -> x{:d}({:d})",
                             sc_core::sc_time_stamp().value(),
                             this->regs->getPC(),
                             rs1, rs2, rd, result);
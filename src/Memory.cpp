@@ -7,6 +7,11 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "Memory.h"
+#include "ClockDomains.h"
+#include "ExecutionHistory.h"
+#include "FaultCampaign.h"
+#include "SelfProfile.h"
+#include "Telemetry.h"
 
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/null_sink.h"
@@ -22,6 +27,7 @@ namespace riscv_tlm {
  socket.register_get_direct_mem_ptr(this, &Memory::get_direct_mem_ptr);
  socket.register_transport_dbg(this, &Memory::transport_dbg);
 
+ allocate();
  dmi_allowed = false;
  program_counter =0;
  readHexFile(filename);
@@ -51,6 +57,7 @@ namespace riscv_tlm {
  socket.register_get_direct_mem_ptr(this, &Memory::get_direct_mem_ptr);
  socket.register_transport_dbg(this, &Memory::transport_dbg);
 
+ allocate();
  	dmi_allowed = false;
  program_counter =0;
 
@@ -67,6 +74,14 @@ namespace riscv_tlm {
 
  Memory::~Memory() = default;
 
+ void Memory::allocate() {
+ mem = Telemetry::getInstance()->sharedRam(Memory::SIZE);
+ if (mem == nullptr) {
+ storage.reset(new uint8_t[Memory::SIZE]());
+ mem = storage.get();
+ }
+ }
+
  std::uint32_t Memory::getPCfromHEX() {
  return program_counter;
 
@@ -74,6 +89,7 @@ namespace riscv_tlm {
 
  void Memory::b_transport(tlm::tlm_generic_payload &trans,
  sc_core::sc_time &delay) {
+ RVVP_PROFILE_SCOPE(Memory);
  tlm::tlm_command cmd = trans.get_command();
  sc_dt::uint64 adr = trans.get_address();
  unsigned char *ptr = trans.get_data_ptr();
@@ -99,13 +115,18 @@ namespace riscv_tlm {
 
  // Obliged to implement read and write commands
  if (cmd == tlm::TLM_READ_COMMAND) {
- std::copy_n(mem.cbegin() + adr, len, ptr);
+ std::copy_n(mem + adr, len, ptr);
  } else if (cmd == tlm::TLM_WRITE_COMMAND) {
- std::copy_n(ptr, len, mem.begin() + adr);
+ ExecutionHistory::beforeWrite(mem + adr, len);
+ FaultCampaign::beforeWrite(mem + adr, len);
+ std::copy_n(ptr, len, mem + adr);
  }
 
  // Accumulate configured latency (simulate memory/bus delay)
  delay += m_latency;
+ if (ClockDomains::timedAccesses()) {
+ delay += ClockDomains::getInstance()->domain(ClockDomains::MEMORY).accessTime();
+ }
 
  // Reset timing annotation after waiting
  // Keep annotation for initiator to honor; do not zero it here
@@ -138,7 +159,7 @@ namespace riscv_tlm {
  dmi_data.allow_read_write();
 
  // Set other details of DMI region
- dmi_data.set_dmi_ptr(reinterpret_cast<unsigned char *>(mem.data()));
+ dmi_data.set_dmi_ptr(reinterpret_cast<unsigned char *>(mem));
  dmi_data.set_start_address(0);
  dmi_data.set_end_address(Memory::SIZE -1);
  dmi_data.set_read_latency(m_latency);
@@ -163,79 +184,92 @@ namespace riscv_tlm {
  (std::min<sc_dt::uint64>(len, sc_dt::uint64(Memory::SIZE) - adr));
 
  if (cmd == tlm::TLM_READ_COMMAND) {
- std::copy_n(mem.cbegin() + adr, num_bytes, ptr);
+ std::copy_n(mem + adr, num_bytes, ptr);
  } else if (cmd == tlm::TLM_WRITE_COMMAND) {
- std::copy_n(ptr, num_bytes, mem.begin() + adr);
+ ExecutionHistory::beforeWrite(mem + adr, num_bytes);
+ FaultCampaign::beforeWrite(mem + adr, num_bytes);
+ std::copy_n(ptr, num_bytes, mem + adr);
  }
 
  return num_bytes;
  }
 
- void Memory::readHexFile(std::string const &filename) {
- std::ifstream hexfile;
- std::string line;
- std::uint32_t memory_offset =0;
-
- hexfile.open(filename);
-
- if (hexfile.is_open()) {
- std::uint32_t extended_address =0;
-
- while (getline(hexfile, line)) {
- if (line[0] == ':') {
- if (line.substr(7,2) == "00") {
- /* Data */
- int byte_count;
- std::uint32_t address;
- byte_count = std::stoi(line.substr(1,2), nullptr,16);
- address = std::stoi(line.substr(3,4), nullptr,16);
- address = address + extended_address + memory_offset;
-
- for (int i =0; i < byte_count; i++) {
+    void Memory::readHexFile(std::string const &filename) {
+        std::ifstream hexfile;
+        std::string line;
+        std::uint32_t memory_offset =0;
+
+        // The runs describe the last image loaded, not every image since construction.
+        image_runs.clear();
+        hexfile.open(filename);
+
+        if (hexfile.is_open()) {
+            std::uint32_t extended_address =0;
+            ImageHash hash;
+            std::vector<std::uint8_t> record;
+
+            while (getline(hexfile, line)) {
+                if (line[0] == ':') {
+                    if (line.substr(7,2) == "00") {
+                        /* Data */
+                        int byte_count;
+                        std::uint32_t address;
+                        byte_count = std::stoi(line.substr(1,2), nullptr,16);
+                        address = std::stoi(line.substr(3,4), nullptr,16);
+                        address = address + extended_address + memory_offset;
+
+                        record.resize(byte_count);
+                        for (int i =0; i < byte_count; i++) {
                             std::uint32_t a = address + i;
+                            record[i] = stol(line.substr(9 + (i *2),2), nullptr,16);
                             if (a < Memory::SIZE) {
-                                mem[a] = stol(line.substr(9 + (i *2),2), nullptr,16);
+                                mem[a] = record[i];
                             }
- }
- } else if (line.substr(7,2) == "02") {
- /* Extended segment address */
- extended_address = stol(line.substr(9,4), nullptr,16)
- *16;
- std::cout << "02 extended address0x" << std::hex
- << extended_address << std::dec << std::endl;
- } else if (line.substr(7,2) == "03") {
- /* Start segment address */
- std::uint32_t code_segment;
- code_segment = stol(line.substr(9,4), nullptr,16) *16; /* ? */
- program_counter = stol(line.substr(13,4), nullptr,16);
- program_counter = program_counter + code_segment;
- std::cout << "03 PC set to0x" << std::hex
- << program_counter << std::dec << std::endl;
- } else if (line.substr(7,2) == "04") {
- /* Start segment address */
- memory_offset = stol(line.substr(9,4), nullptr,16) <<16;
- extended_address =0;
- std::cout << "04 address set to0x" << std::hex
- << extended_address << std::dec << std::endl;
- std::cout << "04 offset set to0x" << std::hex
- << memory_offset << std::dec << std::endl;
- } else if (line.substr(7,2) == "05") {
- program_counter = stol(line.substr(9,8), nullptr,16);
- std::cout << "05 PC set to0x" << std::hex
- << program_counter << std::dec << std::endl;
- }
- }
- }
- hexfile.close();
-
- if (memory_offset !=0) {
- dmi_allowed = false;
- } else {
- dmi_allowed = true;
- }
-
- } else {
- SC_REPORT_ERROR("Memory", "Open file error");
- }
- }
+                        }
+                        hash.add(address, record.data(), record.size());
+                    } else if (line.substr(7,2) == "02") {
+                        /* Extended segment address */
+                        extended_address = stol(line.substr(9,4), nullptr,16)
+                            *16;
+                        std::cout << "02 extended address0x" << std::hex
+                            << extended_address << std::dec << std::endl;
+                    } else if (line.substr(7,2) == "03") {
+                        /* Start segment address */
+                        std::uint32_t code_segment;
+                        code_segment = stol(line.substr(9,4), nullptr,16) *16; /* ? */
+                        program_counter = stol(line.substr(13,4), nullptr,16);
+                        program_counter = program_counter + code_segment;
+                        std::cout << "03 PC set to0x" << std::hex
+                            << program_counter << std::dec << std::endl;
+                    } else if (line.substr(7,2) == "04") {
+                        /* Start segment address */
+                        memory_offset = stol(line.substr(9,4), nullptr,16) <<16;
+                        extended_address =0;
+                        std::cout << "04 address set to0x" << std::hex
+                            << extended_address << std::dec << std::endl;
+                        std::cout << "04 offset set to0x" << std::hex
+                            << memory_offset << std::dec << std::endl;
+                    } else if (line.substr(7,2) == "05") {
+                        program_counter = stol(line.substr(9,8), nullptr,16);
+                        std::cout << "05 PC set to0x" << std::hex
+                            << program_counter << std::dec << std::endl;
+                    }
+                }
+            }
+            hexfile.close();
+            image_hash = hash.digest();
+            hash.visitRuns([this](std::uint64_t start, std::uint64_t length) {
+                image_runs.emplace_back(start, length);
+            });
+
+            if (memory_offset !=0) {
+                dmi_allowed = false;
+            } else {
+                dmi_allowed = true;
+            }
+
+        } else {
+            SC_REPORT_ERROR("Memory", "Open file error");
+        }
+    }
 }
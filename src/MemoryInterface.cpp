@@ -7,13 +7,22 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "MemoryInterface.h"
+#include "ClockDomains.h"
+#include "ExecutionHistory.h"
+#include "FaultCampaign.h"
+#include "PluginManager.h"
+#include "RunControl.h"
+#include "SelfProfile.h"
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
 namespace riscv_tlm {
 
     MemoryInterface::MemoryInterface() :
-            data_bus("data_bus") {}
+            data_bus("data_bus") {
+        data_bus.register_invalidate_direct_mem_ptr(this, &MemoryInterface::invalidate_direct_mem_ptr);
+    }
 
 /**
  * Access data memory to get data (32-bit)
@@ -23,25 +32,19 @@ namespace riscv_tlm {
  */
     std::uint32_t MemoryInterface::readDataMem(std::uint64_t addr, int size) {
         std::uint32_t data = 0;
-        tlm::tlm_generic_payload trans;
-        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
-
-        trans.set_command(tlm::TLM_READ_COMMAND);
-        trans.set_data_ptr(reinterpret_cast<unsigned char *>(&data));
-        trans.set_data_length(size);
-        trans.set_streaming_width(4);
-        trans.set_byte_enable_ptr(nullptr);
-        trans.set_dmi_allowed(false);
-        trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
-        trans.set_address(addr);
 
-        data_bus->b_transport(trans, delay);
+        if (plugin_reports && PluginManager::active()) {
+            PluginManager::getInstance()->onMemAccess(addr, size, false);
+        }
 
-        if (trans.is_response_error()) {
-            std::stringstream error_msg;
-            error_msg << "Read memory: 0x" << std::hex << addr;
-            SC_REPORT_ERROR("Memory", error_msg.str().c_str());
+        std::uint64_t vaddr = addr;
+        if (mmu != nullptr && mmu->translates(AccessType::Load)
+            && translatedAccess(addr, reinterpret_cast<unsigned char *>(&data), size, false)) {
+            return data;
         }
+        checkPMP(addr, size, AccessType::Load, vaddr);
+
+        transport(tlm::TLM_READ_COMMAND, addr, reinterpret_cast<unsigned char *>(&data), size, 4, "Read memory");
 
         return data;
     }
@@ -54,25 +57,20 @@ namespace riscv_tlm {
  */
     std::uint64_t MemoryInterface::readDataMem64(std::uint64_t addr, int size) {
         std::uint64_t data = 0;
-        tlm::tlm_generic_payload trans;
-        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
-
-        trans.set_command(tlm::TLM_READ_COMMAND);
-        trans.set_data_ptr(reinterpret_cast<unsigned char *>(&data));
-        trans.set_data_length(size);
-        trans.set_streaming_width(size);
-        trans.set_byte_enable_ptr(nullptr);
-        trans.set_dmi_allowed(false);
-        trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
-        trans.set_address(addr);
 
-        data_bus->b_transport(trans, delay);
+        if (plugin_reports && PluginManager::active()) {
+            PluginManager::getInstance()->onMemAccess(addr, size, false);
+        }
 
-        if (trans.is_response_error()) {
-            std::stringstream error_msg;
-            error_msg << "Read memory (64-bit): 0x" << std::hex << addr;
-            SC_REPORT_ERROR("Memory", error_msg.str().c_str());
+        std::uint64_t vaddr = addr;
+        if (mmu != nullptr && mmu->translates(AccessType::Load)
+            && translatedAccess(addr, reinterpret_cast<unsigned char *>(&data), size, false)) {
+            return data;
         }
+        checkPMP(addr, size, AccessType::Load, vaddr);
+
+        transport(tlm::TLM_READ_COMMAND, addr, reinterpret_cast<unsigned char *>(&data), size, size,
+                  "Read memory (64-bit)");
 
         return data;
     }
@@ -85,25 +83,21 @@ namespace riscv_tlm {
  * @param size size of the data to write in bytes
  */
     void MemoryInterface::writeDataMem(std::uint64_t addr, std::uint32_t data, int size) {
-        tlm::tlm_generic_payload trans;
-        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
-
-        trans.set_command(tlm::TLM_WRITE_COMMAND);
-        trans.set_data_ptr(reinterpret_cast<unsigned char *>(&data));
-        trans.set_data_length(size);
-        trans.set_streaming_width(4);
-        trans.set_byte_enable_ptr(nullptr);
-        trans.set_dmi_allowed(false);
-        trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
-        trans.set_address(addr);
-
-        data_bus->b_transport(trans, delay);
+        if (plugin_reports && PluginManager::active()) {
+            PluginManager::getInstance()->onMemAccess(addr, size, true);
+        }
+        if (RunControl::watchesWrites()) {
+            RunControl::getInstance()->write(addr, size);
+        }
 
-        if (trans.is_response_error()) {
-            std::stringstream error_msg;
-            error_msg << "Write memory: 0x" << std::hex << addr;
-            SC_REPORT_ERROR("Memory", error_msg.str().c_str());
+        std::uint64_t vaddr = addr;
+        if (mmu != nullptr && mmu->translates(AccessType::Store)
+            && translatedAccess(addr, reinterpret_cast<unsigned char *>(&data), size, true)) {
+            return;
         }
+        checkPMP(addr, size, AccessType::Store, vaddr);
+
+        transport(tlm::TLM_WRITE_COMMAND, addr, reinterpret_cast<unsigned char *>(&data), size, 4, "Write memory");
     }
 
 /**
@@ -114,13 +108,80 @@ namespace riscv_tlm {
  * @param size size of the data to write in bytes (1, 2, 4, or 8)
  */
     void MemoryInterface::writeDataMem64(std::uint64_t addr, std::uint64_t data, int size) {
+        if (plugin_reports && PluginManager::active()) {
+            PluginManager::getInstance()->onMemAccess(addr, size, true);
+        }
+        if (RunControl::watchesWrites()) {
+            RunControl::getInstance()->write(addr, size);
+        }
+
+        std::uint64_t vaddr = addr;
+        if (mmu != nullptr && mmu->translates(AccessType::Store)
+            && translatedAccess(addr, reinterpret_cast<unsigned char *>(&data), size, true)) {
+            return;
+        }
+        checkPMP(addr, size, AccessType::Store, vaddr);
+
+        transport(tlm::TLM_WRITE_COMMAND, addr, reinterpret_cast<unsigned char *>(&data), size, size,
+                  "Write memory (64-bit)");
+    }
+
+    std::uint32_t MemoryInterface::readPhysical(std::uint64_t addr, int size) {
+        std::uint32_t data = 0;
+        transport(tlm::TLM_READ_COMMAND, addr, reinterpret_cast<unsigned char *>(&data), size, 4, "Read memory");
+        return data;
+    }
+
+    void MemoryInterface::writePhysical(std::uint64_t addr, std::uint32_t data, int size) {
+        transport(tlm::TLM_WRITE_COMMAND, addr, reinterpret_cast<unsigned char *>(&data), size, 4, "Write memory");
+    }
+
+    bool MemoryInterface::translatedAccess(std::uint64_t &addr, unsigned char *data, int size, bool is_write) {
+        AccessType type = is_write ? AccessType::Store : AccessType::Load;
+
+        if (MMU::crossesPage(addr, size)) {
+            if (is_write) {
+                /* fault before any byte is stored */
+                for (int i = 0; i < size; i++) {
+                    checkPMP(mmu->translate(addr + i, type), 1, type, addr + i);
+                }
+            }
+            for (int i = 0; i < size; i++) {
+                std::uint64_t byte_addr = addr + i;
+                if (!translatedAccess(byte_addr, data + i, 1, is_write)) {
+                    checkPMP(byte_addr, 1, type, addr + i);
+                    transport(is_write ? tlm::TLM_WRITE_COMMAND : tlm::TLM_READ_COMMAND, byte_addr, data + i, 1, 4,
+                              is_write ? "Write memory" : "Read memory");
+                }
+            }
+            return true;
+        }
+
+        unsigned char *host = nullptr;
+        addr = mmu->translate(addr, type, &host);
+        if (host == nullptr) {
+            return false;
+        }
+
+        if (is_write) {
+            ExecutionHistory::beforeWrite(host, size);
+            FaultCampaign::beforeWrite(host, size);
+            std::memcpy(host, data, size);
+        } else {
+            std::memcpy(data, host, size);
+        }
+        return true;
+    }
+
+    void MemoryInterface::transport(tlm::tlm_command cmd, std::uint64_t addr, unsigned char *data, int size,
+                                    unsigned int width, const char *what) {
         tlm::tlm_generic_payload trans;
         sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
 
-        trans.set_command(tlm::TLM_WRITE_COMMAND);
-        trans.set_data_ptr(reinterpret_cast<unsigned char *>(&data));
+        trans.set_command(cmd);
+        trans.set_data_ptr(data);
         trans.set_data_length(size);
-        trans.set_streaming_width(size);
+        trans.set_streaming_width(width);
         trans.set_byte_enable_ptr(nullptr);
         trans.set_dmi_allowed(false);
         trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
@@ -128,10 +189,88 @@ namespace riscv_tlm {
 
         data_bus->b_transport(trans, delay);
 
+        if (ClockDomains::timedAccesses() && delay != sc_core::SC_ZERO_TIME) {
+            RVVP_PROFILE_SUSPEND();
+            sc_core::wait(delay);
+        }
+
         if (trans.is_response_error()) {
             std::stringstream error_msg;
-            error_msg << "Write memory (64-bit): 0x" << std::hex << addr;
+            error_msg << what << ": 0x" << std::hex << addr;
             SC_REPORT_ERROR("Memory", error_msg.str().c_str());
         }
     }
-}
\ No newline at end of file
+
+    unsigned char *MemoryInterface::getDMIPointer(std::uint64_t addr, std::size_t len, bool is_write) {
+        if (len == 0) {
+            return nullptr;
+        }
+        if (is_write && RunControl::watchesWrites()) {
+            RunControl::getInstance()->write(addr, static_cast<unsigned int>(len));
+        }
+
+        AccessType type = is_write ? AccessType::Store : AccessType::Load;
+        unsigned char *host = nullptr;
+        if (mmu != nullptr && mmu->translates(type)) {
+            if (MMU::crossesPage(addr, len)) {
+                return nullptr;
+            }
+            mmu->translate(addr, type, &host);
+        } else if (pmp == nullptr || !pmp->checks(type) || pmp->permits(addr, len, type)) {
+            host = getPhysicalDMIPointer(addr, len, is_write);
+        }
+
+        if (is_write && host != nullptr) {
+            ExecutionHistory::beforeWrite(host, len);
+            FaultCampaign::beforeWrite(host, len);
+        }
+        return host;
+    }
+
+    unsigned char *MemoryInterface::getPhysicalDMIPointer(std::uint64_t addr, std::size_t len, bool is_write) {
+        if (len == 0) {
+            return nullptr;
+        }
+
+        if (!dmiCovers(addr, len, is_write)) {
+            tlm::tlm_generic_payload trans;
+            trans.set_command(is_write ? tlm::TLM_WRITE_COMMAND : tlm::TLM_READ_COMMAND);
+            trans.set_address(addr);
+            dmi_data.init();
+            dmi_valid = data_bus->get_direct_mem_ptr(trans, dmi_data);
+            if (!dmiCovers(addr, len, is_write)) {
+                return nullptr;
+            }
+        }
+
+        return dmi_data.get_dmi_ptr() + (addr - dmi_data.get_start_address());
+    }
+
+    unsigned char *MemoryInterface::getPhysicalDMIRegion(std::uint64_t addr, std::uint64_t &start,
+                                                        std::uint64_t &end) {
+        if (getPhysicalDMIPointer(addr, 1, true) == nullptr || !dmi_data.is_read_allowed()) {
+            return nullptr;
+        }
+        start = dmi_data.get_start_address();
+        end = dmi_data.get_end_address();
+        return dmi_data.get_dmi_ptr();
+    }
+
+    bool MemoryInterface::dmiCovers(std::uint64_t addr, std::size_t len, bool is_write) const {
+        if (!dmi_valid || addr < dmi_data.get_start_address()
+            || addr + len - 1 > dmi_data.get_end_address()) {
+            return false;
+        }
+        return is_write ? dmi_data.is_write_allowed() : dmi_data.is_read_allowed();
+    }
+
+    void MemoryInterface::invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end) {
+        (void) start;
+        (void) end;
+        dmi_valid = false;
+        if (mmu != nullptr) {
+            /* TLB entries hold host pointers into the old region */
+            mmu->flush();
+        }
+    }
+}
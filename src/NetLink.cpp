@@ -0,0 +1,470 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file NetLink.cpp
+ * @brief Shared-memory Ethernet segment and its time synchronisation
+ */
+
+#include "NetLink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+namespace riscv_tlm {
+
+    NetSpec NetSpec::s_platform;
+
+    namespace {
+        constexpr const char *SEGMENT_PREFIX = "/riscv_vp.net.";
+
+        /* preamble and start delimiter, FCS, inter-frame gap */
+        constexpr std::uint64_t WIRE_OVERHEAD = 8 + 4 + 12;
+        constexpr std::uint64_t MIN_FRAME = 60;
+
+        bool number(const std::string &text, std::uint64_t &value) {
+            try {
+                std::size_t used = 0;
+                value = std::stoull(text, &used, 0);
+                return used == text.size();
+            } catch (...) {
+                return false;
+            }
+        }
+
+        bool duration(const std::string &text, std::uint64_t &ps) {
+            static const struct {
+                const char *unit;
+                std::uint64_t scale;
+            } units[] = {{"ps", 1}, {"ns", 1000}, {"us", 1000000}, {"ms", 1000000000}};
+
+            for (auto const &u : units) {
+                const std::size_t len = std::strlen(u.unit);
+                if (text.size() > len && text.compare(text.size() - len, len, u.unit) == 0) {
+                    std::uint64_t value = 0;
+                    if (!number(text.substr(0, text.size() - len), value)) {
+                        return false;
+                    }
+                    ps = value * u.scale;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool rate(std::string text, std::uint64_t &bps) {
+            for (const char *suffix : {"bit/s", "bps"}) {
+                const std::size_t len = std::strlen(suffix);
+                if (text.size() > len && text.compare(text.size() - len, len, suffix) == 0) {
+                    text.resize(text.size() - len);
+                    break;
+                }
+            }
+            std::uint64_t scale = 1;
+            if (!text.empty()) {
+                switch (text.back()) {
+                    case 'k': scale = 1000; break;
+                    case 'M': scale = 1000000; break;
+                    case 'G': scale = 1000000000; break;
+                    default: break;
+                }
+                if (scale != 1) {
+                    text.pop_back();
+                }
+            }
+            std::uint64_t value = 0;
+            if (!number(text, value)) {
+                return false;
+            }
+            bps = value * scale;
+            return true;
+        }
+
+        bool macAddress(const std::string &text, std::array<std::uint8_t, 6> &mac) {
+            unsigned int bytes[6];
+            char tail;
+            if (std::sscanf(text.c_str(), "%x:%x:%x:%x:%x:%x%c", &bytes[0], &bytes[1], &bytes[2],
+                            &bytes[3], &bytes[4], &bytes[5], &tail) != 6) {
+                return false;
+            }
+            for (unsigned int i = 0; i < 6; i++) {
+                if (bytes[i] > 0xff) {
+                    return false;
+                }
+                mac[i] = static_cast<std::uint8_t>(bytes[i]);
+            }
+            return (mac[0] & 1) == 0;     // not a multicast address
+        }
+
+        std::uint64_t toPs(const sc_core::sc_time &t) {
+            return static_cast<std::uint64_t>(t / sc_core::sc_time(1, sc_core::SC_PS) + 0.5);
+        }
+
+        sc_core::sc_time fromPs(std::uint64_t ps) {
+            return sc_core::sc_time(static_cast<double>(ps), sc_core::SC_PS);
+        }
+
+        std::uint64_t nowPs() {
+            return toPs(sc_core::sc_time_stamp());
+        }
+
+        sc_core::sc_time until(std::uint64_t time_ps) {
+            const std::uint64_t now = nowPs();
+            return time_ps > now ? fromPs(time_ps - now) : sc_core::SC_ZERO_TIME;
+        }
+
+        void backoff(unsigned int &spins) {
+            if (++spins < 1024) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+            }
+        }
+    }
+
+    bool NetSpec::parse(const std::string &spec, std::string &error) {
+        *this = NetSpec{};
+
+        std::size_t pos = 0;
+        bool first = true;
+        while (pos <= spec.size()) {
+            std::size_t comma = spec.find(',', pos);
+            if (comma == std::string::npos) {
+                comma = spec.size();
+            }
+            const std::string item = spec.substr(pos, comma - pos);
+            pos = comma + 1;
+
+            if (first) {
+                first = false;
+                if (item.empty() || item.find('/') != std::string::npos) {
+                    error = "expected a segment name: " + spec;
+                    return false;
+                }
+                segment = item;
+                continue;
+            }
+
+            const std::size_t eq = item.find('=');
+            const std::string key = item.substr(0, eq);
+            const std::string value = eq == std::string::npos ? "" : item.substr(eq + 1);
+            bool ok = eq != std::string::npos;
+            std::uint64_t n = 0;
+            if (key == "mac") {
+                ok = ok && macAddress(value, mac);
+                has_mac = true;
+            } else if (key == "latency") {
+                ok = ok && duration(value, latency_ps) && latency_ps > 0;
+                has_link = true;
+            } else if (key == "bandwidth") {
+                ok = ok && rate(value, bandwidth_bps) && bandwidth_bps > 0;
+                has_link = true;
+            } else if (key == "nodes") {
+                ok = ok && number(value, n) && n >= 1 && n <= NET_PORTS;
+                nodes = static_cast<unsigned int>(n);
+            } else {
+                error = "unknown key: " + item;
+                return false;
+            }
+            if (!ok) {
+                error = "bad value: " + item;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // =========================================================================
+    // Segment
+    // =========================================================================
+
+    NetLink::NetLink(sc_core::sc_module_name const &name, const NetSpec &spec)
+            : sc_module(name), m_nodes(spec.nodes) {
+        const std::string shm_name = SEGMENT_PREFIX + spec.segment;
+        const std::uint32_t pid = SharedMemory::processId();
+        std::string error;
+
+        for (int attempt = 0; m_segment == nullptr; attempt++) {
+            bool created = false;
+            if (attempt == 3 || !m_shm.open(shm_name, sizeof(NetSegment), 0600, created, error)) {
+                SC_REPORT_ERROR("NetLink", (attempt == 3 ? shm_name + ": cannot set it up" : error).c_str());
+                return;
+            }
+            auto *segment = static_cast<NetSegment *>(m_shm.data());
+
+            if (created) {
+                /* the object is zero-filled, which is the empty state of every ring */
+                new(segment) NetSegment;
+                segment->version = NetSegment::VERSION;
+                segment->latency_ps = spec.latency_ps;
+                segment->bandwidth_bps = spec.bandwidth_bps;
+                segment->port[0].pid.store(pid);
+                segment->magic.store(NetSegment::MAGIC, std::memory_order_release);
+                m_segment = segment;
+                break;
+            }
+
+            /* the creator claims its port before it publishes the segment */
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+            while (segment->magic.load(std::memory_order_acquire) != NetSegment::MAGIC
+                   && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            bool live = false;
+            if (segment->magic.load(std::memory_order_acquire) == NetSegment::MAGIC) {
+                for (auto const &port : segment->port) {
+                    const std::uint32_t owner = port.pid.load();
+                    live = live || (owner != 0 && SharedMemory::processAlive(owner));
+                }
+            }
+            if (!live) {
+                /* left behind by a crashed run */
+                m_shm.close();
+                SharedMemory::remove(shm_name);
+                continue;
+            }
+            if (segment->version != NetSegment::VERSION) {
+                SC_REPORT_ERROR("NetLink", (shm_name + ": version mismatch").c_str());
+                return;
+            }
+            if (spec.has_link && (segment->latency_ps != spec.latency_ps
+                                  || segment->bandwidth_bps != spec.bandwidth_bps)) {
+                SC_REPORT_ERROR("NetLink", (shm_name + ": latency and bandwidth are set by the first port ("
+                                            + std::to_string(segment->latency_ps) + " ps, "
+                                            + std::to_string(segment->bandwidth_bps) + " bit/s)").c_str());
+                return;
+            }
+
+            /* a free port, or one whose owner has exited */
+            bool claimed = false;
+            for (unsigned int p = 0; p < NET_PORTS && !claimed; p++) {
+                std::uint32_t owner = segment->port[p].pid.load();
+                if (owner != 0 && SharedMemory::processAlive(owner)) {
+                    continue;
+                }
+                claimed = segment->port[p].pid.compare_exchange_strong(owner, pid);
+                m_port = p;
+            }
+            if (!claimed) {
+                SC_REPORT_ERROR("NetLink", (shm_name + ": all " + std::to_string(NET_PORTS)
+                                            + " ports are in use").c_str());
+                return;
+            }
+            m_segment = segment;
+        }
+
+        /* frames left for the previous owner of the port */
+        for (auto &ring : m_segment->ring[m_port]) {
+            ring.tail.store(ring.head.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        if (spec.has_mac) {
+            m_mac = spec.mac;
+        } else {
+            m_mac = {0x52, 0x54, 0x00, 0x12, 0x34, static_cast<std::uint8_t>(m_port + 1)};
+        }
+        m_latency_ps = m_segment->latency_ps;
+        m_latency = fromPs(m_latency_ps);
+        m_bandwidth_bps = m_segment->bandwidth_bps;
+
+        NetPort &self = m_segment->port[m_port];
+        std::memcpy(self.mac, m_mac.data(), m_mac.size());
+        self.grant_ps.store(0, std::memory_order_relaxed);
+        self.state.store(NetPort::Running, std::memory_order_release);
+
+        SC_THREAD(sync_thread);
+
+        SC_METHOD(deliver_method);
+        sensitive << m_arrival_event;
+        dont_initialize();
+    }
+
+    NetLink::~NetLink() {
+        leave();
+    }
+
+    void NetLink::leave() {
+        if (m_segment == nullptr) {
+            return;
+        }
+        NetPort &self = m_segment->port[m_port];
+        self.state.store(NetPort::Finished, std::memory_order_release);
+        self.pid.store(0);
+
+        /* the last port to leave removes the segment */
+        bool others = false;
+        for (auto const &port : m_segment->port) {
+            others = others || port.pid.load() != 0;
+        }
+        m_segment = nullptr;
+        if (!others) {
+            SharedMemory::remove(m_shm.name());
+        }
+        m_shm.close();
+    }
+
+    void NetLink::end_of_simulation() {
+        if (m_segment != nullptr) {
+            m_segment->port[m_port].state.store(NetPort::Finished, std::memory_order_release);
+        }
+    }
+
+    sc_core::sc_time NetLink::send(const std::uint8_t *frame, std::size_t length) {
+        if (m_segment == nullptr) {
+            m_stats.tx_dropped++;
+            return sc_core::SC_ZERO_TIME;
+        }
+        length = std::min(length, NET_FRAME_MAX);
+
+        /* the frame waits for the ones before it, then occupies the link */
+        const std::uint64_t now = nowPs();
+        const std::uint64_t bits = (std::max<std::uint64_t>(length, MIN_FRAME) + WIRE_OVERHEAD) * 8;
+        const std::uint64_t start = std::max(now, m_link_free_ps);
+        m_link_free_ps = start + bits * 1000000000000ULL / m_bandwidth_bps;
+
+        NetFrame out;
+        out.time_ps = m_link_free_ps + m_latency_ps;
+        out.length = static_cast<std::uint32_t>(length);
+        out.reserved = 0;
+        std::memcpy(out.data, frame, length);
+
+        unsigned int delivered = 0;
+        bool flood = length < 6 || (frame[0] & 1) != 0;
+        if (!flood) {
+            flood = true;
+            for (unsigned int p = 0; p < NET_PORTS && flood; p++) {
+                const NetPort &port = m_segment->port[p];
+                if (p != m_port && port.state.load(std::memory_order_acquire) == NetPort::Running
+                    && std::memcmp(port.mac, frame, 6) == 0) {
+                    delivered += push(p, out) ? 1 : 0;
+                    flood = false;
+                }
+            }
+        }
+        if (flood) {
+            for (unsigned int p = 0; p < NET_PORTS; p++) {
+                if (p != m_port && m_segment->port[p].state.load(std::memory_order_acquire) == NetPort::Running) {
+                    delivered += push(p, out) ? 1 : 0;
+                }
+            }
+        }
+
+        if (delivered == 0) {
+            m_stats.tx_dropped++;
+        } else {
+            m_stats.tx_frames++;
+            m_stats.tx_bytes += length;
+        }
+        return fromPs(m_link_free_ps - now);
+    }
+
+    bool NetLink::push(unsigned int to, const NetFrame &frame) {
+        auto &ring = m_segment->ring[to][m_port];
+        unsigned int spins = 0;
+        while (!ring.push(frame)) {
+            /* the receiver may itself be waiting for room in one of our rings */
+            poll();
+            if (m_segment->port[to].state.load(std::memory_order_acquire) != NetPort::Running) {
+                return false;
+            }
+            backoff(spins);
+        }
+        return true;
+    }
+
+    void NetLink::poll() {
+        const std::uint64_t now = nowPs();
+        NetFrame frame;
+        for (unsigned int from = 0; from < NET_PORTS; from++) {
+            if (from == m_port) {
+                continue;
+            }
+            auto &ring = m_segment->ring[m_port][from];
+            while (ring.pop(frame)) {
+                if (m_backlog.size() >= MAX_BACKLOG) {
+                    m_stats.rx_dropped++;
+                    continue;
+                }
+                if (frame.time_ps < now) {
+                    m_stats.rx_late++;
+                }
+                m_backlog.emplace(std::max(frame.time_ps, now),
+                                  std::vector<std::uint8_t>(frame.data, frame.data + frame.length));
+            }
+        }
+        if (!m_backlog.empty()) {
+            m_arrival_event.notify(until(m_backlog.begin()->first));
+        }
+    }
+
+    void NetLink::deliver_method() {
+        const std::uint64_t now = nowPs();
+        while (!m_backlog.empty() && m_backlog.begin()->first <= now) {
+            auto first = m_backlog.begin();
+            m_stats.rx_frames++;
+            m_stats.rx_bytes += first->second.size();
+            if (m_on_receive) {
+                m_on_receive(first->second.data(), first->second.size());
+            }
+            m_backlog.erase(first);
+        }
+        if (!m_backlog.empty()) {
+            m_arrival_event.notify(until(m_backlog.begin()->first));
+        }
+    }
+
+    void NetLink::sync_thread() {
+        NetPort &self = m_segment->port[m_port];
+
+        /* time starts once enough boards are up, so that none runs ahead alone */
+        unsigned int spins = 0;
+        auto since = std::chrono::steady_clock::now();
+        bool announced = false;
+        while (true) {
+            unsigned int running = 0;
+            for (auto const &port : m_segment->port) {
+                running += port.state.load(std::memory_order_acquire) == NetPort::Running ? 1 : 0;
+            }
+            if (running >= m_nodes) {
+                break;
+            }
+            if (!announced && std::chrono::steady_clock::now() - since > std::chrono::seconds(1)) {
+                std::cout << "[net] " << name() << ": waiting for " << m_nodes - running << " more port(s) on "
+                          << m_shm.name() << "\n";
+                announced = true;
+            }
+            backoff(spins);
+        }
+
+        while (true) {
+            const std::uint64_t next = nowPs() + m_latency_ps;
+            self.grant_ps.store(next, std::memory_order_release);
+
+            /* advance by one latency once every running port has granted that far */
+            spins = 0;
+            while (true) {
+                bool ready = true;
+                for (unsigned int p = 0; p < NET_PORTS; p++) {
+                    NetPort &peer = m_segment->port[p];
+                    if (p == m_port || peer.state.load(std::memory_order_acquire) != NetPort::Running
+                        || peer.grant_ps.load(std::memory_order_acquire) >= next) {
+                        continue;
+                    }
+                    ready = false;
+                    if ((spins & 4095) == 4095 && !SharedMemory::processAlive(peer.pid.load())) {
+                        peer.state.store(NetPort::Finished, std::memory_order_release);     // crashed
+                    }
+                }
+                poll();     // everything sent before those grants
+                if (ready) {
+                    break;
+                }
+                backoff(spins);
+            }
+            wait(m_latency);
+        }
+    }
+}
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file PMP.cpp
+ * @brief PMP CSR handling, region decoding and the per-page cache fill
+ */
+
+#include "PMP.h"
+#include "Registers.h"
+
+namespace riscv_tlm {
+
+    namespace {
+        constexpr unsigned int PRIV_M = 3;
+    }
+
+    PMP::PMP(bool rv64, unsigned int entries) :
+            rv64(rv64), entries(entries > MAX_ENTRIES ? MAX_ENTRIES : entries), cache(1u << CACHE_BITS) {
+        decode();
+    }
+
+    std::uint64_t PMP::readCSR(int csr) const {
+        if (csr >= CSR_PMPADDR0) {
+            unsigned int i = csr - CSR_PMPADDR0;
+            return i < entries ? addr[i] : 0;
+        }
+
+        unsigned int reg = csr - CSR_PMPCFG0;
+        if (rv64 && (reg & 1)) {
+            /* odd pmpcfg registers do not exist on RV64 */
+            return 0;
+        }
+        unsigned int per_reg = rv64 ? 8 : 4;
+        std::uint64_t value = 0;
+        for (unsigned int b = 0; b < per_reg; b++) {
+            unsigned int i = reg * 4 + b;
+            if (i < entries) {
+                value |= static_cast<std::uint64_t>(cfg[i]) << (b * 8);
+            }
+        }
+        return value;
+    }
+
+    bool PMP::writeCSR(int csr, std::uint64_t value) {
+        bool changed = false;
+
+        if (csr >= CSR_PMPADDR0) {
+            unsigned int i = csr - CSR_PMPADDR0;
+            if (i >= entries || locked(i)) {
+                return false;
+            }
+            /* the next entry's TOR region uses this address as its base */
+            if (i + 1 < entries && locked(i + 1) && ((cfg[i + 1] & CFG_A) >> 3) == A_TOR) {
+                return false;
+            }
+            value &= rv64 ? (1ULL << 54) - 1 : 0xFFFFFFFFULL;
+            changed = addr[i] != value;
+            addr[i] = value;
+        } else {
+            unsigned int reg = csr - CSR_PMPCFG0;
+            if (rv64 && (reg & 1)) {
+                return false;
+            }
+            unsigned int per_reg = rv64 ? 8 : 4;
+            for (unsigned int b = 0; b < per_reg; b++) {
+                unsigned int i = reg * 4 + b;
+                if (i >= entries || locked(i)) {
+                    continue;
+                }
+                auto c = static_cast<std::uint8_t>(value >> (b * 8));
+                c &= CFG_R | CFG_W | CFG_X | CFG_A | CFG_L;
+                if (!(c & CFG_R)) {
+                    /* R=0 W=1 is reserved */
+                    c &= ~CFG_W;
+                }
+                changed |= cfg[i] != c;
+                cfg[i] = c;
+            }
+        }
+
+        if (changed) {
+            decode();
+        }
+        return changed;
+    }
+
+    void PMP::setState(std::uint64_t mstatus, unsigned int privilege) {
+        fetch_priv = privilege;
+        data_priv = privilege;
+        if ((mstatus & MSTATUS_MPRV) && privilege == PRIV_M) {
+            data_priv = (mstatus >> 11) & 3;
+        }
+        fetch_checked = entries > 0 && (fetch_priv != PRIV_M || any_locked);
+        data_checked = entries > 0 && (data_priv != PRIV_M || any_locked);
+    }
+
+    void PMP::fault(AccessType type, std::uint64_t tval) {
+        static constexpr unsigned int causes[] = {1, 5, 7};
+        throw MemoryFault{causes[static_cast<int>(type)], tval};
+    }
+
+    void PMP::decode() {
+        any_locked = false;
+        for (unsigned int i = 0; i < entries; i++) {
+            unsigned int a = (cfg[i] & CFG_A) >> 3;
+            active[i] = a != A_OFF;
+            switch (a) {
+                case A_TOR:
+                    first[i] = i == 0 ? 0 : addr[i - 1] << 2;
+                    last[i] = (addr[i] << 2) - 1;
+                    /* an empty TOR range matches nothing */
+                    active[i] = first[i] < (addr[i] << 2);
+                    break;
+                case A_NA4:
+                    first[i] = addr[i] << 2;
+                    last[i] = first[i] + 3;
+                    break;
+                case A_NAPOT: {
+                    /* trailing ones select the size: 2^(ones + 3) bytes */
+                    std::uint64_t ones = addr[i] & ~(addr[i] + 1);
+                    std::uint64_t mask = (ones << 3) | 7;
+                    first[i] = (addr[i] << 2) & ~mask;
+                    last[i] = first[i] | mask;
+                    break;
+                }
+                default:
+                    break;
+            }
+            any_locked |= locked(i);
+        }
+
+        if (++epoch == 0) {
+            for (auto &info : cache) {
+                info.epoch = 0;
+            }
+            epoch = 1;
+        }
+    }
+
+    void PMP::fillPage(PageInfo &info, std::uint64_t page) {
+        const std::uint64_t base = page << PAGE_SHIFT;
+        const std::uint64_t end = base + (1ULL << PAGE_SHIFT) - 1;
+
+        info.page = page;
+        info.epoch = epoch;
+        /* no entry touches the page: M has full access, S and U none */
+        info.uniform = true;
+        info.perm[0] = CFG_R | CFG_W | CFG_X;
+        info.perm[1] = 0;
+
+        for (unsigned int i = 0; i < entries; i++) {
+            if (!active[i] || last[i] < base || first[i] > end) {
+                continue;
+            }
+            /* the highest-priority entry touching the page decides */
+            if (first[i] <= base && last[i] >= end) {
+                std::uint8_t perm = cfg[i] & (CFG_R | CFG_W | CFG_X);
+                info.perm[0] = locked(i) ? perm : CFG_R | CFG_W | CFG_X;
+                info.perm[1] = perm;
+            } else {
+                info.uniform = false;
+            }
+            return;
+        }
+    }
+
+    bool PMP::matchEntries(std::uint64_t address, std::uint64_t size, AccessType type, unsigned int priv) const {
+        const std::uint64_t end = address + size - 1;
+
+        for (unsigned int i = 0; i < entries; i++) {
+            if (!active[i] || last[i] < address || first[i] > end) {
+                continue;
+            }
+            if (first[i] > address || last[i] < end) {
+                /* only some bytes of the access match */
+                return false;
+            }
+            if (priv == PRIV_M && !locked(i)) {
+                return true;
+            }
+            return (cfg[i] & permBit(type)) != 0;
+        }
+        return priv == PRIV_M;
+    }
+}
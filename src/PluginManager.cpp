@@ -0,0 +1,445 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file PluginManager.cpp
+ * @brief Loader and dispatcher for instrumentation plugins
+ */
+
+#include "PluginManager.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#if !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+#include "Registers.h"
+
+namespace riscv_tlm {
+
+bool PluginManager::s_active = false;
+PluginManager *PluginManager::instance = nullptr;
+
+/* Guest markers: slti x0, x0, 1 / slti x0, x0, 2 (HINT space, no-ops) */
+static constexpr std::uint32_t ROI_BEGIN_INSN = 0x00102013;
+static constexpr std::uint32_t ROI_END_INSN = 0x00202013;
+
+PluginManager *PluginManager::getInstance() {
+    if (instance == nullptr) {
+        instance = new PluginManager();
+    }
+    return instance;
+}
+
+bool PluginManager::load(const std::string &spec, unsigned int xlen) {
+    std::vector<std::string> parts;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        parts.push_back(item);
+    }
+    if (parts.empty() || parts[0].empty()) {
+        std::cerr << "Plugin: empty --plugin specification\n";
+        return false;
+    }
+
+#if defined(_WIN32)
+    (void) xlen;
+    std::cerr << "Plugin: shared-library plugins are not supported on this platform\n";
+    return false;
+#else
+    void *handle = dlopen(parts[0].c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        std::cerr << "Plugin: cannot load " << parts[0] << ": " << dlerror() << "\n";
+        return false;
+    }
+
+    auto *version = static_cast<int *>(dlsym(handle, "rvvp_plugin_version"));
+    using install_fn = int (*)(rvvp_plugin_id_t, const rvvp_plugin_info_t *, int, char **);
+    auto install = reinterpret_cast<install_fn>(dlsym(handle, "rvvp_plugin_install"));
+
+    if (version == nullptr || install == nullptr) {
+        std::cerr << "Plugin: " << parts[0] << " does not export rvvp_plugin_version/rvvp_plugin_install\n";
+        dlclose(handle);
+        return false;
+    }
+    if (*version != RVVP_PLUGIN_VERSION) {
+        std::cerr << "Plugin: " << parts[0] << " built for API version " << *version
+                  << ", simulator provides " << RVVP_PLUGIN_VERSION << "\n";
+        dlclose(handle);
+        return false;
+    }
+
+    Plugin p;
+    p.handle = handle;
+    p.path = parts[0];
+    plugins.push_back(p);
+    auto id = static_cast<rvvp_plugin_id_t>(plugins.size());
+
+    std::vector<char *> argv;
+    for (std::size_t i = 1; i < parts.size(); i++) {
+        argv.push_back(const_cast<char *>(parts[i].c_str()));
+    }
+    argv.push_back(nullptr);
+
+    rvvp_plugin_info_t info;
+    info.version = RVVP_PLUGIN_VERSION;
+    info.xlen = xlen;
+    info.n_harts = numHarts();
+
+    int ret = install(id, &info, static_cast<int>(argv.size() - 1), argv.data());
+    if (ret != 0) {
+        std::cerr << "Plugin: " << parts[0] << " install failed (" << ret << ")\n";
+        plugins.pop_back();
+        dlclose(handle);
+        return false;
+    }
+
+    std::cout << "Plugin: loaded " << parts[0] << "\n";
+    s_active = true;
+    return true;
+#endif
+}
+
+unsigned int PluginManager::registerHart(HartAccess access) {
+    Hart h;
+    h.access = std::move(access);
+    harts.push_back(std::move(h));
+    return static_cast<unsigned int>(harts.size() - 1);
+}
+
+/**
+ * @brief Does this encoding end a translation block (control transfer or system)?
+ */
+static bool endsBlock(std::uint32_t insn) {
+    if ((insn & 0x3) == 0x3) {
+        switch (insn & 0x7F) {
+            case 0x63: // branches
+            case 0x6F: // jal
+            case 0x67: // jalr
+            case 0x73: // ecall/ebreak/xret/wfi/csr
+                return true;
+            case 0x0F: // fence.i
+                return ((insn >> 12) & 0x7) == 0x1;
+            default:
+                return false;
+        }
+    }
+
+    std::uint32_t quadrant = insn & 0x3;
+    std::uint32_t funct3 = (insn >> 13) & 0x7;
+    if (quadrant == 1) {
+        // c.jal (RV32) / c.j / c.beqz / c.bnez
+        return funct3 == 1 || funct3 == 5 || funct3 == 6 || funct3 == 7;
+    }
+    if (quadrant == 2 && funct3 == 4) {
+        // c.jr / c.jalr / c.ebreak (rs2 == 0)
+        return ((insn >> 2) & 0x1F) == 0;
+    }
+    return false;
+}
+
+rvvp_plugin_tb *PluginManager::translate(unsigned int hart, std::uint64_t pc, std::uint32_t insn) {
+    auto tb = std::make_unique<rvvp_plugin_tb>();
+    tb->pc = pc;
+
+    std::uint64_t addr = pc;
+    std::uint32_t word = insn;
+    while (true) {
+        rvvp_plugin_insn rec;
+        rec.pc = addr;
+        rec.size = ((word & 0x3) == 0x3) ? 4 : 2;
+        rec.data = (rec.size == 4) ? word : (word & 0xFFFF);
+        if (rec.data == ROI_BEGIN_INSN) {
+            rec.roi = RVVP_ROI_BEGIN;
+        } else if (rec.data == ROI_END_INSN) {
+            rec.roi = RVVP_ROI_END;
+        }
+        tb->insns.push_back(std::move(rec));
+
+        if (endsBlock(word) || tb->insns.size() == MAX_TB_INSNS) {
+            break;
+        }
+        addr += tb->insns.back().size;
+        auto const &fetch = harts[hart].access.fetch;
+        if (!fetch || !fetch(addr, word)) {
+            break;
+        }
+    }
+
+    /* Subscriptions keep pointers into insns: it must not grow from here on */
+    for (std::size_t i = 0; i < plugins.size(); i++) {
+        if (plugins[i].tb_trans != nullptr) {
+            plugins[i].tb_trans(static_cast<rvvp_plugin_id_t>(i + 1), tb.get());
+        }
+    }
+    for (auto &rec : tb->insns) {
+        rec.instrumented = rec.roi >= 0 || !rec.exec_cbs.empty() || !rec.inline_ops.empty();
+    }
+
+    auto &slot = tb_cache[pc];
+    if (slot) {
+        stale_tbs.push_back(std::move(slot));
+    }
+    slot = std::move(tb);
+    return slot.get();
+}
+
+void PluginManager::onInsnExec(unsigned int hart, std::uint64_t pc, std::uint32_t insn) {
+    Hart &h = harts[hart];
+    current_hart = hart;
+
+    rvvp_plugin_insn *rec = nullptr;
+    if (h.tb != nullptr && h.next < h.tb->insns.size()) {
+        rvvp_plugin_insn &next = h.tb->insns[h.next];
+        std::uint32_t data = (next.size == 4) ? insn : (insn & 0xFFFF);
+        if (next.pc == pc && next.data == data) {
+            rec = &next;
+            h.next++;
+        }
+    }
+
+    if (rec == nullptr) {
+        rvvp_plugin_tb *tb = nullptr;
+        auto it = tb_cache.find(pc);
+        if (it != tb_cache.end()) {
+            rvvp_plugin_insn &first = it->second->insns.front();
+            std::uint32_t data = (first.size == 4) ? insn : (insn & 0xFFFF);
+            if (first.data == data) {
+                tb = it->second.get();
+            }
+        }
+        if (tb == nullptr) {
+            tb = translate(hart, pc, insn);
+        }
+        h.tb = tb;
+        h.next = 1;
+        rec = &tb->insns.front();
+        if (!stale_tbs.empty()) {
+            releaseStaleBlocks();
+        }
+    }
+
+    h.cur = rec;
+    if (rec->instrumented) {
+        execute(hart, *rec);
+    }
+}
+
+void PluginManager::releaseStaleBlocks() {
+    /* Plugins see blocks only inside callbacks, so a replaced block is in use only while a hart is in it */
+    stale_tbs.erase(std::remove_if(stale_tbs.begin(), stale_tbs.end(),
+                                   [this](std::unique_ptr<rvvp_plugin_tb> const &tb) {
+                                       return std::none_of(harts.begin(), harts.end(), [&tb](Hart const &h) {
+                                           return h.tb == tb.get();
+                                       });
+                                   }),
+                    stale_tbs.end());
+}
+
+void PluginManager::execute(unsigned int hart, rvvp_plugin_insn &insn) {
+    for (auto const &op : insn.inline_ops) {
+        if (op.counter != nullptr) {
+            *op.counter += op.imm;
+        } else {
+            auto *base = static_cast<std::uint8_t *>(scratchFor(op.scratch, hart));
+            std::uint64_t value;
+            std::memcpy(&value, base + op.offset, sizeof(value));
+            value += op.imm;
+            std::memcpy(base + op.offset, &value, sizeof(value));
+        }
+    }
+    for (auto const &cb : insn.exec_cbs) {
+        cb.cb(hart, cb.udata);
+    }
+    if (insn.roi >= 0) {
+        for (std::size_t i = 0; i < plugins.size(); i++) {
+            if (plugins[i].roi != nullptr) {
+                plugins[i].roi(static_cast<rvvp_plugin_id_t>(i + 1), hart, insn.roi);
+            }
+        }
+    }
+}
+
+void PluginManager::onTrap(std::uint64_t cause, std::uint64_t pc) {
+    for (std::size_t i = 0; i < plugins.size(); i++) {
+        if (plugins[i].trap != nullptr) {
+            plugins[i].trap(static_cast<rvvp_plugin_id_t>(i + 1), current_hart, cause, pc, 0);
+        }
+    }
+}
+
+void PluginManager::onInterrupt(unsigned int hart) {
+    if (hart >= harts.size() || !harts[hart].access.read_csr) {
+        return;
+    }
+    std::uint64_t cause = harts[hart].access.read_csr(CSR_MCAUSE);
+    std::uint64_t epc = harts[hart].access.read_csr(CSR_MEPC);
+    for (std::size_t i = 0; i < plugins.size(); i++) {
+        if (plugins[i].trap != nullptr) {
+            plugins[i].trap(static_cast<rvvp_plugin_id_t>(i + 1), hart, cause, epc, 1);
+        }
+    }
+}
+
+void PluginManager::shutdown() {
+    for (std::size_t i = 0; i < plugins.size(); i++) {
+        for (auto const &cb : plugins[i].atexit) {
+            cb.first(static_cast<rvvp_plugin_id_t>(i + 1), cb.second);
+        }
+    }
+#if !defined(_WIN32)
+    for (auto &p : plugins) {
+        dlclose(p.handle);
+    }
+#endif
+    plugins.clear();
+    for (auto &h : harts) {
+        h.tb = nullptr;
+        h.cur = nullptr;
+    }
+    tb_cache.clear();
+    stale_tbs.clear();
+    s_active = false;
+}
+
+PluginManager::Plugin *PluginManager::plugin(rvvp_plugin_id_t id) {
+    if (id == 0 || id > plugins.size()) {
+        return nullptr;
+    }
+    return &plugins[id - 1];
+}
+
+rvvp_plugin_scratch *PluginManager::newScratch(size_t size) {
+    auto s = std::make_unique<rvvp_plugin_scratch>();
+    s->size = size;
+    scratches.push_back(std::move(s));
+    return scratches.back().get();
+}
+
+void *PluginManager::scratchFor(rvvp_plugin_scratch *scratch, unsigned int hart) {
+    if (hart >= scratch->per_hart.size()) {
+        scratch->per_hart.resize(hart + 1);
+    }
+    auto &area = scratch->per_hart[hart];
+    if (!area) {
+        area.reset(new std::uint8_t[scratch->size]());
+    }
+    return area.get();
+}
+
+std::uint64_t PluginManager::readRegister(unsigned int hart, unsigned int reg) const {
+    if (hart >= harts.size() || !harts[hart].access.read_reg || reg > 32) {
+        return 0;
+    }
+    return harts[hart].access.read_reg(reg);
+}
+
+} // namespace riscv_tlm
+
+/* ========================================================================== */
+/* C API                                                                      */
+/* ========================================================================== */
+
+using riscv_tlm::PluginManager;
+
+extern "C" {
+
+void rvvp_plugin_register_tb_trans_cb(rvvp_plugin_id_t id, rvvp_plugin_tb_trans_cb_t cb) {
+    if (auto *p = PluginManager::getInstance()->plugin(id)) {
+        p->tb_trans = cb;
+    }
+}
+
+void rvvp_plugin_register_trap_cb(rvvp_plugin_id_t id, rvvp_plugin_trap_cb_t cb) {
+    if (auto *p = PluginManager::getInstance()->plugin(id)) {
+        p->trap = cb;
+    }
+}
+
+void rvvp_plugin_register_roi_cb(rvvp_plugin_id_t id, rvvp_plugin_roi_cb_t cb) {
+    if (auto *p = PluginManager::getInstance()->plugin(id)) {
+        p->roi = cb;
+    }
+}
+
+void rvvp_plugin_register_atexit_cb(rvvp_plugin_id_t id, rvvp_plugin_atexit_cb_t cb, void *udata) {
+    if (auto *p = PluginManager::getInstance()->plugin(id)) {
+        p->atexit.emplace_back(cb, udata);
+    }
+}
+
+size_t rvvp_plugin_tb_n_insns(const struct rvvp_plugin_tb *tb) {
+    return tb->insns.size();
+}
+
+uint64_t rvvp_plugin_tb_vaddr(const struct rvvp_plugin_tb *tb) {
+    return tb->pc;
+}
+
+struct rvvp_plugin_insn *rvvp_plugin_tb_get_insn(const struct rvvp_plugin_tb *tb, size_t idx) {
+    if (idx >= tb->insns.size()) {
+        return nullptr;
+    }
+    return const_cast<rvvp_plugin_insn *>(&tb->insns[idx]);
+}
+
+uint64_t rvvp_plugin_insn_vaddr(const struct rvvp_plugin_insn *insn) {
+    return insn->pc;
+}
+
+uint32_t rvvp_plugin_insn_data(const struct rvvp_plugin_insn *insn) {
+    return insn->data;
+}
+
+unsigned int rvvp_plugin_insn_size(const struct rvvp_plugin_insn *insn) {
+    return insn->size;
+}
+
+void rvvp_plugin_register_insn_exec_cb(struct rvvp_plugin_insn *insn,
+                                       rvvp_plugin_insn_exec_cb_t cb, void *udata) {
+    insn->exec_cbs.push_back({cb, udata});
+}
+
+void rvvp_plugin_register_insn_mem_cb(struct rvvp_plugin_insn *insn,
+                                      rvvp_plugin_mem_cb_t cb, void *udata) {
+    insn->mem_cbs.push_back({cb, udata});
+}
+
+void rvvp_plugin_register_insn_exec_inline_add(struct rvvp_plugin_insn *insn,
+                                               uint64_t *counter, uint64_t imm) {
+    insn->inline_ops.push_back({counter, nullptr, 0, imm});
+}
+
+struct rvvp_plugin_scratch *rvvp_plugin_scratch_new(size_t size) {
+    return PluginManager::getInstance()->newScratch(size);
+}
+
+void *rvvp_plugin_scratch_get(struct rvvp_plugin_scratch *scratch, unsigned int hart) {
+    return PluginManager::getInstance()->scratchFor(scratch, hart);
+}
+
+void rvvp_plugin_register_insn_exec_inline_add_per_hart(struct rvvp_plugin_insn *insn,
+                                                        struct rvvp_plugin_scratch *scratch,
+                                                        size_t offset, uint64_t imm) {
+    if (offset + sizeof(uint64_t) > scratch->size) {
+        return;
+    }
+    insn->inline_ops.push_back({nullptr, scratch, offset, imm});
+}
+
+uint64_t rvvp_plugin_read_register(unsigned int hart, unsigned int reg) {
+    return PluginManager::getInstance()->readRegister(hart, reg);
+}
+
+unsigned int rvvp_plugin_n_harts(void) {
+    return PluginManager::getInstance()->numHarts();
+}
+
+void rvvp_plugin_outs(const char *msg) {
+    std::cout << msg << std::flush;
+}
+
+} // extern "C"
@@ -0,0 +1,233 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file RegisterBank.cpp
+ * @brief Decode tables, access policies and DMI of a peripheral register file
+ */
+
+#include "RegisterBank.h"
+
+#include <cstring>
+
+#include "systemc"
+
+namespace riscv_tlm { namespace peripherals {
+
+namespace {
+    std::uint64_t bitsOf(unsigned int lsb, unsigned int width) {
+        if (lsb >= 64 || width == 0) {
+            return 0;
+        }
+        const std::uint64_t ones = width >= 64 ? ~0ULL : (1ULL << width) - 1;
+        return ones << lsb;
+    }
+}
+
+void RegisterBank::build() {
+    m_entries.clear();
+    m_pages.clear();
+    m_page_of.assign((m_size + PAGE_SIZE - 1) / PAGE_SIZE, -1);
+
+    for (std::uint32_t r = 0; r < m_table.size(); r++) {
+        Register &reg = m_table[r];
+        if (reg.m_bytes != 4 && reg.m_bytes != 8) {
+            SC_REPORT_ERROR("RegisterBank", (reg.m_name + ": registers are 4 or 8 bytes").c_str());
+            continue;
+        }
+
+        /* policy of every implemented bit: the register's, unless a field says otherwise */
+        reg.m_implemented = reg.m_mask & bitsOf(0, 8 * reg.m_bytes);
+        std::uint64_t policy[4] = {0, 0, 0, 0};
+        std::uint64_t in_fields = 0;
+        for (auto const &field : reg.m_fields) {
+            const std::uint64_t bits = bitsOf(field.lsb, field.width) & reg.m_implemented;
+            policy[static_cast<unsigned int>(field.access)] |= bits;
+            in_fields |= bits;
+        }
+        policy[static_cast<unsigned int>(reg.m_access)] |= reg.m_implemented & ~in_fields;
+        reg.m_rw = policy[static_cast<unsigned int>(Access::RW)];
+        reg.m_wo = policy[static_cast<unsigned int>(Access::WO)];
+        reg.m_w1c = policy[static_cast<unsigned int>(Access::W1C)];
+
+        const std::uint64_t stride = reg.m_stride != 0 ? reg.m_stride : reg.m_bytes;
+        for (std::uint32_t i = 0; i < reg.m_count; i++) {
+            const std::uint64_t offset = reg.m_offset + i * stride;
+            if (offset % 4 != 0 || offset + reg.m_bytes > m_size
+                || offset / PAGE_SIZE != (offset + reg.m_bytes - 1) / PAGE_SIZE) {
+                SC_REPORT_ERROR("RegisterBank", (reg.m_name + ": offset outside the window or misaligned").c_str());
+                break;
+            }
+            std::int32_t &page = m_page_of[offset / PAGE_SIZE];
+            if (page < 0) {
+                page = static_cast<std::int32_t>(m_pages.size());
+                m_pages.emplace_back(new Page());
+            }
+            Page &p = *m_pages[page];
+            const unsigned int first = static_cast<unsigned int>((offset % PAGE_SIZE) / 4);
+            const unsigned int slots = reg.m_bytes / 4;
+            bool overlap = false;
+            for (unsigned int s = first; s < first + slots; s++) {
+                overlap |= p.slot[s] != 0;
+            }
+            if (overlap) {
+                SC_REPORT_ERROR("RegisterBank", (reg.m_name + ": overlaps another register").c_str());
+                break;
+            }
+
+            m_entries.push_back({offset, r, i, &p.image[offset % PAGE_SIZE]});
+            for (unsigned int s = first; s < first + slots; s++) {
+                p.slot[s] = static_cast<std::uint32_t>(m_entries.size());
+            }
+            store(m_entries.back(), reg.m_reset & reg.m_implemented & ~reg.m_wo);
+        }
+    }
+    m_built = true;
+}
+
+const RegisterBank::Entry &RegisterBank::at(std::uint64_t offset) {
+    if (!m_built) {
+        build();
+    }
+    const Entry *entry = offset < m_size ? decode(offset) : nullptr;
+    if (entry == nullptr || entry->offset != offset) {
+        SC_REPORT_FATAL("RegisterBank", "no register at this offset");
+    }
+    return *entry;
+}
+
+bool RegisterBank::readable(std::int32_t page, unsigned int slot) const {
+    std::uint32_t s = m_pages[page]->slot[slot];
+    if (s == 0) {
+        return !m_strict;       // reads as 0, and the image holds 0 there
+    }
+    return !m_table[m_entries[s - 1].reg].m_read;
+}
+
+std::uint64_t RegisterBank::load(const Entry &entry) const {
+    std::uint64_t value = 0;
+    std::memcpy(&value, entry.image, m_table[entry.reg].m_bytes);
+    return value;
+}
+
+void RegisterBank::store(const Entry &entry, std::uint64_t value) {
+    std::memcpy(entry.image, &value, m_table[entry.reg].m_bytes);
+}
+
+std::uint64_t RegisterBank::read(const Entry &entry) {
+    const Register &reg = m_table[entry.reg];
+    if (reg.m_read) {
+        return reg.m_read(entry.index) & reg.m_implemented & ~reg.m_wo;
+    }
+    return load(entry);
+}
+
+void RegisterBank::write(const Entry &entry, std::uint64_t data, std::uint64_t bytes) {
+    const Register &reg = m_table[entry.reg];
+    std::uint64_t value = load(entry);
+    value = (value & ~(reg.m_rw & bytes)) | (data & reg.m_rw & bytes);
+    value &= ~(data & reg.m_w1c & bytes);
+    store(entry, value);
+    if (reg.m_write) {
+        reg.m_write(entry.index, value | (data & reg.m_wo & bytes));
+    }
+}
+
+void RegisterBank::access(tlm::tlm_generic_payload &trans) {
+    if (!m_built) {
+        build();
+    }
+    const std::uint64_t offset = trans.get_address();
+    const unsigned int len = trans.get_data_length();
+    unsigned char *ptr = trans.get_data_ptr();
+
+    if (offset >= m_size || m_size - offset < len) {
+        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        return;
+    }
+    if (len == 0 || len > 8 || (len & (len - 1)) != 0 || (m_sizes & len) == 0 || offset % len != 0) {
+        trans.set_response_status(tlm::TLM_BURST_ERROR_RESPONSE);
+        return;
+    }
+    if (trans.get_byte_enable_ptr() != nullptr) {
+        trans.set_response_status(tlm::TLM_BYTE_ENABLE_ERROR_RESPONSE);
+        return;
+    }
+
+    /* an aligned access covers one slot, or two for 8 bytes */
+    const Entry *entries[2] = {decode(offset), len == 8 ? decode(offset + 4) : nullptr};
+    if (entries[1] == entries[0]) {
+        entries[1] = nullptr;
+    }
+    if (m_strict && (entries[0] == nullptr || (len == 8 && entries[1] == nullptr && decode(offset + 4) == nullptr))) {
+        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        return;
+    }
+
+    const bool is_write = trans.get_command() == tlm::TLM_WRITE_COMMAND;
+    if (!is_write) {
+        std::memset(ptr, 0, len);
+    }
+    for (const Entry *entry : entries) {
+        if (entry == nullptr) {
+            continue;
+        }
+        /* bytes of the access and of the register that overlap */
+        const unsigned int bytes = m_table[entry->reg].m_bytes;
+        const std::uint64_t first = offset > entry->offset ? offset : entry->offset;
+        const std::uint64_t end = offset + len < entry->offset + bytes ? offset + len : entry->offset + bytes;
+        const unsigned int shift = static_cast<unsigned int>(8 * (first - entry->offset));
+        const unsigned int count = static_cast<unsigned int>(end - first);
+
+        if (is_write) {
+            std::uint64_t data = 0;
+            std::memcpy(&data, ptr + (first - offset), count);
+            write(*entry, data << shift, bitsOf(shift, 8 * count));
+        } else {
+            std::uint64_t value = read(*entry) >> shift;
+            std::memcpy(ptr + (first - offset), &value, count);
+        }
+    }
+    trans.set_response_status(tlm::TLM_OK_RESPONSE);
+}
+
+bool RegisterBank::dmi(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi_data) {
+    if (!m_built) {
+        build();
+    }
+    const std::uint64_t offset = trans.get_address();
+    dmi_data.allow_none();
+    dmi_data.set_read_latency(sc_core::SC_ZERO_TIME);
+    dmi_data.set_write_latency(sc_core::SC_ZERO_TIME);
+    if (offset >= m_size) {
+        dmi_data.set_start_address(m_size);
+        dmi_data.set_end_address(~0ULL);
+        return false;
+    }
+
+    const std::uint64_t base = offset - offset % PAGE_SIZE;
+    const std::int32_t page = m_page_of[offset / PAGE_SIZE];
+    if (page < 0) {
+        dmi_data.set_start_address(base);
+        dmi_data.set_end_address((base + PAGE_SIZE < m_size ? base + PAGE_SIZE : m_size) - 1);
+        return false;
+    }
+
+    unsigned int first = static_cast<unsigned int>((offset % PAGE_SIZE) / 4);
+    unsigned int last = first;
+    const bool allowed = readable(page, first);
+    while (first > 0 && readable(page, first - 1) == allowed) {
+        first--;
+    }
+    while (last + 1 < SLOTS && base + 4 * (last + 1) < m_size && readable(page, last + 1) == allowed) {
+        last++;
+    }
+    dmi_data.set_start_address(base + 4 * first);
+    dmi_data.set_end_address(base + 4 * last + 3);
+    if (!allowed) {
+        return false;
+    }
+    dmi_data.set_dmi_ptr(&m_pages[page]->image[4 * first]);
+    dmi_data.allow_read();
+    return true;
+}
+
+}} // namespace
@@ -12,8 +12,8 @@ namespace riscv_tlm {
     /* Specialization for each XLEN (RV32, RV64)*/
     template<>
     void Registers<std::uint32_t>::initCSR() {
-        CSR[CSR_MISA] = MISA_MXL | MISA_M_EXTENSION | MISA_C_EXTENSION
-                        | MISA_A_EXTENSION | MISA_I_BASE;
+        /* the CPU model adds its extensions with setExtensions() */
+        CSR[CSR_MISA] = MISA_MXL | MISA_I_BASE;
         CSR[CSR_MSTATUS] = MISA_MXL;
     }
 
@@ -100,8 +100,8 @@ namespace riscv_tlm {
 
     template<>
     void Registers<std::uint64_t>::initCSR() {
-        CSR[CSR_MISA] = (((std::uint64_t) 0x02) << 30) | MISA_M_EXTENSION | MISA_C_EXTENSION
-                        | MISA_A_EXTENSION | MISA_I_BASE;
+        /* the CPU model adds its extensions with setExtensions() */
+        CSR[CSR_MISA] = (((std::uint64_t) 0x02) << 30) | MISA_I_BASE;
         CSR[CSR_MSTATUS] = MISA_MXL;
     }
 
@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file RunControl.cpp
+ * @brief Stop and pause conditions and the ELF symbol table reader
+ */
+
+#include "RunControl.h"
+#include "Performance.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "systemc"
+
+namespace riscv_tlm {
+
+    bool RunControl::s_armed = false;
+    bool RunControl::s_watch_writes = false;
+
+    namespace {
+        constexpr std::uint64_t NEVER = std::numeric_limits<std::uint64_t>::max();
+
+        std::uint64_t field(const std::vector<char> &image, std::size_t offset, unsigned int bytes) {
+            std::uint64_t value = 0;
+            if (offset + bytes <= image.size()) {
+                std::memcpy(&value, image.data() + offset, bytes);    // little-endian hosts and targets
+            }
+            return value;
+        }
+
+        bool number(const std::string &text, std::uint64_t &value) {
+            try {
+                std::size_t used = 0;
+                value = std::stoull(text, &used, 0);
+                return used == text.size();
+            } catch (...) {
+                return false;
+            }
+        }
+    }
+
+    RunControl *RunControl::getInstance() {
+        static RunControl instance;
+        return &instance;
+    }
+
+    bool RunControl::loadSymbols(const std::string &elf_path, std::string &error) {
+        std::ifstream file(elf_path, std::ios::binary);
+        if (!file) {
+            error = "cannot open " + elf_path;
+            return false;
+        }
+        std::vector<char> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (image.size() < 0x34 || std::memcmp(image.data(), "\177ELF", 4) != 0 || image[5] != 1) {
+            error = elf_path + " is not a little-endian ELF file";
+            return false;
+        }
+
+        const bool elf64 = image[4] == 2;
+        const std::uint64_t shoff = elf64 ? field(image, 0x28, 8) : field(image, 0x20, 4);
+        const std::uint64_t shentsize = field(image, elf64 ? 0x3A : 0x2E, 2);
+        const std::uint64_t shnum = field(image, elf64 ? 0x3C : 0x30, 2);
+
+        auto section = [&](std::uint64_t index, unsigned int what) {
+            // what: 0 type, 1 offset, 2 size, 3 link
+            const std::size_t base = shoff + index * shentsize;
+            static const unsigned int off64[] = {4, 24, 32, 40};
+            static const unsigned int off32[] = {4, 16, 20, 24};
+            if (what == 0 || what == 3) {
+                return field(image, base + (elf64 ? off64[what] : off32[what]), 4);
+            }
+            return field(image, base + (elf64 ? off64[what] : off32[what]), elf64 ? 8 : 4);
+        };
+
+        std::size_t found = 0;
+        for (std::uint64_t s = 0; s < shnum; s++) {
+            if (section(s, 0) != 2) {   // SHT_SYMTAB
+                continue;
+            }
+            const std::uint64_t symoff = section(s, 1);
+            const std::uint64_t symsize = section(s, 2);
+            const std::uint64_t stroff = section(section(s, 3), 1);
+            const std::uint64_t entsize = elf64 ? 24 : 16;
+
+            for (std::uint64_t e = entsize; e + entsize <= symsize; e += entsize) {
+                const std::size_t sym = symoff + e;
+                const std::uint64_t name = field(image, sym, 4);
+                const std::uint64_t value = elf64 ? field(image, sym + 8, 8) : field(image, sym + 4, 4);
+                const std::uint64_t shndx = field(image, sym + (elf64 ? 6 : 14), 2);
+                const unsigned int type = field(image, sym + (elf64 ? 4 : 12), 1) & 0xF;
+                if (shndx == 0 || type > 2 || stroff + name >= image.size()) {  // NOTYPE, OBJECT, FUNC
+                    continue;
+                }
+                const char *str = image.data() + stroff + name;
+                const std::size_t len = strnlen(str, image.size() - (stroff + name));
+                if (len != 0) {
+                    symbols[std::string(str, len)] = value;
+                    found++;
+                }
+            }
+        }
+
+        if (found == 0) {
+            error = elf_path + " has no symbol table";
+            return false;
+        }
+        return true;
+    }
+
+    bool RunControl::resolve(const std::string &text, std::uint64_t &addr) const {
+        if (number(text, addr)) {
+            return true;
+        }
+        auto it = symbols.find(text);
+        if (it == symbols.end()) {
+            return false;
+        }
+        addr = it->second;
+        return true;
+    }
+
+    bool RunControl::add(const std::string &spec, Action action, std::string &error) {
+        std::string::size_type eq = spec.find('=');
+        if (eq == std::string::npos) {
+            error = "expected <condition>=<value>: " + spec;
+            return false;
+        }
+        const std::string key = spec.substr(0, eq);
+        std::string value = spec.substr(eq + 1);
+
+        Condition cond{Kind::PC, action, 0, 0, false, false, spec};
+        if (key == "instr" || key == "cycle") {
+            cond.kind = key == "instr" ? Kind::Instructions : Kind::Cycles;
+            if (!number(value, cond.value) || cond.value == 0) {
+                error = "expected a positive count: " + spec;
+                return false;
+            }
+        } else if (key == "pc" || key == "enter" || key == "exit") {
+            if (!resolve(value, cond.value)) {
+                error = "unknown address or symbol (see --symbols): " + spec;
+                return false;
+            }
+            if (key == "exit") {
+                cond.kind = Kind::Exit;
+                cond.entry = cond.value;
+            }
+        } else if (key == "write") {
+            cond.kind = Kind::Write;
+            cond.entry = 1;
+            std::string::size_type plus = value.find('+');
+            if (plus != std::string::npos) {
+                if (!number(value.substr(plus + 1), cond.entry) || cond.entry == 0) {
+                    error = "expected write=<address>+<length>: " + spec;
+                    return false;
+                }
+                value = value.substr(0, plus);
+            }
+            if (!resolve(value, cond.value)) {
+                error = "unknown address or symbol (see --symbols): " + spec;
+                return false;
+            }
+            s_watch_writes = true;
+        } else {
+            error = "unknown condition: " + spec;
+            return false;
+        }
+
+        conditions.push_back(cond);
+        s_armed = true;
+        return true;
+    }
+
+    void RunControl::clear() {
+        conditions.clear();
+        s_armed = false;
+        s_watch_writes = false;
+    }
+
+    bool RunControl::matches(Condition &cond, std::uint64_t pc, std::uint64_t cycle, std::uint64_t ra) {
+        switch (cond.kind) {
+            case Kind::Instructions:
+                return Performance::getInstance()->getInstructions() == cond.value;
+            case Kind::Cycles:
+                if (cycle < cond.value) {
+                    return false;
+                }
+                cond.value = NEVER;
+                return true;
+            case Kind::PC:
+                return pc == cond.value;
+            case Kind::Exit:
+                // value alternates between the function and the return address of the current call
+                if (pc != cond.value) {
+                    return false;
+                }
+                cond.returning = !cond.returning;
+                cond.value = cond.returning ? ra : cond.entry;
+                return !cond.returning;
+            case Kind::Write:
+                if (!cond.written) {
+                    return false;
+                }
+                cond.written = false;
+                return true;
+        }
+        return false;
+    }
+
+    bool RunControl::retire(std::uint64_t pc, std::uint64_t cycle, std::uint64_t ra) {
+        bool fired = false;
+        bool stop = false;
+        for (auto &cond : conditions) {
+            if (matches(cond, pc, cycle, ra)) {
+                hits.push_back({cond.text, cond.action, Performance::getInstance()->getInstructions(), cycle, pc});
+                fired = true;
+                stop |= cond.action == Action::Stop;
+            }
+        }
+        if (fired) {
+            if (stop) {
+                sc_core::sc_stop();
+            } else {
+                sc_core::sc_pause();
+            }
+        }
+        return fired;
+    }
+
+    void RunControl::write(std::uint64_t addr, unsigned int size) {
+        for (auto &cond : conditions) {
+            if (cond.kind == Kind::Write && addr < cond.value + cond.entry && cond.value < addr + size) {
+                cond.written = true;
+            }
+        }
+    }
+
+    bool RunControl::takeHit(Hit &hit) {
+        if (hits.empty()) {
+            return false;
+        }
+        hit = hits.front();
+        hits.pop_front();
+        return true;
+    }
+}
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file SelfProfile.cpp
+ * @brief Host-time attribution of simulator components
+ */
+
+#include "SelfProfile.h"
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace riscv_tlm {
+
+SelfProfile *SelfProfile::instance = nullptr;
+
+SelfProfile *SelfProfile::getInstance() {
+    if (instance == nullptr) {
+        instance = new SelfProfile();
+    }
+    return instance;
+}
+
+SelfProfile::SelfProfile() = default;
+
+void SelfProfile::setEnabled(bool enable) {
+    if (enable && !enabled) {
+        calib_ticks = now();
+        calib_time = std::chrono::steady_clock::now();
+        openCounters();
+    }
+    enabled = enable;
+}
+
+#if defined(__linux__)
+static int perfEventOpen(std::uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (group_fd == -1) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+#endif
+
+void SelfProfile::openCounters() {
+#if defined(__linux__)
+    const std::uint64_t configs[NUM_HW_COUNTERS] = {
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    perf_fd[0] = perfEventOpen(configs[0], -1);
+    if (perf_fd[0] < 0) {
+        std::cout << "SelfProfile: perf_event_open unavailable (check "
+                     "/proc/sys/kernel/perf_event_paranoid); host counters disabled\n";
+        return;
+    }
+    for (unsigned i = 1; i < NUM_HW_COUNTERS; i++) {
+        perf_fd[i] = perfEventOpen(configs[i], perf_fd[0]);
+    }
+    ioctl(perf_fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(perf_fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+bool SelfProfile::readCounters(std::array<std::uint64_t, NUM_HW_COUNTERS> &values) const {
+    values.fill(0);
+#if defined(__linux__)
+    if (perf_fd[0] < 0) {
+        return false;
+    }
+    /* PERF_FORMAT_GROUP: nr, then one value per opened member in creation order */
+    std::uint64_t buf[1 + NUM_HW_COUNTERS] = {0};
+    if (::read(perf_fd[0], buf, sizeof(buf)) <= 0) {
+        return false;
+    }
+    unsigned idx = 1;
+    for (unsigned i = 0; i < NUM_HW_COUNTERS && idx <= buf[0]; i++) {
+        if (perf_fd[i] >= 0) {
+            values[i] = buf[idx++];
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SelfProfile::beginPhase(Phase p) {
+    if (!enabled) {
+        return;
+    }
+    phase_start = std::chrono::steady_clock::now();
+    phases[p].valid = readCounters(phase_base);
+}
+
+void SelfProfile::endPhase(Phase p) {
+    if (!enabled) {
+        return;
+    }
+    std::array<std::uint64_t, NUM_HW_COUNTERS> end{};
+    PhaseCounters &pc = phases[p];
+    pc.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - phase_start).count();
+    if (pc.valid && readCounters(end)) {
+        pc.instructions += end[0] - phase_base[0];
+        pc.cycles += end[1] - phase_base[1];
+        pc.cache_misses += end[2] - phase_base[2];
+        pc.branch_misses += end[3] - phase_base[3];
+    }
+}
+
+void SelfProfile::dump(std::uint64_t delta_cycles) const {
+    if (!enabled) {
+        return;
+    }
+
+    static const char *const component_names[NumComponents] = {
+            "decode", "execute", "bus routing", "memory",
+            "peripherals", "logging", "SystemC kernel/other",
+    };
+    static const char *const phase_names[NumPhases] = {
+            "elaboration", "simulation",
+    };
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - calib_time).count();
+    double ticks_per_sec = wall > 0 ? static_cast<double>(now() - calib_ticks) / wall : 0.0;
+
+    std::uint64_t total = 0;
+    for (auto t : ticks) total += t;
+
+    std::cout << "\n=== Self-Profile (host time) ===\n";
+    std::cout << std::left << std::setw(24) << "component"
+              << std::right << std::setw(12) << "seconds"
+              << std::setw(9) << "%"
+              << std::setw(16) << "scopes" << "\n";
+    for (unsigned c = 0; c < NumComponents; c++) {
+        double secs = ticks_per_sec > 0 ? static_cast<double>(ticks[c]) / ticks_per_sec : 0.0;
+        double pct = total > 0 ? 100.0 * static_cast<double>(ticks[c]) / static_cast<double>(total) : 0.0;
+        std::cout << std::left << std::setw(24) << component_names[c]
+                  << std::right << std::fixed << std::setprecision(3) << std::setw(12) << secs
+                  << std::setprecision(1) << std::setw(9) << pct
+                  << std::setw(16) << calls[c] << "\n";
+    }
+    std::cout << "SystemC delta cycles:   " << delta_cycles << "\n";
+
+    for (unsigned p = 0; p < NumPhases; p++) {
+        const PhaseCounters &pc = phases[p];
+        std::cout << "Phase " << std::left << std::setw(12) << phase_names[p] << std::right
+                  << std::fixed << std::setprecision(3) << pc.seconds << " s";
+        if (pc.valid && pc.cycles > 0) {
+            std::cout << std::setprecision(2)
+                      << "  IPC " << static_cast<double>(pc.instructions) / static_cast<double>(pc.cycles)
+                      << "  cache-miss " << pc.cache_misses
+                      << "  branch-miss " << pc.branch_misses;
+        }
+        std::cout << "\n";
+    }
+}
+
+} // namespace riscv_tlm
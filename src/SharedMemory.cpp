@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file SharedMemory.cpp
+ * @brief POSIX shared-memory objects
+ */
+
+#include "SharedMemory.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace riscv_tlm {
+
+#ifndef _WIN32
+    namespace {
+        void *map(int fd, std::size_t size) {
+            void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            return addr == MAP_FAILED ? nullptr : addr;
+        }
+    }
+
+    bool SharedMemory::create(const std::string &name, std::size_t size, unsigned int mode, std::string &error) {
+        close();
+        shm_unlink(name.c_str());   // left behind by a crashed run
+        const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, static_cast<mode_t>(mode));
+        if (fd < 0) {
+            error = name + ": " + std::strerror(errno);
+            return false;
+        }
+        /* shm_open applies the umask */
+        fchmod(fd, static_cast<mode_t>(mode));
+        void *addr = ftruncate(fd, static_cast<off_t>(size)) == 0 ? map(fd, size) : nullptr;
+        if (addr == nullptr) {
+            error = name + ": " + std::strerror(errno);
+            ::close(fd);
+            shm_unlink(name.c_str());
+            return false;
+        }
+        ::close(fd);
+        m_addr = addr;
+        m_size = size;
+        m_name = name;
+        m_owner = true;
+        return true;
+    }
+
+    bool SharedMemory::attach(const std::string &name, std::size_t size, std::string &error) {
+        close();
+        const int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            error = name + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < size) {
+            error = name + ": not created yet";
+            ::close(fd);
+            return false;
+        }
+        void *addr = map(fd, size);
+        ::close(fd);
+        if (addr == nullptr) {
+            error = name + ": " + std::strerror(errno);
+            return false;
+        }
+        m_addr = addr;
+        m_size = size;
+        m_name = name;
+        m_owner = false;
+        return true;
+    }
+
+    bool SharedMemory::open(const std::string &name, std::size_t size, unsigned int mode, bool &created,
+                            std::string &error) {
+        close();
+        created = false;
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, static_cast<mode_t>(mode));
+        if (fd >= 0) {
+            fchmod(fd, static_cast<mode_t>(mode));
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                error = name + ": " + std::strerror(errno);
+                ::close(fd);
+                shm_unlink(name.c_str());
+                return false;
+            }
+            created = true;
+        } else if (errno == EEXIST) {
+            fd = shm_open(name.c_str(), O_RDWR, 0);
+            /* the creator sizes the object right after creating it */
+            struct stat st{};
+            for (int tries = 0; fd >= 0 && fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) < size
+                                && tries < 1000; tries++) {
+                usleep(1000);
+            }
+            if (fd >= 0 && static_cast<std::size_t>(st.st_size) < size) {
+                error = name + ": exists with another size";
+                ::close(fd);
+                return false;
+            }
+        }
+        if (fd < 0) {
+            error = name + ": " + std::strerror(errno);
+            return false;
+        }
+        void *addr = map(fd, size);
+        ::close(fd);
+        if (addr == nullptr) {
+            error = name + ": " + std::strerror(errno);
+            return false;
+        }
+        m_addr = addr;
+        m_size = size;
+        m_name = name;
+        m_owner = false;
+        return true;
+    }
+
+    void SharedMemory::remove(const std::string &name) {
+        shm_unlink(name.c_str());
+    }
+
+    std::uint32_t SharedMemory::processId() {
+        return static_cast<std::uint32_t>(getpid());
+    }
+
+    bool SharedMemory::processAlive(std::uint32_t pid) {
+        return kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+    }
+
+    void SharedMemory::close() {
+        if (m_addr == nullptr) {
+            return;
+        }
+        munmap(m_addr, m_size);
+        if (m_owner) {
+            shm_unlink(m_name.c_str());
+        }
+        m_addr = nullptr;
+        m_size = 0;
+        m_owner = false;
+    }
+#else
+    bool SharedMemory::create(const std::string &name, std::size_t size, unsigned int mode, std::string &error) {
+        (void) size;
+        (void) mode;
+        error = name + ": shared memory needs a POSIX host";
+        return false;
+    }
+
+    bool SharedMemory::attach(const std::string &name, std::size_t size, std::string &error) {
+        (void) size;
+        error = name + ": shared memory needs a POSIX host";
+        return false;
+    }
+
+    bool SharedMemory::open(const std::string &name, std::size_t size, unsigned int mode, bool &created,
+                            std::string &error) {
+        (void) size;
+        (void) mode;
+        created = false;
+        error = name + ": shared memory needs a POSIX host";
+        return false;
+    }
+
+    void SharedMemory::remove(const std::string &name) {
+        (void) name;
+    }
+
+    std::uint32_t SharedMemory::processId() {
+        return 0;
+    }
+
+    bool SharedMemory::processAlive(std::uint32_t pid) {
+        (void) pid;
+        return true;
+    }
+
+    void SharedMemory::close() {
+    }
+#endif
+}
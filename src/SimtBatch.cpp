@@ -0,0 +1,685 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file SimtBatch.cpp
+ * @brief Many independent RV32IM guests stepped in lockstep by one interpreter
+ */
+
+#include "SimtBatch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace riscv_tlm {
+
+namespace {
+
+/* the addresses BusCtrl.h decodes for the same purposes */
+constexpr std::uint32_t TRACE_ADDRESS = 0x40000000;
+constexpr std::uint32_t UART_THR_ADDRESS = 0x50000000;
+constexpr std::uint32_t TO_HOST_LEGACY = 0x90000000;
+constexpr std::uint32_t TO_HOST = 0x80001000;
+
+/* mcause */
+constexpr std::uint32_t INSN_MISALIGNED = 0;
+constexpr std::uint32_t INSN_ACCESS = 1;
+constexpr std::uint32_t ILLEGAL_INSN = 2;
+constexpr std::uint32_t LOAD_ACCESS = 5;
+constexpr std::uint32_t STORE_ACCESS = 7;
+
+constexpr unsigned int A0 = 10;
+constexpr unsigned int A1 = 11;
+constexpr unsigned int SP = 2;
+
+inline std::uint32_t immI(std::uint32_t insn) {
+    return static_cast<std::uint32_t>(static_cast<std::int32_t>(insn) >> 20);
+}
+
+inline std::uint32_t immS(std::uint32_t insn) {
+    return static_cast<std::uint32_t>((static_cast<std::int32_t>(insn) >> 25) << 5) | ((insn >> 7) & 0x1f);
+}
+
+inline std::uint32_t immB(std::uint32_t insn) {
+    return static_cast<std::uint32_t>((static_cast<std::int32_t>(insn) >> 31) << 12) |
+           ((insn << 4) & 0x800) | ((insn >> 20) & 0x7e0) | ((insn >> 7) & 0x1e);
+}
+
+inline std::uint32_t immJ(std::uint32_t insn) {
+    return static_cast<std::uint32_t>((static_cast<std::int32_t>(insn) >> 31) << 20) |
+           (insn & 0xff000) | ((insn >> 9) & 0x800) | ((insn >> 20) & 0x7fe);
+}
+
+} // namespace
+
+SimtImage::SimtImage(std::uint32_t size)
+        : m_pages((static_cast<std::uint64_t>(size) + PAGE_SIZE - 1) / PAGE_SIZE) {
+    m_size = static_cast<std::uint32_t>(m_pages.size()) * PAGE_SIZE;
+}
+
+void SimtImage::write(std::uint32_t addr, const std::uint8_t *data, std::size_t len) {
+    for (std::size_t i = 0; i < len; i++) {
+        std::uint64_t a = static_cast<std::uint64_t>(addr) + i;
+        if (a >= m_size) {
+            break;
+        }
+        auto &page = m_pages[a / PAGE_SIZE];
+        if (!page) {
+            page.reset(new std::uint8_t[PAGE_SIZE]());
+        }
+        page[a % PAGE_SIZE] = data[i];
+    }
+}
+
+bool SimtImage::loadHex(const std::string &filename, std::string &error) {
+    std::ifstream hexfile(filename);
+    if (!hexfile.is_open()) {
+        error = "cannot open " + filename;
+        return false;
+    }
+
+    std::uint32_t extended_address = 0;
+    std::uint32_t memory_offset = 0;
+    std::string line;
+    unsigned int line_no = 0;
+
+    try {
+        while (std::getline(hexfile, line)) {
+            line_no++;
+            if (line.empty() || line[0] != ':') {
+                continue;
+            }
+            std::string type = line.substr(7, 2);
+            if (type == "00") {
+                /* Data */
+                auto byte_count = static_cast<std::size_t>(std::stoul(line.substr(1, 2), nullptr, 16));
+                std::uint32_t address = std::stoul(line.substr(3, 4), nullptr, 16);
+                address += extended_address + memory_offset;
+                std::vector<std::uint8_t> bytes(byte_count);
+                for (std::size_t i = 0; i < byte_count; i++) {
+                    bytes[i] = static_cast<std::uint8_t>(std::stoul(line.substr(9 + i * 2, 2), nullptr, 16));
+                }
+                write(address, bytes.data(), bytes.size());
+            } else if (type == "02") {
+                /* Extended segment address */
+                extended_address = std::stoul(line.substr(9, 4), nullptr, 16) * 16;
+            } else if (type == "03") {
+                /* Start segment address */
+                std::uint32_t code_segment = std::stoul(line.substr(9, 4), nullptr, 16) * 16;
+                m_entry = code_segment + std::stoul(line.substr(13, 4), nullptr, 16);
+            } else if (type == "04") {
+                /* Extended linear address */
+                memory_offset = std::stoul(line.substr(9, 4), nullptr, 16) << 16;
+                extended_address = 0;
+            } else if (type == "05") {
+                /* Start linear address */
+                m_entry = std::stoul(line.substr(9, 8), nullptr, 16);
+            }
+        }
+    } catch (const std::exception &) {
+        error = filename + ":" + std::to_string(line_no) + ": malformed record";
+        return false;
+    }
+    return true;
+}
+
+SimtBatch::SimtBatch(const SimtImage &image, unsigned int lanes, const VectorKernels &kernels)
+        : m_image(image), m_kernels(kernels),
+          m_lanes(std::clamp(lanes, 1u, MAX_LANES)),
+          m_stride((m_lanes + 7) & ~7u),
+          m_pages(image.pages()),
+          m_x(32 * m_stride, 0),
+          m_pc(m_lanes, image.entry()),
+          m_lane(m_lanes),
+          m_private(static_cast<std::size_t>(m_lanes) * m_pages),
+          m_private_count(m_pages, 0),
+          m_mask((m_stride + 7) / 8, 0),
+          m_tmp(m_stride, 0),
+          m_imm(m_stride, 0),
+          m_cmp((m_stride + 7) / 8, 0) {
+    m_active.reserve(m_lanes);
+    std::fill_n(row(SP), m_lanes, image.size());
+}
+
+bool SimtBatch::setInput(unsigned int lane, std::uint32_t addr, const std::uint8_t *data,
+                         std::size_t len) {
+    if (static_cast<std::uint64_t>(addr) + len > m_image.size()) {
+        return false;
+    }
+    std::size_t done = 0;
+    while (done < len) {
+        std::uint32_t a = addr + static_cast<std::uint32_t>(done);
+        std::size_t chunk = std::min<std::size_t>(len - done, SimtImage::PAGE_SIZE - a % SimtImage::PAGE_SIZE);
+        std::memcpy(writePage(lane, a / SimtImage::PAGE_SIZE) + a % SimtImage::PAGE_SIZE, data + done, chunk);
+        done += chunk;
+    }
+    setReg(lane, A0, addr);
+    setReg(lane, A1, static_cast<std::uint32_t>(len));
+    return true;
+}
+
+const char *SimtBatch::stateName(LaneState state) {
+    switch (state) {
+        case LaneState::Running:
+            return "running";
+        case LaneState::Exited:
+            return "exited";
+        case LaneState::Halted:
+            return "halted";
+        case LaneState::Faulted:
+            return "faulted";
+        default:
+            return "limit";
+    }
+}
+
+void SimtBatch::run(std::uint64_t max_instructions) {
+    while (select(max_instructions)) {
+        execBlock();
+    }
+
+    m_stats.lane_instructions = 0;
+    for (const auto &l : m_lane) {
+        m_stats.lane_instructions += l.instret;
+    }
+}
+
+bool SimtBatch::select(std::uint64_t max_instructions) {
+    std::uint32_t pc_min = std::numeric_limits<std::uint32_t>::max();
+    unsigned int running = 0;
+
+    for (unsigned int l = 0; l < m_lanes; l++) {
+        Lane &lane = m_lane[l];
+        if (lane.state != LaneState::Running) {
+            continue;
+        }
+        if (max_instructions != 0 && lane.instret >= max_instructions) {
+            lane.state = LaneState::Limit;
+            lane.pc = m_pc[l];
+            continue;
+        }
+        running++;
+        pc_min = std::min(pc_min, m_pc[l]);
+    }
+    if (running == 0) {
+        return false;
+    }
+
+    std::fill(m_mask.begin(), m_mask.end(), 0);
+    m_active.clear();
+    m_budget = MAX_BLOCK;
+    for (unsigned int l = 0; l < m_lanes; l++) {
+        if (m_lane[l].state == LaneState::Running && m_pc[l] == pc_min) {
+            m_mask[l >> 3] |= static_cast<std::uint8_t>(1u << (l & 7));
+            m_active.push_back(l);
+            if (max_instructions != 0) {
+                m_budget = static_cast<std::uint32_t>(
+                        std::min<std::uint64_t>(m_budget, max_instructions - m_lane[l].instret));
+            }
+        }
+    }
+    m_block_pc = pc_min;
+    m_full = m_active.size() == m_lanes;
+
+    m_stats.blocks++;
+    if (m_active.size() != running) {
+        m_stats.divergent_blocks++;
+    }
+    return true;
+}
+
+void SimtBatch::leave(unsigned int lane, std::uint32_t executed, std::uint32_t pc) {
+    m_mask[lane >> 3] &= static_cast<std::uint8_t>(~(1u << (lane & 7)));
+    m_lane[lane].instret += executed;
+    m_pc[lane] = pc;
+    m_left = true;
+}
+
+void SimtBatch::stop(unsigned int lane, LaneState state, std::uint32_t executed, std::uint32_t pc) {
+    leave(lane, executed, pc);
+    m_lane[lane].state = state;
+    m_lane[lane].pc = pc;
+}
+
+void SimtBatch::fault(unsigned int lane, std::uint32_t cause, std::uint32_t tval, std::uint32_t executed,
+                      std::uint32_t pc) {
+    stop(lane, LaneState::Faulted, executed, pc);
+    m_lane[lane].cause = cause;
+    m_lane[lane].tval = tval;
+}
+
+void SimtBatch::compact() {
+    if (m_left) {
+        m_active.erase(std::remove_if(m_active.begin(), m_active.end(),
+                                      [this](unsigned int l) { return !maskBit(m_mask, l); }),
+                       m_active.end());
+        m_full = false;
+        m_left = false;
+    }
+}
+
+const std::uint8_t *SimtBatch::readPage(unsigned int lane, std::uint32_t index) const {
+    static const std::uint8_t zero_page[SimtImage::PAGE_SIZE] = {};
+
+    const auto &own = m_private[static_cast<std::size_t>(lane) * m_pages + index];
+    if (own) {
+        return own.get();
+    }
+    const std::uint8_t *shared = m_image.page(index);
+    return shared != nullptr ? shared : zero_page;
+}
+
+std::uint8_t *SimtBatch::writePage(unsigned int lane, std::uint32_t index) {
+    auto &own = m_private[static_cast<std::size_t>(lane) * m_pages + index];
+    if (!own) {
+        own.reset(new std::uint8_t[SimtImage::PAGE_SIZE]);
+        const std::uint8_t *shared = m_image.page(index);
+        if (shared != nullptr) {
+            std::memcpy(own.get(), shared, SimtImage::PAGE_SIZE);
+        } else {
+            std::memset(own.get(), 0, SimtImage::PAGE_SIZE);
+        }
+        m_private_count[index]++;
+        m_lane[lane].private_pages++;
+    }
+    return own.get();
+}
+
+bool SimtBatch::load(unsigned int lane, std::uint32_t addr, unsigned int size, std::uint32_t &value) {
+    if (static_cast<std::uint64_t>(addr) + size > m_image.size()) {
+        return false;
+    }
+    std::uint32_t offset = addr % SimtImage::PAGE_SIZE;
+    if (offset + size <= SimtImage::PAGE_SIZE) {
+        value = 0;
+        std::memcpy(&value, readPage(lane, addr / SimtImage::PAGE_SIZE) + offset, size);
+        return true;
+    }
+    /* misaligned across a page boundary */
+    value = 0;
+    for (unsigned int i = 0; i < size; i++) {
+        std::uint32_t a = addr + i;
+        value |= static_cast<std::uint32_t>(readPage(lane, a / SimtImage::PAGE_SIZE)[a % SimtImage::PAGE_SIZE])
+                << (8 * i);
+    }
+    return true;
+}
+
+bool SimtBatch::store(unsigned int lane, std::uint32_t addr, unsigned int size, std::uint32_t value,
+                      bool &stop) {
+    stop = false;
+    if (static_cast<std::uint64_t>(addr) + size <= m_image.size()) {
+        std::uint32_t offset = addr % SimtImage::PAGE_SIZE;
+        if (offset + size <= SimtImage::PAGE_SIZE) {
+            std::memcpy(writePage(lane, addr / SimtImage::PAGE_SIZE) + offset, &value, size);
+        } else {
+            for (unsigned int i = 0; i < size; i++) {
+                std::uint32_t a = addr + i;
+                writePage(lane, a / SimtImage::PAGE_SIZE)[a % SimtImage::PAGE_SIZE] =
+                        static_cast<std::uint8_t>(value >> (8 * i));
+            }
+        }
+        return true;
+    }
+
+    if (addr == TRACE_ADDRESS || addr == UART_THR_ADDRESS) {
+        m_lane[lane].output.push_back(static_cast<char>(value & 0xff));
+        return true;
+    }
+    if (addr == TO_HOST_LEGACY) {
+        m_lane[lane].exit_code = value;
+        stop = true;
+        return true;
+    }
+    if (addr == TO_HOST) {
+        /* riscv-tests: (code << 1) | 1, and 0 is not a result */
+        if (value != 0) {
+            m_lane[lane].exit_code = value >> 1;
+            stop = true;
+        }
+        return true;
+    }
+    return false;
+}
+
+const std::uint32_t *SimtBatch::immediate(std::uint32_t value) {
+    if (value != m_imm_value) {
+        VectorKernels::splat(32, m_imm.data(), value, m_lanes);
+        m_imm_value = value;
+    }
+    return m_imm.data();
+}
+
+void SimtBatch::commit(unsigned int rd) {
+    if (rd != 0 && !m_full) {
+        VectorKernels::merge(32, row(rd), m_tmp.data(), m_mask.data(), m_lanes);
+    }
+}
+
+void SimtBatch::setFromMask(unsigned int rd) {
+    if (rd == 0) {
+        return;
+    }
+    std::uint32_t *x = row(rd);
+    for (unsigned int l : m_active) {
+        x[l] = maskBit(m_cmp, l) ? 1 : 0;
+    }
+}
+
+bool SimtBatch::fetch(std::uint32_t pc, std::uint32_t executed, std::uint32_t &insn) {
+    if ((pc & 3) != 0 || static_cast<std::uint64_t>(pc) + 4 > m_image.size()) {
+        std::uint32_t cause = (pc & 3) != 0 ? INSN_MISALIGNED : INSN_ACCESS;
+        for (unsigned int l : m_active) {
+            fault(l, cause, pc, executed, pc);
+        }
+        compact();
+        return false;
+    }
+
+    std::uint32_t index = pc / SimtImage::PAGE_SIZE;
+    std::uint32_t offset = pc % SimtImage::PAGE_SIZE;
+    if (m_private_count[index] == 0) {
+        const std::uint8_t *shared = m_image.page(index);
+        insn = 0;
+        if (shared != nullptr) {
+            std::memcpy(&insn, shared + offset, 4);
+        }
+        return true;
+    }
+
+    /* some lane wrote this page: lanes with other code there run it in a later block */
+    std::memcpy(&insn, readPage(m_active.front(), index) + offset, 4);
+    for (unsigned int l : m_active) {
+        std::uint32_t own;
+        std::memcpy(&own, readPage(l, index) + offset, 4);
+        if (own != insn) {
+            leave(l, executed, pc);
+        }
+    }
+    compact();
+    return true;
+}
+
+void SimtBatch::execBlock() {
+    const VectorKernels &k = m_kernels;
+    std::uint32_t pc = m_block_pc;
+    std::uint32_t n = 0;            // retired so far by the lanes still active
+    bool end = false;
+    bool per_lane_pc = false;       // m_pc already holds each lane's next PC
+
+    while (!end && n < m_budget) {
+        std::uint32_t insn;
+        if (m_active.empty() || !fetch(pc, n, insn)) {
+            break;
+        }
+
+        unsigned int rd = (insn >> 7) & 0x1f;
+        unsigned int rs1 = (insn >> 15) & 0x1f;
+        unsigned int rs2 = (insn >> 20) & 0x1f;
+        unsigned int funct3 = (insn >> 12) & 7;
+        unsigned int funct7 = insn >> 25;
+        std::uint32_t next = pc + 4;
+        bool illegal = false;
+
+        switch (insn & 0x7f) {
+            case 0x37:      /* LUI */
+                VectorKernels::splat(32, dest(rd), insn & 0xfffff000, m_lanes);
+                commit(rd);
+                break;
+            case 0x17:      /* AUIPC */
+                VectorKernels::splat(32, dest(rd), pc + (insn & 0xfffff000), m_lanes);
+                commit(rd);
+                break;
+            case 0x6f:      /* JAL */
+                VectorKernels::splat(32, dest(rd), pc + 4, m_lanes);
+                commit(rd);
+                next = pc + immJ(insn);
+                end = true;
+                break;
+            case 0x67: {    /* JALR */
+                if (funct3 != 0) {
+                    illegal = true;
+                    break;
+                }
+                const std::uint32_t *base = row(rs1);
+                std::uint32_t imm = immI(insn);
+                for (unsigned int l : m_active) {
+                    m_pc[l] = (base[l] + imm) & ~1u;
+                }
+                VectorKernels::splat(32, dest(rd), pc + 4, m_lanes);
+                commit(rd);
+                per_lane_pc = true;
+                end = true;
+                break;
+            }
+            case 0x63: {    /* BRANCH */
+                const std::uint32_t *a = row(rs1);
+                const std::uint32_t *b = row(rs2);
+                switch (funct3) {
+                    case 0:
+                        k.compare(VecCmpOp::Eq, 32, m_cmp.data(), a, b, m_lanes);
+                        break;
+                    case 1:
+                        k.compare(VecCmpOp::Ne, 32, m_cmp.data(), a, b, m_lanes);
+                        break;
+                    case 4:
+                        k.compare(VecCmpOp::Lt, 32, m_cmp.data(), a, b, m_lanes);
+                        break;
+                    case 5:         /* a >= b is b <= a */
+                        k.compare(VecCmpOp::Le, 32, m_cmp.data(), b, a, m_lanes);
+                        break;
+                    case 6:
+                        k.compare(VecCmpOp::LtU, 32, m_cmp.data(), a, b, m_lanes);
+                        break;
+                    case 7:
+                        k.compare(VecCmpOp::LeU, 32, m_cmp.data(), b, a, m_lanes);
+                        break;
+                    default:
+                        illegal = true;
+                        break;
+                }
+                if (illegal) {
+                    break;
+                }
+                std::uint32_t target = pc + immB(insn);
+                for (unsigned int l : m_active) {
+                    m_pc[l] = maskBit(m_cmp, l) ? target : pc + 4;
+                }
+                per_lane_pc = true;
+                end = true;
+                break;
+            }
+            case 0x03: {    /* LOAD */
+                static constexpr unsigned int sizes[8] = {1, 2, 4, 0, 1, 2, 0, 0};
+                unsigned int size = sizes[funct3];
+                if (size == 0) {
+                    illegal = true;
+                    break;
+                }
+                const std::uint32_t *base = row(rs1);
+                std::uint32_t imm = immI(insn);
+                std::uint32_t *x = rd != 0 ? row(rd) : m_tmp.data();
+                for (unsigned int l : m_active) {
+                    std::uint32_t addr = base[l] + imm;
+                    std::uint32_t value;
+                    if (!load(l, addr, size, value)) {
+                        fault(l, LOAD_ACCESS, addr, n, pc);
+                        continue;
+                    }
+                    if (funct3 == 0) {
+                        value = static_cast<std::uint32_t>(static_cast<std::int8_t>(value));
+                    } else if (funct3 == 1) {
+                        value = static_cast<std::uint32_t>(static_cast<std::int16_t>(value));
+                    }
+                    x[l] = value;
+                }
+                break;
+            }
+            case 0x23: {    /* STORE */
+                if (funct3 > 2) {
+                    illegal = true;
+                    break;
+                }
+                unsigned int size = 1u << funct3;
+                const std::uint32_t *base = row(rs1);
+                const std::uint32_t *data = row(rs2);
+                std::uint32_t imm = immS(insn);
+                for (unsigned int l : m_active) {
+                    std::uint32_t addr = base[l] + imm;
+                    bool done;
+                    if (!store(l, addr, size, data[l], done)) {
+                        fault(l, STORE_ACCESS, addr, n, pc);
+                    } else if (done) {
+                        stop(l, LaneState::Exited, n + 1, pc);
+                    }
+                }
+                break;
+            }
+            case 0x13: {    /* OP-IMM */
+                const std::uint32_t *a = row(rs1);
+                std::uint32_t imm = immI(insn);
+                switch (funct3) {
+                    case 0:
+                        k.binary(VecBinOp::Add, 32, dest(rd), a, immediate(imm), m_lanes);
+                        commit(rd);
+                        break;
+                    case 2:
+                        k.compare(VecCmpOp::Lt, 32, m_cmp.data(), a, immediate(imm), m_lanes);
+                        setFromMask(rd);
+                        break;
+                    case 3:
+                        k.compare(VecCmpOp::LtU, 32, m_cmp.data(), a, immediate(imm), m_lanes);
+                        setFromMask(rd);
+                        break;
+                    case 4:
+                        k.binary(VecBinOp::Xor, 32, dest(rd), a, immediate(imm), m_lanes);
+                        commit(rd);
+                        break;
+                    case 6:
+                        k.binary(VecBinOp::Or, 32, dest(rd), a, immediate(imm), m_lanes);
+                        commit(rd);
+                        break;
+                    case 7:
+                        k.binary(VecBinOp::And, 32, dest(rd), a, immediate(imm), m_lanes);
+                        commit(rd);
+                        break;
+                    case 1:
+                        if (funct7 != 0) {
+                            illegal = true;
+                            break;
+                        }
+                        k.binary(VecBinOp::Sll, 32, dest(rd), a, immediate(rs2), m_lanes);
+                        commit(rd);
+                        break;
+                    default:        /* 5 */
+                        if (funct7 != 0 && funct7 != 0x20) {
+                            illegal = true;
+                            break;
+                        }
+                        k.binary(funct7 != 0 ? VecBinOp::Sra : VecBinOp::Srl, 32, dest(rd), a,
+                                 immediate(rs2), m_lanes);
+                        commit(rd);
+                        break;
+                }
+                break;
+            }
+            case 0x33: {    /* OP */
+                static constexpr VecBinOp base_ops[8] = {
+                        VecBinOp::Add, VecBinOp::Sll, VecBinOp::Count, VecBinOp::Count,
+                        VecBinOp::Xor, VecBinOp::Srl, VecBinOp::Or, VecBinOp::And};
+                static constexpr VecBinOp mul_ops[8] = {
+                        VecBinOp::Mul, VecBinOp::MulH, VecBinOp::MulHSU, VecBinOp::MulHU,
+                        VecBinOp::Div, VecBinOp::DivU, VecBinOp::Rem, VecBinOp::RemU};
+                const std::uint32_t *a = row(rs1);
+                const std::uint32_t *b = row(rs2);
+                VecBinOp op;
+                if (funct7 == 0x01) {
+                    op = mul_ops[funct3];
+                } else if (funct7 == 0x20 && (funct3 == 0 || funct3 == 5)) {
+                    op = funct3 == 0 ? VecBinOp::Sub : VecBinOp::Sra;
+                } else if (funct7 == 0 && (funct3 == 2 || funct3 == 3)) {
+                    k.compare(funct3 == 2 ? VecCmpOp::Lt : VecCmpOp::LtU, 32, m_cmp.data(), a, b, m_lanes);
+                    setFromMask(rd);
+                    break;
+                } else if (funct7 == 0) {
+                    op = base_ops[funct3];
+                } else {
+                    illegal = true;
+                    break;
+                }
+                k.binary(op, 32, dest(rd), a, b, m_lanes);
+                commit(rd);
+                break;
+            }
+            case 0x0f:      /* FENCE, FENCE.I: nothing to order */
+                break;
+            case 0x73: {    /* SYSTEM */
+                if (insn == 0x00000073) {           /* ECALL */
+                    const std::uint32_t *a0 = row(A0);
+                    for (unsigned int l : m_active) {
+                        m_lane[l].exit_code = a0[l];
+                        stop(l, LaneState::Exited, n + 1, pc);
+                    }
+                    break;
+                }
+                if (insn == 0x00100073) {           /* EBREAK */
+                    for (unsigned int l : m_active) {
+                        stop(l, LaneState::Halted, n + 1, pc);
+                    }
+                    break;
+                }
+                /* counters can be read (CSRRS/CSRRSI with nothing to set), nothing written */
+                std::uint32_t csr = insn >> 20;
+                if ((funct3 != 2 && funct3 != 6) || rs1 != 0) {
+                    illegal = true;
+                    break;
+                }
+                bool high;
+                if (csr == 0xc00 || csr == 0xc01 || csr == 0xc02 || csr == 0xb00 || csr == 0xb02) {
+                    high = false;
+                } else if (csr == 0xc80 || csr == 0xc81 || csr == 0xc82 || csr == 0xb80 || csr == 0xb82) {
+                    high = true;
+                } else if (csr == 0xf14) {          /* mhartid: every lane is hart 0 of its own machine */
+                    VectorKernels::splat(32, dest(rd), 0, m_lanes);
+                    commit(rd);
+                    break;
+                } else {
+                    illegal = true;
+                    break;
+                }
+                if (rd != 0) {
+                    std::uint32_t *x = row(rd);
+                    for (unsigned int l : m_active) {
+                        std::uint64_t count = m_lane[l].instret + n;
+                        x[l] = static_cast<std::uint32_t>(high ? count >> 32 : count);
+                    }
+                }
+                break;
+            }
+            default:
+                illegal = true;
+                break;
+        }
+
+        if (illegal) {
+            for (unsigned int l : m_active) {
+                fault(l, ILLEGAL_INSN, insn, n, pc);
+            }
+        }
+        compact();
+        n++;
+        pc = next;
+    }
+
+    if (!per_lane_pc) {
+        for (unsigned int l : m_active) {
+            m_pc[l] = pc;
+        }
+    }
+    for (unsigned int l : m_active) {
+        m_lane[l].instret += n;
+    }
+    m_stats.issued += n;
+}
+
+} // namespace riscv_tlm
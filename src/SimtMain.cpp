@@ -0,0 +1,192 @@
+/*!
+ \file SimtMain.cpp
+ \brief Batch entry point: one RV32IM program over many inputs, in lockstep
+ \note Functional only; see SimtBatch.h for what a lane can and cannot do
+ */
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SimtBatch.h"
+
+struct Options {
+    std::string hex_file;
+    unsigned int lanes{0};
+    std::uint32_t memory{0x04000000};
+    std::uint32_t input_addr{0x01000000};
+    std::uint64_t max_instructions{0};
+    bool quiet{false};
+    std::vector<std::string> inputs;
+};
+
+static void usage(const char* exe) {
+    std::cout << "Usage: " << exe << " -f <file.hex> [options] [input files...]\n";
+    std::cout << "\nRuns one RV32IM program as many independent instances in lockstep\n";
+    std::cout << "\nOptions:\n";
+    std::cout << "  -f, --file <file.hex>   Program (required)\n";
+    std::cout << "  -n, --lanes <N>         Instances (default: one per input file, or 8)\n";
+    std::cout << "  --memory <bytes>        Guest memory of each instance (default: 0x4000000)\n";
+    std::cout << "  --input-addr <addr>     Where each instance finds its input file (default: 0x1000000);\n";
+    std::cout << "                          a0 holds the address and a1 the length\n";
+    std::cout << "  --max-instr <N>         Maximum instructions per instance\n";
+    std::cout << "  -q, --quiet             Do not print the instances' output\n";
+    std::cout << "\nInput files are dealt to the instances in turn.\n";
+}
+
+static bool number(const char* text, std::uint64_t &value) {
+    char* endp = nullptr;
+    value = std::strtoull(text, &endp, 0);
+    return endp != text && *endp == '\0';
+}
+
+static Options parse(int argc, char* argv[]) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        std::uint64_t value = 0;
+        if ((std::strcmp(argv[i], "-f") == 0 || std::strcmp(argv[i], "--file") == 0) && i+1 < argc) {
+            o.hex_file = argv[++i];
+        } else if ((std::strcmp(argv[i], "-n") == 0 || std::strcmp(argv[i], "--lanes") == 0) && i+1 < argc) {
+            if (!number(argv[++i], value) || value == 0 || value > riscv_tlm::SimtBatch::MAX_LANES) {
+                std::cerr << "Invalid --lanes (1 to " << riscv_tlm::SimtBatch::MAX_LANES << ")\n";
+                std::exit(1);
+            }
+            o.lanes = static_cast<unsigned int>(value);
+        } else if ((std::strcmp(argv[i], "--memory") == 0) && i+1 < argc) {
+            if (!number(argv[++i], value) || value < riscv_tlm::SimtImage::PAGE_SIZE || value > 0xFFFFF000ULL) {
+                std::cerr << "Invalid --memory\n";
+                std::exit(1);
+            }
+            o.memory = static_cast<std::uint32_t>(value);
+        } else if ((std::strcmp(argv[i], "--input-addr") == 0) && i+1 < argc) {
+            if (!number(argv[++i], value) || value > 0xFFFFFFFFULL) {
+                std::cerr << "Invalid --input-addr\n";
+                std::exit(1);
+            }
+            o.input_addr = static_cast<std::uint32_t>(value);
+        } else if ((std::strcmp(argv[i], "--max-instr") == 0) && i+1 < argc) {
+            if (!number(argv[++i], value)) {
+                std::cerr << "Invalid --max-instr\n";
+                std::exit(1);
+            }
+            o.max_instructions = value;
+        } else if (std::strcmp(argv[i], "-q") == 0 || std::strcmp(argv[i], "--quiet") == 0) {
+            o.quiet = true;
+        } else if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
+            usage(argv[0]);
+            std::exit(0);
+        } else if (argv[i][0] != '-') {
+            o.inputs.emplace_back(argv[i]);
+        } else {
+            usage(argv[0]);
+            std::exit(1);
+        }
+    }
+    if (o.hex_file.empty()) {
+        usage(argv[0]);
+        std::exit(1);
+    }
+    if (o.lanes == 0) {
+        o.lanes = o.inputs.empty() ? 8 : static_cast<unsigned int>(o.inputs.size());
+    }
+    return o;
+}
+
+static bool readFile(const std::string &name, std::vector<std::uint8_t> &data) {
+    std::ifstream file(name, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    using riscv_tlm::SimtBatch;
+
+    Options opts = parse(argc, argv);
+
+    riscv_tlm::SimtImage image(opts.memory);
+    std::string error;
+    if (!image.loadHex(opts.hex_file, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    SimtBatch batch(image, opts.lanes);
+    for (unsigned int l = 0; l < opts.lanes && !opts.inputs.empty(); l++) {
+        const std::string &name = opts.inputs[l % opts.inputs.size()];
+        std::vector<std::uint8_t> data;
+        if (!readFile(name, data)) {
+            std::cerr << "Cannot read " << name << "\n";
+            return 1;
+        }
+        if (!batch.setInput(l, opts.input_addr, data.data(), data.size())) {
+            std::cerr << name << " does not fit in memory at 0x" << std::hex << opts.input_addr << std::dec
+                      << "\n";
+            return 1;
+        }
+    }
+
+    std::cout << "Config:\n";
+    std::cout << "  file: " << opts.hex_file << "\n";
+    std::cout << "  lanes: " << opts.lanes << " (" << riscv_tlm::VectorKernels::isaName(batch.kernels().isa())
+              << ")\n";
+    std::cout << "  mem : 0x" << std::hex << image.size() << std::dec << " bytes per lane, copy-on-write\n";
+    if (opts.max_instructions != 0) {
+        std::cout << "  max : " << opts.max_instructions << " instr per lane\n";
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    batch.run(opts.max_instructions);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    int status = 0;
+    std::cout << "\n=== Lanes ===\n";
+    for (unsigned int l = 0; l < batch.lanes(); l++) {
+        const SimtBatch::Lane &lane = batch.lane(l);
+        std::cout << "lane " << std::setw(4) << l << ": " << SimtBatch::stateName(lane.state);
+        if (lane.state == SimtBatch::LaneState::Exited) {
+            std::cout << " " << static_cast<std::int32_t>(lane.exit_code);
+        } else if (lane.state == SimtBatch::LaneState::Faulted) {
+            std::cout << " (cause " << lane.cause << ", tval 0x" << std::hex << lane.tval << ")" << std::dec;
+        }
+        std::cout << " at 0x" << std::hex << lane.pc << std::dec << ", " << lane.instret << " instr, "
+                  << lane.private_pages << " pages copied\n";
+        if (!opts.quiet && !lane.output.empty()) {
+            std::istringstream lines(lane.output);
+            std::string line;
+            while (std::getline(lines, line)) {
+                std::cout << "  [" << l << "] " << line << "\n";
+            }
+        }
+        if (lane.state != SimtBatch::LaneState::Exited || lane.exit_code != 0) {
+            status = 1;
+        }
+    }
+
+    const SimtBatch::Stats &stats = batch.stats();
+    double issued = static_cast<double>(stats.issued);
+    std::cout << "\n=== Batch Results ===\n";
+    std::cout << "Wall time:    " << std::fixed << std::setprecision(3) << elapsed.count() << " s\n";
+    std::cout << "Instructions: " << stats.lane_instructions << " over all lanes, " << stats.issued << " issued\n";
+    std::cout << "Blocks:       " << stats.blocks << " (" << stats.divergent_blocks << " divergent)\n";
+    if (issued > 0) {
+        std::cout << "Lane usage:   " << std::setprecision(1)
+                  << 100.0 * static_cast<double>(stats.lane_instructions) / (issued * batch.lanes()) << " %\n";
+    }
+    if (elapsed.count() > 0) {
+        std::cout << "Speed:        " << std::setprecision(2)
+                  << static_cast<double>(stats.lane_instructions) / elapsed.count() / 1e6 << " MIPS\n";
+    }
+    return status;
+}
@@ -13,11 +13,13 @@
 #include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <fstream>
 #include <string>
 #include <cstring>
 #include <iomanip>
 #include <cmath>
+#include <vector>
 #ifndef _WIN32
 #include <unistd.h>
 #include <getopt.h>
@@ -27,6 +29,7 @@
 
 // Minimal getopt_long replacement for Windows build
 static int optind_win = 1; char* optarg = nullptr; int opterr = 0; struct option { const char* name; int has_arg; int* flag; int val; };
+#define no_argument 0
 #define required_argument 1
 int getopt_long(int argc, char* const argv[], const char* optstring, const option* longopts, int* longindex) {
     (void)longopts; (void)longindex; if (optind_win >= argc) return -1; char* arg = argv[optind_win]; if(arg[0] != '-') return -1; char opt = arg[1]; if(opt == '\0') return -1; optarg = nullptr; if(strchr(optstring,opt)) { if((opt=='f'||opt=='R'||opt=='M'||opt=='B'||opt=='E'||opt=='L') && optind_win+1 < argc) { optarg = argv[++optind_win]; } optind_win++; return opt; } optind_win++; return '?'; }
@@ -41,13 +44,19 @@ int getopt_long(int argc, char* const argv[], const char* optstring, const optio
 #include "Timer.h"
 #include "Debug.h"
 #include "Performance.h"
+#include "PluginManager.h"
+#include "RunControl.h"
+#include "AotModule.h"
 
 // Peripherals
 #include "UART.h"
 #include "CLINT.h"
 #include "PLIC.h"
+#include "CLIC.h"
 #include "DMA.h"
+#include "DVFS.h"
 #include "SyscallIf.h"
+#include "VirtioNet.h"
 
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/basic_file_sink.h"
@@ -56,7 +65,11 @@ int getopt_long(int argc, char* const argv[], const char* optstring, const optio
 
 std::string filename;
 bool debug_session = false;
+unsigned short gdb_port = riscv_tlm::Debug::DEFAULT_PORT;
+std::uint64_t reverse_interval = 1000000;
+std::size_t reverse_budget_mb = 256;
 bool mem_dump = false;
+std::string aot_dir;
 uint32_t dump_addr_st = 0;
 uint32_t dump_addr_end = 0;
 
@@ -79,8 +92,13 @@ public:
     riscv_tlm::peripherals::UART *uart;
     riscv_tlm::peripherals::CLINT *clint;
     riscv_tlm::peripherals::PLIC *plic;
+    riscv_tlm::CLIC *clic;
     riscv_tlm::peripherals::DMA *dma;
     riscv_tlm::peripherals::SyscallIf *sysif;
+    riscv_tlm::peripherals::DVFS *dvfs;
+    riscv_tlm::peripherals::VirtioNet *net;     // empty slot: --net is RISCV_VP only
+    riscv_tlm::Debug *debugger;
+    std::unique_ptr<riscv_tlm::AotModule> aot;
 
     explicit Simulator(sc_core::sc_module_name const &name, riscv_tlm::cpu_types_t cpu_type_m)
     : sc_module(name)
@@ -89,7 +107,7 @@ public:
     , Bus(nullptr)
     , trace(nullptr)
     , timer(nullptr)
-    , clk("clk", sc_core::sc_time(10, sc_core::SC_NS))
+    , debugger(nullptr)
     {
         std::uint32_t start_PC;
 
@@ -104,7 +122,8 @@ public:
         } else {
             cpu = new riscv_tlm::CPURV64Simple("cpu", start_PC, debug_session);
         }
-        cpu->set_clock(&clk);
+        riscv_tlm::ClockDomains::getInstance()->create();
+        cpu->set_clock(&riscv_tlm::ClockDomains::getInstance()->core());
 
         Bus = new riscv_tlm::BusCtrl("BusCtrl");
         trace = new riscv_tlm::peripherals::Trace("Trace");
@@ -112,8 +131,11 @@ public:
         uart  = new riscv_tlm::peripherals::UART("UART0");
         clint = new riscv_tlm::peripherals::CLINT("CLINT");
         plic  = new riscv_tlm::peripherals::PLIC("PLIC");
+        clic  = new riscv_tlm::CLIC("CLIC");
         dma   = new riscv_tlm::peripherals::DMA("DMA");
         sysif = new riscv_tlm::peripherals::SyscallIf("SysIf");
+        dvfs  = new riscv_tlm::peripherals::DVFS("DVFS");
+        net   = new riscv_tlm::peripherals::VirtioNet("VirtioNet");
 
         cpu->instr_bus.bind(Bus->cpu_instr_socket);
         cpu->mem_intf->data_bus.bind(Bus->cpu_data_socket);
@@ -124,14 +146,26 @@ public:
         Bus->uart_socket.bind(uart->socket);
         Bus->clint_socket.bind(clint->socket);
         Bus->plic_socket.bind(plic->socket);
+        Bus->clic_socket.bind(clic->socket);
         Bus->dma_socket.bind(dma->socket);
         Bus->syscall_socket.bind(sysif->socket);
+        Bus->dvfs_socket.bind(dvfs->socket);
+        Bus->net_socket.bind(net->socket);
 
         dma->mem_master.bind(Bus->dma_master_socket);
+        net->mem_master.bind(Bus->net_master_socket);
         timer->irq_line.bind(cpu->irq_line_socket);
+        plic->irq_lines[0]->bind(cpu->ext_irq_socket);
+        cpu->attachCLIC(clic);
+
+        if (!aot_dir.empty()) {
+            attachTranslation();
+        }
 
         if (debug_session) {
             std::cout << "[Debug] GDB debugging enabled." << std::endl;
+            debugger = new riscv_tlm::Debug(cpu, MainMemory, cpu_type, gdb_port);
+            debugger->enableReverse(reverse_interval, reverse_budget_mb << 20);
         }
     }
 
@@ -139,8 +173,12 @@ public:
         if (mem_dump) {
             MemoryDump();
         }
+        delete debugger;
+        delete net;
+        delete dvfs;
         delete sysif;
         delete dma;
+        delete clic;
         delete plic;
         delete clint;
         delete uart;
@@ -152,6 +190,29 @@ public:
     }
 
 private:
+    /**
+     * @brief Run the translation of the loaded image from aot_dir, if rv_aot made one
+     */
+    void attachTranslation() {
+        std::uint64_t hash = MainMemory->imageHash();
+        if (debug_session) {
+            std::cout << "  aot : off, the debugger steps single instructions" << std::endl;
+            return;
+        }
+        std::string error;
+        aot = riscv_tlm::AotModule::load(aot_dir, hash, error);
+        if (!aot) {
+            std::cout << "  aot : " << error << ", interpreting" << std::endl;
+            return;
+        }
+        if (!cpu->attachAot(aot.get())) {
+            std::cout << "  aot : not used, translated code is RV32 only" << std::endl;
+            aot.reset();
+            return;
+        }
+        std::cout << "  aot : " << aot->path() << " (" << aot->blocks() << " blocks)" << std::endl;
+    }
+
     void MemoryDump() const {
         std::cout << "********** MEMORY DUMP ***********\n";
 
@@ -198,7 +259,6 @@ private:
 
 private:
     riscv_tlm::cpu_types_t cpu_type;
-    sc_core::sc_clock clk;
 };
 
 Simulator *top;
@@ -211,6 +271,7 @@ static void intHandler(int dummy) {
 }
 
 std::uint64_t max_instructions_limit = 0;
+std::vector<std::string> plugin_specs;
 
 static void process_arguments(int argc, char *argv[]) {
     opterr = 0;
@@ -222,6 +283,12 @@ static void process_arguments(int argc, char *argv[]) {
 
     static struct option long_options[] = {
         {"max-instr", required_argument, nullptr, 'M'},
+        {"plugin", required_argument, nullptr, 'P'},
+        {"zcmp", no_argument, nullptr, 'Z'},
+        {"gdb-port", required_argument, nullptr, 'g'},
+        {"reverse-interval", required_argument, nullptr, 'i'},
+        {"reverse-budget", required_argument, nullptr, 'b'},
+        {"aot", required_argument, nullptr, 'A'},
         {0, 0, 0, 0}
     };
 
@@ -284,6 +351,24 @@ static void process_arguments(int argc, char *argv[]) {
                 max_instructions_limit = std::strtoull(optarg, nullptr, 10);
             }
             break;
+        case 'P':
+            plugin_specs.emplace_back(optarg);
+            break;
+        case 'Z':
+            riscv_tlm::CodeSizeExtensions::enable(true);
+            break;
+        case 'g':
+            gdb_port = static_cast<unsigned short>(std::strtoul(optarg, nullptr, 10));
+            break;
+        case 'i':
+            reverse_interval = std::strtoull(optarg, nullptr, 10);
+            break;
+        case 'b':
+            reverse_budget_mb = std::strtoull(optarg, nullptr, 10);
+            break;
+        case 'A':
+            aot_dir = optarg;
+            break;
         case '?':
             break;
         default:
@@ -292,7 +377,7 @@ static void process_arguments(int argc, char *argv[]) {
     }
 
     if (filename.empty()) {
-        std::cout << "Usage: ./RISCV_TLM -f <file.hex> [-R 32|64] [-L <0..3>] [-M <max_instr>] [-D]" << std::endl;
+        std::cout << "Usage: ./RISCV_TLM -f <file.hex> [-R 32|64] [-L <0..3>] [-M <max_instr>] [--plugin <lib[,args]>] [--zcmp] [--aot <dir>] [-D [--gdb-port <n>] [--reverse-interval <instr>] [--reverse-budget <MB>]]" << std::endl;
         std::exit(EXIT_FAILURE);
     }
 }
@@ -301,7 +386,7 @@ int sc_main(int argc, char *argv[]) {
     Performance *perf = Performance::getInstance();
 
     signal(SIGINT, intHandler);
-    sc_core::sc_set_time_resolution(1, sc_core::SC_NS);
+    sc_core::sc_set_time_resolution(1, sc_core::SC_PS);
 
     process_arguments(argc, argv);
 
@@ -320,18 +405,22 @@ int sc_main(int argc, char *argv[]) {
 
     top = new Simulator("top", cpu_type_opt);
 
+    // Plugins are installed once the CPU has registered its hart, so they see the hart count
+    for (auto const &spec : plugin_specs) {
+        if (!riscv_tlm::PluginManager::getInstance()->load(spec, cpu_type_opt == riscv_tlm::RV32 ? 32 : 64)) {
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
     auto start = std::chrono::steady_clock::now();
 
     if (max_instructions_limit > 0) {
-        const sc_core::sc_time quantum(1, sc_core::SC_MS);
-        while (true) {
-            sc_core::sc_start(quantum);
-            if (perf->getInstructions() >= max_instructions_limit || sc_core::sc_get_status() == sc_core::SC_STOPPED)
-                break;
-        }
-    } else {
-        sc_core::sc_start();
+        // Stops exactly at the limit as the instruction retires
+        std::string error;
+        riscv_tlm::RunControl::getInstance()->add("instr=" + std::to_string(max_instructions_limit),
+                                                  riscv_tlm::RunControl::Action::Stop, error);
     }
+    sc_core::sc_start();
 
     auto end = std::chrono::steady_clock::now();
 
@@ -341,6 +430,8 @@ int sc_main(int argc, char *argv[]) {
     std::cout << "Wall time:    " << std::fixed << std::setprecision(3) << elapsed_seconds.count() << " s" << std::endl;
     std::cout << "Instructions: " << perf->getInstructions() << std::endl;
 
+    riscv_tlm::PluginManager::getInstance()->shutdown();
+
     if (!mem_dump && max_instructions_limit == 0) {
         std::cout << "Press Enter to finish" << std::endl;
         std::cin.ignore();
@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file Telemetry.cpp
+ * @brief Shared-memory telemetry page of RISCV_VP
+ */
+
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "systemc"
+
+#include "CPU.h"
+#include "ClockDomains.h"
+#include "Performance.h"
+
+namespace riscv_tlm {
+
+    namespace {
+        template<std::size_t N>
+        void copyName(char (&dst)[N], const std::string &src) {
+            std::memset(dst, 0, N);
+            std::memcpy(dst, src.data(), std::min(src.size(), N - 1));
+        }
+    }
+
+    Telemetry *Telemetry::getInstance() {
+        static Telemetry instance;
+        return &instance;
+    }
+
+    Telemetry::~Telemetry() {
+        close();
+    }
+
+    bool Telemetry::open(bool share_ram, std::string &error) {
+#ifndef _WIN32
+        /* read-write for the simulator, read-only for everybody else */
+        const std::string name = TELEMETRY_PREFIX + std::to_string(getpid());
+        if (!m_page_shm.create(name, sizeof(TelemetryPage), 0644, error)) {
+            return false;
+        }
+        m_page = new(m_page_shm.data()) TelemetryPage{};
+        m_page->version = TELEMETRY_VERSION;
+        m_page->size = sizeof(TelemetryPage);
+        m_page->pid = static_cast<std::uint32_t>(getpid());
+        m_page->state = TelemetryState::Running;
+        m_share_ram = share_ram;
+        m_start = m_last = std::chrono::steady_clock::now();
+        m_last_instructions = 0;
+        std::atomic_thread_fence(std::memory_order_release);
+        m_page->magic = TELEMETRY_MAGIC;
+        return true;
+#else
+        (void) share_ram;
+        error = "shared-memory telemetry needs a POSIX host";
+        return false;
+#endif
+    }
+
+    unsigned char *Telemetry::sharedRam(std::size_t size) {
+        if (!isOpen() || !m_share_ram || m_ram_shm.data() != nullptr) {
+            return nullptr;
+        }
+        std::string error;
+        if (!m_ram_shm.create(name() + ".ram", size, 0644, error)) {
+            std::cerr << "[telemetry] guest RAM not shared: " << error << "\n";
+            return nullptr;
+        }
+        telemetryWrite(*m_page, [this](TelemetryPage &page) {
+            page.ram_size = m_ram_shm.size();
+            copyName(page.ram_name, m_ram_shm.name());
+        });
+        return static_cast<unsigned char *>(m_ram_shm.data());
+    }
+
+    void Telemetry::describe(const std::string &model, const std::string &image) {
+        if (!isOpen()) {
+            return;
+        }
+        telemetryWrite(*m_page, [&](TelemetryPage &page) {
+            copyName(page.model, model);
+            copyName(page.image, image);
+        });
+    }
+
+    void Telemetry::publish(CPU *cpu, TelemetryState state) {
+        if (!isOpen()) {
+            return;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        const std::uint64_t instructions = Performance::getInstance()->getInstructions();
+        const std::chrono::duration<double> interval = now - m_last;
+        const double mips = interval.count() > 0
+                            ? static_cast<double>(instructions - m_last_instructions) / interval.count() / 1e6
+                            : 0.0;
+        m_last = now;
+        m_last_instructions = instructions;
+
+        ClockDomain &core = ClockDomains::getInstance()->core();
+        std::uint64_t pc = 0;
+        if (cpu != nullptr) {
+            cpu->readDebugRegister(32, pc);
+        }
+
+        telemetryWrite(*m_page, [&](TelemetryPage &page) {
+            page.state = state;
+            page.instructions = instructions;
+            page.cycles = core.cycles();
+            page.pc = pc;
+            page.sim_time_ps = static_cast<std::uint64_t>(sc_core::sc_time_stamp() / sc_core::sc_time(1, sc_core::SC_PS));
+            page.wall_ns = static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_start).count());
+            page.core_hz = static_cast<std::uint64_t>(core.frequency());
+            page.mips = mips;
+            page.counter_count = 0;
+            if (cpu != nullptr) {
+                cpu->visitCounters([&page](const char *name, std::uint64_t value) {
+                    if (page.counter_count < TELEMETRY_COUNTERS) {
+                        TelemetryCounter &counter = page.counters[page.counter_count++];
+                        copyName(counter.name, name);
+                        counter.value = value;
+                    }
+                });
+            }
+        });
+    }
+
+    void Telemetry::close() {
+        m_ram_shm.close();
+        m_page_shm.close();
+        m_page = nullptr;
+    }
+}
@@ -8,16 +8,33 @@
 
 #include "Timer.h"
 #include <cstdint>
-#include <cstring> // Added for memcpy
 
 namespace riscv_tlm::peripherals {
 
     SC_HAS_PROCESS(Timer);
 
     Timer::Timer(sc_core::sc_module_name const &name) :
-            sc_module(name), socket("timer_socket"), m_mtime(0), m_mtimecmp(0) {
+            sc_module(name), socket("timer_socket"),
+            regs(0x10, RegisterBank::BYTE | RegisterBank::HALF | RegisterBank::WORD, true) {
+
+        // Reading the low half of mtime samples the simulated time; the high half keeps that sample
+        regs.add("mtime_lo", MTIME_LO).onRead([this](unsigned int) {
+            auto now = static_cast<std::uint64_t>(sc_core::sc_time_stamp() / sc_core::sc_time(1, sc_core::SC_NS));
+            regs.set(MTIME_LO, now & 0xFFFFFFFF);
+            regs.set(MTIME_HI, now >> 32);
+            return now & 0xFFFFFFFF;
+        });
+        regs.add("mtime_hi", MTIME_HI);
+        regs.add("mtimecmp_lo", MTIMECMP_LO);
+        regs.add("mtimecmp_hi", MTIMECMP_HI).onWrite([this](unsigned int, std::uint64_t) {
+            // notify needs relative time, mtimecmp works in absolute time
+            std::uint64_t mtime = regs.get(MTIME_HI) << 32 | regs.get(MTIME_LO);
+            std::uint64_t mtimecmp = regs.get(MTIMECMP_HI) << 32 | regs.get(MTIMECMP_LO);
+            timer_event.notify(sc_core::sc_time(static_cast<double>(mtimecmp - mtime), sc_core::SC_NS));
+        });
 
         socket.register_b_transport(this, &Timer::b_transport);
+        socket.register_get_direct_mem_ptr(this, &Timer::get_direct_mem_ptr);
 
         SC_THREAD(run);
     }
@@ -44,64 +61,11 @@ namespace riscv_tlm::peripherals {
 
     void Timer::b_transport(tlm::tlm_generic_payload &trans,
                             sc_core::sc_time &delay) {
-
-        tlm::tlm_command cmd = trans.get_command();
-        sc_dt::uint64 addr = trans.get_address();
-        unsigned char *ptr = trans.get_data_ptr();
-        unsigned int len = trans.get_data_length();
         delay = sc_core::SC_ZERO_TIME;
+        regs.access(trans);
+    }
 
-        std::uint32_t aux_value = 0;
-
-
-        if (cmd == tlm::TLM_WRITE_COMMAND) {
-            memcpy(&aux_value, ptr, len);
-            switch (addr) {
-                case TIMER_MEMORY_ADDRESS_LO:
-                    m_mtime.range(31, 0) = aux_value;
-                    break;
-                case TIMER_MEMORY_ADDRESS_HI:
-                    m_mtime.range(63, 32) = aux_value;
-                    break;
-                case TIMERCMP_MEMORY_ADDRESS_LO:
-                    m_mtimecmp.range(31, 0) = aux_value;
-                    break;
-                case TIMERCMP_MEMORY_ADDRESS_HI:
-                    m_mtimecmp.range(63, 32) = aux_value;
-
-                    std::uint64_t notify_time;
-                    // notify needs relative time, mtimecmp works in absolute time
-                    notify_time = m_mtimecmp - m_mtime;
-
-                    //timer_event.notify(sc_core::sc_time(notify_time, sc_core::SC_NS));
-                    timer_event.notify(sc_core::sc_time::from_value(notify_time));
-                    break;
-                default:
-                    trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
-                    return;
-            }
-        } else { // TLM_READ_COMMAND
-            switch (addr) {
-                case TIMER_MEMORY_ADDRESS_LO:
-                    m_mtime = sc_core::sc_time_stamp().value();
-                    aux_value = m_mtime.range(31, 0);
-                    break;
-                case TIMER_MEMORY_ADDRESS_HI:
-                    aux_value = m_mtime.range(63, 32);
-                    break;
-                case TIMERCMP_MEMORY_ADDRESS_LO:
-                    aux_value = m_mtimecmp.range(31, 0);
-                    break;
-                case TIMERCMP_MEMORY_ADDRESS_HI:
-                    aux_value = m_mtimecmp.range(63, 32);
-                    break;
-                default:
-                    trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
-                    return;
-            }
-            memcpy(ptr, &aux_value, len);
-        }
-
-        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    bool Timer::get_direct_mem_ptr(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi_data) {
+        return regs.dmi(trans, dmi_data);
     }
-}
\ No newline at end of file
+}
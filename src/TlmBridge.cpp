@@ -0,0 +1,444 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file TlmBridge.cpp
+ * @brief Shared-memory TLM bridge stubs and their time synchronisation
+ */
+
+#include "TlmBridge.h"
+#include "SelfProfile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+namespace riscv_tlm {
+
+    BridgeSpec BridgeSpec::s_platform;
+
+    namespace {
+        constexpr const char *CHANNEL_PREFIX = "/riscv_vp.bridge.";
+
+        bool number(const std::string &text, std::uint64_t &value) {
+            try {
+                std::size_t used = 0;
+                value = std::stoull(text, &used, 0);
+                return used == text.size();
+            } catch (...) {
+                return false;
+            }
+        }
+
+        bool duration(const std::string &text, std::uint64_t &ps) {
+            static const struct {
+                const char *unit;
+                std::uint64_t scale;
+            } units[] = {{"ps", 1}, {"ns", 1000}, {"us", 1000000}, {"ms", 1000000000}};
+
+            for (auto const &u : units) {
+                const std::size_t len = std::strlen(u.unit);
+                if (text.size() > len && text.compare(text.size() - len, len, u.unit) == 0) {
+                    std::uint64_t value = 0;
+                    if (!number(text.substr(0, text.size() - len), value)) {
+                        return false;
+                    }
+                    ps = value * u.scale;
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    bool BridgeSpec::parse(const std::string &spec, Role side, std::string &error) {
+        *this = BridgeSpec{};
+        role = side;
+
+        std::size_t pos = 0;
+        bool first = true;
+        while (pos <= spec.size()) {
+            std::size_t comma = spec.find(',', pos);
+            if (comma == std::string::npos) {
+                comma = spec.size();
+            }
+            const std::string item = spec.substr(pos, comma - pos);
+            pos = comma + 1;
+
+            if (first) {
+                first = false;
+                if (item.empty() || item.find('/') != std::string::npos) {
+                    error = "expected a channel name: " + spec;
+                    return false;
+                }
+                channel = item;
+                continue;
+            }
+
+            const std::size_t eq = item.find('=');
+            const std::string key = item.substr(0, eq);
+            const std::string value = eq == std::string::npos ? "" : item.substr(eq + 1);
+            bool ok = eq != std::string::npos;
+            if (key == "base") {
+                ok = ok && number(value, base);
+            } else if (key == "size" && side == Role::Out) {
+                ok = ok && number(value, size) && size > 0;
+            } else if (key == "remote" && side == Role::Out) {
+                ok = ok && number(value, remote);
+            } else if (key == "lookahead" && side == Role::Out) {
+                ok = ok && duration(value, lookahead_ps) && lookahead_ps > 0;
+            } else {
+                error = "unknown key: " + item;
+                return false;
+            }
+            if (!ok) {
+                error = "bad value: " + item;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // =========================================================================
+    // Channel and time synchronisation
+    // =========================================================================
+
+    BridgeEndpoint::BridgeEndpoint(sc_core::sc_module_name const &name, const BridgeSpec &spec, unsigned int side)
+            : sc_module(name) {
+        const std::string shm_name = CHANNEL_PREFIX + spec.channel;
+        std::string error;
+
+        if (side == 0) {
+            if (!m_shm.create(shm_name, sizeof(BridgeChannel), 0600, error)) {
+                SC_REPORT_ERROR("TlmBridge", error.c_str());
+                return;
+            }
+            m_channel = new(m_shm.data()) BridgeChannel{};
+            m_channel->version = BridgeChannel::VERSION;
+            m_channel->creator_pid = SharedMemory::processId();
+            m_channel->lookahead_ps = spec.lookahead_ps;
+        } else {
+            /* the other process may not have created the channel yet */
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+            bool waiting = false;
+            while (true) {
+                if (m_shm.attach(shm_name, sizeof(BridgeChannel), error)) {
+                    auto *channel = static_cast<BridgeChannel *>(m_shm.data());
+                    if (channel->magic.load(std::memory_order_acquire) == BridgeChannel::MAGIC
+                        && SharedMemory::processAlive(channel->creator_pid)) {
+                        m_channel = channel;
+                        break;
+                    }
+                    m_shm.close();      // being set up, or left behind by a crashed run
+                }
+                if (std::chrono::steady_clock::now() > deadline) {
+                    SC_REPORT_ERROR("TlmBridge", (shm_name + ": no peer created it").c_str());
+                    return;
+                }
+                if (!waiting) {
+                    std::cout << "[bridge] waiting for " << shm_name << "\n";
+                    waiting = true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            if (m_channel->version != BridgeChannel::VERSION) {
+                SC_REPORT_ERROR("TlmBridge", (shm_name + ": version mismatch").c_str());
+                m_channel = nullptr;
+                return;
+            }
+        }
+
+        m_out = &m_channel->link[side];
+        m_in = &m_channel->link[side ^ 1];
+        m_lookahead_ps = m_channel->lookahead_ps;
+        m_lookahead = fromPs(m_lookahead_ps);
+        m_out->state.store(BridgeLink::Running, std::memory_order_release);
+        if (side == 0) {
+            m_channel->magic.store(BridgeChannel::MAGIC, std::memory_order_release);
+        }
+
+        SC_THREAD(sync_thread);
+    }
+
+    BridgeEndpoint::~BridgeEndpoint() {
+        if (m_out != nullptr) {
+            m_out->state.store(BridgeLink::Finished, std::memory_order_release);
+        }
+    }
+
+    std::uint64_t BridgeEndpoint::toPs(const sc_core::sc_time &t) {
+        return static_cast<std::uint64_t>(t / sc_core::sc_time(1, sc_core::SC_PS) + 0.5);
+    }
+
+    sc_core::sc_time BridgeEndpoint::fromPs(std::uint64_t ps) {
+        return sc_core::sc_time(static_cast<double>(ps), sc_core::SC_PS);
+    }
+
+    sc_core::sc_time BridgeEndpoint::until(std::uint64_t time_ps) {
+        const std::uint64_t now = nowPs();
+        return time_ps > now ? fromPs(time_ps - now) : sc_core::SC_ZERO_TIME;
+    }
+
+    void BridgeEndpoint::send(BridgeMessage &msg) {
+        msg.time_ps = std::max(msg.time_ps, m_granted);
+        unsigned int spins = 0;
+        while (!m_out->ring.push(msg)) {
+            /* the other side may be waiting for room in our incoming ring */
+            poll();
+            backoff(spins);
+        }
+    }
+
+    void BridgeEndpoint::poll() {
+        BridgeMessage msg;
+        while (m_in->ring.pop(msg)) {
+            receive(msg);
+        }
+    }
+
+    void BridgeEndpoint::grant(std::uint64_t time_ps) {
+        if (time_ps > m_granted) {
+            m_granted = time_ps;
+            m_out->grant_ps.store(time_ps, std::memory_order_release);
+        }
+    }
+
+    void BridgeEndpoint::setBlocked(bool blocked) {
+        m_out->blocked.store(blocked ? 1 : 0, std::memory_order_release);
+    }
+
+    bool BridgeEndpoint::peerFinished() const {
+        return m_in->state.load(std::memory_order_acquire) == BridgeLink::Finished;
+    }
+
+    void BridgeEndpoint::backoff(unsigned int &spins) {
+        if (++spins < 1024) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+    }
+
+    void BridgeEndpoint::sync_thread() {
+        while (true) {
+            const std::uint64_t next = nowPs() + m_lookahead_ps;
+            grant(next);
+
+            /* advance by one lookahead once the other side has granted that far */
+            unsigned int spins = 0;
+            const auto since = std::chrono::steady_clock::now();
+            bool announced = false;
+            while (true) {
+                const std::uint32_t state = m_in->state.load(std::memory_order_acquire);
+                const bool blocked = m_in->blocked.load(std::memory_order_acquire) != 0;
+                const std::uint64_t granted = m_in->grant_ps.load(std::memory_order_acquire);
+                poll();     // everything sent before that grant
+                if (state == BridgeLink::Finished) {
+                    if (m_stop_with_peer) {
+                        sc_core::sc_stop();
+                    }
+                    return;
+                }
+                if (state == BridgeLink::Running && ((blocked && owesResponse()) || granted >= next)) {
+                    break;
+                }
+                if (state == BridgeLink::Absent && !announced
+                    && std::chrono::steady_clock::now() - since > std::chrono::seconds(1)) {
+                    std::cout << "[bridge] " << name() << ": waiting for the other side\n";
+                    announced = true;
+                }
+                backoff(spins);
+            }
+            wait(m_lookahead);
+        }
+    }
+
+    void BridgeEndpoint::end_of_simulation() {
+        if (m_out != nullptr) {
+            m_out->state.store(BridgeLink::Finished, std::memory_order_release);
+        }
+    }
+
+    // =========================================================================
+    // Target side
+    // =========================================================================
+
+    BridgeTargetStub::BridgeTargetStub(sc_core::sc_module_name const &name, const BridgeSpec &spec)
+            : BridgeEndpoint(name, spec, 0), socket("socket"), m_remote(spec.remote) {
+        socket.register_b_transport(this, &BridgeTargetStub::b_transport);
+
+        SC_METHOD(interrupt_method);
+        sensitive << m_interrupt_event;
+        dont_initialize();
+    }
+
+    void BridgeTargetStub::b_transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+        const unsigned int len = trans.get_data_length();
+        if (trans.get_byte_enable_ptr() != nullptr) {
+            trans.set_response_status(tlm::TLM_BYTE_ENABLE_ERROR_RESPONSE);
+            return;
+        }
+        if (len > BRIDGE_MAX_DATA || trans.get_streaming_width() < len) {
+            trans.set_response_status(tlm::TLM_BURST_ERROR_RESPONSE);
+            return;
+        }
+        if (peerFinished()) {
+            trans.set_response_status(tlm::TLM_GENERIC_ERROR_RESPONSE);
+            return;
+        }
+
+        /* catch up with the caller's local time so the request is stamped with it */
+        const bool in_thread = sc_core::sc_get_current_process_handle().proc_kind() == sc_core::SC_THREAD_PROC_;
+        if (in_thread) {
+            RVVP_PROFILE_SUSPEND();
+            wait(delay);
+            delay = sc_core::SC_ZERO_TIME;
+        }
+
+        BridgeMessage request{};
+        request.kind = BridgeMessage::Request;
+        request.command = static_cast<std::uint32_t>(trans.get_command());
+        request.time_ps = nowPs() + m_lookahead_ps;
+        request.address = m_remote + trans.get_address();
+        request.length = len;
+        if (trans.is_write()) {
+            std::memcpy(request.data, trans.get_data_ptr(), len);
+        }
+        grant(request.time_ps);
+        send(request);
+
+        /* the kernel stops here, so nothing else is sent until the response */
+        setBlocked(true);
+        m_has_response = false;
+        unsigned int spins = 0;
+        while (!m_has_response && !peerFinished()) {
+            poll();
+            backoff(spins);
+        }
+        poll();
+        grant(m_response.time_ps + m_lookahead_ps);
+        setBlocked(false);
+
+        if (!m_has_response) {
+            trans.set_response_status(tlm::TLM_GENERIC_ERROR_RESPONSE);
+            return;
+        }
+        if (trans.is_read()) {
+            std::memcpy(trans.get_data_ptr(), m_response.data, len);
+        }
+        trans.set_response_status(static_cast<tlm::tlm_response_status>(m_response.status));
+        if (in_thread) {
+            RVVP_PROFILE_SUSPEND();
+            wait(until(m_response.time_ps));
+        } else {
+            delay += until(m_response.time_ps);
+        }
+    }
+
+    void BridgeTargetStub::receive(const BridgeMessage &msg) {
+        if (msg.kind == BridgeMessage::Response) {
+            m_response = msg;
+            m_has_response = true;
+        } else if (msg.kind == BridgeMessage::Interrupt) {
+            m_interrupts.push_back(msg);
+            m_interrupt_event.notify(until(m_interrupts.front().time_ps));
+        }
+    }
+
+    void BridgeTargetStub::interrupt_method() {
+        const std::uint64_t now = nowPs();
+        while (!m_interrupts.empty() && m_interrupts.front().time_ps <= now) {
+            const BridgeMessage &msg = m_interrupts.front();
+            if (m_on_interrupt) {
+                m_on_interrupt(msg.command, msg.status != 0);
+            }
+            m_interrupts.pop_front();
+        }
+        if (!m_interrupts.empty()) {
+            m_interrupt_event.notify(until(m_interrupts.front().time_ps));
+        }
+    }
+
+    // =========================================================================
+    // Initiator side
+    // =========================================================================
+
+    BridgeInitiatorStub::BridgeInitiatorStub(sc_core::sc_module_name const &name, const BridgeSpec &spec)
+            : BridgeEndpoint(name, spec, 1), socket("socket"), irq_socket("irq_socket") {
+        m_stop_with_peer = true;
+        irq_socket.register_b_transport(this, &BridgeInitiatorStub::doorbell);
+
+        SC_THREAD(request_thread);
+    }
+
+    void BridgeInitiatorStub::setInterrupt(std::uint32_t line, bool level) {
+        BridgeMessage msg{};
+        msg.kind = BridgeMessage::Interrupt;
+        msg.command = line;
+        msg.status = level ? 1 : 0;
+        msg.time_ps = nowPs() + m_lookahead_ps;
+        send(msg);
+    }
+
+    void BridgeInitiatorStub::receive(const BridgeMessage &msg) {
+        if (msg.kind == BridgeMessage::Request) {
+            m_unanswered++;
+            m_requests.push_back(msg);
+            m_request_event.notify(until(m_requests.front().time_ps));
+        }
+    }
+
+    void BridgeInitiatorStub::request_thread() {
+        tlm::tlm_generic_payload trans;
+        std::uint8_t data[BRIDGE_MAX_DATA];
+
+        while (true) {
+            wait(m_request_event);
+            while (!m_requests.empty() && m_requests.front().time_ps <= nowPs()) {
+                const BridgeMessage request = m_requests.front();
+                m_requests.pop_front();
+
+                std::memcpy(data, request.data, sizeof(data));
+                trans.set_command(static_cast<tlm::tlm_command>(request.command));
+                trans.set_address(request.address);
+                trans.set_data_ptr(data);
+                trans.set_data_length(request.length);
+                trans.set_streaming_width(request.length);
+                trans.set_byte_enable_ptr(nullptr);
+                trans.set_dmi_allowed(false);
+                trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+                sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+                socket->b_transport(trans, delay);
+
+                BridgeMessage response{};
+                response.kind = BridgeMessage::Response;
+                response.time_ps = nowPs() + toPs(delay) + m_lookahead_ps;
+                response.address = request.address;
+                response.length = request.length;
+                response.status = static_cast<std::int32_t>(trans.get_response_status());
+                if (trans.is_read()) {
+                    std::memcpy(response.data, data, request.length);
+                }
+                send(response);
+                m_unanswered--;
+            }
+            if (!m_requests.empty()) {
+                m_request_event.notify(until(m_requests.front().time_ps));
+            }
+        }
+    }
+
+    void BridgeInitiatorStub::doorbell(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+        (void) delay;
+        if (trans.is_write() && trans.get_address() == 0 && trans.get_data_length() == 4) {
+            std::uint32_t value = 0;
+            std::memcpy(&value, trans.get_data_ptr(), 4);
+            setInterrupt(value & 0x7FFFFFFF, (value >> 31) != 0);
+        } else if (trans.is_read()) {
+            std::memset(trans.get_data_ptr(), 0, trans.get_data_length());
+        }
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+}
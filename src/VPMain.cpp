@@ -16,10 +16,21 @@
 #include <string>
 #include <cmath>
 #include <iomanip>
+#include <map>
 #include <cstdlib>
+#include <vector>
 
 #include "VPTop.h"
 #include "Performance.h"
+#include "PluginManager.h"
+#include "SelfProfile.h"
+#include "ClockDomains.h"
+#include "IssueRules.h"
+#include "RunControl.h"
+#include "Telemetry.h"
+#include "TlmBridge.h"
+#include "NetLink.h"
+#include "FaultCampaign.h"
 #if defined(ENABLE_PIPELINED_ISS)
   #if defined(ENABLE_CYCLE6_MODEL)
     #include "CPU_P32_6_Cycle.h"
@@ -60,6 +71,21 @@ struct Options {
     riscv_tlm::cpu_types_t cpu_type = riscv_tlm::RV32;
     double timeout_sec = -1.0;
     std::uint64_t max_instructions = 0;
+    bool profile = false;
+    bool zcmp = false;
+    std::string pairing;
+    std::string clocks;
+    std::vector<std::string> clocks_at;
+    std::string symbols;
+    std::vector<std::string> stop_at;
+    std::vector<std::string> pause_at;
+    std::vector<std::string> plugins;
+    bool telemetry = false;
+    bool telemetry_ram = false;
+    std::string bridge_out;
+    std::string bridge_in;
+    std::string net;
+    std::string inject;
 };
 
 static void usage(const char* exe) {
@@ -83,6 +109,26 @@ static void usage(const char* exe) {
     std::cout << "  -D, --debug             Enable debug mode\n";
     std::cout << "  -t, --timeout <sec>     Wall-clock timeout in seconds\n";
     std::cout << "  --max-instr <N>         Maximum instructions to execute\n";
+    std::cout << "  --stop-at <cond>        Stop exactly at a condition (repeatable):\n";
+    std::cout << "                          instr=N, cycle=N, pc=A, enter=SYM, exit=SYM, write=A[+LEN]\n";
+    std::cout << "  --pause-at <cond>       Pause at a condition, report it and resume (repeatable)\n";
+    std::cout << "  --symbols <file.elf>    ELF file whose symbols the conditions may name\n";
+    std::cout << "  --profile               Report host time per simulator component at exit\n";
+    std::cout << "  --plugin <lib[,args]>   Load an instrumentation plugin (repeatable)\n";
+    std::cout << "  --zcmp                  Decode Zcmp/Zcmt instead of C.FSDSP\n";
+    std::cout << "  --pairing <spec>        6-stage issue width and pairing rules, e.g. width=2,lsu=1,no=load+mul\n";
+    std::cout << "  --clocks <spec>         Clock domain frequencies and access cycles,\n";
+    std::cout << "                          e.g. core=200MHz,bus=100MHz,memory=50MHz:4,peripheral=1MHz\n";
+    std::cout << "  --clocks-at <spec@cond> Change clock domains when a --pause-at condition fires (repeatable)\n";
+    std::cout << "  --telemetry             Publish live counters in /riscv_vp.<pid> (see vp_top)\n";
+    std::cout << "  --telemetry-ram         As --telemetry, and share the guest RAM read-only\n";
+    std::cout << "  --bridge-out <spec>     Forward a bus window to another VP process,\n";
+    std::cout << "                          e.g. link0,base=0x60000000,size=0x1000,remote=0x10000000,lookahead=10us\n";
+    std::cout << "  --bridge-in <spec>      Serve the window another VP process forwards, e.g. link0\n";
+    std::cout << "  --net <spec>            Plug the virtio-net device into a shared-memory segment,\n";
+    std::cout << "                          e.g. lan0,latency=50us,bandwidth=100Mbps,nodes=3\n";
+    std::cout << "  --inject <spec>         Run a fault-injection campaign instead of the program,\n";
+    std::cout << "                          e.g. target=gpr,count=10000,bits=1,window=1000:50000,report=faults.csv\n";
 }
 
 static Options parse(int argc, char* argv[]) {
@@ -110,6 +156,37 @@ static Options parse(int argc, char* argv[]) {
                 std::exit(1);
             }
             o.max_instructions = val;
+        } else if (std::strcmp(argv[i], "--profile") == 0) {
+            o.profile = true;
+        } else if (std::strcmp(argv[i], "--zcmp") == 0) {
+            o.zcmp = true;
+        } else if ((std::strcmp(argv[i], "--stop-at") == 0) && i+1 < argc) {
+            o.stop_at.emplace_back(argv[++i]);
+        } else if ((std::strcmp(argv[i], "--pause-at") == 0) && i+1 < argc) {
+            o.pause_at.emplace_back(argv[++i]);
+        } else if ((std::strcmp(argv[i], "--symbols") == 0) && i+1 < argc) {
+            o.symbols = argv[++i];
+        } else if ((std::strcmp(argv[i], "--pairing") == 0) && i+1 < argc) {
+            o.pairing = argv[++i];
+        } else if ((std::strcmp(argv[i], "--clocks") == 0) && i+1 < argc) {
+            o.clocks = argv[++i];
+        } else if ((std::strcmp(argv[i], "--clocks-at") == 0) && i+1 < argc) {
+            o.clocks_at.emplace_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--telemetry") == 0) {
+            o.telemetry = true;
+        } else if (std::strcmp(argv[i], "--telemetry-ram") == 0) {
+            o.telemetry = true;
+            o.telemetry_ram = true;
+        } else if ((std::strcmp(argv[i], "--bridge-out") == 0) && i+1 < argc) {
+            o.bridge_out = argv[++i];
+        } else if ((std::strcmp(argv[i], "--bridge-in") == 0) && i+1 < argc) {
+            o.bridge_in = argv[++i];
+        } else if ((std::strcmp(argv[i], "--net") == 0) && i+1 < argc) {
+            o.net = argv[++i];
+        } else if ((std::strcmp(argv[i], "--inject") == 0) && i+1 < argc) {
+            o.inject = argv[++i];
+        } else if ((std::strcmp(argv[i], "--plugin") == 0) && i+1 < argc) {
+            o.plugins.emplace_back(argv[++i]);
         } else if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
             usage(argv[0]);
             std::exit(0);
@@ -118,25 +195,49 @@ static Options parse(int argc, char* argv[]) {
             std::exit(1);
         }
     }
-    if (o.hex_file.empty()) {
+    if (o.hex_file.empty() || (!o.bridge_out.empty() && !o.bridge_in.empty())) {
         usage(argv[0]);
         std::exit(1);
     }
+    // A campaign drives the run control itself and forks the whole simulator
+    if (!o.inject.empty() && (o.debug || o.telemetry || !o.bridge_out.empty() || !o.bridge_in.empty() ||
+                              !o.net.empty() || !o.stop_at.empty() || !o.pause_at.empty() || !o.clocks_at.empty())) {
+        std::cerr << "--inject cannot be combined with -D, --telemetry, --bridge-*, --net, --stop-at, --pause-at "
+                     "or --clocks-at\n";
+        std::exit(1);
+    }
     return o;
 }
 
 int sc_main(int argc, char* argv[]) {
     signal(SIGINT, intHandler);
-    sc_core::sc_set_time_resolution(1, sc_core::SC_NS);
+    sc_core::sc_set_time_resolution(1, sc_core::SC_PS);
 
     const auto opts = parse(argc, argv);
 
+    auto prof = riscv_tlm::SelfProfile::getInstance();
+    if (opts.profile) {
+#if defined(ENABLE_SELF_PROFILE)
+        prof->setEnabled(true);
+#else
+        std::cerr << "Warning: --profile ignored, rebuild with -DENABLE_SELF_PROFILE=ON\n";
+#endif
+    }
+
     // Setup logger
     try {
         auto existing = spdlog::get("my_logger");
         if (!existing) {
             spdlog::filename_t log_filename = SPDLOG_FILENAME_T("vp.log");
-            auto logger = spdlog::create<spdlog::sinks::basic_file_sink_mt>("my_logger", log_filename, true);
+            std::shared_ptr<spdlog::logger> logger;
+            if (prof->isEnabled()) {
+                auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(log_filename, true);
+                logger = std::make_shared<spdlog::logger>("my_logger",
+                                                          std::make_shared<riscv_tlm::ProfilingSink>(file_sink));
+                spdlog::register_logger(logger);
+            } else {
+                logger = spdlog::create<spdlog::sinks::basic_file_sink_mt>("my_logger", log_filename, true);
+            }
             logger->set_pattern("%v");
             logger->set_level(spdlog::level::info);
         }
@@ -180,7 +281,135 @@ int sc_main(int argc, char* argv[]) {
         std::cout << "  max : " << opts.max_instructions << " instr\n";
     }
 
+    if (opts.zcmp) {
+        std::cout << "  zc  : Zcb, Zcmp, Zcmt (no C.FSDSP)\n";
+    }
+    riscv_tlm::CodeSizeExtensions::enable(opts.zcmp);
+
+    // The 6-stage models copy the pairing rules when they are constructed
+    riscv_tlm::PairingRules pairing = riscv_tlm::PairingRules::defaults();
+    std::string pairing_error;
+    if (!pairing.parse(opts.pairing, pairing_error)) {
+        std::cerr << "--pairing: " << pairing_error << "\n";
+        std::exit(1);
+    }
+    riscv_tlm::PairingRules::setDefaults(pairing);
+#if defined(ENABLE_CYCLE6_MODEL)
+    std::cout << "  issue: " << pairing.width << "-wide\n";
+#endif
+
+    // Clock domains take their initial frequencies before the top level creates them
+    auto *clocks = riscv_tlm::ClockDomains::getInstance();
+    std::string clocks_error;
+    if (!clocks->parse(opts.clocks, clocks_error)) {
+        std::cerr << "--clocks: " << clocks_error << "\n";
+        std::exit(1);
+    }
+
+    // Run control: exact stop and pause conditions checked as instructions retire
+    auto *run_control = riscv_tlm::RunControl::getInstance();
+    std::string run_error;
+    if (!opts.symbols.empty() && !run_control->loadSymbols(opts.symbols, run_error)) {
+        std::cerr << "--symbols: " << run_error << "\n";
+        std::exit(1);
+    }
+    std::vector<std::string> stop_at = opts.stop_at;
+    if (opts.max_instructions > 0 && opts.inject.empty()) {
+        stop_at.push_back("instr=" + std::to_string(opts.max_instructions));
+    }
+    for (auto const &cond : stop_at) {
+        if (!run_control->add(cond, riscv_tlm::RunControl::Action::Stop, run_error)) {
+            std::cerr << "--stop-at: " << run_error << "\n";
+            std::exit(1);
+        }
+    }
+    for (auto const &cond : opts.pause_at) {
+        if (!run_control->add(cond, riscv_tlm::RunControl::Action::Pause, run_error)) {
+            std::cerr << "--pause-at: " << run_error << "\n";
+            std::exit(1);
+        }
+    }
+    // --clocks-at <spec>@<cond>: the spec is applied while the simulation is paused at cond
+    std::multimap<std::string, std::string> clock_changes;
+    for (auto const &item : opts.clocks_at) {
+        std::string::size_type at = item.find('@');
+        if (at == std::string::npos) {
+            std::cerr << "--clocks-at: expected <spec>@<condition>: " << item << "\n";
+            std::exit(1);
+        }
+        const std::string cond = item.substr(at + 1);
+        if (!run_control->add(cond, riscv_tlm::RunControl::Action::Pause, run_error)) {
+            std::cerr << "--clocks-at: " << run_error << "\n";
+            std::exit(1);
+        }
+        clock_changes.emplace(cond, item.substr(0, at));
+    }
+
+    // Telemetry page first: Memory allocates the guest RAM in it with --telemetry-ram
+    auto *telemetry = riscv_tlm::Telemetry::getInstance();
+    if (opts.telemetry) {
+        std::string telemetry_error;
+        if (!telemetry->open(opts.telemetry_ram, telemetry_error)) {
+            std::cerr << "--telemetry: " << telemetry_error << "\n";
+            std::exit(1);
+        }
+    }
+
+    // The top level builds one side of a bridge to another VP process, if asked
+    if (!opts.bridge_out.empty() || !opts.bridge_in.empty()) {
+        const bool out = !opts.bridge_out.empty();
+        riscv_tlm::BridgeSpec bridge;
+        std::string bridge_error;
+        if (!bridge.parse(out ? opts.bridge_out : opts.bridge_in,
+                          out ? riscv_tlm::BridgeSpec::Role::Out : riscv_tlm::BridgeSpec::Role::In,
+                          bridge_error)) {
+            std::cerr << (out ? "--bridge-out: " : "--bridge-in: ") << bridge_error << "\n";
+            std::exit(1);
+        }
+        riscv_tlm::BridgeSpec::setPlatform(bridge);
+    }
+    if (!opts.net.empty()) {
+        riscv_tlm::NetSpec net;
+        std::string net_error;
+        if (!net.parse(opts.net, net_error)) {
+            std::cerr << "--net: " << net_error << "\n";
+            std::exit(1);
+        }
+        riscv_tlm::NetSpec::setPlatform(net);
+    }
+
+    riscv_tlm::FaultCampaign::Options campaign;
+    if (!opts.inject.empty()) {
+        std::string inject_error;
+        if (!riscv_tlm::FaultCampaign::parse(opts.inject, campaign, inject_error)) {
+            std::cerr << "--inject: " << inject_error << "\n";
+            std::exit(1);
+        }
+        campaign.max_instructions = opts.max_instructions;
+    }
+
+    prof->beginPhase(riscv_tlm::SelfProfile::Elaboration);
     g_top = new vp::VPTop("vp_top", opts.hex_file, opts.cpu_type, opts.debug);
+    prof->endPhase(riscv_tlm::SelfProfile::Elaboration);
+
+    // Plugins are installed once the CPU has registered its hart, so they see the hart count
+    for (auto const &spec : opts.plugins) {
+        if (!riscv_tlm::PluginManager::getInstance()->load(spec, opts.cpu_type == riscv_tlm::RV32 ? 32 : 64)) {
+            std::exit(1);
+        }
+    }
+
+    if (!opts.inject.empty()) {
+        return riscv_tlm::FaultCampaign::getInstance()->run(campaign, g_top->cpu, g_top->MainMemory,
+                                                           opts.cpu_type == riscv_tlm::RV32 ? 32 : 64);
+    }
+
+    if (telemetry->isOpen()) {
+        telemetry->describe(std::string(riscv_tlm::timing_model_name(vp::VPTop::getTimingModel()))
+                            + (opts.cpu_type == riscv_tlm::RV32 ? " RV32" : " RV64"), opts.hex_file);
+        telemetry->publish(g_top->cpu);
+        std::cout << "  tele: " << telemetry->name() << "\n";
+    }
 
     auto wall_start = std::chrono::steady_clock::now();
 
@@ -188,8 +417,13 @@ int sc_main(int argc, char* argv[]) {
     bool timed_out = false;
     bool reached_instr_limit = false;
 
+    prof->beginPhase(riscv_tlm::SelfProfile::Simulation);
     while (true) {
-        sc_core::sc_start(quantum);
+        {
+            RVVP_PROFILE_SCOPE(Kernel);
+            sc_core::sc_start(quantum);
+        }
+        telemetry->publish(g_top->cpu);
 
         if (opts.timeout_sec > 0) {
             auto now = std::chrono::steady_clock::now();
@@ -201,18 +435,32 @@ int sc_main(int argc, char* argv[]) {
             }
         }
         
-        if (opts.max_instructions > 0 && perf->getInstructions() >= opts.max_instructions) {
-            reached_instr_limit = true;
-            sc_core::sc_stop();
-            break;
+        // Report the conditions that fired; a pause resumes with the next slice
+        riscv_tlm::RunControl::Hit hit;
+        while (run_control->takeHit(hit)) {
+            auto changes = clock_changes.equal_range(hit.condition);
+            if (changes.first != changes.second) {
+                for (auto it = changes.first; it != changes.second; ++it) {
+                    if (!clocks->parse(it->second, clocks_error)) {
+                        std::cerr << "--clocks-at: " << clocks_error << "\n";
+                    }
+                }
+                continue;
+            }
+            std::cout << "[run-control] " << (hit.action == riscv_tlm::RunControl::Action::Stop ? "stop" : "pause")
+                      << " at " << hit.condition << ": " << hit.instructions << " instructions, cycle "
+                      << hit.cycle << ", pc 0x" << std::hex << hit.pc << std::dec << "\n";
         }
-        
+
         if (sc_core::sc_get_status() == sc_core::SC_STOPPED) {
             break;
         }
     }
+    reached_instr_limit = opts.max_instructions > 0 && perf->getInstructions() >= opts.max_instructions;
 
     auto wall_end = std::chrono::steady_clock::now();
+    prof->endPhase(riscv_tlm::SelfProfile::Simulation);
+    telemetry->publish(g_top->cpu, riscv_tlm::TelemetryState::Finished);
 
     std::chrono::duration<double> elapsed = wall_end - wall_start;
 
@@ -227,6 +475,14 @@ int sc_main(int argc, char* argv[]) {
     std::cout << "Wall time:    " << std::fixed << std::setprecision(3) << elapsed.count() << " s\n";
     std::cout << "Sim time:     " << sc_core::sc_time_stamp() << "\n";
     std::cout << "Instructions: " << perf->getInstructions() << "\n";
+    clocks->print(std::cout);
+    if (g_top->net_link != nullptr) {
+        const auto &net = g_top->net_link->stats();
+        std::cout << "Net:          tx " << net.tx_frames << " frames, " << net.tx_bytes << " bytes ("
+                  << net.tx_dropped << " dropped), rx " << net.rx_frames << " frames, " << net.rx_bytes
+                  << " bytes (" << net.rx_late << " late, " << net.rx_dropped + g_top->net->rxDropped()
+                  << " dropped)\n";
+    }
 
     // Print pipeline statistics
 #if defined(ENABLE_PIPELINED_ISS)
@@ -291,6 +547,9 @@ int sc_main(int argc, char* argv[]) {
     }
 #endif
 
+    prof->dump(sc_core::sc_delta_count());
+    riscv_tlm::PluginManager::getInstance()->shutdown();
+
     delete g_top;
     g_top = nullptr;
 
@@ -9,6 +9,8 @@
 
 #include "VPTop.h"
 
+#include <iomanip>
+
 // CPU includes based on timing model
 #if defined(ENABLE_PIPELINED_ISS)
   #if defined(ENABLE_CYCLE6_MODEL)
@@ -45,11 +47,16 @@ VPTop::VPTop(sc_core::sc_module_name const &name,
       uart(nullptr),
       clint(nullptr),
       plic(nullptr),
+      clic(nullptr),
       dma(nullptr),
       sysif(nullptr),
+      dvfs(nullptr),
+      net(nullptr),
+      net_link(nullptr),
+      bridge_out(nullptr),
+      bridge_in(nullptr),
       m_debug(debug_mode),
-      m_cpu_type(cpu_type),
-      clk("clk", sc_core::sc_time(10, sc_core::SC_NS))
+      m_cpu_type(cpu_type)
 {
     std::uint32_t start_PC;
 
@@ -108,12 +115,17 @@ VPTop::VPTop(sc_core::sc_module_name const &name,
 #endif
     }
 
-    cpu->set_clock(&clk);
+    // Core, bus, memory and peripheral clocks (--clocks, DVFS controller)
+    riscv_tlm::ClockDomains *clocks = riscv_tlm::ClockDomains::getInstance();
+    clocks->create();
+    cpu->set_clock(&clocks->core());
+    std::cout << "Core clock: " << clocks->core().frequency() / 1e6 << " MHz" << std::endl;
 
     // =========================================================================
     // Create Bus and Peripherals
     // =========================================================================
-    Bus = new riscv_tlm::BusCtrl("BusCtrl");
+    const riscv_tlm::BridgeSpec &bridge = riscv_tlm::BridgeSpec::platform();
+    Bus = new riscv_tlm::BusCtrl("BusCtrl", &bridge);
     std::cout << "Bus: LT (Loosely-Timed)" << std::endl;
 
     trace = new riscv_tlm::peripherals::Trace("Trace");
@@ -121,9 +133,15 @@ VPTop::VPTop(sc_core::sc_module_name const &name,
     uart  = new riscv_tlm::peripherals::UART("UART0");
     clint = new riscv_tlm::peripherals::CLINT("CLINT");
     plic  = new riscv_tlm::peripherals::PLIC("PLIC");
+    clic  = new riscv_tlm::CLIC("CLIC");
     dma   = new riscv_tlm::peripherals::DMA("DMA");
     dma->set_debug(m_debug);
     sysif = new riscv_tlm::peripherals::SyscallIf("SysIf");
+    dvfs  = new riscv_tlm::peripherals::DVFS("DVFS");
+    if (!riscv_tlm::NetSpec::platform().segment.empty()) {
+        net_link = new riscv_tlm::NetLink("NetLink", riscv_tlm::NetSpec::platform());
+    }
+    net   = new riscv_tlm::peripherals::VirtioNet("VirtioNet", net_link);
 
     cpu->instr_bus.bind(Bus->cpu_instr_socket);
     cpu->mem_intf->data_bus.bind(Bus->cpu_data_socket);
@@ -134,11 +152,47 @@ VPTop::VPTop(sc_core::sc_module_name const &name,
     Bus->uart_socket.bind(uart->socket);
     Bus->clint_socket.bind(clint->socket);
     Bus->plic_socket.bind(plic->socket);
+    Bus->clic_socket.bind(clic->socket);
     Bus->dma_socket.bind(dma->socket);
     Bus->syscall_socket.bind(sysif->socket);
+    Bus->dvfs_socket.bind(dvfs->socket);
+    Bus->net_socket.bind(net->socket);
 
     dma->mem_master.bind(Bus->dma_master_socket);
+    net->mem_master.bind(Bus->net_master_socket);
+    net->onInterrupt([this](bool level) {
+        plic->set_irq(riscv_tlm::peripherals::VirtioNet::PLIC_SOURCE, level);
+    });
     timer->irq_line.bind(cpu->irq_line_socket);
+    plic->irq_lines[0]->bind(cpu->ext_irq_socket);
+    cpu->attachCLIC(clic);
+
+    if (net_link != nullptr) {
+        const std::uint8_t *mac = net_link->mac();
+        std::cout << "Net: port " << net_link->port() << " of " << riscv_tlm::NetSpec::platform().segment
+                  << ", MAC " << std::hex << std::setfill('0');
+        for (int i = 0; i < 6; i++) {
+            std::cout << (i > 0 ? ":" : "") << std::setw(2) << static_cast<unsigned int>(mac[i]);
+        }
+        std::cout << std::dec << std::setfill(' ') << ", " << net_link->latency() << ", "
+                  << net_link->bandwidth() / 1e6 << " Mbit/s" << std::endl;
+    }
+
+    if (bridge.role == riscv_tlm::BridgeSpec::Role::Out) {
+        bridge_out = new riscv_tlm::BridgeTargetStub("BridgeOut", bridge);
+        Bus->bridge_socket->bind(bridge_out->socket);
+        bridge_out->onInterrupt([this](std::uint32_t line, bool level) {
+            plic->set_irq(line, level);
+        });
+        std::cout << "Bridge: 0x" << std::hex << bridge.base << "-0x" << bridge.base + bridge.size - 1
+                  << std::dec << " to " << bridge.channel << std::endl;
+    } else if (bridge.role == riscv_tlm::BridgeSpec::Role::In) {
+        bridge_in = new riscv_tlm::BridgeInitiatorStub("BridgeIn", bridge);
+        bridge_in->socket.bind(*Bus->bridge_master_socket);
+        Bus->bridge_socket->bind(bridge_in->irq_socket);
+        std::cout << "Bridge: requests from " << bridge.channel << ", doorbell at 0x"
+                  << std::hex << bridge.base << std::dec << std::endl;
+    }
 
     std::cout << "========================================" << std::endl;
 
@@ -150,8 +204,14 @@ VPTop::VPTop(sc_core::sc_module_name const &name,
 }
 
 VPTop::~VPTop() {
+    delete bridge_in;
+    delete bridge_out;
+    delete net;
+    delete net_link;
+    delete dvfs;
     delete sysif;
     delete dma;
+    delete clic;
     delete plic;
     delete clint;
     delete uart;
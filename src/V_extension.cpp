@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file V_extension.cpp
+ * @brief Implement V extension (RVV 1.0, integer subset) part of the RISC-V
+ */
+
+#include "V_extension.h"
+
+namespace riscv_tlm {
+
+    VectorTiming::Model VectorTiming::model;
+
+    void VectorTiming::setModel(Model m) {
+        model = std::move(m);
+    }
+
+    unsigned int VectorTiming::defaultCycles(const VectorOpInfo &op) {
+        std::uint64_t bits = op.vl * op.sew * op.fields;
+        auto passes = static_cast<unsigned int>((bits + RVV_VLEN - 1) / RVV_VLEN);
+        auto elements = static_cast<unsigned int>(op.vl * op.fields);
+
+        switch (op.kind) {
+            case VectorOpInfo::Kind::Config:
+                return 1;
+            case VectorOpInfo::Kind::Strided:
+            case VectorOpInfo::Kind::Indexed:
+            case VectorOpInfo::Kind::Serial:
+            case VectorOpInfo::Kind::Permute:
+                return std::max(1u, elements);
+            case VectorOpInfo::Kind::Reduction: {
+                /* One pass over the group, then a log2(lanes) adder tree */
+                unsigned int tree = 0;
+                for (unsigned int lanes = RVV_VLEN / std::max(1u, op.sew); lanes > 1; lanes >>= 1) {
+                    tree++;
+                }
+                return std::max(1u, passes) + tree;
+            }
+            default:
+                return std::max(1u, passes);
+        }
+    }
+}
@@ -0,0 +1,706 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file VectorKernels.cpp
+ * @brief Host SIMD kernels behind the RISC-V V extension
+ *
+ * Every operation has a scalar reference implementation. Operations with a
+ * direct AVX2 or SSE2 equivalent get a SIMD body over 32/16-byte blocks; the
+ * remaining tail elements reuse the scalar code, so results are identical
+ * whichever implementation runs. Set RVVP_VECTOR_ISA=scalar|sse2|avx2 to
+ * force an implementation (for benchmarking and cross-checking).
+ */
+
+#include "VectorKernels.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RVV_HOST_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define RVV_TARGET_AVX2
+#else
+#define RVV_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define RVV_HOST_X86 0
+#endif
+
+namespace riscv_tlm {
+
+namespace {
+
+using HostIsa = VectorKernels::HostIsa;
+
+/* Element access; memcpy keeps mixed-width use of the register file well defined */
+template<typename U>
+inline U ld(const void *p, std::size_t i) {
+    U v;
+    std::memcpy(&v, static_cast<const std::uint8_t *>(p) + i * sizeof(U), sizeof(U));
+    return v;
+}
+
+template<typename U>
+inline void st(void *p, std::size_t i, U v) {
+    std::memcpy(static_cast<std::uint8_t *>(p) + i * sizeof(U), &v, sizeof(U));
+}
+
+inline void setMaskBit(std::uint8_t *mask, std::size_t i, bool v) {
+    auto bit = static_cast<std::uint8_t>(1u << (i & 7));
+    mask[i >> 3] = static_cast<std::uint8_t>(v ? (mask[i >> 3] | bit) : (mask[i >> 3] & ~bit));
+}
+
+inline bool getMaskBit(const std::uint8_t *mask, std::size_t i) {
+    return ((mask[i >> 3] >> (i & 7)) & 1) != 0;
+}
+
+/* 64x64 -> upper 64 bits, without relying on __int128 */
+inline std::uint64_t mulhu64(std::uint64_t a, std::uint64_t b) {
+    std::uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+    std::uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+    std::uint64_t p0 = a_lo * b_lo;
+    std::uint64_t p1 = a_lo * b_hi;
+    std::uint64_t p2 = a_hi * b_lo;
+    std::uint64_t p3 = a_hi * b_hi;
+    std::uint64_t mid = (p0 >> 32) + (p1 & 0xFFFFFFFF) + (p2 & 0xFFFFFFFF);
+    return p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+}
+
+inline std::uint64_t mulh64(std::uint64_t a, std::uint64_t b) {
+    std::uint64_t h = mulhu64(a, b);
+    if (static_cast<std::int64_t>(a) < 0) {
+        h -= b;
+    }
+    if (static_cast<std::int64_t>(b) < 0) {
+        h -= a;
+    }
+    return h;
+}
+
+inline std::uint64_t mulhsu64(std::uint64_t a, std::uint64_t b) {
+    std::uint64_t h = mulhu64(a, b);
+    if (static_cast<std::int64_t>(a) < 0) {
+        h -= b;
+    }
+    return h;
+}
+
+/* --- Scalar reference ------------------------------------------------------ */
+
+template<VecBinOp OP, typename U>
+inline U scalarOp(U a, U b) {
+    using S = typename std::make_signed<U>::type;
+    constexpr unsigned int bits = sizeof(U) * 8;
+    constexpr U shmask = bits - 1;
+
+    if constexpr (OP == VecBinOp::Add) {
+        return static_cast<U>(a + b);
+    } else if constexpr (OP == VecBinOp::Sub) {
+        return static_cast<U>(a - b);
+    } else if constexpr (OP == VecBinOp::RSub) {
+        return static_cast<U>(b - a);
+    } else if constexpr (OP == VecBinOp::And) {
+        return static_cast<U>(a & b);
+    } else if constexpr (OP == VecBinOp::Or) {
+        return static_cast<U>(a | b);
+    } else if constexpr (OP == VecBinOp::Xor) {
+        return static_cast<U>(a ^ b);
+    } else if constexpr (OP == VecBinOp::MinU) {
+        return a < b ? a : b;
+    } else if constexpr (OP == VecBinOp::Min) {
+        return static_cast<S>(a) < static_cast<S>(b) ? a : b;
+    } else if constexpr (OP == VecBinOp::MaxU) {
+        return a > b ? a : b;
+    } else if constexpr (OP == VecBinOp::Max) {
+        return static_cast<S>(a) > static_cast<S>(b) ? a : b;
+    } else if constexpr (OP == VecBinOp::Sll) {
+        return static_cast<U>(static_cast<std::uint64_t>(a) << (b & shmask));
+    } else if constexpr (OP == VecBinOp::Srl) {
+        return static_cast<U>(a >> (b & shmask));
+    } else if constexpr (OP == VecBinOp::Sra) {
+        return static_cast<U>(static_cast<S>(a) >> (b & shmask));
+    } else if constexpr (OP == VecBinOp::Mul) {
+        return static_cast<U>(static_cast<std::uint64_t>(a) * static_cast<std::uint64_t>(b));
+    } else if constexpr (OP == VecBinOp::MulH) {
+        if constexpr (bits == 64) {
+            return mulh64(a, b);
+        } else {
+            return static_cast<U>((static_cast<std::int64_t>(static_cast<S>(a)) *
+                                   static_cast<std::int64_t>(static_cast<S>(b))) >> bits);
+        }
+    } else if constexpr (OP == VecBinOp::MulHU) {
+        if constexpr (bits == 64) {
+            return mulhu64(a, b);
+        } else {
+            return static_cast<U>((static_cast<std::uint64_t>(a) * static_cast<std::uint64_t>(b)) >> bits);
+        }
+    } else if constexpr (OP == VecBinOp::MulHSU) {
+        if constexpr (bits == 64) {
+            return mulhsu64(a, b);
+        } else {
+            return static_cast<U>((static_cast<std::int64_t>(static_cast<S>(a)) *
+                                   static_cast<std::int64_t>(b)) >> bits);
+        }
+    } else if constexpr (OP == VecBinOp::DivU) {
+        return b == 0 ? std::numeric_limits<U>::max() : static_cast<U>(a / b);
+    } else if constexpr (OP == VecBinOp::Div) {
+        if (b == 0) {
+            return std::numeric_limits<U>::max();
+        }
+        if (static_cast<S>(a) == std::numeric_limits<S>::min() && static_cast<S>(b) == -1) {
+            return a;
+        }
+        return static_cast<U>(static_cast<S>(a) / static_cast<S>(b));
+    } else if constexpr (OP == VecBinOp::RemU) {
+        return b == 0 ? a : static_cast<U>(a % b);
+    } else {
+        static_assert(OP == VecBinOp::Rem, "unhandled operation");
+        if (b == 0) {
+            return a;
+        }
+        if (static_cast<S>(a) == std::numeric_limits<S>::min() && static_cast<S>(b) == -1) {
+            return 0;
+        }
+        return static_cast<U>(static_cast<S>(a) % static_cast<S>(b));
+    }
+}
+
+template<VecCmpOp OP, typename U>
+inline bool scalarCmp(U a, U b) {
+    using S = typename std::make_signed<U>::type;
+    switch (OP) {
+        case VecCmpOp::Eq:
+            return a == b;
+        case VecCmpOp::Ne:
+            return a != b;
+        case VecCmpOp::LtU:
+            return a < b;
+        case VecCmpOp::Lt:
+            return static_cast<S>(a) < static_cast<S>(b);
+        case VecCmpOp::LeU:
+            return a <= b;
+        case VecCmpOp::Le:
+            return static_cast<S>(a) <= static_cast<S>(b);
+        case VecCmpOp::GtU:
+            return a > b;
+        default:
+            return static_cast<S>(a) > static_cast<S>(b);
+    }
+}
+
+constexpr VecBinOp redToBin(VecRedOp op) {
+    switch (op) {
+        case VecRedOp::Sum:
+            return VecBinOp::Add;
+        case VecRedOp::And:
+            return VecBinOp::And;
+        case VecRedOp::Or:
+            return VecBinOp::Or;
+        case VecRedOp::Xor:
+            return VecBinOp::Xor;
+        case VecRedOp::MinU:
+            return VecBinOp::MinU;
+        case VecRedOp::Min:
+            return VecBinOp::Min;
+        case VecRedOp::MaxU:
+            return VecBinOp::MaxU;
+        default:
+            return VecBinOp::Max;
+    }
+}
+
+template<VecBinOp OP, typename U>
+void scalarBin(void *d, const void *a, const void *b, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        st<U>(d, i, scalarOp<OP, U>(ld<U>(a, i), ld<U>(b, i)));
+    }
+}
+
+template<VecCmpOp OP, typename U>
+void scalarCmpFn(std::uint8_t *mask, const void *a, const void *b, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        setMaskBit(mask, i, scalarCmp<OP, U>(ld<U>(a, i), ld<U>(b, i)));
+    }
+}
+
+template<VecRedOp OP, typename U>
+std::uint64_t scalarRed(const void *a, std::size_t n, std::uint64_t init) {
+    auto acc = static_cast<U>(init);
+    for (std::size_t i = 0; i < n; i++) {
+        acc = scalarOp<redToBin(OP), U>(acc, ld<U>(a, i));
+    }
+    return acc;
+}
+
+/* --- SIMD bodies ------------------------------------------------------------ */
+
+template<VecBinOp OP, typename U>
+struct Avx2Op {
+    static constexpr bool available = false;
+};
+
+template<VecBinOp OP, typename U>
+struct Sse2Op {
+    static constexpr bool available = false;
+};
+
+#if RVV_HOST_X86
+
+#define RVV_AVX2_OP(OP, U, EXPR)                                              \
+    template<>                                                                \
+    struct Avx2Op<VecBinOp::OP, U> {                                          \
+        static constexpr bool available = true;                               \
+        RVV_TARGET_AVX2 static inline __m256i apply(__m256i a, __m256i b) {   \
+            return EXPR;                                                      \
+        }                                                                     \
+    };
+
+#define RVV_SSE2_OP(OP, U, EXPR)                                              \
+    template<>                                                                \
+    struct Sse2Op<VecBinOp::OP, U> {                                          \
+        static constexpr bool available = true;                               \
+        static inline __m128i apply(__m128i a, __m128i b) {                   \
+            return EXPR;                                                      \
+        }                                                                     \
+    };
+
+#define RVV_BITWISE_OPS(U)                                                    \
+    RVV_AVX2_OP(And, U, _mm256_and_si256(a, b))                               \
+    RVV_AVX2_OP(Or, U, _mm256_or_si256(a, b))                                 \
+    RVV_AVX2_OP(Xor, U, _mm256_xor_si256(a, b))                               \
+    RVV_SSE2_OP(And, U, _mm_and_si128(a, b))                                  \
+    RVV_SSE2_OP(Or, U, _mm_or_si128(a, b))                                    \
+    RVV_SSE2_OP(Xor, U, _mm_xor_si128(a, b))
+
+#define RVV_ADDSUB_OPS(U, W)                                                  \
+    RVV_AVX2_OP(Add, U, _mm256_add_epi##W(a, b))                              \
+    RVV_AVX2_OP(Sub, U, _mm256_sub_epi##W(a, b))                              \
+    RVV_AVX2_OP(RSub, U, _mm256_sub_epi##W(b, a))                             \
+    RVV_SSE2_OP(Add, U, _mm_add_epi##W(a, b))                                 \
+    RVV_SSE2_OP(Sub, U, _mm_sub_epi##W(a, b))                                 \
+    RVV_SSE2_OP(RSub, U, _mm_sub_epi##W(b, a))
+
+#define RVV_MINMAX_AVX2(U, W)                                                 \
+    RVV_AVX2_OP(MinU, U, _mm256_min_epu##W(a, b))                             \
+    RVV_AVX2_OP(Min, U, _mm256_min_epi##W(a, b))                              \
+    RVV_AVX2_OP(MaxU, U, _mm256_max_epu##W(a, b))                             \
+    RVV_AVX2_OP(Max, U, _mm256_max_epi##W(a, b))
+
+RVV_BITWISE_OPS(std::uint8_t)
+RVV_BITWISE_OPS(std::uint16_t)
+RVV_BITWISE_OPS(std::uint32_t)
+RVV_BITWISE_OPS(std::uint64_t)
+
+RVV_ADDSUB_OPS(std::uint8_t, 8)
+RVV_ADDSUB_OPS(std::uint16_t, 16)
+RVV_ADDSUB_OPS(std::uint32_t, 32)
+RVV_ADDSUB_OPS(std::uint64_t, 64)
+
+RVV_MINMAX_AVX2(std::uint8_t, 8)
+RVV_MINMAX_AVX2(std::uint16_t, 16)
+RVV_MINMAX_AVX2(std::uint32_t, 32)
+
+RVV_AVX2_OP(Mul, std::uint16_t, _mm256_mullo_epi16(a, b))
+RVV_AVX2_OP(Mul, std::uint32_t, _mm256_mullo_epi32(a, b))
+RVV_AVX2_OP(MulH, std::uint16_t, _mm256_mulhi_epi16(a, b))
+RVV_AVX2_OP(MulHU, std::uint16_t, _mm256_mulhi_epu16(a, b))
+
+RVV_AVX2_OP(Sll, std::uint32_t, _mm256_sllv_epi32(a, _mm256_and_si256(b, _mm256_set1_epi32(31))))
+RVV_AVX2_OP(Srl, std::uint32_t, _mm256_srlv_epi32(a, _mm256_and_si256(b, _mm256_set1_epi32(31))))
+RVV_AVX2_OP(Sra, std::uint32_t, _mm256_srav_epi32(a, _mm256_and_si256(b, _mm256_set1_epi32(31))))
+RVV_AVX2_OP(Sll, std::uint64_t, _mm256_sllv_epi64(a, _mm256_and_si256(b, _mm256_set1_epi64x(63))))
+RVV_AVX2_OP(Srl, std::uint64_t, _mm256_srlv_epi64(a, _mm256_and_si256(b, _mm256_set1_epi64x(63))))
+
+/* SSE2 only has the unsigned byte and signed halfword forms */
+RVV_SSE2_OP(MinU, std::uint8_t, _mm_min_epu8(a, b))
+RVV_SSE2_OP(MaxU, std::uint8_t, _mm_max_epu8(a, b))
+RVV_SSE2_OP(Min, std::uint16_t, _mm_min_epi16(a, b))
+RVV_SSE2_OP(Max, std::uint16_t, _mm_max_epi16(a, b))
+RVV_SSE2_OP(Mul, std::uint16_t, _mm_mullo_epi16(a, b))
+RVV_SSE2_OP(MulH, std::uint16_t, _mm_mulhi_epi16(a, b))
+RVV_SSE2_OP(MulHU, std::uint16_t, _mm_mulhi_epu16(a, b))
+
+#undef RVV_MINMAX_AVX2
+#undef RVV_ADDSUB_OPS
+#undef RVV_BITWISE_OPS
+#undef RVV_SSE2_OP
+#undef RVV_AVX2_OP
+
+template<VecBinOp OP, typename U>
+RVV_TARGET_AVX2 void avx2Bin(void *d, const void *a, const void *b, std::size_t n) {
+    auto *pd = static_cast<std::uint8_t *>(d);
+    auto *pa = static_cast<const std::uint8_t *>(a);
+    auto *pb = static_cast<const std::uint8_t *>(b);
+    std::size_t bytes = n * sizeof(U);
+    std::size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pa + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pb + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pd + i), Avx2Op<OP, U>::apply(va, vb));
+    }
+    for (std::size_t e = i / sizeof(U); e < n; e++) {
+        st<U>(d, e, scalarOp<OP, U>(ld<U>(a, e), ld<U>(b, e)));
+    }
+}
+
+template<VecBinOp OP, typename U>
+void sse2Bin(void *d, const void *a, const void *b, std::size_t n) {
+    auto *pd = static_cast<std::uint8_t *>(d);
+    auto *pa = static_cast<const std::uint8_t *>(a);
+    auto *pb = static_cast<const std::uint8_t *>(b);
+    std::size_t bytes = n * sizeof(U);
+    std::size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pa + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pb + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pd + i), Sse2Op<OP, U>::apply(va, vb));
+    }
+    for (std::size_t e = i / sizeof(U); e < n; e++) {
+        st<U>(d, e, scalarOp<OP, U>(ld<U>(a, e), ld<U>(b, e)));
+    }
+}
+
+/* Compares: signed greater-than and equality; unsigned forms bias the sign bit */
+template<typename U>
+RVV_TARGET_AVX2 inline __m256i avx2Eq(__m256i a, __m256i b) {
+    if constexpr (sizeof(U) == 1) {
+        return _mm256_cmpeq_epi8(a, b);
+    } else if constexpr (sizeof(U) == 4) {
+        return _mm256_cmpeq_epi32(a, b);
+    } else {
+        return _mm256_cmpeq_epi64(a, b);
+    }
+}
+
+template<typename U>
+RVV_TARGET_AVX2 inline __m256i avx2Gt(__m256i a, __m256i b) {
+    if constexpr (sizeof(U) == 1) {
+        return _mm256_cmpgt_epi8(a, b);
+    } else if constexpr (sizeof(U) == 4) {
+        return _mm256_cmpgt_epi32(a, b);
+    } else {
+        return _mm256_cmpgt_epi64(a, b);
+    }
+}
+
+template<typename U>
+RVV_TARGET_AVX2 inline __m256i avx2SignBias() {
+    if constexpr (sizeof(U) == 1) {
+        return _mm256_set1_epi8(static_cast<char>(0x80));
+    } else if constexpr (sizeof(U) == 4) {
+        return _mm256_set1_epi32(std::numeric_limits<std::int32_t>::min());
+    } else {
+        return _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::min());
+    }
+}
+
+/** One bit per lane, lane 0 in bit 0 */
+template<typename U>
+RVV_TARGET_AVX2 inline std::uint32_t avx2MoveMask(__m256i m) {
+    if constexpr (sizeof(U) == 1) {
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(m));
+    } else if constexpr (sizeof(U) == 4) {
+        return static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+    } else {
+        return static_cast<std::uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(m)));
+    }
+}
+
+template<VecCmpOp OP, typename U>
+RVV_TARGET_AVX2 void avx2Cmp(std::uint8_t *mask, const void *a, const void *b, std::size_t n) {
+    constexpr bool is_unsigned = OP == VecCmpOp::LtU || OP == VecCmpOp::LeU || OP == VecCmpOp::GtU;
+    constexpr bool invert = OP == VecCmpOp::Ne || OP == VecCmpOp::Le || OP == VecCmpOp::LeU;
+    constexpr std::size_t lanes = 32 / sizeof(U);
+    constexpr std::uint32_t all = lanes == 32 ? 0xFFFFFFFFu : ((1u << lanes) - 1);
+
+    auto *pa = static_cast<const std::uint8_t *>(a);
+    auto *pb = static_cast<const std::uint8_t *>(b);
+    std::size_t e = 0;
+    for (; e + lanes <= n; e += lanes) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pa + e * sizeof(U)));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pb + e * sizeof(U)));
+        if constexpr (is_unsigned) {
+            va = _mm256_xor_si256(va, avx2SignBias<U>());
+            vb = _mm256_xor_si256(vb, avx2SignBias<U>());
+        }
+        __m256i m;
+        if constexpr (OP == VecCmpOp::Eq || OP == VecCmpOp::Ne) {
+            m = avx2Eq<U>(va, vb);
+        } else if constexpr (OP == VecCmpOp::Lt || OP == VecCmpOp::LtU) {
+            m = avx2Gt<U>(vb, va);
+        } else {
+            m = avx2Gt<U>(va, vb);    // Gt, or Le inverted
+        }
+        std::uint32_t bits = avx2MoveMask<U>(m);
+        if (invert) {
+            bits ^= all;
+        }
+        /* lanes is 32, 8 or 4 and e is a multiple of it */
+        if constexpr (lanes >= 8) {
+            std::memcpy(mask + e / 8, &bits, lanes / 8);
+        } else {
+            unsigned int shift = e & 7;
+            mask[e / 8] = static_cast<std::uint8_t>((mask[e / 8] & ~(all << shift)) | (bits << shift));
+        }
+    }
+    for (; e < n; e++) {
+        setMaskBit(mask, e, scalarCmp<OP, U>(ld<U>(a, e), ld<U>(b, e)));
+    }
+}
+
+template<VecRedOp OP, typename U>
+RVV_TARGET_AVX2 std::uint64_t avx2Red(const void *a, std::size_t n, std::uint64_t init) {
+    constexpr VecBinOp bop = redToBin(OP);
+    constexpr std::size_t lanes = 32 / sizeof(U);
+    auto *pa = static_cast<const std::uint8_t *>(a);
+    auto acc = static_cast<U>(init);
+    std::size_t e = 0;
+    if (n >= lanes) {
+        __m256i vacc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pa));
+        for (e = lanes; e + lanes <= n; e += lanes) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pa + e * sizeof(U)));
+            vacc = Avx2Op<bop, U>::apply(vacc, v);
+        }
+        alignas(32) U tmp[lanes];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(tmp), vacc);
+        for (std::size_t l = 0; l < lanes; l++) {
+            acc = scalarOp<bop, U>(acc, tmp[l]);
+        }
+    }
+    for (; e < n; e++) {
+        acc = scalarOp<bop, U>(acc, ld<U>(a, e));
+    }
+    return acc;
+}
+
+template<VecRedOp OP, typename U>
+std::uint64_t sse2Red(const void *a, std::size_t n, std::uint64_t init) {
+    constexpr VecBinOp bop = redToBin(OP);
+    constexpr std::size_t lanes = 16 / sizeof(U);
+    auto *pa = static_cast<const std::uint8_t *>(a);
+    auto acc = static_cast<U>(init);
+    std::size_t e = 0;
+    if (n >= lanes) {
+        __m128i vacc = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pa));
+        for (e = lanes; e + lanes <= n; e += lanes) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pa + e * sizeof(U)));
+            vacc = Sse2Op<bop, U>::apply(vacc, v);
+        }
+        alignas(16) U tmp[lanes];
+        _mm_store_si128(reinterpret_cast<__m128i *>(tmp), vacc);
+        for (std::size_t l = 0; l < lanes; l++) {
+            acc = scalarOp<bop, U>(acc, tmp[l]);
+        }
+    }
+    for (; e < n; e++) {
+        acc = scalarOp<bop, U>(acc, ld<U>(a, e));
+    }
+    return acc;
+}
+
+#endif // RVV_HOST_X86
+
+/* --- Table construction ---------------------------------------------------- */
+
+template<VecBinOp OP, typename U>
+VectorKernels::BinFn pickBin(HostIsa isa) {
+#if RVV_HOST_X86
+    if constexpr (Avx2Op<OP, U>::available) {
+        if (isa == HostIsa::AVX2) {
+            return &avx2Bin<OP, U>;
+        }
+    }
+    if constexpr (Sse2Op<OP, U>::available) {
+        if (isa != HostIsa::Scalar) {
+            return &sse2Bin<OP, U>;
+        }
+    }
+#endif
+    (void) isa;
+    return &scalarBin<OP, U>;
+}
+
+template<VecCmpOp OP, typename U>
+VectorKernels::CmpFn pickCmp(HostIsa isa) {
+#if RVV_HOST_X86
+    if constexpr (sizeof(U) != 2) {
+        if (isa == HostIsa::AVX2) {
+            return &avx2Cmp<OP, U>;
+        }
+    }
+#endif
+    (void) isa;
+    return &scalarCmpFn<OP, U>;
+}
+
+template<VecRedOp OP, typename U>
+VectorKernels::RedFn pickRed(HostIsa isa) {
+#if RVV_HOST_X86
+    if constexpr (Avx2Op<redToBin(OP), U>::available) {
+        if (isa == HostIsa::AVX2) {
+            return &avx2Red<OP, U>;
+        }
+    }
+    if constexpr (Sse2Op<redToBin(OP), U>::available) {
+        if (isa != HostIsa::Scalar) {
+            return &sse2Red<OP, U>;
+        }
+    }
+#endif
+    (void) isa;
+    return &scalarRed<OP, U>;
+}
+
+template<typename U, unsigned int... I>
+void fillBin(VectorKernels::BinFn (*tbl)[4], HostIsa isa, std::integer_sequence<unsigned int, I...>) {
+    unsigned int s = VectorKernels::sewIndex(sizeof(U) * 8);
+    ((tbl[I][s] = pickBin<static_cast<VecBinOp>(I), U>(isa)), ...);
+}
+
+template<typename U, unsigned int... I>
+void fillCmp(VectorKernels::CmpFn (*tbl)[4], HostIsa isa, std::integer_sequence<unsigned int, I...>) {
+    unsigned int s = VectorKernels::sewIndex(sizeof(U) * 8);
+    ((tbl[I][s] = pickCmp<static_cast<VecCmpOp>(I), U>(isa)), ...);
+}
+
+template<typename U, unsigned int... I>
+void fillRed(VectorKernels::RedFn (*tbl)[4], HostIsa isa, std::integer_sequence<unsigned int, I...>) {
+    unsigned int s = VectorKernels::sewIndex(sizeof(U) * 8);
+    ((tbl[I][s] = pickRed<static_cast<VecRedOp>(I), U>(isa)), ...);
+}
+
+HostIsa detectHostIsa() {
+#if RVV_HOST_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    if (osxsave && avx2 && (_xgetbv(0) & 0x6) == 0x6) {
+        return HostIsa::AVX2;
+    }
+    return HostIsa::SSE2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return HostIsa::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return HostIsa::SSE2;
+    }
+    return HostIsa::Scalar;
+#endif
+#else
+    return HostIsa::Scalar;
+#endif
+}
+
+} // namespace
+
+VectorKernels::VectorKernels(HostIsa isa) : host_isa(isa) {
+    constexpr auto nbin = std::make_integer_sequence<unsigned int, static_cast<unsigned int>(VecBinOp::Count)>();
+    constexpr auto ncmp = std::make_integer_sequence<unsigned int, static_cast<unsigned int>(VecCmpOp::Count)>();
+    constexpr auto nred = std::make_integer_sequence<unsigned int, static_cast<unsigned int>(VecRedOp::Count)>();
+
+    fillBin<std::uint8_t>(bin, isa, nbin);
+    fillBin<std::uint16_t>(bin, isa, nbin);
+    fillBin<std::uint32_t>(bin, isa, nbin);
+    fillBin<std::uint64_t>(bin, isa, nbin);
+    fillCmp<std::uint8_t>(cmp, isa, ncmp);
+    fillCmp<std::uint16_t>(cmp, isa, ncmp);
+    fillCmp<std::uint32_t>(cmp, isa, ncmp);
+    fillCmp<std::uint64_t>(cmp, isa, ncmp);
+    fillRed<std::uint8_t>(red, isa, nred);
+    fillRed<std::uint16_t>(red, isa, nred);
+    fillRed<std::uint32_t>(red, isa, nred);
+    fillRed<std::uint64_t>(red, isa, nred);
+}
+
+const VectorKernels &VectorKernels::get(HostIsa isa) {
+    static const HostIsa host = detectHostIsa();
+    if (static_cast<int>(isa) > static_cast<int>(host)) {
+        isa = host;
+    }
+    static const VectorKernels scalar(HostIsa::Scalar);
+    static const VectorKernels sse2(host >= HostIsa::SSE2 ? HostIsa::SSE2 : HostIsa::Scalar);
+    static const VectorKernels avx2(host);
+    switch (isa) {
+        case HostIsa::AVX2:
+            return avx2;
+        case HostIsa::SSE2:
+            return sse2;
+        default:
+            return scalar;
+    }
+}
+
+const VectorKernels &VectorKernels::get() {
+    static const VectorKernels &best = []() -> const VectorKernels & {
+        HostIsa isa = HostIsa::AVX2;
+        if (const char *env = std::getenv("RVVP_VECTOR_ISA")) {
+            std::string s(env);
+            if (s == "scalar") {
+                isa = HostIsa::Scalar;
+            } else if (s == "sse2") {
+                isa = HostIsa::SSE2;
+            }
+        }
+        return get(isa);
+    }();
+    return best;
+}
+
+const char *VectorKernels::isaName(HostIsa isa) {
+    switch (isa) {
+        case HostIsa::AVX2:
+            return "AVX2";
+        case HostIsa::SSE2:
+            return "SSE2";
+        default:
+            return "scalar";
+    }
+}
+
+void VectorKernels::merge(unsigned int sew, void *dst, const void *src, const std::uint8_t *mask,
+                          std::size_t n) {
+    std::size_t bytes = sew / 8;
+    auto *pd = static_cast<std::uint8_t *>(dst);
+    auto *ps = static_cast<const std::uint8_t *>(src);
+    for (std::size_t i = 0; i < n; i++) {
+        if (getMaskBit(mask, i)) {
+            std::memcpy(pd + i * bytes, ps + i * bytes, bytes);
+        }
+    }
+}
+
+void VectorKernels::splat(unsigned int sew, void *dst, std::uint64_t value, std::size_t n) {
+    switch (sew) {
+        case 8:
+            std::memset(dst, static_cast<int>(value & 0xFF), n);
+            break;
+        case 16:
+            for (std::size_t i = 0; i < n; i++) {
+                st<std::uint16_t>(dst, i, static_cast<std::uint16_t>(value));
+            }
+            break;
+        case 32:
+            for (std::size_t i = 0; i < n; i++) {
+                st<std::uint32_t>(dst, i, static_cast<std::uint32_t>(value));
+            }
+            break;
+        default:
+            for (std::size_t i = 0; i < n; i++) {
+                st<std::uint64_t>(dst, i, value);
+            }
+            break;
+    }
+}
+
+} // namespace riscv_tlm
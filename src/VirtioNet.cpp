@@ -0,0 +1,383 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file VirtioNet.cpp
+ * @brief virtio-mmio network device
+ */
+
+#include "VirtioNet.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace riscv_tlm::peripherals {
+
+    namespace {
+        constexpr std::uint32_t VIRTIO_MAGIC = 0x74726976;     // "virt"
+        constexpr std::uint32_t VIRTIO_VENDOR = 0x50565652;    // "RVVP"
+        constexpr std::uint32_t VIRTIO_ID_NET = 1;
+
+        constexpr std::uint64_t VIRTIO_NET_F_MAC = 1ULL << 5;
+        constexpr std::uint64_t VIRTIO_NET_F_STATUS = 1ULL << 16;
+        constexpr std::uint64_t VIRTIO_F_VERSION_1 = 1ULL << 32;
+        constexpr std::uint64_t DEVICE_FEATURES = VIRTIO_NET_F_MAC | VIRTIO_NET_F_STATUS | VIRTIO_F_VERSION_1;
+
+        constexpr std::uint32_t STATUS_FEATURES_OK = 8;
+        constexpr std::uint32_t STATUS_DRIVER_OK = 4;
+        constexpr std::uint16_t VIRTIO_NET_S_LINK_UP = 1;
+
+        constexpr std::uint16_t VIRTQ_DESC_F_NEXT = 1;
+        constexpr std::uint16_t VIRTQ_DESC_F_WRITE = 2;
+        constexpr std::uint16_t VIRTQ_AVAIL_F_NO_INTERRUPT = 1;
+
+        constexpr std::uint32_t INTERRUPT_USED_BUFFER = 1;
+
+        constexpr unsigned int RX = 0;
+        constexpr unsigned int TX = 1;
+
+        void setLow(std::uint64_t &reg, std::uint32_t value) {
+            reg = (reg & 0xffffffff00000000ULL) | value;
+        }
+
+        void setHigh(std::uint64_t &reg, std::uint32_t value) {
+            reg = (reg & 0xffffffffULL) | (static_cast<std::uint64_t>(value) << 32);
+        }
+    }
+
+    VirtioNet::VirtioNet(sc_core::sc_module_name const &name, NetLink *link)
+            : sc_module(name), socket("socket"), mem_master("mem_master"), m_link(link) {
+        socket.register_b_transport(this, &VirtioNet::b_transport);
+
+        if (m_link != nullptr) {
+            std::memcpy(m_config.data(), m_link->mac(), 6);
+            m_config[6] = VIRTIO_NET_S_LINK_UP & 0xff;
+            m_config[7] = VIRTIO_NET_S_LINK_UP >> 8;
+            m_link->onReceive([this](const std::uint8_t *frame, std::size_t length) {
+                receive(frame, length);
+            });
+
+            SC_THREAD(rx_thread);
+            SC_THREAD(tx_thread);
+        }
+    }
+
+    void VirtioNet::b_transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+        (void) delay;
+        const std::uint64_t addr = trans.get_address();
+        unsigned char *ptr = trans.get_data_ptr();
+        const unsigned int len = trans.get_data_length();
+
+        /* the configuration space takes any access inside it, the registers only words */
+        if (addr >= CONFIG && addr + len <= CONFIG + CONFIG_SIZE) {
+            if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+                std::memcpy(ptr, &m_config[addr - CONFIG], len);
+            }
+            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            return;
+        }
+        if (len != 4 || (addr & 3) != 0) {
+            trans.set_response_status(tlm::TLM_BURST_ERROR_RESPONSE);
+            return;
+        }
+
+        std::uint32_t value = 0;
+        if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+            std::memcpy(&value, ptr, 4);
+            writeRegister(addr, value);
+        } else if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+            value = readRegister(addr);
+            std::memcpy(ptr, &value, 4);
+        }
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+
+    std::uint32_t VirtioNet::readRegister(std::uint64_t addr) const {
+        const Queue *q = m_queue_sel < m_queues.size() ? &m_queues[m_queue_sel] : nullptr;
+        switch (addr) {
+            case MAGIC_VALUE:
+                return VIRTIO_MAGIC;
+            case VERSION:
+                return 2;
+            case DEVICE_ID:
+                return m_link != nullptr ? VIRTIO_ID_NET : 0;
+            case VENDOR_ID:
+                return VIRTIO_VENDOR;
+            case DEVICE_FEATURES:
+                return m_device_features_sel < 2
+                       ? static_cast<std::uint32_t>(DEVICE_FEATURES >> (32 * m_device_features_sel)) : 0;
+            case QUEUE_NUM_MAX:
+                return q != nullptr ? QUEUE_SIZE : 0;
+            case QUEUE_READY:
+                return q != nullptr ? q->ready : 0;
+            case INTERRUPT_STATUS:
+                return m_isr;
+            case STATUS:
+                return m_status;
+            case CONFIG_GENERATION:
+                return 0;
+            default:
+                return 0;
+        }
+    }
+
+    void VirtioNet::writeRegister(std::uint64_t addr, std::uint32_t value) {
+        Queue *q = m_queue_sel < m_queues.size() ? &m_queues[m_queue_sel] : nullptr;
+        switch (addr) {
+            case DEVICE_FEATURES_SEL:
+                m_device_features_sel = value;
+                break;
+            case DRIVER_FEATURES:
+                if (m_driver_features_sel == 0) {
+                    setLow(m_driver_features, value);
+                } else if (m_driver_features_sel == 1) {
+                    setHigh(m_driver_features, value);
+                }
+                m_driver_features &= DEVICE_FEATURES;
+                break;
+            case DRIVER_FEATURES_SEL:
+                m_driver_features_sel = value;
+                break;
+            case QUEUE_SEL:
+                m_queue_sel = value;
+                break;
+            case QUEUE_NUM:
+                if (q != nullptr && value > 0 && value <= QUEUE_SIZE && (value & (value - 1)) == 0) {
+                    q->num = value;
+                }
+                break;
+            case QUEUE_READY:
+                if (q != nullptr) {
+                    q->ready = value & 1;
+                }
+                break;
+            case QUEUE_NOTIFY:
+                if (value == RX) {
+                    m_rx_event.notify(sc_core::SC_ZERO_TIME);
+                } else if (value == TX) {
+                    m_tx_event.notify(sc_core::SC_ZERO_TIME);
+                }
+                break;
+            case INTERRUPT_ACK:
+                m_isr &= ~value;
+                updateLine();
+                break;
+            case STATUS:
+                if (value == 0) {
+                    reset();
+                    break;
+                }
+                /* the device only works with the virtio 1.x layout */
+                if ((value & STATUS_FEATURES_OK) != 0 && (m_driver_features & VIRTIO_F_VERSION_1) == 0) {
+                    value &= ~STATUS_FEATURES_OK;
+                }
+                m_status = value;
+                if (driverOk()) {
+                    m_rx_event.notify(sc_core::SC_ZERO_TIME);
+                    m_tx_event.notify(sc_core::SC_ZERO_TIME);
+                }
+                break;
+            case QUEUE_DESC_LOW:
+                if (q != nullptr) setLow(q->desc, value);
+                break;
+            case QUEUE_DESC_HIGH:
+                if (q != nullptr) setHigh(q->desc, value);
+                break;
+            case QUEUE_DRIVER_LOW:
+                if (q != nullptr) setLow(q->driver, value);
+                break;
+            case QUEUE_DRIVER_HIGH:
+                if (q != nullptr) setHigh(q->driver, value);
+                break;
+            case QUEUE_DEVICE_LOW:
+                if (q != nullptr) setLow(q->device, value);
+                break;
+            case QUEUE_DEVICE_HIGH:
+                if (q != nullptr) setHigh(q->device, value);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void VirtioNet::reset() {
+        m_device_features_sel = 0;
+        m_driver_features_sel = 0;
+        m_driver_features = 0;
+        m_queue_sel = 0;
+        m_status = 0;
+        m_isr = 0;
+        m_queues = {};
+        m_rx_frames.clear();
+        updateLine();
+    }
+
+    bool VirtioNet::driverOk() const {
+        return (m_status & STATUS_DRIVER_OK) != 0;
+    }
+
+    void VirtioNet::receive(const std::uint8_t *frame, std::size_t length) {
+        if (!driverOk() || m_rx_frames.size() >= MAX_PENDING) {
+            m_rx_dropped++;
+            return;
+        }
+        m_rx_frames.emplace_back(frame, frame + length);
+        m_rx_event.notify(sc_core::SC_ZERO_TIME);
+    }
+
+    void VirtioNet::rx_thread() {
+        std::uint8_t header[NET_HDR_SIZE] = {};
+        header[10] = 1;     // num_buffers
+        std::vector<std::uint8_t> packet;
+
+        while (true) {
+            wait(m_rx_event);
+            Queue &q = m_queues[RX];
+            std::uint16_t head = 0;
+            sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+            while (!m_rx_frames.empty() && driverOk() && q.ready != 0 && nextAvail(q, head, delay)) {
+                packet.assign(header, header + NET_HDR_SIZE);
+                packet.insert(packet.end(), m_rx_frames.front().begin(), m_rx_frames.front().end());
+                m_rx_frames.pop_front();
+
+                /* scatter over the device-writable descriptors of the chain */
+                std::size_t written = 0;
+                std::uint16_t index = head;
+                for (std::uint32_t n = 0; n < q.num && written < packet.size(); n++) {
+                    const Descriptor d = readDescriptor(q, index, delay);
+                    if ((d.flags & VIRTQ_DESC_F_WRITE) != 0) {
+                        const std::size_t chunk = std::min<std::size_t>(d.len, packet.size() - written);
+                        dma(tlm::TLM_WRITE_COMMAND, d.addr, packet.data() + written, chunk, delay);
+                        written += chunk;
+                    }
+                    if ((d.flags & VIRTQ_DESC_F_NEXT) == 0) {
+                        break;
+                    }
+                    index = d.next;
+                }
+                wait(delay);
+                delay = sc_core::SC_ZERO_TIME;
+                if (!driverOk() || q.ready == 0) {
+                    break;      // reset meanwhile
+                }
+                putUsed(q, head, static_cast<std::uint32_t>(written), delay);
+                wait(delay);
+                delay = sc_core::SC_ZERO_TIME;
+            }
+        }
+    }
+
+    void VirtioNet::tx_thread() {
+        std::vector<std::uint8_t> packet;
+        packet.reserve(NET_HDR_SIZE + NET_FRAME_MAX);
+
+        while (true) {
+            wait(m_tx_event);
+            Queue &q = m_queues[TX];
+            std::uint16_t head = 0;
+            sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+            while (driverOk() && q.ready != 0 && nextAvail(q, head, delay)) {
+                /* gather the device-readable descriptors of the chain */
+                packet.clear();
+                std::uint16_t index = head;
+                for (std::uint32_t n = 0; n < q.num; n++) {
+                    const Descriptor d = readDescriptor(q, index, delay);
+                    if ((d.flags & VIRTQ_DESC_F_WRITE) == 0) {
+                        const std::size_t used = packet.size();
+                        const std::size_t chunk = std::min<std::size_t>(d.len, packet.capacity() - used);
+                        packet.resize(used + chunk);
+                        dma(tlm::TLM_READ_COMMAND, d.addr, packet.data() + used, chunk, delay);
+                    }
+                    if ((d.flags & VIRTQ_DESC_F_NEXT) == 0) {
+                        break;
+                    }
+                    index = d.next;
+                }
+                wait(delay);
+                delay = sc_core::SC_ZERO_TIME;
+
+                /* the buffer goes back once the frame has left */
+                if (packet.size() > NET_HDR_SIZE) {
+                    wait(m_link->send(packet.data() + NET_HDR_SIZE, packet.size() - NET_HDR_SIZE));
+                }
+                if (!driverOk() || q.ready == 0) {
+                    break;      // reset meanwhile
+                }
+                putUsed(q, head, 0, delay);
+                wait(delay);
+                delay = sc_core::SC_ZERO_TIME;
+            }
+        }
+    }
+
+    bool VirtioNet::nextAvail(Queue &q, std::uint16_t &head, sc_core::sc_time &delay) {
+        if (q.num == 0 || load16(q.driver + 2, delay) == q.last_avail) {
+            return false;
+        }
+        head = load16(q.driver + 4 + 2 * (q.last_avail % q.num), delay) % q.num;
+        q.last_avail++;
+        return true;
+    }
+
+    void VirtioNet::putUsed(Queue &q, std::uint16_t head, std::uint32_t len, sc_core::sc_time &delay) {
+        std::uint32_t element[2] = {head, len};
+        dma(tlm::TLM_WRITE_COMMAND, q.device + 4 + 8 * (q.used_idx % q.num),
+            reinterpret_cast<std::uint8_t *>(element), sizeof(element), delay);
+        q.used_idx++;
+        store16(q.device + 2, q.used_idx, delay);
+
+        if ((load16(q.driver, delay) & VIRTQ_AVAIL_F_NO_INTERRUPT) == 0) {
+            m_isr |= INTERRUPT_USED_BUFFER;
+            updateLine();
+        }
+    }
+
+    VirtioNet::Descriptor VirtioNet::readDescriptor(const Queue &q, std::uint16_t index, sc_core::sc_time &delay) {
+        std::uint8_t raw[16];
+        dma(tlm::TLM_READ_COMMAND, q.desc + 16 * (index % q.num), raw, sizeof(raw), delay);
+        Descriptor d{};
+        std::memcpy(&d.addr, raw, 8);
+        std::memcpy(&d.len, raw + 8, 4);
+        std::memcpy(&d.flags, raw + 12, 2);
+        std::memcpy(&d.next, raw + 14, 2);
+        return d;
+    }
+
+    void VirtioNet::updateLine() {
+        const bool level = m_isr != 0;
+        if (level != m_line) {
+            m_line = level;
+            if (m_on_interrupt) {
+                m_on_interrupt(level);
+            }
+        }
+    }
+
+    void VirtioNet::dma(tlm::tlm_command cmd, std::uint64_t addr, std::uint8_t *data, std::size_t len,
+                        sc_core::sc_time &delay) {
+        tlm::tlm_generic_payload trans;
+        while (len > 0) {
+            const unsigned int chunk = static_cast<unsigned int>(std::min<std::uint64_t>(4 - (addr & 3), len));
+            trans.set_command(cmd);
+            trans.set_address(addr);
+            trans.set_data_ptr(data);
+            trans.set_data_length(chunk);
+            trans.set_streaming_width(chunk);
+            trans.set_byte_enable_ptr(nullptr);
+            trans.set_dmi_allowed(false);
+            trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+            mem_master->b_transport(trans, delay);
+            addr += chunk;
+            data += chunk;
+            len -= chunk;
+        }
+    }
+
+    std::uint16_t VirtioNet::load16(std::uint64_t addr, sc_core::sc_time &delay) {
+        std::uint16_t value = 0;
+        dma(tlm::TLM_READ_COMMAND, addr, reinterpret_cast<std::uint8_t *>(&value), 2, delay);
+        return value;
+    }
+
+    void VirtioNet::store16(std::uint64_t addr, std::uint16_t value, sc_core::sc_time &delay) {
+        dma(tlm::TLM_WRITE_COMMAND, addr, reinterpret_cast<std::uint8_t *>(&value), 2, delay);
+    }
+}
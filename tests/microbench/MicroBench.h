@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file MicroBench.h
+ * @brief Minimal micro-benchmark harness (warm-up, repetitions, statistics)
+ *
+ * Header-only, no third-party dependencies. Each benchmark is a callable
+ * that performs a fixed number of operations per repetition; the harness
+ * reports per-operation timing as min / median / mean / stddev.
+ */
+#pragma once
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace microbench {
+
+/**
+ * @brief Keep a value alive so the optimiser cannot discard the work producing it
+ */
+template<typename T>
+inline void doNotOptimize(T const &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T *sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * @brief Harness settings, filled from the command line
+ */
+struct Config {
+    unsigned warmup = 3;        ///< repetitions discarded before measuring
+    unsigned repetitions = 15;  ///< measured repetitions
+    double scale = 1.0;         ///< multiplier for per-benchmark operation counts
+    std::string filter;         ///< run only benchmarks whose name contains this
+};
+
+/**
+ * @brief Statistics of one benchmark, in nanoseconds per operation
+ */
+struct Result {
+    std::string name;
+    std::uint64_t ops = 0;
+    double min_ns = 0;
+    double median_ns = 0;
+    double mean_ns = 0;
+    double stddev_ns = 0;
+};
+
+class Harness {
+public:
+    explicit Harness(Config cfg) : m_cfg(std::move(cfg)) {}
+
+    /**
+     * @brief Number of operations a benchmark should execute per repetition
+     * @param base nominal count at scale 1.0
+     */
+    std::uint64_t ops(std::uint64_t base) const {
+        auto n = static_cast<std::uint64_t>(static_cast<double>(base) * m_cfg.scale);
+        return n == 0 ? 1 : n;
+    }
+
+    /**
+     * @brief Run one benchmark
+     * @param name   benchmark name (used by the filter)
+     * @param n_ops  operations performed by one call of @p body
+     * @param body   work to measure; called warmup + repetitions times
+     */
+    void run(const std::string &name, std::uint64_t n_ops, const std::function<void()> &body) {
+        if (!m_cfg.filter.empty() && name.find(m_cfg.filter) == std::string::npos) {
+            return;
+        }
+
+        for (unsigned i = 0; i < m_cfg.warmup; i++) {
+            body();
+        }
+
+        std::vector<double> samples;
+        samples.reserve(m_cfg.repetitions);
+        for (unsigned i = 0; i < m_cfg.repetitions; i++) {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto stop = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            samples.push_back(ns / static_cast<double>(n_ops));
+        }
+
+        Result r;
+        r.name = name;
+        r.ops = n_ops;
+        if (!samples.empty()) {
+            std::sort(samples.begin(), samples.end());
+            std::size_t n = samples.size();
+            r.min_ns = samples.front();
+            r.median_ns = (n % 2) ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+            double sum = 0;
+            for (double s : samples) sum += s;
+            r.mean_ns = sum / static_cast<double>(n);
+            double var = 0;
+            for (double s : samples) var += (s - r.mean_ns) * (s - r.mean_ns);
+            r.stddev_ns = n > 1 ? std::sqrt(var / static_cast<double>(n - 1)) : 0.0;
+        }
+        m_results.push_back(r);
+        print(r);
+    }
+
+    const std::vector<Result> &results() const { return m_results; }
+
+    static void printHeader() {
+        std::cout << std::left << std::setw(36) << "benchmark"
+                  << std::right << std::setw(12) << "ops/rep"
+                  << std::setw(12) << "min ns"
+                  << std::setw(12) << "median ns"
+                  << std::setw(12) << "mean ns"
+                  << std::setw(12) << "stddev"
+                  << std::setw(14) << "Mops/s" << "\n";
+        std::cout << std::string(110, '-') << "\n";
+    }
+
+private:
+    static void print(const Result &r) {
+        double mops = r.median_ns > 0 ? 1000.0 / r.median_ns : 0.0;
+        std::cout << std::left << std::setw(36) << r.name
+                  << std::right << std::setw(12) << r.ops
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(12) << r.min_ns
+                  << std::setw(12) << r.median_ns
+                  << std::setw(12) << r.mean_ns
+                  << std::setw(12) << r.stddev_ns
+                  << std::setw(14) << mops << "\n" << std::flush;
+    }
+
+    Config m_cfg;
+    std::vector<Result> m_results;
+};
+
+} // namespace microbench
+
+#endif // MICROBENCH_H
@@ -0,0 +1,465 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file micro_bench.cpp
+ * @brief Micro-benchmarks for simulator hot paths
+ *
+ * Measures, in isolation:
+ *  - BASE_ISA::decode and C_extension::decode over an instruction stream
+ *  - BusCtrl::b_transport address routing
+ *  - Memory::b_transport and the DMI path
+ *  - MemoryInterface load/store through the bus
+ *  - Registers::getCSR / setCSR
+ *  - Intel HEX parsing (Memory::readHexFile)
+ *
+ * The instruction stream is either synthetic or captured from a hex image
+ * given with -f. All benchmarks run inside one SC_THREAD after elaboration
+ * so that socket bindings are resolved.
+ */
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "systemc"
+#include "tlm.h"
+#include "tlm_utils/simple_initiator_socket.h"
+#include "tlm_utils/simple_target_socket.h"
+
+#include "spdlog/spdlog.h"
+#include "spdlog/sinks/null_sink.h"
+
+#include "BASE_ISA.h"
+#include "BusCtrl.h"
+#include "C_extension.h"
+#include "Memory.h"
+#include "MemoryInterface.h"
+#include "Registers.h"
+
+#include "MicroBench.h"
+
+namespace {
+
+/**
+ * @brief Target that accepts any transaction; isolates bus routing cost
+ */
+class NullTarget : sc_core::sc_module {
+public:
+    tlm_utils::simple_target_socket<NullTarget> socket;
+
+    explicit NullTarget(sc_core::sc_module_name const &name) :
+            sc_module(name), socket("socket") {
+        socket.register_b_transport(this, &NullTarget::b_transport);
+    }
+
+    void b_transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+        (void) delay;
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+};
+
+/* Representative RV32I mix: ALU, loads/stores, branches, jumps, CSR, system */
+const std::uint32_t synthetic_rv32[] = {
+        0x00100093, // addi  x1, x0, 1
+        0x002081b3, // add   x3, x1, x2
+        0x00012283, // lw    x5, 0(x2)
+        0x00512223, // sw    x5, 4(x2)
+        0x00208463, // beq   x1, x2, 8
+        0x010000ef, // jal   x1, 16
+        0x123452b7, // lui   x5, 0x12345
+        0x00000297, // auipc x5, 0
+        0x402081b3, // sub   x3, x1, x2
+        0x00209093, // slli  x1, x1, 2
+        0x300022f3, // csrrs x5, mstatus, x0
+        0x4030d093, // srai  x1, x1, 3
+        0x0020e1b3, // or    x3, x1, x2
+        0x0ff0f093, // andi  x1, x1, 255
+        0x00008067, // jalr  x0, 0(x1)
+        0x00014283, // lbu   x5, 0(x2)
+        0x0020b1b3, // sltu  x3, x1, x2
+        0x00000073, // ecall
+};
+
+/* Representative RVC mix */
+const std::uint16_t synthetic_rvc[] = {
+        0x0405, // c.addi   s0, 1
+        0x4501, // c.li     a0, 0
+        0x852e, // c.mv     a0, a1
+        0x4188, // c.lw     a0, 0(a1)
+        0xc188, // c.sw     a0, 0(a1)
+        0xa001, // c.j      0
+        0xc101, // c.beqz   a0, 0
+        0x8082, // c.jr     ra
+        0x7139, // c.addi16sp
+        0x4512, // c.lwsp   a0, 4(sp)
+        0xc02a, // c.swsp   a0, 0(sp)
+        0x952e, // c.add    a0, a1
+        0x0506, // c.slli   a0, 1
+        0x0001, // c.nop
+};
+
+struct Options {
+    microbench::Config cfg;
+    std::string hex_file;
+};
+
+/**
+ * @brief Write a synthetic Intel HEX image of @p records 16-byte data records
+ */
+std::string writeSyntheticHex(unsigned records) {
+    auto path = (std::filesystem::temp_directory_path() / "riscv_vp_microbench.hex").string();
+    std::ofstream out(path);
+    char line[64];
+
+    for (unsigned r = 0; r < records; r++) {
+        std::uint32_t address = r * 16;
+        std::uint8_t checksum = 0x10 + ((address >> 8) & 0xFF) + (address & 0xFF);
+        std::snprintf(line, sizeof(line), ":10%04X00", address & 0xFFFF);
+        out << line;
+        for (unsigned i = 0; i < 16; i++) {
+            std::uint8_t byte = static_cast<std::uint8_t>((r * 16 + i) * 31);
+            checksum += byte;
+            std::snprintf(line, sizeof(line), "%02X", byte);
+            out << line;
+        }
+        std::snprintf(line, sizeof(line), "%02X\n", static_cast<std::uint8_t>(-checksum) & 0xFF);
+        out << line;
+    }
+    out << ":00000001FF\n";
+    return path;
+}
+
+class MicroBenchTop : sc_core::sc_module {
+public:
+    tlm_utils::simple_initiator_socket<MicroBenchTop> instr_init;
+    tlm_utils::simple_initiator_socket<MicroBenchTop> dma_init;
+    tlm_utils::simple_initiator_socket<MicroBenchTop> net_init;     // virtio-net DMA master, unused
+
+    SC_HAS_PROCESS(MicroBenchTop);
+
+    MicroBenchTop(sc_core::sc_module_name const &name, Options opts) :
+            sc_module(name), instr_init("instr_init"), dma_init("dma_init"), net_init("net_init"),
+            m_opts(std::move(opts)) {
+
+        if (m_opts.hex_file.empty()) {
+            mem = new riscv_tlm::Memory("Main_Memory");
+        } else {
+            mem = new riscv_tlm::Memory("Main_Memory", m_opts.hex_file);
+        }
+        bus = new riscv_tlm::BusCtrl("BusCtrl");
+        mem_if = new riscv_tlm::MemoryInterface();
+
+        for (auto const *n : {"trace", "timer", "uart", "clint", "plic", "dma", "syscall", "clic", "dvfs", "net"}) {
+            sinks.push_back(new NullTarget(n));
+        }
+
+        instr_init.bind(bus->cpu_instr_socket);
+        dma_init.bind(bus->dma_master_socket);
+        net_init.bind(bus->net_master_socket);
+        mem_if->data_bus.bind(bus->cpu_data_socket);
+        bus->memory_socket.bind(mem->socket);
+        bus->trace_socket.bind(sinks[0]->socket);
+        bus->timer_socket.bind(sinks[1]->socket);
+        bus->uart_socket.bind(sinks[2]->socket);
+        bus->clint_socket.bind(sinks[3]->socket);
+        bus->plic_socket.bind(sinks[4]->socket);
+        bus->dma_socket.bind(sinks[5]->socket);
+        bus->syscall_socket.bind(sinks[6]->socket);
+        bus->clic_socket.bind(sinks[7]->socket);
+        bus->dvfs_socket.bind(sinks[8]->socket);
+        bus->net_socket.bind(sinks[9]->socket);
+
+        SC_THREAD(run);
+    }
+
+    ~MicroBenchTop() override {
+        for (auto *s : sinks) delete s;
+        delete mem_if;
+        delete bus;
+        delete mem;
+    }
+
+private:
+    void run() {
+        microbench::Harness h(m_opts.cfg);
+        microbench::Harness::printHeader();
+
+        captureStreams();
+        benchDecode(h);
+        /* Parsing an image also enables DMI on a memory created without one */
+        benchHex(h);
+        benchMemory(h);
+        benchBus(h);
+        benchMemoryInterface(h);
+        benchCSR(h);
+
+        sc_core::sc_stop();
+    }
+
+    /**
+     * @brief Build decode streams, from the loaded image if there is one
+     */
+    void captureStreams() {
+        if (!m_opts.hex_file.empty()) {
+            std::vector<std::uint8_t> image(64 * 1024);
+            tlm::tlm_generic_payload trans;
+            trans.set_command(tlm::TLM_READ_COMMAND);
+            trans.set_address(mem->getPCfromHEX());
+            trans.set_data_ptr(image.data());
+            trans.set_data_length(static_cast<unsigned>(image.size()));
+            unsigned n = mem->transport_dbg(trans);
+
+            for (unsigned off = 0; off + 2 <= n;) {
+                std::uint16_t half;
+                std::memcpy(&half, &image[off], 2);
+                if ((half & 0x3) == 0x3 && off + 4 <= n) {
+                    std::uint32_t word;
+                    std::memcpy(&word, &image[off], 4);
+                    if (word != 0) rv32_stream.push_back(word);
+                    off += 4;
+                } else {
+                    if (half != 0) rvc_stream.push_back(half);
+                    off += 2;
+                }
+            }
+            std::cout << "Captured " << rv32_stream.size() << " 32-bit and "
+                      << rvc_stream.size() << " compressed instructions from "
+                      << m_opts.hex_file << "\n";
+        }
+        if (rv32_stream.empty()) {
+            rv32_stream.assign(std::begin(synthetic_rv32), std::end(synthetic_rv32));
+        }
+        if (rvc_stream.empty()) {
+            rvc_stream.assign(std::begin(synthetic_rvc), std::end(synthetic_rvc));
+        }
+    }
+
+    void benchDecode(microbench::Harness &h) {
+        riscv_tlm::Registers<std::uint32_t> regs;
+        riscv_tlm::BASE_ISA<std::uint32_t> base(0, &regs, mem_if);
+        riscv_tlm::C_extension<std::uint32_t> c_ext(0, &regs, mem_if);
+
+        std::uint64_t n = h.ops(2000000);
+        h.run("BASE_ISA::decode", n, [&] {
+            std::size_t idx = 0;
+            for (std::uint64_t i = 0; i < n; i++) {
+                base.setInstr(rv32_stream[idx]);
+                microbench::doNotOptimize(base.decode());
+                if (++idx == rv32_stream.size()) idx = 0;
+            }
+        });
+
+        h.run("C_extension::decode", n, [&] {
+            std::size_t idx = 0;
+            for (std::uint64_t i = 0; i < n; i++) {
+                c_ext.setInstr(rvc_stream[idx]);
+                microbench::doNotOptimize(c_ext.decode());
+                if (++idx == rvc_stream.size()) idx = 0;
+            }
+        });
+    }
+
+    void benchMemory(microbench::Harness &h) {
+        std::uint64_t n = h.ops(1000000);
+        std::uint32_t data = 0;
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        tlm::tlm_generic_payload trans;
+        trans.set_data_ptr(reinterpret_cast<unsigned char *>(&data));
+        trans.set_data_length(4);
+        trans.set_streaming_width(4);
+        trans.set_byte_enable_ptr(nullptr);
+
+        h.run("Memory::b_transport read", n, [&] {
+            trans.set_command(tlm::TLM_READ_COMMAND);
+            for (std::uint64_t i = 0; i < n; i++) {
+                trans.set_address((i * 4) & 0xFFFFF);
+                mem->b_transport(trans, delay);
+            }
+            microbench::doNotOptimize(data);
+        });
+
+        h.run("Memory::b_transport write", n, [&] {
+            trans.set_command(tlm::TLM_WRITE_COMMAND);
+            for (std::uint64_t i = 0; i < n; i++) {
+                data = static_cast<std::uint32_t>(i);
+                trans.set_address((i * 4) & 0xFFFFF);
+                mem->b_transport(trans, delay);
+            }
+        });
+
+        tlm::tlm_dmi dmi;
+        if (mem->get_direct_mem_ptr(trans, dmi)) {
+            unsigned char *base = dmi.get_dmi_ptr();
+            h.run("Memory DMI read", n, [&] {
+                std::uint32_t acc = 0;
+                for (std::uint64_t i = 0; i < n; i++) {
+                    std::uint32_t v;
+                    std::memcpy(&v, base + ((i * 4) & 0xFFFFF), 4);
+                    acc += v;
+                }
+                microbench::doNotOptimize(acc);
+            });
+        } else {
+            std::cout << "Memory DMI: not granted (no hex image loaded or DISABLE_DMI set), skipped\n";
+        }
+    }
+
+    void benchBus(microbench::Harness &h) {
+        std::uint64_t n = h.ops(1000000);
+        std::uint32_t data = 0;
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        tlm::tlm_generic_payload trans;
+        trans.set_command(tlm::TLM_READ_COMMAND);
+        trans.set_data_ptr(reinterpret_cast<unsigned char *>(&data));
+        trans.set_data_length(4);
+        trans.set_streaming_width(4);
+        trans.set_byte_enable_ptr(nullptr);
+
+        struct Route {
+            const char *name;
+            std::uint64_t addr;
+        };
+        const Route routes[] = {
+                {"BusCtrl::b_transport -> memory", 0x00001000},
+                {"BusCtrl::b_transport -> uart", UART0_BASE_ADDRESS},
+                {"BusCtrl::b_transport -> clint", CLINT_BASE_ADDRESS + 0xBFF8},
+                {"BusCtrl::b_transport -> plic", PLIC_BASE_ADDRESS + 0x200004},
+                {"BusCtrl::b_transport -> timer", TIMER_MEMORY_ADDRESS_LO},
+        };
+
+        for (auto const &r : routes) {
+            h.run(r.name, n, [&] {
+                for (std::uint64_t i = 0; i < n; i++) {
+                    trans.set_address(r.addr);
+                    trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+                    bus->b_transport(trans, delay);
+                }
+            });
+        }
+    }
+
+    void benchMemoryInterface(microbench::Harness &h) {
+        std::uint64_t n = h.ops(1000000);
+
+        h.run("MemoryInterface::readDataMem", n, [&] {
+            std::uint32_t acc = 0;
+            for (std::uint64_t i = 0; i < n; i++) {
+                acc += mem_if->readDataMem((i * 4) & 0xFFFFF, 4);
+            }
+            microbench::doNotOptimize(acc);
+        });
+
+        h.run("MemoryInterface::writeDataMem", n, [&] {
+            for (std::uint64_t i = 0; i < n; i++) {
+                mem_if->writeDataMem((i * 4) & 0xFFFFF, static_cast<std::uint32_t>(i), 4);
+            }
+        });
+    }
+
+    void benchCSR(microbench::Harness &h) {
+        riscv_tlm::Registers<std::uint32_t> regs;
+        std::uint64_t n = h.ops(2000000);
+        const int csrs[] = {CSR_MSTATUS, CSR_MEPC, CSR_MTVEC, CSR_MSCRATCH, CSR_MCAUSE, CSR_MIE};
+
+        h.run("Registers::setCSR", n, [&] {
+            for (std::uint64_t i = 0; i < n; i++) {
+                regs.setCSR(csrs[i % 6], static_cast<std::uint32_t>(i));
+            }
+        });
+
+        h.run("Registers::getCSR", n, [&] {
+            std::uint32_t acc = 0;
+            for (std::uint64_t i = 0; i < n; i++) {
+                acc += regs.getCSR(csrs[i % 6]);
+            }
+            microbench::doNotOptimize(acc);
+        });
+
+        h.run("Registers::getCSR(mcycle)", n, [&] {
+            std::uint32_t acc = 0;
+            for (std::uint64_t i = 0; i < n; i++) {
+                acc += regs.getCSR(CSR_MCYCLE);
+            }
+            microbench::doNotOptimize(acc);
+        });
+    }
+
+    void benchHex(microbench::Harness &h) {
+        const unsigned records = 4096;
+        std::string path = writeSyntheticHex(records);
+
+        h.run("Memory::readHexFile (64 KiB)", records, [&] {
+            mem->readHexFile(path);
+        });
+        std::remove(path.c_str());
+    }
+
+    Options m_opts;
+    riscv_tlm::Memory *mem{nullptr};
+    riscv_tlm::BusCtrl *bus{nullptr};
+    riscv_tlm::MemoryInterface *mem_if{nullptr};
+    std::vector<NullTarget *> sinks;
+
+    std::vector<std::uint32_t> rv32_stream;
+    std::vector<std::uint16_t> rvc_stream;
+};
+
+void usage(const char *exe) {
+    std::cout << "Usage: " << exe << " [-f <file.hex>] [--warmup N] [--reps N] [--scale X] [--filter NAME]\n"
+              << "\nOptions:\n"
+              << "  -f <file.hex>   Capture decode streams from this image (default: synthetic mix)\n"
+              << "  --warmup N      Unmeasured repetitions per benchmark (default 3)\n"
+              << "  --reps N        Measured repetitions per benchmark (default 15)\n"
+              << "  --scale X       Multiply operation counts (default 1.0)\n"
+              << "  --filter NAME   Run only benchmarks whose name contains NAME\n";
+}
+
+} // namespace
+
+int sc_main(int argc, char *argv[]) {
+    Options opts;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "-f" && i + 1 < argc) {
+            opts.hex_file = argv[++i];
+        } else if (a == "--warmup" && i + 1 < argc) {
+            opts.cfg.warmup = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (a == "--reps" && i + 1 < argc) {
+            opts.cfg.repetitions = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (a == "--scale" && i + 1 < argc) {
+            opts.cfg.scale = std::strtod(argv[++i], nullptr);
+        } else if (a == "--filter" && i + 1 < argc) {
+            opts.cfg.filter = argv[++i];
+        } else if (a == "-h" || a == "--help") {
+            usage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown or incomplete option: " << a << "\n";
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (opts.cfg.repetitions == 0) {
+        opts.cfg.repetitions = 1;
+    }
+
+    /* Silence instruction logging; only the harness should print */
+    auto null_sink = std::make_shared<spdlog::sinks::null_sink_mt>();
+    auto logger = std::make_shared<spdlog::logger>("my_logger", null_sink);
+    logger->set_level(spdlog::level::off);
+    spdlog::register_logger(logger);
+
+    auto *top = new MicroBenchTop("microbench", opts);
+    sc_core::sc_start();
+    delete top;
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file custom_mac.cpp
+ * @brief Example plugin: DSP multiply-accumulate instructions in custom-0
+ *
+ * Usage: RISCV_VP -f prog.hex --plugin ./libcustom_mac.so[,latency]
+ *
+ * Encodings (R-type, opcode custom-0 = 0x0B, funct7 = 0):
+ *   funct3 = 0  mac    rd, rs1, rs2   rd += rs1 * rs2
+ *   funct3 = 1  macld  rd, rs1, rs2   rd += mem32[rs1] * mem32[rs2]
+ *
+ * From assembly: .insn r 0x0B, 0, 0, rd, rs1, rs2
+ */
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "PluginAPI.h"
+
+extern "C" {
+RVVP_PLUGIN_EXPORT int rvvp_plugin_version = RVVP_PLUGIN_VERSION;
+}
+
+namespace {
+
+constexpr std::uint32_t MASK = 0xFE00707F;   // funct7, funct3, opcode
+constexpr std::uint32_t MAC = 0x0000000B;
+constexpr std::uint32_t MACLD = 0x0000100B;
+
+unsigned int rd(std::uint32_t insn) {
+    return (insn >> 7) & 0x1F;
+}
+
+unsigned int rs1(std::uint32_t insn) {
+    return (insn >> 15) & 0x1F;
+}
+
+unsigned int rs2(std::uint32_t insn) {
+    return (insn >> 20) & 0x1F;
+}
+
+int mac(rvvp_custom_ctx *ctx, std::uint32_t insn, void *) {
+    std::uint64_t acc = rvvp_custom_read_reg(ctx, rd(insn));
+    acc += rvvp_custom_read_reg(ctx, rs1(insn)) * rvvp_custom_read_reg(ctx, rs2(insn));
+    rvvp_custom_write_reg(ctx, rd(insn), acc);
+    return 0;
+}
+
+int macld(rvvp_custom_ctx *ctx, std::uint32_t insn, void *) {
+    auto a = static_cast<std::int32_t>(rvvp_custom_load(ctx, rvvp_custom_read_reg(ctx, rs1(insn)), 4));
+    auto b = static_cast<std::int32_t>(rvvp_custom_load(ctx, rvvp_custom_read_reg(ctx, rs2(insn)), 4));
+    std::uint64_t acc = rvvp_custom_read_reg(ctx, rd(insn));
+    acc += static_cast<std::uint64_t>(static_cast<std::int64_t>(a) * b);
+    rvvp_custom_write_reg(ctx, rd(insn), acc);
+    return 0;
+}
+
+} // namespace
+
+extern "C" RVVP_PLUGIN_EXPORT int rvvp_plugin_install(rvvp_plugin_id_t, const rvvp_plugin_info_t *,
+                                                      int argc, char **argv) {
+    unsigned int latency = 2;
+    if (argc > 0) {
+        latency = static_cast<unsigned int>(std::strtoul(argv[0], nullptr, 10));
+    }
+
+    /* Pipelined MAC unit: a new operation every cycle */
+    if (rvvp_plugin_register_custom_insn("mac", MASK, MAC, mac, nullptr, latency, 1) < 0) {
+        return 1;
+    }
+    /* Two memory reads share one port: the unit accepts an operation every other cycle */
+    if (rvvp_plugin_register_custom_insn("macld", MASK, MACLD, macld, nullptr, latency + 1, 2) < 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file insn_count.cpp
+ * @brief Example plugin: instruction and memory access counts
+ *
+ * Usage: RISCV_VP -f prog.hex --plugin ./libinsn_count.so[,roi]
+ *
+ * Instructions are counted with per-hart inline adds, so no callback runs
+ * per instruction. With "roi", counting happens only between the guest's
+ * ROI markers (slti x0,x0,1 / slti x0,x0,2).
+ */
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include "PluginAPI.h"
+
+extern "C" {
+RVVP_PLUGIN_EXPORT int rvvp_plugin_version = RVVP_PLUGIN_VERSION;
+}
+
+namespace {
+
+struct HartCounts {
+    std::uint64_t insns;
+    std::uint64_t loads;
+    std::uint64_t stores;
+    std::uint64_t in_roi;
+};
+
+rvvp_plugin_scratch *counts = nullptr;
+bool roi_only = false;
+std::uint64_t traps = 0;
+
+HartCounts *hartCounts(unsigned int hart) {
+    return static_cast<HartCounts *>(rvvp_plugin_scratch_get(counts, hart));
+}
+
+void memAccess(unsigned int hart, std::uint64_t, unsigned int, int is_store, void *) {
+    HartCounts *c = hartCounts(hart);
+    if (roi_only && c->in_roi == 0) {
+        return;
+    }
+    if (is_store) {
+        c->stores++;
+    } else {
+        c->loads++;
+    }
+}
+
+void roiExec(unsigned int hart, void *) {
+    HartCounts *c = hartCounts(hart);
+    if (c->in_roi != 0) {
+        c->insns++;
+    }
+}
+
+void tbTrans(rvvp_plugin_id_t, rvvp_plugin_tb *tb) {
+    std::size_t n = rvvp_plugin_tb_n_insns(tb);
+    for (std::size_t i = 0; i < n; i++) {
+        rvvp_plugin_insn *insn = rvvp_plugin_tb_get_insn(tb, i);
+        if (roi_only) {
+            rvvp_plugin_register_insn_exec_cb(insn, roiExec, nullptr);
+        } else {
+            rvvp_plugin_register_insn_exec_inline_add_per_hart(insn, counts,
+                                                               offsetof(HartCounts, insns), 1);
+        }
+        rvvp_plugin_register_insn_mem_cb(insn, memAccess, nullptr);
+    }
+}
+
+void roi(rvvp_plugin_id_t, unsigned int hart, int begin) {
+    hartCounts(hart)->in_roi = begin ? 1 : 0;
+}
+
+void trap(rvvp_plugin_id_t, unsigned int, std::uint64_t, std::uint64_t, int) {
+    traps++;
+}
+
+void atExit(rvvp_plugin_id_t, void *) {
+    char line[160];
+    for (unsigned int h = 0; h < rvvp_plugin_n_harts(); h++) {
+        const HartCounts *c = hartCounts(h);
+        std::snprintf(line, sizeof(line),
+                      "insn_count: hart %u insns %" PRIu64 " loads %" PRIu64 " stores %" PRIu64 "\n",
+                      h, c->insns, c->loads, c->stores);
+        rvvp_plugin_outs(line);
+    }
+    std::snprintf(line, sizeof(line), "insn_count: traps and interrupts %" PRIu64 "\n", traps);
+    rvvp_plugin_outs(line);
+}
+
+} // namespace
+
+extern "C" RVVP_PLUGIN_EXPORT int rvvp_plugin_install(rvvp_plugin_id_t id, const rvvp_plugin_info_t *,
+                                                      int argc, char **argv) {
+    for (int i = 0; i < argc; i++) {
+        if (std::strcmp(argv[i], "roi") == 0) {
+            roi_only = true;
+        }
+    }
+
+    counts = rvvp_plugin_scratch_new(sizeof(HartCounts));
+    rvvp_plugin_register_tb_trans_cb(id, tbTrans);
+    rvvp_plugin_register_roi_cb(id, roi);
+    rvvp_plugin_register_trap_cb(id, trap);
+    rvvp_plugin_register_atexit_cb(id, atExit, nullptr);
+    return 0;
+}
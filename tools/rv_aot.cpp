@@ -0,0 +1,841 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file rv_aot.cpp
+ * @brief Translate an RV32 ELF program ahead of time for RISCV_TLM --aot
+ *
+ * Finds the basic blocks reachable from the entry point and the code
+ * symbols by following direct jumps and branches, writes each one as a C
+ * function (AotAPI.h), and compiles them with the host compiler into
+ * <dir>/<image hash>.so. Blocks end before any instruction they cannot run:
+ * the simulator interprets it and continues natively at the next block it
+ * finds. Targets of indirect jumps that are not symbols are interpreted up
+ * to the next block.
+ *
+ * The RV32IMC integer instructions are translated; CSR, system, atomic,
+ * floating-point and Zb* instructions are left to the interpreter.
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AotAPI.h"
+#include "AotModule.h"
+#include "ImageHash.h"
+
+#ifndef RVVP_AOT_INCLUDE_DIR
+#define RVVP_AOT_INCLUDE_DIR "."
+#endif
+
+namespace {
+
+    constexpr std::size_t MAX_BLOCK = 64;   ///< instructions, then the block continues in the next one
+
+    struct Section {
+        std::uint32_t addr;
+        std::vector<std::uint8_t> bytes;
+    };
+
+    struct Program {
+        std::uint32_t entry{0};
+        std::vector<Section> code;          ///< executable sections at their run addresses
+        std::set<std::uint32_t> symbols;    ///< code addresses with a symbol
+        riscv_tlm::ImageHash hash;          ///< as the HEX loader computes it
+    };
+
+    std::uint32_t le(const std::vector<std::uint8_t> &f, std::size_t off, unsigned int n) {
+        std::uint32_t v = 0;
+        for (unsigned int i = 0; i < n; i++) {
+            v |= static_cast<std::uint32_t>(f[off + i]) << (8 * i);
+        }
+        return v;
+    }
+
+    bool readElf(const std::string &path, Program &prog, std::string &error) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            error = "cannot open " + path;
+            return false;
+        }
+        std::vector<std::uint8_t> f((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        if (f.size() < 52 || std::memcmp(f.data(), "\x7f" "ELF", 4) != 0 || f[4] != 1 || f[5] != 1) {
+            error = path + " is not a 32-bit little-endian ELF file";
+            return false;
+        }
+        if (le(f, 18, 2) != 243) {
+            error = path + " is not a RISC-V program";
+            return false;
+        }
+
+        prog.entry = le(f, 24, 4);
+        const std::uint32_t phoff = le(f, 28, 4);
+        const std::uint32_t shoff = le(f, 32, 4);
+        const std::uint32_t phentsize = le(f, 42, 2);
+        const std::uint32_t phnum = le(f, 44, 2);
+        const std::uint32_t shentsize = le(f, 46, 2);
+        const std::uint32_t shnum = le(f, 48, 2);
+        if (static_cast<std::uint64_t>(shoff) + static_cast<std::uint64_t>(shnum) * shentsize > f.size() ||
+            static_cast<std::uint64_t>(phoff) + static_cast<std::uint64_t>(phnum) * phentsize > f.size()) {
+            error = path + ": truncated headers";
+            return false;
+        }
+
+        /* load address of a section: objcopy -O ihex writes sections at their LMA */
+        auto loadAddress = [&](std::uint32_t vaddr) {
+            for (std::uint32_t i = 0; i < phnum; i++) {
+                std::size_t ph = phoff + static_cast<std::size_t>(i) * phentsize;
+                if (le(f, ph, 4) != 1) {    // PT_LOAD
+                    continue;
+                }
+                std::uint32_t p_vaddr = le(f, ph + 8, 4);
+                std::uint32_t p_paddr = le(f, ph + 12, 4);
+                std::uint32_t p_memsz = le(f, ph + 20, 4);
+                if (vaddr >= p_vaddr && vaddr - p_vaddr < p_memsz) {
+                    return vaddr - p_vaddr + p_paddr;
+                }
+            }
+            return vaddr;
+        };
+
+        for (std::uint32_t i = 0; i < shnum; i++) {
+            std::size_t sh = shoff + static_cast<std::size_t>(i) * shentsize;
+            const std::uint32_t type = le(f, sh + 4, 4);
+            const std::uint32_t flags = le(f, sh + 8, 4);
+            const std::uint32_t addr = le(f, sh + 12, 4);
+            const std::uint32_t offset = le(f, sh + 16, 4);
+            const std::uint32_t size = le(f, sh + 20, 4);
+            const std::uint32_t link = le(f, sh + 24, 4);
+            const std::uint32_t entsize = le(f, sh + 36, 4);
+
+            if ((flags & 0x2) != 0 && type != 8 && size != 0) {    // SHF_ALLOC, not SHT_NOBITS
+                if (static_cast<std::uint64_t>(offset) + size > f.size()) {
+                    error = path + ": truncated section";
+                    return false;
+                }
+                prog.hash.add(loadAddress(addr), f.data() + offset, size);
+                if ((flags & 0x4) != 0) {   // SHF_EXECINSTR
+                    prog.code.push_back({addr, std::vector<std::uint8_t>(f.begin() + offset,
+                                                                         f.begin() + offset + size)});
+                }
+            }
+
+            if (type == 2 && entsize >= 16 && link < shnum) {     // SHT_SYMTAB
+                std::size_t strsh = shoff + static_cast<std::size_t>(link) * shentsize;
+                const std::uint32_t stroff = le(f, strsh + 16, 4);
+                for (std::uint32_t off = offset; off + 16 <= offset + size && off + 16 <= f.size(); off += entsize) {
+                    const std::uint32_t name = le(f, off, 4);
+                    const std::uint32_t value = le(f, off + 4, 4);
+                    const unsigned int kind = f[off + 12] & 0xf;
+                    const std::uint32_t shndx = le(f, off + 14, 2);
+                    /* functions and plain labels; not $x/$d mapping symbols */
+                    if ((kind == 0 || kind == 2) && shndx != 0 && shndx < 0xff00 && stroff + name < f.size() &&
+                        f[stroff + name] != '\0' && f[stroff + name] != '$') {
+                        prog.symbols.insert(value);
+                    }
+                }
+            }
+        }
+
+        if (prog.code.empty()) {
+            error = path + " has no executable sections";
+            return false;
+        }
+        return true;
+    }
+
+    /* 32-bit encodings, for expanding compressed instructions */
+    std::uint32_t encR(std::uint32_t op, unsigned int rd, unsigned int f3, unsigned int rs1, unsigned int rs2,
+                       std::uint32_t f7) {
+        return (f7 << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op;
+    }
+
+    std::uint32_t encI(std::uint32_t op, unsigned int rd, unsigned int f3, unsigned int rs1, std::uint32_t imm) {
+        return ((imm & 0xfff) << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op;
+    }
+
+    std::uint32_t encS(unsigned int f3, unsigned int rs1, unsigned int rs2, std::uint32_t imm) {
+        return (((imm >> 5) & 0x7f) << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | ((imm & 0x1f) << 7) | 0x23;
+    }
+
+    std::uint32_t encB(unsigned int f3, unsigned int rs1, unsigned int rs2, std::uint32_t imm) {
+        return (((imm >> 12) & 1) << 31) | (((imm >> 5) & 0x3f) << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) |
+               (((imm >> 1) & 0xf) << 8) | (((imm >> 11) & 1) << 7) | 0x63;
+    }
+
+    std::uint32_t encJ(unsigned int rd, std::uint32_t imm) {
+        return (((imm >> 20) & 1) << 31) | (((imm >> 1) & 0x3ff) << 21) | (((imm >> 11) & 1) << 20) |
+               (((imm >> 12) & 0xff) << 12) | (rd << 7) | 0x6f;
+    }
+
+    std::uint32_t sext(std::uint32_t value, unsigned int bits) {
+        const std::uint32_t m = 1u << (bits - 1);
+        return (value ^ m) - m;
+    }
+
+    /**
+     * @brief The RV32C instruction @p c as its 32-bit equivalent, or 0 if it is not translated
+     */
+    std::uint32_t expand(std::uint16_t c) {
+        const unsigned int f3 = c >> 13;
+        const unsigned int rd = (c >> 7) & 0x1f;
+        const unsigned int rs2 = (c >> 2) & 0x1f;
+        const unsigned int rdp = 8 + ((c >> 2) & 7);
+        const unsigned int rs1p = 8 + ((c >> 7) & 7);
+        const std::uint32_t imm6 = sext(((c >> 7) & 0x20) | ((c >> 2) & 0x1f), 6);
+        const std::uint32_t jimm = sext(((c >> 1) & 0x800) | ((c >> 7) & 0x10) | ((c >> 1) & 0x300) |
+                                        ((c << 2) & 0x400) | ((c >> 1) & 0x40) | ((c << 1) & 0x80) |
+                                        ((c >> 2) & 0xe) | ((c << 3) & 0x20), 12);
+        const std::uint32_t bimm = sext(((c >> 4) & 0x100) | ((c >> 7) & 0x18) | ((c << 1) & 0xc0) |
+                                        ((c >> 2) & 0x6) | ((c << 3) & 0x20), 9);
+        const std::uint32_t wimm = ((c >> 7) & 0x38) | ((c >> 4) & 0x4) | ((c << 1) & 0x40);
+
+        switch (c & 3) {
+            case 0:
+                if (f3 == 0) {          /* C.ADDI4SPN */
+                    std::uint32_t imm = ((c >> 7) & 0x30) | ((c >> 1) & 0x3c0) | ((c >> 4) & 0x4) |
+                                        ((c >> 2) & 0x8);
+                    return imm == 0 ? 0 : encI(0x13, rdp, 0, 2, imm);
+                }
+                if (f3 == 2) {          /* C.LW */
+                    return encI(0x03, rdp, 2, rs1p, wimm);
+                }
+                if (f3 == 6) {          /* C.SW */
+                    return encS(2, rs1p, rdp, wimm);
+                }
+                return 0;
+            case 1:
+                switch (f3) {
+                    case 0:             /* C.ADDI, C.NOP */
+                        return encI(0x13, rd, 0, rd, imm6);
+                    case 1:             /* C.JAL */
+                        return encJ(1, jimm);
+                    case 2:             /* C.LI */
+                        return encI(0x13, rd, 0, 0, imm6);
+                    case 3:
+                        if (rd == 2) {  /* C.ADDI16SP */
+                            std::uint32_t imm = sext(((c >> 3) & 0x200) | ((c >> 2) & 0x10) | ((c << 1) & 0x40) |
+                                                     ((c << 4) & 0x180) | ((c << 3) & 0x20), 10);
+                            return imm == 0 ? 0 : encI(0x13, 2, 0, 2, imm);
+                        }
+                        /* C.LUI */
+                        return imm6 == 0 || rd == 0 ? 0 : (imm6 << 12) | (rd << 7) | 0x37;
+                    case 4: {
+                        const unsigned int f2 = (c >> 10) & 3;
+                        if (f2 == 0 || f2 == 1) {   /* C.SRLI, C.SRAI */
+                            return (c & 0x1000) ? 0 : encR(0x13, rs1p, 5, rs1p, rs2, f2 == 1 ? 0x20 : 0);
+                        }
+                        if (f2 == 2) {              /* C.ANDI */
+                            return encI(0x13, rs1p, 7, rs1p, imm6);
+                        }
+                        if (c & 0x1000) {           /* RV64 or Zcb */
+                            return 0;
+                        }
+                        static constexpr unsigned int f3s[4] = {0, 4, 6, 7};
+                        const unsigned int op = (c >> 5) & 3;
+                        return encR(0x33, rs1p, f3s[op], rs1p, rdp, op == 0 ? 0x20 : 0);
+                    }
+                    case 5:             /* C.J */
+                        return encJ(0, jimm);
+                    case 6:             /* C.BEQZ */
+                        return encB(0, rs1p, 0, bimm);
+                    default:            /* C.BNEZ */
+                        return encB(1, rs1p, 0, bimm);
+                }
+            case 2:
+                if (f3 == 0) {          /* C.SLLI */
+                    return (c & 0x1000) ? 0 : encR(0x13, rd, 1, rd, rs2, 0);
+                }
+                if (f3 == 2) {          /* C.LWSP */
+                    std::uint32_t imm = ((c >> 7) & 0x20) | ((c >> 2) & 0x1c) | ((c << 4) & 0xc0);
+                    return rd == 0 ? 0 : encI(0x03, rd, 2, 2, imm);
+                }
+                if (f3 == 4) {
+                    if ((c & 0x1000) == 0) {
+                        if (rs2 == 0) { /* C.JR */
+                            return rd == 0 ? 0 : encI(0x67, 0, 0, rd, 0);
+                        }
+                        return encR(0x33, rd, 0, 0, rs2, 0);       /* C.MV */
+                    }
+                    if (rs2 == 0) {     /* C.EBREAK, C.JALR */
+                        return rd == 0 ? 0 : encI(0x67, 1, 0, rd, 0);
+                    }
+                    return encR(0x33, rd, 0, rd, rs2, 0);          /* C.ADD */
+                }
+                if (f3 == 6) {          /* C.SWSP */
+                    std::uint32_t imm = ((c >> 7) & 0x3c) | ((c >> 1) & 0xc0);
+                    return encS(2, 2, rs2, imm);
+                }
+                return 0;
+            default:
+                return 0;
+        }
+    }
+
+    enum class Kind {
+        Untranslated, Plain, Load, Store, Branch, Jal, Jalr
+    };
+
+    struct Insn {
+        std::uint32_t pc;
+        unsigned int len;
+        std::uint32_t w;        ///< 32-bit form
+        Kind kind;
+    };
+
+    std::uint32_t immI(std::uint32_t w) {
+        return static_cast<std::uint32_t>(static_cast<std::int32_t>(w) >> 20);
+    }
+
+    std::uint32_t immS(std::uint32_t w) {
+        return static_cast<std::uint32_t>((static_cast<std::int32_t>(w) >> 25) << 5) | ((w >> 7) & 0x1f);
+    }
+
+    std::uint32_t immB(std::uint32_t w) {
+        return static_cast<std::uint32_t>((static_cast<std::int32_t>(w) >> 31) << 12) |
+               ((w << 4) & 0x800) | ((w >> 20) & 0x7e0) | ((w >> 7) & 0x1e);
+    }
+
+    std::uint32_t immJ(std::uint32_t w) {
+        return static_cast<std::uint32_t>((static_cast<std::int32_t>(w) >> 31) << 20) |
+               (w & 0xff000) | ((w >> 9) & 0x800) | ((w >> 20) & 0x7fe);
+    }
+
+    Kind classify(std::uint32_t w) {
+        const unsigned int f3 = (w >> 12) & 7;
+        const unsigned int f7 = w >> 25;
+        switch (w & 0x7f) {
+            case 0x37:
+            case 0x17:
+                return Kind::Plain;
+            case 0x6f:
+                return Kind::Jal;
+            case 0x67:
+                return f3 == 0 ? Kind::Jalr : Kind::Untranslated;
+            case 0x63:
+                return f3 == 2 || f3 == 3 ? Kind::Untranslated : Kind::Branch;
+            case 0x03:
+                return f3 == 3 || f3 > 5 ? Kind::Untranslated : Kind::Load;
+            case 0x23:
+                return f3 > 2 ? Kind::Untranslated : Kind::Store;
+            case 0x13:
+                if (f3 == 1) {
+                    return f7 == 0 ? Kind::Plain : Kind::Untranslated;
+                }
+                if (f3 == 5) {
+                    return f7 == 0 || f7 == 0x20 ? Kind::Plain : Kind::Untranslated;
+                }
+                return Kind::Plain;
+            case 0x33:
+                if (f7 == 0 || f7 == 1 || (f7 == 0x20 && (f3 == 0 || f3 == 5))) {
+                    return Kind::Plain;
+                }
+                return Kind::Untranslated;
+            case 0x0f:
+                return f3 == 0 ? Kind::Plain : Kind::Untranslated;     /* FENCE; not FENCE.I */
+            default:
+                return Kind::Untranslated;
+        }
+    }
+
+    struct Block {
+        std::uint32_t start;
+        std::uint32_t end;          ///< past the last translated byte
+        std::vector<Insn> insns;
+        std::uint32_t next;         ///< where it continues if the last instruction falls through
+        std::uint32_t regs_read{0};
+        std::uint32_t regs_written{0};
+    };
+
+    class Translator {
+    public:
+        explicit Translator(const Program &prog) : m_prog(prog) {}
+
+        void discover() {
+            std::vector<std::uint32_t> work(m_prog.symbols.begin(), m_prog.symbols.end());
+            work.push_back(m_prog.entry);
+            while (!work.empty()) {
+                std::uint32_t pc = work.back();
+                work.pop_back();
+                if (m_visited.count(pc) != 0) {
+                    continue;
+                }
+                m_visited.insert(pc);
+                Block b = decode(pc, work);
+                if (!b.insns.empty()) {
+                    m_blocks.emplace(pc, std::move(b));
+                }
+            }
+        }
+
+        std::size_t blocks() const {
+            return m_blocks.size();
+        }
+
+        std::size_t instructions() const {
+            std::size_t n = 0;
+            for (const auto &b : m_blocks) {
+                n += b.second.insns.size();
+            }
+            return n;
+        }
+
+        void emit(std::ostream &out, std::uint64_t hash) const {
+            out << "/* Generated by rv_aot; image " << riscv_tlm::AotModule::fileName(hash) << " */\n";
+            out << "#include <string.h>\n#include \"AotAPI.h\"\n\n";
+            for (const auto &b : m_blocks) {
+                out << "static void " << name(b.first) << "(rvvp_aot_state_t *s);\n";
+            }
+            out << "\n";
+            for (const auto &b : m_blocks) {
+                emitBlock(out, b.second);
+            }
+
+            out << "RVVP_AOT_EXPORT const int rvvp_aot_version = RVVP_AOT_VERSION;\n";
+            out << "RVVP_AOT_EXPORT const uint64_t rvvp_aot_image_hash = " << hex(hash) << "ULL;\n";
+            out << "RVVP_AOT_EXPORT const uint32_t rvvp_aot_block_count = " << m_blocks.size() << ";\n";
+            out << "RVVP_AOT_EXPORT const rvvp_aot_block_t rvvp_aot_blocks[] = {\n";
+            for (const auto &b : m_blocks) {
+                out << "    {" << hex(b.first) << "u, " << name(b.first) << "},\n";
+            }
+            out << "};\n";
+        }
+
+    private:
+        bool fetch(std::uint32_t pc, std::uint32_t &raw, unsigned int &len) const {
+            for (const auto &sec : m_prog.code) {
+                if (pc < sec.addr || pc - sec.addr + 2 > sec.bytes.size()) {
+                    continue;
+                }
+                std::size_t off = pc - sec.addr;
+                raw = static_cast<std::uint32_t>(sec.bytes[off]) | (static_cast<std::uint32_t>(sec.bytes[off + 1]) << 8);
+                if ((raw & 3) != 3) {
+                    len = 2;
+                    return true;
+                }
+                if (off + 4 > sec.bytes.size()) {
+                    return false;
+                }
+                raw |= (static_cast<std::uint32_t>(sec.bytes[off + 2]) << 16) |
+                       (static_cast<std::uint32_t>(sec.bytes[off + 3]) << 24);
+                len = 4;
+                return true;
+            }
+            return false;
+        }
+
+        bool inCode(std::uint32_t pc) const {
+            std::uint32_t raw;
+            unsigned int len;
+            return (pc & 1) == 0 && fetch(pc, raw, len);
+        }
+
+        Block decode(std::uint32_t start, std::vector<std::uint32_t> &work) const {
+            Block b{start, start, {}, start};
+            auto root = [&](std::uint32_t pc) {
+                if (m_visited.count(pc) == 0 && inCode(pc)) {
+                    work.push_back(pc);
+                }
+            };
+
+            std::uint32_t pc = start;
+            while (true) {
+                std::uint32_t raw;
+                unsigned int len;
+                if ((pc & 1) != 0 || !fetch(pc, raw, len)) {
+                    break;
+                }
+                std::uint32_t w = len == 2 ? expand(static_cast<std::uint16_t>(raw)) : raw;
+                Kind kind = w == 0 ? Kind::Untranslated : classify(w);
+                if (kind == Kind::Untranslated) {
+                    /* interpreted; translated code resumes after it */
+                    root(pc + len);
+                    break;
+                }
+
+                b.insns.push_back({pc, len, w, kind});
+                track(b, w, kind);
+                pc += len;
+                b.end = pc;
+                b.next = pc;
+
+                if (kind == Kind::Branch) {
+                    root(b.insns.back().pc + immB(w));
+                    root(pc);
+                    break;
+                }
+                if (kind == Kind::Jal) {
+                    root(b.insns.back().pc + immJ(w));
+                    if (((w >> 7) & 0x1f) != 0) {
+                        root(pc);       /* the call returns here */
+                    }
+                    break;
+                }
+                if (kind == Kind::Jalr) {
+                    if (((w >> 7) & 0x1f) != 0) {
+                        root(pc);
+                    }
+                    break;
+                }
+                if (b.insns.size() == MAX_BLOCK) {
+                    root(pc);
+                    break;
+                }
+            }
+            return b;
+        }
+
+        static void track(Block &b, std::uint32_t w, Kind kind) {
+            const unsigned int rd = (w >> 7) & 0x1f;
+            const unsigned int rs1 = (w >> 15) & 0x1f;
+            const unsigned int rs2 = (w >> 20) & 0x1f;
+            const unsigned int op = w & 0x7f;
+            bool reads1 = op != 0x37 && op != 0x17 && op != 0x6f && op != 0x0f;
+            bool reads2 = op == 0x33 || kind == Kind::Store || kind == Kind::Branch;
+            bool writes = kind != Kind::Store && kind != Kind::Branch && op != 0x0f;
+            if (reads1) {
+                b.regs_read |= 1u << rs1;
+            }
+            if (reads2) {
+                b.regs_read |= 1u << rs2;
+            }
+            if (writes) {
+                b.regs_written |= 1u << rd;
+            }
+        }
+
+        static std::string hex(std::uint64_t v) {
+            std::ostringstream s;
+            s << "0x" << std::hex << v;
+            return s.str();
+        }
+
+        static std::string name(std::uint32_t pc) {
+            char n[16];
+            std::snprintf(n, sizeof(n), "b_%08x", pc);
+            return n;
+        }
+
+        static std::string reg(unsigned int r) {
+            return r == 0 ? std::string("0u") : "r" + std::to_string(r);
+        }
+
+        static std::string writeBack(const Block &b) {
+            std::string s;
+            for (unsigned int r = 1; r < 32; r++) {
+                if (b.regs_written & (1u << r)) {
+                    s += "x[" + std::to_string(r) + "] = r" + std::to_string(r) + "; ";
+                }
+            }
+            return s;
+        }
+
+        /* leave to the interpreter at pc, after k instructions */
+        static std::string exitTo(const Block &b, const std::string &pc, std::size_t k) {
+            return "{ " + writeBack(b) + "s->retired += " + std::to_string(k) + "; s->pc = " + pc + "; return; }";
+        }
+
+        /* continue at a known address, directly if a block starts there */
+        std::string jumpTo(const Block &b, std::uint32_t target, std::size_t k) const {
+            if (m_blocks.count(target) == 0) {
+                return exitTo(b, hex(target) + "u", k);
+            }
+            return "{ " + writeBack(b) + "s->retired += " + std::to_string(k) +
+                   "; if (s->retired < s->budget) { " + name(target) + "(s); return; } s->pc = " + hex(target) +
+                   "u; return; }";
+        }
+
+        void emitBlock(std::ostream &out, const Block &b) const {
+            out << "static void " << name(b.start) << "(rvvp_aot_state_t *s) {\n";
+            out << "    static const uint8_t code[] = {";
+            std::vector<std::uint8_t> bytes;
+            for (std::uint32_t pc = b.start; pc < b.end;) {
+                std::uint32_t raw = 0;
+                unsigned int len = 2;
+                fetch(pc, raw, len);
+                for (unsigned int i = 0; i < len; i++) {
+                    bytes.push_back(static_cast<std::uint8_t>(raw >> (8 * i)));
+                }
+                pc += len;
+            }
+            for (std::size_t i = 0; i < bytes.size(); i++) {
+                out << (i % 16 == 0 ? "\n        " : " ") << static_cast<unsigned int>(bytes[i]) << ",";
+            }
+            out << "\n    };\n";
+            out << "    if (" << hex(b.start) << "u + sizeof code > s->code_size || memcmp(s->code + "
+                << hex(b.start) << "u, code, sizeof code) != 0) {\n";
+            out << "        s->pc = " << hex(b.start) << "u;\n        return;\n    }\n";
+            out << "    uint32_t *x = s->x;\n";
+            for (unsigned int r = 1; r < 32; r++) {
+                if ((b.regs_read | b.regs_written) & (1u << r)) {
+                    out << "    uint32_t r" << r << " = x[" << r << "];\n";
+                }
+            }
+            out << "    (void) x;\n";
+
+            for (std::size_t k = 0; k < b.insns.size(); k++) {
+                emitInsn(out, b, b.insns[k], k);
+            }
+            const Insn &last = b.insns.back();
+            if (last.kind != Kind::Branch && last.kind != Kind::Jal && last.kind != Kind::Jalr) {
+                out << "    " << jumpTo(b, b.next, b.insns.size()) << "\n";
+            }
+            out << "}\n\n";
+        }
+
+        void emitInsn(std::ostream &out, const Block &b, const Insn &in, std::size_t k) const {
+            const std::uint32_t w = in.w;
+            const unsigned int rd = (w >> 7) & 0x1f;
+            const unsigned int f3 = (w >> 12) & 7;
+            const unsigned int f7 = w >> 25;
+            const std::string a = reg((w >> 15) & 0x1f);
+            const std::string c = reg((w >> 20) & 0x1f);
+            const std::string d = reg(rd);
+            const std::string next = hex(in.pc + in.len) + "u";
+            auto assign = [&](const std::string &expr) {
+                if (rd != 0) {
+                    out << "    " << d << " = " << expr << ";\n";
+                }
+            };
+
+            out << "    /* " << hex(in.pc) << " */\n";
+            switch (w & 0x7f) {
+                case 0x37:
+                    assign(hex(w & 0xfffff000) + "u");
+                    break;
+                case 0x17:
+                    assign(hex(in.pc + (w & 0xfffff000)) + "u");
+                    break;
+                case 0x6f:
+                    assign(next);
+                    out << "    " << jumpTo(b, in.pc + immJ(w), k + 1) << "\n";
+                    break;
+                case 0x67:
+                    out << "    { uint32_t t = (" << a << " + " << hex(immI(w)) << "u) & ~1u;";
+                    if (rd != 0) {
+                        out << " " << d << " = " << next << ";";
+                    }
+                    out << "\n      " << exitTo(b, "t", k + 1) << " }\n";
+                    break;
+                case 0x63: {
+                    static const char *const conds[8] = {
+                            "%a == %b", "%a != %b", "", "", "(int32_t) %a < (int32_t) %b",
+                            "(int32_t) %a >= (int32_t) %b", "%a < %b", "%a >= %b"};
+                    std::string cond = conds[f3];
+                    cond.replace(cond.find("%a"), 2, a);
+                    cond.replace(cond.find("%b"), 2, c);
+                    out << "    if (" << cond << ")\n        " << jumpTo(b, in.pc + immB(w), k + 1) << "\n";
+                    out << "    " << jumpTo(b, in.pc + in.len, k + 1) << "\n";
+                    break;
+                }
+                case 0x03: {
+                    static constexpr unsigned int sizes[8] = {1, 2, 4, 0, 1, 2, 0, 0};
+                    const unsigned int n = sizes[f3];
+                    out << "    { uint32_t a = " << a << " + " << hex(immI(w)) << "u; const uint8_t *p = "
+                        << "rvvp_aot_host(s, a, " << n << ");\n";
+                    out << "      if (!p) " << exitTo(b, hex(in.pc) + "u", k) << "\n";
+                    out << "      s->loads++;";
+                    if (rd != 0) {
+                        switch (f3) {
+                            case 0:
+                                out << " " << d << " = (uint32_t) (int32_t) (int8_t) p[0];";
+                                break;
+                            case 4:
+                                out << " " << d << " = p[0];";
+                                break;
+                            case 1:
+                                out << " { uint16_t h; memcpy(&h, p, 2); " << d
+                                    << " = (uint32_t) (int32_t) (int16_t) h; }";
+                                break;
+                            case 5:
+                                out << " { uint16_t h; memcpy(&h, p, 2); " << d << " = h; }";
+                                break;
+                            default:
+                                out << " memcpy(&" << d << ", p, 4);";
+                                break;
+                        }
+                    }
+                    out << " }\n";
+                    break;
+                }
+                case 0x23: {
+                    const unsigned int n = 1u << f3;
+                    /* a store into this block's own code leaves first: the rest may be stale */
+                    out << "    { uint32_t a = " << a << " + " << hex(immS(w)) << "u; uint8_t *p = "
+                        << "rvvp_aot_host(s, a, " << n << ");\n";
+                    out << "      if (!p || (a < " << hex(b.end) << "u && a + " << n << "u > " << hex(b.start)
+                        << "u)) " << exitTo(b, hex(in.pc) + "u", k) << "\n";
+                    out << "      { uint32_t v = " << c << "; memcpy(p, &v, " << n << "); } s->stores++; }\n";
+                    break;
+                }
+                case 0x13: {
+                    const std::string imm = hex(immI(w)) + "u";
+                    const std::string sh = std::to_string((w >> 20) & 0x1f);
+                    switch (f3) {
+                        case 0: assign(a + " + " + imm); break;
+                        case 2: assign("(int32_t) " + a + " < (int32_t) " + imm + " ? 1u : 0u"); break;
+                        case 3: assign(a + " < " + imm + " ? 1u : 0u"); break;
+                        case 4: assign(a + " ^ " + imm); break;
+                        case 6: assign(a + " | " + imm); break;
+                        case 7: assign(a + " & " + imm); break;
+                        case 1: assign(a + " << " + sh); break;
+                        default:
+                            assign(f7 != 0 ? "(uint32_t) ((int32_t) " + a + " >> " + sh + ")" : a + " >> " + sh);
+                            break;
+                    }
+                    break;
+                }
+                case 0x33:
+                    if (f7 == 1) {
+                        switch (f3) {
+                            case 0: assign(a + " * " + c); break;
+                            case 1: assign("(uint32_t) (((int64_t) (int32_t) " + a + " * (int64_t) (int32_t) " +
+                                           c + ") >> 32)"); break;
+                            case 2: assign("(uint32_t) (((int64_t) (int32_t) " + a + " * (int64_t) " + c +
+                                           ") >> 32)"); break;
+                            case 3: assign("(uint32_t) (((uint64_t) " + a + " * " + c + ") >> 32)"); break;
+                            case 4: assign(c + " == 0 ? 0xffffffffu : (" + a + " == 0x80000000u && " + c +
+                                           " == 0xffffffffu) ? " + a + " : (uint32_t) ((int32_t) " + a +
+                                           " / (int32_t) " + c + ")"); break;
+                            case 5: assign(c + " == 0 ? 0xffffffffu : " + a + " / " + c); break;
+                            case 6: assign(c + " == 0 ? " + a + " : (" + a + " == 0x80000000u && " + c +
+                                           " == 0xffffffffu) ? 0u : (uint32_t) ((int32_t) " + a +
+                                           " % (int32_t) " + c + ")"); break;
+                            default: assign(c + " == 0 ? " + a + " : " + a + " % " + c); break;
+                        }
+                        break;
+                    }
+                    switch (f3) {
+                        case 0: assign(f7 != 0 ? a + " - " + c : a + " + " + c); break;
+                        case 1: assign(a + " << (" + c + " & 31)"); break;
+                        case 2: assign("(int32_t) " + a + " < (int32_t) " + c + " ? 1u : 0u"); break;
+                        case 3: assign(a + " < " + c + " ? 1u : 0u"); break;
+                        case 4: assign(a + " ^ " + c); break;
+                        case 5:
+                            assign(f7 != 0 ? "(uint32_t) ((int32_t) " + a + " >> (" + c + " & 31))"
+                                           : a + " >> (" + c + " & 31)");
+                            break;
+                        case 6: assign(a + " | " + c); break;
+                        default: assign(a + " & " + c); break;
+                    }
+                    break;
+                default:        /* FENCE: the model has nothing to order */
+                    break;
+            }
+        }
+
+        const Program &m_prog;
+        std::set<std::uint32_t> m_visited;
+        std::map<std::uint32_t, Block> m_blocks;
+    };
+
+    void usage(const char *exe) {
+        std::cout << "Usage: " << exe << " [options] <program.elf>\n";
+        std::cout << "\nTranslates an RV32 program for RISCV_TLM --aot <dir>\n";
+        std::cout << "\nOptions:\n";
+        std::cout << "  -o <dir>        Output directory (default: .)\n";
+        std::cout << "  --cc <command>  Host C compiler (default: $CC, else cc)\n";
+        std::cout << "  --cflags <f>    Compiler flags (default: -O2)\n";
+        std::cout << "  -I <dir>        Directory of AotAPI.h (default: " RVVP_AOT_INCLUDE_DIR ")\n";
+        std::cout << "  --emit-only     Write <hash>.c without compiling it\n";
+    }
+
+    std::string quote(const std::string &s) {
+        std::string q = "'";
+        for (char ch : s) {
+            q += ch == '\'' ? std::string("'\\''") : std::string(1, ch);
+        }
+        return q + "'";
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string out_dir = ".";
+    std::string include_dir = RVVP_AOT_INCLUDE_DIR;
+    std::string cc = std::getenv("CC") != nullptr ? std::getenv("CC") : "cc";
+    std::string cflags = "-O2";
+    std::string elf;
+    bool emit_only = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            out_dir = argv[++i];
+        } else if (arg == "--cc" && i + 1 < argc) {
+            cc = argv[++i];
+        } else if (arg == "--cflags" && i + 1 < argc) {
+            cflags = argv[++i];
+        } else if (arg == "-I" && i + 1 < argc) {
+            include_dir = argv[++i];
+        } else if (arg == "--emit-only") {
+            emit_only = true;
+        } else if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            return 0;
+        } else if (arg[0] != '-' && elf.empty()) {
+            elf = arg;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (elf.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Program prog;
+    std::string error;
+    if (!readElf(elf, prog, error)) {
+        std::cerr << "rv_aot: " << error << "\n";
+        return 1;
+    }
+    const std::uint64_t hash = prog.hash.digest();
+
+    Translator translator(prog);
+    translator.discover();
+
+    const std::string so = out_dir + "/" + riscv_tlm::AotModule::fileName(hash);
+    const std::string base = so.substr(0, so.size() - 3);
+    const std::string src = base + ".c";
+    {
+        std::ofstream out(src);
+        if (!out.is_open()) {
+            std::cerr << "rv_aot: cannot write " << src << "\n";
+            return 1;
+        }
+        translator.emit(out, hash);
+    }
+    std::cout << elf << ": " << translator.blocks() << " blocks, " << translator.instructions()
+              << " instructions translated\n";
+
+    if (emit_only) {
+        std::cout << "wrote " << src << "\n";
+        return 0;
+    }
+
+    /* build next to the target and rename, so a running simulator never sees half a library */
+    const std::string tmp = base + ".tmp.so";
+    const std::string cmd = cc + " " + cflags + " -fPIC -shared -I" + quote(include_dir) + " -o " + quote(tmp) +
+                            " " + quote(src);
+    if (std::system(cmd.c_str()) != 0) {
+        std::cerr << "rv_aot: compiler failed: " << cmd << "\n";
+        std::remove(tmp.c_str());
+        return 1;
+    }
+    if (std::rename(tmp.c_str(), so.c_str()) != 0) {
+        std::cerr << "rv_aot: cannot rename " << tmp << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::cout << "wrote " << so << "\n";
+    return 0;
+}
@@ -0,0 +1,208 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * @file vp_top.cpp
+ * @brief Live view of the RISCV_VP processes started with --telemetry
+ *
+ * Attaches read-only to the telemetry pages in /dev/shm (or to the pids
+ * given) and refreshes a table of their counters. With -m it dumps guest
+ * RAM of a VP started with --telemetry-ram instead. The simulators never
+ * wait for this tool.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "TelemetryPage.h"
+
+using riscv_tlm::TelemetryPage;
+
+namespace {
+
+    /* a read-only mapping of a shared-memory object */
+    class Mapping {
+    public:
+        bool open(const std::string &name) {
+            const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+            if (fd < 0) {
+                return false;
+            }
+            struct stat st{};
+            if (fstat(fd, &st) == 0 && st.st_size > 0) {
+                m_size = static_cast<std::size_t>(st.st_size);
+                void *addr = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+                m_addr = addr == MAP_FAILED ? nullptr : addr;
+            }
+            ::close(fd);
+            return m_addr != nullptr;
+        }
+
+        ~Mapping() {
+            if (m_addr != nullptr) {
+                munmap(m_addr, m_size);
+            }
+        }
+
+        const void *data() const {
+            return m_addr;
+        }
+
+        std::size_t size() const {
+            return m_size;
+        }
+
+    private:
+        void *m_addr{nullptr};
+        std::size_t m_size{0};
+    };
+
+    bool readPage(unsigned long pid, TelemetryPage &page) {
+        Mapping map;
+        if (!map.open(riscv_tlm::TELEMETRY_PREFIX + std::to_string(pid)) || map.size() < sizeof(TelemetryPage)) {
+            return false;
+        }
+        const auto &shared = *static_cast<const TelemetryPage *>(map.data());
+        if (shared.magic != riscv_tlm::TELEMETRY_MAGIC || shared.version != riscv_tlm::TELEMETRY_VERSION) {
+            return false;
+        }
+        return riscv_tlm::telemetryRead(shared, page);
+    }
+
+    /* pids of the telemetry pages in /dev/shm */
+    std::vector<unsigned long> discover() {
+        std::vector<unsigned long> pids;
+        DIR *dir = opendir("/dev/shm");
+        if (dir == nullptr) {
+            return pids;
+        }
+        const std::string prefix = riscv_tlm::TELEMETRY_PREFIX + 1;
+        while (const dirent *entry = readdir(dir)) {
+            const std::string name = entry->d_name;
+            if (name.compare(0, prefix.size(), prefix) != 0) {
+                continue;
+            }
+            char *end = nullptr;
+            const unsigned long pid = std::strtoul(name.c_str() + prefix.size(), &end, 10);
+            if (end != nullptr && *end == '\0') {
+                pids.push_back(pid);
+            }
+        }
+        closedir(dir);
+        return pids;
+    }
+
+    void printTable(const std::vector<unsigned long> &pids) {
+        std::printf("%-8s %-28s %-9s %14s %14s %18s %12s %9s %9s\n",
+                    "PID", "MODEL", "STATE", "INSTR", "CYCLES", "PC", "SIM (ms)", "MIPS", "WALL (s)");
+        for (unsigned long pid : pids) {
+            TelemetryPage page;
+            if (!readPage(pid, page)) {
+                continue;
+            }
+            const char *state = page.state == riscv_tlm::TelemetryState::Finished ? "finished" : "running";
+            if (kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH) {
+                state = "gone";
+            }
+            std::printf("%-8lu %-28.28s %-9s %14" PRIu64 " %14" PRIu64 " 0x%016" PRIx64 " %12.3f %9.2f %9.1f\n",
+                        pid, page.model, state, page.instructions, page.cycles, page.pc,
+                        static_cast<double>(page.sim_time_ps) / 1e9, page.mips,
+                        static_cast<double>(page.wall_ns) / 1e9);
+            std::printf("         %s\n", page.image);
+            if (page.counter_count > 0) {
+                std::printf("        ");
+                for (std::uint32_t i = 0; i < page.counter_count && i < riscv_tlm::TELEMETRY_COUNTERS; i++) {
+                    std::printf(" %.*s=%" PRIu64, static_cast<int>(sizeof(page.counters[i].name)),
+                                page.counters[i].name, page.counters[i].value);
+                }
+                std::printf("\n");
+            }
+        }
+        std::fflush(stdout);
+    }
+
+    int dumpRam(unsigned long pid, std::uint64_t addr, std::uint64_t len) {
+        TelemetryPage page;
+        if (!readPage(pid, page)) {
+            std::fprintf(stderr, "vp_top: no telemetry page for pid %lu\n", pid);
+            return 1;
+        }
+        Mapping ram;
+        if (page.ram_size == 0 || !ram.open(page.ram_name)) {
+            std::fprintf(stderr, "vp_top: pid %lu does not share its RAM (--telemetry-ram)\n", pid);
+            return 1;
+        }
+        if (addr >= ram.size()) {
+            std::fprintf(stderr, "vp_top: 0x%" PRIx64 " is outside RAM\n", addr);
+            return 1;
+        }
+        len = std::min<std::uint64_t>(len, ram.size() - addr);
+        const auto *bytes = static_cast<const unsigned char *>(ram.data());
+        for (std::uint64_t line = 0; line < len; line += 16) {
+            std::printf("%08" PRIx64 ":", addr + line);
+            for (std::uint64_t i = line; i < line + 16 && i < len; i++) {
+                std::printf(" %02x", bytes[addr + i]);
+            }
+            std::printf("\n");
+        }
+        return 0;
+    }
+
+    void usage(const char *exe) {
+        std::printf("Usage: %s [-i <ms>] [-1] [pid...]\n", exe);
+        std::printf("       %s -m <pid> <addr> [len]\n\n", exe);
+        std::printf("  -i <ms>   Refresh interval (default 1000)\n");
+        std::printf("  -1        Print once and exit\n");
+        std::printf("  -m        Dump guest RAM of a VP started with --telemetry-ram\n");
+        std::printf("Without pids, every VP with a telemetry page in /dev/shm is shown.\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long interval_ms = 1000;
+    bool once = false;
+    std::vector<unsigned long> pids;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            interval_ms = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "-1") == 0) {
+            once = true;
+        } else if (std::strcmp(argv[i], "-m") == 0 && i + 2 < argc) {
+            const unsigned long pid = std::strtoul(argv[i + 1], nullptr, 10);
+            const std::uint64_t addr = std::strtoull(argv[i + 2], nullptr, 0);
+            const std::uint64_t len = i + 3 < argc ? std::strtoull(argv[i + 3], nullptr, 0) : 256;
+            return dumpRam(pid, addr, len);
+        } else if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        } else if (argv[i][0] != '-') {
+            pids.push_back(std::strtoul(argv[i], nullptr, 10));
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    while (true) {
+        if (!once) {
+            std::printf("\033[H\033[2J");
+        }
+        printTable(pids.empty() ? discover() : pids);
+        if (once) {
+            return 0;
+        }
+        usleep(static_cast<useconds_t>(interval_ms * 1000));
+    }
+}